@@ -34,7 +34,15 @@
 #define VGNSS_PIN   3   // GPS Power Enable (HIGH = ON)
 
 // --- Battery ---
-#define BATTERY_PIN 15  // Analog input for battery voltage
+// Heltec's v1.1 schematic has the VBAT divider on GPIO1 (VBAT_Read, ADC1,
+// so DMA sampling), switched in by ADC_Ctrl on GPIO2. This mapping drives
+// those two pins as VEXT_PIN and VTFT_PIN, so the default stays on GPIO15,
+// which is not on that divider: a board reading ~1.1 V / 0 % is measuring
+// GPIO15, not the cell. Boards wired to GPIO1 build with -DBATTERY_PIN=1
+// once the power pins are moved off it.
+#ifndef BATTERY_PIN
+#define BATTERY_PIN 15  // Analog input for battery voltage (ADC2_CH4)
+#endif
 
 // --- LoRaWAN Timing ---
 #define LORA_SEND_INTERVAL 60000    // Send data every 60 seconds
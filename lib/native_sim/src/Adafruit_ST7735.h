@@ -0,0 +1,65 @@
+#ifndef _ADAFRUIT_ST7735H_
+#define _ADAFRUIT_ST7735H_
+
+#include <string>
+#include <vector>
+#include "Adafruit_GFX.h"
+
+#define INITR_GREENTAB      0x00
+#define INITR_REDTAB        0x01
+#define INITR_BLACKTAB      0x02
+#define INITR_MINI160x80    0x04
+#define INITR_HALLOWING     0x05
+
+#define ST77XX_BLACK    0x0000
+#define ST77XX_WHITE    0xFFFF
+#define ST77XX_RED      0xF800
+#define ST77XX_GREEN    0x07E0
+#define ST77XX_BLUE     0x001F
+#define ST77XX_CYAN     0x07FF
+#define ST77XX_MAGENTA  0xF81F
+#define ST77XX_YELLOW   0xFFE0
+#define ST77XX_ORANGE   0xFC00
+
+#define ST7735_BLACK    ST77XX_BLACK
+#define ST7735_WHITE    ST77XX_WHITE
+#define ST7735_RED      ST77XX_RED
+#define ST7735_GREEN    ST77XX_GREEN
+#define ST7735_BLUE     ST77XX_BLUE
+#define ST7735_CYAN     ST77XX_CYAN
+#define ST7735_MAGENTA  ST77XX_MAGENTA
+#define ST7735_YELLOW   ST77XX_YELLOW
+#define ST7735_ORANGE   ST77XX_ORANGE
+
+// ST7735 panel as a 16-bit framebuffer. The last panel initialised is the
+// one simDisplayText() reads back. The controller is powered from VTFT_PIN:
+// once that rail drops, drawing is lost until the next initR().
+class Adafruit_ST7735 : public Adafruit_GFX {
+private:
+    std::vector<uint16_t> framebuffer;
+    std::vector<std::string> textRows;      // One row per 8 pixel line, in the current rotation
+    bool ready;
+    bool sleeping;
+    uint64_t initUs;
+
+    bool powered() const;
+
+    void drawCharCell(int16_t x, int16_t y, char c, uint8_t size) override;
+
+public:
+    Adafruit_ST7735(int8_t cs, int8_t dc, int8_t mosi, int8_t sclk, int8_t rst = -1);
+    Adafruit_ST7735(int8_t cs, int8_t dc, int8_t rst);
+
+    void initR(uint8_t options = INITR_GREENTAB);
+    void setRotation(uint8_t r) override;
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    void enableDisplay(bool enable) { (void)enable; }
+    void enableSleep(bool enable);
+
+    uint16_t pixel(int16_t x, int16_t y) const;
+    const std::vector<std::string>& text() const { return textRows; }
+};
+
+#endif // _ADAFRUIT_ST7735H_
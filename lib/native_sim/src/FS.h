@@ -0,0 +1,66 @@
+#ifndef FS_H
+#define FS_H
+
+#include <stdio.h>
+#include "Print.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+// A flash file backed by a host file under simFsRoot(); bytes written
+// count towards simFsStats
+class File : public Stream {
+private:
+    FILE* handle;
+
+public:
+    File() : handle(nullptr) {}
+    explicit File(FILE* file) : handle(file) {}
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+    File(File&& other) : handle(other.handle) { other.handle = nullptr; }
+    File& operator=(File&& other);
+    ~File() { close(); }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const { return handle != nullptr; }
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif // FS_H
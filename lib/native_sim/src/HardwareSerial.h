@@ -0,0 +1,42 @@
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Print.h"
+
+#define SERIAL_8N1 0x800001c
+
+// UART 0 is the console (USB CDC on the device): output goes to the
+// simulation's console sink, input comes from scheduled commands.
+// UART 1 is wired to the simulated GNSS receiver, which streams NMEA at
+// the configured baud rate into a SIM_UART_RX_BUFFER byte ring that
+// overflows when the loop does not drain it in time.
+// The console is true while a USB host is attached (--no-usb detaches it).
+class HardwareSerial : public Stream {
+private:
+    uint8_t uart;
+    bool started;
+
+public:
+    explicit HardwareSerial(uint8_t uartNumber);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+               bool invert = false, unsigned long timeoutMs = 20000UL);
+    void end();
+    size_t setRxBufferSize(size_t size);
+
+    int available() override;
+    int peek() override;
+    int read() override;
+    size_t read(uint8_t* buffer, size_t size);
+    int availableForWrite() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    operator bool() const;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // HardwareSerial_h
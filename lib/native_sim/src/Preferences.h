@@ -0,0 +1,72 @@
+#ifndef _PREFERENCES_H_
+#define _PREFERENCES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// ESP32 Preferences over the simulation's in-memory NVS. Every put counts
+// towards the wear statistics in simNvsStats; like NVS itself, a put that
+// stores the value already there writes nothing.
+class Preferences {
+private:
+    std::string name;
+    bool started;
+    bool readOnly;
+
+    size_t put(const char* key, const void* value, size_t length);
+    size_t get(const char* key, void* value, size_t length) const;
+
+    template <class T>
+    T getValue(const char* key, T defaultValue) const {
+        T value;
+        return get(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+    }
+
+public:
+    Preferences();
+    ~Preferences();
+
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key) const;
+
+    size_t putChar(const char* key, int8_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUChar(const char* key, uint8_t value) { return put(key, &value, sizeof(value)); }
+    size_t putShort(const char* key, int16_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUShort(const char* key, uint16_t value) { return put(key, &value, sizeof(value)); }
+    size_t putInt(const char* key, int32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putLong(const char* key, int32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putULong(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putLong64(const char* key, int64_t value) { return put(key, &value, sizeof(value)); }
+    size_t putULong64(const char* key, uint64_t value) { return put(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return put(key, &value, sizeof(value)); }
+    size_t putDouble(const char* key, double value) { return put(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { uint8_t byte = value; return put(key, &byte, sizeof(byte)); }
+    size_t putString(const char* key, const char* value);
+    size_t putBytes(const char* key, const void* value, size_t length) { return put(key, value, length); }
+
+    int8_t getChar(const char* key, int8_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    int16_t getShort(const char* key, int16_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    int32_t getLong(const char* key, int32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    int64_t getLong64(const char* key, int64_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) const { return getValue(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = 0) const { return getValue(key, defaultValue); }
+    double getDouble(const char* key, double defaultValue = 0) const { return getValue(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false) const { return getValue<uint8_t>(key, defaultValue) != 0; }
+    size_t getString(const char* key, char* value, size_t maxLength) const;
+    size_t getBytesLength(const char* key) const;
+    size_t getBytes(const char* key, void* buffer, size_t maxLength) const;
+    size_t freeEntries() const;
+};
+
+#endif // _PREFERENCES_H_
@@ -0,0 +1,153 @@
+#ifndef _RADIOLIB_H
+#define _RADIOLIB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SPI.h"
+
+// RadioLib subset the firmware uses: SX1262 and an OTAA LoRaWANNode on
+// US915 over the simulation's path loss model (sim_world.h). Joins and
+// uplinks take their airtime and receive windows out of the virtual clock.
+
+#define RADIOLIB_ERR_NONE                       (0)
+#define RADIOLIB_ERR_UNKNOWN                    (-1)
+#define RADIOLIB_ERR_CHIP_NOT_FOUND             (-2)
+#define RADIOLIB_ERR_PACKET_TOO_LONG            (-4)
+#define RADIOLIB_ERR_TX_TIMEOUT                 (-5)
+#define RADIOLIB_ERR_RX_TIMEOUT                 (-6)
+#define RADIOLIB_ERR_CRC_MISMATCH               (-7)
+#define RADIOLIB_ERR_INVALID_BANDWIDTH          (-8)
+#define RADIOLIB_ERR_INVALID_SPREADING_FACTOR   (-9)
+#define RADIOLIB_ERR_INVALID_CODING_RATE        (-10)
+#define RADIOLIB_ERR_INVALID_FREQUENCY          (-12)
+#define RADIOLIB_ERR_INVALID_OUTPUT_POWER       (-13)
+#define RADIOLIB_ERR_INVALID_DATA_RATE          (-26)
+
+#define RADIOLIB_ERR_NETWORK_NOT_JOINED         (-1101)
+#define RADIOLIB_ERR_NO_RX_WINDOW               (-1105)
+#define RADIOLIB_ERR_UPLINK_UNAVAILABLE         (-1108)
+#define RADIOLIB_ERR_NO_JOIN_ACCEPT             (-1116)
+#define RADIOLIB_LORAWAN_SESSION_RESTORED       (-1117)
+#define RADIOLIB_LORAWAN_NEW_SESSION            (-1118)
+#define RADIOLIB_LORAWAN_NONCES_DISCARDED       (-1119)
+#define RADIOLIB_LORAWAN_SESSION_DISCARDED      (-1120)
+
+#define RADIOLIB_LORAWAN_DATA_RATE_UNUSED       0xFF
+
+// Persistence buffers the application keeps (RTC memory, NVS) and hands
+// back after a reset; RadioLib checks their signatures on the way in
+#define RADIOLIB_LORAWAN_NONCES_BUF_SIZE        16
+#define RADIOLIB_LORAWAN_SESSION_BUF_SIZE       32
+#define RADIOLIB_LORAWAN_SESSION_FCNT_UP        5   // Session buffer offsets, as RadioLib's
+#define RADIOLIB_LORAWAN_SESSION_SIGNATURE      (RADIOLIB_LORAWAN_SESSION_BUF_SIZE - 2)
+
+class Module {
+public:
+    Module(uint32_t cs, uint32_t irq, uint32_t rst, uint32_t gpio, SPIClass& spi) {
+        (void)cs; (void)irq; (void)rst; (void)gpio; (void)spi;
+    }
+};
+
+class PhysicalLayer {
+protected:
+    float packetRssi;
+    float packetSnr;
+
+public:
+    PhysicalLayer() : packetRssi(0.0f), packetSnr(0.0f) {}
+    virtual ~PhysicalLayer() {}
+
+    // Signal of the last received packet (join accept or downlink)
+    float getRSSI() const { return packetRssi; }
+    float getSNR() const { return packetSnr; }
+    void setPacketSignal(float rssi, float snr) { packetRssi = rssi; packetSnr = snr; }
+};
+
+class SX1262 : public PhysicalLayer {
+private:
+    Module* module;
+
+public:
+    explicit SX1262(Module* mod) : module(mod) {}
+    ~SX1262() override { delete module; }
+    int16_t begin(float freq = 434.0, float bw = 125.0, uint8_t sf = 9, uint8_t cr = 7, uint8_t syncWord = 0x12,
+                  int8_t power = 10, uint16_t preambleLength = 8, float tcxoVoltage = 1.6, bool useRegulatorLDO = false);
+    int16_t sleep(bool retainConfig = true);
+};
+
+struct LoRaWANBand_t {
+    const char* name;
+    uint8_t subBands;
+    uint8_t maxPayload[5];      // Per uplink DR
+    uint8_t spreadingFactor[5];
+    uint16_t bandwidthKhz[5];
+};
+
+extern const LoRaWANBand_t US915;
+
+// What sendReceive() reports about a frame; the simulation fills the
+// fields the firmware reads
+struct LoRaWANEvent_t {
+    uint8_t dir;
+    bool confirmed;
+    bool confirming;
+    uint8_t datarate;
+    float freq;
+    int16_t power;
+    uint32_t fcnt;
+    uint8_t port;
+};
+
+class LoRaWANNode {
+private:
+    PhysicalLayer* phy;
+    const LoRaWANBand_t* band;
+    uint8_t subBand;
+    uint8_t dataRate;
+    int8_t txPower;
+    bool adr;
+    bool credentials;
+    bool activated;
+    uint32_t fCntUp;
+    uint32_t devNonce;
+    uint32_t joinNonce;
+    uint32_t devAddr;
+    uint8_t bufferNonces[RADIOLIB_LORAWAN_NONCES_BUF_SIZE];
+    uint8_t bufferSession[RADIOLIB_LORAWAN_SESSION_BUF_SIZE];
+
+    void receiveWindows(bool join, bool delivered, uint32_t downlinkAirtimeUs);
+    bool channelHeard() const;
+    int16_t transmit(size_t len, bool isConfirmed, uint8_t* dataDown, size_t* lenDown, LoRaWANEvent_t* eventDown);
+
+public:
+    LoRaWANNode(PhysicalLayer* phy, const LoRaWANBand_t* band, uint8_t subBand = 0);
+
+    int16_t beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey);
+    int16_t activateOTAA(uint8_t initialDr = RADIOLIB_LORAWAN_DATA_RATE_UNUSED);
+    int16_t uplink(uint8_t* data, size_t len, uint8_t fPort, bool isConfirmed = false);
+    // Uplink and both receive windows, as RadioLib 6: RADIOLIB_ERR_NONE when
+    // a downlink came (an ack, application data in dataDown, or both),
+    // RADIOLIB_ERR_RX_TIMEOUT when the windows stayed empty
+    int16_t sendReceive(uint8_t* dataUp, size_t lenUp, uint8_t fPort, uint8_t* dataDown, size_t* lenDown,
+                        bool isConfirmed = false, LoRaWANEvent_t* eventUp = nullptr, LoRaWANEvent_t* eventDown = nullptr);
+    int16_t setDatarate(uint8_t drUp);
+    int16_t setTxPower(int8_t txPower);
+    // The simulated network sends no LinkADRReq, so ADR only records the setting
+    void setADR(bool enable = true) { adr = enable; }
+
+    // Nonces first, then the session they belong to; a session is only
+    // restored on top of matching nonces and leaves the node activated
+    uint8_t* getBufferNonces();
+    int16_t setBufferNonces(uint8_t* persistentBuffer);
+    uint8_t* getBufferSession();
+    int16_t setBufferSession(uint8_t* persistentBuffer);
+
+    // Signature of a persistence buffer, over the bytes before it
+    static uint16_t checkSum16(const uint8_t* key, uint16_t keyLen);
+
+    bool isActivated() const { return activated; }
+    uint32_t getFCntUp() const { return fCntUp; }
+    uint8_t getDataRate() const { return dataRate; }
+};
+
+#endif // _RADIOLIB_H
@@ -0,0 +1,24 @@
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include <stdint.h>
+
+#define FSPI 0
+#define HSPI 1
+
+// Bus setup only; the simulated radio and display exchange no SPI bytes
+class SPIClass {
+private:
+    uint8_t bus;
+
+public:
+    explicit SPIClass(uint8_t spiBus = HSPI) : bus(spiBus) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {
+        (void)sck; (void)miso; (void)mosi; (void)ss;
+    }
+    void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif // _SPI_H_INCLUDED
@@ -0,0 +1,2 @@
+// Pre-1.0 Arduino header name, still included by some libraries when ARDUINO is undefined
+#include "Arduino.h"
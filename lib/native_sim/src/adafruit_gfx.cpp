@@ -0,0 +1,227 @@
+#include "Adafruit_GFX.h"
+#include "Adafruit_ST7735.h"
+#include "sim_world.h"
+#include "Config.h"
+#include "alloc_audit.h"
+#include <algorithm>
+
+#define GFX_CELL_WIDTH  6
+#define GFX_CELL_HEIGHT 8
+
+static const Adafruit_ST7735* activeDisplay = nullptr;
+
+// ---------------------------------------------------------------------------
+// Adafruit_GFX
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) :
+    WIDTH(w),
+    HEIGHT(h),
+    _width(w),
+    _height(h),
+    cursor_x(0),
+    cursor_y(0),
+    textcolor(0xFFFF),
+    textbgcolor(0xFFFF),
+    textsize_x(1),
+    textsize_y(1),
+    rotation(0),
+    wrap(true) {
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t row = y; row < y + h; row++) {
+        for (int16_t column = x; column < x + w; column++) drawPixel(column, row, color);
+    }
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX::setRotation(uint8_t r) {
+    rotation = r & 3;
+    _width = (rotation & 1) ? HEIGHT : WIDTH;
+    _height = (rotation & 1) ? WIDTH : HEIGHT;
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+// A lit 5x7 block stands in for the glyph; a distinct background fills the cell
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+    if (x >= _width || y >= _height || x + GFX_CELL_WIDTH * size - 1 < 0 || y + GFX_CELL_HEIGHT * size - 1 < 0) return;
+    if (bg != color) fillRect(x, y, GFX_CELL_WIDTH * size, GFX_CELL_HEIGHT * size, bg);
+    if (c != ' ') fillRect(x, y, 5 * size, 7 * size, color);
+    drawCharCell(x, y, (char)c, size);
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += textsize_y * GFX_CELL_HEIGHT;
+    } else if (c != '\r') {
+        if (wrap && cursor_x + textsize_x * GFX_CELL_WIDTH > _width) {
+            cursor_x = 0;
+            cursor_y += textsize_y * GFX_CELL_HEIGHT;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x);
+        cursor_x += textsize_x * GFX_CELL_WIDTH;
+    }
+    return 1;
+}
+
+// Classic font metrics: 6x8 cells, wrapped at the screen edge
+void Adafruit_GFX::getTextBounds(const char* string, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w,
+                                 uint16_t* h) {
+    int16_t cursorX = x;
+    int16_t cursorY = y;
+    int16_t minX = _width, minY = _height, maxX = -1, maxY = -1;
+    for (const char* c = string; *c; c++) {
+        if (*c == '\n') {
+            cursorX = 0;
+            cursorY += textsize_y * GFX_CELL_HEIGHT;
+            continue;
+        }
+        if (*c == '\r') continue;
+        if (wrap && cursorX + textsize_x * GFX_CELL_WIDTH > _width) {
+            cursorX = 0;
+            cursorY += textsize_y * GFX_CELL_HEIGHT;
+        }
+        int16_t right = cursorX + textsize_x * GFX_CELL_WIDTH - 1;
+        int16_t bottom = cursorY + textsize_y * GFX_CELL_HEIGHT - 1;
+        if (cursorX < minX) minX = cursorX;
+        if (cursorY < minY) minY = cursorY;
+        if (right > maxX) maxX = right;
+        if (bottom > maxY) maxY = bottom;
+        cursorX += textsize_x * GFX_CELL_WIDTH;
+    }
+    *x1 = x;
+    *y1 = y;
+    *w = *h = 0;
+    if (maxX >= minX) {
+        *x1 = minX;
+        *w = maxX - minX + 1;
+    }
+    if (maxY >= minY) {
+        *y1 = minY;
+        *h = maxY - minY + 1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Adafruit_ST7735
+
+Adafruit_ST7735::Adafruit_ST7735(int8_t cs, int8_t dc, int8_t mosi, int8_t sclk, int8_t rst) :
+    Adafruit_GFX(128, 160),
+    ready(false),
+    sleeping(false),
+    initUs(0) {
+    (void)cs; (void)dc; (void)mosi; (void)sclk; (void)rst;
+}
+
+Adafruit_ST7735::Adafruit_ST7735(int8_t cs, int8_t dc, int8_t rst) :
+    Adafruit_GFX(128, 160),
+    ready(false),
+    sleeping(false),
+    initUs(0) {
+    (void)cs; (void)dc; (void)rst;
+}
+
+void Adafruit_ST7735::initR(uint8_t options) {
+    int16_t panelWidth = options == INITR_MINI160x80 ? 80 : 128;
+    int16_t panelHeight = 160;
+    WIDTH = panelWidth;
+    HEIGHT = panelHeight;
+    ready = true;
+    sleeping = false;
+    initUs = simNowUs();
+    simDisplayStats.inits++;
+    activeDisplay = this;
+    simBootEvent(SIM_BOOT_DISPLAY);
+    setRotation(0);
+}
+
+// Initialized since the rail last came up
+bool Adafruit_ST7735::powered() const {
+    return ready && simGetPin(VTFT_PIN) && simPinHighSinceUs(VTFT_PIN) <= initUs;
+}
+
+// Sleep in keeps the registers and the frame memory
+void Adafruit_ST7735::enableSleep(bool enable) {
+    if (!powered() || enable == sleeping) return;
+    sleeping = enable;
+    if (enable) {
+        simDisplayStats.sleeps++;
+    } else {
+        simDisplayStats.wakes++;
+    }
+}
+
+// The host's framebuffer and text rows; the panel keeps its own
+void Adafruit_ST7735::setRotation(uint8_t r) {
+    AllocAuditHostScope host;
+    Adafruit_GFX::setRotation(r);
+    framebuffer.assign((size_t)_width * _height, 0);
+    textRows.assign(_height / GFX_CELL_HEIGHT, std::string(_width / GFX_CELL_WIDTH, ' '));
+}
+
+void Adafruit_ST7735::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (!powered() || x < 0 || y < 0 || x >= _width || y >= _height) return;
+    framebuffer[(size_t)y * _width + x] = color;
+    simDisplayStats.pixels++;
+}
+
+void Adafruit_ST7735::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (!powered()) return;
+    int16_t left = x < 0 ? 0 : x;
+    int16_t top = y < 0 ? 0 : y;
+    int16_t right = x + w > _width ? _width : x + w;
+    int16_t bottom = y + h > _height ? _height : y + h;
+    if (left >= right || top >= bottom) return;
+    for (int16_t row = top; row < bottom; row++) {
+        std::fill(framebuffer.begin() + (size_t)row * _width + left, framebuffer.begin() + (size_t)row * _width + right,
+                  color);
+    }
+    simDisplayStats.pixels += (uint64_t)(right - left) * (bottom - top);
+
+    // Text under the rectangle is gone
+    for (int16_t row = top / GFX_CELL_HEIGHT; row * GFX_CELL_HEIGHT < bottom && row < (int16_t)textRows.size(); row++) {
+        for (int16_t column = left / GFX_CELL_WIDTH;
+             column * GFX_CELL_WIDTH < right && column < (int16_t)textRows[row].size(); column++) {
+            if (row * GFX_CELL_HEIGHT >= top && column * GFX_CELL_WIDTH >= left) textRows[row][column] = ' ';
+        }
+    }
+}
+
+void Adafruit_ST7735::fillScreen(uint16_t color) {
+    simDisplayStats.clears++;
+    if (ready && !powered()) simDisplayStats.framesLost++;
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_ST7735::drawCharCell(int16_t x, int16_t y, char c, uint8_t size) {
+    (void)size;
+    int16_t row = y / GFX_CELL_HEIGHT;
+    int16_t column = x / GFX_CELL_WIDTH;
+    if (y < 0 || x < 0 || row >= (int16_t)textRows.size() || column >= (int16_t)textRows[row].size()) return;
+    textRows[row][column] = (c >= 0x20 && c < 0x7F) ? c : '?';
+}
+
+uint16_t Adafruit_ST7735::pixel(int16_t x, int16_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    return framebuffer[(size_t)y * _width + x];
+}
+
+std::vector<std::string> simDisplayText() {
+    std::vector<std::string> rows;
+    if (!activeDisplay) return rows;
+    for (const std::string& row : activeDisplay->text()) {
+        size_t end = row.find_last_not_of(' ');
+        rows.push_back(end == std::string::npos ? std::string() : row.substr(0, end + 1));
+    }
+    return rows;
+}
@@ -0,0 +1,355 @@
+#include "Arduino.h"
+#include "SPI.h"
+#include "esp_sleep.h"
+#include "sim_world.h"
+#include "Config.h"
+#include <sys/time.h>
+
+// ---------------------------------------------------------------------------
+// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) written += write(*buffer++);
+    return written;
+}
+
+// Same buffering as the ESP32 core, so heap use per printf matches the device
+size_t Print::printf(const char* format, ...) {
+    char stackBuffer[64];
+    char* text = stackBuffer;
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, copy);
+    va_end(copy);
+    if (length < 0) {
+        va_end(args);
+        return 0;
+    }
+    if ((size_t)length >= sizeof(stackBuffer)) {
+        text = (char*)malloc(length + 1);
+        if (!text) {
+            va_end(args);
+            return 0;
+        }
+        vsnprintf(text, length + 1, format, args);
+    }
+    va_end(args);
+    size_t written = write((const uint8_t*)text, length);
+    if (text != stackBuffer) free(text);
+    return written;
+}
+
+size_t Print::printNumber(unsigned long long value, int base) {
+    if (base < 2) base = 10;
+    char buffer[8 * sizeof(value) + 1];
+    char* digit = &buffer[sizeof(buffer) - 1];
+    *digit = '\0';
+    do {
+        int remainder = (int)(value % base);
+        *--digit = remainder < 10 ? '0' + remainder : 'A' + remainder - 10;
+        value /= base;
+    } while (value);
+    return write(digit);
+}
+
+size_t Print::printSigned(long long value, int base) {
+    if (base == 10 && value < 0) {
+        return write((uint8_t)'-') + printNumber(-(unsigned long long)value, 10);
+    }
+    return printNumber((unsigned long long)value, base);
+}
+
+size_t Print::printFloat(double value, int digits) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+// ---------------------------------------------------------------------------
+// Serial ports
+
+// Constructed before the firmware's globals, whose constructors may log
+HardwareSerial Serial __attribute__((init_priority(101)))(0);
+HardwareSerial Serial1 __attribute__((init_priority(101)))(1);
+SPIClass SPI(HSPI);
+
+static size_t gnssRxBufferSize = SIM_UART_RX_BUFFER;
+
+HardwareSerial::HardwareSerial(uint8_t uartNumber) : uart(uartNumber), started(false) {
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin, bool invert,
+                           unsigned long timeoutMs) {
+    (void)config; (void)rxPin; (void)txPin; (void)invert; (void)timeoutMs;
+    started = true;
+    if (uart == 1) simGnssBegin(baud, gnssRxBufferSize);
+}
+
+void HardwareSerial::end() {
+    started = false;
+    if (uart == 1) simGnssEnd();
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size) {
+    if (uart == 1 && !started) gnssRxBufferSize = size;
+    return size;
+}
+
+int HardwareSerial::available() {
+    if (uart == 0) return simConsoleAvailable();
+    return started ? simGnssAvailable() : 0;
+}
+
+int HardwareSerial::peek() {
+    if (uart == 0) return -1;
+    return started ? simGnssPeek() : -1;
+}
+
+int HardwareSerial::read() {
+    if (uart == 0) return simConsoleRead();
+    return started ? simGnssRead() : -1;
+}
+
+size_t HardwareSerial::read(uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (count < size && available() > 0) buffer[count++] = (uint8_t)read();
+    return count;
+}
+
+HardwareSerial::operator bool() const {
+    return uart != 0 || simConfig.usbHost;
+}
+
+int HardwareSerial::availableForWrite() {
+    return uart == 0 ? SIM_CONSOLE_TX_BUFFER : SIM_UART_RX_BUFFER;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+// Console output goes to the sink; the GNSS receiver ignores commands
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (uart != 0) return size;
+    simConsoleStats.bytesWritten += size;
+    for (size_t i = 0; i < size; i++) {
+        if (buffer[i] == '\n') simConsoleStats.lines++;
+    }
+    if (simConfig.console) fwrite(buffer, 1, size, simConfig.console);
+    return size;
+}
+
+// ---------------------------------------------------------------------------
+// Time, GPIO, ADC
+
+// Both restart at every boot, deep-sleep wakes included
+unsigned long millis() {
+    return (unsigned long)(simSinceBootUs() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)simSinceBootUs();
+}
+
+// Stands in for the C library's: the RTC clock counts from power-on and
+// keeps running through deep sleep, as on the device before SNTP sets it
+extern "C" int gettimeofday(struct timeval* now, void* zone) {
+    (void)zone;
+    now->tv_sec = (time_t)(simNowUs() / 1000000);
+    now->tv_usec = (suseconds_t)(simNowUs() % 1000000);
+    return 0;
+}
+
+// The loop task blocks; the idle task may light-sleep meanwhile
+void delay(uint32_t ms) {
+    simIdleUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    simAdvanceUs(us);
+}
+
+void yield() {
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (mode == OUTPUT) {
+        simSetPin(pin, simGetPin(pin));
+    } else {
+        simSetInput(pin, (mode & PULLUP) ? HIGH : LOW);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    simSetPin(pin, level);
+}
+
+int digitalRead(uint8_t pin) {
+    simPollEvents();
+    return simGetPin(pin);
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+    simAttachInterrupt(pin, handler, mode);
+}
+
+void detachInterrupt(uint8_t pin) {
+    simAttachInterrupt(pin, nullptr, 0);
+}
+
+// LEDC channels drive their attached pin at duty / full scale
+#define SIM_LEDC_CHANNELS   8
+
+struct SimLedcChannel {
+    uint8_t bits;
+    uint32_t duty;
+    int pin;                    // -1 when detached
+};
+
+static SimLedcChannel ledcChannels[SIM_LEDC_CHANNELS] = {
+    {8, 0, -1}, {8, 0, -1}, {8, 0, -1}, {8, 0, -1}, {8, 0, -1}, {8, 0, -1}, {8, 0, -1}, {8, 0, -1}
+};
+
+static void ledcOutput(const SimLedcChannel& channel) {
+    if (channel.pin < 0) return;
+    uint32_t full = (1UL << channel.bits) - 1;
+    simSetPwm((uint8_t)channel.pin, channel.duty >= full ? 1.0f : (float)channel.duty / full);
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolutionBits) {
+    if (channel >= SIM_LEDC_CHANNELS || resolutionBits == 0 || resolutionBits > 14) return 0;
+    ledcChannels[channel].bits = resolutionBits;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    if (channel >= SIM_LEDC_CHANNELS) return;
+    ledcDetachPin(pin);
+    ledcChannels[channel].pin = pin;
+    ledcOutput(ledcChannels[channel]);
+}
+
+void ledcDetachPin(uint8_t pin) {
+    for (SimLedcChannel& channel : ledcChannels) {
+        if (channel.pin == pin) channel.pin = -1;
+    }
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel >= SIM_LEDC_CHANNELS) return;
+    ledcChannels[channel].duty = duty;
+    ledcOutput(ledcChannels[channel]);
+}
+
+uint32_t ledcRead(uint8_t channel) {
+    return channel < SIM_LEDC_CHANNELS ? ledcChannels[channel].duty : 0;
+}
+
+// Calibrated one-shot read, as the Arduino core does it with the eFuse values
+uint32_t analogReadMilliVolts(uint8_t pin) {
+    simAdcStats.oneshotReads++;
+    if (simInTimerCallback()) simAdcStats.timerReads++;
+    if (pin != BATTERY_PIN) return 0;
+    double mv = simAnalogPinMv(pin) + simGaussian(3.0);
+    return mv > 0 ? (uint32_t)mv : 0;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    uint32_t mv = analogReadMilliVolts(pin);
+    return mv >= 3100 ? 4095 : (uint16_t)(mv * 4095 / 3100);
+}
+
+long random(long howBig) {
+    return howBig > 0 ? (long)(simRandom() % (unsigned long)howBig) : 0;
+}
+
+long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+// Runs are reproducible from --seed, so the firmware's own seed is ignored
+void randomSeed(unsigned long seed) {
+    (void)seed;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return simCpuFrequencyMhz();
+}
+
+bool setCpuFrequencyMhz(uint32_t cpuFreqMhz) {
+    return simSetCpuFrequencyMhz(cpuFreqMhz);
+}
+
+// ---------------------------------------------------------------------------
+// Deep sleep
+
+static uint64_t sleepTimerUs = 0;
+static bool sleepButtonWake = false;
+static esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+    sleepTimerUs = timeUs;
+    return ESP_OK;
+}
+
+// ext0 on the user button (active LOW) is the only pin wake the board has
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio, int level) {
+    if (gpio != USER_BUTTON_PIN || level != 0) return ESP_ERR_INVALID_ARG;
+    sleepButtonWake = true;
+    return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return wakeCause;
+}
+
+void esp_deep_sleep_start() {
+    if (simConfig.console) fflush(simConfig.console);
+    wakeCause = (esp_sleep_wakeup_cause_t)simDeepSleep(sleepTimerUs, sleepButtonWake);
+    sleepTimerUs = 0;
+    sleepButtonWake = false;
+    throw SimReboot();
+}
+
+// ---------------------------------------------------------------------------
+// ESP
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() {
+    return simFreeHeap();
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return simMinFreeHeap();
+}
+
+uint32_t EspClass::getHeapSize() {
+    return SIM_HEAP_TOTAL;
+}
+
+const char* EspClass::getChipModel() {
+    return "ESP32-S3 (native sim)";
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+    return getCpuFrequencyMhz();
+}
+
+uint32_t EspClass::getFlashChipSize() {
+    return 8UL * 1024UL * 1024UL;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return simCpuCycles();
+}
+
+void EspClass::restart() {
+    if (simConfig.console) fflush(simConfig.console);
+    simRestart();
+    wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    throw SimReboot();
+}
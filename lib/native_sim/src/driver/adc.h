@@ -0,0 +1,97 @@
+#ifndef _DRIVER_ADC_H_
+#define _DRIVER_ADC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_sleep.h"
+
+// ESP-IDF 4.4 continuous (DMA) ADC driver on the virtual clock, ESP32-S3
+// flavour: ADC1 only, TYPE2 results. Conversions are generated for the
+// virtual time since the last read at the configured rate, from the pin
+// voltages of sim_world.h, through the chip's uncalibrated transfer curve
+// (esp_adc_cal.h undoes it from the simulated eFuse). A ring of
+// max_store_buf_size bytes holds them; when it is full, new conversions
+// are dropped and the next read reports ESP_ERR_INVALID_STATE, as the
+// driver does.
+
+#ifndef BIT
+#define BIT(n)                          (1UL << (n))
+#endif
+
+#define SOC_ADC_MAX_CHANNEL_NUM         10
+#define SOC_ADC_DIGI_RESULT_BYTES       4
+#define SOC_ADC_DIGI_MAX_BITWIDTH       12
+#define SOC_ADC_SAMPLE_FREQ_THRES_LOW   611
+#define SOC_ADC_SAMPLE_FREQ_THRES_HIGH  83333
+
+typedef enum {
+    ADC_UNIT_1 = 1,
+    ADC_UNIT_2 = 2,
+} adc_unit_t;
+
+typedef enum {
+    ADC_ATTEN_DB_0 = 0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_11,
+} adc_atten_t;
+
+typedef enum {
+    ADC_WIDTH_BIT_12 = 3,
+} adc_bits_width_t;
+
+typedef enum {
+    ADC_CONV_SINGLE_UNIT_1 = 1,
+    ADC_CONV_SINGLE_UNIT_2 = 2,
+} adc_digi_convert_mode_t;
+
+typedef enum {
+    ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+} adc_digi_output_format_t;
+
+typedef struct {
+    uint32_t max_store_buf_size;
+    uint32_t conv_num_each_intr;
+    uint32_t adc1_chan_mask;
+    uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+    uint8_t atten;
+    uint8_t channel;
+    uint8_t unit;               // 0 = ADC1
+    uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+    bool conv_limit_en;
+    uint32_t conv_limit_num;
+    uint32_t pattern_num;
+    adc_digi_pattern_config_t* adc_pattern;
+    uint32_t sample_freq_hz;
+    adc_digi_convert_mode_t conv_mode;
+    adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t data:      12;
+            uint32_t reserved12: 1;
+            uint32_t channel:   4;
+            uint32_t unit:      1;
+            uint32_t reserved17_31: 14;
+        } type2;
+        uint32_t val;
+    };
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config);
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config);
+esp_err_t adc_digi_start();
+esp_err_t adc_digi_stop();
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms);
+esp_err_t adc_digi_deinitialize();
+
+#endif // _DRIVER_ADC_H_
@@ -0,0 +1,23 @@
+#ifndef _DRIVER_GPIO_H_
+#define _DRIVER_GPIO_H_
+
+#include "esp_sleep.h"
+
+// Light-sleep wake pins (esp_sleep_enable_gpio_wakeup()). The simulation
+// wakes on the GNSS UART's RX pin when the receiver starts a byte; the
+// radio's DIO1 only rises inside blocking radio operations, which never
+// sleep, so its wake is recorded but never needed.
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num);
+
+#endif // _DRIVER_GPIO_H_
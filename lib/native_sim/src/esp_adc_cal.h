@@ -0,0 +1,32 @@
+#ifndef _ESP_ADC_CAL_H_
+#define _ESP_ADC_CAL_H_
+
+#include <stdint.h>
+#include "driver/adc.h"
+
+// ADC calibration from the simulated eFuse: two-point values burnt per
+// chip, from which esp_adc_cal_characterize() fits the line that turns raw
+// codes back into millivolts (ESP32-S3 scheme)
+
+typedef enum {
+    ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+    ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+    ESP_ADC_CAL_VAL_DEFAULT_VREF = 2,
+    ESP_ADC_CAL_VAL_EFUSE_TP_FIT = 3,
+} esp_adc_cal_value_t;
+
+typedef struct {
+    adc_unit_t adc_num;
+    adc_atten_t atten;
+    adc_bits_width_t bit_width;
+    uint32_t coeff_a;           // Gain, mV per code x 65536
+    uint32_t coeff_b;           // Offset, mV
+    uint32_t vref;
+} esp_adc_cal_characteristics_t;
+
+esp_err_t esp_adc_cal_check_efuse(esp_adc_cal_value_t value_type);
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t* chars);
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t* chars);
+
+#endif // _ESP_ADC_CAL_H_
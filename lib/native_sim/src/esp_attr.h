@@ -0,0 +1,12 @@
+#ifndef __ESP_ATTR_H__
+#define __ESP_ATTR_H__
+
+// RTC slow memory keeps its contents through deep sleep. The simulation
+// keeps the whole process across a deep sleep (esp_sleep.h), so RTC
+// variables are ordinary ones; what the firmware must not rely on is
+// everything else, which it re-initializes on every wake as on the device.
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+#endif // __ESP_ATTR_H__
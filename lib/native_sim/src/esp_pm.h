@@ -0,0 +1,38 @@
+#ifndef _ESP_PM_H_
+#define _ESP_PM_H_
+
+#include "esp_sleep.h"
+
+// ESP-IDF power management on the virtual clock. With a configuration in
+// place the CPU runs at min_freq_mhz unless a lock asks for more: any
+// ESP_PM_CPU_FREQ_MAX lock raises it to max_freq_mhz. With light sleep
+// enabled, delay() sleeps the chip whenever no lock of any kind is held:
+// it wakes for esp_timer timers, the end of the delay and the pins set up
+// with gpio_wakeup_enable(). What a UART receives while the chip sleeps is
+// lost. The simulation can play a build without power management
+// (--pm none: ESP_ERR_NOT_SUPPORTED) or without tickless idle (--pm dfs:
+// light sleep not supported), as the stock Arduino core is built.
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_esp32s3_t;
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+struct SimPmLock;
+typedef SimPmLock* esp_pm_lock_handle_t;
+
+esp_err_t esp_pm_configure(const void* config);
+esp_err_t esp_pm_get_configuration(void* config);
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle);
+
+#endif // _ESP_PM_H_
@@ -0,0 +1,41 @@
+#ifndef _ESP_SLEEP_H_
+#define _ESP_SLEEP_H_
+
+#include <stdint.h>
+
+// ESP-IDF deep sleep on the virtual clock. esp_deep_sleep_start() skips
+// the clock to the timer or to the next scheduled button press (ext0 on
+// the user button), drops every GPIO the firmware drove, restarts millis()
+// and boots the firmware again through setup(). Only RTC_DATA_ATTR state is
+// meant to survive; see esp_attr.h for what the simulation cannot enforce.
+
+typedef int esp_err_t;
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_NOT_SUPPORTED   0x106
+#define ESP_ERR_TIMEOUT         0x107
+
+typedef int gpio_num_t;
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,     // Power-on or reset, not a deep-sleep wake
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+    ESP_SLEEP_WAKEUP_UART,
+} esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio, int level);
+// Light sleep: wake on the pins set up with gpio_wakeup_enable() (driver/gpio.h)
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+void esp_deep_sleep_start() __attribute__((noreturn));
+
+#endif // _ESP_SLEEP_H_
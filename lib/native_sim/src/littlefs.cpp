@@ -0,0 +1,172 @@
+#include "LittleFS.h"
+#include "sim_world.h"
+#include "alloc_audit.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIM_LITTLEFS_BYTES  (1536UL * 1024UL)      // spiffs partition of the default 8 MB table
+
+fs::LittleFSFS LittleFS;
+
+// stdio's FILE and buffers are counted as host allocations, apart from the
+// firmware's (AllocAuditHostScope, alloc_audit.h)
+
+static void hostPath(char* out, size_t size, const char* path) {
+    snprintf(out, size, "%s%s%s", simFsRoot(), path[0] == '/' ? "" : "/", path);
+}
+
+namespace fs {
+
+File& File::operator=(File&& other) {
+    if (this != &other) {
+        close();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    AllocAuditHostScope host;
+    if (!handle) return 0;
+    size_t written = fwrite(buffer, 1, size, handle);
+    simFsStats.bytesWritten += written;
+    return written;
+}
+
+int File::available() {
+    if (!handle) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    AllocAuditHostScope host;
+    if (!handle) return -1;
+    int c = fgetc(handle);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    AllocAuditHostScope host;
+    if (!handle) return -1;
+    int c = fgetc(handle);
+    if (c == EOF) return -1;
+    ungetc(c, handle);
+    return c;
+}
+
+void File::flush() {
+    AllocAuditHostScope host;
+    if (handle) fflush(handle);
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    AllocAuditHostScope host;
+    return handle ? fread(buffer, 1, size, handle) : 0;
+}
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+    if (!handle) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(handle, offset, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!handle) return 0;
+    long offset = ftell(handle);
+    return offset < 0 ? 0 : (size_t)offset;
+}
+
+size_t File::size() const {
+    if (!handle) return 0;
+    struct stat info;
+    fflush(handle);
+    return fstat(fileno(handle), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+void File::close() {
+    AllocAuditHostScope host;
+    if (handle) {
+        fclose(handle);
+        handle = nullptr;
+    }
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    AllocAuditHostScope host;
+    (void)create;
+    char file[512];
+    hostPath(file, sizeof(file), path);
+    simFsStats.opens++;
+    // Binary modes; "w" and "a" create the file as LittleFS does
+    const char* hostMode = mode[0] == 'w' ? "wb" : (mode[0] == 'a' ? "ab" : "rb");
+    return File(fopen(file, hostMode));
+}
+
+bool FS::exists(const char* path) {
+    char file[512];
+    hostPath(file, sizeof(file), path);
+    return access(file, F_OK) == 0;
+}
+
+bool FS::remove(const char* path) {
+    AllocAuditHostScope host;
+    char file[512];
+    hostPath(file, sizeof(file), path);
+    simFsStats.removes++;
+    return unlink(file) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    AllocAuditHostScope host;
+    char source[512];
+    char target[512];
+    hostPath(source, sizeof(source), from);
+    hostPath(target, sizeof(target), to);
+    return ::rename(source, target) == 0;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    struct stat info;
+    mounted = stat(simFsRoot(), &info) == 0 && S_ISDIR(info.st_mode);
+    return mounted;
+}
+
+bool LittleFSFS::format() {
+    DIR* directory = opendir(simFsRoot());
+    if (!directory) return false;
+    while (struct dirent* entry = readdir(directory)) {
+        if (entry->d_type != DT_REG) continue;
+        char file[512];
+        snprintf(file, sizeof(file), "%s/%s", simFsRoot(), entry->d_name);
+        unlink(file);
+    }
+    closedir(directory);
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return SIM_LITTLEFS_BYTES;
+}
+
+size_t LittleFSFS::usedBytes() {
+    DIR* directory = opendir(simFsRoot());
+    if (!directory) return 0;
+    size_t used = 0;
+    while (struct dirent* entry = readdir(directory)) {
+        char file[512];
+        struct stat info;
+        snprintf(file, sizeof(file), "%s/%s", simFsRoot(), entry->d_name);
+        if (entry->d_type == DT_REG && stat(file, &info) == 0) used += info.st_size;
+    }
+    closedir(directory);
+    return used;
+}
+
+} // namespace fs
@@ -0,0 +1,123 @@
+#include "Preferences.h"
+#include "sim_world.h"
+#include "alloc_audit.h"
+#include <string.h>
+
+// Entries an item occupies in an NVS page: primitives take one, strings
+// and blobs a header entry plus their data in 32 byte entries (blobs add a
+// blob index entry)
+static uint64_t nvsEntries(size_t length, bool blob) {
+    if (length <= 8 && !blob) return 1;
+    return 1 + (length + 31) / 32 + (blob ? 1 : 0);
+}
+
+// The store's maps and vectors are the host's, not the firmware's heap
+// (AllocAuditHostScope, alloc_audit.h)
+
+Preferences::Preferences() : started(false), readOnly(false) {
+}
+
+Preferences::~Preferences() {
+    end();
+}
+
+bool Preferences::begin(const char* namespaceName, bool openReadOnly, const char* partitionLabel) {
+    AllocAuditHostScope host;
+    (void)partitionLabel;
+    if (started) return false;
+    if (!namespaceName || strlen(namespaceName) > 15) return false;
+    name = namespaceName;
+    readOnly = openReadOnly;
+    started = true;
+    if (!readOnly) simNvsStore()[name];
+    return true;
+}
+
+void Preferences::end() {
+    started = false;
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t length) {
+    AllocAuditHostScope host;
+    if (!started || readOnly || !key || strlen(key) > 15) return 0;
+    std::vector<uint8_t>& stored = simNvsStore()[name][key];
+    // Names are at most 15 characters, short enough to build without the heap
+    SimNvsKeyStats& stats = simNvsStats.keys[std::make_pair(name, std::string(key))];
+    stats.puts++;
+
+    // NVS compares before writing; an unchanged value costs no flash
+    const uint8_t* bytes = (const uint8_t*)value;
+    if (stored.size() == length && (length == 0 || memcmp(stored.data(), bytes, length) == 0)) return length;
+
+    stored.assign(bytes, bytes + length);
+    stats.writes++;
+    stats.entries += nvsEntries(length, length > 8);
+    simNvsStats.commits++;
+    return length;
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return value ? put(key, value, strlen(value) + 1) : 0;
+}
+
+size_t Preferences::get(const char* key, void* value, size_t length) const {
+    AllocAuditHostScope host;
+    if (!started || !key) return 0;
+    auto space = simNvsStore().find(name);
+    if (space == simNvsStore().end()) return 0;
+    auto item = space->second.find(key);
+    if (item == space->second.end() || item->second.size() != length) return 0;
+    memcpy(value, item->second.data(), length);
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) const {
+    AllocAuditHostScope host;
+    if (!started || !key) return 0;
+    auto space = simNvsStore().find(name);
+    if (space == simNvsStore().end()) return 0;
+    auto item = space->second.find(key);
+    return item == space->second.end() ? 0 : item->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) const {
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > maxLength) return 0;
+    return get(key, buffer, length);
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLength) const {
+    size_t length = getBytes(key, value, maxLength);
+    if (length == 0 && maxLength > 0) value[0] = '\0';
+    return length;
+}
+
+bool Preferences::isKey(const char* key) const {
+    return getBytesLength(key) > 0;
+}
+
+bool Preferences::remove(const char* key) {
+    AllocAuditHostScope host;
+    if (!started || readOnly || !key) return false;
+    auto space = simNvsStore().find(name);
+    if (space == simNvsStore().end() || space->second.erase(key) == 0) return false;
+    simNvsStats.commits++;
+    return true;
+}
+
+bool Preferences::clear() {
+    AllocAuditHostScope host;
+    if (!started || readOnly) return false;
+    simNvsStore()[name].clear();
+    simNvsStats.commits++;
+    return true;
+}
+
+size_t Preferences::freeEntries() const {
+    uint64_t used = 0;
+    for (const auto& space : simNvsStore()) {
+        for (const auto& item : space.second) used += nvsEntries(item.second.size(), item.second.size() > 8);
+    }
+    uint64_t total = (SIM_NVS_PAGES - 1) * SIM_NVS_ENTRIES_PER_PAGE;
+    return used < total ? (size_t)(total - used) : 0;
+}
@@ -0,0 +1,351 @@
+#include "RadioLib.h"
+#include "sim_world.h"
+#include <string.h>
+
+// LoRaWAN MAC timing (RP002): RX1 opens RECEIVE_DELAY1 after the uplink
+// ends, RX2 one second later; join accepts use the JOIN_ACCEPT delays
+#define SIM_RECEIVE_DELAY1_US       1000000
+#define SIM_JOIN_ACCEPT_DELAY1_US   5000000
+#define SIM_RX2_AFTER_RX1_US        1000000
+#define SIM_RX_DETECT_US            33000   // Preamble search before an empty window closes
+#define SIM_MAC_OVERHEAD_BYTES      13      // MHDR, FHDR without options, FPort, MIC
+#define SIM_JOIN_REQUEST_BYTES      23
+#define SIM_JOIN_ACCEPT_BYTES       33      // With the US915 channel mask CFList
+#define SIM_ACK_BYTES               12
+
+// Status uplinks as the network decodes them (payload_codec.h): the
+// position flags follow the base and GPS blocks, behind the config ack on
+// its port. A position without the estimated flag sent longer than the
+// firmware's fix timeout (GPS_TIMEOUT_MS) and an epoch after the
+// receiver's last fix is a dead-reckoned one passed off as live
+#define SIM_STATUS_PORT             3
+#define SIM_CONFIG_ACK_PORT         6
+#define SIM_CONFIG_ACK_BYTES        4
+#define SIM_STATUS_FLAGS_OFFSET     24
+#define SIM_STATUS_FLAG_ESTIMATED   0x01
+#define SIM_STATUS_FLAG_NO_POSITION 0x02
+#define SIM_FIX_STALE_MS            6000
+
+const LoRaWANBand_t US915 = {
+    "US915",
+    8,
+    {11, 53, 125, 242, 242},
+    {10, 9, 8, 7, 8},
+    {125, 125, 125, 125, 500}
+};
+
+// The network's side of the session: the last frame counter it heard. It
+// outlives the node, as it would a device reset
+static uint32_t networkDevAddr = 0;
+static uint32_t networkFCntUp = 0;
+static bool networkFCntHeard = false;
+
+int16_t SX1262::begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t syncWord, int8_t power,
+                      uint16_t preambleLength, float tcxoVoltage, bool useRegulatorLDO) {
+    (void)freq; (void)bw; (void)sf; (void)cr; (void)syncWord; (void)power;
+    (void)preambleLength; (void)tcxoVoltage; (void)useRegulatorLDO;
+    simBootEvent(SIM_BOOT_RADIO);
+    return RADIOLIB_ERR_NONE;
+}
+
+int16_t SX1262::sleep(bool retainConfig) {
+    (void)retainConfig;
+    return RADIOLIB_ERR_NONE;
+}
+
+LoRaWANNode::LoRaWANNode(PhysicalLayer* physical, const LoRaWANBand_t* lorawanBand, uint8_t lorawanSubBand) :
+    phy(physical),
+    band(lorawanBand),
+    subBand(lorawanSubBand),
+    dataRate(simConfig.dataRate),
+    txPower((int8_t)simConfig.txPowerDbm),
+    adr(true),
+    credentials(false),
+    activated(false),
+    fCntUp(0),
+    devNonce(0),
+    joinNonce(0),
+    devAddr(0),
+    bufferNonces(),
+    bufferSession() {
+}
+
+int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey) {
+    (void)joinEUI; (void)devEUI; (void)nwkKey; (void)appKey;
+    credentials = true;
+    activated = false;
+    return RADIOLIB_ERR_NONE;
+}
+
+int16_t LoRaWANNode::setDatarate(uint8_t drUp) {
+    if (drUp > 4) return RADIOLIB_ERR_INVALID_DATA_RATE;
+    dataRate = drUp;
+    return RADIOLIB_ERR_NONE;
+}
+
+// SX1262 output range; the US915 EIRP limit is above the chip's maximum
+int16_t LoRaWANNode::setTxPower(int8_t power) {
+    if (power < -9 || power > 22) return RADIOLIB_ERR_INVALID_OUTPUT_POWER;
+    txPower = power;
+    return RADIOLIB_ERR_NONE;
+}
+
+// Waits out RX1 (and RX2 when RX1 stays empty) on the virtual clock
+void LoRaWANNode::receiveWindows(bool join, bool delivered, uint32_t downlinkAirtimeUs) {
+    simAdvanceUs(join ? SIM_JOIN_ACCEPT_DELAY1_US : SIM_RECEIVE_DELAY1_US);
+    if (delivered) {
+        simAdvanceUs(downlinkAirtimeUs);
+        simRadioStats.rxWindowUs += downlinkAirtimeUs;
+        return;
+    }
+    simAdvanceUs(SIM_RX_DETECT_US + SIM_RX2_AFTER_RX1_US);
+    simRadioStats.rxWindowUs += 2 * SIM_RX_DETECT_US;
+}
+
+static uint32_t uplinkAirtimeUs(const LoRaWANBand_t* band, uint8_t dataRate, size_t phyPayloadBytes) {
+    return simLoRaAirtimeUs(band->spreadingFactor[dataRate], band->bandwidthKhz[dataRate] * 1000UL, phyPayloadBytes);
+}
+
+static uint32_t downlinkAirtimeUs(uint8_t dataRate, size_t phyPayloadBytes) {
+    uint8_t spreadingFactor = dataRate >= 4 ? 8 : 10 - dataRate;
+    return simLoRaAirtimeUs(spreadingFactor, 500000, phyPayloadBytes);
+}
+
+// The gateways listen on one sub-band; a node built for sub-band 0 picks any
+// of the 64 125 kHz channels, 1 in 8 of them heard
+bool LoRaWANNode::channelHeard() const {
+    if (subBand == 0) return simRandom() % 8 + 1 == simConfig.networkSubBand;
+    return subBand == simConfig.networkSubBand;
+}
+
+// Join request and accept through the link model; returns RADIOLIB_ERR_NONE
+// on a fresh join, which is what LoRaHandler::joinNetwork() checks for
+int16_t LoRaWANNode::activateOTAA(uint8_t initialDr) {
+    if (!credentials) return RADIOLIB_ERR_NETWORK_NOT_JOINED;
+    uint8_t joinDr = initialDr != RADIOLIB_LORAWAN_DATA_RATE_UNUSED && initialDr <= 4 ? initialDr : dataRate;
+
+    devNonce++;
+    simRadioStats.joinRequests++;
+    uint32_t airtime = uplinkAirtimeUs(band, joinDr, SIM_JOIN_REQUEST_BYTES);
+    simAdvanceUs(airtime);
+    simRadioStats.txAirtimeUs += airtime;
+
+    bool heard = channelHeard();
+    if (!heard) {
+        simRadioStats.joinsOffBand++;
+        if (simRadioStats.joinAccepts > 0) simRadioStats.joinsOffBandLater++;
+    }
+    SimLink up = simUplinkLink(joinDr, txPower);
+    SimLink down = simDownlinkLink(joinDr);
+    bool accepted = heard && up.delivered && down.delivered;
+    receiveWindows(true, accepted, downlinkAirtimeUs(joinDr, SIM_JOIN_ACCEPT_BYTES));
+    if (!accepted) return RADIOLIB_ERR_NO_JOIN_ACCEPT;
+
+    simRadioStats.joinAccepts++;
+    phy->setPacketSignal(down.rssi, down.snr);
+    activated = true;
+    fCntUp = 0;
+    joinNonce++;
+    devAddr = simRandom() | 1;
+    networkDevAddr = devAddr;
+    networkFCntHeard = false;
+    return RADIOLIB_ERR_NONE;
+}
+
+// An uplink through the link model. The network answers in RX1 with the
+// ack of a confirmed uplink and the due application downlink, if any
+// (simQueueDownlink()), in one frame; it sends once whether or not the
+// device hears it. Returns whether the device received a downlink
+int16_t LoRaWANNode::transmit(size_t len, bool isConfirmed, uint8_t* dataDown, size_t* lenDown,
+                              LoRaWANEvent_t* eventDown) {
+    if (lenDown) *lenDown = 0;
+    if (!activated) return RADIOLIB_ERR_NETWORK_NOT_JOINED;
+    if (len > band->maxPayload[dataRate]) {
+        simRadioStats.rejectedTooLong++;
+        return RADIOLIB_ERR_PACKET_TOO_LONG;
+    }
+
+    uint32_t airtime = uplinkAirtimeUs(band, dataRate, SIM_MAC_OVERHEAD_BYTES + len);
+    simAdvanceUs(airtime);
+    simRadioStats.txAirtimeUs += airtime;
+    simRadioStats.uplinks++;
+    simBootEvent(SIM_BOOT_FIRST_UPLINK);
+    simRadioStats.payloadBytes += len;
+    uint32_t fCnt = fCntUp++;
+
+    SimLink up = simUplinkLink(dataRate, txPower);
+    up.delivered = up.delivered && channelHeard();
+    // The network drops a frame counter it has already seen in the session
+    if (up.delivered && devAddr == networkDevAddr) {
+        if (networkFCntHeard && fCnt <= networkFCntUp) {
+            simRadioStats.uplinksReplayed++;
+            up.delivered = false;
+        } else {
+            networkFCntUp = fCnt;
+            networkFCntHeard = true;
+        }
+    }
+    simRadioStats.uplinksByDr[dataRate]++;
+    if (up.delivered) {
+        simRadioStats.uplinksDelivered++;
+        simRadioStats.deliveredByDr[dataRate]++;
+    }
+    if (isConfirmed) simRadioStats.confirmedUplinks++;
+
+    uint8_t port = 0;
+    std::vector<uint8_t> data;
+    bool application = up.delivered && simTakeDownlink(port, data);
+    if (application) simRadioStats.downlinksSent++;
+    if (!isConfirmed && !application) {
+        receiveWindows(false, false, 0);
+        return RADIOLIB_ERR_RX_TIMEOUT;
+    }
+
+    SimLink down = simDownlinkLink(dataRate);
+    bool received = up.delivered && down.delivered;
+    size_t frameBytes = application ? SIM_MAC_OVERHEAD_BYTES + data.size() : SIM_ACK_BYTES;
+    receiveWindows(false, received, downlinkAirtimeUs(dataRate, frameBytes));
+    if (!received) return RADIOLIB_ERR_RX_TIMEOUT;
+    if (isConfirmed) simRadioStats.acks++;
+    phy->setPacketSignal(down.rssi, down.snr);
+    if (application) {
+        simRadioStats.downlinksReceived++;
+        if (dataDown && lenDown) {
+            memcpy(dataDown, data.data(), data.size());
+            *lenDown = data.size();
+        }
+    }
+    if (eventDown) {
+        memset(eventDown, 0, sizeof(*eventDown));
+        eventDown->dir = 1;
+        eventDown->confirming = isConfirmed;
+        eventDown->datarate = dataRate < 4 ? 10 + dataRate : 13;   // RX1
+        eventDown->port = application ? port : 0;
+    }
+    return RADIOLIB_ERR_NONE;
+}
+
+// sentMs and lastFixMs as the uplink started
+static void inspectStatus(uint8_t fPort, const uint8_t* data, size_t len, uint64_t sentMs, uint64_t lastFixMs) {
+    if (fPort == SIM_CONFIG_ACK_PORT && len >= SIM_CONFIG_ACK_BYTES) {
+        data += SIM_CONFIG_ACK_BYTES;
+        len -= SIM_CONFIG_ACK_BYTES;
+    } else if (fPort != SIM_STATUS_PORT) {
+        return;
+    }
+    if (!data || len < SIM_STATUS_FLAGS_OFFSET) return;
+    uint8_t flags = len > SIM_STATUS_FLAGS_OFFSET ? data[SIM_STATUS_FLAGS_OFFSET] : 0;
+    if (flags & SIM_STATUS_FLAG_NO_POSITION) return;
+    if (flags & SIM_STATUS_FLAG_ESTIMATED) {
+        simRadioStats.positionsEstimated++;
+        return;
+    }
+    simRadioStats.positionsLive++;
+    if (lastFixMs == 0 || sentMs > lastFixMs + SIM_FIX_STALE_MS) simRadioStats.positionsStale++;
+}
+
+// Unconfirmed uplinks succeed once transmitted (the device cannot know
+// whether a gateway heard them); confirmed ones need the ACK in RX1. A
+// downlink that came with it is dropped
+int16_t LoRaWANNode::uplink(uint8_t* data, size_t len, uint8_t fPort, bool isConfirmed) {
+    uint64_t sentMs = simNowMs();
+    uint64_t lastFixMs = simGnssLastFixMs();
+    int16_t state = transmit(len, isConfirmed, nullptr, nullptr, nullptr);
+    if (state == RADIOLIB_ERR_NONE || state == RADIOLIB_ERR_RX_TIMEOUT) inspectStatus(fPort, data, len, sentMs, lastFixMs);
+    return state == RADIOLIB_ERR_RX_TIMEOUT && !isConfirmed ? RADIOLIB_ERR_NONE : state;
+}
+
+int16_t LoRaWANNode::sendReceive(uint8_t* dataUp, size_t lenUp, uint8_t fPort, uint8_t* dataDown, size_t* lenDown,
+                                 bool isConfirmed, LoRaWANEvent_t* eventUp, LoRaWANEvent_t* eventDown) {
+    uint64_t sentMs = simNowMs();
+    uint64_t lastFixMs = simGnssLastFixMs();
+    int16_t state = transmit(lenUp, isConfirmed, dataDown, lenDown, eventDown);
+    if (state == RADIOLIB_ERR_NONE || state == RADIOLIB_ERR_RX_TIMEOUT) inspectStatus(fPort, dataUp, lenUp, sentMs, lastFixMs);
+    if (eventUp && (state == RADIOLIB_ERR_NONE || state == RADIOLIB_ERR_RX_TIMEOUT)) {
+        memset(eventUp, 0, sizeof(*eventUp));
+        eventUp->confirmed = isConfirmed;
+        eventUp->datarate = dataRate;
+        eventUp->power = txPower;
+        eventUp->fcnt = fCntUp - 1;
+        eventUp->port = fPort;
+    }
+    return state;
+}
+
+// ---------------------------------------------------------------------------
+// Persistence buffers: fields little-endian, a 16-bit signature over the
+// rest in the last two bytes
+
+static void putU32(uint8_t* at, uint32_t value) {
+    for (int i = 0; i < 4; i++) at[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t* at) {
+    return (uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16 | (uint32_t)at[3] << 24;
+}
+
+uint16_t LoRaWANNode::checkSum16(const uint8_t* key, uint16_t keyLen) {
+    uint16_t signature = 0xA55A;
+    for (size_t i = 0; i < keyLen; i++) signature = (uint16_t)((signature << 5 | signature >> 11) ^ key[i]);
+    return signature;
+}
+
+static uint16_t bufferSignature(const uint8_t* buffer, size_t size) {
+    return LoRaWANNode::checkSum16(buffer, (uint16_t)(size - 2));
+}
+
+static void signBuffer(uint8_t* buffer, size_t size) {
+    uint16_t signature = bufferSignature(buffer, size);
+    buffer[size - 2] = (uint8_t)signature;
+    buffer[size - 1] = (uint8_t)(signature >> 8);
+}
+
+static bool signatureValid(const uint8_t* buffer, size_t size) {
+    uint16_t signature = bufferSignature(buffer, size);
+    return buffer[size - 2] == (uint8_t)signature && buffer[size - 1] == (uint8_t)(signature >> 8);
+}
+
+// Layout: devNonce, joinNonce
+uint8_t* LoRaWANNode::getBufferNonces() {
+    memset(bufferNonces, 0, sizeof(bufferNonces));
+    putU32(bufferNonces, devNonce);
+    putU32(bufferNonces + 4, joinNonce);
+    signBuffer(bufferNonces, sizeof(bufferNonces));
+    return bufferNonces;
+}
+
+int16_t LoRaWANNode::setBufferNonces(uint8_t* persistentBuffer) {
+    if (!persistentBuffer || !signatureValid(persistentBuffer, RADIOLIB_LORAWAN_NONCES_BUF_SIZE)) {
+        return RADIOLIB_LORAWAN_NONCES_DISCARDED;
+    }
+    devNonce = getU32(persistentBuffer);
+    joinNonce = getU32(persistentBuffer + 4);
+    return RADIOLIB_ERR_NONE;
+}
+
+// Layout: activated, devAddr, fCntUp, joinNonce, data rate, sub-band (the
+// channel mask RadioLib keeps with the session; 0 in older buffers)
+uint8_t* LoRaWANNode::getBufferSession() {
+    memset(bufferSession, 0, sizeof(bufferSession));
+    bufferSession[0] = activated ? 1 : 0;
+    putU32(bufferSession + 1, devAddr);
+    putU32(bufferSession + RADIOLIB_LORAWAN_SESSION_FCNT_UP, fCntUp);
+    putU32(bufferSession + 9, joinNonce);
+    bufferSession[13] = dataRate;
+    bufferSession[14] = subBand;
+    signBuffer(bufferSession, sizeof(bufferSession));
+    return bufferSession;
+}
+
+int16_t LoRaWANNode::setBufferSession(uint8_t* persistentBuffer) {
+    if (!persistentBuffer || !signatureValid(persistentBuffer, RADIOLIB_LORAWAN_SESSION_BUF_SIZE) ||
+        !persistentBuffer[0] || getU32(persistentBuffer + 9) != joinNonce || persistentBuffer[13] > 4) {
+        return RADIOLIB_LORAWAN_SESSION_DISCARDED;
+    }
+    devAddr = getU32(persistentBuffer + 1);
+    fCntUp = getU32(persistentBuffer + RADIOLIB_LORAWAN_SESSION_FCNT_UP);
+    dataRate = persistentBuffer[13];
+    if (persistentBuffer[14] != 0) subBand = persistentBuffer[14];
+    activated = true;
+    return RADIOLIB_ERR_NONE;
+}
@@ -0,0 +1,190 @@
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+#include "sim_world.h"
+#include "alloc_audit.h"
+#include <math.h>
+#include <string.h>
+#include <deque>
+
+// Uncalibrated ADC1 at 11 dB: nominal full scale, and how far a chip
+// strays from it; each simulated chip gets its own gain and offset from
+// the seed, and its eFuse holds what the factory measured
+#define SIM_ADC_FULL_SCALE_MV   3100.0
+#define SIM_ADC_MAX_CODE        4095
+#define SIM_ADC_GAIN_SPREAD     0.04    // +-4 %
+#define SIM_ADC_OFFSET_SPREAD   40.0    // +-40 mV
+#define SIM_ADC_NOISE_CODES     6.0     // Per conversion, one sigma
+#define SIM_ADC_CAL_SCALE       65536
+
+struct SimAdc {
+    bool initialized;
+    bool configured;
+    bool running;
+    uint32_t ringBytes;
+    uint32_t channelMask;
+    uint8_t channel;
+    uint32_t sampleHz;
+    uint64_t lastUs;            // Conversions are generated up to here
+    uint64_t carryUs;           // Part of a sample period not converted yet
+    bool overflowed;
+    std::deque<uint32_t> ring;
+};
+
+static SimAdc adc;
+
+// ESP32-S3 ADC1: channel n is GPIO n + 1
+static uint8_t channelPin(uint8_t channel) {
+    return channel + 1;
+}
+
+// Per-chip transfer curve, fixed by the seed but drawn apart from the
+// run's random stream so that other results do not move
+static void chipCurve(double& gain, double& offsetMv) {
+    uint32_t h = simConfig.seed * 2654435761u;
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    gain = 1.0 + ((h & 0xFFFF) / 65535.0 * 2.0 - 1.0) * SIM_ADC_GAIN_SPREAD;
+    offsetMv = (((h >> 16) & 0xFFFF) / 65535.0 * 2.0 - 1.0) * SIM_ADC_OFFSET_SPREAD;
+}
+
+static uint32_t convert(uint8_t channel) {
+    double gain, offsetMv;
+    chipCurve(gain, offsetMv);
+    double mv = simAnalogPinMv(channelPin(channel));
+    double code = (mv * gain + offsetMv) * SIM_ADC_MAX_CODE / SIM_ADC_FULL_SCALE_MV + simGaussian(SIM_ADC_NOISE_CODES);
+    if (code < 0) code = 0;
+    if (code > SIM_ADC_MAX_CODE) code = SIM_ADC_MAX_CODE;
+
+    adc_digi_output_data_t result;
+    result.val = 0;
+    result.type2.data = (uint32_t)(code + 0.5);
+    result.type2.channel = channel;
+    result.type2.unit = 0;
+    return result.val;
+}
+
+// Conversions for the virtual time since the last call, into the ring (a
+// host deque, not the driver's DMA buffer: AllocAuditHostScope)
+static void generate() {
+    AllocAuditHostScope host;
+    uint64_t now = simNowUs();
+    if (!adc.running || adc.sampleHz == 0) {
+        adc.lastUs = now;
+        return;
+    }
+    uint64_t periodUs = 1000000ULL / adc.sampleHz;
+    uint64_t elapsed = now - adc.lastUs + adc.carryUs;
+    uint64_t count = elapsed / periodUs;
+    adc.carryUs = elapsed % periodUs;
+    adc.lastUs = now;
+
+    size_t capacity = adc.ringBytes / SOC_ADC_DIGI_RESULT_BYTES;
+    uint64_t room = capacity > adc.ring.size() ? capacity - adc.ring.size() : 0;
+    uint64_t kept = count < room ? count : room;
+    for (uint64_t i = 0; i < kept; i++) adc.ring.push_back(convert(adc.channel));
+    simAdcStats.conversions += count;
+    if (count > kept) {
+        simAdcStats.dropped += count - kept;
+        adc.overflowed = true;
+    }
+}
+
+void simAdcReset() {
+    AllocAuditHostScope host;
+    adc = SimAdc();
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config) {
+    if (!init_config) return ESP_ERR_INVALID_ARG;
+    if (adc.initialized) return ESP_ERR_INVALID_STATE;
+    if (init_config->adc2_chan_mask) return ESP_ERR_NOT_SUPPORTED;     // No ADC2 DMA on the S3
+    adc.initialized = true;
+    adc.ringBytes = init_config->max_store_buf_size;
+    adc.channelMask = init_config->adc1_chan_mask;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config) {
+    if (!adc.initialized) return ESP_ERR_INVALID_STATE;
+    if (!config || config->pattern_num != 1 || !config->adc_pattern) return ESP_ERR_INVALID_ARG;
+    const adc_digi_pattern_config_t& pattern = config->adc_pattern[0];
+    if (pattern.unit != 0 || pattern.channel >= SOC_ADC_MAX_CHANNEL_NUM || !(adc.channelMask & BIT(pattern.channel))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || config->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH ||
+        config->conv_mode != ADC_CONV_SINGLE_UNIT_1 || config->format != ADC_DIGI_OUTPUT_FORMAT_TYPE2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    adc.channel = pattern.channel;
+    adc.sampleHz = config->sample_freq_hz;
+    adc.configured = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+    if (!adc.configured) return ESP_ERR_INVALID_STATE;
+    adc.running = true;
+    adc.lastUs = simNowUs();
+    adc.carryUs = 0;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+    generate();
+    adc.running = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+    if (!adc.initialized) return ESP_ERR_INVALID_STATE;
+    generate();
+    if (adc.ring.empty() && timeout_ms > 0 && adc.running) {
+        simAdvanceUs((uint64_t)timeout_ms * 1000);
+        generate();
+    }
+    uint32_t length = 0;
+    while (!adc.ring.empty() && length + SOC_ADC_DIGI_RESULT_BYTES <= length_max) {
+        uint32_t value = adc.ring.front();
+        adc.ring.pop_front();
+        memcpy(buf + length, &value, SOC_ADC_DIGI_RESULT_BYTES);
+        length += SOC_ADC_DIGI_RESULT_BYTES;
+    }
+    *out_length = length;
+    if (adc.overflowed) {
+        adc.overflowed = false;
+        return ESP_ERR_INVALID_STATE;
+    }
+    return length ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t adc_digi_deinitialize() {
+    simAdcReset();
+    return ESP_OK;
+}
+
+esp_err_t esp_adc_cal_check_efuse(esp_adc_cal_value_t value_type) {
+    return value_type == ESP_ADC_CAL_VAL_EFUSE_TP_FIT ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+}
+
+// The eFuse two-point values pin the chip's curve down; inverting it gives the line
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t* chars) {
+    double gain, offsetMv;
+    chipCurve(gain, offsetMv);
+    double mvPerCode = SIM_ADC_FULL_SCALE_MV / SIM_ADC_MAX_CODE / gain;
+    chars->adc_num = adc_num;
+    chars->atten = atten;
+    chars->bit_width = bit_width;
+    chars->coeff_a = (uint32_t)(mvPerCode * SIM_ADC_CAL_SCALE + 0.5);
+    // Unsigned as in the driver; a negative intercept wraps and is read back signed
+    chars->coeff_b = (uint32_t)(int32_t)lround(-offsetMv / gain);
+    chars->vref = default_vref;
+    return ESP_ADC_CAL_VAL_EFUSE_TP_FIT;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t* chars) {
+    int64_t mv = ((int64_t)adc_reading * chars->coeff_a + SIM_ADC_CAL_SCALE / 2) / SIM_ADC_CAL_SCALE +
+                 (int32_t)chars->coeff_b;
+    return mv > 0 ? (uint32_t)mv : 0;
+}
@@ -0,0 +1,242 @@
+#include "sim_world.h"
+#include "Config.h"
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+// UC6580-style receiver: one epoch per second of GGA, GSA, three GSV,
+// RMC and VTG, clocked out at the UART baud rate. The receiver runs while
+// its power pin is HIGH, whether or not the UART is open, and needs
+// simConfig.ttffMs from the pin's rising edge for a fix,
+// or simConfig.hotStartMs when it had a fix less than SIM_GNSS_EPHEMERIS_MS
+// before (backup domain kept time and ephemeris, as across a deep sleep).
+// Bytes the firmware does not read in time overflow the RX ring and are
+// lost, exactly where TinyGPS++ would then see failed checksums; so are
+// bytes that arrive while the chip is in light sleep.
+
+#define SIM_GNSS_TIME_AFTER_MS  2000    // Receiver knows UTC this long after power-on
+#define SIM_GNSS_COMPACT_BYTES  4096
+#define SIM_GNSS_EPHEMERIS_MS   (4ULL * 3600000ULL)     // Broadcast ephemeris stays usable this long
+
+static bool started = false;
+static bool asleep = false;
+static bool powered = false;
+static uint64_t poweredSinceMs = 0;
+static uint64_t fixAfterMs = 0;         // TTFF of the current power-on
+static bool hotStart = false;
+static bool hadFix = false;
+static uint64_t lastFixMs = 0;
+static uint64_t nextEpochMs = 0;
+static double byteUs = 1041.7;          // 9600 baud, 10 bits per byte
+// Outlive the firmware's globals: ~GPSHandler ends Serial1 at exit
+static std::string line __attribute__((init_priority(101)));   // Bytes in flight on the wire
+static size_t linePosition = 0;
+static double nextByteUs = 0;
+static std::vector<uint8_t> ring __attribute__((init_priority(101)));
+static size_t ringHead = 0;
+static size_t ringCount = 0;
+
+static void appendSentence(const char* body) {
+    uint8_t checksum = 0;
+    for (const char* c = body; *c; c++) checksum ^= (uint8_t)*c;
+    char sentence[128];
+    snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+    line.append(sentence);
+}
+
+static void formatCoordinate(char* out, size_t size, double value, int degreeDigits) {
+    double magnitude = fabs(value);
+    int degrees = (int)magnitude;
+    double minutes = (magnitude - degrees) * 60.0;
+    snprintf(out, size, "%0*d%08.5f", degreeDigits, degrees, minutes);
+}
+
+static void generateEpoch(uint64_t epochMs) {
+    SimPosition position = simPosition(epochMs);
+    uint64_t sincePowerOn = epochMs - poweredSinceMs;
+    bool fix = position.fix && sincePowerOn >= fixAfterMs;
+    bool timeKnown = hotStart || sincePowerOn >= SIM_GNSS_TIME_AFTER_MS;
+    int satellites = sincePowerOn >= fixAfterMs ? position.satellites : (int)(sincePowerOn / 10000);
+
+    simGpsStats.epochs++;
+    if (fix) {
+        simGpsStats.epochsWithFix++;
+        hadFix = true;
+        lastFixMs = epochMs;
+        if (started) simBootEvent(SIM_BOOT_FIRST_FIX);
+    }
+
+    char timeField[16] = "";
+    char dateField[24] = "";
+    if (timeKnown) {
+        int64_t unixMs = simConfig.startUnixMs + (int64_t)epochMs;
+        time_t seconds = (time_t)(unixMs / 1000);
+        struct tm utc;
+        gmtime_r(&seconds, &utc);
+        snprintf(timeField, sizeof(timeField), "%02d%02d%02d.%02d", utc.tm_hour, utc.tm_min, utc.tm_sec,
+                 (int)(unixMs % 1000) / 10);
+        snprintf(dateField, sizeof(dateField), "%02d%02d%02d", utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100);
+    }
+
+    char latitude[24] = "";
+    char longitude[24] = "";
+    char latitudeSide[2] = "";
+    char longitudeSide[2] = "";
+    if (fix) {
+        formatCoordinate(latitude, sizeof(latitude), position.latitude, 2);
+        formatCoordinate(longitude, sizeof(longitude), position.longitude, 3);
+        latitudeSide[0] = position.latitude >= 0 ? 'N' : 'S';
+        longitudeSide[0] = position.longitude >= 0 ? 'E' : 'W';
+    }
+
+    double knots = position.speedMps * 1.943844;
+    char body[112];
+    if (fix) {
+        snprintf(body, sizeof(body), "GNGGA,%s,%s,%s,%s,%s,1,%02d,%.2f,%.1f,M,-22.0,M,,", timeField, latitude,
+                 latitudeSide, longitude, longitudeSide, satellites, position.hdop, position.altitudeM);
+    } else {
+        snprintf(body, sizeof(body), "GNGGA,%s,,,,,0,%02d,99.99,,,,,,", timeField, satellites);
+    }
+    appendSentence(body);
+
+    snprintf(body, sizeof(body), "GNGSA,A,%d,%s,%.2f,%.2f,%.2f,1", fix ? 3 : 1,
+             fix ? "02,05,07,09,13,15,18,20,,,," : ",,,,,,,,,,,", fix ? position.hdop * 1.4 : 99.99,
+             fix ? position.hdop : 99.99, fix ? position.hdop * 1.1 : 99.99);
+    appendSentence(body);
+
+    for (int message = 1; message <= 3; message++) {
+        snprintf(body, sizeof(body), "GPGSV,3,%d,%02d,%02d,%02d,%03d,%02d,%02d,%02d,%03d,%02d,%02d,%02d,%03d,%02d,%02d,%02d,%03d,%02d",
+                 message, satellites, message * 4 - 3, 40 + message * 7, 45 * message, fix ? 38 : 12,
+                 message * 4 - 2, 25 + message * 5, 90 + 30 * message, fix ? 35 : 0,
+                 message * 4 - 1, 60 - message * 9, 200 + 20 * message, fix ? 31 : 0,
+                 message * 4, 15 + message * 3, 300 - 25 * message, fix ? 27 : 0);
+        appendSentence(body);
+    }
+
+    if (fix) {
+        snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,%s,,,A", timeField, latitude, latitudeSide,
+                 longitude, longitudeSide, knots, position.courseDeg, dateField);
+    } else {
+        snprintf(body, sizeof(body), "GNRMC,%s,V,,,,,,,%s,,,N", timeField, dateField);
+    }
+    appendSentence(body);
+
+    if (fix) {
+        snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", position.courseDeg, knots,
+                 position.speedMps * 3.6);
+    } else {
+        snprintf(body, sizeof(body), "GNVTG,,,,,,,,,N");
+    }
+    appendSentence(body);
+}
+
+static void receiveByte(uint8_t c) {
+    if (!started) return;       // Nobody listening on the UART yet
+    simGpsStats.bytesSent++;
+    if (asleep) {
+        simGpsStats.bytesLostAsleep++;
+        return;
+    }
+    if (ringCount == ring.size()) {
+        simGpsStats.bytesDropped++;
+        return;
+    }
+    ring[(ringHead + ringCount) % ring.size()] = c;
+    ringCount++;
+}
+
+// Runs the receiver and the wire up to the current virtual time
+static void advance() {
+    if (!simGetPin(GPS_PWR_PIN)) {
+        powered = false;
+        line.clear();
+        linePosition = 0;
+        return;
+    }
+    // Power-on is the pin's rising edge, also one this code did not see
+    // (the pin dropped and came back, as across a deep sleep)
+    uint64_t nowUs = simNowUs();
+    uint64_t risingMs = simPinHighSinceUs(GPS_PWR_PIN) / 1000;
+    if (!powered || risingMs != poweredSinceMs) {
+        if (powered) {
+            line.clear();
+            linePosition = 0;
+        }
+        powered = true;
+        poweredSinceMs = risingMs;
+        nextEpochMs = poweredSinceMs + 1000;
+        hotStart = hadFix && poweredSinceMs - lastFixMs < SIM_GNSS_EPHEMERIS_MS;
+        fixAfterMs = hotStart ? simConfig.hotStartMs : simConfig.ttffMs;
+    }
+
+    for (;;) {
+        bool lineBusy = linePosition < line.size();
+        double epochUs = (double)nextEpochMs * 1000.0;
+        if (lineBusy && nextByteUs <= nowUs && (nextByteUs <= epochUs || epochUs > nowUs)) {
+            receiveByte((uint8_t)line[linePosition++]);
+            nextByteUs += byteUs;
+        } else if (epochUs <= nowUs) {
+            if (!lineBusy) nextByteUs = epochUs;
+            generateEpoch(nextEpochMs);
+            nextEpochMs += 1000;
+        } else {
+            break;
+        }
+    }
+
+    if (linePosition > SIM_GNSS_COMPACT_BYTES) {
+        line.erase(0, linePosition);
+        linePosition = 0;
+    }
+}
+
+void simGnssBegin(unsigned long baud, size_t rxBufferSize) {
+    byteUs = 10e6 / (double)baud;
+    ring.assign(rxBufferSize, 0);
+    ringHead = 0;
+    ringCount = 0;
+    advance();              // Catch the receiver up before the UART listens
+    started = true;
+}
+
+void simGnssEnd() {
+    advance();
+    started = false;
+}
+
+void simGnssSetAsleep(bool sleeping) {
+    advance();
+    asleep = sleeping;
+}
+
+uint64_t simGnssLastFixMs() {
+    advance();
+    return hadFix ? lastFixMs : 0;
+}
+
+uint64_t simGnssNextByteUs() {
+    advance();
+    if (!started || !powered) return UINT64_MAX;
+    if (linePosition < line.size()) return (uint64_t)ceil(nextByteUs);
+    return nextEpochMs * 1000;
+}
+
+int simGnssAvailable() {
+    advance();
+    return (int)ringCount;
+}
+
+int simGnssPeek() {
+    advance();
+    return ringCount ? ring[ringHead] : -1;
+}
+
+int simGnssRead() {
+    advance();
+    if (ringCount == 0) return -1;
+    uint8_t c = ring[ringHead];
+    ringHead = (ringHead + 1) % ring.size();
+    ringCount--;
+    simGpsStats.bytesRead++;
+    return c;
+}
@@ -0,0 +1,457 @@
+/**
+ * LoRa Gateway Sniffer - Native Simulation Driver
+ *
+ * Runs the firmware's unmodified setup()/loop() against the simulated
+ * peripherals in sim_world.h on a virtual clock, then reports what a day
+ * (or any span) of operation costs: radio duty cycle, GNSS UART drops,
+ * NVS wear, LittleFS traffic, display work, heap drift and pin residency.
+ * A deep sleep (esp_sleep.h) skips the clock to the wake and boots the
+ * firmware again through setup(), as the chip does; so does ESP.restart(),
+ * without the skip.
+ *
+ * Usage:
+ *   pio run -e native && .pio/build/native/program [options]
+ *
+ * Options:
+ *   --hours N             Virtual hours to run (default 24)
+ *   --seed N              Seed for the route noise and radio fading (default 1)
+ *   --dr N                US915 uplink data rate 0..4 (default 3)
+ *   --console FILE|-      Write the firmware's serial output to FILE or stdout
+ *   --fs DIR              Keep the LittleFS files in DIR (default: temporary, removed)
+ *   --command SEC:TEXT    Type a console command at SEC seconds (repeatable)
+ *   --button SEC          Press the user button at SEC seconds (repeatable)
+ *   --downlink SEC:PORT:HEX  Queue an application downlink at the network from SEC
+ *                         seconds on; it goes out after the next uplink heard (repeatable)
+ *   --ttff SEC            GNSS time to first fix (default 45)
+ *   --hot-start SEC       GNSS time to fix after a recent fix, e.g. across a deep sleep (default 5)
+ *   --outage-every SEC    Lose the fix periodically, 0 = never (default 3600)
+ *   --outage-length SEC   Length of each outage (default 120)
+ *   --report-every SEC    Progress line interval on stderr (default 3600)
+ *   --display             Print the screen contents at the end
+ *   --check-boot          Exit with status 4 if any boot broke the staged boot
+ *                         order (GNSS power, radio, display after setup())
+ *   --pm full|dfs|none    Power management in the firmware's IDF build: frequency
+ *                         scaling and light sleep, scaling only, or none (default full)
+ *   --no-usb              Run on battery: no USB host on the console
+ *   --sub-band N          US915 sub-band 1..8 the network's gateways listen on (default 2)
+ *   --check-join          Exit with status 5 if a join request after the run's first
+ *                         accept went out on another sub-band (the learned one was not used)
+ *   --check-fix           Exit with status 6 if a status uplink sent after the receiver
+ *                         lost its fix carried a position not flagged estimated
+ *   --check-allocs        Exit with status 7 if a loop pass after the warm-up allocated
+ *                         from the heap (the models' own host allocations aside)
+ */
+
+#include "Arduino.h"
+#include "sim_world.h"
+#include "Config.h"
+#include "alloc_audit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Heap use settles once every code path has run (first join, first log
+// flush, NVS namespaces created); drift is measured from here on
+#define SIM_HEAP_WARMUP_MS  3600000
+
+// Loop passes before heap allocations count against the steady state, as
+// the firmware's own loop audit (`allocs`)
+#define SIM_ALLOC_WARMUP_PASSES 50
+
+struct SimAllocStats {
+    uint32_t allocatingPasses;  // After the warm-up
+    uint32_t worstPass;
+    uint32_t allocations;       // In those passes
+};
+
+static SimAllocStats allocStats;
+
+void setup();
+void loop();
+
+struct PinReport {
+    uint8_t pin;
+    const char* name;
+};
+
+static const PinReport REPORTED_PINS[] = {
+    {VEXT_PIN, "VEXT"},
+    {VTFT_PIN, "VTFT"},
+    {GPS_PWR_PIN, "GPS_PWR"},
+    {TFT_BLK, "TFT_BLK"},
+    {USER_LED_PIN, "USER_LED"},
+};
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--hours N] [--seed N] [--dr N] [--console FILE|-] [--fs DIR]\n"
+            "          [--command SEC:TEXT]... [--button SEC]... [--downlink SEC:PORT:HEX]...\n"
+            "          [--ttff SEC] [--hot-start SEC]\n"
+            "          [--outage-every SEC] [--outage-length SEC] [--report-every SEC] [--display]\n"
+            "          [--check-boot] [--pm full|dfs|none] [--no-usb] [--sub-band N] [--check-join]\n"
+            "          [--check-fix] [--check-allocs]\n",
+            program);
+}
+
+// SEC:PORT:HEX, port 1..223 and at least one payload byte
+static bool queueDownlink(const char* value) {
+    const char* port = strchr(value, ':');
+    const char* hex = port ? strchr(port + 1, ':') : nullptr;
+    if (!hex) return false;
+    int fPort = atoi(port + 1);
+    size_t digits = strlen(hex + 1);
+    if (fPort < 1 || fPort > 223 || digits == 0 || digits % 2 != 0) return false;
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < digits; i += 2) {
+        char byte[3] = {hex[1 + i], hex[2 + i], 0};
+        char* end;
+        data.push_back((uint8_t)strtoul(byte, &end, 16));
+        if (*end != 0) return false;
+    }
+    simQueueDownlink((uint64_t)(atof(value) * 1000.0), (uint8_t)fPort, data);
+    return true;
+}
+
+static int removeEntry(const char* path, const struct stat* info, int flag, struct FTW* walk) {
+    (void)info; (void)flag; (void)walk;
+    return remove(path);
+}
+
+// setup() again after every deep sleep or restart it ends in, until the run is over
+static void bootFirmware(uint64_t endMs) {
+    for (;;) {
+        try {
+            setup();
+            simBootEvent(SIM_BOOT_SETUP_DONE);
+            return;
+        } catch (const SimReboot&) {
+            if (simNowMs() >= endMs) return;
+        }
+    }
+}
+
+// Milestone of the power-on boot, from the boot
+static std::string bootTime(uint64_t us) {
+    if (us == SIM_BOOT_NOT_REACHED) return "-";
+    char text[24];
+    snprintf(text, sizeof(text), us < 10000000 ? "%.0f ms" : "%.1f s", us < 10000000 ? us / 1e3 : us / 1e6);
+    return text;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static void printReport(uint64_t virtualMs, double realSeconds, uint64_t passes, uint32_t heapStart,
+                        uint64_t heapWarmMs, uint32_t heapWarm, uint32_t heapEnd) {
+    double hours = virtualMs / 3600000.0;
+    double days = virtualMs / 86400000.0;
+
+    fprintf(stderr, "\n[Sim] === Report ===\n");
+    fprintf(stderr, "[Sim] Virtual time: %.2f h in %.2f s real (%.0fx), %llu loop passes\n", hours, realSeconds,
+            realSeconds > 0 ? virtualMs / 1000.0 / realSeconds : 0.0, (unsigned long long)passes);
+
+    fprintf(stderr, "[Sim] Radio: %u join requests, %u accepts; %u uplinks (%u heard by the gateway, %u too long, "
+            "%u replayed frame counters)\n",
+            simRadioStats.joinRequests, simRadioStats.joinAccepts, simRadioStats.uplinks,
+            simRadioStats.uplinksDelivered, simRadioStats.rejectedTooLong, simRadioStats.uplinksReplayed);
+    fprintf(stderr, "[Sim]   network on sub-band %u: %u join requests off it (%u after the first accept)\n",
+            simConfig.networkSubBand, simRadioStats.joinsOffBand, simRadioStats.joinsOffBandLater);
+    fprintf(stderr, "[Sim]   confirmed %u, acked %u; %llu payload bytes; TX %.1f s (%.3f%% duty), RX %.1f s\n",
+            simRadioStats.confirmedUplinks, simRadioStats.acks, (unsigned long long)simRadioStats.payloadBytes,
+            simRadioStats.txAirtimeUs / 1e6, percent(simRadioStats.txAirtimeUs / 1000, virtualMs),
+            simRadioStats.rxWindowUs / 1e6);
+    fprintf(stderr, "[Sim]   positions: %u live, %u estimated; %u sent as live after the fix was lost\n",
+            simRadioStats.positionsLive, simRadioStats.positionsEstimated, simRadioStats.positionsStale);
+    if (simRadioStats.downlinksQueued > 0) {
+        fprintf(stderr, "[Sim]   downlinks: %u queued, %u sent, %u received\n", simRadioStats.downlinksQueued,
+                simRadioStats.downlinksSent, simRadioStats.downlinksReceived);
+    }
+    // Gateway-side truth for a data-rate survey (the device only sees acks)
+    int dataRates = 0;
+    for (int dr = 0; dr < 5; dr++) dataRates += simRadioStats.uplinksByDr[dr] > 0;
+    if (dataRates > 1) {
+        fprintf(stderr, "[Sim]   heard per data rate:");
+        for (int dr = 0; dr < 5; dr++) {
+            if (simRadioStats.uplinksByDr[dr] == 0) continue;
+            fprintf(stderr, " DR%d %u/%u", dr, simRadioStats.deliveredByDr[dr], simRadioStats.uplinksByDr[dr]);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "[Sim] GNSS: %u epochs (%u with fix); %llu bytes sent, %llu read, %llu dropped (%.1f%%), %llu lost asleep\n",
+            simGpsStats.epochs, simGpsStats.epochsWithFix, (unsigned long long)simGpsStats.bytesSent,
+            (unsigned long long)simGpsStats.bytesRead, (unsigned long long)simGpsStats.bytesDropped,
+            percent(simGpsStats.bytesDropped, simGpsStats.bytesSent), (unsigned long long)simGpsStats.bytesLostAsleep);
+
+    // Residency over the time the chip was up (deep sleep is reported below)
+    float cpuMa = simCpuCurrentMa();
+    uint64_t upUs = simPowerStats.lightSleepUs;
+    for (int i = 0; i < SIM_CPU_FREQ_COUNT; i++) upUs += simPowerStats.cpuUs[i];
+    fprintf(stderr, "[Sim] CPU: 80 MHz %.1f%%, 160 MHz %.1f%%, 240 MHz %.1f%%, light sleep %.1f%% (%u sleeps, %u GNSS wakes, %u timers); %u clock switches, SoC %.1f mA\n",
+            percent(simPowerStats.cpuUs[0], upUs), percent(simPowerStats.cpuUs[1], upUs),
+            percent(simPowerStats.cpuUs[2], upUs), percent(simPowerStats.lightSleepUs, upUs), simPowerStats.lightSleeps,
+            simPowerStats.gnssWakes, simPowerStats.timerWakes, simPowerStats.frequencySwitches, cpuMa);
+
+    // Each NVS page holds 126 entries; a full page is erased when it is
+    // reclaimed, so entries written per day bound the erase rate
+    uint64_t entries = simNvsStats.totalEntries();
+    double erasesPerDay = days > 0 ? entries / (double)SIM_NVS_ENTRIES_PER_PAGE / days : 0.0;
+    double erasesPerSectorPerDay = erasesPerDay / SIM_NVS_PAGES;
+    fprintf(stderr, "[Sim] NVS: %u commits, %llu entries written, %.1f page erases/day", simNvsStats.commits,
+            (unsigned long long)entries, erasesPerDay);
+    if (erasesPerSectorPerDay > 0) {
+        fprintf(stderr, ", %.1f years to %u cycles\n", SIM_FLASH_ENDURANCE / erasesPerSectorPerDay / 365.0,
+                SIM_FLASH_ENDURANCE);
+    } else {
+        fprintf(stderr, "\n");
+    }
+    for (const auto& key : simNvsStats.keys) {
+        fprintf(stderr, "[Sim]   %s/%s: %u puts, %u writes, %llu entries\n", key.first.first.c_str(),
+                key.first.second.c_str(), key.second.puts, key.second.writes,
+                (unsigned long long)key.second.entries);
+    }
+
+    fprintf(stderr, "[Sim] LittleFS: %llu bytes written (%.1f KB/day), %u opens, %u removes\n",
+            (unsigned long long)simFsStats.bytesWritten, days > 0 ? simFsStats.bytesWritten / 1024.0 / days : 0.0,
+            simFsStats.opens, simFsStats.removes);
+    fprintf(stderr, "[Sim] Display: %u frames, %llu pixels pushed; %u inits, %u sleeps, %u wakes, %u frames lost; "
+            "backlight %.1f%% lit, %.1f%% mean duty\n", simDisplayStats.clears,
+            (unsigned long long)simDisplayStats.pixels, simDisplayStats.inits, simDisplayStats.sleeps,
+            simDisplayStats.wakes, simDisplayStats.framesLost, percent(simPinHighMs(TFT_BLK), virtualMs),
+            percent(simPinDutyMs(TFT_BLK), virtualMs));
+    fprintf(stderr, "[Sim] Heap: %u free after setup, %u at end, %u minimum", heapStart, heapEnd, simMinFreeHeap());
+    if (heapWarmMs >= SIM_HEAP_WARMUP_MS && virtualMs > heapWarmMs) {
+        fprintf(stderr, "; %u after warm-up, drift %+.1f bytes/h\n", heapWarm,
+                ((double)heapEnd - (double)heapWarm) / ((virtualMs - heapWarmMs) / 3600000.0));
+    } else {
+        fprintf(stderr, "; run too short for drift\n");
+    }
+    if (allocAuditEnabled()) {
+        fprintf(stderr, "[Sim] Allocations: %u loop passes after the first %u allocated (worst %u, %u in all); "
+                "%u host allocations by the models\n", allocStats.allocatingPasses, SIM_ALLOC_WARMUP_PASSES,
+                allocStats.worstPass, allocStats.allocations, allocAuditSnapshot().hostAllocations);
+    }
+    if (simSleepStats.sleeps) {
+        fprintf(stderr, "[Sim] Deep sleep: %u sleeps (%u timer, %u button wakes), %.2f h asleep (%.1f%%)\n",
+                simSleepStats.sleeps, simSleepStats.timerWakes, simSleepStats.buttonWakes,
+                simSleepStats.sleepUs / 3600e6, percent(simSleepStats.sleepUs / 1000, virtualMs));
+    }
+    const uint64_t* boot = simBootStats.powerOnUs;
+    fprintf(stderr, "[Sim] Boot: GNSS power %s, radio %s, setup() %s, display %s, first fix %s, first uplink %s\n",
+            bootTime(boot[SIM_BOOT_GNSS_POWER]).c_str(), bootTime(boot[SIM_BOOT_RADIO]).c_str(),
+            bootTime(boot[SIM_BOOT_SETUP_DONE]).c_str(), bootTime(boot[SIM_BOOT_DISPLAY]).c_str(),
+            bootTime(boot[SIM_BOOT_FIRST_FIX]).c_str(), bootTime(boot[SIM_BOOT_FIRST_UPLINK]).c_str());
+    fprintf(stderr, "[Sim]   %u boots checked, %u boot order violations\n", simBootStats.boots, simBootStats.violations);
+    if (simSleepStats.restarts) {
+        fprintf(stderr, "[Sim] Restarts: %u\n", simSleepStats.restarts);
+    }
+    fprintf(stderr, "[Sim] Battery: cell %.0f mV, terminal %.0f mV at %.0f mA; ADC %llu DMA conversions (%llu dropped), %u one-shot reads (%u in setup() or loop())\n",
+            simBatteryMv(), simBatteryTerminalMv(), simBatteryLoadMa(), (unsigned long long)simAdcStats.conversions,
+            (unsigned long long)simAdcStats.dropped, simAdcStats.oneshotReads,
+            simAdcStats.oneshotReads - simAdcStats.timerReads);
+    fprintf(stderr, "[Sim] Console: %llu bytes, %llu lines\n", (unsigned long long)simConsoleStats.bytesWritten,
+            (unsigned long long)simConsoleStats.lines);
+
+    fprintf(stderr, "[Sim] Pins HIGH:");
+    for (const PinReport& pin : REPORTED_PINS) {
+        fprintf(stderr, " %s %.1f%%", pin.name, percent(simPinHighMs(pin.pin), virtualMs));
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+    double hours = 24.0;
+    uint32_t reportEverySeconds = 3600;
+    const char* fsDir = nullptr;
+    bool showDisplay = false;
+    bool checkBoot = false;
+    bool checkJoin = false;
+    bool checkFix = false;
+    bool checkAllocs = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(option, "--display") == 0) {
+            showDisplay = true;
+            continue;
+        }
+        if (strcmp(option, "--check-boot") == 0) {
+            checkBoot = true;
+            continue;
+        }
+        if (strcmp(option, "--check-join") == 0) {
+            checkJoin = true;
+            continue;
+        }
+        if (strcmp(option, "--check-fix") == 0) {
+            checkFix = true;
+            continue;
+        }
+        if (strcmp(option, "--check-allocs") == 0) {
+            checkAllocs = true;
+            continue;
+        }
+        if (strcmp(option, "--no-usb") == 0) {
+            simConfig.usbHost = false;
+            continue;
+        }
+        if (!value) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (strcmp(option, "--hours") == 0) {
+            hours = atof(value);
+        } else if (strcmp(option, "--seed") == 0) {
+            simConfig.seed = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(option, "--dr") == 0) {
+            simConfig.dataRate = (uint8_t)atoi(value);
+        } else if (strcmp(option, "--console") == 0) {
+            simConfig.console = strcmp(value, "-") == 0 ? stdout : fopen(value, "wb");
+            if (!simConfig.console) {
+                fprintf(stderr, "[Sim] [ERROR] Cannot open %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(option, "--fs") == 0) {
+            fsDir = value;
+        } else if (strcmp(option, "--command") == 0) {
+            const char* text = strchr(value, ':');
+            if (!text) {
+                usage(argv[0]);
+                return 2;
+            }
+            simScheduleCommand((uint64_t)(atof(value) * 1000.0), text + 1);
+        } else if (strcmp(option, "--button") == 0) {
+            simScheduleButton((uint64_t)(atof(value) * 1000.0));
+        } else if (strcmp(option, "--downlink") == 0) {
+            if (!queueDownlink(value)) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(option, "--ttff") == 0) {
+            simConfig.ttffMs = (uint32_t)(atof(value) * 1000.0);
+        } else if (strcmp(option, "--hot-start") == 0) {
+            simConfig.hotStartMs = (uint32_t)(atof(value) * 1000.0);
+        } else if (strcmp(option, "--outage-every") == 0) {
+            simConfig.outageEveryMs = (uint32_t)(atof(value) * 1000.0);
+        } else if (strcmp(option, "--outage-length") == 0) {
+            simConfig.outageLengthMs = (uint32_t)(atof(value) * 1000.0);
+        } else if (strcmp(option, "--report-every") == 0) {
+            reportEverySeconds = (uint32_t)atoi(value);
+        } else if (strcmp(option, "--sub-band") == 0) {
+            simConfig.networkSubBand = (uint8_t)atoi(value);
+        } else if (strcmp(option, "--pm") == 0) {
+            if (strcmp(value, "full") == 0) {
+                simConfig.pmSupport = SIM_PM_FULL;
+            } else if (strcmp(value, "dfs") == 0) {
+                simConfig.pmSupport = SIM_PM_DFS;
+            } else if (strcmp(value, "none") == 0) {
+                simConfig.pmSupport = SIM_PM_NONE;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (simConfig.dataRate > 4 || simConfig.networkSubBand < 1 || simConfig.networkSubBand > 8 || hours <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char tempDir[] = "/tmp/tracker-sim-XXXXXX";
+    if (fsDir) {
+        mkdir(fsDir, 0755);
+        simSetFsRoot(fsDir);
+    } else if (mkdtemp(tempDir)) {
+        simSetFsRoot(tempDir);
+    } else {
+        fprintf(stderr, "[Sim] [ERROR] Cannot create a LittleFS directory\n");
+        return 1;
+    }
+
+    simSeed(simConfig.seed);
+    simHeapBaseline();
+    fprintf(stderr, "[Sim] Running %.2f virtual hours, seed %u, DR%u, LittleFS in %s\n", hours, simConfig.seed,
+            simConfig.dataRate, simFsRoot());
+
+    uint64_t endMs = (uint64_t)(hours * 3600000.0);
+    auto realStart = std::chrono::steady_clock::now();
+    bootFirmware(endMs);
+    uint32_t heapStart = ESP.getFreeHeap();
+    uint32_t heapWarm = heapStart;
+    uint64_t heapWarmMs = simNowMs();
+
+    uint64_t reportEveryMs = (uint64_t)reportEverySeconds * 1000;
+    uint64_t nextReportMs = reportEveryMs;
+    uint64_t passes = 0;
+    while (simNowMs() < endMs) {
+        // A pass that ends in a reboot is counted up to the reboot, not setup()
+        uint32_t allocationsBefore = allocAuditSnapshot().allocations;
+        bool reboot = false;
+        try {
+            loop();
+        } catch (const SimReboot&) {
+            reboot = true;
+        }
+        uint32_t passAllocations = allocAuditSnapshot().allocations - allocationsBefore;
+        if (passes >= SIM_ALLOC_WARMUP_PASSES && passAllocations > 0) {
+            allocStats.allocatingPasses++;
+            allocStats.allocations += passAllocations;
+            if (passAllocations > allocStats.worstPass) allocStats.worstPass = passAllocations;
+        }
+        if (reboot) bootFirmware(endMs);
+        passes++;
+        if (heapWarmMs < SIM_HEAP_WARMUP_MS && simNowMs() >= SIM_HEAP_WARMUP_MS) {
+            heapWarm = ESP.getFreeHeap();
+            heapWarmMs = simNowMs();
+        }
+        if (reportEveryMs && simNowMs() >= nextReportMs) {
+            fprintf(stderr, "[Sim] %6.2f h: %u uplinks, %u GNSS fixes, %llu GNSS bytes dropped, heap %u, NVS %llu entries\n",
+                    simNowMs() / 3600000.0, simRadioStats.uplinks, simGpsStats.epochsWithFix,
+                    (unsigned long long)simGpsStats.bytesDropped, ESP.getFreeHeap(),
+                    (unsigned long long)simNvsStats.totalEntries());
+            nextReportMs += reportEveryMs;
+        }
+    }
+    double realSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+    simBootFinish();
+
+    printReport(simNowMs(), realSeconds, passes, heapStart, heapWarmMs, heapWarm, ESP.getFreeHeap());
+    if (showDisplay) {
+        fprintf(stderr, "[Sim] Display:\n");
+        for (const std::string& row : simDisplayText()) fprintf(stderr, "[Sim]   |%s\n", row.c_str());
+    }
+
+    // Handler destructors still log at exit; their lines are dropped
+    if (simConfig.console && simConfig.console != stdout) fclose(simConfig.console);
+    simConfig.console = nullptr;
+    if (!fsDir) nftw(tempDir, removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+    if (checkBoot && simBootStats.violations) return 4;
+    if (checkJoin && simRadioStats.joinsOffBandLater) {
+        fprintf(stderr, "[Sim] [FAIL] %u join requests off the network's sub-band after the first accept\n",
+                simRadioStats.joinsOffBandLater);
+        return 5;
+    }
+    if (checkFix && simRadioStats.positionsStale) {
+        fprintf(stderr, "[Sim] [FAIL] %u status uplinks sent a position as live after the fix was lost\n",
+                simRadioStats.positionsStale);
+        return 6;
+    }
+    if (checkAllocs && allocStats.allocatingPasses) {
+        fprintf(stderr, "[Sim] [FAIL] %u loop passes allocated from the heap after the warm-up\n",
+                allocStats.allocatingPasses);
+        return 7;
+    }
+    return 0;
+}
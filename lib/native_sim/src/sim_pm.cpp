@@ -0,0 +1,358 @@
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "sim_world.h"
+#include "Config.h"
+#include <string>
+#include <vector>
+
+// Power management and esp_timer behind esp_pm.h, esp_timer.h and
+// driver/gpio.h. The clock the CPU runs at is accounted per span of
+// virtual time (residency) and in cycles for ESP.getCycleCount(). Light
+// sleep is taken by simIdleUs() only: the firmware's delay() is where the
+// idle task would run.
+
+#define SIM_DEFAULT_CPU_MHZ         240
+#define SIM_LIGHT_SLEEP_MIN_US      3000    // Shorter idle is not worth the entry and exit
+#define SIM_LIGHT_SLEEP_AWAKE_US    2000    // After a wake, until the idle task can sleep again
+
+// ESP32-S3 draw with the CPU mostly waiting (datasheet typicals), and in light sleep
+static const float CPU_MA[SIM_CPU_FREQ_COUNT] = {22.0f, 27.0f, 32.0f};
+#define SIM_LIGHT_SLEEP_MA          0.3f
+
+struct SimPmLock {
+    esp_pm_lock_type_t type;
+    std::string name;
+    int count;
+};
+
+struct SimTimer {
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t dueUs;
+    bool armed;
+};
+
+static bool configured = false;
+static esp_pm_config_esp32s3_t config;
+static uint32_t manualMhz = SIM_DEFAULT_CPU_MHZ;
+static std::vector<SimPmLock*> locks;
+static std::vector<SimTimer*> timers;
+static std::vector<int> wakePins;
+static bool gpioWake = false;
+static uint64_t accountedUs = 0;
+static uint64_t cycles = 0;
+static int callbackDepth = 0;
+
+static bool held(esp_pm_lock_type_t type) {
+    for (const SimPmLock* lock : locks) {
+        if (lock->type == type && lock->count > 0) return true;
+    }
+    return false;
+}
+
+static bool anyLockHeld() {
+    for (const SimPmLock* lock : locks) {
+        if (lock->count > 0) return true;
+    }
+    return false;
+}
+
+static uint32_t currentMhz() {
+    if (!configured) return manualMhz;
+    if (held(ESP_PM_CPU_FREQ_MAX)) return config.max_freq_mhz;
+    if (held(ESP_PM_APB_FREQ_MAX)) return config.min_freq_mhz > 80 ? config.min_freq_mhz : 80;
+    return config.min_freq_mhz;
+}
+
+static int frequencyIndex(uint32_t mhz) {
+    if (mhz > 160) return 2;
+    if (mhz > 80) return 1;
+    return 0;
+}
+
+// Charges the time since the last change to the clock running now
+static void account() {
+    uint64_t now = simNowUs();
+    if (now <= accountedUs) return;
+    uint32_t mhz = currentMhz();
+    simPowerStats.cpuUs[frequencyIndex(mhz)] += now - accountedUs;
+    cycles += (now - accountedUs) * mhz;
+    accountedUs = now;
+}
+
+// A clock change: settle the old clock first, count it if it moved
+template <typename Change>
+static void changeClock(Change change) {
+    account();
+    uint32_t before = currentMhz();
+    change();
+    if (currentMhz() != before) simPowerStats.frequencySwitches++;
+}
+
+void simPmReset() {
+    account();
+    configured = false;
+    manualMhz = SIM_DEFAULT_CPU_MHZ;
+    for (SimPmLock* lock : locks) delete lock;
+    locks.clear();
+    for (SimTimer* timer : timers) delete timer;
+    timers.clear();
+    wakePins.clear();
+    gpioWake = false;
+}
+
+void simPmResume() {
+    accountedUs = simNowUs();
+}
+
+uint32_t simCpuFrequencyMhz() {
+    return currentMhz();
+}
+
+bool simSetCpuFrequencyMhz(uint32_t mhz) {
+    if (mhz != 240 && mhz != 160 && mhz != 80 && mhz != 40 && mhz != 20 && mhz != 10) return false;
+    changeClock([&] { manualMhz = mhz; });
+    return true;
+}
+
+uint32_t simCpuCycles() {
+    account();
+    return (uint32_t)cycles;
+}
+
+float simCpuCurrentMa() {
+    account();
+    double chargeMaUs = simPowerStats.lightSleepUs * (double)SIM_LIGHT_SLEEP_MA;
+    uint64_t totalUs = simPowerStats.lightSleepUs;
+    for (int i = 0; i < SIM_CPU_FREQ_COUNT; i++) {
+        chargeMaUs += simPowerStats.cpuUs[i] * (double)CPU_MA[i];
+        totalUs += simPowerStats.cpuUs[i];
+    }
+    return totalUs ? (float)(chargeMaUs / totalUs) : 0.0f;
+}
+
+// ---------------------------------------------------------------------------
+// esp_pm
+
+esp_err_t esp_pm_configure(const void* vconfig) {
+    if (simConfig.pmSupport == SIM_PM_NONE) return ESP_ERR_NOT_SUPPORTED;
+    const esp_pm_config_esp32s3_t* requested = (const esp_pm_config_esp32s3_t*)vconfig;
+    if (!requested) return ESP_ERR_INVALID_ARG;
+    if (requested->light_sleep_enable && simConfig.pmSupport != SIM_PM_FULL) return ESP_ERR_NOT_SUPPORTED;
+    bool valid = true;
+    for (int mhz : {requested->max_freq_mhz, requested->min_freq_mhz}) {
+        if (mhz != 240 && mhz != 160 && mhz != 80 && mhz != 40) valid = false;
+    }
+    if (!valid || requested->min_freq_mhz > requested->max_freq_mhz) return ESP_ERR_INVALID_ARG;
+    changeClock([&] {
+        config = *requested;
+        configured = true;
+    });
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_get_configuration(void* vconfig) {
+    if (!vconfig) return ESP_ERR_INVALID_ARG;
+    esp_pm_config_esp32s3_t* out = (esp_pm_config_esp32s3_t*)vconfig;
+    if (configured) {
+        *out = config;
+    } else {
+        out->max_freq_mhz = (int)manualMhz;
+        out->min_freq_mhz = (int)manualMhz;
+        out->light_sleep_enable = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle) {
+    (void)arg;
+    if (simConfig.pmSupport == SIM_PM_NONE) return ESP_ERR_NOT_SUPPORTED;
+    if (!out_handle) return ESP_ERR_INVALID_ARG;
+    SimPmLock* lock = new SimPmLock();
+    lock->type = lock_type;
+    lock->name = name ? name : "";
+    lock->count = 0;
+    locks.push_back(lock);
+    *out_handle = lock;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    changeClock([&] { handle->count++; });
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->count == 0) return ESP_ERR_INVALID_STATE;
+    changeClock([&] { handle->count--; });
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->count > 0) return ESP_ERR_INVALID_STATE;
+    for (size_t i = 0; i < locks.size(); i++) {
+        if (locks[i] == handle) {
+            locks.erase(locks.begin() + i);
+            delete handle;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+// ---------------------------------------------------------------------------
+// esp_timer
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (!create_args || !create_args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    SimTimer* timer = new SimTimer();
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->dueUs = 0;
+    timer->armed = false;
+    timers.push_back(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->dueUs = simNowUs() + timeout_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (!timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    for (size_t i = 0; i < timers.size(); i++) {
+        if (timers[i] == timer) {
+            timers.erase(timers.begin() + i);
+            delete timer;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    return timer && timer->armed;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)simSinceBootUs();
+}
+
+uint64_t simTimerNextUs() {
+    uint64_t next = UINT64_MAX;
+    for (const SimTimer* timer : timers) {
+        if (timer->armed && timer->dueUs < next) next = timer->dueUs;
+    }
+    return next;
+}
+
+void simTimerFire(uint64_t nowUs) {
+    // Callbacks may arm, stop or delete timers; restart the scan after each
+    for (bool fired = true; fired;) {
+        fired = false;
+        for (SimTimer* timer : timers) {
+            if (!timer->armed || timer->dueUs > nowUs) continue;
+            timer->armed = false;
+            simPowerStats.timerWakes++;
+            callbackDepth++;
+            timer->callback(timer->arg);
+            callbackDepth--;
+            fired = true;
+            break;
+        }
+    }
+}
+
+bool simInTimerCallback() {
+    return callbackDepth > 0;
+}
+
+// ---------------------------------------------------------------------------
+// Light sleep
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (gpio_num < 0 || gpio_num >= SIM_PIN_COUNT) return ESP_ERR_INVALID_ARG;
+    if (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL) return ESP_ERR_INVALID_ARG;
+    gpio_wakeup_disable(gpio_num);
+    wakePins.push_back(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    for (size_t i = 0; i < wakePins.size(); i++) {
+        if (wakePins[i] == gpio_num) {
+            wakePins.erase(wakePins.begin() + i);
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    gpioWake = true;
+    return ESP_OK;
+}
+
+static bool gnssRxWake() {
+    if (!gpioWake) return false;
+    for (int pin : wakePins) {
+        if (pin == GPS_RX_PIN) return true;
+    }
+    return false;
+}
+
+void simIdleUs(uint64_t us) {
+    uint64_t endUs = simNowUs() + us;
+    while (simNowUs() < endUs) {
+        uint64_t now = simNowUs();
+        if (!configured || !config.light_sleep_enable || anyLockHeld()) {
+            // Awake; a timer callback taking a lock keeps it that way
+            simAdvanceUs(endUs - now);
+            return;
+        }
+
+        bool gnssWake = gnssRxWake();
+        uint64_t wakeUs = endUs;
+        uint64_t timerUs = simTimerNextUs();
+        if (timerUs < wakeUs) wakeUs = timerUs;
+        uint64_t byteUs = gnssWake ? simGnssNextByteUs() : UINT64_MAX;
+        if (byteUs < wakeUs) wakeUs = byteUs;
+
+        if (wakeUs < now + SIM_LIGHT_SLEEP_MIN_US) {
+            uint64_t untilUs = wakeUs > now + SIM_LIGHT_SLEEP_AWAKE_US ? wakeUs : now + SIM_LIGHT_SLEEP_AWAKE_US;
+            simAdvanceUs((untilUs < endUs ? untilUs : endUs) - now);
+            continue;
+        }
+
+        // The UART is clocked down with the rest: what arrives meanwhile is
+        // lost, the start bit that wakes the chip included
+        account();
+        accountedUs = wakeUs;       // Asleep is not awake time at any clock
+        simGnssSetAsleep(true);
+        simAdvanceUs(wakeUs - now);
+        simGnssSetAsleep(false);
+        simPowerStats.lightSleepUs += wakeUs - now;
+        simPowerStats.lightSleeps++;
+        if (wakeUs == byteUs) simPowerStats.gnssWakes++;
+
+        uint64_t awakeUs = simNowUs() + SIM_LIGHT_SLEEP_AWAKE_US;
+        simAdvanceUs((awakeUs < endUs ? awakeUs : endUs) - simNowUs());
+    }
+}
@@ -0,0 +1,541 @@
+#include "sim_world.h"
+#include "Arduino.h"
+#include "Config.h"
+#include "esp_sleep.h"
+#include <malloc.h>
+#include <math.h>
+#include <random>
+
+// Log-distance path loss fitted to suburban LoRa drives (the same model
+// tools/gateway_locate fits per gateway)
+#define SIM_PATH_LOSS_1KM_DB        128.0
+#define SIM_PATH_LOSS_EXPONENT      2.9
+#define SIM_SHADOWING_SIGMA_DB      4.0
+#define SIM_NOISE_FIGURE_DB         6.0
+#define SIM_GATEWAY_TX_DBM          27.0
+#define SIM_ANTENNA_GAINS_DB        3.0     // Gateway antenna; the tracker's own is taken as 0 dBi
+#define SIM_BUTTON_HOLD_MS          200
+#define SIM_METERS_PER_DEGREE       111320.0
+#define SIM_BATTERY_DIVIDER         2.0f
+#define SIM_AWAKE_MA                45.0f   // CPU running, radio in standby, regulators
+#define SIM_GNSS_MA                 30.0f
+#define SIM_BACKLIGHT_MA            15.0f
+
+SimConfig::SimConfig() :
+    seed(1),
+    startUnixMs(1748764800000LL),           // 2025-06-01 08:00:00 UTC
+    dataRate(3),
+    txPowerDbm(20.0f),
+    networkSubBand(2),
+    gatewayLat(30.2672),
+    gatewayLon(-97.7431),
+    routeCenterLat(30.2852),
+    routeCenterLon(-97.7431),
+    routeRadiusM(4000.0),
+    speedMps(12.0),
+    ttffMs(45000),
+    hotStartMs(5000),
+    outageEveryMs(3600000),
+    outageLengthMs(120000),
+    batteryStartMv(4150.0f),
+    batteryDrainMvPerHour(20.0f),
+    batteryResistanceMohm(250.0f),
+    pmSupport(SIM_PM_FULL),
+    usbHost(true),
+    console(nullptr) {
+}
+
+SimConfig simConfig;
+SimRadioStats simRadioStats;
+SimGpsStats simGpsStats;
+SimConsoleStats simConsoleStats;
+SimDisplayStats simDisplayStats;
+SimFsStats simFsStats;
+SimNvsStats simNvsStats;
+SimSleepStats simSleepStats;
+SimBootStats simBootStats;
+SimAdcStats simAdcStats;
+SimPowerStats simPowerStats;
+
+uint64_t SimNvsStats::totalEntries() const {
+    uint64_t total = 0;
+    for (const auto& key : keys) total += key.second.entries;
+    return total;
+}
+
+// ---------------------------------------------------------------------------
+// Virtual clock and random numbers
+
+static uint64_t nowUs = 0;
+static uint64_t bootUs = 0;
+static std::mt19937_64 rng(1);
+
+uint64_t simNowUs() {
+    return nowUs;
+}
+
+uint64_t simNowMs() {
+    return nowUs / 1000;
+}
+
+void simAdvanceUs(uint64_t us) {
+    uint64_t endUs = nowUs + us;
+    for (uint64_t dueUs = simTimerNextUs(); dueUs <= endUs; dueUs = simTimerNextUs()) {
+        if (dueUs > nowUs) nowUs = dueUs;
+        simTimerFire(nowUs);
+    }
+    nowUs = endUs;
+}
+
+uint64_t simSinceBootUs() {
+    return nowUs - bootUs;
+}
+
+void simSeed(uint32_t seed) {
+    rng.seed(seed);
+}
+
+uint32_t simRandom() {
+    return (uint32_t)rng();
+}
+
+double simUniform() {
+    return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double simGaussian(double sigma) {
+    std::normal_distribution<double> normal(0.0, sigma);
+    return normal(rng);
+}
+
+// ---------------------------------------------------------------------------
+// GPIO
+
+struct SimPin {
+    uint8_t level;
+    bool output;
+    uint64_t highSinceUs;
+    uint64_t highUs;
+    float duty;                 // Of a HIGH output: 1, or the PWM duty
+    double dutyUs;              // HIGH time weighed by duty, before dutySinceUs
+    uint64_t dutySinceUs;
+    void (*handler)();
+    int interruptMode;
+};
+
+static SimPin pins[SIM_PIN_COUNT];
+
+static void settleDuty(SimPin& state) {
+    if (state.output && state.level) state.dutyUs += state.duty * (double)(nowUs - state.dutySinceUs);
+    state.dutySinceUs = nowUs;
+}
+
+void simSetPin(uint8_t pin, uint8_t level) {
+    simSetPwm(pin, level ? 1.0f : 0.0f);
+}
+
+void simSetPwm(uint8_t pin, float duty) {
+    if (pin >= SIM_PIN_COUNT) return;
+    SimPin& state = pins[pin];
+    uint8_t level = duty > 0.0f ? 1 : 0;
+    settleDuty(state);
+    if (state.output && state.level && !level) state.highUs += nowUs - state.highSinceUs;
+    if ((!state.output || !state.level) && level) state.highSinceUs = nowUs;
+    state.output = true;
+    if (pin == GPS_PWR_PIN && !state.level && level) simBootEvent(SIM_BOOT_GNSS_POWER);
+    state.level = level;
+    state.duty = duty;
+}
+
+void simSetInput(uint8_t pin, uint8_t level) {
+    if (pin >= SIM_PIN_COUNT) return;
+    SimPin& state = pins[pin];
+    if (state.output) simSetPin(pin, 0);
+    uint8_t previous = state.level;
+    state.output = false;
+    state.level = level ? 1 : 0;
+    if (state.handler && previous != state.level) {
+        bool rising = state.level != 0;
+        if (state.interruptMode == CHANGE || (rising ? state.interruptMode == RISING : state.interruptMode == FALLING)) {
+            state.handler();
+        }
+    }
+}
+
+void simAttachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+    if (pin >= SIM_PIN_COUNT) return;
+    pins[pin].handler = handler;
+    pins[pin].interruptMode = mode;
+}
+
+uint8_t simGetPin(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pins[pin].level : 0;
+}
+
+uint64_t simPinHighMs(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return 0;
+    const SimPin& state = pins[pin];
+    uint64_t us = state.highUs;
+    if (state.output && state.level) us += nowUs - state.highSinceUs;
+    return us / 1000;
+}
+
+uint64_t simPinDutyMs(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return 0;
+    const SimPin& state = pins[pin];
+    double us = state.dutyUs;
+    if (state.output && state.level) us += state.duty * (double)(nowUs - state.dutySinceUs);
+    return (uint64_t)(us / 1000.0);
+}
+
+uint64_t simPinHighSinceUs(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pins[pin].highSinceUs : 0;
+}
+
+float simBatteryMv() {
+    float mv = simConfig.batteryStartMv - simConfig.batteryDrainMvPerHour * (float)(nowUs / 3600e6);
+    return mv > 0.0f ? mv : 0.0f;
+}
+
+float simBatteryLoadMa() {
+    float ma = SIM_AWAKE_MA;
+    if (simGetPin(GPS_PWR_PIN)) ma += SIM_GNSS_MA;
+    if (simGetPin(TFT_BLK)) ma += SIM_BACKLIGHT_MA * pins[TFT_BLK].duty;
+    return ma;
+}
+
+float simBatteryTerminalMv() {
+    float mv = simBatteryMv() - simBatteryLoadMa() * simConfig.batteryResistanceMohm / 1000.0f;
+    return mv > 0.0f ? mv : 0.0f;
+}
+
+float simAnalogPinMv(uint8_t pin) {
+    return pin == BATTERY_PIN ? simBatteryTerminalMv() / SIM_BATTERY_DIVIDER : 0.0f;
+}
+
+// ---------------------------------------------------------------------------
+// Route and radio link
+
+SimPosition simPosition(uint64_t ms) {
+    SimPosition position;
+    double travelled = simConfig.speedMps * ms / 1000.0;
+    double angle = travelled / simConfig.routeRadiusM;
+    double north = simConfig.routeRadiusM * cos(angle);
+    double east = simConfig.routeRadiusM * sin(angle);
+    double cosLat = cos(simConfig.routeCenterLat * M_PI / 180.0);
+
+    position.latitude = simConfig.routeCenterLat + north / SIM_METERS_PER_DEGREE;
+    position.longitude = simConfig.routeCenterLon + east / (SIM_METERS_PER_DEGREE * cosLat);
+    position.altitudeM = 150.0 + 10.0 * sin(angle * 3.0);
+    position.speedMps = simConfig.speedMps;
+    double course = atan2(cos(angle), -sin(angle)) * 180.0 / M_PI;
+    position.courseDeg = course < 0 ? course + 360.0 : course;
+
+    bool outage = simConfig.outageEveryMs && ms >= simConfig.outageEveryMs &&
+                  ms % simConfig.outageEveryMs < simConfig.outageLengthMs;
+    position.fix = !outage;
+    position.satellites = outage ? 2 : 8 + (int)((ms / 60000) % 4);
+    position.hdop = outage ? 99.99f : 0.9f + 0.1f * (float)((ms / 30000) % 5);
+    return position;
+}
+
+double simGatewayDistanceM(const SimPosition& position) {
+    double cosLat = cos(simConfig.gatewayLat * M_PI / 180.0);
+    double north = (position.latitude - simConfig.gatewayLat) * SIM_METERS_PER_DEGREE;
+    double east = (position.longitude - simConfig.gatewayLon) * SIM_METERS_PER_DEGREE * cosLat;
+    return sqrt(north * north + east * east);
+}
+
+// Demodulation floor per spreading factor (SX126x datasheet)
+static double snrFloor(uint8_t spreadingFactor) {
+    return -7.5 - 2.5 * (spreadingFactor - 7);
+}
+
+static SimLink linkBudget(double txDbm, uint8_t spreadingFactor, uint32_t bandwidthHz) {
+    double distanceKm = simGatewayDistanceM(simPosition(simNowMs())) / 1000.0;
+    if (distanceKm < 0.05) distanceKm = 0.05;
+    double pathLoss = SIM_PATH_LOSS_1KM_DB + 10.0 * SIM_PATH_LOSS_EXPONENT * log10(distanceKm);
+    double noise = -174.0 + 10.0 * log10((double)bandwidthHz) + SIM_NOISE_FIGURE_DB;
+    double rssi = txDbm + SIM_ANTENNA_GAINS_DB - pathLoss + simGaussian(SIM_SHADOWING_SIGMA_DB);
+
+    SimLink link;
+    link.snr = (float)(rssi - noise);
+    // The radio reports the noise floor when the packet is below it
+    link.rssi = (float)(rssi > noise ? rssi : noise);
+    link.delivered = link.snr >= snrFloor(spreadingFactor);
+    return link;
+}
+
+// US915: DR0..DR3 are SF10..SF7 at 125 kHz, DR4 SF8 at 500 kHz; RX1
+// answers on DR10..DR13 (SF10..SF7 at 500 kHz)
+static void dataRateParameters(uint8_t dataRate, uint8_t& spreadingFactor, uint32_t& bandwidthHz) {
+    if (dataRate >= 4) {
+        spreadingFactor = 8;
+        bandwidthHz = 500000;
+    } else {
+        spreadingFactor = 10 - dataRate;
+        bandwidthHz = 125000;
+    }
+}
+
+SimLink simUplinkLink(uint8_t dataRate, float txPowerDbm) {
+    uint8_t spreadingFactor;
+    uint32_t bandwidthHz;
+    dataRateParameters(dataRate, spreadingFactor, bandwidthHz);
+    return linkBudget(txPowerDbm, spreadingFactor, bandwidthHz);
+}
+
+SimLink simDownlinkLink(uint8_t dataRate) {
+    uint8_t spreadingFactor = dataRate >= 4 ? 8 : 10 - dataRate;
+    return linkBudget(SIM_GATEWAY_TX_DBM, spreadingFactor, 500000);
+}
+
+// Semtech AN1200.13 time on air: explicit header, CRC, coding rate 4/5,
+// 8 symbol preamble, low data rate optimisation above 16 ms symbols
+uint32_t simLoRaAirtimeUs(uint8_t spreadingFactor, uint32_t bandwidthHz, size_t phyPayloadBytes) {
+    double symbolUs = (double)(1UL << spreadingFactor) * 1e6 / bandwidthHz;
+    int lowDataRate = symbolUs > 16000.0 ? 1 : 0;
+    double numerator = 8.0 * phyPayloadBytes - 4.0 * spreadingFactor + 28 + 16;
+    double payloadSymbols = 8 + fmax(ceil(numerator / (4.0 * (spreadingFactor - 2 * lowDataRate))) * 5, 0.0);
+    return (uint32_t)((8 + 4.25 + payloadSymbols) * symbolUs);
+}
+
+// ---------------------------------------------------------------------------
+// Scheduled console input and button presses
+
+struct SimEvent {
+    uint64_t atMs;
+    std::string text;       // Empty for a button press
+};
+
+static std::vector<SimEvent> events;
+static size_t nextEvent = 0;
+static uint64_t buttonReleaseMs = 0;
+static std::string consoleInput;
+static size_t consoleInputPosition = 0;
+
+static void insertEvent(const SimEvent& event) {
+    auto position = events.begin() + nextEvent;
+    while (position != events.end() && position->atMs <= event.atMs) ++position;
+    events.insert(position, event);
+}
+
+void simScheduleCommand(uint64_t atMs, const char* text) {
+    SimEvent event;
+    event.atMs = atMs;
+    event.text = text;
+    event.text += "\n";
+    insertEvent(event);
+}
+
+void simScheduleButton(uint64_t atMs) {
+    SimEvent event;
+    event.atMs = atMs;
+    insertEvent(event);
+}
+
+struct SimDownlink {
+    uint64_t atMs;
+    uint8_t port;
+    std::vector<uint8_t> data;
+};
+
+static std::vector<SimDownlink> downlinks;
+
+void simQueueDownlink(uint64_t atMs, uint8_t port, const std::vector<uint8_t>& data) {
+    SimDownlink downlink = {atMs, port, data};
+    auto at = downlinks.begin();
+    while (at != downlinks.end() && at->atMs <= atMs) ++at;
+    downlinks.insert(at, downlink);
+    simRadioStats.downlinksQueued++;
+}
+
+bool simTakeDownlink(uint8_t& port, std::vector<uint8_t>& data) {
+    if (downlinks.empty() || downlinks.front().atMs > simNowMs()) return false;
+    port = downlinks.front().port;
+    data = downlinks.front().data;
+    downlinks.erase(downlinks.begin());
+    return true;
+}
+
+void simPollEvents() {
+    uint64_t ms = simNowMs();
+    if (buttonReleaseMs && ms >= buttonReleaseMs) {
+        simSetInput(USER_BUTTON_PIN, 1);
+        buttonReleaseMs = 0;
+    }
+    while (nextEvent < events.size() && events[nextEvent].atMs <= ms) {
+        const SimEvent& event = events[nextEvent++];
+        if (event.text.empty()) {
+            simSetInput(USER_BUTTON_PIN, 0);
+            buttonReleaseMs = ms + SIM_BUTTON_HOLD_MS;
+        } else {
+            consoleInput.append(event.text);
+            simConsoleStats.commandBytes += event.text.size();
+        }
+    }
+}
+
+int simConsoleAvailable() {
+    simPollEvents();
+    return (int)(consoleInput.size() - consoleInputPosition);
+}
+
+int simConsoleRead() {
+    if (simConsoleAvailable() <= 0) return -1;
+    uint8_t c = consoleInput[consoleInputPosition++];
+    if (consoleInputPosition == consoleInput.size()) {
+        consoleInput.clear();
+        consoleInputPosition = 0;
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// Heap
+
+static size_t heapBaseline = 0;
+static uint32_t minFreeHeap = SIM_HEAP_TOTAL;
+
+void simHeapBaseline() {
+    heapBaseline = mallinfo2().uordblks;
+    minFreeHeap = SIM_HEAP_TOTAL;
+}
+
+uint32_t simFreeHeap() {
+    size_t allocated = mallinfo2().uordblks;
+    size_t used = allocated > heapBaseline ? allocated - heapBaseline : 0;
+    uint32_t free = used < SIM_HEAP_TOTAL ? (uint32_t)(SIM_HEAP_TOTAL - used) : 0;
+    if (free < minFreeHeap) minFreeHeap = free;
+    return free;
+}
+
+uint32_t simMinFreeHeap() {
+    simFreeHeap();
+    return minFreeHeap;
+}
+
+// ---------------------------------------------------------------------------
+// NVS and flash
+
+std::map<std::string, SimNvsNamespace>& simNvsStore() {
+    static std::map<std::string, SimNvsNamespace> store;
+    return store;
+}
+
+static std::string fsRoot = ".";
+
+void simSetFsRoot(const char* path) {
+    fsRoot = path;
+}
+
+const char* simFsRoot() {
+    return fsRoot.c_str();
+}
+
+// ---------------------------------------------------------------------------
+// Deep sleep
+
+// Pins the firmware drove float in deep sleep (nothing is held), which
+// powers down VEXT, the display and the GNSS receiver with them
+static void releasePins() {
+    for (uint8_t pin = 0; pin < SIM_PIN_COUNT; pin++) {
+        pins[pin].handler = nullptr;
+        if (pins[pin].output) simSetInput(pin, 0);
+    }
+    simSetInput(USER_BUTTON_PIN, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Boot order
+
+static const struct {
+    SimBootEvent first;
+    SimBootEvent then;
+    const char* rule;
+} BOOT_ORDER[] = {
+    {SIM_BOOT_GNSS_POWER, SIM_BOOT_RADIO, "GNSS power before the radio"},
+    {SIM_BOOT_GNSS_POWER, SIM_BOOT_DISPLAY, "GNSS power before the display"},
+    {SIM_BOOT_RADIO, SIM_BOOT_DISPLAY, "radio before the display"},
+    {SIM_BOOT_SETUP_DONE, SIM_BOOT_DISPLAY, "display after setup() returned"},
+};
+
+static uint64_t bootEventUs[SIM_BOOT_EVENT_COUNT];
+static bool bootEventsReset = false;
+
+static void resetBootEvents() {
+    for (int i = 0; i < SIM_BOOT_EVENT_COUNT; i++) bootEventUs[i] = SIM_BOOT_NOT_REACHED;
+    bootEventsReset = true;
+}
+
+void simBootEvent(SimBootEvent event) {
+    if (!bootEventsReset) resetBootEvents();
+    if (bootEventUs[event] == SIM_BOOT_NOT_REACHED) bootEventUs[event] = nowUs - bootUs;
+}
+
+// A rule is broken when its second event happened without the first, or before it
+void simBootFinish() {
+    if (!bootEventsReset) resetBootEvents();
+    for (const auto& order : BOOT_ORDER) {
+        uint64_t then = bootEventUs[order.then];
+        if (then == SIM_BOOT_NOT_REACHED || bootEventUs[order.first] <= then) continue;
+        simBootStats.violations++;
+        fprintf(stderr, "[Sim] [ERROR] Boot %u at %llu ms broke the boot order: %s\n", simBootStats.boots + 1,
+                (unsigned long long)(bootUs / 1000), order.rule);
+    }
+    if (simBootStats.boots == 0) {
+        for (int i = 0; i < SIM_BOOT_EVENT_COUNT; i++) simBootStats.powerOnUs[i] = bootEventUs[i];
+    }
+    simBootStats.boots++;
+    resetBootEvents();
+}
+
+void simRestart() {
+    simBootFinish();
+    releasePins();
+    simAdcReset();
+    simPmReset();
+    simSleepStats.restarts++;
+    bootUs = nowUs;
+}
+
+int simDeepSleep(uint64_t timerUs, bool buttonWake) {
+    simBootFinish();
+    releasePins();
+    simAdcReset();
+    simPmReset();
+
+    uint64_t wakeUs = timerUs ? nowUs + timerUs : UINT64_MAX;
+    bool button = false;
+    if (buttonWake) {
+        for (size_t i = nextEvent; i < events.size(); i++) {
+            if (!events[i].text.empty() || events[i].atMs * 1000 <= nowUs) continue;
+            if (events[i].atMs * 1000 < wakeUs) {
+                wakeUs = events[i].atMs * 1000;
+                button = true;
+            }
+            break;
+        }
+    }
+    if (wakeUs == UINT64_MAX) {
+        fprintf(stderr, "[Sim] [ERROR] Deep sleep without a wake source at %llu ms\n", (unsigned long long)simNowMs());
+        exit(3);
+    }
+
+    simSleepStats.sleeps++;
+    simSleepStats.sleepUs += wakeUs - nowUs;
+    nowUs = wakeUs;
+    bootUs = nowUs;
+    simPmResume();
+    // Commands typed meanwhile are waiting on wake; the press that woke the
+    // chip is over by the time the firmware looks
+    simPollEvents();
+    buttonReleaseMs = 0;
+    simSetInput(USER_BUTTON_PIN, 1);
+    if (button) {
+        simSleepStats.buttonWakes++;
+        return ESP_SLEEP_WAKEUP_EXT0;
+    }
+    simSleepStats.timerWakes++;
+    return ESP_SLEEP_WAKEUP_TIMER;
+}
@@ -0,0 +1,332 @@
+#ifndef SIM_WORLD_H
+#define SIM_WORLD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Simulated world behind the Arduino/ESP shims of the native env. Time is
+// virtual: delay() and blocking peripheral operations (radio airtime, RX
+// windows, join accept delays) advance it instantly, so a day of firmware
+// behavior replays in seconds. Everything random draws from one seeded
+// generator, so a run is reproducible from its seed.
+
+#define SIM_HEAP_TOTAL              327680  // Internal DRAM left to the application on the ESP32-S3
+#define SIM_UART_RX_BUFFER          256     // HardwareSerial default RX ring
+#define SIM_CONSOLE_TX_BUFFER       4096    // USB CDC transmit space seen by availableForWrite()
+#define SIM_PIN_COUNT               49      // GPIO0..48
+#define SIM_NVS_PAGES               5       // 0x5000 nvs partition in the default table
+#define SIM_NVS_ENTRIES_PER_PAGE    126
+#define SIM_FLASH_ENDURANCE         100000  // Erase cycles per sector
+#define SIM_CPU_FREQ_COUNT          3       // 80, 160, 240 MHz; slower clocks count as 80
+
+// What the firmware's ESP-IDF build supports (esp_pm.h)
+enum SimPmSupport {
+    SIM_PM_FULL = 0,            // Frequency scaling and automatic light sleep
+    SIM_PM_DFS,                 // Frequency scaling only: no tickless idle, as the stock Arduino core
+    SIM_PM_NONE                 // No CONFIG_PM_ENABLE
+};
+
+struct SimConfig {
+    uint32_t seed;
+    int64_t startUnixMs;        // UTC at power-on
+    uint8_t dataRate;           // US915 uplink DR0..DR4
+    float txPowerDbm;
+    uint8_t networkSubBand;     // US915 sub-band 1..8 the gateways listen on
+    double gatewayLat;
+    double gatewayLon;
+    double routeCenterLat;      // Vehicle drives a circle around this point
+    double routeCenterLon;
+    double routeRadiusM;
+    double speedMps;
+    uint32_t ttffMs;            // Power-on to first fix
+    uint32_t hotStartMs;        // Power-on to fix when the receiver had one recently
+    uint32_t outageEveryMs;     // Fix lost periodically (tunnels, garages), 0 = never
+    uint32_t outageLengthMs;
+    float batteryStartMv;
+    float batteryDrainMvPerHour;
+    float batteryResistanceMohm;    // Cell, protection and wiring: the terminal sags by load x this
+    SimPmSupport pmSupport;
+    bool usbHost;               // A host is attached to the USB console (Serial is true)
+    FILE* console;              // Console output, nullptr = count only
+
+    SimConfig();
+};
+
+// Uplink/downlink outcome of the path loss model
+struct SimLink {
+    float rssi;
+    float snr;
+    bool delivered;
+};
+
+struct SimPosition {
+    bool fix;
+    double latitude;
+    double longitude;
+    double altitudeM;
+    double speedMps;
+    double courseDeg;
+    int satellites;
+    float hdop;
+};
+
+struct SimRadioStats {
+    uint32_t joinRequests;
+    uint32_t joinAccepts;
+    uint32_t joinsOffBand;      // Requests on channels the gateways do not listen on
+    uint32_t joinsOffBandLater; // ... after the run's first accept (--check-join)
+    uint32_t uplinks;
+    uint32_t uplinksDelivered;  // Heard by the gateway, whether or not the device knows
+    uint32_t uplinksByDr[5];    // Per US915 DR0..DR4
+    uint32_t deliveredByDr[5];
+    uint32_t confirmedUplinks;
+    uint32_t acks;
+    uint32_t downlinksQueued;   // Application downlinks (--downlink)
+    uint32_t downlinksSent;     // ... sent by the network after an uplink it heard
+    uint32_t downlinksReceived; // ... and received by the device
+    uint32_t rejectedTooLong;
+    uint32_t uplinksReplayed;   // Heard with a frame counter the network had seen, dropped
+    uint32_t positionsLive;     // Status uplinks with a position not flagged estimated
+    uint32_t positionsEstimated;
+    uint32_t positionsStale;    // ... live by the flags, but sent after the receiver lost the fix
+    uint64_t payloadBytes;
+    uint64_t txAirtimeUs;
+    uint64_t rxWindowUs;
+};
+
+struct SimGpsStats {
+    uint64_t bytesSent;         // Receiver to UART
+    uint64_t bytesRead;         // UART to firmware
+    uint64_t bytesDropped;      // RX ring overflow while the loop was busy
+    uint64_t bytesLostAsleep;   // Arrived while the chip was in light sleep
+    uint32_t epochs;
+    uint32_t epochsWithFix;
+};
+
+struct SimConsoleStats {
+    uint64_t bytesWritten;
+    uint64_t lines;
+    uint64_t commandBytes;
+};
+
+struct SimDisplayStats {
+    uint32_t clears;            // fillScreen() calls, one per drawn frame
+    uint64_t pixels;            // Pixels pushed over SPI
+    uint32_t inits;             // initR()
+    uint32_t sleeps;            // Sleep in, controller state kept
+    uint32_t wakes;             // Sleep out
+    uint32_t framesLost;        // Drawn with the panel unpowered, or powered again since initR()
+};
+
+struct SimSleepStats {
+    uint32_t sleeps;
+    uint32_t timerWakes;
+    uint32_t buttonWakes;
+    uint64_t sleepUs;
+    uint32_t restarts;          // ESP.restart()
+};
+
+// Peripheral bring-up in each boot as the hardware sees it, checked
+// against the staged boot order: GNSS power first, then the radio, the
+// display last and only once setup() has returned
+enum SimBootEvent {
+    SIM_BOOT_GNSS_POWER = 0,
+    SIM_BOOT_RADIO,             // SX1262::begin()
+    SIM_BOOT_SETUP_DONE,        // setup() returned to the driver
+    SIM_BOOT_DISPLAY,           // Panel initR()
+    SIM_BOOT_FIRST_FIX,         // First epoch with a fix on the open UART
+    SIM_BOOT_FIRST_UPLINK,
+    SIM_BOOT_EVENT_COUNT
+};
+
+#define SIM_BOOT_NOT_REACHED    UINT64_MAX
+
+struct SimAdcStats {
+    uint64_t conversions;       // DMA conversions generated
+    uint64_t dropped;           // ... lost to a full ring
+    uint32_t oneshotReads;      // analogRead()/analogReadMilliVolts()
+    uint32_t timerReads;        // ... made from an esp_timer callback, off the loop
+};
+
+// Clock and light-sleep residency under esp_pm.h, over the awake time
+// between deep sleeps
+struct SimPowerStats {
+    uint64_t cpuUs[SIM_CPU_FREQ_COUNT];     // Awake at 80, 160, 240 MHz
+    uint64_t lightSleepUs;
+    uint32_t lightSleeps;
+    uint32_t gnssWakes;                     // Woken by the GNSS RX pin
+    uint32_t timerWakes;                    // esp_timer callbacks
+    uint32_t frequencySwitches;
+};
+
+struct SimBootStats {
+    uint32_t boots;                                 // Checked: ended by a reboot or the end of the run
+    uint32_t violations;                            // Order rules broken, summed over boots
+    uint64_t powerOnUs[SIM_BOOT_EVENT_COUNT];       // First boot, from the boot
+};
+
+struct SimFsStats {
+    uint64_t bytesWritten;
+    uint32_t opens;
+    uint32_t removes;
+};
+
+// NVS wear per namespace/key: puts the firmware made, and what NVS writes
+// (unchanged values are skipped by NVS, as on the device)
+struct SimNvsKeyStats {
+    uint32_t puts;
+    uint32_t writes;
+    uint64_t entries;           // 32-byte NVS entries written
+};
+
+struct SimNvsStats {
+    uint32_t commits;
+    std::map<std::pair<std::string, std::string>, SimNvsKeyStats> keys;    // By namespace, key
+    uint64_t totalEntries() const;
+};
+
+extern SimConfig simConfig;
+extern SimRadioStats simRadioStats;
+extern SimGpsStats simGpsStats;
+extern SimConsoleStats simConsoleStats;
+extern SimDisplayStats simDisplayStats;
+extern SimFsStats simFsStats;
+extern SimSleepStats simSleepStats;
+extern SimBootStats simBootStats;
+extern SimAdcStats simAdcStats;
+extern SimPowerStats simPowerStats;
+extern SimNvsStats simNvsStats;
+
+// Virtual clock. simAdvanceUs() runs esp_timer callbacks as their time
+// passes; simIdleUs() is the idle task: with automatic light sleep
+// configured and no power management lock held it sleeps the chip
+// through the span, waking for timers and the GNSS RX pin
+uint64_t simNowUs();
+uint64_t simNowMs();
+void simAdvanceUs(uint64_t us);
+void simIdleUs(uint64_t us);
+
+// Time since the firmware last booted (power-on, restart or deep-sleep wake), as micros() counts it
+uint64_t simSinceBootUs();
+
+// Thrown by esp_deep_sleep_start() once the clock has skipped to the wake,
+// and by ESP.restart(); the driver catches it and boots the firmware again
+// through setup()
+struct SimReboot {};
+
+// Software reset: outputs released, millis() from zero, no deep-sleep wake
+void simRestart();
+
+// Boot order: events keep their first time per boot; simBootFinish()
+// checks the boot that ended (reboots call it, the driver at the end)
+void simBootEvent(SimBootEvent event);
+void simBootFinish();
+
+// Deep sleep until the timer (0 = none) or, when `buttonWake`, the next
+// scheduled button press; returns the wake cause (esp_sleep.h values)
+int simDeepSleep(uint64_t timerUs, bool buttonWake);
+
+// Random numbers from the run's seed
+void simSeed(uint32_t seed);
+uint32_t simRandom();
+double simUniform();
+double simGaussian(double sigma);
+
+// GPIO levels, with time spent HIGH per pin for duty cycles. A PWM output
+// (LEDC) is HIGH while its duty is above zero; simPinDutyMs() weighs the
+// time by the duty.
+void simSetPin(uint8_t pin, uint8_t level);
+void simSetPwm(uint8_t pin, float duty);
+uint8_t simGetPin(uint8_t pin);
+void simSetInput(uint8_t pin, uint8_t level);       // External drive (buttons)
+uint64_t simPinHighMs(uint8_t pin);
+uint64_t simPinDutyMs(uint8_t pin);
+uint64_t simPinHighSinceUs(uint8_t pin);    // Virtual time of the last rising edge
+
+// Interrupt on an input's edges (Arduino RISING, FALLING, CHANGE), run
+// when the edge is driven; nullptr detaches
+void simAttachInterrupt(uint8_t pin, void (*handler)(), int mode);
+
+// Battery voltage at the cell (open circuit), and at the terminals under
+// the board's present load, which comes from the rails and loads switched on
+float simBatteryMv();
+float simBatteryLoadMa();
+float simBatteryTerminalMv();
+
+// Voltage an ADC sees on a pin: the battery behind the board's 2:1
+// divider on BATTERY_PIN, ground elsewhere
+float simAnalogPinMv(uint8_t pin);
+
+// Peripherals that a reset or deep sleep powers down (the DMA ADC)
+void simAdcReset();
+
+// Power management and esp_timer state: simPmReset() settles the
+// residency and drops the configuration, locks and timers (reset, deep
+// sleep); simPmResume() restarts the residency clock after a deep sleep
+void simPmReset();
+void simPmResume();
+uint32_t simCpuFrequencyMhz();
+bool simSetCpuFrequencyMhz(uint32_t mhz);
+uint32_t simCpuCycles();                // CCOUNT, at whatever the clock was
+uint64_t simTimerNextUs();              // UINT64_MAX when none is armed
+void simTimerFire(uint64_t nowUs);      // Callbacks of the timers due by nowUs
+bool simInTimerCallback();              // An esp_timer callback is running
+float simCpuCurrentMa();                // Mean SoC draw over the residency so far
+
+// Vehicle state from the route and outage schedule at a virtual time
+SimPosition simPosition(uint64_t ms);
+double simGatewayDistanceM(const SimPosition& position);
+
+// One frame through the path loss model at the current position;
+// downlink uses the gateway's transmit power and the 500 kHz RX1 channel
+SimLink simUplinkLink(uint8_t dataRate, float txPowerDbm);
+SimLink simDownlinkLink(uint8_t dataRate);
+uint32_t simLoRaAirtimeUs(uint8_t spreadingFactor, uint32_t bandwidthHz, size_t phyPayloadBytes);
+
+// Console lines typed at a virtual time
+void simScheduleCommand(uint64_t atMs, const char* text);
+// User button held LOW for a moment at a virtual time
+void simScheduleButton(uint64_t atMs);
+// Application downlink the network holds from a virtual time on and sends
+// after the next uplink it hears, whether or not the device receives it
+void simQueueDownlink(uint64_t atMs, uint8_t port, const std::vector<uint8_t>& data);
+bool simTakeDownlink(uint8_t& port, std::vector<uint8_t>& data);
+// Delivers due console input and button presses
+void simPollEvents();
+
+// Console input (UART 0) and the GNSS receiver's UART (UART 1)
+int simConsoleAvailable();
+int simConsoleRead();
+void simGnssBegin(unsigned long baud, size_t rxBufferSize);
+void simGnssEnd();
+void simGnssSetAsleep(bool asleep);     // Bytes arriving meanwhile are lost
+uint64_t simGnssNextByteUs();           // Start of the next byte on the wire, UINT64_MAX when silent
+uint64_t simGnssLastFixMs();            // Epoch of the last fix sent, 0 before any
+int simGnssAvailable();
+int simGnssPeek();
+int simGnssRead();
+
+// Free heap as the firmware sees it: SIM_HEAP_TOTAL less what was
+// allocated since simHeapBaseline()
+void simHeapBaseline();
+uint32_t simFreeHeap();
+uint32_t simMinFreeHeap();
+
+// In-memory NVS, by namespace then key
+typedef std::map<std::string, std::vector<uint8_t>> SimNvsNamespace;
+std::map<std::string, SimNvsNamespace>& simNvsStore();
+
+// Directory holding the LittleFS files (kept with --fs, so the sample log
+// opens in tools/archive_query after the run)
+void simSetFsRoot(const char* path);
+const char* simFsRoot();
+
+// Text the display currently shows, one row per 8 pixel line
+std::vector<std::string> simDisplayText();
+
+#endif // SIM_WORLD_H
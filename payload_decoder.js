@@ -4,25 +4,75 @@
  * This decoder handles multiple payload types:
  * - Port 1: Plain text messages (e.g., "Online!" join confirmation)
  * - Port 2: GPS data as JSON (latitude, longitude, altitude, satellites)
- * - Port 3: Status data as JSON (uptime, heap, rssi, snr)
+ * - Port 3: Status data as JSON (uptime, heap, rssi, snr), optionally followed by
+ *   a latency summary (p50/p99 per instrumented code path, see src/perf_stats.h)
+ *   and an energy estimate (see src/energy_ledger.h)
  * - Port 4: Gateway discovery data as JSON (GPS + signal strength when gateway detected)
+ * - Port 5: Data-rate survey (data rate, TX power, 24-bit latitude/longitude), see src/payload_codec.h
+ * - Port 6: Config acknowledgement (sequence, applied/rejected commands, revision), followed by
+ *   the port 3 layout when the data rate had room for both, see src/remote_config.h
+ * 
+ * encodeDownlink() builds the port 10 config commands, see src/remote_config.h
  * 
  * The decoder automatically detects JSON vs plain text payloads
  */
 
+// Signed 24-bit fraction of fullScale degrees
+function decodeCoordinate(bytes, offset, fullScale) {
+    let value = (bytes[offset] << 16) | (bytes[offset + 1] << 8) | bytes[offset + 2];
+    if (value & 0x800000) value -= 0x1000000;
+    return value * fullScale / 0x800000;
+}
+
 function decodeUplink(input) {
     try {
-        const bytes = input.bytes;
+        let bytes = input.bytes;
         const result = {};
         
+        // Config ack (4 bytes): bit (opcode - 1) per command applied or rejected, 0x80 = unreadable frame
+        if (input.fPort === 6) {
+            if (bytes.length < 4) {
+                throw new Error("Payload too short for the config ack");
+            }
+            result.config_sequence = bytes[0];
+            result.config_applied = bytes[1];
+            result.config_rejected = bytes[2];
+            result.config_malformed = (bytes[2] & 0x80) !== 0;
+            result.config_revision = bytes[3];
+            bytes = bytes.slice(4);
+            if (bytes.length === 0) {
+                return {
+                    data: result,
+                    warnings: [],
+                    errors: []
+                };
+            }
+        }
+        
+        if (input.fPort === 5) {
+            if (bytes.length < 8) {
+                throw new Error("Payload too short for the survey format");
+            }
+            result.survey_data_rate = bytes[0];
+            result.survey_tx_power_dbm = bytes[1] > 127 ? bytes[1] - 256 : bytes[1];
+            result.latitude = decodeCoordinate(bytes, 2, 90);
+            result.longitude = decodeCoordinate(bytes, 5, 180);
+            result.has_gps = true;
+            return {
+                data: result,
+                warnings: [],
+                errors: []
+            };
+        }
+        
         if (bytes.length < 11) {
             throw new Error("Payload too short for binary format");
         }
         
         let offset = 0;
         
-        // Uptime (4 bytes) - seconds as uint32
-        result.uptime_seconds = (bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3];
+        // Uptime (4 bytes) - seconds as uint32 (>>> 0 keeps values above 2^31 unsigned)
+        result.uptime_seconds = ((bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3]) >>> 0;
         offset += 4;
         
         // Free heap (2 bytes) - KB as uint16
@@ -69,6 +119,53 @@ function decodeUplink(input) {
             // Satellites (1 byte)
             result.satellites = bytes[offset];
             offset += 1;
+            
+            // Position quality (3 bytes, newer firmware only)
+            if (bytes.length >= offset + 3) {
+                // Flags (1 byte) - bit 0: dead-reckoned between fixes
+                result.position_estimated = (bytes[offset] & 0x01) !== 0;
+                offset += 1;
+                
+                // Accuracy (2 bytes) - uncertainty radius in metres as uint16
+                result.position_accuracy_m = (bytes[offset] << 8) | bytes[offset + 1];
+                offset += 2;
+                
+                // Bit 1: no position, the GPS block only pads the frame for the latency block
+                if ((bytes[offset - 3] & 0x02) !== 0) {
+                    delete result.latitude;
+                    delete result.longitude;
+                    delete result.altitude;
+                    delete result.satellites;
+                    delete result.position_estimated;
+                    delete result.position_accuracy_m;
+                }
+            }
+        }
+        
+        // Latency summary (1 + 2N bytes) after the full 27-byte position layout: probe count,
+        // then p50 and p99 codes per probe.
+        // Code c > 0 means 2^((c - 1) / 8) microseconds; 0 means no samples yet.
+        if (bytes.length > 27) {
+            const probes = ["gps_update", "display_update", "uplink", "join", "nvs_save", "battery_read", "loop"];
+            const decodeMs = function (code) {
+                return code === 0 ? null : Math.round(Math.pow(2, (code - 1) / 8)) / 1000;
+            };
+            let count = Math.min(bytes[offset], Math.floor((bytes.length - offset - 1) / 2), probes.length);
+            offset += 1;
+            result.latency_ms = {};
+            for (let i = 0; i < count; i++) {
+                result.latency_ms[probes[i]] = { p50: decodeMs(bytes[offset]), p99: decodeMs(bytes[offset + 1]) };
+                offset += 2;
+            }
+            
+            // Energy estimate (6 bytes): mean current in 0.01 mA (= mAh per hour),
+            // charge per uplink in uAh (0 before the first uplink), charge used in mAh
+            if (bytes.length >= offset + 6) {
+                result.energy_ma_mean = ((bytes[offset] << 8) | bytes[offset + 1]) / 100;
+                result.energy_mah_per_uplink = ((bytes[offset + 2] << 8) | bytes[offset + 3]) / 1000;
+                result.energy_mah_used = (bytes[offset + 4] << 8) | bytes[offset + 5];
+                offset += 6;
+            }
         }
         
         // Add some useful computed fields
@@ -88,4 +185,31 @@ function decodeUplink(input) {
             errors: ["Decode error: " + error.message]
         };
     }
-} 
\ No newline at end of file
+} 
+
+// Port 10 config command from named settings, applied in this order:
+// { sequence, defaults, uplink_interval_s, data_rate ("adr" or 0-4),
+//   discovery: { enabled, rssi_change_db, min_interval_s }, sample_cycle_s,
+//   log_level ("error", "warn", "info", "debug") }
+function encodeDownlink(input) {
+    const data = input.data;
+    const bytes = [1, (data.sequence || 0) & 0xFF];
+    const u16 = function (value) {
+        return [(value >> 8) & 0xFF, value & 0xFF];
+    };
+    if (data.defaults) bytes.push(0x06);
+    if (data.uplink_interval_s !== undefined) bytes.push(0x01, ...u16(data.uplink_interval_s));
+    if (data.data_rate !== undefined) bytes.push(0x02, data.data_rate === "adr" ? 0xFF : data.data_rate);
+    if (data.discovery !== undefined) {
+        bytes.push(0x03, data.discovery.enabled ? 1 : 0, Math.round(data.discovery.rssi_change_db * 10),
+                   ...u16(data.discovery.min_interval_s));
+    }
+    if (data.sample_cycle_s !== undefined) bytes.push(0x04, ...u16(data.sample_cycle_s));
+    if (data.log_level !== undefined) bytes.push(0x05, ["error", "warn", "info", "debug"].indexOf(data.log_level));
+    return {
+        bytes: bytes,
+        fPort: 10,
+        warnings: [],
+        errors: []
+    };
+}
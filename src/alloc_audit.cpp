@@ -0,0 +1,130 @@
+#include "alloc_audit.h"
+#include <stdlib.h>
+#include <new>
+
+static volatile uint32_t allocationCount = 0;
+static volatile uint32_t allocationBytes = 0;
+static volatile uint32_t hostAllocationCount = 0;
+static volatile uint32_t hostDepth = 0;
+
+#if defined(ALLOC_AUDIT)
+
+static inline void countAllocation(size_t size) {
+    if (__atomic_load_n(&hostDepth, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&hostAllocationCount, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocationBytes, (uint32_t)size, __ATOMIC_RELAXED);
+}
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    void* pointer = __real_malloc(size);
+    if (pointer) countAllocation(size);
+    return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* pointer = __real_calloc(count, size);
+    if (pointer) countAllocation(count * size);
+    return pointer;
+}
+
+// Shrinking or freeing through realloc is not an allocation
+void* __wrap_realloc(void* pointer, size_t size) {
+    void* result = __real_realloc(pointer, size);
+    if (result && size > 0) countAllocation(size);
+    return result;
+}
+}
+
+// Route operator new through the wrapped malloc; a prebuilt C++ runtime
+// (host libstdc++.so) would otherwise allocate out of sight of --wrap
+void* operator new(size_t size) {
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer) abort();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+bool allocAuditEnabled() {
+    return true;
+}
+
+#else
+
+bool allocAuditEnabled() {
+    return false;
+}
+
+#endif
+
+AllocAuditStats allocAuditSnapshot() {
+    AllocAuditStats stats;
+    stats.allocations = __atomic_load_n(&allocationCount, __ATOMIC_RELAXED);
+    stats.bytes = __atomic_load_n(&allocationBytes, __ATOMIC_RELAXED);
+    stats.hostAllocations = __atomic_load_n(&hostAllocationCount, __ATOMIC_RELAXED);
+    return stats;
+}
+
+// Nests; the platform stand-ins call into each other
+void allocAuditHostBegin() {
+    __atomic_fetch_add(&hostDepth, 1, __ATOMIC_RELAXED);
+}
+
+void allocAuditHostEnd() {
+    __atomic_fetch_sub(&hostDepth, 1, __ATOMIC_RELAXED);
+}
+
+AllocAuditLoop::AllocAuditLoop(uint32_t warmup) :
+    iterations(0),
+    warmupIterations(warmup),
+    startCount(0),
+    lastAllocations(0),
+    worstAllocations(0),
+    allocatingIterations(0) {
+}
+
+void AllocAuditLoop::begin() {
+    startCount = allocAuditSnapshot().allocations;
+}
+
+void AllocAuditLoop::end() {
+    lastAllocations = allocAuditSnapshot().allocations - startCount;
+    iterations++;
+    if (!isWarm()) return;
+    if (lastAllocations > worstAllocations) worstAllocations = lastAllocations;
+    if (lastAllocations > 0) allocatingIterations++;
+}
@@ -0,0 +1,58 @@
+#ifndef ALLOC_AUDIT_H
+#define ALLOC_AUDIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Heap allocation counter for checking that the steady-state loop does not
+// allocate. Built with -DALLOC_AUDIT and the linker wrapping the C heap
+// (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc, see the
+// heltec_wireless_tracker_alloc_audit env), every allocation is counted:
+// operator new, Arduino String, printf spill buffers, from any task.
+// Without the flag the counters stay at zero and nothing is wrapped.
+//
+// Code standing in for the platform (the native simulation's NVS, LittleFS
+// and radio models) brackets itself with AllocAuditHostScope: what it
+// allocates on the host is counted apart, not as the firmware's.
+
+struct AllocAuditStats {
+    uint32_t allocations;       // Calls that returned memory since boot
+    uint32_t bytes;             // Bytes requested by those calls
+    uint32_t hostAllocations;   // Made inside an AllocAuditHostScope, not in the above
+};
+
+bool allocAuditEnabled();
+AllocAuditStats allocAuditSnapshot();
+void allocAuditHostBegin();
+void allocAuditHostEnd();
+
+class AllocAuditHostScope {
+public:
+    AllocAuditHostScope() { allocAuditHostBegin(); }
+    ~AllocAuditHostScope() { allocAuditHostEnd(); }
+};
+
+// Tracks allocations per loop iteration once a warm-up period is over
+class AllocAuditLoop {
+private:
+    uint32_t iterations;
+    uint32_t warmupIterations;
+    uint32_t startCount;
+    uint32_t lastAllocations;
+    uint32_t worstAllocations;
+    uint32_t allocatingIterations;
+
+public:
+    explicit AllocAuditLoop(uint32_t warmup);
+
+    void begin();
+    void end();
+
+    bool isWarm() const { return iterations > warmupIterations; }
+    uint32_t getIterations() const { return iterations; }
+    uint32_t getLastAllocations() const { return lastAllocations; }
+    uint32_t getWorstAllocations() const { return worstAllocations; }
+    uint32_t getAllocatingIterations() const { return allocatingIterations; }
+};
+
+#endif // ALLOC_AUDIT_H
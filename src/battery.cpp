@@ -0,0 +1,253 @@
+#include "battery.h"
+#include "console_print.h"
+#include "energy_ledger.h"
+#include "perf_stats.h"
+#include "Config.h"
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <esp_timer.h>
+#if !defined(NATIVE_SIM)
+#include <freertos/FreeRTOS.h>
+#endif
+
+#define ADC_CHANNELS_PER_UNIT   10      // ESP32-S3: GPIO1..10 on ADC1, GPIO11..20 on ADC2
+#define ADC_DEFAULT_VREF_MV     1100
+
+// The one-shot bursts run in the esp_timer task, possibly on the other core,
+// while the loop takes its copy of the reading
+#if defined(NATIVE_SIM)
+#define READING_ENTER()
+#define READING_EXIT()
+#else
+static portMUX_TYPE readingMux = portMUX_INITIALIZER_UNLOCKED;
+#define READING_ENTER() portENTER_CRITICAL(&readingMux)
+#define READING_EXIT()  portEXIT_CRITICAL(&readingMux)
+#endif
+
+// LiPo open-circuit voltage against state of charge, at room temperature
+struct DischargePoint {
+    uint16_t millivolts;
+    uint8_t percent;
+};
+
+static const DischargePoint DISCHARGE_CURVE[] = {
+    {3270, 0}, {3610, 5}, {3690, 10}, {3710, 15}, {3730, 20}, {3750, 25}, {3770, 30},
+    {3790, 35}, {3800, 40}, {3820, 45}, {3840, 50}, {3850, 55}, {3870, 60}, {3910, 65},
+    {3950, 70}, {3980, 75}, {4020, 80}, {4080, 85}, {4110, 90}, {4150, 95}, {4200, 100}
+};
+#define DISCHARGE_POINTS (sizeof(DISCHARGE_CURVE) / sizeof(DISCHARGE_CURVE[0]))
+
+static BatteryReading reading;             // The loop's copy
+static BatteryReading published;           // Latest measurement
+static BatteryStats stats;
+static esp_adc_cal_characteristics_t calibration;
+static uint8_t adcChannel = 0;
+static uint32_t sampleSum = 0;      // Calibrated mV at the pin, towards the next measurement
+static uint16_t sampleCount = 0;
+static float filteredMv = 0;
+static uint32_t measuredMs = 0;
+static esp_timer_handle_t burstTimer = nullptr;
+static uint8_t frame[BATTERY_DMA_FRAME_BYTES];
+
+static bool startDma() {
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = BATTERY_DMA_BUFFER_BYTES;
+    init.conv_num_each_intr = BATTERY_DMA_FRAME_BYTES;
+    init.adc1_chan_mask = BIT(adcChannel);
+    init.adc2_chan_mask = 0;
+    esp_err_t err = adc_digi_initialize(&init);
+    if (err == ESP_ERR_INVALID_STATE) {
+        // Still running from before a recovery; start over
+        adc_digi_stop();
+        adc_digi_deinitialize();
+        err = adc_digi_initialize(&init);
+    }
+    if (err != ESP_OK) {
+        consolePrintf("[Battery] [WARN] DMA ADC unavailable (%d), sampling one-shot\n", err);
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_11;
+    pattern.channel = adcChannel;
+    pattern.unit = 0;
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.conv_limit_num = 250;
+    config.pattern_num = 1;
+    config.adc_pattern = &pattern;
+    config.sample_freq_hz = BATTERY_SAMPLE_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    err = adc_digi_controller_configure(&config);
+    if (err == ESP_OK) err = adc_digi_start();
+    if (err != ESP_OK) {
+        consolePrintf("[Battery] [WARN] DMA ADC configuration failed (%d), sampling one-shot\n", err);
+        adc_digi_deinitialize();
+        return false;
+    }
+    return true;
+}
+
+static void oneShotBurst();
+static void burstTimerFired(void*);
+
+bool batteryInitialize() {
+    reading = BatteryReading();
+    published = BatteryReading();
+    stats = BatteryStats();
+    sampleSum = 0;
+    sampleCount = 0;
+    filteredMv = 0;
+    measuredMs = 0;
+    burstTimer = nullptr;
+
+    // DMA needs an ADC1 pin; the one-shot reads are calibrated by the Arduino core
+    bool adc1 = BATTERY_PIN >= 1 && BATTERY_PIN <= ADC_CHANNELS_PER_UNIT;
+    adcChannel = adc1 ? BATTERY_PIN - 1 : 0;
+    stats.sampling = adc1 && startDma() ? BATTERY_SAMPLING_DMA : BATTERY_SAMPLING_ONESHOT;
+    if (stats.sampling == BATTERY_SAMPLING_DMA) {
+        esp_adc_cal_value_t source =
+            esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF_MV, &calibration);
+        stats.efuseCalibration = source == ESP_ADC_CAL_VAL_EFUSE_TP || source == ESP_ADC_CAL_VAL_EFUSE_TP_FIT ||
+                                 source == ESP_ADC_CAL_VAL_EFUSE_VREF;
+    } else {
+        stats.efuseCalibration = esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP_FIT) == ESP_OK;
+    }
+
+    consolePrintf("[Battery] GPIO %d, divider %.2f, %s sampling, %s calibration\n", BATTERY_PIN,
+                  BATTERY_DIVIDER_RATIO, stats.sampling == BATTERY_SAMPLING_DMA ? "DMA" : "one-shot",
+                  stats.efuseCalibration ? "eFuse" : "default");
+    if (stats.sampling == BATTERY_SAMPLING_ONESHOT) {
+        // First burst here so there is a reading at boot, the rest on the timer
+        oneShotBurst();
+        reading = published;
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = burstTimerFired;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "battery";
+        if (esp_timer_create(&timerArgs, &burstTimer) == ESP_OK) {
+            esp_timer_start_once(burstTimer, BATTERY_ONESHOT_PERIOD_MS * 1000ULL);
+        } else {
+            consolePrintf("[Battery] [WARN] No burst timer, the reading stays at boot\n");
+        }
+    }
+    return stats.sampling == BATTERY_SAMPLING_DMA;
+}
+
+// One averaged measurement into the filter, then the published reading
+static void measure() {
+    float mv = (float)sampleSum / sampleCount * BATTERY_DIVIDER_RATIO;
+    sampleSum = 0;
+    sampleCount = 0;
+
+    uint32_t now = millis();
+    if (stats.measurements == 0) {
+        filteredMv = mv;
+    } else {
+        float dt = (float)(uint32_t)(now - measuredMs);
+        filteredMv += (mv - filteredMv) * dt / (BATTERY_FILTER_MS + dt);
+    }
+    stats.measurements++;
+    measuredMs = now;
+
+    BatteryReading next;
+    float loadMa = energyPresentCurrentMa();
+    float openCircuitMv = filteredMv + loadMa * BATTERY_INTERNAL_MOHM / 1000.0f;
+    next.millivolts = (uint16_t)(filteredMv + 0.5f);
+    next.openCircuitMv = (uint16_t)(openCircuitMv + 0.5f);
+    next.voltage = next.millivolts / 1000.0f;
+    next.percent = batteryVoltageToPercentage(openCircuitMv / 1000.0f);
+    next.loadMa = loadMa;
+    next.updatedMs = now;
+    next.valid = true;
+    READING_ENTER();
+    published = next;
+    READING_EXIT();
+}
+
+static void addSample(uint32_t pinMv) {
+    sampleSum += pinMv;
+    sampleCount++;
+    stats.conversions++;
+    if (sampleCount >= BATTERY_OVERSAMPLE) measure();
+}
+
+static void drainDma() {
+    uint32_t length = 0;
+    esp_err_t err;
+    do {
+        err = adc_digi_read_bytes(frame, sizeof(frame), &length, 0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            stats.overruns++;       // Ring was full; what it holds is still good
+        } else if (err != ESP_OK) {
+            if (err != ESP_ERR_TIMEOUT) stats.errors++;
+            return;
+        }
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t* result = (const adc_digi_output_data_t*)&frame[i];
+            if (result->type2.unit != 0 || result->type2.channel != adcChannel) continue;
+            addSample(esp_adc_cal_raw_to_voltage(result->type2.data, &calibration));
+        }
+    } while (length == sizeof(frame));
+}
+
+// ADC2 fallback: one measurement's worth of one-shot reads, a few ms
+static void oneShotBurst() {
+    PERF_SCOPE(PERF_BATTERY_READ);
+    for (int i = 0; i < BATTERY_OVERSAMPLE; i++) addSample(analogReadMilliVolts(BATTERY_PIN));
+}
+
+static void burstTimerFired(void*) {
+    if (stats.sampling != BATTERY_SAMPLING_ONESHOT) return;
+    oneShotBurst();
+    esp_timer_start_once(burstTimer, BATTERY_ONESHOT_PERIOD_MS * 1000ULL);
+}
+
+void batteryUpdate() {
+    if (stats.sampling == BATTERY_SAMPLING_DMA) {
+        PERF_SCOPE(PERF_BATTERY_READ);
+        drainDma();
+    }
+    READING_ENTER();
+    reading = published;
+    READING_EXIT();
+}
+
+const BatteryReading& batteryReading() {
+    return reading;
+}
+
+const BatteryStats& batteryStats() {
+    return stats;
+}
+
+void batteryPrintStatus() {
+    static const char* SAMPLING_NAMES[] = {"off", "DMA", "one-shot"};
+    consolePrintf("[Battery] %s sampling on GPIO %d, %s calibration, divider %.2f\n", SAMPLING_NAMES[stats.sampling],
+                  BATTERY_PIN, stats.efuseCalibration ? "eFuse" : "default", BATTERY_DIVIDER_RATIO);
+    if (!reading.valid) {
+        Serial.println(F("[Battery] No measurement yet"));
+    } else {
+        consolePrintf("[Battery] %.3f V at %.0f mA, %.3f V open circuit, %.1f%% (%lu ms ago)\n", reading.voltage,
+                      reading.loadMa, reading.openCircuitMv / 1000.0f, reading.percent,
+                      (unsigned long)(millis() - reading.updatedMs));
+    }
+    consolePrintf("[Battery] %lu conversions, %lu measurements, %lu overruns, %lu errors\n",
+                  (unsigned long)stats.conversions, (unsigned long)stats.measurements, (unsigned long)stats.overruns,
+                  (unsigned long)stats.errors);
+}
+
+float batteryVoltageToPercentage(float voltage) {
+    float mv = voltage * 1000.0f;
+    if (mv <= DISCHARGE_CURVE[0].millivolts) return 0.0f;
+    if (mv >= DISCHARGE_CURVE[DISCHARGE_POINTS - 1].millivolts) return 100.0f;
+
+    size_t i = 1;
+    while (mv > DISCHARGE_CURVE[i].millivolts) i++;
+    const DischargePoint& low = DISCHARGE_CURVE[i - 1];
+    const DischargePoint& high = DISCHARGE_CURVE[i];
+    return low.percent + (mv - low.millivolts) * (high.percent - low.percent) / (high.millivolts - low.millivolts);
+}
@@ -0,0 +1,79 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdint.h>
+
+// Battery monitor. The ADC samples the battery divider continuously and
+// the loop only picks up the result (batteryUpdate()); readers get the last
+// reading from batteryReading() without touching the ADC.
+//
+// On an ADC1 pin the conversions come from the continuous (DMA) driver at
+// BATTERY_SAMPLE_HZ, the lowest rate it runs at, and the loop drains them.
+// ADC2 has no DMA on the ESP32-S3, so on an ADC2 pin (the default
+// BATTERY_PIN) an esp_timer takes a burst of one-shot reads every
+// BATTERY_ONESHOT_PERIOD_MS instead, off the loop.
+// Either way BATTERY_OVERSAMPLE conversions are averaged into one
+// measurement, converted to millivolts with the chip's eFuse calibration,
+// scaled by the divider and smoothed over BATTERY_FILTER_MS.
+//
+// State of charge comes from a LiPo open-circuit discharge curve. The
+// terminal voltage sags under load, so the open-circuit voltage is
+// estimated first: terminal + present draw (energy ledger) x the cell's
+// internal resistance.
+
+#ifndef BATTERY_DIVIDER_RATIO
+#define BATTERY_DIVIDER_RATIO       2.0f    // Battery voltage / ADC pin voltage
+#endif
+#ifndef BATTERY_INTERNAL_MOHM
+#define BATTERY_INTERNAL_MOHM       250.0f  // Cell, protection FET and wiring
+#endif
+#define BATTERY_SAMPLE_HZ           611     // ESP32-S3 DMA minimum
+#define BATTERY_OVERSAMPLE          64      // Conversions averaged per measurement
+#define BATTERY_FILTER_MS           10000   // Time constant of the smoothing
+#define BATTERY_ONESHOT_PERIOD_MS   1000    // ADC2 fallback: one burst per period
+#define BATTERY_DMA_BUFFER_BYTES    1024    // Driver ring, 256 conversions
+#define BATTERY_DMA_FRAME_BYTES     256     // Converted per DMA interrupt and per read
+
+enum BatterySampling {
+    BATTERY_SAMPLING_NONE = 0,
+    BATTERY_SAMPLING_DMA,
+    BATTERY_SAMPLING_ONESHOT
+};
+
+struct BatteryReading {
+    bool valid;                 // False until the first measurement
+    uint16_t millivolts;        // Filtered terminal voltage
+    uint16_t openCircuitMv;     // ... compensated for the load
+    float voltage;              // millivolts in V
+    float percent;              // From the discharge curve, 0..100
+    float loadMa;               // Draw used for the compensation
+    uint32_t updatedMs;         // millis() of the last measurement
+
+    BatteryReading() : valid(false), millivolts(0), openCircuitMv(0), voltage(0), percent(0), loadMa(0),
+                       updatedMs(0) {}
+};
+
+struct BatteryStats {
+    BatterySampling sampling;
+    bool efuseCalibration;      // False: the driver's default reference
+    uint32_t conversions;
+    uint32_t measurements;
+    uint32_t overruns;          // Drains that found the DMA ring full
+    uint32_t errors;            // Reads that failed
+};
+
+// Starts sampling; call once early in setup() (again after a wake is fine)
+bool batteryInitialize();
+
+// Drains converted samples (DMA) and takes the latest reading; every loop pass
+void batteryUpdate();
+
+// Last reading, cached
+const BatteryReading& batteryReading();
+const BatteryStats& batteryStats();
+void batteryPrintStatus();
+
+// State of charge from the open-circuit voltage of one LiPo cell, 0..100
+float batteryVoltageToPercentage(float voltage);
+
+#endif // BATTERY_H
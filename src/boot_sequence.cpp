@@ -0,0 +1,98 @@
+#include "boot_sequence.h"
+#include "console_print.h"
+#include <Arduino.h>
+
+static const char* MILESTONE_NAMES[BOOT_MILESTONE_COUNT] = {
+    "gnss_power",
+    "console",
+    "radio_ready",
+    "link_up",
+    "setup_done",
+    "display_ready",
+    "first_fix",
+    "first_uplink"
+};
+
+// `before` must be reached no later than `after`
+struct BootOrderRule {
+    BootMilestone before;
+    BootMilestone after;
+};
+
+static const BootOrderRule ORDER_RULES[] = {
+    {BOOT_GNSS_POWER, BOOT_RADIO_READY},
+    {BOOT_GNSS_POWER, BOOT_DISPLAY_READY},
+    {BOOT_RADIO_READY, BOOT_LINK_UP},
+    {BOOT_RADIO_READY, BOOT_DISPLAY_READY},
+    {BOOT_SETUP_DONE, BOOT_DISPLAY_READY},
+    {BOOT_LINK_UP, BOOT_FIRST_UPLINK}
+};
+#define ORDER_RULE_COUNT (sizeof(ORDER_RULES) / sizeof(ORDER_RULES[0]))
+
+static uint32_t milestoneMs[BOOT_MILESTONE_COUNT];
+static bool reached[BOOT_MILESTONE_COUNT];
+static bool ruleBroken[ORDER_RULE_COUNT];
+
+void bootBegin() {
+    for (int i = 0; i < BOOT_MILESTONE_COUNT; i++) {
+        milestoneMs[i] = 0;
+        reached[i] = false;
+    }
+    for (size_t i = 0; i < ORDER_RULE_COUNT; i++) ruleBroken[i] = false;
+}
+
+void bootMark(BootMilestone milestone) {
+    bootMarkAt(milestone, millis());
+}
+
+void bootMarkAt(BootMilestone milestone, uint32_t ms) {
+    if (milestone < 0 || milestone >= BOOT_MILESTONE_COUNT || reached[milestone]) return;
+    reached[milestone] = true;
+    milestoneMs[milestone] = ms;
+}
+
+bool bootReached(BootMilestone milestone) {
+    return milestone >= 0 && milestone < BOOT_MILESTONE_COUNT && reached[milestone];
+}
+
+uint32_t bootMilestoneMs(BootMilestone milestone) {
+    return bootReached(milestone) ? milestoneMs[milestone] : 0;
+}
+
+const char* bootMilestoneName(BootMilestone milestone) {
+    if (milestone < 0 || milestone >= BOOT_MILESTONE_COUNT) return "?";
+    return MILESTONE_NAMES[milestone];
+}
+
+uint8_t bootCheckOrder() {
+    uint8_t broken = 0;
+    for (size_t i = 0; i < ORDER_RULE_COUNT; i++) {
+        const BootOrderRule& rule = ORDER_RULES[i];
+        if (!reached[rule.after]) continue;
+        if (reached[rule.before] && milestoneMs[rule.before] <= milestoneMs[rule.after]) continue;
+        broken++;
+        if (!ruleBroken[i]) {
+            ruleBroken[i] = true;
+            consolePrintf("[BOOT] [ERROR] %s at %lu ms came before %s\n", MILESTONE_NAMES[rule.after],
+                          (unsigned long)milestoneMs[rule.after], MILESTONE_NAMES[rule.before]);
+        }
+    }
+    return broken;
+}
+
+void bootPrintReport() {
+    Serial.println(F("[BOOT] Milestones (ms since boot):"));
+    for (int i = 0; i < BOOT_MILESTONE_COUNT; i++) {
+        if (reached[i]) {
+            consolePrintf("[BOOT]   %-14s %8lu\n", MILESTONE_NAMES[i], (unsigned long)milestoneMs[i]);
+        } else {
+            consolePrintf("[BOOT]   %-14s %8s\n", MILESTONE_NAMES[i], "-");
+        }
+    }
+    uint8_t broken = bootCheckOrder();
+    if (broken == 0) {
+        Serial.println(F("[BOOT] Order OK"));
+    } else {
+        consolePrintf("[BOOT] [ERROR] %u ordering constraint(s) broken\n", broken);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <stdint.h>
+
+// Staged boot: the slow parts start first and run in parallel. The GNSS
+// receiver is powered before anything else so its acquisition overlaps the
+// rest of the boot; the radio comes up next and restores its session or
+// joins in the background (a task on the device); the display is powered
+// early but initialized last, from the first loop pass, so nothing waits
+// for it.
+//
+// Each stage is timestamped (millis() since boot) when it is reached, and
+// bootCheckOrder() checks the order the stages depend on. The native
+// simulation checks the same order from the outside, on its pins and
+// peripherals (--check-boot).
+
+#define BOOT_CONSOLE_WAIT_MS    2000    // Power-on: longest wait for a USB console to attach
+
+enum BootMilestone {
+    BOOT_GNSS_POWER = 0,    // Receiver powered, acquisition running
+    BOOT_CONSOLE,           // Serial console and commands up
+    BOOT_RADIO_READY,       // SX1262 and LoRaWAN credentials configured
+    BOOT_LINK_UP,           // Session restored or join accepted
+    BOOT_SETUP_DONE,        // setup() returned
+    BOOT_DISPLAY_READY,     // Panel initialized, from the first loop pass
+    BOOT_FIRST_FIX,
+    BOOT_FIRST_UPLINK,
+    BOOT_MILESTONE_COUNT
+};
+
+// Forgets the previous boot's milestones; call first thing in setup()
+void bootBegin();
+
+// Records a milestone now, or at an earlier millis() taken elsewhere; the
+// first record of each milestone counts
+void bootMark(BootMilestone milestone);
+void bootMarkAt(BootMilestone milestone, uint32_t ms);
+
+bool bootReached(BootMilestone milestone);
+uint32_t bootMilestoneMs(BootMilestone milestone);     // 0 if not reached
+const char* bootMilestoneName(BootMilestone milestone);
+
+// Number of ordering constraints broken so far, each logged once
+uint8_t bootCheckOrder();
+
+void bootPrintReport();
+
+#endif // BOOT_SEQUENCE_H
@@ -0,0 +1,264 @@
+#include "command_processor.h"
+#include "fixed_string.h"
+#include <stdlib.h>
+
+#define COMMAND_MESSAGE_MAX     127
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static char* skipSpaces(char* text) {
+    while (isSpace(*text)) text++;
+    return text;
+}
+
+static void trimEnd(char* text) {
+    size_t length = strlen(text);
+    while (length > 0 && isSpace(text[length - 1])) text[--length] = '\0';
+}
+
+CommandProcessor::CommandProcessor() :
+    commands(nullptr),
+    commandCount(0),
+    print(nullptr),
+    used(0),
+    overlong(false),
+    executed(0),
+    rejected(0) {
+    memset(index, 0, sizeof(index));
+    line[0] = '\0';
+}
+
+// FNV-1a
+uint32_t CommandProcessor::hash(const char* word, size_t length) {
+    uint32_t value = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        value ^= (uint8_t)word[i];
+        value *= 16777619u;
+    }
+    return value;
+}
+
+bool CommandProcessor::insert(const char* name, uint8_t position) {
+    size_t length = strlen(name);
+    uint32_t slot = hash(name, length);
+    for (int probe = 0; probe < COMMAND_INDEX_SIZE; probe++, slot++) {
+        uint8_t& entry = index[slot & (COMMAND_INDEX_SIZE - 1)];
+        if (entry == 0) {
+            entry = position + 1;
+            return true;
+        }
+        // A command's own name may sit on its alias's probe path
+        if (entry - 1 == position) continue;
+        const CommandSpec& other = commands[entry - 1];
+        if (strcmp(other.name, name) == 0 || (other.alias && strcmp(other.alias, name) == 0)) return false;
+    }
+    return false;
+}
+
+bool CommandProcessor::begin(const CommandSpec* table, size_t count, CommandPrint printer) {
+    commands = table;
+    commandCount = count;
+    print = printer;
+    used = 0;
+    overlong = false;
+    memset(index, 0, sizeof(index));
+    if (count * 2 >= COMMAND_INDEX_SIZE || count >= 0xFF) return false;
+    for (size_t i = 0; i < count; i++) {
+        bool inserted = insert(table[i].name, (uint8_t)i) && (!table[i].alias || insert(table[i].alias, (uint8_t)i));
+        if (!inserted) {
+            // Every lookup fails rather than some resolving to the wrong command
+            memset(index, 0, sizeof(index));
+            return false;
+        }
+    }
+    return true;
+}
+
+const CommandSpec* CommandProcessor::find(const char* name, size_t length) const {
+    uint32_t slot = hash(name, length);
+    for (int probe = 0; probe < COMMAND_INDEX_SIZE; probe++, slot++) {
+        uint8_t entry = index[slot & (COMMAND_INDEX_SIZE - 1)];
+        if (entry == 0) return nullptr;
+        const CommandSpec& spec = commands[entry - 1];
+        if (strncmp(spec.name, name, length) == 0 && spec.name[length] == '\0') return &spec;
+        if (spec.alias && strncmp(spec.alias, name, length) == 0 && spec.alias[length] == '\0') return &spec;
+    }
+    return nullptr;
+}
+
+void CommandProcessor::report(const char* format, ...) {
+    if (!print) return;
+    char message[COMMAND_MESSAGE_MAX + 1];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    print(message);
+}
+
+void CommandProcessor::feed(char c) {
+    if (c == '\n' || c == '\r') {
+        endLine();
+        return;
+    }
+    if (overlong) return;
+    if (used == COMMAND_LINE_MAX) {
+        overlong = true;
+        return;
+    }
+    // Names and keywords are case-insensitive
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    line[used++] = c;
+}
+
+void CommandProcessor::endLine() {
+    line[used] = '\0';
+    if (overlong) {
+        report("Command too long (max %u characters)", (unsigned)COMMAND_LINE_MAX);
+        rejected++;
+    } else if (used > 0) {
+        execute(line);
+    }
+    used = 0;
+    overlong = false;
+}
+
+bool CommandProcessor::execute(char* text) {
+    bool ok = true;
+    while (text) {
+        char* separator = strchr(text, COMMAND_SEPARATOR);
+        if (separator) *separator = '\0';
+        char* command = skipSpaces(text);
+        trimEnd(command);
+        if (*command && !executeOne(command)) ok = false;
+        text = separator ? separator + 1 : nullptr;
+    }
+    return ok;
+}
+
+bool CommandProcessor::executeOne(char* text) {
+    char* end = text;
+    while (*end && !isSpace(*end)) end++;
+    size_t length = end - text;
+
+    const CommandSpec* spec = find(text, length);
+    if (!spec) {
+        *end = '\0';
+        report("Unknown command: %s (type 'help' for available commands)", text);
+        rejected++;
+        return false;
+    }
+
+    CommandArgs args;
+    if (!parseArgs(*spec, end, args)) {
+        rejected++;
+        return false;
+    }
+    executed++;
+    spec->handler(args);
+    return true;
+}
+
+static bool parseBool(const char* token, bool& value) {
+    if (strcmp(token, "on") == 0 || strcmp(token, "1") == 0 || strcmp(token, "true") == 0 || strcmp(token, "yes") == 0) {
+        value = true;
+        return true;
+    }
+    if (strcmp(token, "off") == 0 || strcmp(token, "0") == 0 || strcmp(token, "false") == 0 || strcmp(token, "no") == 0) {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+static const char* typeName(char type) {
+    switch (type) {
+        case 'u': return "<n>";
+        case 'i': return "<+-n>";
+        case 'f': return "<x>";
+        case 'b': return "on|off";
+        default: return "<word>";
+    }
+}
+
+bool CommandProcessor::parseArgs(const CommandSpec& spec, char* rest, CommandArgs& args) {
+    args.count = 0;
+    bool optional = false;
+    const char* types = spec.args;
+    char* cursor = rest;
+
+    for (;;) {
+        // Cut the next token in place
+        if (*cursor) *cursor++ = '\0';
+        cursor = skipSpaces(cursor);
+        char* token = *cursor ? cursor : nullptr;
+        while (*cursor && !isSpace(*cursor)) cursor++;
+
+        char type = *types;
+        if (type && types[1] == '?') optional = true;
+        if (!token) {
+            if (type && !optional) {
+                report("%s: missing argument %u (%s)", spec.name, (unsigned)args.count + 1, typeName(type));
+                return false;
+            }
+            return true;
+        }
+        if (!type || args.count == COMMAND_MAX_ARGS) {
+            report("%s: unexpected argument '%.*s'", spec.name, (int)(cursor - token), token);
+            return false;
+        }
+
+        char saved = *cursor;
+        *cursor = '\0';
+        CommandArg& arg = args.values[args.count];
+        arg.type = type;
+        arg.word = token;
+        char* parsedEnd = token;
+        bool valid = true;
+        switch (type) {
+            case 'u':
+                arg.u = (uint32_t)strtoul(token, &parsedEnd, 0);
+                valid = *token != '-' && *parsedEnd == '\0';
+                break;
+            case 'i':
+                arg.i = (int32_t)strtol(token, &parsedEnd, 0);
+                valid = *parsedEnd == '\0';
+                break;
+            case 'f':
+                arg.f = strtof(token, &parsedEnd);
+                valid = *parsedEnd == '\0';
+                break;
+            case 'b':
+                valid = parseBool(token, arg.b);
+                break;
+            default:
+                break;
+        }
+        if (!valid) {
+            report("%s: argument %u must be %s, got '%s'", spec.name, (unsigned)args.count + 1, typeName(type), token);
+            return false;
+        }
+        *cursor = saved;
+        args.count++;
+        types += types[1] == '?' ? 2 : 1;
+    }
+}
+
+void CommandProcessor::printHelp() const {
+    for (size_t i = 0; i < commandCount; i++) {
+        const CommandSpec& spec = commands[i];
+        FixedString<COMMAND_MESSAGE_MAX> message;
+        message.appendf("- %s", spec.name);
+        bool optional = false;
+        for (const char* type = spec.args; *type; type++) {
+            if (*type == '?') continue;
+            if (type[1] == '?') optional = true;
+            message.appendf(optional ? " [%s]" : " %s", typeName(*type));
+        }
+        if (spec.alias) message.appendf(" (%s)", spec.alias);
+        message.appendf(": %s", spec.help);
+        if (print) print(message.c_str());
+    }
+}
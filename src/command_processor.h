@@ -0,0 +1,108 @@
+#ifndef COMMAND_PROCESSOR_H
+#define COMMAND_PROCESSOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Serial console commands without blocking or heap use. poll() takes at
+// most COMMAND_BYTES_PER_POLL bytes that are already buffered, so a half
+// typed line never holds up the loop. Complete lines are split into
+// ';'-separated commands, each looked up by name or alias through a hash
+// index over the command table (built once in begin()) and its arguments
+// parsed against the command's type string before the handler runs.
+//
+// Argument type string, one character per argument, '?' after a type makes
+// it and everything after it optional:
+//   u unsigned   i signed   f float   b on/off, 1/0, true/false, yes/no   w word
+//
+// Portable: the same processor runs in tools/command_check.cpp.
+
+#define COMMAND_LINE_MAX        95      // Characters per line, batch included
+#define COMMAND_MAX_ARGS        3
+#define COMMAND_BYTES_PER_POLL  64      // Bounded work per poll() call
+#define COMMAND_INDEX_SIZE      64      // Hash slots; power of two, > 2 x names
+#define COMMAND_SEPARATOR       ';'
+
+struct CommandArg {
+    char type;
+    union {
+        uint32_t u;
+        int32_t i;
+        float f;
+        bool b;
+    };
+    const char* word;       // Raw token, valid during the handler call
+};
+
+struct CommandArgs {
+    uint8_t count;
+    CommandArg values[COMMAND_MAX_ARGS];
+
+    bool has(uint8_t index) const { return index < count; }
+    uint32_t getUint(uint8_t index, uint32_t fallback) const { return has(index) ? values[index].u : fallback; }
+    int32_t getInt(uint8_t index, int32_t fallback) const { return has(index) ? values[index].i : fallback; }
+    float getFloat(uint8_t index, float fallback) const { return has(index) ? values[index].f : fallback; }
+    bool getBool(uint8_t index, bool fallback) const { return has(index) ? values[index].b : fallback; }
+    const char* getWord(uint8_t index, const char* fallback) const { return has(index) ? values[index].word : fallback; }
+};
+
+typedef void (*CommandHandler)(const CommandArgs& args);
+typedef void (*CommandPrint)(const char* message);
+
+struct CommandSpec {
+    const char* name;
+    const char* alias;          // nullptr if none
+    const char* args;           // Type string, "" for none
+    const char* help;
+    CommandHandler handler;
+};
+
+class CommandProcessor {
+private:
+    const CommandSpec* commands;
+    size_t commandCount;
+    CommandPrint print;
+    uint8_t index[COMMAND_INDEX_SIZE];      // Table position + 1, 0 = empty
+    char line[COMMAND_LINE_MAX + 1];
+    size_t used;
+    bool overlong;                          // Dropping the rest of a too-long line
+    uint32_t executed;
+    uint32_t rejected;
+
+    static uint32_t hash(const char* word, size_t length);
+    bool insert(const char* name, uint8_t position);
+    void endLine();
+    bool executeOne(char* text);
+    bool parseArgs(const CommandSpec& spec, char* rest, CommandArgs& args);
+    void report(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+public:
+    CommandProcessor();
+
+    // False if two names collide or the index is too small for the table
+    bool begin(const CommandSpec* table, size_t count, CommandPrint printer);
+
+    // Feeds one byte; runs the line when it ends
+    void feed(char c);
+
+    // Drains what the stream already holds, up to COMMAND_BYTES_PER_POLL bytes
+    template <class Stream>
+    void poll(Stream& input) {
+        for (int budget = COMMAND_BYTES_PER_POLL; budget > 0 && input.available() > 0; budget--) {
+            int c = input.read();
+            if (c < 0) break;
+            feed((char)c);
+        }
+    }
+
+    // Runs a complete line (';'-separated batch) in place; false if any command failed
+    bool execute(char* text);
+
+    const CommandSpec* find(const char* name, size_t length) const;
+    void printHelp() const;
+
+    uint32_t getExecuted() const { return executed; }
+    uint32_t getRejected() const { return rejected; }
+};
+
+#endif // COMMAND_PROCESSOR_H
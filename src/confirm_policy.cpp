@@ -0,0 +1,191 @@
+#include "confirm_policy.h"
+#include "console_print.h"
+#include "dr_survey.h"
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <math.h>
+#include <string.h>
+
+#define CONFIRM_RETAINED_MAGIC      0x434E4650  // "CNFP"
+#define CONFIRM_RETAINED_VERSION    1           // Bump when ConfirmRetained changes
+
+struct ConfirmRetained {
+    uint32_t magic;
+    uint32_t version;
+    ConfirmStats stats;
+    ConfirmCell cells[CONFIRM_MAX_CELLS];
+    uint32_t cellCount;
+};
+
+RTC_DATA_ATTR static ConfirmRetained retained;
+
+static const char* REASON_NAMES[CONFIRM_REASON_COUNT] = {"unconfirmed", "interval", "new cell", "retry"};
+
+void confirmPolicyBegin() {
+    bool deepSleepWake = esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+    if (deepSleepWake && retained.magic == CONFIRM_RETAINED_MAGIC && retained.version == CONFIRM_RETAINED_VERSION) {
+        return;
+    }
+    memset(&retained, 0, sizeof(retained));
+    retained.magic = CONFIRM_RETAINED_MAGIC;
+    retained.version = CONFIRM_RETAINED_VERSION;
+    retained.stats.enabled = CONFIRM_POLICY_ENABLED;
+    retained.stats.ackRate = 0.5f;
+    retained.stats.every = CONFIRM_NOVEL_EVERY;
+}
+
+void confirmPolicySetEnabled(bool enable) {
+    retained.stats.enabled = enable;
+    retained.stats.sinceConfirmed = 0;
+    retained.stats.misses = 0;
+}
+
+static ConfirmCell* findCell(int32_t latitudeE7, int32_t longitudeE7) {
+    int32_t latitudeIndex = drSurveyCellIndex(latitudeE7);
+    int32_t longitudeIndex = drSurveyCellIndex(longitudeE7);
+    for (size_t i = 0; i < retained.cellCount; i++) {
+        ConfirmCell& cell = retained.cells[i];
+        if (cell.latitudeIndex == latitudeIndex && cell.longitudeIndex == longitudeIndex) return &cell;
+    }
+    return nullptr;
+}
+
+// A new cell, in a free slot or the least recently visited one
+static ConfirmCell& addCell(int32_t latitudeE7, int32_t longitudeE7) {
+    ConfirmCell* cell;
+    if (retained.cellCount < CONFIRM_MAX_CELLS) {
+        cell = &retained.cells[retained.cellCount++];
+    } else {
+        cell = &retained.cells[0];
+        for (size_t i = 1; i < CONFIRM_MAX_CELLS; i++) {
+            if (retained.cells[i].lastUplink < cell->lastUplink) cell = &retained.cells[i];
+        }
+        retained.stats.replaced++;
+    }
+    memset(cell, 0, sizeof(*cell));
+    cell->latitudeIndex = drSurveyCellIndex(latitudeE7);
+    cell->longitudeIndex = drSurveyCellIndex(longitudeE7);
+    cell->rssiMin = INT16_MAX;
+    return *cell;
+}
+
+static uint8_t intervalFor(float ackRate) {
+    return CONFIRM_MIN_EVERY + (uint8_t)lroundf((CONFIRM_MAX_EVERY - CONFIRM_MIN_EVERY) * ackRate * ackRate);
+}
+
+ConfirmReason confirmPolicyCheck(bool hasPosition, int32_t latitudeE7, int32_t longitudeE7) {
+    ConfirmStats& stats = retained.stats;
+    if (!stats.enabled) return CONFIRM_NONE;
+
+    const ConfirmCell* cell = hasPosition ? findCell(latitudeE7, longitudeE7) : nullptr;
+    bool novel = hasPosition && (!cell || cell->confirmed < CONFIRM_SETTLED);
+    if (novel) {
+        stats.every = CONFIRM_NOVEL_EVERY;
+    } else if (cell) {
+        // Counted with one ack and one miss up front, so a short run does not swing it to either end
+        stats.every = intervalFor((cell->acked + 1.0f) / (cell->confirmed + 2.0f));
+    } else {
+        stats.every = intervalFor(stats.ackRate);
+    }
+
+    uint32_t uplinks = stats.sinceConfirmed + 1u;
+    if (stats.misses > 0) {
+        uint32_t wait = 1u << (stats.misses > 6 ? 6 : stats.misses - 1);
+        return uplinks >= (wait < CONFIRM_MAX_EVERY ? wait : CONFIRM_MAX_EVERY) ? CONFIRM_RETRY : CONFIRM_NONE;
+    }
+    if (uplinks < stats.every) return CONFIRM_NONE;
+    return novel ? CONFIRM_NOVEL : CONFIRM_INTERVAL;
+}
+
+void confirmPolicyRecord(ConfirmReason reason, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7, bool acked,
+                         int16_t rssi, int16_t snrDeci, uint8_t rxWindow) {
+    ConfirmStats& stats = retained.stats;
+    if (reason >= CONFIRM_REASON_COUNT) return;
+    stats.uplinks++;
+    stats.sent[reason]++;
+    ConfirmCell* cell = hasPosition ? findCell(latitudeE7, longitudeE7) : nullptr;
+    if (cell) cell->lastUplink = stats.uplinks;
+    if (reason == CONFIRM_NONE) {
+        if (stats.sinceConfirmed < UINT16_MAX) stats.sinceConfirmed++;
+        return;
+    }
+
+    stats.sinceConfirmed = 0;
+    stats.ackRate += CONFIRM_RATE_WEIGHT * ((acked ? 1.0f : 0.0f) - stats.ackRate);
+    if (acked) {
+        stats.acked++;
+        stats.misses = 0;
+        if (rxWindow == 2) {
+            stats.acksRx2++;
+        } else {
+            stats.acksRx1++;
+        }
+    } else if (stats.misses < UINT8_MAX) {
+        stats.misses++;
+    }
+
+    if (!hasPosition) {
+        stats.unplaced++;
+        return;
+    }
+    if (!cell) {
+        cell = &addCell(latitudeE7, longitudeE7);
+        cell->lastUplink = stats.uplinks;
+    }
+    if (cell->confirmed == UINT16_MAX) return;
+    cell->confirmed++;
+    if (!acked) return;
+    cell->acked++;
+    if (rxWindow == 2) {
+        cell->acksRx2++;
+    } else {
+        cell->acksRx1++;
+    }
+    cell->rssiSum += rssi;
+    cell->snrDeciSum += snrDeci;
+    if (rssi < cell->rssiMin) cell->rssiMin = rssi;
+}
+
+const ConfirmStats& confirmPolicyStats() {
+    return retained.stats;
+}
+
+size_t confirmPolicyCellCount() {
+    return retained.cellCount;
+}
+
+const ConfirmCell& confirmPolicyCell(size_t index) {
+    return retained.cells[index < retained.cellCount ? index : 0];
+}
+
+const char* confirmReasonName(ConfirmReason reason) {
+    return reason < CONFIRM_REASON_COUNT ? REASON_NAMES[reason] : "?";
+}
+
+void confirmPolicyPrintReport() {
+    const ConfirmStats& stats = retained.stats;
+    uint32_t confirmed = stats.uplinks - stats.sent[CONFIRM_NONE];
+    consolePrintf("[Confirm] Policy %s: %lu of %lu uplinks confirmed (%lu interval, %lu new cell, %lu retry), "
+                  "%lu acked (RX1 %lu, RX2 %lu)\n",
+                  stats.enabled ? "on" : "off", (unsigned long)confirmed, (unsigned long)stats.uplinks,
+                  (unsigned long)stats.sent[CONFIRM_INTERVAL], (unsigned long)stats.sent[CONFIRM_NOVEL],
+                  (unsigned long)stats.sent[CONFIRM_RETRY], (unsigned long)stats.acked, (unsigned long)stats.acksRx1,
+                  (unsigned long)stats.acksRx2);
+    consolePrintf("[Confirm] Ack rate %.0f%% (moving average), 1 in %u, %u uplinks since the last, %u misses in a row\n",
+                  stats.ackRate * 100.0f, stats.every, stats.sinceConfirmed, stats.misses);
+    for (size_t i = 0; i < retained.cellCount; i++) {
+        const ConfirmCell& cell = retained.cells[i];
+        consolePrintf("[Confirm] %7.3f,%8.3f: %u/%u acked", cell.latitudeIndex * (DR_SURVEY_CELL_E7 / 1e7),
+                      cell.longitudeIndex * (DR_SURVEY_CELL_E7 / 1e7), cell.acked, cell.confirmed);
+        if (cell.acked > 0) {
+            consolePrintf(", RSSI %d dBm mean, %d min, SNR %.1f dB, RX1/RX2 %u/%u", (int)(cell.rssiSum / cell.acked),
+                          cell.rssiMin, cell.snrDeciSum / 10.0f / cell.acked, cell.acksRx1, cell.acksRx2);
+        }
+        Serial.println();
+    }
+    if (stats.unplaced > 0 || stats.replaced > 0) {
+        consolePrintf("[Confirm] %lu confirmed without a position (totals only), %lu cells replaced\n",
+                      (unsigned long)stats.unplaced, (unsigned long)stats.replaced);
+    }
+}
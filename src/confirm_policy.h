@@ -0,0 +1,94 @@
+#ifndef CONFIRM_POLICY_H
+#define CONFIRM_POLICY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Which uplinks ask for an ack (LoRaHandler::sendStatusData() and the
+// gateway discovery uplinks). An ack is the only sign the device gets that
+// the downlink path works where it is, but each one takes a downlink slot
+// from the network's gateways; so one uplink in N is confirmed, N between
+// CONFIRM_MIN_EVERY and CONFIRM_MAX_EVERY:
+// - in a grid cell with CONFIRM_SETTLED confirmed uplinks, from the cell's
+//   ack rate r: N = MIN + (MAX - MIN) r^2, so a cell that always acks is
+//   confirmed rarely and a patchy one often;
+// - in a cell with fewer (a new place), N = CONFIRM_NOVEL_EVERY;
+// - without a position, from the ack rate over all cells.
+// After a confirmed uplink that got no ack, the next confirmation comes
+// after 1, 2, 4... uplinks (doubling per miss up to CONFIRM_MAX_EVERY), so
+// a dead spot settles at the longest interval. The missed frame itself is
+// not sent again: the next status uplink is newer anyway.
+//
+// Cells are the data-rate survey's (dr_survey.h), in a table of
+// CONFIRM_MAX_CELLS; the least recently visited cell makes room for a new
+// one. The state is in RTC memory, so the deep-sleep sample cycle keeps
+// counting across wakes; a power-on clears it.
+
+#ifndef CONFIRM_POLICY_ENABLED
+#define CONFIRM_POLICY_ENABLED  1       // Else every status uplink is unconfirmed (see `confirm` command)
+#endif
+#define CONFIRM_MIN_EVERY       4
+#define CONFIRM_MAX_EVERY       32
+#define CONFIRM_NOVEL_EVERY     8
+#define CONFIRM_SETTLED         3       // Confirmed uplinks before a cell's own ack rate counts
+#define CONFIRM_MAX_CELLS       64      // 2 KB of RTC memory
+#define CONFIRM_RATE_WEIGHT     0.125f  // Weight of one outcome in the overall ack rate
+
+enum ConfirmReason {
+    CONFIRM_NONE = 0,           // Unconfirmed
+    CONFIRM_INTERVAL,           // N uplinks since the last confirmed one
+    CONFIRM_NOVEL,              // ... with N for a new cell
+    CONFIRM_RETRY,              // Backing off after a missed ack
+    CONFIRM_REASON_COUNT
+};
+
+struct ConfirmCell {
+    int32_t latitudeIndex;      // As DrSurveyCell
+    int32_t longitudeIndex;
+    uint16_t confirmed;
+    uint16_t acked;
+    uint16_t acksRx1;           // Acks per receive window
+    uint16_t acksRx2;
+    int32_t rssiSum;            // Over the acks, dBm
+    int32_t snrDeciSum;
+    int16_t rssiMin;
+    uint32_t lastUplink;        // Uplink count at the last visit
+};
+
+struct ConfirmStats {
+    bool enabled;
+    uint32_t uplinks;           // On air while the policy decided
+    uint32_t sent[CONFIRM_REASON_COUNT];    // Per reason, [CONFIRM_NONE] the unconfirmed ones
+    uint32_t acked;
+    uint32_t acksRx1;
+    uint32_t acksRx2;
+    uint32_t unplaced;          // Confirmed without a position: totals only
+    uint32_t replaced;          // Cells dropped for new ones
+    uint16_t sinceConfirmed;    // Uplinks since the last confirmed one
+    uint8_t misses;             // Confirmed uplinks in a row without an ack
+    uint8_t every;              // N at the last check
+    float ackRate;              // Moving average over all confirmed uplinks
+};
+
+// Clears the state on power-on; after a deep-sleep wake it carries on
+void confirmPolicyBegin();
+void confirmPolicySetEnabled(bool enable);
+
+// Whether the next uplink, sent from here, asks for an ack, and why
+ConfirmReason confirmPolicyCheck(bool hasPosition, int32_t latitudeE7, int32_t longitudeE7);
+
+// An uplink that went on air with what confirmPolicyCheck() said; for a
+// confirmed one whether it was acked, the ack's signal and receive window
+// (1 or 2)
+void confirmPolicyRecord(ConfirmReason reason, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7, bool acked,
+                         int16_t rssi, int16_t snrDeci, uint8_t rxWindow);
+
+const ConfirmStats& confirmPolicyStats();
+size_t confirmPolicyCellCount();
+const ConfirmCell& confirmPolicyCell(size_t index);
+const char* confirmReasonName(ConfirmReason reason);
+
+// Confirmations per reason, acks per window, and ack rate and signal per cell
+void confirmPolicyPrintReport();
+
+#endif // CONFIRM_POLICY_H
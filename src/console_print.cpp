@@ -0,0 +1,20 @@
+#include "console_print.h"
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+size_t consolePrintf(const char* format, ...) {
+    char line[CONSOLE_LINE_MAX + 1];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length > CONSOLE_LINE_MAX) {
+        length = CONSOLE_LINE_MAX;
+        size_t formatLength = strlen(format);
+        if (formatLength > 0 && format[formatLength - 1] == '\n') line[length - 1] = '\n';
+    }
+    return Serial.write((const uint8_t*)line, (size_t)length);
+}
@@ -0,0 +1,16 @@
+#ifndef CONSOLE_PRINT_H
+#define CONSOLE_PRINT_H
+
+#include <stddef.h>
+
+// Formatted console output without the heap. The ESP32 core's
+// Print::printf formats into a 64-byte stack buffer and mallocs for
+// anything longer, which most log lines are; consolePrintf() formats on the
+// stack up to CONSOLE_LINE_MAX and writes to Serial. A longer line is cut
+// off, keeping its final newline.
+
+#define CONSOLE_LINE_MAX    256
+
+size_t consolePrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#endif // CONSOLE_PRINT_H
@@ -0,0 +1,275 @@
+#include "cpu_load.h"
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_freertos_hooks.h>
+#else
+#include <time.h>
+#endif
+
+static const char* SUBSYSTEM_NAMES[CPU_SUBSYSTEM_COUNT] = {
+    "main",
+    "gps",
+    "lora",
+    "display",
+    "logging",
+    "serial"
+};
+
+static CpuLoadReport report;
+
+float CpuLoadReport::totalLoad() const {
+    if (coreCount == 0) return 0.0f;
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < coreCount; i++) sum += coreLoad[i];
+    return sum / coreCount;
+}
+
+CpuSubsystem CpuLoadReport::busiestSubsystem() const {
+    int busiest = CPU_MAIN;
+    for (int i = 1; i < CPU_SUBSYSTEM_COUNT; i++) {
+        if (subsystemLoad[i] > subsystemLoad[busiest]) busiest = i;
+    }
+    return (CpuSubsystem)busiest;
+}
+
+const CpuLoadReport& cpuLoadReport() {
+    return report;
+}
+
+const char* cpuSubsystemName(CpuSubsystem subsystem) {
+    if (subsystem < 0 || subsystem >= CPU_SUBSYSTEM_COUNT) return "?";
+    return SUBSYSTEM_NAMES[subsystem];
+}
+
+// Keeps report.tasks sorted busiest first, dropping the least busy when full
+static void insertTask(const char* name, uint8_t core, float load) {
+    if (load <= 0.0f) return;
+    int position = report.taskCount;
+    while (position > 0 && report.tasks[position - 1].load < load) position--;
+    if (position >= CPU_LOAD_MAX_TASKS) return;
+
+    int last = report.taskCount < CPU_LOAD_MAX_TASKS ? report.taskCount : CPU_LOAD_MAX_TASKS - 1;
+    for (int i = last; i > position; i--) report.tasks[i] = report.tasks[i - 1];
+    strncpy(report.tasks[position].name, name, CPU_LOAD_TASK_NAME_LEN - 1);
+    report.tasks[position].name[CPU_LOAD_TASK_NAME_LEN - 1] = '\0';
+    report.tasks[position].core = core;
+    report.tasks[position].load = load;
+    if (report.taskCount < CPU_LOAD_MAX_TASKS) report.taskCount++;
+}
+
+#if defined(ARDUINO)
+
+#define CPU_CORE_COUNT  portNUM_PROCESSORS
+
+// Each table is only written by its own core's tick interrupt
+struct TaskSlot {
+    TaskHandle_t volatile handle;
+    char name[CPU_LOAD_TASK_NAME_LEN];
+    volatile uint32_t ticks;
+    uint32_t previousTicks;
+};
+
+struct CoreSamples {
+    volatile uint32_t ticks;
+    volatile uint32_t idleTicks;
+    volatile uint32_t untrackedTicks;   // Tasks beyond the slot table
+    TaskSlot slots[CPU_LOAD_MAX_TASKS];
+    uint32_t previousTicks;
+    uint32_t previousIdleTicks;
+    uint32_t previousUntrackedTicks;
+};
+
+static CoreSamples cores[CPU_CORE_COUNT];
+static TaskHandle_t idleTasks[CPU_CORE_COUNT];
+static TaskHandle_t loopTask = nullptr;
+static volatile uint8_t loopSubsystem = CPU_MAIN;
+static volatile uint32_t subsystemTicks[CPU_SUBSYSTEM_COUNT];
+static uint32_t previousSubsystemTicks[CPU_SUBSYSTEM_COUNT];
+static uint32_t windowStartMs = 0;
+static bool initialized = false;
+
+static void IRAM_ATTR sampleTick(int core) {
+    CoreSamples& samples = cores[core];
+    samples.ticks++;
+
+    TaskHandle_t current = xTaskGetCurrentTaskHandleForCPU(core);
+    if (current == idleTasks[core]) {
+        samples.idleTicks++;
+        return;
+    }
+    if (current == loopTask) subsystemTicks[loopSubsystem]++;
+
+    for (int i = 0; i < CPU_LOAD_MAX_TASKS; i++) {
+        TaskSlot& slot = samples.slots[i];
+        if (slot.handle == current) {
+            slot.ticks++;
+            return;
+        }
+        if (slot.handle == nullptr) {
+            strncpy(slot.name, pcTaskGetName(current), CPU_LOAD_TASK_NAME_LEN - 1);
+            slot.name[CPU_LOAD_TASK_NAME_LEN - 1] = '\0';
+            slot.ticks = 1;
+            slot.handle = current;
+            return;
+        }
+    }
+    samples.untrackedTicks++;
+}
+
+static void IRAM_ATTR sampleTickCore0() {
+    sampleTick(0);
+}
+
+#if CPU_CORE_COUNT > 1
+static void IRAM_ATTR sampleTickCore1() {
+    sampleTick(1);
+}
+#endif
+
+void cpuLoadInitialize() {
+    if (initialized) return;
+
+    loopTask = xTaskGetCurrentTaskHandle();
+    for (int core = 0; core < CPU_CORE_COUNT; core++) {
+        idleTasks[core] = xTaskGetIdleTaskHandleForCPU(core);
+    }
+
+    bool hooked = esp_register_freertos_tick_hook_for_cpu(sampleTickCore0, 0) == ESP_OK;
+#if CPU_CORE_COUNT > 1
+    hooked = hooked && esp_register_freertos_tick_hook_for_cpu(sampleTickCore1, 1) == ESP_OK;
+#endif
+    if (!hooked) {
+        Serial.println("[MAIN] [CPU] Failed to register tick hooks, CPU load unavailable");
+        return;
+    }
+
+    windowStartMs = millis();
+    initialized = true;
+}
+
+CpuSubsystem cpuLoadEnter(CpuSubsystem subsystem) {
+    CpuSubsystem previous = (CpuSubsystem)loopSubsystem;
+    loopSubsystem = (uint8_t)subsystem;
+    return previous;
+}
+
+void cpuLoadUpdate() {
+    if (!initialized) return;
+    uint32_t now = millis();
+    if (now - windowStartMs < CPU_LOAD_WINDOW_MS) return;
+
+    report.windowMs = now - windowStartMs;
+    report.coreCount = CPU_CORE_COUNT < CPU_LOAD_MAX_CORES ? CPU_CORE_COUNT : CPU_LOAD_MAX_CORES;
+    report.taskCount = 0;
+    windowStartMs = now;
+
+    uint32_t windowTicks = 0;
+    for (int core = 0; core < CPU_CORE_COUNT; core++) {
+        CoreSamples& samples = cores[core];
+        uint32_t ticks = samples.ticks;
+        uint32_t idle = samples.idleTicks;
+        uint32_t untracked = samples.untrackedTicks;
+        uint32_t deltaTicks = ticks - samples.previousTicks;
+        uint32_t deltaIdle = idle - samples.previousIdleTicks;
+        uint32_t deltaUntracked = untracked - samples.previousUntrackedTicks;
+        samples.previousTicks = ticks;
+        samples.previousIdleTicks = idle;
+        samples.previousUntrackedTicks = untracked;
+        if (deltaTicks > windowTicks) windowTicks = deltaTicks;
+
+        if (core < CPU_LOAD_MAX_CORES) {
+            report.coreLoad[core] = deltaTicks ? 100.0f * (deltaTicks - deltaIdle) / deltaTicks : 0.0f;
+        }
+        if (deltaTicks == 0) continue;
+
+        for (int i = 0; i < CPU_LOAD_MAX_TASKS; i++) {
+            TaskSlot& slot = samples.slots[i];
+            if (slot.handle == nullptr) break;
+            uint32_t slotTicks = slot.ticks;
+            insertTask(slot.name, core, 100.0f * (slotTicks - slot.previousTicks) / deltaTicks);
+            slot.previousTicks = slotTicks;
+        }
+        insertTask("(other)", core, 100.0f * deltaUntracked / deltaTicks);
+    }
+
+    for (int i = 0; i < CPU_SUBSYSTEM_COUNT; i++) {
+        uint32_t ticks = subsystemTicks[i];
+        report.subsystemLoad[i] = windowTicks ? 100.0f * (ticks - previousSubsystemTicks[i]) / windowTicks : 0.0f;
+        previousSubsystemTicks[i] = ticks;
+    }
+    report.valid = true;
+}
+
+#else
+
+static uint64_t clockNs(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Subsystems are charged the CPU time of the thread that tags them
+static CpuSubsystem loopSubsystem = CPU_MAIN;
+static uint64_t subsystemNs[CPU_SUBSYSTEM_COUNT];
+static uint64_t previousSubsystemNs[CPU_SUBSYSTEM_COUNT];
+static uint64_t lastSwitchNs = 0;
+static uint64_t windowStartNs = 0;
+static uint64_t windowStartProcessNs = 0;
+static uint64_t windowStartThreadNs = 0;
+static bool initialized = false;
+
+static void chargeCurrent() {
+    uint64_t now = clockNs(CLOCK_THREAD_CPUTIME_ID);
+    subsystemNs[loopSubsystem] += now - lastSwitchNs;
+    lastSwitchNs = now;
+}
+
+void cpuLoadInitialize() {
+    if (initialized) return;
+    lastSwitchNs = clockNs(CLOCK_THREAD_CPUTIME_ID);
+    windowStartThreadNs = lastSwitchNs;
+    windowStartProcessNs = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+    windowStartNs = clockNs(CLOCK_MONOTONIC);
+    initialized = true;
+}
+
+CpuSubsystem cpuLoadEnter(CpuSubsystem subsystem) {
+    CpuSubsystem previous = loopSubsystem;
+    if (initialized) chargeCurrent();
+    loopSubsystem = subsystem;
+    return previous;
+}
+
+// Wall time is real time, so a simulation running ahead of its virtual
+// clock still reports what it costs the host
+void cpuLoadUpdate() {
+    if (!initialized) return;
+    uint64_t now = clockNs(CLOCK_MONOTONIC);
+    uint64_t windowNs = now - windowStartNs;
+    if (windowNs < (uint64_t)CPU_LOAD_WINDOW_MS * 1000000ULL) return;
+
+    chargeCurrent();
+    uint64_t processNs = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t threadNs = lastSwitchNs;
+
+    report.windowMs = (uint32_t)(windowNs / 1000000ULL);
+    report.coreCount = 1;
+    report.coreLoad[0] = 100.0f * (float)(processNs - windowStartProcessNs) / (float)windowNs;
+    for (int i = 0; i < CPU_SUBSYSTEM_COUNT; i++) {
+        report.subsystemLoad[i] = 100.0f * (float)(subsystemNs[i] - previousSubsystemNs[i]) / (float)windowNs;
+        previousSubsystemNs[i] = subsystemNs[i];
+    }
+    report.taskCount = 0;
+    insertTask("loop", 0, 100.0f * (float)(threadNs - windowStartThreadNs) / (float)windowNs);
+
+    windowStartNs = now;
+    windowStartProcessNs = processNs;
+    windowStartThreadNs = threadNs;
+    report.valid = true;
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CPU load per core, per FreeRTOS task and per firmware subsystem.
+//
+// On the ESP32-S3 a FreeRTOS tick hook on each core samples what was running
+// when the 1 kHz tick fired: the idle task, another task, or the Arduino loop
+// task tagged with the subsystem it is currently in (CpuScope). Sampling
+// works with the stock Arduino sdkconfig, which has no run-time stats. Bursts
+// shorter than a tick that always end before the next one are not seen.
+//
+// On the host (native simulation) the same report comes from thread and
+// process CPU clocks: subsystems are charged the calling thread's CPU time,
+// and the single "core" is process CPU time over wall time.
+
+#define CPU_LOAD_WINDOW_MS      2000    // Report covers the last completed window
+#define CPU_LOAD_MAX_CORES      2
+#define CPU_LOAD_MAX_TASKS      12
+#define CPU_LOAD_TASK_NAME_LEN  16
+
+enum CpuSubsystem {
+    CPU_MAIN = 0,           // Loop task outside any tagged scope
+    CPU_GPS,
+    CPU_LORA,
+    CPU_DISPLAY,
+    CPU_LOGGING,
+    CPU_SERIAL,
+    CPU_SUBSYSTEM_COUNT
+};
+
+struct CpuTaskLoad {
+    char name[CPU_LOAD_TASK_NAME_LEN];
+    uint8_t core;
+    float load;             // Percent of one core
+};
+
+struct CpuLoadReport {
+    bool valid;                                 // False until the first window completes
+    uint32_t windowMs;
+    uint8_t coreCount;
+    float coreLoad[CPU_LOAD_MAX_CORES];         // Percent busy per core
+    float subsystemLoad[CPU_SUBSYSTEM_COUNT];   // Percent of one core
+    uint8_t taskCount;
+    CpuTaskLoad tasks[CPU_LOAD_MAX_TASKS];      // Busiest first, idle tasks excluded
+
+    CpuLoadReport() : valid(false), windowMs(0), coreCount(0), coreLoad(), subsystemLoad(), taskCount(0), tasks() {}
+
+    float totalLoad() const;                    // Mean over cores
+    CpuSubsystem busiestSubsystem() const;
+};
+
+// Call once from the loop task (setup) before anything is tagged
+void cpuLoadInitialize();
+
+// Closes the window when due; cheap enough to call every loop pass
+void cpuLoadUpdate();
+
+const CpuLoadReport& cpuLoadReport();
+const char* cpuSubsystemName(CpuSubsystem subsystem);
+
+// Re-tags the calling (loop) task and returns the previous tag
+CpuSubsystem cpuLoadEnter(CpuSubsystem subsystem);
+
+class CpuScope {
+private:
+    CpuSubsystem previous;
+
+public:
+    explicit CpuScope(CpuSubsystem subsystem) : previous(cpuLoadEnter(subsystem)) {}
+    ~CpuScope() { cpuLoadEnter(previous); }
+};
+
+#define CPU_CONCAT_INNER(a, b) a##b
+#define CPU_CONCAT(a, b) CPU_CONCAT_INNER(a, b)
+#define CPU_SCOPE(subsystem) CpuScope CPU_CONCAT(cpuScope_, __LINE__)(subsystem)
+
+#endif // CPU_LOAD_H
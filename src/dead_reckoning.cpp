@@ -0,0 +1,127 @@
+#include "dead_reckoning.h"
+
+// sin() for 0..90 degrees in 1 degree steps, Q15
+static const int16_t SIN_TABLE_Q15[91] = {
+    0, 572, 1144, 1715, 2286, 2856, 3425, 3993, 4560, 5126,
+    5690, 6252, 6813, 7371, 7927, 8481, 9032, 9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14364, 14876, 15383, 15886,
+    16383, 16876, 17364, 17846, 18323, 18794, 19260, 19720, 20173, 20621,
+    21062, 21497, 21925, 22347, 22762, 23170, 23571, 23964, 24351, 24730,
+    25101, 25465, 25821, 26169, 26509, 26841, 27165, 27481, 27788, 28087,
+    28377, 28659, 28932, 29196, 29451, 29697, 29934, 30162, 30381, 30591,
+    30791, 30982, 31163, 31335, 31498, 31650, 31794, 31927, 32051, 32165,
+    32269, 32364, 32448, 32523, 32587, 32642, 32687, 32722, 32747, 32762,
+    32767
+};
+
+// 1 mm of northing in 1e-7 degrees of latitude, Q16 (1e7 / 111319490 * 65536)
+static const int64_t LAT_E7_PER_MM_Q16 = 5887;
+
+static const int64_t E7_FULL_CIRCLE = 3600000000LL;
+static const int64_t E7_HALF_CIRCLE = 1800000000LL;
+
+DeadReckoning::DeadReckoning() {
+    reset();
+}
+
+void DeadReckoning::reset() {
+    fixLatitudeE7 = 0;
+    fixLongitudeE7 = 0;
+    fixTimeMs = 0;
+    fixAccuracyMm = 0;
+    velocityNorthMmS = 0;
+    velocityEastMmS = 0;
+    speedMmS = 0;
+    cosLatitudeQ15 = 32767;
+    hasFix = false;
+}
+
+int32_t DeadReckoning::sinQ15(int32_t angleCdeg) {
+    // Normalise to 0..35999 centidegrees
+    angleCdeg %= 36000;
+    if (angleCdeg < 0) angleCdeg += 36000;
+
+    int32_t sign = 1;
+    if (angleCdeg >= 18000) {
+        angleCdeg -= 18000;
+        sign = -1;
+    }
+    if (angleCdeg > 9000) {
+        angleCdeg = 18000 - angleCdeg;
+    }
+
+    // Linear interpolation between whole degrees
+    int32_t index = angleCdeg / 100;
+    int32_t fraction = angleCdeg % 100;
+    int32_t value = SIN_TABLE_Q15[index];
+    if (fraction != 0) {
+        value += ((SIN_TABLE_Q15[index + 1] - value) * fraction) / 100;
+    }
+    return sign * value;
+}
+
+int32_t DeadReckoning::cosQ15(int32_t angleCdeg) {
+    return sinQ15(angleCdeg + 9000);
+}
+
+void DeadReckoning::addFix(uint32_t timeMs, int32_t latitudeE7, int32_t longitudeE7,
+                           uint32_t newSpeedMmS, uint32_t courseCdeg, uint32_t hdopCenti) {
+    int32_t newNorth = 0;
+    int32_t newEast = 0;
+    if (newSpeedMmS >= DR_MIN_SPEED_MM_S) {
+        // Course is clockwise from north: north = v*cos, east = v*sin
+        newNorth = (int32_t)(((int64_t)newSpeedMmS * cosQ15(courseCdeg)) >> 15);
+        newEast = (int32_t)(((int64_t)newSpeedMmS * sinQ15(courseCdeg)) >> 15);
+    }
+
+    // Light smoothing between closely spaced fixes; a stale velocity is replaced outright
+    if (hasFix && (uint32_t)(timeMs - fixTimeMs) <= 2000) {
+        velocityNorthMmS = (velocityNorthMmS + 3 * newNorth) / 4;
+        velocityEastMmS = (velocityEastMmS + 3 * newEast) / 4;
+    } else {
+        velocityNorthMmS = newNorth;
+        velocityEastMmS = newEast;
+    }
+
+    fixLatitudeE7 = latitudeE7;
+    fixLongitudeE7 = longitudeE7;
+    fixTimeMs = timeMs;
+    fixAccuracyMm = (uint32_t)(((uint64_t)hdopCenti * DR_UERE_MM) / 100);
+    speedMmS = newSpeedMmS;
+
+    // Latitude in centidegrees for the longitude scale factor
+    cosLatitudeQ15 = cosQ15(latitudeE7 / 100000);
+    if (cosLatitudeQ15 < 1) cosLatitudeQ15 = 1;
+
+    hasFix = true;
+}
+
+bool DeadReckoning::estimate(uint32_t nowMs, PositionEstimate& out) const {
+    if (!hasFix) return false;
+
+    uint32_t ageMs = nowMs - fixTimeMs;
+    if (ageMs > DR_MAX_EXTRAPOLATION_MS) return false;
+
+    // Displacement since the fix in millimetres
+    int64_t northMm = ((int64_t)velocityNorthMmS * ageMs) / 1000;
+    int64_t eastMm = ((int64_t)velocityEastMmS * ageMs) / 1000;
+
+    int64_t latitude = fixLatitudeE7 + ((northMm * LAT_E7_PER_MM_Q16) >> 16);
+    int64_t longitude = fixLongitudeE7 + ((eastMm * LAT_E7_PER_MM_Q16 * 32768) / cosLatitudeQ15 >> 16);
+    if (longitude > E7_HALF_CIRCLE) longitude -= E7_FULL_CIRCLE;
+    if (longitude < -E7_HALF_CIRCLE) longitude += E7_FULL_CIRCLE;
+
+    // Uncertainty grows linearly with velocity error and quadratically with
+    // unobserved acceleration
+    uint64_t velocityErrorMmS = (speedMmS >> DR_SPEED_ERROR_SHIFT) + DR_SPEED_ERROR_MM_S;
+    uint64_t accuracy = fixAccuracyMm
+                      + (velocityErrorMmS * ageMs) / 1000
+                      + ((uint64_t)DR_MAX_ACCEL_MM_S2 * ageMs * ageMs) / 2000000;
+    if (accuracy > 0xFFFFFFFFULL) accuracy = 0xFFFFFFFFULL;
+
+    out.latitudeE7 = (int32_t)latitude;
+    out.longitudeE7 = (int32_t)longitude;
+    out.accuracyMm = (uint32_t)accuracy;
+    out.ageMs = ageMs;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef DEAD_RECKONING_H
+#define DEAD_RECKONING_H
+
+#include <stdint.h>
+
+// Dead reckoning configuration constants
+#define DR_MAX_EXTRAPOLATION_MS 60000   // Give up on a position 60 s after the last fix
+#define DR_MIN_SPEED_MM_S       300     // Below ~1 km/h GPS course is noise, treat as stationary
+#define DR_UERE_MM              5000    // Range error per unit of HDOP (5 m)
+#define DR_SPEED_ERROR_SHIFT    3       // Velocity uncertainty is speed/8 ...
+#define DR_SPEED_ERROR_MM_S     500     // ... plus 0.5 m/s
+#define DR_MAX_ACCEL_MM_S2      300     // Worst-case unobserved acceleration (0.3 m/s^2)
+
+// Fixed-point position estimate (1e-7 degrees, millimetres)
+struct PositionEstimate {
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+    uint32_t accuracyMm;    // Uncertainty radius
+    uint32_t ageMs;         // Time since the fix the estimate is propagated from
+
+    PositionEstimate() : latitudeE7(0), longitudeE7(0), accuracyMm(0), ageMs(0) {}
+};
+
+// Constant-velocity / constant-heading estimator used to bridge GPS outages.
+// Everything is integer math so an update costs a handful of multiplies on
+// the ESP32-S3 and the same code runs on the host benchmark.
+class DeadReckoning {
+private:
+    int32_t fixLatitudeE7;
+    int32_t fixLongitudeE7;
+    uint32_t fixTimeMs;
+    uint32_t fixAccuracyMm;
+    int32_t velocityNorthMmS;
+    int32_t velocityEastMmS;
+    uint32_t speedMmS;
+    int32_t cosLatitudeQ15;
+    bool hasFix;
+
+public:
+    DeadReckoning();
+
+    void reset();
+    void addFix(uint32_t timeMs, int32_t latitudeE7, int32_t longitudeE7,
+                uint32_t speedMmS, uint32_t courseCdeg, uint32_t hdopCenti);
+    bool estimate(uint32_t nowMs, PositionEstimate& out) const;
+
+    bool isValid() const { return hasFix; }
+    uint32_t getLastFixTime() const { return fixTimeMs; }
+
+    // Q15 trigonometry on centidegrees, shared with the host tools
+    static int32_t sinQ15(int32_t angleCdeg);
+    static int32_t cosQ15(int32_t angleCdeg);
+};
+
+#endif // DEAD_RECKONING_H
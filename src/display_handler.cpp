@@ -1,11 +1,24 @@
 #include "display_handler.h"
+#include "console_print.h"
+#include "perf_stats.h"
+#include "energy_ledger.h"
+#include "power_manager.h"
+#include <esp_attr.h>
+
+static const char* POWER_STATE_NAMES[DISPLAY_POWER_STATE_COUNT] = {"on", "dimmed", "asleep", "off"};
+
+// The page shown survives deep sleep, so a button wake comes back to it
+RTC_DATA_ATTR static uint8_t retainedPage = PAGE_STATUS;
 
 DisplayHandler::DisplayHandler() : display(TFT_CS, TFT_DC, TFT_MOSI, TFT_SCLK, TFT_RST),
                                   currentPage(PAGE_STATUS), 
                                   lastUpdate(0), lastPageSwitch(0), initialized(false),
+                                  powered(false), poweredAtMs(0),
+                                  powerState(DISPLAY_POWER_ON), stateSinceMs(0), lastActivityMs(0),
+                                  idleTimeoutMs(DISPLAY_IDLE_TIMEOUT_MS), brightness(0), powerStats(),
                                   gpsFixed(false), gpsSatellites(0), gpsLatitude(0.0), gpsLongitude(0.0),
                                   loraJoined(false), loraRssi(0), loraSnr(0.0), loraStatus("Disconnected"),
-                                  systemUptime(0), systemFreeHeap(0), systemCpuUsage(0.0), 
+                                  systemUptime(0), systemFreeHeap(0), systemCpuLoad("--"), 
                                   systemBatteryVoltage(0.0), systemBatteryPercentage(0) {
     Serial.println(F("[Display] Handler created for Heltec Wireless Tracker V1.1"));
 }
@@ -14,33 +27,21 @@ DisplayHandler::~DisplayHandler() {
     Serial.println(F("[Display] Handler destroyed"));
 }
 
-void DisplayHandler::controlBacklight(bool state) {
-    pinMode(TFT_BLK, OUTPUT);
-    digitalWrite(TFT_BLK, state ? HIGH : LOW);
-    Serial.printf("[Display] Backlight %s\n", state ? "ON" : "OFF");
+void DisplayHandler::setBacklight(uint8_t level) {
+    if (level == brightness) return;
+    ledcWrite(DISPLAY_BACKLIGHT_CHANNEL, level);
+    brightness = level;
+    energySetBacklightLevel(level / (float)DISPLAY_BRIGHTNESS_FULL);
+    consolePrintf("[Display] Backlight %u/%u\n", level, DISPLAY_BRIGHTNESS_FULL);
 }
 
-bool DisplayHandler::initialize() {
-    Serial.println(F("[Display] Initializing TFT LCD display..."));
-
-    // Power up VEXT and VTFT for display
-    pinMode(VEXT_PIN, OUTPUT);
-    digitalWrite(VEXT_PIN, HIGH);
-    Serial.println(F("[Display] VEXT power enabled"));
-    delay(10);
-    pinMode(VTFT_PIN, OUTPUT);
-    digitalWrite(VTFT_PIN, HIGH);
-    Serial.println(F("[Display] VTFT power enabled"));
-    delay(10);
-
-    Serial.printf("[Display] Using pins - CS:%d, DC:%d, MOSI:%d, SCLK:%d, RST:%d, BLK:%d\n", 
-                  TFT_CS, TFT_DC, TFT_MOSI, TFT_SCLK, TFT_RST, TFT_BLK);
-    
-    // Initialize backlight FIRST - this is critical!
-    controlBacklight(true);
-    delay(100);
+// Controller registers from reset; VTFT up for DISPLAY_POWER_SETTLE_MS
+void DisplayHandler::initPanel() {
+    unsigned long sincePowerOn = millis() - poweredAtMs;
+    if (sincePowerOn < DISPLAY_POWER_SETTLE_MS) {
+        delay(DISPLAY_POWER_SETTLE_MS - sincePowerOn);
+    }
     
-    // Initialize the display
     display.initR(INITR_MINI160x80);  // 160x80 pixel display
     
     // Set orientation and colors
@@ -48,6 +49,21 @@ bool DisplayHandler::initialize() {
     display.fillScreen(ST7735_BLACK);
     display.setTextColor(ST7735_WHITE);
     display.setTextSize(1);
+}
+
+bool DisplayHandler::initialize() {
+    Serial.println(F("[Display] Initializing TFT LCD display..."));
+
+    // Power up VEXT, VTFT and the backlight, unless the boot already did
+    if (!powered) {
+        enableDisplayPower();
+    }
+
+    consolePrintf("[Display] Using pins - CS:%d, DC:%d, MOSI:%d, SCLK:%d, RST:%d, BLK:%d\n", 
+                  TFT_CS, TFT_DC, TFT_MOSI, TFT_SCLK, TFT_RST, TFT_BLK);
+    
+    // Initialize the display
+    initPanel();
     
     // Test display with simple message
     display.setCursor(10, 10);
@@ -56,6 +72,12 @@ bool DisplayHandler::initialize() {
     display.println("Display Ready!");
     
     initialized = true;
+    currentPage = retainedPage < PAGE_COUNT ? (DisplayPage)retainedPage : PAGE_STATUS;
+    powerState = DISPLAY_POWER_ON;
+    powerStats = DisplayPowerStats();
+    stateSinceMs = millis();
+    lastActivityMs = stateSinceMs;
+    setBacklight(DISPLAY_BRIGHTNESS_FULL);
     Serial.println(F("[Display] TFT LCD initialized successfully"));
     
     return true;
@@ -63,6 +85,11 @@ bool DisplayHandler::initialize() {
 
 void DisplayHandler::update() {
     if (!initialized) return;
+    PERF_SCOPE(PERF_DISPLAY_UPDATE);
+    
+    // Nothing to draw while the panel is dark; wake() redraws the page
+    updatePower();
+    if (!isLit()) return;
     
     unsigned long currentTime = millis();
     
@@ -74,37 +101,46 @@ void DisplayHandler::update() {
     
     // Update display content every second
     if (currentTime - lastUpdate > DISPLAY_UPDATE_INTERVAL) {
-        display.fillScreen(ST7735_BLACK);
-        
-        switch (currentPage) {
-            case PAGE_STATUS:
-                drawStatusPage();
-                break;
-            case PAGE_GPS:
-                drawGPSPage();
-                break;
-            case PAGE_LORA:
-                drawLoRaPage();
-                break;
-            case PAGE_SYSTEM:
-                drawSystemPage();
-                break;
-        }
-        
+        renderPage(currentPage);
         lastUpdate = currentTime;
-        Serial.printf("[Display] Updated page %d\n", currentPage);
+        consolePrintf("[Display] Updated page %d\n", currentPage);
+    }
+}
+
+// Clears the screen and draws one page from the current system state
+void DisplayHandler::renderPage(DisplayPage page) {
+    if (!isLit()) return;
+    POWER_BURST(POWER_BURST_DISPLAY);
+    display.fillScreen(ST7735_BLACK);
+    
+    switch (page) {
+        case PAGE_STATUS:
+            drawStatusPage();
+            break;
+        case PAGE_GPS:
+            drawGPSPage();
+            break;
+        case PAGE_LORA:
+            drawLoRaPage();
+            break;
+        case PAGE_SYSTEM:
+            drawSystemPage();
+            break;
+        default:
+            break;
     }
 }
 
 void DisplayHandler::nextPage() {
     currentPage = (DisplayPage)((currentPage + 1) % PAGE_COUNT);
-    Serial.printf("[Display] Switched to page %d\n", currentPage);
+    retainedPage = currentPage;
+    consolePrintf("[Display] Switched to page %d\n", currentPage);
 }
 
 void DisplayHandler::showMessage(const char* message) {
-    if (!initialized) return;
+    if (!isLit()) return;
     
-    Serial.printf("[Display] Showing message: %s\n", message);
+    consolePrintf("[Display] Showing message: %s\n", message);
     
     display.fillScreen(ST7735_BLACK);
     display.setTextColor(ST7735_GREEN); // Changed from WHITE to GREEN
@@ -122,12 +158,8 @@ void DisplayHandler::showMessage(const char* message) {
     display.println(message);
 }
 
-void DisplayHandler::showMessage(const String& message) {
-    showMessage(message.c_str());
-}
-
 void DisplayHandler::showSuccess(const char* message) {
-    if (!initialized) return;
+    if (!isLit()) return;
     
     display.fillScreen(ST7735_BLACK);
     display.setTextColor(ST7735_GREEN);
@@ -140,7 +172,7 @@ void DisplayHandler::showSuccess(const char* message) {
 }
 
 void DisplayHandler::showError(const char* message) {
-    if (!initialized) return;
+    if (!isLit()) return;
     
     display.fillScreen(ST7735_BLACK);
     display.setTextColor(ST7735_RED);
@@ -152,10 +184,6 @@ void DisplayHandler::showError(const char* message) {
     display.println(message);
 }
 
-void DisplayHandler::showError(const String& message) {
-    showError(message.c_str());
-}
-
 void DisplayHandler::drawStatusPage() {
     display.setTextColor(ST7735_WHITE);
     display.setTextSize(1);
@@ -230,7 +258,7 @@ void DisplayHandler::drawSystemPage() {
     display.printf("Free RAM: %lu\n", systemFreeHeap);
     
     display.setCursor(0, 45);
-    display.printf("CPU: %.1f%%\n", systemCpuUsage);
+    display.printf("CPU: %s\n", systemCpuLoad.c_str());
     
     display.setCursor(0, 60);
     display.printf("Battery: %.2fV\n", systemBatteryVoltage);
@@ -260,36 +288,168 @@ void DisplayHandler::updateGPSInfo(bool fixed, int satellites, double lat, doubl
     gpsLongitude = lon;
 }
 
-void DisplayHandler::updateLoRaInfo(bool joined, int rssi, float snr, const String& status) {
+void DisplayHandler::updateLoRaInfo(bool joined, int rssi, float snr, const char* status) {
     loraJoined = joined;
     loraRssi = rssi;
     loraSnr = snr;
     loraStatus = status;
 }
 
-void DisplayHandler::updateSystemInfo(unsigned long uptime, unsigned long freeHeap, float cpuUsage, 
+void DisplayHandler::updateSystemInfo(unsigned long uptime, unsigned long freeHeap, const CpuLoadReport& cpuLoad, 
                                      float batteryVoltage, int batteryPercentage) {
     systemUptime = uptime;
     systemFreeHeap = freeHeap;
-    systemCpuUsage = cpuUsage;
+    
+    // "3/15% gps 9%": one figure per core, then the busiest subsystem
+    systemCpuLoad.clear();
+    if (cpuLoad.valid) {
+        for (uint8_t core = 0; core < cpuLoad.coreCount; core++) {
+            systemCpuLoad.appendf(core ? "/%.0f" : "%.0f", cpuLoad.coreLoad[core]);
+        }
+        CpuSubsystem busiest = cpuLoad.busiestSubsystem();
+        systemCpuLoad.appendf("%% %s %.0f%%", cpuSubsystemName(busiest), cpuLoad.subsystemLoad[busiest]);
+    } else {
+        systemCpuLoad = "--";
+    }
     systemBatteryVoltage = batteryVoltage;
     systemBatteryPercentage = batteryPercentage;
 }
 
 void DisplayHandler::printStatus() {
-    Serial.printf("[Display] Status - Page: %d, Initialized: %s\n", 
-                  currentPage, initialized ? "YES" : "NO");
-} 
+    consolePrintf("[Display] Status - Page: %d, Initialized: %s, Power: %s\n", 
+                  currentPage, initialized ? "YES" : "NO", POWER_STATE_NAMES[powerState]);
+}
+
+// One step of the idle policy per state change; the time in the old state
+// goes to the stats
+void DisplayHandler::setPowerState(DisplayPowerState state) {
+    unsigned long now = millis();
+    powerStats.stateMs[powerState] += now - stateSinceMs;
+    stateSinceMs = now;
+    DisplayPowerState previous = powerState;
+    powerState = state;
+    
+    switch (state) {
+        case DISPLAY_POWER_ON:
+            setBacklight(DISPLAY_BRIGHTNESS_FULL);
+            break;
+        case DISPLAY_POWER_DIMMED:
+            setBacklight(DISPLAY_BRIGHTNESS_DIM);
+            powerStats.dims++;
+            break;
+        case DISPLAY_POWER_ASLEEP:
+            setBacklight(0);
+            display.enableDisplay(false);
+            display.enableSleep(true);
+            powerStats.sleeps++;
+            break;
+        case DISPLAY_POWER_OFF:
+            digitalWrite(VTFT_PIN, LOW);
+            powerStats.powerDowns++;
+            break;
+        default:
+            break;
+    }
+    consolePrintf("[Display] Power %s -> %s\n", POWER_STATE_NAMES[previous], POWER_STATE_NAMES[state]);
+}
+
+void DisplayHandler::updatePower() {
+    if (idleTimeoutMs == 0) return;
+    unsigned long now = millis();
+    unsigned long idleMs = now - lastActivityMs;
+    if (powerState == DISPLAY_POWER_ON && idleMs >= idleTimeoutMs / 2) {
+        setPowerState(DISPLAY_POWER_DIMMED);
+    }
+    if (powerState == DISPLAY_POWER_DIMMED && idleMs >= idleTimeoutMs) {
+        setPowerState(DISPLAY_POWER_ASLEEP);
+    }
+    if (powerState == DISPLAY_POWER_ASLEEP && now - stateSinceMs >= DISPLAY_POWER_DOWN_MS) {
+        setPowerState(DISPLAY_POWER_OFF);
+    }
+}
+
+bool DisplayHandler::wake(unsigned long sinceMs) {
+    lastActivityMs = millis();
+    if (!initialized || powerState == DISPLAY_POWER_ON) return false;
+    
+    DisplayPowerState from = powerState;
+    if (from == DISPLAY_POWER_OFF) {
+        // The controller lost its registers with VTFT
+        digitalWrite(VTFT_PIN, HIGH);
+        poweredAtMs = millis();
+        initPanel();
+        powerStats.coldWakes++;
+    } else if (from == DISPLAY_POWER_ASLEEP) {
+        unsigned long asleepMs = millis() - stateSinceMs;
+        if (asleepMs < DISPLAY_SLEEP_SETTLE_MS) {
+            delay(DISPLAY_SLEEP_SETTLE_MS - asleepMs);
+        }
+        display.enableSleep(false);
+        delay(DISPLAY_SLEEP_OUT_MS);
+        display.enableDisplay(true);
+        powerStats.warmWakes++;
+    }
+    
+    // The page comes back from the state kept while dark
+    setPowerState(DISPLAY_POWER_ON);
+    if (from != DISPLAY_POWER_DIMMED) {
+        renderPage(currentPage);
+        lastUpdate = millis();
+        lastPageSwitch = lastUpdate;
+        powerStats.lastWakeMs = millis() - sinceMs;
+    }
+    return true;
+}
+
+void DisplayHandler::setIdleTimeout(uint32_t timeoutMs) {
+    idleTimeoutMs = timeoutMs;
+    wake(millis());
+}
 
-// Optionally, add methods to control VTFT/VEXT
+const DisplayPowerStats& DisplayHandler::getPowerStats() {
+    unsigned long now = millis();
+    powerStats.stateMs[powerState] += now - stateSinceMs;
+    stateSinceMs = now;
+    return powerStats;
+}
+
+void DisplayHandler::printPowerStatus() {
+    const DisplayPowerStats& stats = getPowerStats();
+    consolePrintf("[Display] Power %s, brightness %u/%u, idle timeout %lu s (dimmed after %lu s), power-down after %lu s asleep\n",
+                  POWER_STATE_NAMES[powerState], brightness, DISPLAY_BRIGHTNESS_FULL,
+                  (unsigned long)(idleTimeoutMs / 1000), (unsigned long)(idleTimeoutMs / 2000),
+                  (unsigned long)(DISPLAY_POWER_DOWN_MS / 1000));
+    uint64_t totalMs = 0;
+    for (int i = 0; i < DISPLAY_POWER_STATE_COUNT; i++) totalMs += stats.stateMs[i];
+    Serial.print(F("[Display] Time:"));
+    for (int i = 0; i < DISPLAY_POWER_STATE_COUNT; i++) {
+        consolePrintf(" %s %.1f min (%.1f%%)", POWER_STATE_NAMES[i], stats.stateMs[i] / 60000.0,
+                      totalMs ? 100.0 * stats.stateMs[i] / totalMs : 0.0);
+    }
+    Serial.println();
+    consolePrintf("[Display] %lu dims, %lu sleeps, %lu power-downs; %lu warm and %lu cold wakes, last %lu ms\n",
+                  (unsigned long)stats.dims, (unsigned long)stats.sleeps, (unsigned long)stats.powerDowns,
+                  (unsigned long)stats.warmWakes, (unsigned long)stats.coldWakes, (unsigned long)stats.lastWakeMs);
+}
+
+// VEXT before VTFT; the backlight comes on with the rails - this is critical!
 void DisplayHandler::enableDisplayPower() {
-    pinMode(VTFT_PIN, OUTPUT);
-    digitalWrite(VTFT_PIN, HIGH);
     pinMode(VEXT_PIN, OUTPUT);
     digitalWrite(VEXT_PIN, HIGH);
+    pinMode(VTFT_PIN, OUTPUT);
+    digitalWrite(VTFT_PIN, HIGH);
+    ledcSetup(DISPLAY_BACKLIGHT_CHANNEL, DISPLAY_BACKLIGHT_PWM_HZ, DISPLAY_BACKLIGHT_BITS);
+    ledcAttachPin(TFT_BLK, DISPLAY_BACKLIGHT_CHANNEL);
+    brightness = 0;
+    setBacklight(DISPLAY_BRIGHTNESS_FULL);
+    powered = true;
+    poweredAtMs = millis();
     Serial.println(F("[Display] Display power enabled (VTFT/VEXT)"));
 }
 void DisplayHandler::disableDisplayPower() {
+    setBacklight(0);
+    powered = false;
+    initialized = false;
     digitalWrite(VTFT_PIN, LOW);
     digitalWrite(VEXT_PIN, LOW);
     Serial.println(F("[Display] Display power disabled (VTFT/VEXT)"));
@@ -6,6 +6,8 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7735.h>
 #include "Config.h"
+#include "fixed_string.h"
+#include "cpu_load.h"
 
 // Display dimensions for Heltec Wireless Tracker V1.1
 #ifndef DISPLAY_WIDTH
@@ -17,6 +19,28 @@
 
 // Display update interval
 #define DISPLAY_UPDATE_INTERVAL 1000
+#define DISPLAY_POWER_SETTLE_MS 120     // Rails and backlight on, before the controller is initialized
+#define DISPLAY_SLEEP_SETTLE_MS 120     // ST7735 sleep in to sleep out, and back
+#define DISPLAY_SLEEP_OUT_MS    5       // Sleep out to the first frame
+
+// Backlight PWM (LEDC) and the idle policy: dimmed for the second half of
+// the idle timeout, then the controller sleeps with the backlight off
+// (registers and frame memory kept, so a wake only redraws the page), and
+// after DISPLAY_POWER_DOWN_MS asleep VTFT is switched off (a wake after
+// that initializes the controller again)
+#define DISPLAY_BACKLIGHT_CHANNEL   0
+#define DISPLAY_BACKLIGHT_PWM_HZ    5000
+#define DISPLAY_BACKLIGHT_BITS      8
+#define DISPLAY_BRIGHTNESS_FULL     255
+#ifndef DISPLAY_BRIGHTNESS_DIM
+#define DISPLAY_BRIGHTNESS_DIM      24      // About 10% duty
+#endif
+#ifndef DISPLAY_IDLE_TIMEOUT_MS
+#define DISPLAY_IDLE_TIMEOUT_MS     60000   // 0 = always on
+#endif
+#ifndef DISPLAY_POWER_DOWN_MS
+#define DISPLAY_POWER_DOWN_MS       600000
+#endif
 
 // Display pages
 enum DisplayPage {
@@ -27,6 +51,24 @@ enum DisplayPage {
     PAGE_COUNT = 4
 };
 
+enum DisplayPowerState {
+    DISPLAY_POWER_ON = 0,
+    DISPLAY_POWER_DIMMED,
+    DISPLAY_POWER_ASLEEP,       // Controller asleep, backlight off
+    DISPLAY_POWER_OFF,          // VTFT off
+    DISPLAY_POWER_STATE_COUNT
+};
+
+struct DisplayPowerStats {
+    uint64_t stateMs[DISPLAY_POWER_STATE_COUNT];    // Time in each state since initialize()
+    uint32_t dims;
+    uint32_t sleeps;
+    uint32_t powerDowns;
+    uint32_t warmWakes;         // From sleep: the page redrawn, no initR()
+    uint32_t coldWakes;         // From power-down: initR() again
+    uint32_t lastWakeMs;        // Button press to the page back on screen
+};
+
 class DisplayHandler {
 private:
     Adafruit_ST7735 display;
@@ -34,6 +76,16 @@ private:
     unsigned long lastUpdate;
     unsigned long lastPageSwitch;
     bool initialized;
+    bool powered;
+    unsigned long poweredAtMs;
+    
+    // Power policy
+    DisplayPowerState powerState;
+    unsigned long stateSinceMs;
+    unsigned long lastActivityMs;
+    uint32_t idleTimeoutMs;
+    uint8_t brightness;
+    DisplayPowerStats powerStats;
     
     // System state variables
     bool gpsFixed;
@@ -44,11 +96,11 @@ private:
     bool loraJoined;
     int loraRssi;
     float loraSnr;
-    String loraStatus;
+    FixedString<15> loraStatus;
     
     unsigned long systemUptime;
     unsigned long systemFreeHeap;
-    float systemCpuUsage;
+    FixedString<26> systemCpuLoad;     // Per-core load and busiest subsystem
     float systemBatteryVoltage;
     int systemBatteryPercentage;
     
@@ -60,8 +112,12 @@ private:
     void drawMessage(const char* message);
     void drawCenteredText(const char* text, int y);
     
-    // Backlight control
-    void controlBacklight(bool state);
+    // Backlight PWM duty, 0 = off
+    void setBacklight(uint8_t level);
+    void initPanel();
+    void setPowerState(DisplayPowerState state);
+    void updatePower();
+    bool isLit() const { return initialized && powerState <= DISPLAY_POWER_DIMMED; }
 
 public:
     DisplayHandler();
@@ -69,24 +125,35 @@ public:
     
     bool initialize();
     void update();
+    void renderPage(DisplayPage page);
     void nextPage();
     void showMessage(const char* message);
-    void showMessage(const String& message);
     void showSuccess(const char* message);
     void showError(const char* message);
-    void showError(const String& message);
     
     // System info update methods
     void updateGPSInfo(bool fixed, int satellites, double lat, double lon);
-    void updateLoRaInfo(bool joined, int rssi, float snr, const String& status);
-    void updateSystemInfo(unsigned long uptime, unsigned long freeHeap, float cpuUsage, 
+    void updateLoRaInfo(bool joined, int rssi, float snr, const char* status);
+    void updateSystemInfo(unsigned long uptime, unsigned long freeHeap, const CpuLoadReport& cpuLoad, 
                          float batteryVoltage, int batteryPercentage);
     
     // Status method for main.cpp compatibility
     void printStatus();
     
+    // Idle policy. wake() counts as activity and brings a dimmed, sleeping
+    // or powered-down panel back with the current page; false if it was
+    // fully on already. `sinceMs` is when the user asked (the button press).
+    bool wake(unsigned long sinceMs);
+    void setIdleTimeout(uint32_t timeoutMs);
+    uint32_t getIdleTimeout() const { return idleTimeoutMs; }
+    DisplayPowerState getPowerState() const { return powerState; }
+    const DisplayPowerStats& getPowerStats();
+    void printPowerStatus();
+    
     bool isInitialized() const { return initialized; }
     DisplayPage getCurrentPage() const { return currentPage; }
+    // Rails and backlight; enabled early in the boot, initialize() only
+    // waits out what is left of DISPLAY_POWER_SETTLE_MS
     void enableDisplayPower();
     void disableDisplayPower();
 };
@@ -0,0 +1,140 @@
+#include "dr_survey.h"
+#include "console_print.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const int8_t TX_POWERS[DR_SURVEY_MAX_POWERS] = DR_SURVEY_TX_POWERS;
+
+static DrSurveyStats stats;
+static DrSurveyCell cells[DR_SURVEY_MAX_CELLS];
+static size_t cellCount = 0;
+
+void drSurveyReset(uint8_t powers) {
+    memset(&stats, 0, sizeof(stats));
+    memset(cells, 0, sizeof(cells));
+    cellCount = 0;
+    if (powers < 1) powers = 1;
+    stats.powers = powers > DR_SURVEY_MAX_POWERS ? DR_SURVEY_MAX_POWERS : powers;
+}
+
+DrSurveyStep drSurveyCurrentStep() {
+    DrSurveyStep step;
+    step.dataRate = stats.step % DR_SURVEY_DATA_RATES;
+    step.powerIndex = stats.step / DR_SURVEY_DATA_RATES;
+    step.txPowerDbm = TX_POWERS[step.powerIndex];
+    return step;
+}
+
+void drSurveyAdvance() {
+    stats.stepDeferred = false;
+    if (++stats.step >= DR_SURVEY_DATA_RATES * (stats.powers ? stats.powers : 1)) {
+        stats.step = 0;
+        stats.rounds++;
+    }
+}
+
+int32_t drSurveyCellIndex(int32_t valueE7) {
+    // Rounded down, so the cells either side of the equator or meridian do not merge
+    return valueE7 >= 0 ? valueE7 / DR_SURVEY_CELL_E7 : -((-(int64_t)valueE7 + DR_SURVEY_CELL_E7 - 1) / DR_SURVEY_CELL_E7);
+}
+
+static DrSurveyCell* findCell(int32_t latitudeE7, int32_t longitudeE7) {
+    int32_t latitudeIndex = drSurveyCellIndex(latitudeE7);
+    int32_t longitudeIndex = drSurveyCellIndex(longitudeE7);
+    for (size_t i = 0; i < cellCount; i++) {
+        if (cells[i].latitudeIndex == latitudeIndex && cells[i].longitudeIndex == longitudeIndex) return &cells[i];
+    }
+    if (cellCount >= DR_SURVEY_MAX_CELLS) return nullptr;
+    DrSurveyCell& cell = cells[cellCount++];
+    cell.latitudeIndex = latitudeIndex;
+    cell.longitudeIndex = longitudeIndex;
+    return &cell;
+}
+
+static void count(DrSurveyCounts& counts, bool acked) {
+    if (counts.sent < UINT16_MAX) {
+        counts.sent++;
+        if (acked) counts.acked++;
+    }
+}
+
+void drSurveyRecord(const DrSurveyStep& step, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7, bool acked,
+                    uint32_t airtimeUs, bool compact) {
+    if (step.dataRate >= DR_SURVEY_DATA_RATES || step.powerIndex >= DR_SURVEY_MAX_POWERS) return;
+    count(stats.totals[step.dataRate][step.powerIndex], acked);
+    stats.airtimeUs += airtimeUs;
+    if (compact) stats.compact++;
+
+    DrSurveyCell* cell = hasPosition ? findCell(latitudeE7, longitudeE7) : nullptr;
+    if (cell) {
+        count(cell->counts[step.dataRate][step.powerIndex], acked);
+    } else {
+        stats.unplaced++;
+    }
+}
+
+bool drSurveyCountDeferred() {
+    stats.deferred++;
+    bool again = stats.stepDeferred;
+    stats.stepDeferred = true;
+    return again;
+}
+
+const DrSurveyStats& drSurveyStats() {
+    return stats;
+}
+
+size_t drSurveyCellCount() {
+    return cellCount;
+}
+
+const DrSurveyCell& drSurveyCell(size_t index) {
+    return cells[index < cellCount ? index : 0];
+}
+
+// "DR0 3/5 60%" per data rate, "-" where the step has not been tried there
+static void printCounts(const char* prefix, int8_t txPowerDbm, const DrSurveyCounts* counts) {
+    consolePrintf("[Survey] %s %2d dBm:", prefix, txPowerDbm);
+    for (int dr = 0; dr < DR_SURVEY_DATA_RATES; dr++) {
+        if (counts[dr].sent == 0) {
+            consolePrintf("  DR%d -", dr);
+        } else {
+            consolePrintf("  DR%d %u/%u %3.0f%%", dr, counts[dr].acked, counts[dr].sent,
+                          100.0f * counts[dr].acked / counts[dr].sent);
+        }
+    }
+    Serial.println();
+}
+
+// One line per power level that has been tried in the cell
+static void printTable(const char* prefix, const DrSurveyCounts (&counts)[DR_SURVEY_DATA_RATES][DR_SURVEY_MAX_POWERS]) {
+    for (uint8_t power = 0; power < stats.powers; power++) {
+        DrSurveyCounts column[DR_SURVEY_DATA_RATES];
+        uint32_t sent = 0;
+        for (int dr = 0; dr < DR_SURVEY_DATA_RATES; dr++) {
+            column[dr] = counts[dr][power];
+            sent += column[dr].sent;
+        }
+        if (sent > 0) printCounts(prefix, TX_POWERS[power], column);
+    }
+}
+
+void drSurveyPrintReport() {
+    DrSurveyStep next = drSurveyCurrentStep();
+    consolePrintf("[Survey] %lu rounds, next DR%u at %d dBm; %lu deferred by the airtime budget, %lu compact, "
+                  "%.1f s on air\n",
+                  (unsigned long)stats.rounds, next.dataRate, next.txPowerDbm, (unsigned long)stats.deferred,
+                  (unsigned long)stats.compact, stats.airtimeUs / 1e6);
+    Serial.println(F("[Survey] Reception (acked/sent):"));
+    printTable("all cells       ", stats.totals);
+    for (size_t i = 0; i < cellCount; i++) {
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "%7.3f,%8.3f", cells[i].latitudeIndex * (DR_SURVEY_CELL_E7 / 1e7),
+                 cells[i].longitudeIndex * (DR_SURVEY_CELL_E7 / 1e7));
+        printTable(prefix, cells[i].counts);
+    }
+    if (stats.unplaced > 0) {
+        consolePrintf("[Survey] %lu uplinks without a position or a free cell (totals only)\n",
+                      (unsigned long)stats.unplaced);
+    }
+}
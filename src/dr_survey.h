@@ -0,0 +1,78 @@
+#ifndef DR_SURVEY_H
+#define DR_SURVEY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Reception table of the data-rate survey (LoRaHandler::startSurvey()).
+// The survey rotates its uplinks through DR_SURVEY_DATA_RATES data rates,
+// optionally at each of the first N of DR_SURVEY_TX_POWERS, one schedule
+// step per uplink: DR0..DR3 at the first power, then again at the next.
+// Survey uplinks are confirmed, so the ack is the device's view of whether
+// a gateway heard the uplink; every outcome is counted per step in the
+// grid cell the uplink was sent from.
+//
+// Cells are DR_SURVEY_CELL_E7 (about 110 m north-south) on a side, in a
+// fixed table of DR_SURVEY_MAX_CELLS; uplinks from further cells, or sent
+// without a position, only count towards the totals.
+
+#define DR_SURVEY_DATA_RATES    4           // US915 DR0 (SF10) .. DR3 (SF7), 125 kHz
+#define DR_SURVEY_MAX_POWERS    3
+#define DR_SURVEY_TX_POWERS     {22, 14, 8} // dBm; the first is LORA_TX_POWER_DBM
+#define DR_SURVEY_CELL_E7       10000       // 0.001 degrees
+#define DR_SURVEY_MAX_CELLS     32
+
+struct DrSurveyStep {
+    uint8_t dataRate;
+    uint8_t powerIndex;
+    int8_t txPowerDbm;
+};
+
+struct DrSurveyCounts {
+    uint16_t sent;
+    uint16_t acked;
+};
+
+struct DrSurveyCell {
+    int32_t latitudeIndex;      // Degrees x 1e7 / DR_SURVEY_CELL_E7, rounded down
+    int32_t longitudeIndex;
+    DrSurveyCounts counts[DR_SURVEY_DATA_RATES][DR_SURVEY_MAX_POWERS];
+};
+
+struct DrSurveyStats {
+    uint8_t powers;             // TX power levels in the rotation
+    uint8_t step;               // Next schedule step
+    uint32_t rounds;            // Completed passes through the schedule
+    uint32_t deferred;          // Uplinks held back by the airtime budget
+    bool stepDeferred;          // ... and the next step among them
+    uint32_t compact;           // Sent with the survey payload instead of the status layout
+    uint32_t unplaced;          // Counted in the totals only
+    uint64_t airtimeUs;         // Survey uplinks on air
+    DrSurveyCounts totals[DR_SURVEY_DATA_RATES][DR_SURVEY_MAX_POWERS];
+};
+
+// Cell row or column of a coordinate (degrees x 1e7), rounded down; the
+// confirmed-uplink statistics (confirm_policy.h) use the same grid
+int32_t drSurveyCellIndex(int32_t valueE7);
+
+// Clears the table and starts the schedule at DR0 with 1..DR_SURVEY_MAX_POWERS levels
+void drSurveyReset(uint8_t powers);
+
+// Schedule step the next survey uplink uses; drSurveyAdvance() once it went out
+DrSurveyStep drSurveyCurrentStep();
+void drSurveyAdvance();
+
+// One survey uplink that went on air, and whether the network acked it
+void drSurveyRecord(const DrSurveyStep& step, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7, bool acked,
+                    uint32_t airtimeUs, bool compact);
+// An uplink the airtime budget held back; true if this step was already deferred
+bool drSurveyCountDeferred();
+
+const DrSurveyStats& drSurveyStats();
+size_t drSurveyCellCount();
+const DrSurveyCell& drSurveyCell(size_t index);
+
+// Reception probability per data rate (and power) overall and per cell
+void drSurveyPrintReport();
+
+#endif // DR_SURVEY_H
@@ -0,0 +1,217 @@
+#include "energy_ledger.h"
+#include "cpu_load.h"
+#include "power_manager.h"
+#include <math.h>
+
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+static const char* CONSUMER_NAMES[ENERGY_CONSUMER_COUNT] = {
+    "cpu_active",
+    "cpu_idle",
+    "cpu_sleep",
+    "radio_tx",
+    "radio_rx",
+    "gnss",
+    "backlight",
+    "base"
+};
+
+static const uint16_t CPU_FREQS_MHZ[ENERGY_CPU_FREQ_COUNT] = {80, 160, 240};
+static const float CPU_ACTIVE_MA[ENERGY_CPU_FREQ_COUNT] = {
+    ENERGY_CPU_80_ACTIVE_MA, ENERGY_CPU_160_ACTIVE_MA, ENERGY_CPU_240_ACTIVE_MA};
+static const float CPU_IDLE_MA[ENERGY_CPU_FREQ_COUNT] = {
+    ENERGY_CPU_80_IDLE_MA, ENERGY_CPU_160_IDLE_MA, ENERGY_CPU_240_IDLE_MA};
+
+static const int8_t TX_LEVELS_DBM[ENERGY_TX_LEVEL_COUNT] = {14, 17, 20, 22};
+static const float TX_MA[ENERGY_TX_LEVEL_COUNT] = {
+    ENERGY_TX_14DBM_MA, ENERGY_TX_17DBM_MA, ENERGY_TX_20DBM_MA, ENERGY_TX_22DBM_MA};
+
+#define MAH_PER_MA_US    (1.0 / 3600e6)     // 1 mA for 1 us, in mAh
+
+static EnergyReport ledger;
+static bool consumerOn[ENERGY_CONSUMER_COUNT];
+static float backlightLevel = 1.0f;
+static uint64_t lastSleepAllowedUs = 0;
+static float sleepShare = 0;        // Of the last interval, light sleep allowed
+static uint32_t startMs = 0;
+static uint32_t lastMs = 0;
+static bool initialized = false;
+
+static uint32_t clockMs() {
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+    return millis();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static int cpuFrequencyIndex() {
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+    uint32_t mhz = getCpuFrequencyMhz();
+#else
+    uint32_t mhz = 240;
+#endif
+    if (mhz > 160) return 2;
+    if (mhz > 80) return 1;
+    return 0;
+}
+
+static int txLevelIndex(int8_t powerDbm) {
+    for (int i = 0; i < ENERGY_TX_LEVEL_COUNT; i++) {
+        if (powerDbm <= TX_LEVELS_DBM[i]) return i;
+    }
+    return ENERGY_TX_LEVEL_COUNT - 1;
+}
+
+// Busy share of the last load window; until the first one closes, assume busy
+static float busyShare() {
+    const CpuLoadReport& load = cpuLoadReport();
+    float busy = load.valid ? load.totalLoad() / 100.0f : 1.0f;
+    if (busy < 0.0f) busy = 0.0f;
+    if (busy > 1.0f) busy = 1.0f;
+    return busy;
+}
+
+// Charges the time since the last call to whatever is on now
+static void integrate() {
+    if (!initialized) return;
+    uint32_t now = clockMs();
+    uint64_t elapsedUs = (uint64_t)(uint32_t)(now - lastMs) * 1000ULL;
+    lastMs = now;
+    if (elapsedUs == 0) return;
+
+    float busy = busyShare();
+    uint64_t activeUs = (uint64_t)(elapsedUs * busy);
+    int frequency = cpuFrequencyIndex();
+    ledger.cpuActiveUs[frequency] += activeUs;
+    uint64_t allowedUs = powerSleepAllowedUs();
+    if (allowedUs < lastSleepAllowedUs) lastSleepAllowedUs = 0;     // Power manager restarted
+    sleepShare = (float)(allowedUs - lastSleepAllowedUs) / elapsedUs;
+    if (sleepShare > 1.0f) sleepShare = 1.0f;
+    lastSleepAllowedUs = allowedUs;
+    uint64_t sleepUs = (uint64_t)((elapsedUs - activeUs) * sleepShare);
+    ledger.lightSleepUs += sleepUs;
+    ledger.cpuIdleUs[frequency] += elapsedUs - activeUs - sleepUs;
+
+    if (consumerOn[ENERGY_GNSS]) ledger.gnssUs += elapsedUs;
+    if (consumerOn[ENERGY_BACKLIGHT]) ledger.backlightUs += (uint64_t)(elapsedUs * backlightLevel);
+}
+
+void energyInitialize() {
+    ledger = EnergyReport();
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) consumerOn[i] = false;
+    backlightLevel = 1.0f;
+    lastSleepAllowedUs = powerSleepAllowedUs();
+    sleepShare = 0;
+    startMs = clockMs();
+    lastMs = startMs;
+    initialized = true;
+}
+
+void energyUpdate() {
+    integrate();
+}
+
+void energySetConsumer(EnergyConsumer consumer, bool on) {
+    if (consumer < 0 || consumer >= ENERGY_CONSUMER_COUNT) return;
+    integrate();
+    consumerOn[consumer] = on;
+}
+
+void energySetBacklightLevel(float level) {
+    if (level < 0.0f) level = 0.0f;
+    if (level > 1.0f) level = 1.0f;
+    bool on = level > 0.0f;
+    if (on == consumerOn[ENERGY_BACKLIGHT] && level == backlightLevel) return;
+    integrate();
+    consumerOn[ENERGY_BACKLIGHT] = on;
+    if (on) backlightLevel = level;
+}
+
+void energyRecordTx(uint8_t spreadingFactor, int8_t powerDbm, uint32_t airtimeUs) {
+    int sf = (int)spreadingFactor - ENERGY_SF_MIN;
+    if (sf < 0) sf = 0;
+    if (sf >= ENERGY_SF_COUNT) sf = ENERGY_SF_COUNT - 1;
+    ledger.txUs[sf][txLevelIndex(powerDbm)] += airtimeUs;
+}
+
+void energyRecordRx(uint32_t listenUs) {
+    ledger.rxUs += listenUs;
+}
+
+void energyCountUplink() {
+    ledger.uplinks++;
+}
+
+const EnergyReport& energyReport() {
+    integrate();
+    uint64_t elapsedUs = (uint64_t)(uint32_t)(lastMs - startMs) * 1000ULL;
+    ledger.elapsedMs = (uint32_t)(elapsedUs / 1000);
+
+    double active = 0, idle = 0, tx = 0;
+    for (int i = 0; i < ENERGY_CPU_FREQ_COUNT; i++) {
+        active += ledger.cpuActiveUs[i] * (double)CPU_ACTIVE_MA[i];
+        idle += ledger.cpuIdleUs[i] * (double)CPU_IDLE_MA[i];
+    }
+    for (int sf = 0; sf < ENERGY_SF_COUNT; sf++) {
+        for (int level = 0; level < ENERGY_TX_LEVEL_COUNT; level++) tx += ledger.txUs[sf][level] * (double)TX_MA[level];
+    }
+    ledger.chargeMah[ENERGY_CPU_ACTIVE] = (float)(active * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_CPU_IDLE] = (float)(idle * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_CPU_SLEEP] = (float)(ledger.lightSleepUs * (double)ENERGY_LIGHT_SLEEP_MA * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_RADIO_TX] = (float)(tx * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_RADIO_RX] = (float)(ledger.rxUs * (double)ENERGY_RX_MA * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_GNSS] = (float)(ledger.gnssUs * (double)ENERGY_GNSS_MA * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_BACKLIGHT] =
+        (float)(ledger.backlightUs * (double)ENERGY_BACKLIGHT_MA * MAH_PER_MA_US);
+    ledger.chargeMah[ENERGY_BASE] = (float)(elapsedUs * (double)ENERGY_BASE_MA * MAH_PER_MA_US);
+
+    ledger.totalMah = 0;
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) ledger.totalMah += ledger.chargeMah[i];
+    ledger.meanCurrentMa = elapsedUs ? (float)(ledger.totalMah / (elapsedUs / 3600e6)) : 0.0f;
+    float radioMah = ledger.chargeMah[ENERGY_RADIO_TX] + ledger.chargeMah[ENERGY_RADIO_RX];
+    ledger.mahPerUplink = ledger.uplinks ? ledger.totalMah / ledger.uplinks : 0.0f;
+    ledger.radioMahPerUplink = ledger.uplinks ? radioMah / ledger.uplinks : 0.0f;
+    return ledger;
+}
+
+float energyPresentCurrentMa() {
+    int frequency = cpuFrequencyIndex();
+    float busy = busyShare();
+    float idleMa = sleepShare * ENERGY_LIGHT_SLEEP_MA + (1.0f - sleepShare) * CPU_IDLE_MA[frequency];
+    float ma = busy * CPU_ACTIVE_MA[frequency] + (1.0f - busy) * idleMa + ENERGY_BASE_MA;
+    if (consumerOn[ENERGY_GNSS]) ma += ENERGY_GNSS_MA;
+    if (consumerOn[ENERGY_BACKLIGHT]) ma += ENERGY_BACKLIGHT_MA * backlightLevel;
+    return ma;
+}
+
+const char* energyConsumerName(EnergyConsumer consumer) {
+    if (consumer < 0 || consumer >= ENERGY_CONSUMER_COUNT) return "?";
+    return CONSUMER_NAMES[consumer];
+}
+
+uint16_t energyCpuFrequencyMhz(int index) {
+    return index >= 0 && index < ENERGY_CPU_FREQ_COUNT ? CPU_FREQS_MHZ[index] : 0;
+}
+
+int8_t energyTxLevelDbm(int index) {
+    return index >= 0 && index < ENERGY_TX_LEVEL_COUNT ? TX_LEVELS_DBM[index] : 0;
+}
+
+uint32_t loraSymbolUs(uint8_t spreadingFactor, uint16_t bandwidthKhz) {
+    if (bandwidthKhz == 0) return 0;
+    return (uint32_t)((1000UL << spreadingFactor) / bandwidthKhz);
+}
+
+uint32_t loraAirtimeUs(uint8_t spreadingFactor, uint16_t bandwidthKhz, size_t phyPayloadBytes, bool crc) {
+    double symbolUs = (double)(1UL << spreadingFactor) * 1000.0 / bandwidthKhz;
+    int lowDataRate = symbolUs >= 16000.0 ? 1 : 0;
+    double numerator = 8.0 * phyPayloadBytes - 4.0 * spreadingFactor + 28 + (crc ? 16 : 0);
+    double payloadSymbols = 8 + fmax(ceil(numerator / (4.0 * (spreadingFactor - 2 * lowDataRate))) * 5, 0.0);
+    return (uint32_t)((8 + 4.25 + payloadSymbols) * symbolUs);
+}
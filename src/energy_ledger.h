@@ -0,0 +1,139 @@
+#ifndef ENERGY_LEDGER_H
+#define ENERGY_LEDGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Charge estimate from the time each consumer spends in each power state.
+// Steady consumers are integrated by energyUpdate() (every loop pass) and
+// on every state change: CPU active and idle per clock frequency, taken
+// from the cpu_load.h window (idle time counts as light sleep for the share
+// of the time power_manager.h allowed it), the GNSS receiver and the
+// display backlight.
+// Radio bursts are reported as events: TX airtime per spreading factor and
+// output power, and the time the receive windows stayed open. Charge is
+// time x current from the table below; the defaults are datasheet typicals
+// (ESP32-S3, SX1262, UC6580) and a board measurement can replace any of
+// them with -D in build_flags.
+
+#ifndef ENERGY_CPU_240_ACTIVE_MA
+#define ENERGY_CPU_240_ACTIVE_MA    57.0f
+#endif
+#ifndef ENERGY_CPU_240_IDLE_MA
+#define ENERGY_CPU_240_IDLE_MA      32.0f
+#endif
+#ifndef ENERGY_CPU_160_ACTIVE_MA
+#define ENERGY_CPU_160_ACTIVE_MA    44.0f
+#endif
+#ifndef ENERGY_CPU_160_IDLE_MA
+#define ENERGY_CPU_160_IDLE_MA      27.0f
+#endif
+#ifndef ENERGY_CPU_80_ACTIVE_MA
+#define ENERGY_CPU_80_ACTIVE_MA     32.0f
+#endif
+#ifndef ENERGY_CPU_80_IDLE_MA
+#define ENERGY_CPU_80_IDLE_MA       22.0f
+#endif
+#ifndef ENERGY_LIGHT_SLEEP_MA
+#define ENERGY_LIGHT_SLEEP_MA       0.3f    // SoC in light sleep, CPU powered down
+#endif
+#ifndef ENERGY_TX_14DBM_MA
+#define ENERGY_TX_14DBM_MA          45.0f
+#endif
+#ifndef ENERGY_TX_17DBM_MA
+#define ENERGY_TX_17DBM_MA          58.0f
+#endif
+#ifndef ENERGY_TX_20DBM_MA
+#define ENERGY_TX_20DBM_MA          84.0f
+#endif
+#ifndef ENERGY_TX_22DBM_MA
+#define ENERGY_TX_22DBM_MA          118.0f
+#endif
+#ifndef ENERGY_RX_MA
+#define ENERGY_RX_MA                4.6f
+#endif
+#ifndef ENERGY_GNSS_MA
+#define ENERGY_GNSS_MA              30.0f
+#endif
+#ifndef ENERGY_BACKLIGHT_MA
+#define ENERGY_BACKLIGHT_MA         15.0f
+#endif
+#ifndef ENERGY_BASE_MA
+#define ENERGY_BASE_MA              2.0f    // Regulators, radio standby, panel logic
+#endif
+#ifndef ENERGY_DEEP_SLEEP_MA
+#define ENERGY_DEEP_SLEEP_MA        0.03f   // Board in deep sleep, for sleep_cycle.h: RTC domain, radio asleep, LDO
+#endif
+
+#define ENERGY_CPU_FREQ_COUNT   3       // 80, 160 and 240 MHz; slower clocks count as 80
+#define ENERGY_SF_MIN           7
+#define ENERGY_SF_COUNT         6       // SF7 .. SF12
+#define ENERGY_TX_LEVEL_COUNT   4       // 14, 17, 20, 22 dBm; a power counts at the next level up
+
+enum EnergyConsumer {
+    ENERGY_CPU_ACTIVE = 0,
+    ENERGY_CPU_IDLE,
+    ENERGY_CPU_SLEEP,
+    ENERGY_RADIO_TX,
+    ENERGY_RADIO_RX,
+    ENERGY_GNSS,
+    ENERGY_BACKLIGHT,
+    ENERGY_BASE,
+    ENERGY_CONSUMER_COUNT
+};
+
+struct EnergyReport {
+    uint32_t elapsedMs;                         // Since energyInitialize()
+    uint32_t uplinks;
+    float chargeMah[ENERGY_CONSUMER_COUNT];
+    float totalMah;
+    float meanCurrentMa;                        // = mAh per hour
+    float mahPerUplink;                         // Everything, not just the radio; 0 before the first uplink
+    float radioMahPerUplink;
+    uint64_t cpuActiveUs[ENERGY_CPU_FREQ_COUNT];
+    uint64_t cpuIdleUs[ENERGY_CPU_FREQ_COUNT];
+    uint64_t lightSleepUs;                      // Idle with light sleep allowed
+    uint64_t txUs[ENERGY_SF_COUNT][ENERGY_TX_LEVEL_COUNT];
+    uint64_t rxUs;
+    uint64_t gnssUs;
+    uint64_t backlightUs;                       // At full brightness: dimmed time counts at its duty
+
+    EnergyReport() : elapsedMs(0), uplinks(0), chargeMah(), totalMah(0), meanCurrentMa(0), mahPerUplink(0),
+                     radioMahPerUplink(0), cpuActiveUs(), cpuIdleUs(), lightSleepUs(0), txUs(), rxUs(0), gnssUs(0), backlightUs(0) {}
+};
+
+// Starts the ledger from zero; call once early in setup()
+void energyInitialize();
+
+// Integrates the steady consumers up to now; cheap enough for every loop pass
+void energyUpdate();
+
+// GNSS receiver and backlight power switches
+void energySetConsumer(EnergyConsumer consumer, bool on);
+
+// Backlight PWM duty, 0 (off) to 1; the LED draw scales with it
+void energySetBacklightLevel(float level);
+
+// Radio bursts: airtime of one transmission, receive window time, and one
+// completed uplink (the unit of "per uplink")
+void energyRecordTx(uint8_t spreadingFactor, int8_t powerDbm, uint32_t airtimeUs);
+void energyRecordRx(uint32_t listenUs);
+void energyCountUplink();
+
+// Brings the ledger up to now and prices it
+const EnergyReport& energyReport();
+
+// Draw of the steady consumers right now (CPU at the last window's load,
+// GNSS, backlight, base), without radio bursts; for load compensation
+float energyPresentCurrentMa();
+
+const char* energyConsumerName(EnergyConsumer consumer);
+uint16_t energyCpuFrequencyMhz(int index);
+int8_t energyTxLevelDbm(int index);
+
+// LoRa time on air (Semtech AN1200.13): 8 preamble symbols, explicit
+// header, CR 4/5, low data rate optimisation for symbols of 16 ms or more
+uint32_t loraAirtimeUs(uint8_t spreadingFactor, uint16_t bandwidthKhz, size_t phyPayloadBytes, bool crc);
+uint32_t loraSymbolUs(uint8_t spreadingFactor, uint16_t bandwidthKhz);
+
+#endif // ENERGY_LEDGER_H
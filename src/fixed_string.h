@@ -0,0 +1,106 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Fixed-capacity, inline, always NUL-terminated string for the steady-state
+// paths that used Arduino String. It never touches the heap: appends past
+// the capacity are cut off and remembered in truncated().
+template <size_t Capacity>
+class FixedString {
+private:
+    char text[Capacity + 1];
+    size_t used;
+    bool overflow;
+
+public:
+    FixedString() : used(0), overflow(false) { text[0] = '\0'; }
+    FixedString(const char* value) : used(0), overflow(false) {
+        text[0] = '\0';
+        append(value);
+    }
+
+    void clear() {
+        used = 0;
+        overflow = false;
+        text[0] = '\0';
+    }
+
+    FixedString& operator=(const char* value) {
+        clear();
+        return append(value);
+    }
+
+    FixedString& append(const char* value, size_t length) {
+        if (length > Capacity - used) {
+            length = Capacity - used;
+            overflow = true;
+        }
+        memcpy(text + used, value, length);
+        used += length;
+        text[used] = '\0';
+        return *this;
+    }
+
+    FixedString& append(const char* value) { return append(value, strlen(value)); }
+
+    FixedString& append(char c) {
+        if (used < Capacity) {
+            text[used++] = c;
+            text[used] = '\0';
+        } else {
+            overflow = true;
+        }
+        return *this;
+    }
+
+    FixedString& appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(text + used, Capacity + 1 - used, format, args);
+        va_end(args);
+        if (written < 0) {
+            text[used] = '\0';
+            return *this;
+        }
+        if ((size_t)written > Capacity - used) {
+            written = (int)(Capacity - used);
+            overflow = true;
+        }
+        used += (size_t)written;
+        return *this;
+    }
+
+    // Strips leading and trailing whitespace in place
+    void trim() {
+        size_t start = 0;
+        while (start < used && (text[start] == ' ' || text[start] == '\t' || text[start] == '\r' || text[start] == '\n')) start++;
+        size_t end = used;
+        while (end > start && (text[end - 1] == ' ' || text[end - 1] == '\t' || text[end - 1] == '\r' || text[end - 1] == '\n')) end--;
+        used = end - start;
+        memmove(text, text + start, used);
+        text[used] = '\0';
+    }
+
+    void toLowerCase() {
+        for (size_t i = 0; i < used; i++) {
+            if (text[i] >= 'A' && text[i] <= 'Z') text[i] += 'a' - 'A';
+        }
+    }
+
+    bool operator==(const char* other) const { return strcmp(text, other) == 0; }
+    bool operator!=(const char* other) const { return strcmp(text, other) != 0; }
+
+    const char* c_str() const { return text; }
+    const uint8_t* bytes() const { return (const uint8_t*)text; }
+    size_t length() const { return used; }
+    static size_t capacity() { return Capacity; }
+    bool isEmpty() const { return used == 0; }
+    bool truncated() const { return overflow; }
+};
+
+#endif // FIXED_STRING_H
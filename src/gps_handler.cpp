@@ -1,6 +1,12 @@
 #include "gps_handler.h"
+#include "console_print.h"
+#include "perf_stats.h"
+#include "telemetry.h"
+#include "energy_ledger.h"
+#include "remote_config.h"
 
-GPSHandler::GPSHandler() : gpsSerial(nullptr), lastUpdate(0), lastValidFix(0), initialized(false), gpsPowered(false),
+GPSHandler::GPSHandler() : gpsSerial(nullptr), lastUpdate(0), lastValidFix(0), initialized(false), gpsPowered(false), poweredAtMs(0), lastTelemetryEpoch(0),
+                          lastByteMs(0), epochStartMs(0), epochDated(false), epochKnown(false), bytesRead(0),
                           totalSentences(0), failedChecksums(0), passedChecksums(0) {
     Serial.println(F("[GPS] Handler created"));
 }
@@ -15,14 +21,26 @@ GPSHandler::~GPSHandler() {
 
 bool GPSHandler::initialize() {
     Serial.println(F("[GPS] Initializing GPS handler..."));
-    
+
+    // Start from a clean parser: nothing decoded before this boot is current
+    gps = TinyGPSPlus();
+    currentData = GPSData();
+    lastValidFix = 0;
+    lastTelemetryEpoch = 0;
+    epochDated = false;
+    epochKnown = false;
+    deadReckoning.reset();
+
     // V1.1 hardware requires GPIO 3 to be HIGH to power on the GPS module
-    pinMode(GPS_PWR_PIN, OUTPUT);
-    digitalWrite(GPS_PWR_PIN, HIGH);
-    Serial.println(F("[GPS] GPS power enabled (V1.1 compatibility)"));
+    if (!gpsPowered) {
+        enableGPSPower();
+    }
     
-    // Small delay to allow GPS module to power up
-    delay(100);
+    // Allow the GPS module to power up
+    unsigned long sincePowerOn = millis() - poweredAtMs;
+    if (sincePowerOn < GPS_POWER_SETTLE_MS) {
+        delay(GPS_POWER_SETTLE_MS - sincePowerOn);
+    }
     
     // Initialize GPS serial communication
     gpsSerial = &Serial1;
@@ -33,7 +51,7 @@ bool GPSHandler::initialize() {
         return false;
     }
     
-    Serial.printf("[GPS] GPS serial initialized on pins RX:%d, TX:%d at %d baud\n", 
+    consolePrintf("[GPS] GPS serial initialized on pins RX:%d, TX:%d at %d baud\n", 
                   GPS_RX_PIN, GPS_TX_PIN, GPS_BAUD_RATE);
     
     // Clear any existing data
@@ -42,7 +60,6 @@ bool GPSHandler::initialize() {
     }
     
     initialized = true;
-    gpsPowered = true;
     lastUpdate = millis();
     
     Serial.println(F("[GPS] [SUCCESS] GPS handler initialized"));
@@ -54,51 +71,23 @@ bool GPSHandler::initialize() {
 
 void GPSHandler::update() {
     if (!initialized || !gpsSerial) return;
+    PERF_SCOPE(PERF_GPS_UPDATE);
+    
+    // With binary telemetry on, fixes go out as records instead of per-sentence
+    // text; below the debug log level, neither
+    bool chatter = !telemetryEnabled() && logLevelEnabled(LOG_LEVEL_DEBUG);
     
     // Process incoming GPS data
+    size_t bytes = 0;
     while (gpsSerial->available()) {
-        char c = gpsSerial->read();
-        if (gps.encode(c)) {
-            // New data available
-            if (gps.location.isValid()) {
-                currentData.isValid = true;
-                currentData.latitude = gps.location.lat();
-                currentData.longitude = gps.location.lng();
-                currentData.age = gps.location.age();
-                lastValidFix = millis();
-                
-                // Debug GPS data
-                Serial.printf("[GPS] Valid fix: Lat=%.6f, Lon=%.6f, Age=%lu ms\n", 
-                             currentData.latitude, currentData.longitude, currentData.age);
-            } else {
-                Serial.printf("[GPS] Invalid location data, age=%lu ms\n", gps.location.age());
-            }
-            
-            if (gps.altitude.isValid()) {
-                currentData.altitude = gps.altitude.meters();
-                Serial.printf("[GPS] Altitude: %.2f m\n", currentData.altitude);
-            }
-            
-            if (gps.speed.isValid()) {
-                currentData.speed = gps.speed.kmph();
-                Serial.printf("[GPS] Speed: %.2f km/h\n", currentData.speed);
-            }
-            
-            if (gps.course.isValid()) {
-                currentData.course = gps.course.deg();
-                Serial.printf("[GPS] Course: %.2f degrees\n", currentData.course);
-            }
-            
-            if (gps.satellites.isValid()) {
-                currentData.satellites = gps.satellites.value();
-                Serial.printf("[GPS] Satellites: %d\n", currentData.satellites);
-            }
-            
-            if (gps.hdop.isValid()) {
-                currentData.hdop = gps.hdop.hdop();
-                Serial.printf("[GPS] HDOP: %.2f\n", currentData.hdop);
-            }
-        }
+        handleByte(gpsSerial->read(), chatter);
+        bytes++;
+    }
+    bytesRead += bytes;
+    trackEpoch(bytes);
+    
+    if (telemetryEnabled()) {
+        sendFixTelemetry();
     }
     
     // Check for timeout
@@ -109,17 +98,106 @@ void GPSHandler::update() {
     
     // Print GPS status periodically
     static unsigned long lastStatusPrint = 0;
-    if (millis() - lastStatusPrint > 10000) { // Every 10 seconds
-        Serial.printf("[GPS] Status: %s, Satellites: %d, Characters: %lu, Sentences: %lu, Failed: %lu\n",
+    if (millis() - lastStatusPrint > 10000 && logLevelEnabled(LOG_LEVEL_INFO)) { // Every 10 seconds
+        consolePrintf("[GPS] Status: %s, Satellites: %d, Characters: %lu, Sentences: %lu, Failed: %lu\n",
                      currentData.isValid ? "Valid" : "Invalid",
                      currentData.satellites,
-                     gps.charsProcessed(),
-                     gps.sentencesWithFix(),
-                     gps.failedChecksum());
+                     (unsigned long)gps.charsProcessed(),
+                     (unsigned long)gps.sentencesWithFix(),
+                     (unsigned long)gps.failedChecksum());
         lastStatusPrint = millis();
     }
 }
 
+// The receiver sends its sentences back to back once per epoch, so a pass
+// that reads the start of a burst dates it: now less the bytes read. With
+// fewer bytes than the UART ring holds (and than any full burst) nothing
+// overflowed and nothing came from an earlier burst; two datings that agree
+// rule out a short burst that had already ended.
+void GPSHandler::trackEpoch(size_t bytes) {
+    if (bytes == 0) return;
+    unsigned long now = millis();
+    if (now - lastByteMs > GPS_BURST_GAP_MS && bytes <= GPS_EPOCH_MAX_BYTES) {
+        unsigned long start = now - (unsigned long)(bytes * GPS_BYTE_US / 1000);
+        unsigned long phase = (start - epochStartMs) % GPS_EPOCH_MS;
+        long offset = phase > GPS_EPOCH_MS / 2 ? (long)phase - GPS_EPOCH_MS : (long)phase;
+        epochKnown = epochDated && abs(offset) <= GPS_EPOCH_TOLERANCE_MS;
+        epochStartMs = start;
+        epochDated = true;
+    }
+    lastByteMs = now;
+}
+
+bool GPSHandler::getEpochStartMs(unsigned long& epochMs) const {
+    if (!epochKnown || !gpsPowered) return false;
+    epochMs = epochStartMs;
+    return true;
+}
+
+uint32_t GPSHandler::getBytesReceived() const {
+    return bytesRead + (gpsSerial ? gpsSerial->available() : 0);
+}
+
+// One byte from the receiver; a completed sentence updates the fix
+void GPSHandler::handleByte(char c, bool chatter) {
+    if (!gps.encode(c)) return;
+    
+    // TinyGPS++ keeps the last location valid through an outage; only a
+    // sentence that carried a fix updates it (and not GGA/RMC without one)
+    bool freshFix = gps.location.isUpdated() && gps.location.age() < GPS_TIMEOUT_MS;
+    if (freshFix) {
+        currentData.isValid = true;
+        currentData.latitude = gps.location.lat();
+        currentData.longitude = gps.location.lng();
+        currentData.age = gps.location.age();
+        currentData.fixTime = millis() - currentData.age;
+        lastValidFix = millis();
+        
+        // Debug GPS data
+        if (chatter) consolePrintf("[GPS] Valid fix: Lat=%.6f, Lon=%.6f, Age=%lu ms\n", 
+                     currentData.latitude, currentData.longitude, currentData.age);
+    } else if (gps.location.age() >= GPS_TIMEOUT_MS) {
+        if (chatter) consolePrintf("[GPS] Invalid location data, age=%lu ms\n", gps.location.age());
+    }
+    
+    if (gps.altitude.isValid()) {
+        currentData.altitude = gps.altitude.meters();
+        if (chatter) consolePrintf("[GPS] Altitude: %.2f m\n", currentData.altitude);
+    }
+    
+    if (gps.speed.isValid()) {
+        currentData.speed = gps.speed.kmph();
+        if (chatter) consolePrintf("[GPS] Speed: %.2f km/h\n", currentData.speed);
+    }
+    
+    if (gps.course.isValid()) {
+        currentData.course = gps.course.deg();
+        if (chatter) consolePrintf("[GPS] Course: %.2f degrees\n", currentData.course);
+    }
+    
+    if (gps.satellites.isValid()) {
+        currentData.satellites = gps.satellites.value();
+        if (chatter) consolePrintf("[GPS] Satellites: %d\n", currentData.satellites);
+    }
+    
+    if (gps.hdop.isValid()) {
+        currentData.hdop = gps.hdop.hdop();
+        if (chatter) consolePrintf("[GPS] HDOP: %.2f\n", currentData.hdop);
+    }
+    
+    if (freshFix) {
+        updateDeadReckoning();
+    }
+}
+
+// Same path as the UART bytes, for sentences from a buffer (benchmarks)
+void GPSHandler::processNmea(const char* data, size_t length) {
+    bool chatter = !telemetryEnabled() && logLevelEnabled(LOG_LEVEL_DEBUG);
+    for (size_t i = 0; i < length; i++) {
+        handleByte(data[i], chatter);
+    }
+}
+
 void GPSHandler::updateGPSData() {
     if (!initialized) return;
     
@@ -129,9 +207,10 @@ void GPSHandler::updateGPSData() {
         currentData.latitude = gps.location.lat();
         currentData.longitude = gps.location.lng();
         currentData.age = gps.location.age();
+        currentData.fixTime = millis() - currentData.age;
         lastValidFix = millis();
         
-        Serial.printf("[GPS] [SUCCESS] Valid fix: %.6f, %.6f (age: %lu ms)\n", 
+        consolePrintf("[GPS] [SUCCESS] Valid fix: %.6f, %.6f (age: %lu ms)\n", 
                       currentData.latitude, currentData.longitude, currentData.age);
     } else {
         currentData.isValid = false;
@@ -162,9 +241,23 @@ void GPSHandler::updateGPSData() {
         currentData.hdop = gps.hdop.hdop();
     }
     
+    if (currentData.isValid) {
+        updateDeadReckoning();
+    }
+    
     lastUpdate = millis();
 }
 
+void GPSHandler::updateDeadReckoning() {
+    // Feed the estimator in fixed point; TinyGPS++ reports speed in km/h
+    deadReckoning.addFix(currentData.fixTime,
+                         (int32_t)lround(currentData.latitude * 1e7),
+                         (int32_t)lround(currentData.longitude * 1e7),
+                         (uint32_t)(currentData.speed * 1000.0f / 3.6f),
+                         (uint32_t)(currentData.course * 100.0f),
+                         (uint32_t)(currentData.hdop * 100.0f));
+}
+
 GPSData GPSHandler::getCurrentData() const {
     return currentData;
 }
@@ -178,6 +271,34 @@ bool GPSHandler::hasValidFix() const {
     return currentData.isValid && (millis() - lastValidFix < GPS_TIMEOUT_MS);
 }
 
+// One record per receiver epoch (GGA and RMC of the same second share it)
+void GPSHandler::sendFixTelemetry() {
+    if (!gps.time.isValid() || gps.time.value() == lastTelemetryEpoch) return;
+    lastTelemetryEpoch = gps.time.value();
+    
+    TelemetryGpsFix fix;
+    PositionEstimate estimate;
+    bool hasPosition = getPositionEstimate(estimate);
+    if (!getUnixTimeMs(fix.unixTimeMs)) fix.unixTimeMs = 0;
+    fix.latitudeE7 = hasPosition ? estimate.latitudeE7 : 0;
+    fix.longitudeE7 = hasPosition ? estimate.longitudeE7 : 0;
+    fix.altitudeCm = (int32_t)(currentData.altitude * 100);
+    fix.speedCmps = (uint16_t)(currentData.speed * (100.0f / 3.6f));
+    fix.courseCentiDeg = (uint16_t)(currentData.course * 100);
+    fix.hdopCenti = (uint16_t)(currentData.hdop * 100);
+    uint32_t accuracy = (estimate.accuracyMm + 999) / 1000;
+    fix.accuracyM = hasPosition ? (accuracy > 0xFFFF ? 0xFFFF : (uint16_t)accuracy) : 0;
+    fix.satellites = (uint8_t)currentData.satellites;
+    fix.flags = (currentData.isValid ? TELEMETRY_GPS_VALID : 0) |
+                (hasPosition && !currentData.isValid ? TELEMETRY_GPS_ESTIMATED : 0);
+    telemetrySendGpsFix(fix);
+}
+
+bool GPSHandler::getPositionEstimate(PositionEstimate& estimate) const {
+    // Propagates the last fix through short outages; fails once it is too old
+    return deadReckoning.estimate(millis(), estimate);
+}
+
 bool GPSHandler::hasNewData() const {
     return initialized && (millis() - lastUpdate < GPS_UPDATE_INTERVAL);
 }
@@ -187,7 +308,7 @@ unsigned long GPSHandler::getTimeSinceLastFix() const {
     return millis() - lastValidFix;
 }
 
-String GPSHandler::getStatusString() const {
+const char* GPSHandler::getStatusString() const {
     if (!initialized) return "Not initialized";
     if (!currentData.isValid) return "No fix";
     if (currentData.satellites < GPS_MIN_SATELLITES) return "Insufficient satellites";
@@ -202,21 +323,21 @@ void GPSHandler::printStatus() {
     }
     
     Serial.println(F("[GPS] === GPS Status ==="));
-    Serial.printf("[GPS] Initialized: %s\n", initialized ? "Yes" : "No");
-    Serial.printf("[GPS] Valid fix: %s\n", currentData.isValid ? "Yes" : "No");
-    Serial.printf("[GPS] Satellites: %d\n", currentData.satellites);
-    Serial.printf("[GPS] Status: %s\n", getStatusString().c_str());
+    consolePrintf("[GPS] Initialized: %s\n", initialized ? "Yes" : "No");
+    consolePrintf("[GPS] Valid fix: %s\n", currentData.isValid ? "Yes" : "No");
+    consolePrintf("[GPS] Satellites: %d\n", currentData.satellites);
+    consolePrintf("[GPS] Status: %s\n", getStatusString());
     
     if (currentData.isValid) {
-        Serial.printf("[GPS] Location: %.6f, %.6f\n", currentData.latitude, currentData.longitude);
-        Serial.printf("[GPS] Altitude: %.2f m\n", currentData.altitude);
-        Serial.printf("[GPS] Speed: %.2f km/h\n", currentData.speed);
-        Serial.printf("[GPS] Course: %.2f°\n", currentData.course);
-        Serial.printf("[GPS] HDOP: %.2f\n", currentData.hdop);
-        Serial.printf("[GPS] Age: %lu ms\n", currentData.age);
+        consolePrintf("[GPS] Location: %.6f, %.6f\n", currentData.latitude, currentData.longitude);
+        consolePrintf("[GPS] Altitude: %.2f m\n", currentData.altitude);
+        consolePrintf("[GPS] Speed: %.2f km/h\n", currentData.speed);
+        consolePrintf("[GPS] Course: %.2f°\n", currentData.course);
+        consolePrintf("[GPS] HDOP: %.2f\n", currentData.hdop);
+        consolePrintf("[GPS] Age: %lu ms\n", currentData.age);
     }
     
-    Serial.printf("[GPS] Time since last fix: %lu ms\n", getTimeSinceLastFix());
+    consolePrintf("[GPS] Time since last fix: %lu ms\n", getTimeSinceLastFix());
     printGPSStats();
 }
 
@@ -229,35 +350,35 @@ void GPSHandler::printDetailedInfo() {
     Serial.println(F("[GPS] === Detailed GPS Information ==="));
     
     // Location information
-    Serial.printf("[GPS] Location valid: %s\n", gps.location.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] Location valid: %s\n", gps.location.isValid() ? "Yes" : "No");
     if (gps.location.isValid()) {
-        Serial.printf("[GPS] Latitude: %.8f\n", gps.location.lat());
-        Serial.printf("[GPS] Longitude: %.8f\n", gps.location.lng());
-        Serial.printf("[GPS] Location age: %lu ms\n", gps.location.age());
+        consolePrintf("[GPS] Latitude: %.8f\n", gps.location.lat());
+        consolePrintf("[GPS] Longitude: %.8f\n", gps.location.lng());
+        consolePrintf("[GPS] Location age: %lu ms\n", gps.location.age());
     }
     
     // Date and time
     if (gps.date.isValid() && gps.time.isValid()) {
-        Serial.printf("[GPS] Date: %s\n", formatDate().c_str());
-        Serial.printf("[GPS] Time: %s\n", formatTime().c_str());
+        consolePrintf("[GPS] Date: %s\n", formatDate().c_str());
+        consolePrintf("[GPS] Time: %s\n", formatTime().c_str());
     }
     
     // Altitude
-    Serial.printf("[GPS] Altitude valid: %s\n", gps.altitude.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] Altitude valid: %s\n", gps.altitude.isValid() ? "Yes" : "No");
     if (gps.altitude.isValid()) {
-        Serial.printf("[GPS] Altitude: %.2f m\n", gps.altitude.meters());
+        consolePrintf("[GPS] Altitude: %.2f m\n", gps.altitude.meters());
     }
     
     // Speed
-    Serial.printf("[GPS] Speed valid: %s\n", gps.speed.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] Speed valid: %s\n", gps.speed.isValid() ? "Yes" : "No");
     if (gps.speed.isValid()) {
-        Serial.printf("[GPS] Speed: %.2f km/h\n", gps.speed.kmph());
+        consolePrintf("[GPS] Speed: %.2f km/h\n", gps.speed.kmph());
     }
     
     // Course
-    Serial.printf("[GPS] Course valid: %s\n", gps.course.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] Course valid: %s\n", gps.course.isValid() ? "Yes" : "No");
     if (gps.course.isValid()) {
-        Serial.printf("[GPS] Course: %.2f°\n", gps.course.deg());
+        consolePrintf("[GPS] Course: %.2f°\n", gps.course.deg());
     }
     
     printSatelliteInfo();
@@ -265,32 +386,32 @@ void GPSHandler::printDetailedInfo() {
 
 void GPSHandler::printSatelliteInfo() {
     Serial.println(F("[GPS] === Satellite Information ==="));
-    Serial.printf("[GPS] Satellites valid: %s\n", gps.satellites.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] Satellites valid: %s\n", gps.satellites.isValid() ? "Yes" : "No");
     if (gps.satellites.isValid()) {
-        Serial.printf("[GPS] Satellites in view: %d\n", gps.satellites.value());
+        consolePrintf("[GPS] Satellites in view: %d\n", gps.satellites.value());
     }
     
-    Serial.printf("[GPS] HDOP valid: %s\n", gps.hdop.isValid() ? "Yes" : "No");
+    consolePrintf("[GPS] HDOP valid: %s\n", gps.hdop.isValid() ? "Yes" : "No");
     if (gps.hdop.isValid()) {
-        Serial.printf("[GPS] HDOP: %.2f\n", gps.hdop.hdop());
+        consolePrintf("[GPS] HDOP: %.2f\n", gps.hdop.hdop());
     }
 }
 
 void GPSHandler::printGPSStats() {
     Serial.println(F("[GPS] === GPS Statistics ==="));
-    Serial.printf("[GPS] Total sentences: %lu\n", totalSentences);
-    Serial.printf("[GPS] Passed checksums: %lu\n", passedChecksums);
-    Serial.printf("[GPS] Failed checksums: %lu\n", failedChecksums);
-    Serial.printf("[GPS] Characters processed: %lu\n", gps.charsProcessed());
+    consolePrintf("[GPS] Total sentences: %lu\n", totalSentences);
+    consolePrintf("[GPS] Passed checksums: %lu\n", passedChecksums);
+    consolePrintf("[GPS] Failed checksums: %lu\n", failedChecksums);
+    consolePrintf("[GPS] Characters processed: %lu\n", (unsigned long)gps.charsProcessed());
     
     if (totalSentences > 0) {
         float successRate = (float)passedChecksums / totalSentences * 100.0;
-        Serial.printf("[GPS] Success rate: %.1f%%\n", successRate);
+        consolePrintf("[GPS] Success rate: %.1f%%\n", successRate);
     }
 }
 
-String GPSHandler::formatCoordinate(float coord, bool isLatitude) const {
-    char buffer[32];
+FixedString<23> GPSHandler::formatCoordinate(float coord, bool isLatitude) const {
+    FixedString<23> text;
     char direction = ' ';
     
     if (isLatitude) {
@@ -303,30 +424,43 @@ String GPSHandler::formatCoordinate(float coord, bool isLatitude) const {
     int degrees = (int)absCoord;
     float minutes = (absCoord - degrees) * 60.0;
     
-    snprintf(buffer, sizeof(buffer), "%d°%.4f'%c", degrees, minutes, direction);
-    return String(buffer);
+    text.appendf("%d°%.4f'%c", degrees, minutes, direction);
+    return text;
 }
 
-String GPSHandler::formatTime() const {
+FixedString<15> GPSHandler::formatTime() const {
     if (!gps.time.isValid()) return "Invalid";
     
-    char buffer[16];
+    FixedString<15> text;
     // Cast away const since TinyGPS++ methods are not const-qualified
     TinyGPSPlus& mutableGps = const_cast<TinyGPSPlus&>(gps);
-    snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", 
-             mutableGps.time.hour(), mutableGps.time.minute(), mutableGps.time.second());
-    return String(buffer);
+    text.appendf("%02d:%02d:%02d", 
+                 mutableGps.time.hour(), mutableGps.time.minute(), mutableGps.time.second());
+    return text;
 }
 
-String GPSHandler::formatDate() const {
+FixedString<15> GPSHandler::formatDate() const {
     if (!gps.date.isValid()) return "Invalid";
     
-    char buffer[16];
+    FixedString<15> text;
+    // Cast away const since TinyGPS++ methods are not const-qualified
+    TinyGPSPlus& mutableGps = const_cast<TinyGPSPlus&>(gps);
+    text.appendf("%02d/%02d/%04d", 
+                 mutableGps.date.month(), mutableGps.date.day(), mutableGps.date.year());
+    return text;
+}
+
+// Current UTC time from the last RMC/ZDA date and time, advanced by their age
+bool GPSHandler::getUnixTimeMs(int64_t& timeMs) const {
+    if (!gps.date.isValid() || !gps.time.isValid()) return false;
+    
     // Cast away const since TinyGPS++ methods are not const-qualified
     TinyGPSPlus& mutableGps = const_cast<TinyGPSPlus&>(gps);
-    snprintf(buffer, sizeof(buffer), "%02d/%02d/%04d", 
-             mutableGps.date.month(), mutableGps.date.day(), mutableGps.date.year());
-    return String(buffer);
+    if (mutableGps.date.year() < 2020) return false;
+    timeMs = archiveUnixTimeMs(mutableGps.date.year(), mutableGps.date.month(), mutableGps.date.day(),
+                               mutableGps.time.hour(), mutableGps.time.minute(), mutableGps.time.second(),
+                               mutableGps.time.centisecond() * 10) + mutableGps.time.age();
+    return true;
 }
 
 double GPSHandler::distanceTo(float lat, float lon) const {
@@ -344,13 +478,17 @@ void GPSHandler::enableGPSPower() {
     pinMode(GPS_PWR_PIN, OUTPUT);
     digitalWrite(GPS_PWR_PIN, HIGH);
     gpsPowered = true;
+    poweredAtMs = millis();
+    energySetConsumer(ENERGY_GNSS, true);
     Serial.println(F("[GPS] GPS power enabled"));
-    delay(100); // Allow time for GPS to power up
 }
 
 void GPSHandler::disableGPSPower() {
     digitalWrite(GPS_PWR_PIN, LOW);
     gpsPowered = false;
+    epochDated = false;
+    epochKnown = false;
+    energySetConsumer(ENERGY_GNSS, false);
     currentData.isValid = false; // Clear current data as GPS is powered down
     Serial.println(F("[GPS] GPS power disabled"));
 }
@@ -5,11 +5,20 @@
 #include <TinyGPS++.h>
 #include <HardwareSerial.h>
 #include "Config.h"
+#include "dead_reckoning.h"
+#include "sample_archive.h"
+#include "fixed_string.h"
 
 // GPS configuration constants
 #define GPS_UPDATE_INTERVAL     1000    // Update GPS data every 1 second
 #define GPS_TIMEOUT_MS          5000    // Timeout for GPS operations
 #define GPS_MIN_SATELLITES      4       // Minimum satellites for valid fix
+#define GPS_POWER_SETTLE_MS     100     // Module power-up before the UART is opened
+#define GPS_EPOCH_MS            1000    // Receiver output rate: one NMEA burst per epoch
+#define GPS_BURST_GAP_MS        200     // Silence longer than this (> one loop pass) ends a burst
+#define GPS_BYTE_US             (10000000UL / GPS_BAUD_RATE)    // 8N1
+#define GPS_EPOCH_MAX_BYTES     200     // Dating a burst: more and the UART ring may have overflowed
+#define GPS_EPOCH_TOLERANCE_MS  20      // Two datings this close agree on the epoch
 
 struct GPSData {
     bool isValid;
@@ -21,10 +30,11 @@ struct GPSData {
     int satellites;
     float hdop;
     unsigned long age;
+    unsigned long fixTime;      // millis() at which the fix was computed
     
     // Constructor
     GPSData() : isValid(false), latitude(0.0), longitude(0.0), altitude(0.0), 
-                speed(0.0), course(0.0), satellites(0), hdop(0.0), age(0) {}
+                speed(0.0), course(0.0), satellites(0), hdop(0.0), age(0), fixTime(0) {}
 };
 
 class GPSHandler {
@@ -36,6 +46,16 @@ private:
     unsigned long lastValidFix;
     bool initialized;
     bool gpsPowered;
+    unsigned long poweredAtMs;
+    DeadReckoning deadReckoning;
+    uint32_t lastTelemetryEpoch;    // Receiver hhmmsscc of the last fix record
+    
+    // NMEA burst timing, for the power manager's epoch guard
+    unsigned long lastByteMs;       // Last update() that read bytes
+    unsigned long epochStartMs;     // First byte of the last burst whose start was dated
+    bool epochDated;
+    bool epochKnown;                // The last two datings agree
+    volatile uint32_t bytesRead;
     
     // Statistics
     unsigned long totalSentences;
@@ -44,7 +64,11 @@ private:
     
     // Helper functions
     void updateGPSData();
+    void updateDeadReckoning();
     void printGPSStats();
+    void sendFixTelemetry();
+    void handleByte(char c, bool chatter);
+    void trackEpoch(size_t bytes);
     
 public:
     GPSHandler();
@@ -55,10 +79,13 @@ public:
     
     // Data acquisition
     void update();
+    void processNmea(const char* data, size_t length);
     bool hasValidFix() const;
     bool hasNewData() const;
     GPSData getCurrentData() const;
     int getSatelliteCount();
+    bool getPositionEstimate(PositionEstimate& estimate) const;
+    bool getUnixTimeMs(int64_t& timeMs) const;
     
     // Individual data getters
     float getLatitude() const { return currentData.latitude; }
@@ -73,13 +100,21 @@ public:
     // Status and diagnostics
     bool isInitialized() const { return initialized; }
     unsigned long getTimeSinceLastFix() const;
-    String getStatusString() const;
+    const char* getStatusString() const;
     
-    // Power management (V1.1 hardware)
+    // Power management (V1.1 hardware). Power can come on well before
+    // initialize(), which then only waits out what is left of the settle time
     void enableGPSPower();
     void disableGPSPower();
     bool isGPSPowered() const;
     
+    // NMEA burst timing: millis() at which a burst started, so that the
+    // next ones start GPS_EPOCH_MS apart from it; false until two bursts
+    // dated since power-on agree. Bytes received counts those still in the
+    // UART ring too (safe from another task).
+    bool getEpochStartMs(unsigned long& epochMs) const;
+    uint32_t getBytesReceived() const;
+    
     // Statistics
     unsigned long getTotalSentences() const { return totalSentences; }
     unsigned long getFailedChecksums() const { return failedChecksums; }
@@ -91,9 +126,9 @@ public:
     void printSatelliteInfo();
     
     // Utility functions
-    String formatCoordinate(float coord, bool isLatitude) const;
-    String formatTime() const;
-    String formatDate() const;
+    FixedString<23> formatCoordinate(float coord, bool isLatitude) const;
+    FixedString<15> formatTime() const;
+    FixedString<15> formatDate() const;
     double distanceTo(float lat, float lon) const;
     double courseTo(float lat, float lon) const;
 };
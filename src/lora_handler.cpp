@@ -1,30 +1,79 @@
 #include "lora_handler.h"
+#include "console_print.h"
+#include "payload_codec.h"
+#include "perf_stats.h"
+#include "telemetry.h"
+#include "energy_ledger.h"
+#include "power_manager.h"
+#include "sample_archive.h"
+#include "dr_survey.h"
+#include "remote_config.h"
 #include "secrets.h"
 #include <SPI.h>
 #include "Config.h"
 #include <Preferences.h> // Added for NVS
-
-// Define static constants
-const float LoRaHandler::SIGNAL_CHANGE_THRESHOLD = 10.0; // dBm change threshold
-const unsigned long LoRaHandler::MIN_DISCOVERY_INTERVAL = 30000; // 30 seconds minimum between discoveries
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#if !defined(NATIVE_SIM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+#include <new>
 
 // Add global or class member for SPI
 SPIClass spiLoRa(FSPI);
 
+// RadioLib's session and nonce buffers across deep sleep; RadioLib checks
+// their signatures when they are handed back
+RTC_DATA_ATTR static uint8_t retainedNonces[RADIOLIB_LORAWAN_NONCES_BUF_SIZE];
+RTC_DATA_ATTR static uint8_t retainedSession[RADIOLIB_LORAWAN_SESSION_BUF_SIZE];
+RTC_DATA_ATTR static bool sessionRetained = false;
+
 LoRaHandler::LoRaHandler() : 
     radio(nullptr), 
     node(nullptr), 
     initialized(false), 
     joined(false), 
+    joining(false),
     lastSendTime(0), 
     lastJoinAttempt(0),
+    statusUplinkCount(0),
+    dataRate(LORA_DEFAULT_DATA_RATE),
+    txPowerDbm(LORA_TX_POWER_DBM),
+    fixedDataRate(LORA_DATA_RATE_ADR),
+    subBand(LORA_SUB_BAND),
+    learnedSubBand(0),
+    joinOrder(),
+    joinOrderIndex(0),
+    joinTriesLeft(0),
+    sequenceRequests(0),
+    sequenceStartMs(0),
+    joinStats(),
+    sessionSource(LORA_SESSION_NONE),
+    linkUpMs(0),
+    firstUplinkMs(0),
     lastErrorCode(0),
     lastRssi(0.0),
     lastSnr(0.0),
+    surveying(false),
+    lastSurveyAcked(false),
+    surveyCreditMs(0),
+    surveyCreditUpdatedMs(0),
+    lastStatusConfirmed(false),
+    lastStatusAcked(false),
+    lastRxWindow(0),
+    downlink(),
+    downlinkPending(false),
+    downlinkCount(0),
+    configAck(),
+    configAckPending(false),
+    uplinksSinceSave(0),
     gatewayDiscoveryEnabled(true),
     lastGatewayRssi(-999.0),
     lastGatewaySnr(-999.0),
-    lastGatewayDiscoveryTime(0) {
+    lastGatewayDiscoveryTime(0),
+    signalChangeThreshold(LORA_DISCOVERY_CHANGE_DB),
+    minDiscoveryInterval(LORA_DISCOVERY_INTERVAL_MS) {
     Serial.println(F("[LoRa] Handler created"));
 }
 
@@ -42,7 +91,7 @@ LoRaHandler::~LoRaHandler() {
 
 bool LoRaHandler::initialize() {
     Serial.println(F("[LoRa] Initializing LoRa handler..."));
-    Serial.printf("[LoRa] Pin mapping: CS=%d, DIO1=%d, RST=%d, BUSY=%d, SCK=%d, MISO=%d, MOSI=%d\n", LORA_CS, LORA_DIO1, LORA_RST, LORA_BUSY, LORA_SCK, LORA_MISO, LORA_MOSI);
+    consolePrintf("[LoRa] Pin mapping: CS=%d, DIO1=%d, RST=%d, BUSY=%d, SCK=%d, MISO=%d, MOSI=%d\n", LORA_CS, LORA_DIO1, LORA_RST, LORA_BUSY, LORA_SCK, LORA_MISO, LORA_MOSI);
 
     // Ensure VEXT is enabled before LoRa init (if not already done)
     pinMode(VEXT_PIN, OUTPUT);
@@ -50,6 +99,25 @@ bool LoRaHandler::initialize() {
     Serial.println(F("[LoRa] VEXT power enabled for LoRa"));
     delay(20);
 
+    // A second initialize (error recovery, deep-sleep wake) starts from a fresh radio
+    delete node;
+    node = nullptr;
+    delete radio;
+    radio = nullptr;
+    initialized = false;
+    joined = false;
+    sessionSource = LORA_SESSION_NONE;
+    linkUpMs = 0;
+    firstUplinkMs = 0;
+    surveying = false;
+    dataRate = LORA_DEFAULT_DATA_RATE;
+    txPowerDbm = LORA_TX_POWER_DBM;
+    sequenceRequests = 0;
+    joinStats = LoRaJoinStats();
+    downlinkPending = false;
+    configAckPending = false;
+    uplinksSinceSave = 0;
+
     // Initialize FSPI for LoRa
     spiLoRa.begin(LORA_SCK, LORA_MISO, LORA_MOSI, LORA_CS);
     Serial.println(F("[LoRa] FSPI bus initialized for LoRa"));
@@ -65,28 +133,26 @@ bool LoRaHandler::initialize() {
     Serial.println(F("[LoRa] Initializing radio hardware..."));
     int16_t state = radio->begin();
     if (state != RADIOLIB_ERR_NONE) {
-        Serial.printf("[LoRa] [ERROR] Radio initialization failed, code: %d\n", state);
+        consolePrintf("[LoRa] [ERROR] Radio initialization failed, code: %d\n", state);
         lastErrorCode = state;
         return false;
     }
     
-    // Create LoRaWAN node with US915 band and subband 2
-    node = new LoRaWANNode(radio, &US915, 2);
+    // US915 node on the sub-band learned for this network, the default otherwise
+    loadSubBand();
+    subBand = learnedSubBand ? learnedSubBand : LORA_SUB_BAND;
+    node = new LoRaWANNode(radio, &US915, subBand);
     if (!node) {
         Serial.println(F("[LoRa] [ERROR] Failed to create LoRaWAN node"));
         return false;
     }
+    consolePrintf("[LoRa] US915 sub-band %u (%s)\n", subBand, learnedSubBand ? "learned" : "default");
     
     Serial.println(F("[LoRa] [SUCCESS] Radio hardware initialized"));
     initialized = true;
 
-    // Try to load session from NVS
-    if (loadLoRaSession()) {
-        // Restore session to RadioLib (if API allows)
-        // Example: node->restoreSession(session.devAddr, session.nwkSKey, session.appSKey, session.fCntUp, session.fCntDown);
-        Serial.println(F("[LoRa] [INFO] Restored LoRaWAN session from NVS"));
-        // TODO: Call RadioLib restoreSession if available
-    } else {
+    // RadioLib takes the buffers back once the credentials are set (configureCredentials)
+    if (!loadLoRaSession()) {
         Serial.println(F("[LoRa] [INFO] No valid session found, will join network"));
     }
     return true;
@@ -102,23 +168,19 @@ bool LoRaHandler::configureCredentials() {
     
     // Print credentials for verification
     printCredentials();
-    
-    // Convert credentials to 64-bit integers (MSB format)
-    uint64_t joinEUI = 0;
-    uint64_t devEUI = 0;
-    
-    for (int i = 0; i < 8; i++) {
-        joinEUI = (joinEUI << 8) | APPEUI[i];
-        devEUI = (devEUI << 8) | DEVEUI[i];
-    }
-    
-    // Configure credentials
-    node->beginOTAA(joinEUI, devEUI, (uint8_t*)APPKEY, (uint8_t*)APPKEY);
+    beginCredentials();
     
     Serial.println(F("[LoRa] [SUCCESS] Credentials configured"));
+    restoreSession();
+    applyDataRatePolicy();
     return true;
 }
 
+// Credentials (MSB format) into the node; again for every node built
+void LoRaHandler::beginCredentials() {
+    node->beginOTAA(getJoinEUI(), getDevEUI(), (uint8_t*)APPKEY, (uint8_t*)APPKEY);
+}
+
 bool LoRaHandler::joinNetwork() {
     if (!initialized) {
         Serial.println(F("[LoRa] [ERROR] Handler not initialized"));
@@ -129,25 +191,52 @@ bool LoRaHandler::joinNetwork() {
     Serial.println(F("[LoRa] Attempting OTAA join..."));
     Serial.println(F("[LoRa] =========================================="));
     
-    Serial.println(F("[LoRa] [DEBUG] Sending join request..."));
+    // A new sequence of requests starts from the learned (or default) sub-band
+    if (sequenceRequests == 0) {
+        sequenceStartMs = millis();
+        planJoinOrder();
+    }
+    uint8_t band = joinOrder[joinOrderIndex];
+    if (band != subBand) selectSubBand(band);
+    sequenceRequests++;
+    joinStats.requests++;
+    if (logLevelEnabled(LOG_LEVEL_DEBUG)) {
+        consolePrintf("[LoRa] [DEBUG] Sending join request %u on sub-band %u...\n", sequenceRequests, subBand);
+    }
     unsigned long joinStartTime = millis();
     
     // Attempt to join with a reasonable timeout
-    int16_t state = node->activateOTAA();
+    int16_t state;
+    {
+        PERF_SCOPE(PERF_JOIN);
+        state = node->activateOTAA();
+    }
+    // Every request used a DevNonce, accepted or not; the network refuses a repeat
+    storeSession();
+    // Join requests go out at DR0; no accept means both windows ran empty
+    if (state == RADIOLIB_ERR_NONE) {
+        accountRadioTime(0, LORA_JOIN_REQUEST_SIZE, LORA_JOIN_ACCEPT_SIZE);
+    } else if (state == RADIOLIB_ERR_NO_JOIN_ACCEPT) {
+        accountRadioTime(0, LORA_JOIN_REQUEST_SIZE, 0);
+    }
     
     if (state == RADIOLIB_ERR_NONE) {
         unsigned long joinTime = millis() - joinStartTime;
-        Serial.printf("[LoRa] [SUCCESS] ✅ Join completed in %lu ms\n", joinTime);
+        consolePrintf("[LoRa] [SUCCESS] ✅ Join completed in %lu ms\n", joinTime);
         
         // Verify session was established
         if (node->isActivated()) {
             Serial.println(F("[LoRa] [SUCCESS] ✅ Session established"));
+            countJoin();
+            applyDataRatePolicy();
             
             // Update signal quality
             lastRssi = radio->getRSSI();
             lastSnr = radio->getSNR();
             
             joined = true;
+            sessionSource = LORA_SESSION_JOINED;
+            linkUpMs = millis();
             printJoinStatus();
             
             // Remove initial test message - no longer needed
@@ -162,15 +251,16 @@ bool LoRaHandler::joinNetwork() {
             return true;
         } else {
             Serial.println(F("[LoRa] [ERROR] ❌ Join reported success but session not established"));
+            advanceJoinOrder();
             joined = false;
             return false;
         }
     } else {
         unsigned long joinTime = millis() - joinStartTime;
-        Serial.printf("[LoRa] [ERROR] ❌ Join failed after %lu ms\n", joinTime);
+        consolePrintf("[LoRa] [ERROR] ❌ Join failed after %lu ms\n", joinTime);
         
         lastErrorCode = state;
-        Serial.printf("[LoRa] [ERROR] Join failed with error code: %d (%s)\n", state, getErrorString(state).c_str());
+        consolePrintf("[LoRa] [ERROR] Join failed with error code: %d (%s)\n", state, getErrorString(state));
         
         Serial.println(F("[LoRa] [ERROR] =========================================="));
         Serial.println(F("[LoRa] [ERROR] Join failure analysis:"));
@@ -179,182 +269,607 @@ bool LoRaHandler::joinNetwork() {
         Serial.println(F("[LoRa] [ERROR] - Try clearing persistence and rejoining"));
         Serial.println(F("[LoRa] [ERROR] =========================================="));
         
+        advanceJoinOrder();
         joined = false;
         return false;
     }
 }
 
-bool LoRaHandler::sendData(const String& data, uint8_t port, bool confirmed) {
-    if (!initialized || !joined) {
+// Learned (or default) sub-band first, the other seven in a random order
+void LoRaHandler::planJoinOrder() {
+    uint8_t preferred = learnedSubBand ? learnedSubBand : LORA_SUB_BAND;
+    uint8_t count = 0;
+    joinOrder[count++] = preferred;
+    for (uint8_t band = 1; band <= LORA_SUB_BANDS; band++) {
+        if (band != preferred) joinOrder[count++] = band;
+    }
+    for (uint8_t i = LORA_SUB_BANDS - 1; i > 1; i--) {
+        uint8_t j = 1 + random(i);
+        uint8_t band = joinOrder[i];
+        joinOrder[i] = joinOrder[j];
+        joinOrder[j] = band;
+    }
+    joinOrderIndex = 0;
+    joinTriesLeft = LORA_SUB_BAND_FIRST_TRIES;
+}
+
+// After a request without an accept; a full pass reshuffles
+void LoRaHandler::advanceJoinOrder() {
+    if (--joinTriesLeft > 0) return;
+    if (++joinOrderIndex >= LORA_SUB_BANDS) {
+        planJoinOrder();
+        return;
+    }
+    joinTriesLeft = 1;
+}
+
+// RadioLib takes the sub-band when the node is built, so a switch rebuilds
+// it, in place to keep the heap out of the join; it gets the credentials and
+// the nonces back, so DevNonce keeps counting up across the switch
+bool LoRaHandler::selectSubBand(uint8_t band) {
+    uint8_t nonces[RADIOLIB_LORAWAN_NONCES_BUF_SIZE];
+    memcpy(nonces, node->getBufferNonces(), sizeof(nonces));
+    node->~LoRaWANNode();
+    new (node) LoRaWANNode(radio, &US915, band);
+    subBand = band;
+    beginCredentials();
+    int16_t state = node->setBufferNonces(nonces);
+    if (state != RADIOLIB_ERR_NONE) {
+        consolePrintf("[LoRa] [WARN] Nonces refused on sub-band %u: %d (%s)\n", band, state, getErrorString(state));
+    }
+    if (surveying) {
+        node->setADR(false);
+        node->setDatarate(dataRate);
+        node->setTxPower(txPowerDbm);
+    } else {
+        applyDataRatePolicy();
+    }
+    return state == RADIOLIB_ERR_NONE;
+}
+
+// Time to join for the sequence that just ended; the sub-band is learned
+void LoRaHandler::countJoin() {
+    uint32_t elapsedMs = millis() - sequenceStartMs;
+    joinStats.joins++;
+    if (sequenceRequests == 1) joinStats.firstRequestJoins++;
+    joinStats.lastMs = elapsedMs;
+    if (joinStats.joins == 1 || elapsedMs < joinStats.minMs) joinStats.minMs = elapsedMs;
+    if (elapsedMs > joinStats.maxMs) joinStats.maxMs = elapsedMs;
+    joinStats.totalMs += elapsedMs;
+    joinStats.lastRequests = sequenceRequests;
+    if (sequenceRequests > joinStats.maxRequests) joinStats.maxRequests = sequenceRequests;
+    consolePrintf("[LoRa] Joined on sub-band %u after %u request(s), %lu ms\n", subBand, sequenceRequests,
+                  (unsigned long)elapsedMs);
+    sequenceRequests = 0;
+    saveSubBand(subBand, true);
+}
+
+bool LoRaHandler::sendData(const char* text, uint8_t port, bool confirmed) {
+    if (!initialized || !isJoined()) {
         Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
         return false;
     }
 
+    consolePrintf("[LoRa] Sending text on port %d: %s\n", port, text);
+    return sendData((const uint8_t*)text, strlen(text), port, confirmed);
+}
+
+bool LoRaHandler::sendData(const uint8_t* data, size_t length, uint8_t port, bool confirmed) {
+    int16_t state = sendFrame(data, length, port, confirmed);
+    return state == RADIOLIB_ERR_NONE || (confirmed && state == RADIOLIB_ERR_RX_TIMEOUT);
+}
+
+// sendData() with RadioLib's result, which tells an acked confirmed uplink
+// from one that went out without an ack (RADIOLIB_ERR_RX_TIMEOUT)
+int16_t LoRaHandler::sendFrame(const uint8_t* data, size_t length, uint8_t port, bool confirmed) {
+    if (!initialized || !isJoined()) {
+        Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
+        return RADIOLIB_ERR_NETWORK_NOT_JOINED;
+    }
+
     // Print current frame counter (if available)
-    Serial.printf("[LoRa] [DEBUG] (sendData) Before uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), node->getFCntUp());
+    bool debug = logLevelEnabled(LOG_LEVEL_DEBUG);
+    if (debug) {
+        consolePrintf("[LoRa] [DEBUG] (sendData) Before uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), (unsigned long)node->getFCntUp());
+    }
 
-    Serial.printf("[LoRa] Sending data on port %d: %s\n", port, data.c_str());
+    consolePrintf("[LoRa] Sending %u bytes on port %d\n", (unsigned)length, port);
 
-    String dataToSend = data; // Create non-const copy
-    int16_t state = node->uplink(dataToSend, port, confirmed);
-    Serial.printf("[LoRa] [DEBUG] (sendData) After uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), node->getFCntUp());
-    if (state == RADIOLIB_ERR_NONE) {
+    PerfTimestamp uplinkStart = perfNow();
+    int16_t state = transmit(data, length, port, confirmed);
+    uint64_t uplinkNs = perfElapsedNs(uplinkStart);
+    if (debug) {
+        consolePrintf("[LoRa] [DEBUG] (sendData) After uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), (unsigned long)node->getFCntUp());
+    }
+    // A confirmed uplink that got no ack still went out
+    if (state == RADIOLIB_ERR_NONE || (confirmed && state == RADIOLIB_ERR_RX_TIMEOUT)) {
         Serial.println(F("[LoRa] [SUCCESS] ✅ Data sent successfully"));
         lastSendTime = millis();
-        lastRssi = radio->getRSSI();
-        lastSnr = radio->getSNR();
-        // Update frame counter and save session
-        session.fCntUp = node->getFCntUp();
-        saveLoRaSession();
-        return true;
+        if (state == RADIOLIB_ERR_NONE) {
+            lastRssi = radio->getRSSI();
+            lastSnr = radio->getSNR();
+        }
+        lastErrorCode = RADIOLIB_ERR_NONE;
+        reportUplink(state, port, length, confirmed, uplinkNs);
+        countSessionUplink();
     } else {
-        Serial.printf("[LoRa] [ERROR] ❌ Failed to send data, code: %d (%s)\n", state, getErrorString(state).c_str());
+        consolePrintf("[LoRa] [ERROR] ❌ Failed to send data, code: %d (%s)\n", state, getErrorString(state));
         lastErrorCode = state;
+        reportUplink(state, port, length, confirmed, uplinkNs);
         // If -1108, try to clear persistence and rejoin
         if (state == -1108) {
             Serial.println(F("[LoRa] [WARN] -1108 error: clearing persistence and rejoining..."));
             clearPersistence();
             joinNetwork();
         }
-        return false;
+    }
+    return state;
+}
+
+// Uplink outcome as a binary telemetry record (no-op unless telemetry is on)
+void LoRaHandler::reportUplink(int16_t state, uint8_t port, size_t length, bool confirmed, uint64_t durationNs) {
+    TelemetryUplink uplink;
+    uplink.frameCounter = node->getFCntUp();
+    uint64_t durationUs = durationNs / 1000;
+    uplink.durationUs = durationUs > UINT32_MAX ? UINT32_MAX : (uint32_t)durationUs;
+    uplink.state = state;
+    uplink.rssi = (int16_t)lastRssi;
+    uplink.snrDeci = (int16_t)(lastSnr * 10);
+    uplink.port = port;
+    uplink.length = length > 0xFF ? 0xFF : (uint8_t)length;
+    uplink.flags = (state == RADIOLIB_ERR_NONE ? TELEMETRY_UPLINK_SUCCESS : 0) |
+                   (confirmed ? TELEMETRY_UPLINK_CONFIRMED : 0);
+    telemetrySendUplink(uplink);
+    
+    // A confirmed uplink that got no ack still went out; other errors never reached the air
+    if (state == RADIOLIB_ERR_NONE || state == RADIOLIB_ERR_RX_TIMEOUT) {
+        bool acked = confirmed && state == RADIOLIB_ERR_NONE;
+        accountRadioTime(dataRate, LORA_MAC_OVERHEAD + length, acked ? LORA_MAC_OVERHEAD : 0);
+        energyCountUplink();
+        if (firstUplinkMs == 0) {
+            firstUplinkMs = millis();
+            consolePrintf("[LoRa] First uplink %lu ms after boot, link up at %lu ms (%s)\n", firstUplinkMs, linkUpMs,
+                          getSessionSourceName());
+        }
+    }
+}
+
+// US915 uplink DR0-DR4 and the RX1 reply rate (DR10-DR13 at 500 kHz); RX2 is DR8
+static const uint8_t US915_UPLINK_SF[5] = {10, 9, 8, 7, 8};
+static const uint16_t US915_UPLINK_BW_KHZ[5] = {125, 125, 125, 125, 500};
+static const uint8_t US915_RX1_SF[5] = {10, 9, 8, 7, 7};
+static const uint8_t US915_MAX_PAYLOAD[5] = {11, 53, 125, 242, 242};  // Application bytes, no FOpts
+#define US915_RX_BW_KHZ 500
+#define US915_RX2_SF    12
+
+// Charges one transmission and its receive windows to the energy ledger: a
+// reply is heard in RX1, otherwise both windows stay open for their preamble search
+void LoRaHandler::accountRadioTime(uint8_t uplinkDataRate, size_t phyPayloadBytes, size_t replyBytes) {
+    uint8_t dr = uplinkDataRate < 5 ? uplinkDataRate : 0;
+    energyRecordTx(US915_UPLINK_SF[dr], txPowerDbm,
+                   loraAirtimeUs(US915_UPLINK_SF[dr], US915_UPLINK_BW_KHZ[dr], phyPayloadBytes, true));
+    if (replyBytes > 0) {
+        energyRecordRx(loraAirtimeUs(US915_RX1_SF[dr], US915_RX_BW_KHZ, replyBytes, false));
+    } else {
+        energyRecordRx(LORA_RX_WINDOW_SYMBOLS * (loraSymbolUs(US915_RX1_SF[dr], US915_RX_BW_KHZ) +
+                                                 loraSymbolUs(US915_RX2_SF, US915_RX_BW_KHZ)));
     }
 }
 
 bool LoRaHandler::sendGPSData(float latitude, float longitude, float altitude, int satellites) {
-    if (!initialized || !joined) {
+    if (!initialized || !isJoined()) {
         Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
         return false;
     }
     
     // Create GPS data payload
-    String gpsData = "{\"lat\":" + String(latitude, 6) + 
-                     ",\"lon\":" + String(longitude, 6) + 
-                     ",\"alt\":" + String(altitude, 1) + 
-                     ",\"sats\":" + String(satellites) + "}";
+    FixedString<LORA_JSON_PAYLOAD_MAX> gpsData;
+    gpsData.appendf("{\"lat\":%.6f,\"lon\":%.6f,\"alt\":%.1f,\"sats\":%d}",
+                    latitude, longitude, altitude, satellites);
     
-    return sendData(gpsData, 2);
+    return sendData(gpsData.c_str(), 2);
 }
 
-bool LoRaHandler::sendStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats) {
-    if (!initialized || !joined) {
-        Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
-        return false;
-    }
-    
-    // Create binary payload to minimize size
-    uint8_t payload[24];  // Max 24 bytes: 11 for status + 13 for GPS
-    uint8_t payloadSize = 0;
+static uint16_t saturateU16(float value) {
+    if (value <= 0.0f) return 0;
+    return value >= 65535.0f ? 0xFFFF : (uint16_t)(value + 0.5f);
+}
+
+// Status uplink body (payload_codec.h layout) from the current link state
+size_t LoRaHandler::encodeStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated, uint16_t accuracyM, bool withLatency, uint8_t* payload, size_t capacity) const {
+    // Create binary payload to minimize size (layout in payload_codec.h)
+    StatusPayload status;
+    status.uptimeSeconds = uptime / 1000;
+    status.freeHeapKB = freeHeap / 1024;
+    status.rssiByte = StatusPayload::encodeRssi(lastRssi);
+    status.snrByte = StatusPayload::encodeSnr(lastSnr);
+    status.batteryMv = (uint16_t)(batteryVoltage * 1000);
+    status.batteryPercent = (uint8_t)batteryPercentage;
     
-    // Pack status data into binary format
-    // Uptime (4 bytes) - seconds as uint32
-    uint32_t uptimeSeconds = uptime / 1000;
-    payload[payloadSize++] = (uptimeSeconds >> 24) & 0xFF;
-    payload[payloadSize++] = (uptimeSeconds >> 16) & 0xFF;
-    payload[payloadSize++] = (uptimeSeconds >> 8) & 0xFF;
-    payload[payloadSize++] = uptimeSeconds & 0xFF;
+    // Add GPS data if available
+    if (hasGPS) {
+        status.hasGPS = true;
+        status.latitude = lat;
+        status.longitude = lon;
+        status.altitude = alt;
+        status.satellites = (uint8_t)sats;
+        status.hasPositionQuality = true;
+        status.positionFlags = estimated ? STATUS_FLAG_ESTIMATED : 0;
+        status.accuracyM = accuracyM;
+    }
     
-    // Free heap (2 bytes) - KB as uint16
-    uint16_t heapKB = freeHeap / 1024;
-    payload[payloadSize++] = (heapKB >> 8) & 0xFF;
-    payload[payloadSize++] = heapKB & 0xFF;
+    static_assert(PERF_PROBE_COUNT <= STATUS_PERF_MAX_PROBES, "status uplink has no room for every probe");
+    if (withLatency) {
+        status.perfCount = PERF_PROBE_COUNT;
+        for (int i = 0; i < PERF_PROBE_COUNT; i++) {
+            const PerfHistogram& histogram = perfHistogram((PerfProbe)i);
+            status.perfP50[i] = perfEncodeDuration(histogram.percentileNs(0.50f));
+            status.perfP99[i] = perfEncodeDuration(histogram.percentileNs(0.99f));
+        }
+        
+        const EnergyReport& energy = energyReport();
+        status.hasEnergy = true;
+        status.meanCurrentCentiMa = saturateU16(energy.meanCurrentMa * 100.0f);
+        status.chargePerUplinkUah = saturateU16(energy.mahPerUplink * 1000.0f);
+        status.chargeUsedMah = saturateU16(energy.totalMah);
+    }
     
-    // RSSI (1 byte) - offset by 200 to fit in uint8 (so -100 dBm = 100)
-    uint8_t rssiOffset = (uint8_t)((int)lastRssi + 200);
-    payload[payloadSize++] = rssiOffset;
+    return encodeStatusPayload(status, payload, capacity);
+}
+
+bool LoRaHandler::sendStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated, uint16_t accuracyM) {
+    if (!initialized || !isJoined()) {
+        Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
+        return false;
+    }
+    if (surveying) {
+        return sendSurveyUplink(uptime, freeHeap, batteryVoltage, batteryPercentage, hasGPS, lat, lon, alt, sats,
+                                estimated, accuracyM);
+    }
     
-    // SNR (1 byte) - multiply by 4 for 0.25 precision, offset by 128
-    int8_t snrScaled = (int8_t)((lastSnr * 4) + 128);
-    payload[payloadSize++] = (uint8_t)snrScaled;
+    // One uplink in N asks for an ack, to learn where the downlink path works
+    int32_t latitudeE7 = (int32_t)lround(lat * 1e7);
+    int32_t longitudeE7 = (int32_t)lround(lon * 1e7);
+    ConfirmReason confirmReason = confirmPolicyCheck(hasGPS, latitudeE7, longitudeE7);
+    bool confirmed = confirmReason != CONFIRM_NONE;
     
-    // Battery voltage (2 bytes) - millivolts as uint16
-    uint16_t batteryMV = (uint16_t)(batteryVoltage * 1000);
-    payload[payloadSize++] = (batteryMV >> 8) & 0xFF;
-    payload[payloadSize++] = batteryMV & 0xFF;
+    // Latency summary rides along every few uplinks to keep airtime down
+    bool withLatency = ++statusUplinkCount % LORA_PERF_SUMMARY_EVERY == 0;
+    uint8_t frame[CONFIG_ACK_SIZE + STATUS_MAX_SIZE];
+    uint8_t* payload = frame + CONFIG_ACK_SIZE;
+    uint8_t payloadSize;
+    {
+        POWER_BURST(POWER_BURST_CODEC);
+        payloadSize = encodeStatusData(uptime, freeHeap, batteryVoltage, batteryPercentage, hasGPS, lat, lon, alt, sats,
+                                       estimated, accuracyM, withLatency, payload, STATUS_MAX_SIZE);
+    }
     
-    // Battery percentage (1 byte)
-    payload[payloadSize++] = (uint8_t)batteryPercentage;
+    // A config ack goes in front, and alone where the data rate has no room for both
+    uint8_t port = STATUS_PORT;
+    if (configAckPending) {
+        encodeConfigAck(configAck, frame, CONFIG_ACK_SIZE);
+        payload = frame;
+        port = CONFIG_ACK_PORT;
+        payloadSize = CONFIG_ACK_SIZE + payloadSize <= US915_MAX_PAYLOAD[dataRate] ? CONFIG_ACK_SIZE + payloadSize
+                                                                                   : CONFIG_ACK_SIZE;
+    }
     
-    // Add GPS data if available
-    if (hasGPS) {
-        // Latitude (4 bytes) - float32
-        union { float f; uint32_t i; } latUnion;
-        latUnion.f = lat;
-        payload[payloadSize++] = (latUnion.i >> 24) & 0xFF;
-        payload[payloadSize++] = (latUnion.i >> 16) & 0xFF;
-        payload[payloadSize++] = (latUnion.i >> 8) & 0xFF;
-        payload[payloadSize++] = latUnion.i & 0xFF;
-        
-        // Longitude (4 bytes) - float32
-        union { float f; uint32_t i; } lonUnion;
-        lonUnion.f = lon;
-        payload[payloadSize++] = (lonUnion.i >> 24) & 0xFF;
-        payload[payloadSize++] = (lonUnion.i >> 16) & 0xFF;
-        payload[payloadSize++] = (lonUnion.i >> 8) & 0xFF;
-        payload[payloadSize++] = lonUnion.i & 0xFF;
-        
-        // Altitude (4 bytes) - float32
-        union { float f; uint32_t i; } altUnion;
-        altUnion.f = alt;
-        payload[payloadSize++] = (altUnion.i >> 24) & 0xFF;
-        payload[payloadSize++] = (altUnion.i >> 16) & 0xFF;
-        payload[payloadSize++] = (altUnion.i >> 8) & 0xFF;
-        payload[payloadSize++] = altUnion.i & 0xFF;
+    bool debug = logLevelEnabled(LOG_LEVEL_DEBUG);
+    consolePrintf("[LoRa] Sending binary payload: %d bytes\n", payloadSize);
+    if (debug) {
+        Serial.print("[LoRa] Hex: ");
+        for (int i = 0; i < payloadSize; i++) {
+            consolePrintf("%02X ", payload[i]);
+        }
+        Serial.println();
         
-        // Satellites (1 byte)
-        payload[payloadSize++] = (uint8_t)sats;
+        // Send the binary payload using RadioLib
+        consolePrintf("[LoRa] [DEBUG] (sendStatusData) Before uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), (unsigned long)node->getFCntUp());
     }
-    
-    Serial.printf("[LoRa] Sending binary payload: %d bytes\n", payloadSize);
-    Serial.print("[LoRa] Hex: ");
-    for (int i = 0; i < payloadSize; i++) {
-        Serial.printf("%02X ", payload[i]);
+    PerfTimestamp uplinkStart = perfNow();
+    int result = transmit(payload, payloadSize, port, confirmed);
+    uint64_t uplinkNs = perfElapsedNs(uplinkStart);
+    if (debug) {
+        consolePrintf("[LoRa][DEBUG] node->sendReceive() returned: %d\n", result);
+        consolePrintf("[LoRa] [DEBUG] (sendStatusData) After uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), (unsigned long)node->getFCntUp());
     }
-    Serial.println();
-    
-    // Send the binary payload using RadioLib
-    Serial.printf("[LoRa] [DEBUG] (sendStatusData) Before uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), node->getFCntUp());
-    int result = node->uplink(payload, payloadSize, 3);
-    Serial.printf("[LoRa][DEBUG] node->uplink() returned: %d\n", result);
-    Serial.printf("[LoRa] [DEBUG] (sendStatusData) After uplink: isActivated=%d, fCntUp=%lu\n", node->isActivated(), node->getFCntUp());
-    if (result == RADIOLIB_ERR_NONE) {
+    // A confirmed uplink that got no ack still went out
+    if (result == RADIOLIB_ERR_NONE || (confirmed && result == RADIOLIB_ERR_RX_TIMEOUT)) {
+        bool acked = confirmed && result == RADIOLIB_ERR_NONE;
         Serial.println(F("[LoRa] [SUCCESS] Binary data sent successfully"));
-        lastRssi = radio->getRSSI();
-        lastSnr = radio->getSNR();
+        if (!confirmed || acked) {
+            lastRssi = radio->getRSSI();
+            lastSnr = radio->getSNR();
+        }
         lastErrorCode = RADIOLIB_ERR_NONE;
-        // Manually increment frame counter for debug/testing
-        uint32_t before = session.fCntUp;
-        session.fCntUp++;
-        Serial.printf("[LoRa][DEBUG] Manually incremented fCntUp: %lu -> %lu\n", before, session.fCntUp);
-        saveLoRaSession();
+        lastStatusConfirmed = confirmed;
+        lastStatusAcked = acked;
+        recordConfirmation(confirmReason, hasGPS, latitudeE7, longitudeE7, result);
+        reportUplink(result, port, payloadSize, confirmed, uplinkNs);
+        if (port == CONFIG_ACK_PORT) {
+            configAckPending = false;
+            consolePrintf("[LoRa] Config ack %u sent (revision %u)\n", configAck.sequence, configAck.revision);
+        }
+        countSessionUplink();
         return true;
     } else {
-        Serial.printf("[LoRa] [ERROR] Failed to send binary data, code: %d (%s)\n", result, getErrorString(result).c_str());
-        Serial.printf("[LoRa][DEBUG] Frame counter (fCntUp): %lu\n", node->getFCntUp());
-        Serial.printf("[LoRa][DEBUG] isActivated: %d, joined: %d\n", node->isActivated(), joined);
-        Serial.printf("[LoRa][DEBUG] Last error code: %d\n", lastErrorCode);
-        Serial.print("[LoRa][DEBUG] Payload: ");
-        for (int i = 0; i < payloadSize; i++) {
-            Serial.printf("%02X ", payload[i]);
+        consolePrintf("[LoRa] [ERROR] Failed to send binary data, code: %d (%s)\n", result, getErrorString(result));
+        if (debug) {
+            consolePrintf("[LoRa][DEBUG] Frame counter (fCntUp): %lu\n", (unsigned long)node->getFCntUp());
+            consolePrintf("[LoRa][DEBUG] isActivated: %d, joined: %d\n", node->isActivated(), isJoined());
+            consolePrintf("[LoRa][DEBUG] Last error code: %d\n", lastErrorCode);
+            Serial.print("[LoRa][DEBUG] Payload: ");
+            for (int i = 0; i < payloadSize; i++) {
+                consolePrintf("%02X ", payload[i]);
+            }
+            Serial.println();
+        }
+        lastErrorCode = result;
+        reportUplink(result, port, payloadSize, confirmed, uplinkNs);
+        return false;
+    }
+}
+
+static uint32_t uplinkAirtimeUs(uint8_t uplinkDataRate, size_t payloadBytes) {
+    return loraAirtimeUs(US915_UPLINK_SF[uplinkDataRate], US915_UPLINK_BW_KHZ[uplinkDataRate],
+                         LORA_MAC_OVERHEAD + payloadBytes, true);
+}
+
+// Survey steps set the data rate and power themselves; ADR would undo them
+void LoRaHandler::setRadioSettings(uint8_t uplinkDataRate, int8_t powerDbm) {
+    if (uplinkDataRate != dataRate) {
+        int16_t state = node->setDatarate(uplinkDataRate);
+        if (state == RADIOLIB_ERR_NONE) {
+            dataRate = uplinkDataRate;
+        } else {
+            consolePrintf("[LoRa] [WARN] DR%u refused: %d (%s)\n", uplinkDataRate, state, getErrorString(state));
+        }
+    }
+    if (powerDbm != txPowerDbm) {
+        int16_t state = node->setTxPower(powerDbm);
+        if (state == RADIOLIB_ERR_NONE) {
+            txPowerDbm = powerDbm;
+        } else {
+            consolePrintf("[LoRa] [WARN] TX power %d dBm refused: %d (%s)\n", powerDbm, state, getErrorString(state));
+        }
+    }
+}
+
+bool LoRaHandler::startSurvey(uint8_t powers) {
+    if (!initialized || !node) {
+        Serial.println(F("[LoRa] [ERROR] Cannot start the survey - not initialized"));
+        return false;
+    }
+    if (refuseWhileJoining("Survey")) return false;
+    drSurveyReset(powers);
+    node->setADR(false);
+    surveying = true;
+    lastSurveyAcked = false;
+    surveyCreditMs = LORA_SURVEY_BURST_MS;
+    surveyCreditUpdatedMs = millis();
+    consolePrintf("[LoRa] [SURVEY] Started: DR0-DR%u at %u TX power level(s), %u ms of airtime per hour\n",
+                  DR_SURVEY_DATA_RATES - 1, drSurveyStats().powers, LORA_SURVEY_AIRTIME_MS);
+    return true;
+}
+
+void LoRaHandler::stopSurvey() {
+    if (!surveying || refuseWhileJoining("Stopping the survey")) return;
+    surveying = false;
+    applyDataRatePolicy();
+    consolePrintf("[LoRa] [SURVEY] Stopped after %lu rounds, back to DR%u%s\n", (unsigned long)drSurveyStats().rounds,
+                  dataRate, fixedDataRate == LORA_DATA_RATE_ADR ? " with ADR" : " fixed");
+}
+
+// ADR from the default data rate, or the fixed one with ADR off; at full
+// power either way. Again after a join or restore, which set their own
+void LoRaHandler::applyDataRatePolicy() {
+    if (!node || surveying) return;
+    if (fixedDataRate == LORA_DATA_RATE_ADR) {
+        setRadioSettings(LORA_DEFAULT_DATA_RATE, LORA_TX_POWER_DBM);
+        node->setADR(true);
+        return;
+    }
+    node->setADR(false);
+    int16_t state = node->setDatarate(fixedDataRate);
+    if (state == RADIOLIB_ERR_NONE) {
+        dataRate = fixedDataRate;
+    } else {
+        consolePrintf("[LoRa] [WARN] DR%u refused: %d (%s)\n", fixedDataRate, state, getErrorString(state));
+    }
+    setRadioSettings(dataRate, LORA_TX_POWER_DBM);
+}
+
+bool LoRaHandler::setDataRatePolicy(uint8_t policy) {
+    if (policy != LORA_DATA_RATE_ADR && policy > 4) return false;
+    if (policy == fixedDataRate) return true;
+    if (refuseWhileJoining("Data-rate policy")) return false;
+    fixedDataRate = policy;
+    applyDataRatePolicy();
+    if (policy == LORA_DATA_RATE_ADR) {
+        consolePrintf("[LoRa] Data rate: ADR from DR%u\n", LORA_DEFAULT_DATA_RATE);
+    } else {
+        consolePrintf("[LoRa] Data rate: DR%u fixed, ADR off%s\n", policy, surveying ? " (after the survey)" : "");
+    }
+    return true;
+}
+
+// Uplink and its receive windows through RadioLib's sendReceive(). No
+// downlink is RX_TIMEOUT: fine for an unconfirmed uplink, a missing ack for
+// a confirmed one. Application data that came back is kept for takeDownlink()
+int16_t LoRaHandler::transmit(const uint8_t* data, size_t length, uint8_t port, bool confirmed) {
+    uint8_t received[LORA_DOWNLINK_MAX];
+    size_t receivedLength = 0;
+    LoRaWANEvent_t event;
+    event.port = 0;
+    event.datarate = 0;
+    int16_t state;
+    {
+        PERF_SCOPE(PERF_UPLINK);
+        // RadioLib 6.x takes a non-const pointer but only reads the payload
+        state = node->sendReceive(const_cast<uint8_t*>(data), length, port, received, &receivedLength, confirmed,
+                                  nullptr, &event);
+    }
+    lastRxWindow = state == RADIOLIB_ERR_NONE ? (event.datarate == LORA_RX2_DATA_RATE ? 2 : 1) : 0;
+    if (state == RADIOLIB_ERR_RX_TIMEOUT && !confirmed) return RADIOLIB_ERR_NONE;
+    if (state == RADIOLIB_ERR_NONE && receivedLength > 0 && event.port > 0) {
+        if (downlinkPending) {
+            consolePrintf("[LoRa] [WARN] Downlink on port %u not taken, replaced\n", downlink.port);
         }
+        downlink.port = event.port;
+        downlink.length = (uint8_t)(receivedLength > LORA_DOWNLINK_MAX ? LORA_DOWNLINK_MAX : receivedLength);
+        memcpy(downlink.data, received, downlink.length);
+        downlinkPending = true;
+        downlinkCount++;
+        consolePrintf("[LoRa] Downlink: %u bytes on port %u\n", downlink.length, downlink.port);
+    }
+    return state;
+}
+
+// Outcome of an uplink the confirm policy decided on; errors that kept it off the air do not count
+void LoRaHandler::recordConfirmation(ConfirmReason reason, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7,
+                                     int16_t state) {
+    bool confirmed = reason != CONFIRM_NONE;
+    if (state != RADIOLIB_ERR_NONE && !(confirmed && state == RADIOLIB_ERR_RX_TIMEOUT)) return;
+    bool acked = confirmed && state == RADIOLIB_ERR_NONE;
+    confirmPolicyRecord(reason, hasPosition, latitudeE7, longitudeE7, acked, (int16_t)lastRssi,
+                        (int16_t)(lastSnr * 10), acked ? lastRxWindow : 0);
+    if (confirmed) {
+        consolePrintf("[LoRa] Confirmed (%s): %s", confirmReasonName(reason), acked ? "acked" : "no ack");
+        if (acked) consolePrintf(" in RX%u, %.0f dBm, %.1f dB", lastRxWindow, lastRssi, lastSnr);
         Serial.println();
+    }
+}
+
+bool LoRaHandler::takeDownlink(LoRaDownlink& received) {
+    if (!downlinkPending) return false;
+    received = downlink;
+    downlinkPending = false;
+    return true;
+}
+
+// A newer ack replaces one not sent yet: it carries the later revision
+void LoRaHandler::queueConfigAck(const ConfigAck& ack) {
+    configAck = ack;
+    configAckPending = true;
+}
+
+// One survey step: the status layout when the step's data rate, the dwell
+// time and the budget allow it, else the survey payload, else nothing yet.
+// An uplink the network did not ack still went out and counts as a miss
+bool LoRaHandler::sendSurveyUplink(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated, uint16_t accuracyM) {
+    unsigned long now = millis();
+    surveyCreditMs += (now - surveyCreditUpdatedMs) * (LORA_SURVEY_AIRTIME_MS / 3600000.0f);
+    if (surveyCreditMs > LORA_SURVEY_BURST_MS) surveyCreditMs = LORA_SURVEY_BURST_MS;
+    surveyCreditUpdatedMs = now;
+    
+    DrSurveyStep step = drSurveyCurrentStep();
+    uint8_t payload[STATUS_MAX_SIZE];
+    size_t payloadSize;
+    uint8_t port = STATUS_PORT;
+    {
+        POWER_BURST(POWER_BURST_CODEC);
+        payloadSize = encodeStatusData(uptime, freeHeap, batteryVoltage, batteryPercentage, hasGPS, lat, lon, alt, sats,
+                                       estimated, accuracyM, false, payload, sizeof(payload));
+    }
+    uint32_t airtimeUs = uplinkAirtimeUs(step.dataRate, payloadSize);
+    bool fits = payloadSize <= US915_MAX_PAYLOAD[step.dataRate] && airtimeUs <= LORA_MAX_DWELL_US;
+    if (hasGPS && (!fits || airtimeUs > surveyCreditMs * 1000.0f)) {
+        SurveyPayload survey;
+        survey.dataRate = step.dataRate;
+        survey.txPowerDbm = step.txPowerDbm;
+        survey.latitudeE7 = (int32_t)lround(lat * 1e7);
+        survey.longitudeE7 = (int32_t)lround(lon * 1e7);
+        payloadSize = encodeSurveyPayload(survey, payload, sizeof(payload));
+        port = SURVEY_PORT;
+        airtimeUs = uplinkAirtimeUs(step.dataRate, payloadSize);
+        fits = true;
+    }
+    if (!fits || airtimeUs > surveyCreditMs * 1000.0f) {
+        // Once per step; the periodic sends keep retrying while the budget refills
+        if (drSurveyCountDeferred()) return false;
+        consolePrintf("[LoRa] [SURVEY] DR%u needs %lu ms on air, %.0f ms of budget left: deferred\n", step.dataRate,
+                      (unsigned long)(airtimeUs / 1000), surveyCreditMs);
+        return false;
+    }
+    
+    setRadioSettings(step.dataRate, step.txPowerDbm);
+    PerfTimestamp uplinkStart = perfNow();
+    int16_t result = transmit(payload, payloadSize, port, true);
+    uint64_t uplinkNs = perfElapsedNs(uplinkStart);
+    reportUplink(result, port, payloadSize, true, uplinkNs);
+    if (result != RADIOLIB_ERR_NONE && result != RADIOLIB_ERR_RX_TIMEOUT) {
+        consolePrintf("[LoRa] [SURVEY] [ERROR] DR%u uplink failed, code: %d (%s)\n", step.dataRate, result,
+                      getErrorString(result));
         lastErrorCode = result;
         return false;
     }
+    
+    bool acked = result == RADIOLIB_ERR_NONE;
+    surveyCreditMs -= airtimeUs / 1000.0f;
+    lastSurveyAcked = acked;
+    lastErrorCode = RADIOLIB_ERR_NONE;
+    if (acked) {
+        lastRssi = radio->getRSSI();
+        lastSnr = radio->getSNR();
+    }
+    drSurveyRecord(step, hasGPS, (int32_t)lround(lat * 1e7), (int32_t)lround(lon * 1e7), acked, airtimeUs,
+                   port == SURVEY_PORT);
+    consolePrintf("[LoRa] [SURVEY] DR%u %d dBm: %u bytes on port %u, %lu ms on air, %s\n", step.dataRate,
+                  step.txPowerDbm, (unsigned)payloadSize, port, (unsigned long)(airtimeUs / 1000),
+                  acked ? "acked" : "no ack");
+    drSurveyAdvance();
+    countSessionUplink();
+    return true;
 }
 
 void LoRaHandler::handlePeriodicTasks() {
-    if (!initialized) return;
+    if (!initialized || joining) return;
     
     // Attempt to rejoin if not connected and enough time has passed
     if (!joined && (millis() - lastJoinAttempt > LORA_RETRY_DELAY)) {
         Serial.println(F("[LoRa] [INFO] Attempting periodic rejoin..."));
-        joinNetwork();
-        lastJoinAttempt = millis();
+        startJoin();
+    }
+}
+
+bool LoRaHandler::startJoin() {
+    if (!initialized || joining.exchange(true)) return false;
+    // A rejoin replaces the session; the loop stops sending on the old one
+    joined = false;
+#if defined(NATIVE_SIM)
+    runJoin();
+#else
+    if (xTaskCreatePinnedToCore(joinTask, "lora_join", LORA_JOIN_TASK_STACK, this, LORA_JOIN_TASK_PRIORITY, nullptr,
+                                0) != pdPASS) {
+        Serial.println(F("[LoRa] [WARN] No join task, joining in the foreground"));
+        runJoin();
     }
+#endif
+    return true;
+}
+
+void LoRaHandler::runJoin() {
+    joinNetwork();
+    lastJoinAttempt = millis();
+    joining = false;
+}
+
+// Entry points that touch the node or the session NVS; the join task owns them
+bool LoRaHandler::refuseWhileJoining(const char* what) const {
+    if (!joining) return false;
+    consolePrintf("[LoRa] [WARN] %s refused: a join is running\n", what);
+    return true;
+}
+
+void LoRaHandler::joinTask(void* handler) {
+    ((LoRaHandler*)handler)->runJoin();
+#if !defined(NATIVE_SIM)
+    vTaskDelete(nullptr);
+#endif
 }
 
 bool LoRaHandler::shouldSendData() const {
-    if (!initialized || !joined) return false;
+    if (!initialized || !isJoined()) return false;
     return (millis() - lastSendTime) > LORA_SEND_INTERVAL;
 }
 
@@ -363,6 +878,7 @@ void LoRaHandler::resetDevNonce() {
         Serial.println(F("[LoRa] [ERROR] Cannot reset DevNonce - not initialized"));
         return;
     }
+    if (refuseWhileJoining("DevNonce reset")) return;
     
     Serial.println(F("[LoRa] [INFO] Resetting DevNonce..."));
     
@@ -372,7 +888,7 @@ void LoRaHandler::resetDevNonce() {
     // Reset the LoRaWAN node - this will clear session and force new join
     joined = false;
     
-    Serial.printf("[LoRa] [SUCCESS] DevNonce reset. Next join will use new DevNonce: %u (0x%04X)\n", 
+    consolePrintf("[LoRa] [SUCCESS] DevNonce reset. Next join will use new DevNonce: %u (0x%04X)\n", 
                   newDevNonce, newDevNonce);
     Serial.println(F("[LoRa] [INFO] Device will use new DevNonce on next join attempt"));
 }
@@ -395,20 +911,42 @@ void LoRaHandler::clearPersistence() {
         Serial.println(F("[LoRa] [ERROR] Cannot clear persistence - not initialized"));
         return;
     }
+    if (refuseWhileJoining("Clearing persistence")) return;
     
-    Serial.println(F("[LoRa] [DEBUG] Clearing LoRaWAN session persistence..."));
+    if (logLevelEnabled(LOG_LEVEL_DEBUG)) {
+        Serial.println(F("[LoRa] [DEBUG] Clearing LoRaWAN session persistence..."));
+    }
     
     // Reset join state to force fresh OTAA join
     joined = false;
+    sessionSource = LORA_SESSION_NONE;
     lastErrorCode = 0;
     
-    // Clear any RadioLib persistence (this forces new DevNonce generation)
-    // Note: RadioLib automatically manages DevNonce and will use a new one on next join
+    // Drop the stored session; the nonces stay, so the next join still uses a fresh DevNonce
+    clearLoRaSession();
+    // ... and the node's copy, or a failed rejoin would save it again
+    selectSubBand(subBand);
     
     Serial.println(F("[LoRa] [SUCCESS] ✅ Persistence cleared - next join will use fresh DevNonce"));
     Serial.println(F("[LoRa] [INFO] Device will attempt to rejoin network with new credentials"));
 }
 
+uint64_t LoRaHandler::getJoinEUI() const {
+    uint64_t joinEUI = 0;
+    for (int i = 0; i < 8; i++) {
+        joinEUI = (joinEUI << 8) | APPEUI[i];
+    }
+    return joinEUI;
+}
+
+uint64_t LoRaHandler::getDevEUI() const {
+    uint64_t devEUI = 0;
+    for (int i = 0; i < 8; i++) {
+        devEUI = (devEUI << 8) | DEVEUI[i];
+    }
+    return devEUI;
+}
+
 void LoRaHandler::printStatus() {
     if (!initialized) {
         Serial.println(F("[LoRa] Status: Not initialized"));
@@ -418,14 +956,45 @@ void LoRaHandler::printStatus() {
     Serial.println(F("[LoRa] =========================================="));
     Serial.println(F("[LoRa] Status Report"));
     Serial.println(F("[LoRa] =========================================="));
-    Serial.printf("[LoRa] Initialized: %s\n", initialized ? "YES" : "NO");
-    Serial.printf("[LoRa] Joined: %s\n", joined ? "YES" : "NO");
-    Serial.printf("[LoRa] Last Error: %d (%s)\n", lastErrorCode, getErrorString(lastErrorCode).c_str());
-    Serial.printf("[LoRa] Last RSSI: %.2f dBm\n", lastRssi);
-    Serial.printf("[LoRa] Last SNR: %.2f dB\n", lastSnr);
+    consolePrintf("[LoRa] Initialized: %s\n", initialized ? "YES" : "NO");
+    consolePrintf("[LoRa] Joined: %s\n", isJoined() ? "YES" : "NO");
+    consolePrintf("[LoRa] Session: %s", getSessionSourceName());
+    if (firstUplinkMs) {
+        consolePrintf(", link up %lu ms and first uplink %lu ms after boot\n", linkUpMs, firstUplinkMs);
+    } else {
+        Serial.println();
+    }
+    consolePrintf("[LoRa] Last Error: %d (%s)\n", lastErrorCode, getErrorString(lastErrorCode));
+    consolePrintf("[LoRa] Last RSSI: %.2f dBm\n", lastRssi);
+    consolePrintf("[LoRa] Last SNR: %.2f dB\n", lastSnr);
+    printJoinStats();
     Serial.println(F("[LoRa] =========================================="));
 }
 
+void LoRaHandler::printJoinStats() {
+    consolePrintf("[LoRa] Sub-band %u; learned for this network: ", subBand);
+    if (learnedSubBand) {
+        consolePrintf("%u\n", learnedSubBand);
+    } else {
+        consolePrintf("none (default %u)\n", LORA_SUB_BAND);
+    }
+    if (sequenceRequests > 0) {
+        consolePrintf("[LoRa] Joining: %u request(s) so far, next on sub-band %u\n", sequenceRequests,
+                      joinOrder[joinOrderIndex]);
+    }
+    if (joinStats.joins == 0) {
+        consolePrintf("[LoRa] Joins: none yet, %lu request(s)\n", (unsigned long)joinStats.requests);
+        return;
+    }
+    consolePrintf("[LoRa] Joins: %lu from %lu requests, %lu on the first request; the last took %u request(s)\n",
+                  (unsigned long)joinStats.joins, (unsigned long)joinStats.requests,
+                  (unsigned long)joinStats.firstRequestJoins, joinStats.lastRequests);
+    consolePrintf("[LoRa] Time to join: last %lu ms, min %lu, mean %lu, max %lu; at most %u requests\n",
+                  (unsigned long)joinStats.lastMs, (unsigned long)joinStats.minMs,
+                  (unsigned long)(joinStats.totalMs / joinStats.joins), (unsigned long)joinStats.maxMs,
+                  joinStats.maxRequests);
+}
+
 void LoRaHandler::printNetworkInfo() {
     if (!initialized) {
         Serial.println(F("[LoRa] Network info: Not initialized"));
@@ -444,9 +1013,9 @@ void LoRaHandler::printJoinStatus() {
     Serial.println(F("[LoRa] =========================================="));
     Serial.println(F("[LoRa] Join Status"));
     Serial.println(F("[LoRa] =========================================="));
-    Serial.printf("[LoRa] Activated: %s\n", node->isActivated() ? "YES" : "NO");
-    Serial.printf("[LoRa] RSSI: %.2f dBm\n", lastRssi);
-    Serial.printf("[LoRa] SNR: %.2f dB\n", lastSnr);
+    consolePrintf("[LoRa] Activated: %s\n", node->isActivated() ? "YES" : "NO");
+    consolePrintf("[LoRa] RSSI: %.2f dBm\n", lastRssi);
+    consolePrintf("[LoRa] SNR: %.2f dB\n", lastSnr);
     Serial.println(F("[LoRa] =========================================="));
 }
 
@@ -454,89 +1023,93 @@ void LoRaHandler::printCredentials() {
     Serial.println(F("[LoRa] Credentials (MSB format):"));
     Serial.print(F("[LoRa] DevEUI: "));
     for (int i = 0; i < 8; i++) {
-        Serial.printf("%02X", DEVEUI[i]);
+        consolePrintf("%02X", DEVEUI[i]);
         if (i < 7) Serial.print(":");
     }
     Serial.println();
     
     Serial.print(F("[LoRa] AppEUI: "));
     for (int i = 0; i < 8; i++) {
-        Serial.printf("%02X", APPEUI[i]);
+        consolePrintf("%02X", APPEUI[i]);
         if (i < 7) Serial.print(":");
     }
     Serial.println();
     
     Serial.print(F("[LoRa] AppKey: "));
     for (int i = 0; i < 16; i++) {
-        Serial.printf("%02X", APPKEY[i]);
+        consolePrintf("%02X", APPKEY[i]);
         if (i < 15) Serial.print(":");
     }
     Serial.println();
 }
 
-String LoRaHandler::getErrorString(int16_t errorCode) {
+const char* LoRaHandler::getErrorString(int16_t errorCode) const {
     switch (errorCode) {
         case RADIOLIB_ERR_NONE:
-            return F("No error");
+            return "No error";
         case RADIOLIB_ERR_CHIP_NOT_FOUND:
-            return F("Chip not found");
+            return "Chip not found";
         case RADIOLIB_ERR_PACKET_TOO_LONG:
-            return F("Packet too long");
+            return "Packet too long";
         case RADIOLIB_ERR_TX_TIMEOUT:
-            return F("TX timeout");
+            return "TX timeout";
         case RADIOLIB_ERR_RX_TIMEOUT:
-            return F("RX timeout");
+            return "RX timeout";
         case RADIOLIB_ERR_CRC_MISMATCH:
-            return F("CRC mismatch");
+            return "CRC mismatch";
         case RADIOLIB_ERR_INVALID_BANDWIDTH:
-            return F("Invalid bandwidth");
+            return "Invalid bandwidth";
         case RADIOLIB_ERR_INVALID_SPREADING_FACTOR:
-            return F("Invalid spreading factor");
+            return "Invalid spreading factor";
         case RADIOLIB_ERR_INVALID_CODING_RATE:
-            return F("Invalid coding rate");
+            return "Invalid coding rate";
         case RADIOLIB_ERR_INVALID_FREQUENCY:
-            return F("Invalid frequency");
+            return "Invalid frequency";
         case RADIOLIB_ERR_INVALID_OUTPUT_POWER:
-            return F("Invalid output power");
+            return "Invalid output power";
         case RADIOLIB_LORAWAN_SESSION_RESTORED:
-            return F("Session restored");
+            return "Session restored";
         case RADIOLIB_LORAWAN_NEW_SESSION:
-            return F("New session");
+            return "New session";
         case RADIOLIB_LORAWAN_NONCES_DISCARDED:
-            return F("Nonces discarded");
+            return "Nonces discarded";
         case RADIOLIB_LORAWAN_SESSION_DISCARDED:
-            return F("Session discarded");
+            return "Session discarded";
         default:
-            return F("Unknown error");
+            return "Unknown error";
     }
 }
 
 bool LoRaHandler::sendGatewayDiscoveryData(float latitude, float longitude, float altitude, int satellites, float rssi, float snr) {
-    if (!initialized || !joined) {
+    if (!initialized || !isJoined()) {
         Serial.println(F("[LoRa] [ERROR] Not initialized or not joined"));
         return false;
     }
     
     // Create JSON payload for gateway discovery
-    String payload = "{";
-    payload += "\"type\":\"gateway_discovery\",";
-    payload += "\"lat\":" + String(latitude, 6) + ",";
-    payload += "\"lon\":" + String(longitude, 6) + ",";
-    payload += "\"alt\":" + String(altitude, 1) + ",";
-    payload += "\"sats\":" + String(satellites) + ",";
-    payload += "\"rssi\":" + String(rssi, 1) + ",";
-    payload += "\"snr\":" + String(snr, 1) + ",";
-    payload += "\"timestamp\":" + String(millis());
-    payload += "}";
+    FixedString<LORA_JSON_PAYLOAD_MAX> payload;
+    payload.appendf("{\"type\":\"gateway_discovery\",\"lat\":%.6f,\"lon\":%.6f,\"alt\":%.1f,\"sats\":%d,"
+                    "\"rssi\":%.1f,\"snr\":%.1f,\"timestamp\":%lu}",
+                    latitude, longitude, altitude, satellites, rssi, snr, millis());
+    if (payload.truncated()) {
+        Serial.println(F("[LoRa] [ERROR] Gateway discovery payload does not fit"));
+        return false;
+    }
     
-    Serial.printf("[LoRa] [DISCOVERY] Sending gateway discovery data: %s\n", payload.c_str());
+    consolePrintf("[LoRa] [DISCOVERY] Sending gateway discovery data: %s\n", payload.c_str());
     
-    // Send on port 4 for gateway discovery
-    return sendData(payload, 4, true); // Use confirmed transmission for discovery data
+    // Send on port 4 for gateway discovery, confirmed when the policy says so
+    int32_t latitudeE7 = (int32_t)lround(latitude * 1e7);
+    int32_t longitudeE7 = (int32_t)lround(longitude * 1e7);
+    ConfirmReason reason = confirmPolicyCheck(true, latitudeE7, longitudeE7);
+    bool confirmed = reason != CONFIRM_NONE;
+    int16_t state = sendFrame(payload.bytes(), payload.length(), 4, confirmed);
+    recordConfirmation(reason, true, latitudeE7, longitudeE7, state);
+    return state == RADIOLIB_ERR_NONE || (confirmed && state == RADIOLIB_ERR_RX_TIMEOUT);
 }
 
 void LoRaHandler::trackGatewayDiscovery(float latitude, float longitude, float altitude, int satellites) {
-    if (!gatewayDiscoveryEnabled || !joined) {
+    if (!gatewayDiscoveryEnabled || !isJoined()) {
         return;
     }
     
@@ -548,17 +1121,21 @@ void LoRaHandler::trackGatewayDiscovery(float latitude, float longitude, float a
     unsigned long currentTime = millis();
     
     // Check minimum interval between discoveries
-    if (currentTime - lastGatewayDiscoveryTime < MIN_DISCOVERY_INTERVAL) {
+    if (currentTime - lastGatewayDiscoveryTime < minDiscoveryInterval) {
         return;
     }
     
-    // Get current signal quality
-    float currentRssi = radio->getRSSI();
-    float currentSnr = radio->getSNR();
-    
-    // Check for significant signal change or first discovery
-    if (hasSignificantSignalChange(currentRssi, currentSnr) || lastGatewayDiscoveryTime == 0) {
-        Serial.printf("[LoRa] [DISCOVERY] Gateway discovered! RSSI: %.1f dBm, SNR: %.1f dB\n", 
+    // Get current signal quality and check for significant signal change or first discovery
+    float currentRssi, currentSnr;
+    bool discovered;
+    {
+        POWER_BURST(POWER_BURST_SCAN);
+        currentRssi = radio->getRSSI();
+        currentSnr = radio->getSNR();
+        discovered = hasSignificantSignalChange(currentRssi, currentSnr) || lastGatewayDiscoveryTime == 0;
+    }
+    if (discovered) {
+        consolePrintf("[LoRa] [DISCOVERY] Gateway discovered! RSSI: %.1f dBm, SNR: %.1f dB\n", 
                       currentRssi, currentSnr);
         
         // Send discovery data
@@ -581,8 +1158,8 @@ bool LoRaHandler::hasSignificantSignalChange(float newRssi, float newSnr) {
     
     // Check for significant RSSI change
     float rssiChange = abs(newRssi - lastGatewayRssi);
-    if (rssiChange >= SIGNAL_CHANGE_THRESHOLD) {
-        Serial.printf("[LoRa] [DISCOVERY] Significant RSSI change: %.1f -> %.1f dBm (Δ%.1f)\n", 
+    if (rssiChange >= signalChangeThreshold) {
+        consolePrintf("[LoRa] [DISCOVERY] Significant RSSI change: %.1f -> %.1f dBm (Δ%.1f)\n", 
                       lastGatewayRssi, newRssi, rssiChange);
         return true;
     }
@@ -592,7 +1169,7 @@ bool LoRaHandler::hasSignificantSignalChange(float newRssi, float newSnr) {
 
 void LoRaHandler::enableGatewayDiscovery(bool enable) {
     gatewayDiscoveryEnabled = enable;
-    Serial.printf("[LoRa] [DISCOVERY] Gateway discovery %s\n", enable ? "enabled" : "disabled");
+    consolePrintf("[LoRa] [DISCOVERY] Gateway discovery %s\n", enable ? "enabled" : "disabled");
     
     if (enable) {
         // Reset tracking variables
@@ -602,40 +1179,243 @@ void LoRaHandler::enableGatewayDiscovery(bool enable) {
     }
 } 
 
-#define LORA_NVS_NAMESPACE "lora_session"
+void LoRaHandler::setDiscoveryThresholds(float changeDb, unsigned long minIntervalMs) {
+    signalChangeThreshold = changeDb;
+    minDiscoveryInterval = minIntervalMs;
+    consolePrintf("[LoRa] [DISCOVERY] Thresholds: %.1f dB RSSI change, %lu s apart\n", changeDb, minIntervalMs / 1000);
+}
+
+// Copies RadioLib's session and nonces to RTC memory before a deep sleep,
+// and to NVS when uplinks went out since the last save: RTC memory does not
+// outlast a power loss
+bool LoRaHandler::retainSession() {
+    sessionRetained = false;
+    if (!initialized || !isJoined() || !node->isActivated()) return false;
+    memcpy(retainedNonces, node->getBufferNonces(), sizeof(retainedNonces));
+    memcpy(retainedSession, node->getBufferSession(), sizeof(retainedSession));
+    sessionRetained = true;
+    if (uplinksSinceSave > 0) storeSession();
+    consolePrintf("[LoRa] [SLEEP] Session retained (fCntUp=%lu)\n", (unsigned long)node->getFCntUp());
+    return true;
+}
+
+// Frames that may have gone out after the session was saved, skipped in
+// the buffer (RadioLib's layout and signature). False if the signature
+// does not check out, so a damaged buffer is not signed afresh
+static bool advanceFCntUp(uint8_t* buffer, uint32_t frames) {
+    uint16_t signature;
+    memcpy(&signature, buffer + RADIOLIB_LORAWAN_SESSION_SIGNATURE, sizeof(signature));
+    if (signature != LoRaWANNode::checkSum16(buffer, RADIOLIB_LORAWAN_SESSION_SIGNATURE)) return false;
+    uint32_t fCntUp;
+    memcpy(&fCntUp, buffer + RADIOLIB_LORAWAN_SESSION_FCNT_UP, sizeof(fCntUp));
+    fCntUp += frames;
+    memcpy(buffer + RADIOLIB_LORAWAN_SESSION_FCNT_UP, &fCntUp, sizeof(fCntUp));
+    signature = LoRaWANNode::checkSum16(buffer, RADIOLIB_LORAWAN_SESSION_SIGNATURE);
+    memcpy(buffer + RADIOLIB_LORAWAN_SESSION_SIGNATURE, &signature, sizeof(signature));
+    return true;
+}
+
+// Hands a saved session back to RadioLib: the RTC copy after a deep-sleep
+// wake (RTC memory is only kept through deep sleep), the NVS one otherwise.
+// Nonces go back even without a session so DevNonce keeps counting up
+bool LoRaHandler::restoreSession() {
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) sessionRetained = false;
+    if (sessionRetained) {
+        sessionRetained = false;
+        if (applySession(retainedNonces, retainedSession, LORA_SESSION_RTC)) return true;
+    }
+    if (session.bufferLoaded) {
+        if (advanceFCntUp(session.buffer, LORA_SESSION_SAVE_EVERY) &&
+            applySession(session.nonces, session.buffer, LORA_SESSION_NVS)) {
+            // Saved right away, so a reset before the next save does not skip back
+            storeSession();
+            return true;
+        }
+        // Keys of a session RadioLib refused are no use; join afresh
+        clearLoRaSession();
+    } else if (session.noncesLoaded) {
+        int16_t state = node->setBufferNonces(session.nonces);
+        if (state != RADIOLIB_ERR_NONE) {
+            consolePrintf("[LoRa] [WARN] Saved nonces rejected: %d (%s)\n", state, getErrorString(state));
+        }
+    }
+    return false;
+}
+
+bool LoRaHandler::applySession(const uint8_t* nonces, const uint8_t* buffer, LoRaSessionSource source) {
+    const char* tag = source == LORA_SESSION_RTC ? "[LoRa] [SLEEP]" : "[LoRa][NVS]";
+    // RadioLib 6 takes non-const buffers but only reads them
+    int16_t state = node->setBufferNonces(const_cast<uint8_t*>(nonces));
+    if (state == RADIOLIB_ERR_NONE) state = node->setBufferSession(const_cast<uint8_t*>(buffer));
+    if (state != RADIOLIB_ERR_NONE || !node->isActivated()) {
+        consolePrintf("%s Saved session rejected: %d (%s), will join network\n", tag, state, getErrorString(state));
+        return false;
+    }
+    joined = true;
+    sessionSource = source;
+    linkUpMs = millis();
+    consolePrintf("%s Session restored from %s (fCntUp=%lu)\n", tag, source == LORA_SESSION_RTC ? "RTC memory" : "NVS",
+                  (unsigned long)node->getFCntUp());
+    return true;
+}
+
+const char* LoRaHandler::getSessionSourceName() const {
+    switch (sessionSource) {
+        case LORA_SESSION_JOINED: return "joined";
+        case LORA_SESSION_NVS: return "restored from NVS";
+        case LORA_SESSION_RTC: return "restored from RTC";
+        default: return "none";
+    }
+}
+
+void LoRaHandler::sleep() {
+    if (radio) radio->sleep();
+}
+
+#define LORA_NVS_NAMESPACE      "lora_session"
+#define LORA_NVS_RECORD_VERSION 1
+
+// NVS records: layout version, the DevEUI the buffer belongs to, RadioLib's
+// buffer and a CRC-32 over all of it. RadioLib checks its own signature on
+// top; a record from other credentials or another RadioLib buffer size is
+// ignored like a corrupt one
+#define LORA_NVS_RECORD_HEADER  9
+#define LORA_NVS_RECORD_MAX     (LORA_NVS_RECORD_HEADER + RADIOLIB_LORAWAN_SESSION_BUF_SIZE + 4)
+
+static size_t putRecord(Preferences& nvs, const char* key, const uint8_t* buffer, size_t size, uint64_t devEUI) {
+    uint8_t record[LORA_NVS_RECORD_MAX];
+    record[0] = LORA_NVS_RECORD_VERSION;
+    memcpy(record + 1, &devEUI, sizeof(devEUI));
+    memcpy(record + LORA_NVS_RECORD_HEADER, buffer, size);
+    size_t length = LORA_NVS_RECORD_HEADER + size;
+    uint32_t crc = archiveCrc32(record, length);
+    memcpy(record + length, &crc, sizeof(crc));
+    return nvs.putBytes(key, record, length + sizeof(crc));
+}
+
+static bool getRecord(Preferences& nvs, const char* key, uint8_t* buffer, size_t size, uint64_t devEUI) {
+    uint8_t record[LORA_NVS_RECORD_MAX];
+    size_t length = LORA_NVS_RECORD_HEADER + size;
+    if (nvs.getBytesLength(key) != length + 4 || nvs.getBytes(key, record, sizeof(record)) != length + 4) return false;
+    uint32_t crc;
+    memcpy(&crc, record + length, sizeof(crc));
+    if (record[0] != LORA_NVS_RECORD_VERSION || memcmp(record + 1, &devEUI, sizeof(devEUI)) != 0 ||
+        crc != archiveCrc32(record, length)) {
+        return false;
+    }
+    memcpy(buffer, record + LORA_NVS_RECORD_HEADER, size);
+    return true;
+}
 
 void LoRaHandler::saveLoRaSession() {
+    if (refuseWhileJoining("Session save")) return;
+    storeSession();
+}
+
+// Unchanged records (the nonces between joins) cost no flash write
+void LoRaHandler::storeSession() {
+    if (!node) return;
+    PERF_SCOPE(PERF_NVS_SAVE);
+    uint64_t devEUI = getDevEUI();
     nvs.begin(LORA_NVS_NAMESPACE, false);
-    nvs.putUInt("devaddr", session.devAddr);
-    nvs.putBytes("nwkskey", session.nwkSKey, 16);
-    nvs.putBytes("appskey", session.appSKey, 16);
-    nvs.putUInt("fcntup", session.fCntUp);
-    nvs.putUInt("fcntdown", session.fCntDown);
-    nvs.putBool("joined", session.joined);
+    putRecord(nvs, "nonces", node->getBufferNonces(), RADIOLIB_LORAWAN_NONCES_BUF_SIZE, devEUI);
+    if (node->isActivated()) {
+        putRecord(nvs, "session", node->getBufferSession(), RADIOLIB_LORAWAN_SESSION_BUF_SIZE, devEUI);
+    }
     nvs.end();
+    uplinksSinceSave = 0;
     Serial.println(F("[LoRa][NVS] Session saved to NVS"));
 }
 
+void LoRaHandler::countSessionUplink() {
+    if (++uplinksSinceSave >= LORA_SESSION_SAVE_EVERY) storeSession();
+}
+
 bool LoRaHandler::loadLoRaSession() {
-    nvs.begin(LORA_NVS_NAMESPACE, true);
-    session.devAddr = nvs.getUInt("devaddr", 0);
-    nvs.getBytes("nwkskey", session.nwkSKey, 16);
-    nvs.getBytes("appskey", session.appSKey, 16);
-    session.fCntUp = nvs.getUInt("fcntup", 0);
-    session.fCntDown = nvs.getUInt("fcntdown", 0);
-    session.joined = nvs.getBool("joined", false);
+    uint64_t devEUI = getDevEUI();
+    nvs.begin(LORA_NVS_NAMESPACE, false);
+    // Fields of the old, never applied session layout
+    if (nvs.isKey("devaddr")) {
+        static const char* LEGACY_KEYS[] = {"devaddr", "nwkskey", "appskey", "fcntup", "fcntdown", "joined"};
+        for (const char* key : LEGACY_KEYS) nvs.remove(key);
+    }
+    session.noncesLoaded = getRecord(nvs, "nonces", session.nonces, sizeof(session.nonces), devEUI);
+    session.bufferLoaded = session.noncesLoaded && getRecord(nvs, "session", session.buffer, sizeof(session.buffer), devEUI);
     nvs.end();
-    if (session.devAddr == 0 || !session.joined) {
-        Serial.println(F("[LoRa][NVS] No valid session in NVS"));
+    if (!session.bufferLoaded) {
+        consolePrintf("[LoRa][NVS] No valid session in NVS%s\n", session.noncesLoaded ? " (nonces kept)" : "");
         return false;
     }
     Serial.println(F("[LoRa][NVS] Session loaded from NVS"));
     return true;
 }
 
+// Nonces are kept: a DevNonce must never repeat for these credentials
 void LoRaHandler::clearLoRaSession() {
+    session.bufferLoaded = false;
+    sessionRetained = false;
     nvs.begin(LORA_NVS_NAMESPACE, false);
-    nvs.clear();
+    nvs.remove("session");
     nvs.end();
     Serial.println(F("[LoRa][NVS] Session cleared from NVS"));
-} 
\ No newline at end of file
+}
+
+// Learned sub-band, one record per network: keyed by the JoinEUI's low 48
+// bits and checked against all of it. Layout: sub-band, reserved, joins on
+// it (little-endian); clear_persistence leaves it alone
+#define LORA_SUB_BAND_RECORD_SIZE 4
+
+static void subBandKey(char* key, size_t size, uint64_t joinEUI) {
+    snprintf(key, size, "sb%012llx", (unsigned long long)(joinEUI & 0xFFFFFFFFFFFFULL));
+}
+
+void LoRaHandler::loadSubBand() {
+    char key[16];
+    uint8_t record[LORA_SUB_BAND_RECORD_SIZE];
+    uint64_t joinEUI = getJoinEUI();
+    subBandKey(key, sizeof(key), joinEUI);
+    nvs.begin(LORA_NVS_NAMESPACE, true);
+    bool loaded = getRecord(nvs, key, record, sizeof(record), joinEUI);
+    nvs.end();
+    learnedSubBand = loaded && record[0] >= 1 && record[0] <= LORA_SUB_BANDS ? record[0] : 0;
+}
+
+// After a join on the sub-band (counted) or from setPreferredSubBand()
+void LoRaHandler::saveSubBand(uint8_t band, bool joinedOnIt) {
+    char key[16];
+    uint8_t record[LORA_SUB_BAND_RECORD_SIZE] = {};
+    uint64_t joinEUI = getJoinEUI();
+    subBandKey(key, sizeof(key), joinEUI);
+    nvs.begin(LORA_NVS_NAMESPACE, false);
+    uint16_t joins = 0;
+    if (getRecord(nvs, key, record, sizeof(record), joinEUI) && record[0] == band) {
+        joins = (uint16_t)(record[2] | record[3] << 8);
+    }
+    if (joinedOnIt && joins < UINT16_MAX) joins++;
+    record[0] = band;
+    record[1] = 0;
+    record[2] = joins & 0xFF;
+    record[3] = joins >> 8;
+    putRecord(nvs, key, record, sizeof(record), joinEUI);
+    nvs.end();
+    if (learnedSubBand != band) {
+        consolePrintf("[LoRa][NVS] Sub-band %u learned for this network\n", band);
+    }
+    learnedSubBand = band;
+}
+
+bool LoRaHandler::setPreferredSubBand(uint8_t band) {
+    if (!initialized || joining || band > LORA_SUB_BANDS) return false;
+    if (band == 0) {
+        char key[16];
+        subBandKey(key, sizeof(key), getJoinEUI());
+        nvs.begin(LORA_NVS_NAMESPACE, false);
+        nvs.remove(key);
+        nvs.end();
+        learnedSubBand = 0;
+    } else {
+        saveSubBand(band, false);
+    }
+    sequenceRequests = 0;       // The next request plans afresh
+    return true;
+}
@@ -5,14 +5,101 @@
 #include <RadioLib.h>
 #include "Config.h"
 #include <Preferences.h>
+#include <atomic>
 
+#include "fixed_string.h"
+#include "payload_codec.h"
+#include "confirm_policy.h"
+
+#define LORA_PERF_SUMMARY_EVERY 10  // Status uplinks between latency and energy summaries
+#define LORA_JSON_PAYLOAD_MAX   192 // Port 2/4 JSON payloads, built without heap
+
+// Radio time for the energy ledger (energy_ledger.h). RadioLib 6 does not
+// expose the data rate ADR settled on, so airtime assumes this one
+#ifndef LORA_DEFAULT_DATA_RATE
+#define LORA_DEFAULT_DATA_RATE  0   // US915 DR0 (SF10, 125 kHz), as in the network logs
+#endif
+#define LORA_TX_POWER_DBM       22  // SX1262 maximum, where RadioLib's US915 limit clamps
+#define LORA_MAC_OVERHEAD       13  // MHDR, FHDR without options, FPort, MIC
+#define LORA_JOIN_REQUEST_SIZE  23
+#define LORA_JOIN_ACCEPT_SIZE   33  // With the US915 CFList
+#define LORA_RX_WINDOW_SYMBOLS  8   // Preamble search before an empty receive window closes
+#define LORA_JOIN_TASK_STACK    6144    // Background join (startJoin), on the device
+#define LORA_JOIN_TASK_PRIORITY 1
+#define LORA_MAX_DWELL_US       400000  // US915 dwell time limit per uplink
+#define LORA_DATA_RATE_ADR      0xFF    // Data-rate policy: ADR from LORA_DEFAULT_DATA_RATE, else a fixed DR
+#define LORA_DOWNLINK_MAX       242     // US915 RX1 application payload limit
+#define LORA_RX2_DATA_RATE      8       // US915 RX2 (SF12, 500 kHz); RX1 answers on DR10-DR13
+#define LORA_DISCOVERY_CHANGE_DB    10.0f   // RSSI change that counts as a new gateway
+#define LORA_DISCOVERY_INTERVAL_MS  30000   // Minimum time between discovery uplinks
+
+// US915 sub-bands: eight groups of eight 125 kHz channels, and a network's
+// gateways usually listen on one of them. A join tries the sub-band learned
+// for this network (JoinEUI) first, or LORA_SUB_BAND before anything was
+// learned, LORA_SUB_BAND_FIRST_TRIES times; then one request on each other
+// sub-band in a random order, reshuffled every pass. RadioLib picks a random
+// channel inside the sub-band for each request. The sub-band of an accept
+// is kept in NVS, so the next join (after a reset, or a new session) needs
+// no discovery
+#ifndef LORA_SUB_BAND
+#define LORA_SUB_BAND           2
+#endif
+#define LORA_SUB_BANDS          8
+#define LORA_SUB_BAND_FIRST_TRIES 2
+
+// Data-rate survey (startSurvey()): status uplinks rotate through the
+// dr_survey.h schedule with ADR off, each one confirmed so the ack tells
+// whether it was heard. Survey airtime is budgeted as a bucket that fills
+// at LORA_SURVEY_AIRTIME_MS per hour up to LORA_SURVEY_BURST_MS. A step
+// sends the status layout when it fits the data rate, the dwell time and
+// the budget, else the 8-byte survey payload (payload_codec.h, port 5);
+// the slow data rates mostly get the latter. With not even that in the
+// budget the uplink is deferred and the step tried again next time.
+#define LORA_SURVEY_AIRTIME_MS  36000   // 1% of each hour
+#define LORA_SURVEY_BURST_MS    2000
+
+// RadioLib's persistent buffers as kept in NVS. The nonces (DevNonce and
+// JoinNonce) outlive any one session and are saved after every join
+// request; the session buffer carries DevAddr, keys and frame counters and
+// is saved after the join, every LORA_SESSION_SAVE_EVERY uplinks and before
+// a deep sleep. Up to LORA_SESSION_SAVE_EVERY - 1 uplinks can go out after
+// the last save, so a session restored from NVS starts that many frames
+// further on: the network drops a frame counter it has seen
+#define LORA_SESSION_SAVE_EVERY 16
 struct LoRaSession {
-    uint32_t devAddr;
-    uint8_t nwkSKey[16];
-    uint8_t appSKey[16];
-    uint32_t fCntUp;
-    uint32_t fCntDown;
-    bool joined;
+    uint8_t nonces[RADIOLIB_LORAWAN_NONCES_BUF_SIZE];
+    uint8_t buffer[RADIOLIB_LORAWAN_SESSION_BUF_SIZE];
+    bool noncesLoaded;
+    bool bufferLoaded;
+};
+
+// Join requests and time to join, first request of a sequence to its
+// accept (retry waits included)
+struct LoRaJoinStats {
+    uint32_t requests;
+    uint32_t joins;
+    uint32_t firstRequestJoins;     // Accepted on the sequence's first request
+    uint32_t lastMs;
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint64_t totalMs;
+    uint16_t lastRequests;          // Requests the last join took
+    uint16_t maxRequests;
+};
+
+// Application data the network sent in an uplink's receive windows
+struct LoRaDownlink {
+    uint8_t port;
+    uint8_t length;
+    uint8_t data[LORA_DOWNLINK_MAX];
+};
+
+// Where the session in use came from
+enum LoRaSessionSource {
+    LORA_SESSION_NONE = 0,
+    LORA_SESSION_JOINED,        // OTAA join this boot
+    LORA_SESSION_NVS,           // Restored after a reset
+    LORA_SESSION_RTC            // Restored after a deep-sleep wake
 };
 
 class LoRaHandler {
@@ -23,11 +110,36 @@ private:
     
     // Status flags
     bool initialized;
-    bool joined;
+    // Written by the join task on core 0 and read by the loop on core 1.
+    // While joining, the node, the radio and the session NVS belong to the
+    // join task: every entry point that touches them refuses
+    std::atomic<bool> joined;
+    std::atomic<bool> joining;
     
     // Timing
     unsigned long lastSendTime;
     unsigned long lastJoinAttempt;
+    uint32_t statusUplinkCount;
+    
+    // Radio settings the airtime estimate uses, and the policy that sets them
+    uint8_t dataRate;
+    int8_t txPowerDbm;
+    uint8_t fixedDataRate;          // LORA_DATA_RATE_ADR or the DR held with ADR off
+    
+    // Sub-band discovery: the node's sub-band, the learned one and the join plan
+    uint8_t subBand;
+    uint8_t learnedSubBand;         // 0 = nothing learned for this network
+    uint8_t joinOrder[LORA_SUB_BANDS];
+    uint8_t joinOrderIndex;
+    uint8_t joinTriesLeft;
+    uint16_t sequenceRequests;      // Requests since the link was lost
+    unsigned long sequenceStartMs;
+    LoRaJoinStats joinStats;
+    
+    // Session restore and boot-to-first-uplink, in millis() since boot
+    LoRaSessionSource sessionSource;
+    unsigned long linkUpMs;
+    unsigned long firstUplinkMs;
     
     // Error handling
     int16_t lastErrorCode;
@@ -36,14 +148,54 @@ private:
     float lastRssi;
     float lastSnr;
     
+    // Data-rate survey: airtime budget left and the last step's outcome
+    bool surveying;
+    bool lastSurveyAcked;
+    float surveyCreditMs;
+    unsigned long surveyCreditUpdatedMs;
+    
+    // Confirm policy outcome of the last status uplink, and the window of the last downlink (0 = none)
+    bool lastStatusConfirmed;
+    bool lastStatusAcked;
+    uint8_t lastRxWindow;
+    
+    // Last downlink not yet taken, and the config ack for the next status uplink
+    LoRaDownlink downlink;
+    bool downlinkPending;
+    uint32_t downlinkCount;
+    ConfigAck configAck;
+    bool configAckPending;
+    uint8_t uplinksSinceSave;       // Session saves every LORA_SESSION_SAVE_EVERY uplinks
+    
     // Internal methods
     void printJoinStatus();
     void printCredentials();
     Preferences nvs;
     LoRaSession session;
-    void saveLoRaSession();
     bool loadLoRaSession();
     void clearLoRaSession();
+    bool restoreSession();
+    bool applySession(const uint8_t* nonces, const uint8_t* buffer, LoRaSessionSource source);
+    void countSessionUplink();
+    int16_t transmit(const uint8_t* data, size_t length, uint8_t port, bool confirmed);
+    int16_t sendFrame(const uint8_t* data, size_t length, uint8_t port, bool confirmed);
+    void applyDataRatePolicy();
+    void recordConfirmation(ConfirmReason reason, bool hasPosition, int32_t latitudeE7, int32_t longitudeE7, int16_t state);
+    void reportUplink(int16_t state, uint8_t port, size_t length, bool confirmed, uint64_t durationNs);
+    void accountRadioTime(uint8_t uplinkDataRate, size_t phyPayloadBytes, size_t replyBytes);
+    void setRadioSettings(uint8_t uplinkDataRate, int8_t powerDbm);
+    bool sendSurveyUplink(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated, uint16_t accuracyM);
+    void runJoin();
+    static void joinTask(void* handler);
+    bool refuseWhileJoining(const char* what) const;
+    void storeSession();
+    void beginCredentials();
+    void planJoinOrder();
+    void advanceJoinOrder();
+    bool selectSubBand(uint8_t band);
+    void loadSubBand();
+    void saveSubBand(uint8_t band, bool joinedOnIt);
+    void countJoin();
     
 public:
     LoRaHandler();
@@ -51,26 +203,78 @@ public:
     
     // Initialization and setup
     bool initialize();
-    bool configureCredentials();
+    bool configureCredentials();    // Also restores a saved session: join only while !isJoined()
     bool joinNetwork();
+    // Join without blocking the caller: a task on core 0 on the device,
+    // inline in the single-threaded native simulation. A joined node drops
+    // its session first. False if a join is already running or the handler
+    // is not initialized
+    bool startJoin();
     
-    // DevNonce and persistence management
+    // DevNonce and persistence management; refused while a join runs
     void resetDevNonce();
     uint16_t getCurrentDevNonce() const;
     void clearPersistence();
+    void saveLoRaSession();
+    
+    // Deep sleep: session and nonces in RTC memory, radio in sleep mode
+    bool retainSession();
+    void sleep();
     
     // Data transmission
-    bool sendData(const String& data, uint8_t port = 1, bool confirmed = false);
+    bool sendData(const uint8_t* data, size_t length, uint8_t port = 1, bool confirmed = false);
+    bool sendData(const char* text, uint8_t port = 1, bool confirmed = false);
     bool sendGPSData(float latitude, float longitude, float altitude, int satellites);
-    bool sendStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats);
+    bool sendStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated = false, uint16_t accuracyM = 0);
+    size_t encodeStatusData(unsigned long uptime, size_t freeHeap, float batteryVoltage, float batteryPercentage, bool hasGPS, float lat, float lon, float alt, int sats, bool estimated, uint16_t accuracyM, bool withLatency, uint8_t* payload, size_t capacity) const;
     bool sendGatewayDiscoveryData(float latitude, float longitude, float altitude, int satellites, float rssi, float snr);
     
+    // Data-rate survey over 1..DR_SURVEY_MAX_POWERS TX power levels; the
+    // status uplinks (sendStatusData) carry it. Stopping restores ADR and
+    // the default data rate and power
+    bool startSurvey(uint8_t powers = 1);
+    void stopSurvey();
+    bool isSurveying() const { return surveying; }
+    bool getLastSurveyAcked() const { return lastSurveyAcked; }
+    
+    // Whether the last status uplink was confirmed (confirm_policy.h) and acked
+    bool getLastStatusConfirmed() const { return lastStatusConfirmed; }
+    bool getLastStatusAcked() const { return lastStatusAcked; }
+    
+    // LORA_DATA_RATE_ADR, or DR0-DR4 held with ADR off; a survey overrides
+    // it while it runs. Kept across initialize()
+    bool setDataRatePolicy(uint8_t policy);
+    uint8_t getDataRatePolicy() const { return fixedDataRate; }
+    
+    // Downlinks: every uplink listens for one, the last is kept until taken.
+    // A config ack rides on the next status uplink (CONFIG_ACK_PORT)
+    bool takeDownlink(LoRaDownlink& received);
+    void queueConfigAck(const ConfigAck& ack);
+    uint32_t getDownlinkCount() const { return downlinkCount; }
+    
     // Status and monitoring
-    bool isJoined() const { return joined; }
+    bool isJoined() const { return joined && !joining; }
     bool isInitialized() const { return initialized; }
+    bool isJoining() const { return joining; }
     int16_t getLastError() const { return lastErrorCode; }
     float getLastRssi() const { return lastRssi; }
     float getLastSnr() const { return lastSnr; }
+    uint32_t getFrameCounter() const { return node ? node->getFCntUp() : 0; }
+    uint8_t getDataRate() const { return dataRate; }
+    LoRaSessionSource getSessionSource() const { return sessionSource; }
+    const char* getSessionSourceName() const;
+    unsigned long getLinkUpMs() const { return linkUpMs; }            // 0 until restored or joined
+    unsigned long getFirstUplinkMs() const { return firstUplinkMs; }  // 0 until the first uplink after boot
+    uint64_t getDevEUI() const;
+    uint64_t getJoinEUI() const;
+    
+    // Sub-band discovery: 1..8 makes that sub-band the first one tried (and
+    // saves it), 0 forgets what was learned; from the next join on
+    bool setPreferredSubBand(uint8_t band);
+    uint8_t getSubBand() const { return subBand; }
+    uint8_t getLearnedSubBand() const { return learnedSubBand; }
+    const LoRaJoinStats& getJoinStats() const { return joinStats; }
+    void printJoinStats();
     
     // Periodic operations
     void handlePeriodicTasks();
@@ -79,20 +283,21 @@ public:
     // Error handling and debugging
     void printStatus();
     void printNetworkInfo();
-    String getErrorString(int16_t errorCode);
+    const char* getErrorString(int16_t errorCode) const;
     
     // Gateway discovery tracking
     void trackGatewayDiscovery(float latitude, float longitude, float altitude, int satellites);
     bool hasSignificantSignalChange(float newRssi, float newSnr);
     void enableGatewayDiscovery(bool enable = true);
+    void setDiscoveryThresholds(float changeDb, unsigned long minIntervalMs);
     
     // Gateway discovery tracking variables
     bool gatewayDiscoveryEnabled;
     float lastGatewayRssi;
     float lastGatewaySnr;
     unsigned long lastGatewayDiscoveryTime;
-    static const float SIGNAL_CHANGE_THRESHOLD;
-    static const unsigned long MIN_DISCOVERY_INTERVAL;
+    float signalChangeThreshold;
+    unsigned long minDiscoveryInterval;
 };
 
 #endif // LORA_HANDLER_H 
\ No newline at end of file
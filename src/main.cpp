@@ -1,13 +1,32 @@
 #include <Arduino.h>
+#include <esp_attr.h>
 #include "display_handler.h"
 #include "gps_handler.h"
 #include "lora_handler.h"
+#include "sample_logger.h"
+#include "perf_stats.h"
+#include "cpu_load.h"
+#include "energy_ledger.h"
+#include "telemetry.h"
+#include "alloc_audit.h"
+#include "console_print.h"
+#include "command_processor.h"
+#include "battery.h"
+#include "power_manager.h"
+#include "micro_bench.h"
+#include "sleep_cycle.h"
+#include "boot_sequence.h"
+#include "dr_survey.h"
+#include "remote_config.h"
+#include "confirm_policy.h"
+#include "fixed_string.h"
 #include "Config.h"
 
 // Global handler instances
 DisplayHandler displayHandler;
 GPSHandler gpsHandler;
 LoRaHandler loraHandler;
+SampleLogger sampleLogger;
 
 // Application state
 enum AppState {
@@ -17,55 +36,356 @@ enum AppState {
 };
 
 AppState currentState = STATE_INITIALIZING;
-String lastError = "";
+FixedString<63> lastError;
+
+// Serial console commands, assembled across loop passes without blocking
+CommandProcessor commandProcessor;
 
 // Timing variables
 unsigned long lastStatusUpdate = 0;
 unsigned long lastDisplayUpdate = 0;
 unsigned long lastLoRaSend = 0;
 unsigned long bootTime = 0;
+unsigned long awakeWindowStart = 0;     // Deep-sleep cycle: restarted by the button and console commands
+uint32_t commandsSeen = 0;
+bool displayStarted = false;            // Staged boot: the display comes up on the first loop pass
+bool bootReported = false;
+
+// Remote settings as last pushed into the handlers (applyRemoteConfig())
+RemoteConfig appliedConfig;
 
 // Constants
-const unsigned long PERIODIC_INTERVAL = 120; // Send data every 2 minutes (120 seconds) - respects LoRaWAN duty cycle
+const uint32_t ALLOC_AUDIT_WARMUP_LOOPS = 50; // Loop passes before allocations count as steady state
+
+// Heap allocations per loop pass (counts only in the alloc audit build)
+AllocAuditLoop loopAudit(ALLOC_AUDIT_WARMUP_LOOPS);
 
 // Function prototypes
 void initializeSystem();
 void initializeDisplay();
 void initializeGPS();
 void initializeLoRa();
+void initializeSampleLog();
 void handleMainLoop();
-void handleError(const String& error);
+void handleError(const char* error);
 void updateSystemStatus();
-void sendPeriodicData();
+bool sendPeriodicData(const SleepFix* fallback = nullptr);
 void printSystemInfo();
+void printCpuLoad();
+void printEnergy();
+void sendTelemetrySnapshot();
+void printPerfStats();
+void printAllocStats();
+void runSampleCycle();
+void enterDeepSleep();
+void printSleepCycle();
 void onJoinAccept();
+void logCoverageSample(const PositionEstimate& estimate, bool estimated);
+void updateBootMilestones();
+void applyRemoteConfig(bool boot, bool setCycle = false);
+bool configSetsCycle(const ConfigAck& ack);
+void handleDownlinks();
 
-// Helper function to read battery voltage from GPIO 15
-float readBatteryVoltage() {
-    // Use BATTERY_PIN from Config.h
-    uint32_t reading = analogReadMilliVolts(BATTERY_PIN);
-    float voltage = (2.0f * reading) / 1000.0f; // Assume 2:1 voltage divider
-    Serial.printf("[MAIN] Battery voltage on GPIO %d: %.3f V\n", BATTERY_PIN, voltage);
-    return voltage;
+// Serial commands: one handler per entry in COMMANDS below
+static void printCommandMessage(const char* message) {
+    consolePrintf("[MAIN] [CMD] %s\n", message);
 }
 
-// Helper function to convert battery voltage to percentage
-float batteryVoltageToPercentage(float voltage) {
-    // LiPo battery voltage ranges (adjust these based on your battery)
-    const float BATTERY_MIN = 3.0f; // Empty battery voltage
-    const float BATTERY_MAX = 4.2f; // Full battery voltage
-    
-    if (voltage >= BATTERY_MAX) return 100.0f;
-    if (voltage <= BATTERY_MIN) return 0.0f;
-    
-    return ((voltage - BATTERY_MIN) / (BATTERY_MAX - BATTERY_MIN)) * 100.0f;
+static void commandResetDevNonce(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Resetting DevNonce..."));
+    loraHandler.resetDevNonce();
+}
+
+static void commandRejoin(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Attempting to rejoin network..."));
+    if (!loraHandler.startJoin()) {
+        Serial.println(F("[MAIN] [CMD] A join is already running"));
+    }
+}
+
+static void commandStatus(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] System status:"));
+    printSystemInfo();
+    loraHandler.printStatus();
+}
+
+static void commandDevNonce(const CommandArgs&) {
+    consolePrintf("[MAIN] [CMD] Current DevNonce: %u (0x%04X)\n", 
+                  loraHandler.getCurrentDevNonce(), loraHandler.getCurrentDevNonce());
+}
+
+static void commandClearPersistence(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Clearing persistence..."));
+    loraHandler.clearPersistence();
+}
+
+static void commandEnableDiscovery(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Enabling gateway discovery..."));
+    loraHandler.enableGatewayDiscovery(true);
+}
+
+static void commandDisableDiscovery(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Disabling gateway discovery..."));
+    loraHandler.enableGatewayDiscovery(false);
+}
+
+static void commandArchive(const CommandArgs&) {
+    sampleLogger.printStatus();
+}
+
+static void commandArchiveFlush(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Flushing sample log..."));
+    sampleLogger.flush();
+}
+
+static void commandArchiveClear(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Clearing sample log..."));
+    sampleLogger.clear();
+}
+
+static void commandPerf(const CommandArgs&) {
+    printPerfStats();
+}
+
+static void commandPerfReset(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Resetting latency histograms..."));
+    perfReset();
+}
+
+static void commandAllocs(const CommandArgs&) {
+    printAllocStats();
+}
+
+static void commandCpu(const CommandArgs&) {
+    printCpuLoad();
+}
+
+static void commandEnergy(const CommandArgs&) {
+    printEnergy();
+}
+
+static void commandTelemetry(const CommandArgs& args) {
+    telemetrySetEnabled(args.getBool(0, !telemetryEnabled()));
+    consolePrintf("[MAIN] [CMD] Binary telemetry %s (%lu frames sent, %lu dropped)\n",
+                  telemetryEnabled() ? "ON" : "OFF",
+                  (unsigned long)telemetrySentFrames(), (unsigned long)telemetryDroppedFrames());
+}
+
+static void commandBench(const CommandArgs& args) {
+    static MicroBenchResult results[MICRO_BENCH_MAX_RESULTS];
+    // The session-save case writes the node's buffers to NVS
+    if (loraHandler.isJoining()) {
+        Serial.println(F("[MAIN] [CMD] Not while a join runs"));
+        return;
+    }
+    Serial.println(F("[MAIN] [CMD] Running micro-benchmarks..."));
+    size_t count = runMicroBenchmarks(displayHandler, loraHandler, args.getUint(0, 1), results, MICRO_BENCH_MAX_RESULTS);
+    printMicroBenchJson(results, count);
+}
+
+static void commandSleep(const CommandArgs& args) {
+    if (args.has(0)) {
+        sleepCycleSetInterval(args.getUint(0, 0));
+        awakeWindowStart = millis();
+        if (sleepCycleEnabled()) {
+            consolePrintf("[MAIN] [CMD] Deep-sleep cycle every %lu s, sleeping in %lu s\n",
+                          (unsigned long)sleepCycleInterval(), (unsigned long)(SLEEP_AWAKE_WINDOW_MS / 1000));
+        } else {
+            Serial.println(F("[MAIN] [CMD] Deep-sleep cycle off"));
+        }
+    }
+    printSleepCycle();
+}
+
+static void commandReboot(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Restarting..."));
+    sampleLogger.flush();
+    Serial.flush();
+    ESP.restart();
+}
+
+static void commandBoot(const CommandArgs&) {
+    bootPrintReport();
+}
+
+static void commandBattery(const CommandArgs&) {
+    batteryPrintStatus();
+}
+
+static void commandPower(const CommandArgs& args) {
+    if (args.has(0)) {
+        bool enable = args.getBool(0, true);
+        if (!powerSetLightSleep(enable)) {
+            Serial.println(F("[MAIN] [CMD] Light sleep is not supported by this build"));
+        } else {
+            consolePrintf("[MAIN] [CMD] Automatic light sleep %s\n", enable ? "ON" : "OFF");
+        }
+    }
+    powerPrintStatus();
+}
+
+static void commandDisplay(const CommandArgs& args) {
+    if (args.has(0)) {
+        uint32_t timeoutS = args.getUint(0, 0);
+        displayHandler.setIdleTimeout(timeoutS * 1000UL);
+        if (timeoutS == 0) {
+            Serial.println(F("[MAIN] [CMD] Display always on"));
+        } else {
+            consolePrintf("[MAIN] [CMD] Display sleeps after %lu s idle\n", (unsigned long)timeoutS);
+        }
+    }
+    displayHandler.printPowerStatus();
+}
+
+static void commandSurvey(const CommandArgs& args) {
+    if (args.has(0)) {
+        if (!args.getBool(0, false)) {
+            loraHandler.stopSurvey();
+        } else if (!loraHandler.startSurvey((uint8_t)args.getUint(1, 1))) {
+            Serial.println(F("[MAIN] [CMD] The survey needs the radio"));
+            return;
+        }
+    }
+    consolePrintf("[MAIN] [CMD] Data-rate survey %s\n", loraHandler.isSurveying() ? "ON" : "OFF");
+    drSurveyPrintReport();
+}
+
+static void commandSubBand(const CommandArgs& args) {
+    if (args.has(0)) {
+        uint32_t band = args.getUint(0, 0);
+        if (band > LORA_SUB_BANDS || !loraHandler.setPreferredSubBand((uint8_t)band)) {
+            consolePrintf("[MAIN] [CMD] Sub-band must be 1-%u, or 0 to forget; not while a join runs\n", LORA_SUB_BANDS);
+        } else if (band == 0) {
+            Serial.println(F("[MAIN] [CMD] Learned sub-band forgotten, the next join discovers it"));
+        } else {
+            consolePrintf("[MAIN] [CMD] Next join starts on sub-band %lu\n", (unsigned long)band);
+        }
+    }
+    loraHandler.printJoinStats();
+}
+
+static void commandConfirm(const CommandArgs& args) {
+    if (args.has(0)) {
+        confirmPolicySetEnabled(args.getBool(0, true));
+    }
+    confirmPolicyPrintReport();
+}
+
+static void commandConfig(const CommandArgs& args) {
+    if (args.has(0) && loraHandler.isJoining()) {
+        Serial.println(F("[MAIN] [CMD] Config commands wait until the join is done"));
+        return;
+    }
+    if (args.has(0)) {
+        const char* hex = args.getWord(0, "");
+        uint8_t command[LORA_DOWNLINK_MAX];
+        size_t length = 0;
+        bool valid = strlen(hex) % 2 == 0;
+        for (const char* digit = hex; valid && *digit; digit += 2) {
+            char byte[3] = {digit[0], digit[1], 0};
+            char* end;
+            command[length] = (uint8_t)strtoul(byte, &end, 16);
+            valid = *end == 0 && ++length < sizeof(command);
+        }
+        if (!valid || length == 0) {
+            Serial.println(F("[MAIN] [CMD] Config command must be hex bytes, e.g. 0101003C"));
+            return;
+        }
+        ConfigAck ack = remoteConfigHandleCommand(command, length);
+        loraHandler.queueConfigAck(ack);
+        applyRemoteConfig(false, configSetsCycle(ack));
+    }
+    remoteConfigPrint();
+}
+
+static void commandHelp(const CommandArgs&) {
+    Serial.println(F("[MAIN] [CMD] Available commands (separate several with ';'):"));
+    commandProcessor.printHelp();
+}
+
+static const CommandSpec COMMANDS[] = {
+    {"reset_devnonce", "rd", "", "Reset DevNonce and force fresh join", commandResetDevNonce},
+    {"rejoin", "rj", "", "Attempt to rejoin LoRaWAN network", commandRejoin},
+    {"status", "s", "", "Show system status", commandStatus},
+    {"devnonce", "dn", "", "Show DevNonce info", commandDevNonce},
+    {"clear_persistence", "cp", "", "Clear session data (RECOMMENDED for -1108 errors)", commandClearPersistence},
+    {"enable_discovery", "ed", "", "Enable automatic gateway discovery", commandEnableDiscovery},
+    {"disable_discovery", "dd", "", "Disable automatic gateway discovery", commandDisableDiscovery},
+    {"archive", "ar", "", "Show sample log status", commandArchive},
+    {"archive_flush", "af", "", "Write buffered samples to flash", commandArchiveFlush},
+    {"archive_clear", "ac", "", "Delete the sample log", commandArchiveClear},
+    {"perf", "pf", "", "Show latency percentiles per code path", commandPerf},
+    {"perf_reset", "pr", "", "Clear latency histograms", commandPerfReset},
+    {"allocs", "al", "", "Show heap allocations per loop pass", commandAllocs},
+    {"cpu", "cu", "", "Show CPU load per core, task and subsystem", commandCpu},
+    {"energy", "en", "", "Show estimated charge per consumer, per hour and per uplink", commandEnergy},
+    {"telemetry", "tm", "b?", "Binary telemetry frames on/off, toggles without argument (tools/telemetry_decode)", commandTelemetry},
+    {"bench", "bn", "u?", "Micro-benchmarks as JSON, optional iteration multiplier (tools/bench_check)", commandBench},
+    {"sleep", "sl", "u?", "Deep-sleep sample cycle: interval in s (0 = off), report without argument", commandSleep},
+    {"reboot", "rb", "", "Restart; the LoRaWAN session comes back from NVS without a join", commandReboot},
+    {"boot", "bt", "", "Show boot milestones and check their order", commandBoot},
+    {"battery", "ba", "", "Show battery voltage, state of charge and ADC sampling", commandBattery},
+    {"power", "pw", "b?", "CPU clock and light sleep: turn light sleep on/off, report without argument", commandPower},
+    {"display", "dp", "u?", "Display idle timeout in s (0 = always on), power report without argument", commandDisplay},
+    {"survey", "sv", "b?u", "Data-rate survey on/off, optional TX power levels (1-3), reception report without argument", commandSurvey},
+    {"subband", "sb", "u?", "First US915 sub-band for joins (0 = forget the learned one), join stats without argument", commandSubBand},
+    {"confirm", "cn", "b?", "Confirmed-uplink policy on/off (off = all unconfirmed), ack report per cell without argument", commandConfirm},
+    {"config", "cf", "w?", "Apply a config command in hex (as the port 10 downlink), show the settings without argument", commandConfig},
+    {"help", "h", "", "Show this help", commandHelp}
+};
+
+// User button: the interrupt latches a press, so one that comes while the
+// loop is blocked (a send and its receive windows) is not missed
+static volatile bool buttonPressed = false;
+static volatile unsigned long buttonPressedMs = 0;
+unsigned long lastButtonDebounce = 0;
+const unsigned long debounceDelay = 50;
+
+static void IRAM_ATTR onUserButton() {
+    if (!buttonPressed) {
+        buttonPressedMs = millis();
+        buttonPressed = true;
+    }
 }
 
 void setup() {
     Serial.begin(115200);
-    delay(2000); // Wait for serial to initialize
+    SleepWake wake = sleepCycleBegin();
+    remoteConfigBegin();
+    confirmPolicyBegin();
+    applyRemoteConfig(true, wake == SLEEP_WAKE_POWER_ON);
+    bootBegin();
+    displayStarted = false;
+    bootReported = false;
+    cpuLoadInitialize();
+    energyInitialize();
+    powerInitialize();
+    batteryInitialize();
+    
+    // GNSS first: its acquisition is the longest stage and overlaps everything after
+    gpsHandler.enableGPSPower();
+    bootMark(BOOT_GNSS_POWER);
+    
+    // Give a USB console a moment to attach, but only on power-on and no longer than needed
+    if (wake == SLEEP_WAKE_POWER_ON) {
+        unsigned long consoleWaitStart = millis();
+        while (!Serial && millis() - consoleWaitStart < BOOT_CONSOLE_WAIT_MS) {
+            delay(10);
+        }
+    }
     
     bootTime = millis();
+    awakeWindowStart = bootTime;
+    if (!commandProcessor.begin(COMMANDS, sizeof(COMMANDS) / sizeof(COMMANDS[0]), printCommandMessage)) {
+        Serial.println(F("[MAIN] [CMD] [ERROR] Duplicate command name or alias, console commands disabled"));
+    }
+    bootMark(BOOT_CONSOLE);
+    
+    // Timer wake of the deep-sleep cycle: one sample, then back to sleep
+    // (or on into the awake boot below if the cycle was turned off)
+    if (wake == SLEEP_WAKE_TIMER) {
+        runSampleCycle();
+    }
     
     Serial.println(F("\n=== LoRa Gateway Sniffer ==="));
     Serial.println(F("Heltec Wireless Tracker v1.1"));
@@ -74,6 +394,8 @@ void setup() {
     
     // Initialize user button and LED
     pinMode(USER_BUTTON_PIN, INPUT_PULLUP);
+    buttonPressed = false;
+    attachInterrupt(digitalPinToInterrupt(USER_BUTTON_PIN), onUserButton, FALLING);
     pinMode(USER_LED_PIN, OUTPUT);
     digitalWrite(USER_LED_PIN, LOW);
     Serial.println(F("[MAIN] User button and LED initialized"));
@@ -85,14 +407,12 @@ void setup() {
     Serial.println(F("[MAIN] Entering main loop...\n"));
     
     currentState = STATE_RUNNING;
+    bootMark(BOOT_SETUP_DONE);
 }
 
-// Add button state tracking for page switching
-bool lastButtonState = HIGH;
-unsigned long lastButtonDebounce = 0;
-const unsigned long debounceDelay = 50;
-
 void loop() {
+    loopAudit.begin();
+    
     switch (currentState) {
         case STATE_INITIALIZING:
             // Should not reach here after setup
@@ -104,46 +424,75 @@ void loop() {
             break;
             
         case STATE_ERROR:
-            Serial.printf("[MAIN] [ERROR] System in error state: %s\n", lastError.c_str());
+            consolePrintf("[MAIN] [ERROR] System in error state: %s\n", lastError.c_str());
             Serial.println(F("[MAIN] [ERROR] Attempting recovery in 10 seconds..."));
             delay(10000);
             
             // Attempt to recover
             Serial.println(F("[MAIN] [INFO] Attempting system recovery..."));
+            displayStarted = false;
             initializeSystem();
             currentState = STATE_RUNNING;
             break;
     }
     
-    // Small delay to prevent tight loop
+    // Small delay to prevent tight loop; the chip may light-sleep through it
+    powerUpdate(gpsHandler);
     delay(100);
 
-    // Handle user button for page switching
-    bool buttonState = digitalRead(USER_BUTTON_PIN);
-    if (buttonState == LOW && lastButtonState == HIGH && (millis() - lastButtonDebounce > debounceDelay)) {
-        lastButtonDebounce = millis();
-        displayHandler.nextPage();
-        Serial.println(F("[MAIN] User button pressed: switched display page"));
-        // Blink LED to indicate action
-        digitalWrite(USER_LED_PIN, HIGH);
-        delay(50);
-        digitalWrite(USER_LED_PIN, LOW);
+    // User button: wakes a dark display with its page, else switches the page
+    if (buttonPressed) {
+        unsigned long pressedMs = buttonPressedMs;
+        buttonPressed = false;
+        if (pressedMs - lastButtonDebounce > debounceDelay) {
+            lastButtonDebounce = pressedMs;
+            awakeWindowStart = millis();
+            if (displayHandler.wake(pressedMs)) {
+                Serial.println(F("[MAIN] User button pressed: display woken"));
+            } else {
+                displayHandler.nextPage();
+                Serial.println(F("[MAIN] User button pressed: switched display page"));
+            }
+            // Blink LED to indicate action
+            digitalWrite(USER_LED_PIN, HIGH);
+            delay(50);
+            digitalWrite(USER_LED_PIN, LOW);
+        }
+    }
+    
+    // Deep-sleep cycle: back to sleep once nobody has used the device for a while
+    if (commandProcessor.getExecuted() != commandsSeen) {
+        commandsSeen = commandProcessor.getExecuted();
+        awakeWindowStart = millis();
     }
-    lastButtonState = buttonState;
+    if (sleepCycleEnabled() && !loraHandler.isJoining() && millis() - awakeWindowStart > SLEEP_AWAKE_WINDOW_MS) {
+        enterDeepSleep();
+    }
+    
+    cpuLoadUpdate();
+    energyUpdate();
+    batteryUpdate();
+    loopAudit.end();
 }
 
+// Staged boot (boot_sequence.h): the GNSS receiver is already powered, the
+// radio joins in the background and the display only gets its power here;
+// the first loop pass initializes it
 void initializeSystem() {
     Serial.println(F("[MAIN] Starting system initialization..."));
     
-    // Initialize display first for visual feedback
-    initializeDisplay();
-    
     // Initialize GPS
     initializeGPS();
 
     // Initialize LoRa
     initializeLoRa();
     
+    // Open the on-flash sample log
+    initializeSampleLog();
+    
+    // Panel rails settle while setup() finishes
+    displayHandler.enableDisplayPower();
+    
     // Print initial system information
     printSystemInfo();
 }
@@ -156,26 +505,27 @@ void initializeDisplay() {
         return;
     }
     
-            displayHandler.showMessage("Display OK");
+    if (loraHandler.isJoined()) {
+        displayHandler.showSuccess(loraHandler.getSessionSource() == LORA_SESSION_JOINED ? "LoRa Joined!" : "LoRa Restored!");
+    } else {
+        displayHandler.showMessage(loraHandler.isJoining() ? "Joining network..." : "Join failed");
+    }
     Serial.println(F("[MAIN] [SUCCESS] Display initialized"));
 }
 
 void initializeGPS() {
     Serial.println(F("[MAIN] Initializing GPS..."));
-            displayHandler.showMessage("Starting GPS...");
     
     if (!gpsHandler.initialize()) {
         handleError("GPS initialization failed");
         return;
     }
     
-            displayHandler.showMessage("GPS Started");
     Serial.println(F("[MAIN] [SUCCESS] GPS initialized"));
 }
 
 void initializeLoRa() {
     Serial.println(F("[MAIN] Initializing LoRa..."));
-            displayHandler.showMessage("Starting LoRa...");
     
     // Initialize LoRa hardware
     if (!loraHandler.initialize()) {
@@ -183,104 +533,132 @@ void initializeLoRa() {
         return;
     }
     
-            displayHandler.showMessage("LoRa HW OK");
-    
     // Configure credentials
-            displayHandler.showMessage("Configuring...");
     if (!loraHandler.configureCredentials()) {
         handleError("LoRa credential configuration failed");
         return;
     }
+    bootMark(BOOT_RADIO_READY);
     
-            displayHandler.showMessage("Config OK");
-    
-    // Attempt to join network
-            displayHandler.showMessage("Joining network...");
-    if (!loraHandler.joinNetwork()) {
-        // Don't treat join failure as fatal error, it might succeed later
-        Serial.println(F("[MAIN] [WARN] LoRa network join failed, will retry later"));
-                    displayHandler.showMessage("Join failed");
-    } else {
-        displayHandler.showSuccess("LoRa Joined!");
-        Serial.println(F("[MAIN] [SUCCESS] LoRa network joined"));
+    // A session restored from NVS needs no join
+    if (loraHandler.isJoined()) {
+        Serial.println(F("[MAIN] [SUCCESS] LoRa session restored, join skipped"));
+        Serial.println(F("[MAIN] [SUCCESS] LoRa initialized"));
+        return;
     }
     
+    // Join in the background; handlePeriodicTasks() retries after a failure
+    Serial.println(F("[MAIN] Joining network in the background..."));
+    loraHandler.startJoin();
+    
     Serial.println(F("[MAIN] [SUCCESS] LoRa initialized"));
 }
 
+void initializeSampleLog() {
+    Serial.println(F("[MAIN] Initializing sample log..."));
+    
+    // Logging is optional; the sniffer keeps running without flash storage
+    if (!sampleLogger.initialize()) {
+        Serial.println(F("[MAIN] [WARN] Sample log unavailable, coverage samples will not be stored"));
+        return;
+    }
+    
+    Serial.println(F("[MAIN] [SUCCESS] Sample log initialized"));
+}
+
 void handleMainLoop() {
-    // Handle serial commands
-    if (Serial.available()) {
-        String command = Serial.readStringUntil('\n');
-        command.trim();
-        command.toLowerCase();
-        
-        if (command == "reset_devnonce" || command == "rd") {
-            Serial.println(F("[MAIN] [CMD] Resetting DevNonce..."));
-            loraHandler.resetDevNonce();
-        } else if (command == "rejoin" || command == "rj") {
-            Serial.println(F("[MAIN] [CMD] Attempting to rejoin network..."));
-            loraHandler.joinNetwork();
-        } else if (command == "status" || command == "s") {
-            Serial.println(F("[MAIN] [CMD] System status:"));
-            printSystemInfo();
-            loraHandler.printStatus();
-        } else if (command == "devnonce" || command == "dn") {
-            Serial.printf("[MAIN] [CMD] Current DevNonce: %u (0x%04X)\n", 
-                         loraHandler.getCurrentDevNonce(), loraHandler.getCurrentDevNonce());
-        } else if (command == "clear_persistence" || command == "cp") {
-            Serial.println(F("[MAIN] [CMD] Clearing persistence..."));
-            loraHandler.clearPersistence();
-        } else if (command == "enable_discovery" || command == "ed") {
-            Serial.println(F("[MAIN] [CMD] Enabling gateway discovery..."));
-            loraHandler.enableGatewayDiscovery(true);
-        } else if (command == "disable_discovery" || command == "dd") {
-            Serial.println(F("[MAIN] [CMD] Disabling gateway discovery..."));
-            loraHandler.enableGatewayDiscovery(false);
-        } else if (command == "help" || command == "h") {
-            Serial.println(F("[MAIN] [CMD] Available commands:"));
-            Serial.println(F("[MAIN] [CMD] - reset_devnonce (rd): Reset DevNonce and force fresh join"));
-            Serial.println(F("[MAIN] [CMD] - rejoin (rj): Attempt to rejoin LoRaWAN network"));
-            Serial.println(F("[MAIN] [CMD] - status (s): Show system status"));
-            Serial.println(F("[MAIN] [CMD] - devnonce (dn): Show DevNonce info"));
-            Serial.println(F("[MAIN] [CMD] - clear_persistence (cp): Clear session data (RECOMMENDED for -1108 errors)"));
-            Serial.println(F("[MAIN] [CMD] - enable_discovery (ed): Enable automatic gateway discovery"));
-            Serial.println(F("[MAIN] [CMD] - disable_discovery (dd): Disable automatic gateway discovery"));
-            Serial.println(F("[MAIN] [CMD] - help (h): Show this help"));
-        } else if (command.length() > 0) {
-            Serial.printf("[MAIN] [CMD] Unknown command: %s (type 'help' for available commands)\n", command.c_str());
+    PERF_SCOPE(PERF_LOOP);
+    
+    // Last boot stage: the display, once everything that matters more is running
+    if (!displayStarted) {
+        displayStarted = true;
+        CPU_SCOPE(CPU_DISPLAY);
+        initializeDisplay();
+        if (displayHandler.isInitialized()) {
+            bootMark(BOOT_DISPLAY_READY);
         }
     }
+    
+    // Handle serial commands, one complete line at a time
+    CpuSubsystem outerTag = cpuLoadEnter(CPU_SERIAL);
+    commandProcessor.poll(Serial);
+    cpuLoadEnter(outerTag);
 
     // Update GPS data
-    gpsHandler.update();
+    {
+        CPU_SCOPE(CPU_GPS);
+        gpsHandler.update();
+    }
 
     // Update display periodically
     if (millis() - lastDisplayUpdate > DISPLAY_UPDATE_INTERVAL) {
+        CPU_SCOPE(CPU_DISPLAY);
         updateSystemStatus();
         displayHandler.update();
         lastDisplayUpdate = millis();
     }
     
     // Handle LoRa periodic tasks (reconnection attempts, etc.)
-    loraHandler.handlePeriodicTasks();
+    {
+        CPU_SCOPE(CPU_LORA);
+        loraHandler.handlePeriodicTasks();
+    }
+    
+    // Write out partially filled sample log blocks
+    {
+        CPU_SCOPE(CPU_LOGGING);
+        sampleLogger.handlePeriodicTasks();
+    }
 
     // Send periodic data if LoRa is connected
-    if (loraHandler.isJoined() && (millis() - lastLoRaSend > PERIODIC_INTERVAL)) {
+    if (loraHandler.isJoined() && (millis() - lastLoRaSend > remoteConfig().uplinkIntervalMs)) {
+        CPU_SCOPE(CPU_LORA);
         sendPeriodicData();
+        handleDownlinks();
         delay(2000); // Prevent rapid retries, always wait 2 seconds after send
         lastLoRaSend = millis();
     }
     
-    // Print system status periodically
+    // Gateway discovery: a port 4 uplink from a live fix when the signal
+    // moved by the threshold (remote config 0x03), no closer than its interval
+    if (loraHandler.gatewayDiscoveryEnabled && loraHandler.isJoined() && gpsHandler.hasValidFix()) {
+        CPU_SCOPE(CPU_LORA);
+        GPSData gpsData = gpsHandler.getCurrentData();
+        loraHandler.trackGatewayDiscovery(gpsData.latitude, gpsData.longitude, gpsData.altitude, gpsData.satellites);
+        handleDownlinks();
+    }
+    
+    updateBootMilestones();
+    
+    // Print system status periodically, or send it as records when telemetry is on
     if (millis() - lastStatusUpdate > 30000) {
-        printSystemInfo();
+        if (telemetryEnabled()) {
+            sendTelemetrySnapshot();
+        } else if (logLevelEnabled(LOG_LEVEL_INFO)) {
+            printSystemInfo();
+        }
         lastStatusUpdate = millis();
     }
 }
 
-void handleError(const String& error) {
-    Serial.printf("[MAIN] [ERROR] %s\n", error.c_str());
+// Milestones reached inside the handlers; the report goes out with the first uplink
+void updateBootMilestones() {
+    if (bootReported) return;
+    if (loraHandler.getLinkUpMs()) {
+        bootMarkAt(BOOT_LINK_UP, loraHandler.getLinkUpMs());
+    }
+    if (gpsHandler.hasValidFix()) {
+        bootMark(BOOT_FIRST_FIX);
+    }
+    if (loraHandler.getFirstUplinkMs()) {
+        bootMarkAt(BOOT_FIRST_UPLINK, loraHandler.getFirstUplinkMs());
+        bootPrintReport();
+        bootReported = true;
+    }
+}
+
+void handleError(const char* error) {
+    consolePrintf("[MAIN] [ERROR] %s\n", error);
     lastError = error;
     currentState = STATE_ERROR;
     
@@ -292,11 +670,12 @@ void updateSystemStatus() {
     // Update display with current system information
     unsigned long uptime = millis() - bootTime;
     size_t freeHeap = ESP.getFreeHeap();
-    float batteryVoltage = readBatteryVoltage();
-    float batteryPercentage = batteryVoltageToPercentage(batteryVoltage);
+    const BatteryReading& battery = batteryReading();
+    float batteryVoltage = battery.voltage;
+    float batteryPercentage = battery.percent;
     
     // Update system info (pass both voltage and percentage)
-    displayHandler.updateSystemInfo(uptime, freeHeap, 0.0, batteryVoltage, batteryPercentage);
+    displayHandler.updateSystemInfo(uptime, freeHeap, cpuLoadReport(), batteryVoltage, batteryPercentage);
     
     // Update GPS status
     if (gpsHandler.hasValidFix()) {
@@ -310,61 +689,417 @@ void updateSystemStatus() {
     displayHandler.updateLoRaInfo(loraHandler.isJoined(), loraHandler.getLastRssi(), loraHandler.getLastSnr(), loraHandler.isJoined() ? "Connected" : "Disconnected");
 }
 
-void sendPeriodicData() {
+// Status uplink with the live or dead-reckoned position, else `fallback`
+// (the deep-sleep cycle's retained fix) marked as estimated
+bool sendPeriodicData(const SleepFix* fallback) {
     Serial.println(F("[MAIN] Sending periodic data..."));
     digitalWrite(USER_LED_PIN, HIGH);
+    batteryUpdate();
     
     // Get current data
     unsigned long uptime = millis() - bootTime;
     size_t freeHeap = ESP.getFreeHeap();
-    float batteryVoltage = readBatteryVoltage();
-    float batteryPercentage = batteryVoltageToPercentage(batteryVoltage);
+    const BatteryReading& battery = batteryReading();
+    float batteryVoltage = battery.voltage;
+    float batteryPercentage = battery.percent;
     
-    // Get GPS data
-    bool hasGPS = gpsHandler.hasValidFix();
+    // Get GPS data - a dead-reckoned position bridges short outages; one
+    // propagated further than the fix timeout is sent as estimated
+    PositionEstimate estimate;
+    bool hasGPS = gpsHandler.getPositionEstimate(estimate);
+    bool estimated = hasGPS && estimate.ageMs > GPS_TIMEOUT_MS;
     float lat = 0.0, lon = 0.0, alt = 0.0;
     int sats = 0;
+    uint16_t accuracyM = 0;
     
     if (hasGPS) {
         GPSData gpsData = gpsHandler.getCurrentData();
-        lat = gpsData.latitude;
-        lon = gpsData.longitude;
+        lat = estimate.latitudeE7 / 1e7;
+        lon = estimate.longitudeE7 / 1e7;
         alt = gpsData.altitude;
         sats = gpsData.satellites;
+        uint32_t accuracy = (estimate.accuracyMm + 999) / 1000;
+        accuracyM = accuracy > 0xFFFF ? 0xFFFF : (uint16_t)accuracy;
+    } else if (fallback) {
+        lat = fallback->latitudeE7 / 1e7;
+        lon = fallback->longitudeE7 / 1e7;
+        alt = fallback->altitudeM;
+        sats = fallback->satellites;
+        accuracyM = fallback->accuracyM;
     }
+    bool retained = !hasGPS && fallback != nullptr;
+    
+    TelemetryBattery batteryRecord;
+    batteryRecord.millivolts = battery.millivolts;
+    batteryRecord.percent = (uint8_t)batteryPercentage;
+    telemetrySendBattery(batteryRecord);
     
     // Send combined status + GPS + battery data
-    if (loraHandler.sendStatusData(uptime, freeHeap, batteryVoltage, batteryPercentage, hasGPS, lat, lon, alt, sats)) {
-        Serial.printf("[MAIN] Combined data sent successfully (Battery: %.3f V, %.1f%%, GPS: %s)\n", 
-                     batteryVoltage, batteryPercentage, hasGPS ? "Valid" : "No fix");
+    bool sent = loraHandler.sendStatusData(uptime, freeHeap, batteryVoltage, batteryPercentage, hasGPS || retained, lat,
+                                           lon, alt, sats, estimated || retained, accuracyM);
+    if (sent) {
+        consolePrintf("[MAIN] Combined data sent successfully (Battery: %.3f V, %.1f%%, GPS: %s, ±%u m)\n", 
+                     batteryVoltage, batteryPercentage,
+                     hasGPS ? (estimated ? "Estimated" : "Valid") : (retained ? "Retained" : "No fix"), accuracyM);
+        if (hasGPS) {
+            CPU_SCOPE(CPU_LOGGING);
+            logCoverageSample(estimate, estimated);
+        }
     } else {
         Serial.println(F("[MAIN] Failed to send combined data"));
     }
     digitalWrite(USER_LED_PIN, LOW);
+    return sent;
+}
+
+// Pushes the remote settings into the handlers: at boot whatever differs
+// from the handlers' own defaults, later only what changed since the last
+// push, so a console override (`enable_discovery`) holds until a config
+// command changes that setting. The sample cycle lives in RTC memory through
+// deep sleep and `sleep` sets it too, so it is compared with the cycle that
+// is running, and only set on power-on or by a command that carries it: the
+// ack's applied bit then means the cycle is what the command asked
+void applyRemoteConfig(bool boot, bool setCycle) {
+    const RemoteConfig& config = remoteConfig();
+    float changeDb = config.discoveryChangeDeciDb / 10.0f;
+    unsigned long intervalMs = config.discoveryIntervalS * 1000UL;
+    bool thresholdsChanged = config.discoveryChangeDeciDb != appliedConfig.discoveryChangeDeciDb ||
+                             config.discoveryIntervalS != appliedConfig.discoveryIntervalS;
+    if (boot) {
+        appliedConfig = config;
+        appliedConfig.discoveryEnabled = loraHandler.gatewayDiscoveryEnabled;
+        appliedConfig.dataRatePolicy = loraHandler.getDataRatePolicy();
+        thresholdsChanged = loraHandler.signalChangeThreshold != changeDb || loraHandler.minDiscoveryInterval != intervalMs;
+    }
+    if (config.dataRatePolicy != appliedConfig.dataRatePolicy) {
+        loraHandler.setDataRatePolicy(config.dataRatePolicy);
+    }
+    if (config.discoveryEnabled != appliedConfig.discoveryEnabled) {
+        loraHandler.enableGatewayDiscovery(config.discoveryEnabled);
+    }
+    if (thresholdsChanged) {
+        loraHandler.setDiscoveryThresholds(changeDb, intervalMs);
+    }
+    if (setCycle && config.sampleCycleS != sleepCycleInterval()) {
+        sleepCycleSetInterval(config.sampleCycleS);
+        awakeWindowStart = millis();
+        consolePrintf("[MAIN] Deep-sleep cycle every %lu s (remote config)\n", (unsigned long)sleepCycleInterval());
+    }
+    appliedConfig = config;
+}
+
+// Whether a config command set the sample cycle, itself or with the defaults
+bool configSetsCycle(const ConfigAck& ack) {
+    return ack.applied & (CONFIG_ACK_BIT(CONFIG_OP_SAMPLE_CYCLE) | CONFIG_ACK_BIT(CONFIG_OP_DEFAULTS));
+}
+
+// Config commands that came back in an uplink's receive windows; the ack
+// goes out with the next status uplink. One that arrived before a rejoin
+// waits for the join: applying it touches the node
+void handleDownlinks() {
+    LoRaDownlink downlink;
+    if (loraHandler.isJoining() || !loraHandler.takeDownlink(downlink)) return;
+    if (downlink.port != CONFIG_PORT) {
+        consolePrintf("[MAIN] [WARN] Downlink on port %u ignored\n", downlink.port);
+        return;
+    }
+    ConfigAck ack = remoteConfigHandleCommand(downlink.data, downlink.length);
+    loraHandler.queueConfigAck(ack);
+    applyRemoteConfig(false, configSetsCycle(ack));
+}
+
+// Timer wake of the deep-sleep cycle. The GNSS receiver is powered first so
+// its hot start runs while the radio takes the retained session back; the
+// display stays off. Does not return, unless a config downlink turned the
+// cycle off: then the session goes back to RTC memory for the awake boot
+// that follows to take up.
+void runSampleCycle() {
+    Serial.println(F("[MAIN] [SLEEP] Sample cycle"));
+    if (!gpsHandler.initialize()) {
+        Serial.println(F("[MAIN] [SLEEP] [WARN] GPS initialization failed"));
+    }
+    if (loraHandler.initialize() && loraHandler.configureCredentials()) {
+        bootMark(BOOT_RADIO_READY);
+        bool restored = loraHandler.isJoined();
+        if (!restored) {
+            loraHandler.joinNetwork();
+        }
+        sleepCycleRecordLink(restored);
+    }
+    initializeSampleLog();
+    
+    unsigned long fixWaitStart = millis();
+    while (!gpsHandler.hasValidFix() && millis() - fixWaitStart < SLEEP_FIX_TIMEOUT_MS) {
+        gpsHandler.update();
+        powerUpdate(gpsHandler);
+        batteryUpdate();
+        delay(10);
+    }
+    uint32_t fixWaitMs = millis() - fixWaitStart;
+    
+    if (loraHandler.isJoined()) {
+        PositionEstimate estimate;
+        SleepFix retainedFix;
+        bool live = gpsHandler.getPositionEstimate(estimate);
+        bool useRetained = !live && sleepCycleLastFix(retainedFix);
+        if (sendPeriodicData(useRetained ? &retainedFix : nullptr)) {
+            sleepCycleRecordUplink(fixWaitMs, useRetained);
+            const SleepStats& stats = sleepCycleStats();
+            consolePrintf("[MAIN] [SLEEP] Wake to uplink %lu ms (fix wait %lu ms, %s)\n",
+                          (unsigned long)stats.lastWakeToUplinkMs, (unsigned long)fixWaitMs,
+                          live ? "live fix" : (useRetained ? "retained fix" : "no position"));
+        }
+        handleDownlinks();
+    }
+    if (!sleepCycleEnabled()) {
+        Serial.println(F("[MAIN] [SLEEP] Cycle turned off, staying awake"));
+        loraHandler.retainSession();
+        return;
+    }
+    enterDeepSleep();
+}
+
+// What the next wake needs goes to RTC memory, then every consumer the
+// firmware switched on goes down with the chip. Does not return.
+void enterDeepSleep() {
+    Serial.println(F("[MAIN] [SLEEP] Entering deep sleep..."));
+    PositionEstimate estimate;
+    if (gpsHandler.hasValidFix() && gpsHandler.getPositionEstimate(estimate)) {
+        GPSData gpsData = gpsHandler.getCurrentData();
+        SleepFix fix;
+        fix.latitudeE7 = estimate.latitudeE7;
+        fix.longitudeE7 = estimate.longitudeE7;
+        fix.altitudeM = gpsData.altitude;
+        fix.speedMps = gpsData.speed / 3.6f;
+        uint32_t accuracy = (estimate.accuracyMm + 999) / 1000;
+        fix.accuracyM = accuracy > 0xFFFF ? 0xFFFF : (uint16_t)accuracy;
+        fix.satellites = (uint8_t)gpsData.satellites;
+        sleepCycleRetainFix(fix);
+    }
+    loraHandler.retainSession();
+    loraHandler.sleep();
+    sampleLogger.flush();
+    
+    gpsHandler.disableGPSPower();
+    displayHandler.disableDisplayPower();
+    digitalWrite(USER_LED_PIN, LOW);
+    sleepCycleSleep(energyReport().totalMah);
+}
+
+// Record the uplink just sent in the on-flash sample log
+void logCoverageSample(const PositionEstimate& estimate, bool estimated) {
+    CoverageSample sample;
+    if (!gpsHandler.getUnixTimeMs(sample.timeMs)) {
+        return; // No GNSS date yet, the row could not be placed in time
+    }
+    
+    uint32_t accuracy = (estimate.accuracyMm + 999) / 1000;
+    sample.deviceEui = loraHandler.getDevEUI();
+    sample.gatewayId = 0;
+    sample.latitudeE7 = estimate.latitudeE7;
+    sample.longitudeE7 = estimate.longitudeE7;
+    sample.frameCounter = loraHandler.getFrameCounter();
+    sample.accuracyM = accuracy > 0xFFFF ? 0xFFFF : (uint16_t)accuracy;
+    sample.rssi = (int16_t)loraHandler.getLastRssi();
+    sample.snrDeci = (int16_t)(loraHandler.getLastSnr() * 10);
+    sample.gatewayCount = 0;
+    sample.flags = SAMPLE_FLAG_POSITION | SAMPLE_FLAG_DEVICE | (estimated ? SAMPLE_FLAG_ESTIMATED : 0);
+    if (loraHandler.isSurveying()) {
+        // The survey set the data rate itself; outside it ADR may have moved it
+        sample.dataRate = loraHandler.getDataRate();
+        sample.flags |= SAMPLE_FLAG_SURVEY;
+        if (loraHandler.getLastSurveyAcked()) {
+            sample.flags |= SAMPLE_FLAG_ACKED;
+        } else {
+            sample.rssi = 0;        // No ack, no signal to report
+            sample.snrDeci = 0;
+        }
+    } else {
+        sample.dataRate = SAMPLE_DATA_RATE_UNKNOWN;
+        if (loraHandler.getLastStatusConfirmed()) {
+            sample.flags |= SAMPLE_FLAG_CONFIRMED;
+            if (loraHandler.getLastStatusAcked()) {
+                sample.flags |= SAMPLE_FLAG_ACKED;
+            } else {
+                sample.rssi = 0;
+                sample.snrDeci = 0;
+            }
+        }
+    }
+    sampleLogger.append(sample);
 }
 
 void printSystemInfo() {
     Serial.println(F("\n[MAIN] === System Status Report ==="));
-    Serial.printf("[MAIN] Uptime: %lu seconds\n", (millis() - bootTime) / 1000);
-    Serial.printf("[MAIN] Free heap: %zu bytes\n", ESP.getFreeHeap());
-    Serial.printf("[MAIN] Chip model: %s\n", ESP.getChipModel());
-    Serial.printf("[MAIN] CPU frequency: %lu MHz\n", ESP.getCpuFreqMHz());
-    Serial.printf("[MAIN] Flash size: %lu bytes\n", ESP.getFlashChipSize());
+    consolePrintf("[MAIN] Uptime: %lu seconds\n", (millis() - bootTime) / 1000);
+    consolePrintf("[MAIN] Free heap: %lu bytes\n", (unsigned long)ESP.getFreeHeap());
+    consolePrintf("[MAIN] Chip model: %s\n", ESP.getChipModel());
+    consolePrintf("[MAIN] CPU frequency: %lu MHz\n", (unsigned long)ESP.getCpuFreqMHz());
+    consolePrintf("[MAIN] Flash size: %lu bytes\n", (unsigned long)ESP.getFlashChipSize());
+    printCpuLoad();
+    printEnergy();
+    printSleepCycle();
     
     // Print handler status
     Serial.println(F("\n[MAIN] === Handler Status ==="));
-    Serial.printf("[MAIN] Display: %s\n", displayHandler.isInitialized() ? "OK" : "ERROR");
-    Serial.printf("[MAIN] GPS: %s\n", gpsHandler.isInitialized() ? "OK" : "ERROR");
-    Serial.printf("[MAIN] LoRa: %s\n", loraHandler.isInitialized() ? "OK" : "ERROR");
+    consolePrintf("[MAIN] Display: %s\n", displayHandler.isInitialized() ? "OK" : "ERROR");
+    consolePrintf("[MAIN] GPS: %s\n", gpsHandler.isInitialized() ? "OK" : "ERROR");
+    consolePrintf("[MAIN] LoRa: %s\n", loraHandler.isInitialized() ? "OK" : "ERROR");
     
     // Print detailed status from each handler
     gpsHandler.printStatus();
     loraHandler.printStatus();
     displayHandler.printStatus();
+    sampleLogger.printStatus();
     
     Serial.println(F("[MAIN] === End Status Report ===\n"));
 }
 
+// System, battery and latency records in place of the periodic text report
+void sendTelemetrySnapshot() {
+    const CpuLoadReport& load = cpuLoadReport();
+    TelemetrySystem system;
+    system.freeHeap = ESP.getFreeHeap();
+    system.minFreeHeap = ESP.getMinFreeHeap();
+    for (int core = 0; core < 2; core++) {
+        system.coreLoad[core] = core < load.coreCount ? (uint8_t)(load.coreLoad[core] + 0.5f) : 0;
+    }
+    static_assert(CPU_SUBSYSTEM_COUNT == TELEMETRY_SUBSYSTEMS, "telemetry system record carries every CPU subsystem");
+    for (int i = 0; i < CPU_SUBSYSTEM_COUNT; i++) {
+        system.subsystemLoad[i] = (uint8_t)(load.subsystemLoad[i] + 0.5f);
+    }
+    telemetrySendSystem(system);
+    
+    TelemetryBattery battery;
+    battery.millivolts = batteryReading().millivolts;
+    battery.percent = (uint8_t)batteryReading().percent;
+    telemetrySendBattery(battery);
+    
+    telemetrySendPerf();
+}
+
+// Load over the last completed CPU_LOAD_WINDOW_MS window; subsystems are
+// the loop task's CPU_SCOPE tags, as a share of one core
+void printCpuLoad() {
+    const CpuLoadReport& load = cpuLoadReport();
+    if (!load.valid) {
+        Serial.println(F("[MAIN] CPU load: no complete window yet"));
+        return;
+    }
+    
+    consolePrintf("[MAIN] CPU load over %lu ms:", (unsigned long)load.windowMs);
+    for (uint8_t core = 0; core < load.coreCount; core++) {
+        consolePrintf(" core%u %.1f%%", core, load.coreLoad[core]);
+    }
+    Serial.println();
+    
+    Serial.print(F("[MAIN] CPU by subsystem:"));
+    for (int i = 0; i < CPU_SUBSYSTEM_COUNT; i++) {
+        consolePrintf(" %s %.1f%%", cpuSubsystemName((CpuSubsystem)i), load.subsystemLoad[i]);
+    }
+    Serial.println();
+    
+    for (uint8_t i = 0; i < load.taskCount; i++) {
+        consolePrintf("[MAIN] CPU task %-16s core%u %5.1f%%\n", load.tasks[i].name, load.tasks[i].core, load.tasks[i].load);
+    }
+}
+
+// Charge estimate from the energy ledger: time in each power state priced
+// with the current table in energy_ledger.h
+void printEnergy() {
+    const EnergyReport& energy = energyReport();
+    consolePrintf("[MAIN] Energy: %.2f mAh over %.2f h, %.2f mAh/h", energy.totalMah, energy.elapsedMs / 3600000.0f,
+                  energy.meanCurrentMa);
+    if (energy.uplinks > 0) {
+        consolePrintf(", %.3f mAh/uplink (radio %.3f), %.1f uplinks/mAh", energy.mahPerUplink, energy.radioMahPerUplink,
+                      energy.mahPerUplink > 0 ? 1.0f / energy.mahPerUplink : 0.0f);
+    }
+    Serial.println();
+    
+    Serial.print(F("[MAIN] Energy by consumer (mAh):"));
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) {
+        consolePrintf(" %s %.3f", energyConsumerName((EnergyConsumer)i), energy.chargeMah[i]);
+    }
+    Serial.println();
+    
+    Serial.print(F("[MAIN] CPU time (s) active/idle:"));
+    for (int i = 0; i < ENERGY_CPU_FREQ_COUNT; i++) {
+        consolePrintf(" %uMHz %.1f/%.1f", energyCpuFrequencyMhz(i), energy.cpuActiveUs[i] / 1e6, energy.cpuIdleUs[i] / 1e6);
+    }
+    consolePrintf("; light sleep %.1f\n", energy.lightSleepUs / 1e6);
+    
+    consolePrintf("[MAIN] Radio time (ms): RX %.1f, TX", energy.rxUs / 1e3);
+    for (int sf = 0; sf < ENERGY_SF_COUNT; sf++) {
+        for (int level = 0; level < ENERGY_TX_LEVEL_COUNT; level++) {
+            if (energy.txUs[sf][level] == 0) continue;
+            consolePrintf(" SF%d@%ddBm %.1f", sf + ENERGY_SF_MIN, energyTxLevelDbm(level), energy.txUs[sf][level] / 1e3);
+        }
+    }
+    consolePrintf("; GNSS %.1f s, backlight %.1f s\n", energy.gnssUs / 1e6, energy.backlightUs / 1e6);
+}
+
+// Deep-sleep cycle over every wake since power-on
+void printSleepCycle() {
+    const SleepStats& stats = sleepCycleStats();
+    if (sleepCycleEnabled()) {
+        consolePrintf("[MAIN] [SLEEP] Cycle every %lu s; this boot: %s wake\n", (unsigned long)sleepCycleInterval(),
+                      sleepWakeName(sleepCycleWake()));
+    } else {
+        Serial.println(F("[MAIN] [SLEEP] Cycle off"));
+    }
+    if (stats.sleeps == 0) return;
+    consolePrintf("[MAIN] [SLEEP] %lu sleeps, %lu timer and %lu button wakes, %lu slots skipped\n",
+                  (unsigned long)stats.sleeps, (unsigned long)stats.timerWakes, (unsigned long)stats.buttonWakes,
+                  (unsigned long)stats.skippedSlots);
+    consolePrintf("[MAIN] [SLEEP] Session restored %lu times, rejoined %lu; %lu uplinks (%lu with the retained fix)\n",
+                  (unsigned long)stats.sessionsRestored, (unsigned long)stats.rejoins, (unsigned long)stats.uplinks,
+                  (unsigned long)stats.retainedFixUplinks);
+    if (stats.uplinks > 0) {
+        consolePrintf("[MAIN] [SLEEP] Wake to uplink (ms): last %lu, min %lu, mean %lu, max %lu; fix wait mean %lu\n",
+                      (unsigned long)stats.lastWakeToUplinkMs, (unsigned long)stats.minWakeToUplinkMs,
+                      (unsigned long)stats.meanWakeToUplinkMs(), (unsigned long)stats.maxWakeToUplinkMs,
+                      (unsigned long)stats.meanFixWaitMs());
+    }
+    uint64_t totalMs = stats.awakeMs + stats.asleepMs;
+    consolePrintf("[MAIN] [SLEEP] Awake %.1f%% of %.2f h; %.3f mAh awake + %.3f mAh asleep = %.3f mA average\n",
+                  totalMs ? 100.0f * stats.awakeMs / totalMs : 0.0f, totalMs / 3600000.0f, stats.awakeMah,
+                  stats.asleepMah, stats.meanCurrentMa());
+}
+
+// Latency table from the PERF_SCOPE histograms; times in milliseconds
+void printPerfStats() {
+    Serial.println(F("\n[PERF] === Latency (ms) ==="));
+    Serial.println(F("[PERF] probe              count       p50       p90       p99       max      mean"));
+    for (int i = 0; i < PERF_PROBE_COUNT; i++) {
+        const PerfHistogram& histogram = perfHistogram((PerfProbe)i);
+        consolePrintf("[PERF] %-16s %7lu %9.3f %9.3f %9.3f %9.3f %9.3f\n", perfProbeName((PerfProbe)i),
+                      (unsigned long)histogram.getCount(), histogram.percentileNs(0.50f) / 1e6,
+                      histogram.percentileNs(0.90f) / 1e6, histogram.percentileNs(0.99f) / 1e6,
+                      histogram.getMaxNs() / 1e6, histogram.getMeanNs() / 1e6);
+    }
+    Serial.println(F("[PERF] === End Latency ===\n"));
+}
+
+// Heap allocations per loop pass; steady state should show none
+void printAllocStats() {
+    if (!allocAuditEnabled()) {
+        Serial.println(F("[MAIN] [ALLOC] Not counted in this build (use env heltec_wireless_tracker_alloc_audit)"));
+        return;
+    }
+    AllocAuditStats stats = allocAuditSnapshot();
+    consolePrintf("[MAIN] [ALLOC] Since boot: %lu allocations, %lu bytes\n",
+                  (unsigned long)stats.allocations, (unsigned long)stats.bytes);
+    if (stats.hostAllocations) {
+        consolePrintf("[MAIN] [ALLOC] Host (simulated peripherals): %lu allocations, not counted\n",
+                      (unsigned long)stats.hostAllocations);
+    }
+    consolePrintf("[MAIN] [ALLOC] Loop passes: %lu (first %lu are warm-up)\n",
+                  (unsigned long)loopAudit.getIterations(), (unsigned long)ALLOC_AUDIT_WARMUP_LOOPS);
+    consolePrintf("[MAIN] [ALLOC] Steady state: %lu passes allocated, worst %lu, last %lu\n",
+                  (unsigned long)loopAudit.getAllocatingIterations(),
+                  (unsigned long)loopAudit.getWorstAllocations(), (unsigned long)loopAudit.getLastAllocations());
+}
+
 void onJoinAccept() {
     Serial.println(F("[MAIN] ✅ Join accepted!"));
     displayHandler.updateLoRaInfo(true, 0, 0.0, "Connected");
@@ -0,0 +1,166 @@
+#include "micro_bench.h"
+#include "console_print.h"
+#include "gps_handler.h"
+#include "display_handler.h"
+#include "lora_handler.h"
+#include "battery.h"
+#include "perf_stats.h"
+#include "alloc_audit.h"
+#include "payload_codec.h"
+
+// One receiver epoch as the UC6580 sends it at 1 Hz
+static const char NMEA_EPOCH[] =
+    "$GNGGA,141503.00,3017.11200,N,09744.58600,W,1,09,0.95,152.3,M,-23.4,M,,*78\r\n"
+    "$GNGSA,A,3,05,07,13,15,18,20,23,24,30,,,,1.72,0.95,1.43*19\r\n"
+    "$GPGSV,3,1,10,05,45,062,42,07,23,312,38,13,67,205,45,15,12,145,33*73\r\n"
+    "$GPGSV,3,2,10,18,55,030,44,20,31,270,40,23,08,095,29,24,40,180,41*72\r\n"
+    "$GPGSV,3,3,10,30,18,330,35,28,04,050,*7F\r\n"
+    "$GNRMC,141503.00,A,3017.11200,N,09744.58600,W,23.33,87.40,010625,,,A*58\r\n"
+    "$GNVTG,87.40,T,,M,23.33,N,43.21,K,A*1D\r\n";
+
+static DisplayHandler* benchDisplay = nullptr;
+static LoRaHandler* benchLora = nullptr;
+
+// Results land here so the compiler cannot drop pure calls
+static volatile float benchSink = 0;
+
+static GPSHandler& benchGps() {
+    static GPSHandler parser;
+    return parser;
+}
+
+static void benchStatusEncode(uint32_t i, bool withLatency) {
+    uint8_t payload[STATUS_MAX_SIZE];
+    size_t size = benchLora->encodeStatusData(3600000UL + i, 180000, 3.92f, 76.0f, true, 30.2852f, -97.7431f, 152.3f, 9,
+                                              false, 12, withLatency, payload, sizeof(payload));
+    benchSink = benchSink + payload[size - 1];
+}
+
+static void benchStatus(uint32_t i) {
+    benchStatusEncode(i, false);
+}
+
+static void benchStatusLatency(uint32_t i) {
+    benchStatusEncode(i, true);
+}
+
+static void benchNmea(uint32_t) {
+    benchGps().processNmea(NMEA_EPOCH, sizeof(NMEA_EPOCH) - 1);
+}
+
+static void benchPageStatus(uint32_t) {
+    benchDisplay->renderPage(PAGE_STATUS);
+}
+
+static void benchPageGps(uint32_t) {
+    benchDisplay->renderPage(PAGE_GPS);
+}
+
+static void benchPageLora(uint32_t) {
+    benchDisplay->renderPage(PAGE_LORA);
+}
+
+static void benchPageSystem(uint32_t) {
+    benchDisplay->renderPage(PAGE_SYSTEM);
+}
+
+static void benchSessionSave(uint32_t) {
+    benchLora->saveLoRaSession();
+}
+
+static void benchBattery(uint32_t i) {
+    benchSink = benchSink + batteryVoltageToPercentage(2.9f + (i % 1400) * 0.001f);
+}
+
+static void benchDistance(uint32_t i) {
+    benchSink = benchSink + benchGps().distanceTo(30.2672f + (i % 100) * 0.001f, -97.7431f);
+}
+
+static void benchCourse(uint32_t i) {
+    benchSink = benchSink + benchGps().courseTo(30.2672f, -97.7431f + (i % 100) * 0.001f);
+}
+
+struct MicroBenchCase {
+    const char* name;
+    uint32_t iterations;        // Per round, sized so the whole suite takes a few seconds on the device
+    void (*run)(uint32_t i);
+};
+
+static const MicroBenchCase CASES[] = {
+    {"status_encode", 1000, benchStatus},
+    {"status_encode_latency", 100, benchStatusLatency},
+    {"nmea_epoch", 20, benchNmea},
+    {"page_status", 4, benchPageStatus},
+    {"page_gps", 4, benchPageGps},
+    {"page_lora", 4, benchPageLora},
+    {"page_system", 4, benchPageSystem},
+    {"nvs_session_save", 10, benchSessionSave},
+    {"battery_percent", 5000, benchBattery},
+    {"gps_distance_to", 2000, benchDistance},
+    {"gps_course_to", 2000, benchCourse}
+};
+
+static const size_t CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+size_t runMicroBenchmarks(DisplayHandler& display, LoRaHandler& lora, uint32_t scale, MicroBenchResult* results,
+                          size_t capacity) {
+    benchDisplay = &display;
+    benchLora = &lora;
+    if (scale == 0) scale = 1;
+    // The page cases draw nothing on a dark panel
+    display.wake(millis());
+    // Distance and course need the parser's fix
+    benchGps().processNmea(NMEA_EPOCH, sizeof(NMEA_EPOCH) - 1);
+
+    size_t count = 0;
+    for (size_t c = 0; c < CASE_COUNT && count < capacity; c++) {
+        const MicroBenchCase& bench = CASES[c];
+        uint32_t iterations = bench.iterations * scale;
+
+        // Warm caches and first-use paths outside the measurement
+        for (uint32_t i = 0; i < bench.iterations / 10 + 1; i++) bench.run(i);
+
+        AllocAuditStats allocsBefore = allocAuditSnapshot();
+        uint64_t bestNs = UINT64_MAX;
+        for (int round = 0; round < MICRO_BENCH_ROUNDS; round++) {
+            PerfTimestamp start = perfNow();
+            for (uint32_t i = 0; i < iterations; i++) bench.run(i);
+            uint64_t elapsedNs = perfElapsedNs(start);
+            if (elapsedNs < bestNs) bestNs = elapsedNs;
+        }
+        AllocAuditStats allocsAfter = allocAuditSnapshot();
+
+        MicroBenchResult& result = results[count++];
+        result.name = bench.name;
+        result.iterations = iterations;
+        result.bestRoundNs = bestNs;
+        result.allocations = allocsAfter.allocations - allocsBefore.allocations;
+        result.bytes = allocsAfter.bytes - allocsBefore.bytes;
+    }
+    return count;
+}
+
+void printMicroBenchJson(const MicroBenchResult* results, size_t count) {
+#if defined(ARDUINO)
+    const char* platform = "esp32-s3";
+#else
+    const char* platform = "native";
+#endif
+    bool counted = allocAuditEnabled();
+    Serial.print(F("{\"benchmarks\":["));
+    for (size_t i = 0; i < count; i++) {
+        const MicroBenchResult& result = results[i];
+        double iterations = result.iterations ? result.iterations : 1;
+        double operations = iterations * MICRO_BENCH_ROUNDS;
+        consolePrintf("%s{\"name\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f", i ? "," : "", result.name,
+                      (unsigned long)result.iterations, result.bestRoundNs / iterations);
+        if (counted) {
+            consolePrintf(",\"allocs_per_op\":%.3f,\"bytes_per_op\":%.1f}", result.allocations / operations,
+                          result.bytes / operations);
+        } else {
+            Serial.print(F(",\"allocs_per_op\":null,\"bytes_per_op\":null}"));
+        }
+    }
+    consolePrintf("],\"platform\":\"%s\",\"cpu_mhz\":%lu,\"alloc_audit\":%s}\n", platform,
+                  (unsigned long)getCpuFrequencyMhz(), counted ? "true" : "false");
+}
@@ -0,0 +1,40 @@
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class DisplayHandler;
+class LoRaHandler;
+
+// Micro-benchmarks of the firmware's hot functions, run from the `bench`
+// console command on the device or in the native simulation. Each case
+// reports ns/op of its fastest round (perf_stats.h clock) and, when the
+// build counts them (alloc_audit.h), heap allocations and bytes per op
+// over all rounds. The result is one JSON
+// line starting with {"benchmarks": that tools/bench_check.cpp compares with
+// the committed baseline (tools/bench_baseline.json).
+//
+// NMEA parsing runs on a private GPSHandler so the live fix is untouched;
+// page renders and the session save use the live handlers (NVS skips the
+// unchanged values, so repeated saves cost no flash).
+
+#define MICRO_BENCH_MAX_RESULTS 16
+#define MICRO_BENCH_ROUNDS      5       // Fastest round counts; the others absorb interrupts and task switches
+
+struct MicroBenchResult {
+    const char* name;
+    uint32_t iterations;        // Per round
+    uint64_t bestRoundNs;
+    uint32_t allocations;       // Over all rounds
+    uint32_t bytes;
+};
+
+// Runs every case with its iteration count multiplied by `scale`; returns
+// the number of results written
+size_t runMicroBenchmarks(DisplayHandler& display, LoRaHandler& lora, uint32_t scale, MicroBenchResult* results,
+                          size_t capacity);
+
+void printMicroBenchJson(const MicroBenchResult* results, size_t count);
+
+#endif // MICRO_BENCH_H
@@ -0,0 +1,208 @@
+#include "payload_codec.h"
+#include <string.h>
+
+static inline void putU16(uint8_t* buffer, size_t& offset, uint16_t value) {
+    buffer[offset++] = (value >> 8) & 0xFF;
+    buffer[offset++] = value & 0xFF;
+}
+
+static inline void putU32(uint8_t* buffer, size_t& offset, uint32_t value) {
+    buffer[offset++] = (value >> 24) & 0xFF;
+    buffer[offset++] = (value >> 16) & 0xFF;
+    buffer[offset++] = (value >> 8) & 0xFF;
+    buffer[offset++] = value & 0xFF;
+}
+
+static inline void putFloat(uint8_t* buffer, size_t& offset, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(buffer, offset, bits);
+}
+
+static inline uint16_t getU16(const uint8_t* buffer, size_t& offset) {
+    uint16_t value = ((uint16_t)buffer[offset] << 8) | buffer[offset + 1];
+    offset += 2;
+    return value;
+}
+
+static inline uint32_t getU32(const uint8_t* buffer, size_t& offset) {
+    uint32_t value = ((uint32_t)buffer[offset] << 24) | ((uint32_t)buffer[offset + 1] << 16) |
+                     ((uint32_t)buffer[offset + 2] << 8) | buffer[offset + 3];
+    offset += 4;
+    return value;
+}
+
+static inline float getFloat(const uint8_t* buffer, size_t& offset) {
+    uint32_t bits = getU32(buffer, offset);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+size_t encodeStatusPayload(const StatusPayload& status, uint8_t* buffer, size_t capacity) {
+    uint8_t perfCount = status.perfCount > STATUS_PERF_MAX_PROBES ? STATUS_PERF_MAX_PROBES : status.perfCount;
+    size_t required = STATUS_BASE_SIZE;
+    bool energy = perfCount > 0 && status.hasEnergy;
+    if (perfCount > 0) {
+        required = STATUS_POSITION_END + 1 + 2 * perfCount + (energy ? STATUS_ENERGY_SIZE : 0);
+    } else if (status.hasGPS) {
+        required += STATUS_GPS_SIZE;
+        if (status.hasPositionQuality) required += STATUS_POSITION_SIZE;
+    }
+    if (capacity < required) return 0;
+
+    size_t offset = 0;
+    putU32(buffer, offset, status.uptimeSeconds);
+    putU16(buffer, offset, status.freeHeapKB);
+    buffer[offset++] = status.rssiByte;
+    buffer[offset++] = status.snrByte;
+    putU16(buffer, offset, status.batteryMv);
+    buffer[offset++] = status.batteryPercent;
+
+    if (status.hasGPS) {
+        putFloat(buffer, offset, status.latitude);
+        putFloat(buffer, offset, status.longitude);
+        putFloat(buffer, offset, status.altitude);
+        buffer[offset++] = status.satellites;
+
+        if (status.hasPositionQuality) {
+            buffer[offset++] = status.positionFlags;
+            putU16(buffer, offset, status.accuracyM);
+        }
+    }
+
+    if (perfCount > 0) {
+        // The latency block is found by length, so the blocks before it must be there
+        if (!status.hasGPS) {
+            memset(buffer + offset, 0, STATUS_GPS_SIZE);
+            offset += STATUS_GPS_SIZE;
+        }
+        if (!status.hasGPS || !status.hasPositionQuality) {
+            buffer[offset++] = status.hasGPS ? 0 : STATUS_FLAG_NO_POSITION;
+            putU16(buffer, offset, 0);
+        }
+        buffer[offset++] = perfCount;
+        for (uint8_t i = 0; i < perfCount; i++) {
+            buffer[offset++] = status.perfP50[i];
+            buffer[offset++] = status.perfP99[i];
+        }
+        if (energy) {
+            putU16(buffer, offset, status.meanCurrentCentiMa);
+            putU16(buffer, offset, status.chargePerUplinkUah);
+            putU16(buffer, offset, status.chargeUsedMah);
+        }
+    }
+    return offset;
+}
+
+bool decodeStatusPayload(const uint8_t* buffer, size_t length, StatusPayload& status) {
+    if (length < STATUS_BASE_SIZE) return false;
+
+    size_t offset = 0;
+    status.uptimeSeconds = getU32(buffer, offset);
+    status.freeHeapKB = getU16(buffer, offset);
+    status.rssiByte = buffer[offset++];
+    status.snrByte = buffer[offset++];
+    status.batteryMv = getU16(buffer, offset);
+    status.batteryPercent = buffer[offset++];
+
+    // Optional blocks are recognised by length, exactly like the JS decoder
+    status.hasGPS = length >= offset + STATUS_GPS_SIZE;
+    status.hasPositionQuality = false;
+    if (status.hasGPS) {
+        status.latitude = getFloat(buffer, offset);
+        status.longitude = getFloat(buffer, offset);
+        status.altitude = getFloat(buffer, offset);
+        status.satellites = buffer[offset++];
+
+        if (length >= offset + STATUS_POSITION_SIZE) {
+            status.hasPositionQuality = true;
+            status.positionFlags = buffer[offset++];
+            status.accuracyM = getU16(buffer, offset);
+        }
+    }
+    if (status.hasPositionQuality && (status.positionFlags & STATUS_FLAG_NO_POSITION)) {
+        status.hasGPS = false;
+        status.hasPositionQuality = false;
+        status.latitude = status.longitude = status.altitude = 0;
+        status.satellites = 0;
+        status.accuracyM = 0;
+    }
+
+    status.perfCount = 0;
+    status.hasEnergy = false;
+    if (length > STATUS_POSITION_END) {
+        size_t count = buffer[offset++];
+        size_t available = (length - offset) / 2;
+        if (count > available) count = available;
+        if (count > STATUS_PERF_MAX_PROBES) count = STATUS_PERF_MAX_PROBES;
+        status.perfCount = (uint8_t)count;
+        for (size_t i = 0; i < count; i++) {
+            status.perfP50[i] = buffer[offset++];
+            status.perfP99[i] = buffer[offset++];
+        }
+        if (length >= offset + STATUS_ENERGY_SIZE) {
+            status.hasEnergy = true;
+            status.meanCurrentCentiMa = getU16(buffer, offset);
+            status.chargePerUplinkUah = getU16(buffer, offset);
+            status.chargeUsedMah = getU16(buffer, offset);
+        }
+    }
+    return true;
+}
+
+// Degrees x 1e7 against a full scale of 90 or 180 degrees, as 24-bit two's complement
+static inline void putCoordinate(uint8_t* buffer, size_t& offset, int32_t valueE7, int64_t fullScaleE7) {
+    int64_t scaled = ((int64_t)valueE7 * 0x800000 + (valueE7 >= 0 ? fullScaleE7 / 2 : -fullScaleE7 / 2)) / fullScaleE7;
+    if (scaled > 0x7FFFFF) scaled = 0x7FFFFF;
+    if (scaled < -0x7FFFFF) scaled = -0x7FFFFF;
+    uint32_t bits = (uint32_t)scaled & 0xFFFFFF;
+    buffer[offset++] = (bits >> 16) & 0xFF;
+    buffer[offset++] = (bits >> 8) & 0xFF;
+    buffer[offset++] = bits & 0xFF;
+}
+
+static inline int32_t getCoordinate(const uint8_t* buffer, size_t& offset, int64_t fullScaleE7) {
+    uint32_t bits = ((uint32_t)buffer[offset] << 16) | ((uint32_t)buffer[offset + 1] << 8) | buffer[offset + 2];
+    offset += 3;
+    int64_t scaled = (bits & 0x800000) ? (int64_t)bits - 0x1000000 : (int64_t)bits;
+    return (int32_t)(scaled * fullScaleE7 / 0x800000);
+}
+
+size_t encodeSurveyPayload(const SurveyPayload& survey, uint8_t* buffer, size_t capacity) {
+    if (capacity < SURVEY_PAYLOAD_SIZE) return 0;
+    size_t offset = 0;
+    buffer[offset++] = survey.dataRate;
+    buffer[offset++] = (uint8_t)survey.txPowerDbm;
+    putCoordinate(buffer, offset, survey.latitudeE7, 900000000LL);
+    putCoordinate(buffer, offset, survey.longitudeE7, 1800000000LL);
+    return offset;
+}
+
+bool decodeSurveyPayload(const uint8_t* buffer, size_t length, SurveyPayload& survey) {
+    if (length < SURVEY_PAYLOAD_SIZE) return false;
+    size_t offset = 0;
+    survey.dataRate = buffer[offset++];
+    survey.txPowerDbm = (int8_t)buffer[offset++];
+    survey.latitudeE7 = getCoordinate(buffer, offset, 900000000LL);
+    survey.longitudeE7 = getCoordinate(buffer, offset, 1800000000LL);
+    return true;
+}
+
+size_t encodeConfigAck(const ConfigAck& ack, uint8_t* buffer, size_t capacity) {
+    if (capacity < CONFIG_ACK_SIZE) return 0;
+    buffer[0] = ack.sequence;
+    buffer[1] = ack.applied;
+    buffer[2] = ack.rejected;
+    buffer[3] = ack.revision;
+    return CONFIG_ACK_SIZE;
+}
+
+bool decodeConfigAck(const uint8_t* buffer, size_t length, ConfigAck& ack) {
+    if (length < CONFIG_ACK_SIZE) return false;
+    ack.sequence = buffer[0];
+    ack.applied = buffer[1];
+    ack.rejected = buffer[2];
+    ack.revision = buffer[3];
+    return true;
+}
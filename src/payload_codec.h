@@ -0,0 +1,121 @@
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Status uplink (port 3) wire format, big-endian:
+//   uptime s (4) | heap KB (2) | RSSI+200 (1) | SNR*4+128 (1) | battery mV (2) | battery % (1)
+//   [ latitude f32 (4) | longitude f32 (4) | altitude f32 (4) | satellites (1)
+//     [ position flags (1) | accuracy m (2)
+//       [ probe count N (1) | N x (p50 code (1) | p99 code (1))
+//         [ mean current 0.01 mA (2) | charge per uplink uAh (2) | charge used mAh (2) ] ] ] ]
+// The optional latency block (perf_stats.h, probe order and duration codes)
+// needs the blocks before it; without a position they are sent zeroed with
+// STATUS_FLAG_NO_POSITION set. The energy block (energy_ledger.h) follows
+// the latency block and goes out with it. payload_decoder.js decodes the
+// same layout inside ChirpStack.
+#define STATUS_PORT                 3
+#define STATUS_BASE_SIZE            11
+#define STATUS_GPS_SIZE             13
+#define STATUS_POSITION_SIZE        3
+#define STATUS_POSITION_END         (STATUS_BASE_SIZE + STATUS_GPS_SIZE + STATUS_POSITION_SIZE)
+#define STATUS_PERF_MAX_PROBES      7
+#define STATUS_ENERGY_SIZE          6
+#define STATUS_MAX_SIZE             (STATUS_POSITION_END + 1 + 2 * STATUS_PERF_MAX_PROBES + STATUS_ENERGY_SIZE)
+
+#define STATUS_FLAG_ESTIMATED       0x01    // Position is dead-reckoned between fixes
+#define STATUS_FLAG_NO_POSITION     0x02    // GPS block is padding for the latency block
+
+struct StatusPayload {
+    uint32_t uptimeSeconds;
+    uint16_t freeHeapKB;
+    uint8_t rssiByte;           // RSSI + 200
+    uint8_t snrByte;            // SNR * 4 + 128
+    uint16_t batteryMv;
+    uint8_t batteryPercent;
+
+    bool hasGPS;
+    float latitude;
+    float longitude;
+    float altitude;
+    uint8_t satellites;
+
+    bool hasPositionQuality;
+    uint8_t positionFlags;
+    uint16_t accuracyM;
+
+    uint8_t perfCount;                          // 0 = no latency block
+    uint8_t perfP50[STATUS_PERF_MAX_PROBES];    // perfEncodeDuration() codes
+    uint8_t perfP99[STATUS_PERF_MAX_PROBES];
+
+    bool hasEnergy;                             // Only sent after a latency block
+    uint16_t meanCurrentCentiMa;                // = mAh per hour x 100
+    uint16_t chargePerUplinkUah;                // 0 before the first uplink
+    uint16_t chargeUsedMah;
+
+    StatusPayload() : uptimeSeconds(0), freeHeapKB(0), rssiByte(0), snrByte(0), batteryMv(0),
+                      batteryPercent(0), hasGPS(false), latitude(0), longitude(0), altitude(0),
+                      satellites(0), hasPositionQuality(false), positionFlags(0), accuracyM(0),
+                      perfCount(0), perfP50(), perfP99(), hasEnergy(false), meanCurrentCentiMa(0),
+                      chargePerUplinkUah(0), chargeUsedMah(0) {}
+
+    // Field conversions used by the firmware when filling the payload
+    static uint8_t encodeRssi(float rssi) { return (uint8_t)((int)rssi + 200); }
+    static uint8_t encodeSnr(float snr) { return (uint8_t)(int)((snr * 4) + 128); }
+
+    int rssiDbm() const { return (int)rssiByte - 200; }
+    float snrDb() const { return ((int)snrByte - 128) / 4.0f; }
+};
+
+// Survey uplink (port 5), big-endian, sent by the data-rate survey
+// (lora_handler.h) where the status layout would cost too much airtime:
+//   data rate (1) | TX power dBm (1) | latitude (3) | longitude (3)
+// Latitude and longitude are signed 24-bit fractions of 90 and 180
+// degrees, about 1.2 m and 2.4 m steps at the equator.
+#define SURVEY_PORT                 5
+#define SURVEY_PAYLOAD_SIZE         8
+
+struct SurveyPayload {
+    uint8_t dataRate;
+    int8_t txPowerDbm;
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+
+    SurveyPayload() : dataRate(0), txPowerDbm(0), latitudeE7(0), longitudeE7(0) {}
+};
+
+// Config acknowledgement (port 6): the result of a config downlink
+// (remote_config.h), sent in place of the next status uplink and followed
+// by its status layout when the data rate has room for both:
+//   sequence (1) | applied (1) | rejected (1) | config revision (1) [ | status layout ]
+// Applied and rejected carry bit (opcode - 1) per command in the downlink;
+// CONFIG_ACK_MALFORMED marks a frame that could not be read to its end.
+#define CONFIG_ACK_PORT             6
+#define CONFIG_ACK_SIZE             4
+#define CONFIG_ACK_MALFORMED        0x80
+
+struct ConfigAck {
+    uint8_t sequence;
+    uint8_t applied;
+    uint8_t rejected;
+    uint8_t revision;
+
+    ConfigAck() : sequence(0), applied(0), rejected(0), revision(0) {}
+};
+
+// Returns the number of bytes written (0 if the buffer is too small)
+size_t encodeStatusPayload(const StatusPayload& status, uint8_t* buffer, size_t capacity);
+
+// Returns false for payloads shorter than the fixed status block
+bool decodeStatusPayload(const uint8_t* buffer, size_t length, StatusPayload& status);
+
+// Same conventions; the decoded position is rounded to the 24-bit steps
+size_t encodeSurveyPayload(const SurveyPayload& survey, uint8_t* buffer, size_t capacity);
+bool decodeSurveyPayload(const uint8_t* buffer, size_t length, SurveyPayload& survey);
+
+// The ack block only; a status layout after it decodes from CONFIG_ACK_SIZE on
+size_t encodeConfigAck(const ConfigAck& ack, uint8_t* buffer, size_t capacity);
+bool decodeConfigAck(const uint8_t* buffer, size_t length, ConfigAck& ack);
+
+#endif // PAYLOAD_CODEC_H
@@ -0,0 +1,159 @@
+#include "perf_stats.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+// Spans shorter than this use the cycle counter, which wraps after ~17 s at 240 MHz
+#define PERF_CYCLE_SPAN_LIMIT_US    10000000LL
+
+static const char* PROBE_NAMES[PERF_PROBE_COUNT] = {
+    "gps_update",
+    "display_update",
+    "uplink",
+    "join",
+    "nvs_save",
+    "battery_read",
+    "loop"
+};
+
+static PerfHistogram histograms[PERF_PROBE_COUNT];
+
+PerfHistogram::PerfHistogram() {
+    reset();
+}
+
+void PerfHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    sumNs = 0;
+    minNs = UINT64_MAX;
+    maxNs = 0;
+}
+
+int PerfHistogram::bucketOf(uint64_t ns) {
+    if (ns < (1u << PERF_SUB_BUCKET_BITS)) return (int)ns;
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent > PERF_MAX_EXPONENT) return PERF_BUCKET_COUNT - 1;
+    return ((exponent - PERF_SUB_BUCKET_BITS + 1) << PERF_SUB_BUCKET_BITS) |
+           (int)((ns >> (exponent - PERF_SUB_BUCKET_BITS)) & ((1 << PERF_SUB_BUCKET_BITS) - 1));
+}
+
+uint64_t PerfHistogram::bucketMidpoint(int bucket) {
+    if (bucket < (1 << PERF_SUB_BUCKET_BITS)) return (uint64_t)bucket;
+    int exponent = (bucket >> PERF_SUB_BUCKET_BITS) + PERF_SUB_BUCKET_BITS - 1;
+    uint64_t width = 1ULL << (exponent - PERF_SUB_BUCKET_BITS);
+    uint64_t low = (1ULL << exponent) | ((uint64_t)(bucket & ((1 << PERF_SUB_BUCKET_BITS) - 1)) * width);
+    return low + width / 2;
+}
+
+void PerfHistogram::record(uint64_t ns) {
+    counts[bucketOf(ns)]++;
+    total++;
+    sumNs += ns;
+    if (ns < minNs) minNs = ns;
+    if (ns > maxNs) maxNs = ns;
+}
+
+void PerfHistogram::restore(const uint16_t* buckets, const uint32_t* bucketCounts, size_t pairs,
+                            uint64_t min, uint64_t max, uint64_t sum) {
+    reset();
+    for (size_t i = 0; i < pairs; i++) {
+        if (buckets[i] >= PERF_BUCKET_COUNT) continue;
+        counts[buckets[i]] += bucketCounts[i];
+        total += bucketCounts[i];
+    }
+    if (total == 0) return;
+    minNs = min;
+    maxNs = max;
+    sumNs = sum;
+}
+
+uint64_t PerfHistogram::percentileNs(float fraction) const {
+    if (total == 0) return 0;
+    uint32_t rank = (uint32_t)ceilf(fraction * total);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (int i = 0; i < PERF_BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucketMidpoint(i);
+            if (value < minNs) return minNs;
+            if (value > maxNs) return maxNs;
+            return value;
+        }
+    }
+    return maxNs;
+}
+
+#if defined(ARDUINO)
+
+PerfTimestamp perfNow() {
+    PerfTimestamp now;
+    now.cycles = ESP.getCycleCount();
+    now.micros = esp_timer_get_time();
+    now.cpuMhz = getCpuFrequencyMhz();
+    return now;
+}
+
+uint64_t perfElapsedNs(const PerfTimestamp& start) {
+    PerfTimestamp now = perfNow();
+    int64_t elapsedUs = now.micros - start.micros;
+    if (elapsedUs >= PERF_CYCLE_SPAN_LIMIT_US || now.cpuMhz != start.cpuMhz) return (uint64_t)elapsedUs * 1000ULL;
+    uint32_t cycles = now.cycles - start.cycles;
+    return (uint64_t)cycles * 1000ULL / getCpuFrequencyMhz();
+}
+
+#else
+
+PerfTimestamp perfNow() {
+    PerfTimestamp now;
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    // Host builds keep full resolution: sub-microsecond remainder in cycles
+    now.micros = ns / 1000;
+    now.cycles = (uint32_t)(ns % 1000);
+    now.cpuMhz = 0;
+    return now;
+}
+
+uint64_t perfElapsedNs(const PerfTimestamp& start) {
+    PerfTimestamp now = perfNow();
+    return (uint64_t)((now.micros - start.micros) * 1000 + ((int64_t)now.cycles - (int64_t)start.cycles));
+}
+
+#endif
+
+void perfRecord(PerfProbe probe, uint64_t ns) {
+    histograms[probe].record(ns);
+}
+
+const PerfHistogram& perfHistogram(PerfProbe probe) {
+    return histograms[probe];
+}
+
+const char* perfProbeName(PerfProbe probe) {
+    return PROBE_NAMES[probe];
+}
+
+void perfReset() {
+    for (int i = 0; i < PERF_PROBE_COUNT; i++) histograms[i].reset();
+}
+
+uint8_t perfEncodeDuration(uint64_t ns) {
+    if (ns == 0) return 0;
+    double micros = ns / 1000.0;
+    if (micros <= 1.0) return 1;
+    long code = 1 + lround(8.0 * log2(micros));
+    return code > 255 ? 255 : (uint8_t)code;
+}
+
+uint64_t perfDecodeDurationNs(uint8_t code) {
+    if (code == 0) return 0;
+    return (uint64_t)llround(exp2((code - 1) / 8.0) * 1000.0);
+}
@@ -0,0 +1,97 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Latency instrumentation for the hot paths. A PerfScope times the block it
+// lives in and records the duration in the probe's histogram. On the ESP32
+// the cycle counter is used for spans shorter than its wrap time (~17 s at
+// 240 MHz) and esp_timer for longer ones such as joins, or for any span
+// the clock changed in (power_manager.h). On the host the
+// clock is steady_clock. Nothing allocates; all histograms are static.
+
+enum PerfProbe {
+    PERF_GPS_UPDATE = 0,
+    PERF_DISPLAY_UPDATE,
+    PERF_UPLINK,
+    PERF_JOIN,
+    PERF_NVS_SAVE,
+    PERF_BATTERY_READ,
+    PERF_LOOP,              // One handleMainLoop() pass
+    PERF_PROBE_COUNT
+};
+
+// HDR-style log-linear buckets: 8 sub-buckets per power of two of
+// nanoseconds (<= 12.5 % error), exact below 8 ns, saturating at ~73 min
+#define PERF_SUB_BUCKET_BITS    3
+#define PERF_MAX_EXPONENT       42
+#define PERF_BUCKET_COUNT       ((PERF_MAX_EXPONENT - PERF_SUB_BUCKET_BITS + 2) << PERF_SUB_BUCKET_BITS)
+
+class PerfHistogram {
+private:
+    uint32_t counts[PERF_BUCKET_COUNT];
+    uint32_t total;
+    uint64_t sumNs;
+    uint64_t minNs;
+    uint64_t maxNs;
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketMidpoint(int bucket);
+
+public:
+    PerfHistogram();
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint32_t getCount() const { return total; }
+    uint64_t getMinNs() const { return total ? minNs : 0; }
+    uint64_t getMaxNs() const { return maxNs; }
+    uint64_t getMeanNs() const { return total ? sumNs / total : 0; }
+    uint64_t getSumNs() const { return sumNs; }
+    uint32_t getBucketCount(int bucket) const { return counts[bucket]; }
+
+    // Rebuilds a histogram shipped elsewhere as (bucket, count) pairs plus its summary
+    void restore(const uint16_t* buckets, const uint32_t* bucketCounts, size_t pairs,
+                 uint64_t min, uint64_t max, uint64_t sum);
+
+    // Bucket midpoint of the value at the given fraction (0.5 = median), clamped to [min, max]
+    uint64_t percentileNs(float fraction) const;
+};
+
+// Opaque start point of a measurement
+struct PerfTimestamp {
+    uint32_t cycles;
+    int64_t micros;
+    uint32_t cpuMhz;        // ESP32: the cycle count is only usable at an unchanged clock
+};
+
+PerfTimestamp perfNow();
+uint64_t perfElapsedNs(const PerfTimestamp& start);
+
+void perfRecord(PerfProbe probe, uint64_t ns);
+const PerfHistogram& perfHistogram(PerfProbe probe);
+const char* perfProbeName(PerfProbe probe);
+void perfReset();
+
+// Log-scale one-byte duration used by the status uplink: 0 = no samples,
+// otherwise 2^((code - 1) / 8) microseconds (1 us .. ~58 min, ~9 % steps)
+uint8_t perfEncodeDuration(uint64_t ns);
+uint64_t perfDecodeDurationNs(uint8_t code);
+
+class PerfScope {
+private:
+    PerfProbe probe;
+    PerfTimestamp start;
+
+public:
+    explicit PerfScope(PerfProbe timedProbe) : probe(timedProbe), start(perfNow()) {}
+    ~PerfScope() { perfRecord(probe, perfElapsedNs(start)); }
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+#define PERF_SCOPE(probe) PerfScope PERF_CONCAT(perfScope_, __LINE__)(probe)
+
+#endif // PERF_STATS_H
@@ -0,0 +1,283 @@
+#include "power_manager.h"
+#include "console_print.h"
+#include "gps_handler.h"
+#include "energy_ledger.h"
+#include "Config.h"
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#if !defined(NATIVE_SIM)
+#include <freertos/FreeRTOS.h>
+#endif
+
+// The guard timer's callback runs in the esp_timer task, possibly on the
+// other core, while the loop task releases the guard
+#if defined(NATIVE_SIM)
+#define GUARD_ENTER()
+#define GUARD_EXIT()
+#else
+static portMUX_TYPE guardMux = portMUX_INITIALIZER_UNLOCKED;
+#define GUARD_ENTER()   portENTER_CRITICAL(&guardMux)
+#define GUARD_EXIT()    portEXIT_CRITICAL(&guardMux)
+#endif
+
+static const char* MODE_NAMES[] = {"fixed", "manual", "DFS", "DFS + light sleep"};
+static const char* BURST_NAMES[POWER_BURST_KIND_COUNT] = {"display", "codec", "scan"};
+
+static PowerStats stats;
+static bool lightSleepSupported = false;
+static esp_pm_lock_handle_t burstLock = nullptr;
+static esp_pm_lock_handle_t gnssLock = nullptr;
+static esp_pm_lock_handle_t consoleLock = nullptr;
+static esp_timer_handle_t guardTimer = nullptr;
+static volatile bool guardHeld = false;
+static volatile bool scheduleActive = false;    // The timer runs the guard
+static volatile unsigned long epochRef = 0;     // An NMEA burst started at this millis()
+static uint32_t guardBytes = 0;                 // GNSS bytes received at the last poll
+static const GPSHandler* gnss = nullptr;
+static uint8_t burstDepth = 0;
+static bool sleepAllowed = false;
+static uint64_t sleepAllowedUs = 0;             // Before sleepAllowedSinceUs
+static uint64_t sleepAllowedSinceUs = 0;
+
+static bool configure(bool lightSleep) {
+    esp_pm_config_esp32s3_t config = {};
+    config.max_freq_mhz = POWER_MAX_MHZ;
+    config.min_freq_mhz = POWER_MIN_MHZ;
+    config.light_sleep_enable = lightSleep;
+    return esp_pm_configure(&config) == ESP_OK;
+}
+
+// Time with no lock against light sleep, for the energy ledger; call with
+// the guard mux held
+static void trackSleepAllowed() {
+    bool allowed = stats.mode == POWER_MODE_LIGHT_SLEEP && !guardHeld && !stats.consoleHeld && burstDepth == 0;
+    if (allowed == sleepAllowed) return;
+    uint64_t now = esp_timer_get_time();
+    if (sleepAllowed) sleepAllowedUs += now - sleepAllowedSinceUs;
+    sleepAllowedSinceUs = now;
+    sleepAllowed = allowed;
+}
+
+static void updateSleepAllowed() {
+    GUARD_ENTER();
+    trackSleepAllowed();
+    GUARD_EXIT();
+}
+
+// Takes the guard POWER_GNSS_LEAD_MS before each burst is due, then polls
+// the UART every POWER_GNSS_POLL_MS; once a poll finds no new bytes the
+// burst is over, and the guard is released until just before the next one
+static void guardTimerFired(void*) {
+    if (!scheduleActive) return;
+    uint32_t received = gnss->getBytesReceived();
+    uint64_t nextUs = POWER_GNSS_POLL_MS * 1000ULL;
+    GUARD_ENTER();
+    if (!guardHeld) {
+        esp_pm_lock_acquire(gnssLock);
+        guardHeld = true;
+        stats.gnssGuards++;
+        nextUs += POWER_GNSS_LEAD_MS * 1000ULL;
+    } else if (received == guardBytes) {
+        unsigned long position = (millis() - epochRef) % GPS_EPOCH_MS;
+        unsigned long waitMs = GPS_EPOCH_MS - position - POWER_GNSS_LEAD_MS;
+        if (position + POWER_GNSS_LEAD_MS < GPS_EPOCH_MS && waitMs > 2 * POWER_GNSS_LEAD_MS) {
+            esp_pm_lock_release(gnssLock);
+            guardHeld = false;
+            nextUs = waitMs * 1000ULL;
+        }
+    }
+    guardBytes = received;
+    trackSleepAllowed();
+    GUARD_EXIT();
+    esp_timer_start_once(guardTimer, nextUs);
+}
+
+static void takeGuard() {
+    GUARD_ENTER();
+    bool taken = !guardHeld;
+    if (taken) {
+        esp_pm_lock_acquire(gnssLock);
+        guardHeld = true;
+    }
+    GUARD_EXIT();
+    if (taken) stats.gnssLateGuards++;
+}
+
+static void stopSchedule() {
+    scheduleActive = false;
+    if (esp_timer_is_active(guardTimer)) esp_timer_stop(guardTimer);
+}
+
+static void releaseGuard() {
+    stopSchedule();
+    GUARD_ENTER();
+    if (guardHeld) {
+        esp_pm_lock_release(gnssLock);
+        guardHeld = false;
+    }
+    GUARD_EXIT();
+}
+
+PowerMode powerInitialize() {
+    stats = PowerStats();
+    burstLock = gnssLock = consoleLock = nullptr;
+    guardTimer = nullptr;
+    guardHeld = false;
+    scheduleActive = false;
+    gnss = nullptr;
+    burstDepth = 0;
+    sleepAllowed = false;
+    sleepAllowedUs = 0;
+
+    lightSleepSupported = POWER_LIGHT_SLEEP && configure(true);
+    if (lightSleepSupported) {
+        stats.mode = POWER_MODE_LIGHT_SLEEP;
+    } else if (configure(false)) {
+        stats.mode = POWER_MODE_DFS;
+    } else {
+        stats.mode = setCpuFrequencyMhz(POWER_MIN_MHZ) ? POWER_MODE_MANUAL : POWER_MODE_FIXED;
+    }
+
+    if (stats.mode >= POWER_MODE_DFS) {
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "burst", &burstLock);
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "gnss", &gnssLock);
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "console", &consoleLock);
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = guardTimerFired;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "gnss_guard";
+        esp_timer_create(&timerArgs, &guardTimer);
+
+        // Wake on a start bit of the GNSS UART (its RX pin is not the
+        // IOMUX one UART wake needs), on a radio interrupt and on the user
+        // button (it wakes the display)
+        gpio_wakeup_enable((gpio_num_t)GPS_RX_PIN, GPIO_INTR_LOW_LEVEL);
+        gpio_wakeup_enable((gpio_num_t)LORA_DIO1, GPIO_INTR_HIGH_LEVEL);
+        gpio_wakeup_enable((gpio_num_t)USER_BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+    if (stats.mode == POWER_MODE_LIGHT_SLEEP) {
+        // Awake until powerUpdate() has timed the NMEA bursts
+        esp_pm_lock_acquire(gnssLock);
+        guardHeld = true;
+    }
+
+    consolePrintf("[Power] %s, %d-%d MHz\n", MODE_NAMES[stats.mode], POWER_MIN_MHZ, POWER_MAX_MHZ);
+    updateSleepAllowed();
+    return stats.mode;
+}
+
+void powerUpdate(const GPSHandler& gps) {
+    if (stats.mode != POWER_MODE_LIGHT_SLEEP) return;
+
+    bool console = (bool)Serial;
+    if (console != stats.consoleHeld) {
+        if (console) {
+            esp_pm_lock_acquire(consoleLock);
+        } else {
+            esp_pm_lock_release(consoleLock);
+        }
+        stats.consoleHeld = console;
+    }
+
+    // Awake through each NMEA burst (the timer's job once the bursts are
+    // timed); until then, awake throughout
+    unsigned long epochMs;
+    if (!gps.isGPSPowered()) {
+        releaseGuard();
+    } else if (!gps.getEpochStartMs(epochMs)) {
+        stopSchedule();
+        takeGuard();
+    } else {
+        gnss = &gps;
+        epochRef = epochMs;
+        scheduleActive = true;
+        if (!esp_timer_is_active(guardTimer)) esp_timer_start_once(guardTimer, POWER_GNSS_POLL_MS * 1000ULL);
+    }
+    updateSleepAllowed();
+}
+
+bool powerSetLightSleep(bool enable) {
+    if (!lightSleepSupported) return false;
+    if (enable == (stats.mode == POWER_MODE_LIGHT_SLEEP)) return true;
+    if (!configure(enable)) return false;
+    stats.mode = enable ? POWER_MODE_LIGHT_SLEEP : POWER_MODE_DFS;
+    if (!enable) {
+        releaseGuard();
+        if (stats.consoleHeld) esp_pm_lock_release(consoleLock);
+        stats.consoleHeld = false;
+    }
+    updateSleepAllowed();
+    return true;
+}
+
+void powerBurstBegin(PowerBurstKind kind) {
+    if (kind >= 0 && kind < POWER_BURST_KIND_COUNT) stats.bursts[kind]++;
+    if (burstDepth++ > 0 || stats.mode == POWER_MODE_FIXED) return;
+    energyUpdate();
+    if (stats.mode == POWER_MODE_MANUAL) {
+        setCpuFrequencyMhz(POWER_MAX_MHZ);
+    } else {
+        esp_pm_lock_acquire(burstLock);
+    }
+    updateSleepAllowed();
+}
+
+void powerBurstEnd() {
+    if (burstDepth == 0 || --burstDepth > 0 || stats.mode == POWER_MODE_FIXED) return;
+    energyUpdate();
+    if (stats.mode == POWER_MODE_MANUAL) {
+        setCpuFrequencyMhz(POWER_MIN_MHZ);
+    } else {
+        esp_pm_lock_release(burstLock);
+    }
+    updateSleepAllowed();
+}
+
+uint64_t powerSleepAllowedUs() {
+    GUARD_ENTER();
+    uint64_t us = sleepAllowedUs;
+    if (sleepAllowed) us += esp_timer_get_time() - sleepAllowedSinceUs;
+    GUARD_EXIT();
+    return us;
+}
+
+const PowerStats& powerStats() {
+    return stats;
+}
+
+const char* powerModeName(PowerMode mode) {
+    return mode >= POWER_MODE_FIXED && mode <= POWER_MODE_LIGHT_SLEEP ? MODE_NAMES[mode] : "?";
+}
+
+void powerPrintStatus() {
+    consolePrintf("[Power] %s, %d-%d MHz, CPU at %lu MHz now\n", MODE_NAMES[stats.mode], POWER_MIN_MHZ,
+                  POWER_MAX_MHZ, (unsigned long)getCpuFrequencyMhz());
+    Serial.print(F("[Power] Bursts:"));
+    for (int i = 0; i < POWER_BURST_KIND_COUNT; i++) consolePrintf(" %s %lu", BURST_NAMES[i], (unsigned long)stats.bursts[i]);
+    Serial.println();
+
+    // Residency from the energy ledger, with what it prices it at
+    const EnergyReport& energy = energyReport();
+    uint64_t totalUs = energy.lightSleepUs;
+    for (int i = 0; i < ENERGY_CPU_FREQ_COUNT; i++) totalUs += energy.cpuActiveUs[i] + energy.cpuIdleUs[i];
+    if (totalUs > 0) {
+        Serial.print(F("[Power] Residency:"));
+        for (int i = 0; i < ENERGY_CPU_FREQ_COUNT; i++) {
+            consolePrintf(" %u MHz %.1f%%", energyCpuFrequencyMhz(i),
+                          100.0 * (energy.cpuActiveUs[i] + energy.cpuIdleUs[i]) / totalUs);
+        }
+        float cpuMah = energy.chargeMah[ENERGY_CPU_ACTIVE] + energy.chargeMah[ENERGY_CPU_IDLE] +
+                       energy.chargeMah[ENERGY_CPU_SLEEP];
+        consolePrintf(", light sleep %.1f%%; CPU %.1f mA, board %.1f mA mean\n", 100.0 * energy.lightSleepUs / totalUs,
+                      cpuMah / (totalUs / 3600e6), energy.meanCurrentMa);
+    }
+    if (stats.mode == POWER_MODE_LIGHT_SLEEP) {
+        consolePrintf("[Power] GNSS guard %s: %lu timed, %lu late; console %s\n", guardHeld ? "held" : "released",
+                      (unsigned long)stats.gnssGuards, (unsigned long)stats.gnssLateGuards,
+                      stats.consoleHeld ? "attached (no light sleep)" : "detached");
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+
+class GPSHandler;
+
+// CPU clock and light sleep (ESP-IDF esp_pm). The CPU idles at
+// POWER_MIN_MHZ and only bursts of work ask for POWER_MAX_MHZ: display
+// renders, payload encoding and the gateway discovery scan, each inside a
+// PowerBurst scope. Whenever nothing holds a lock the idle task puts the
+// chip into light sleep between loop passes (automatic light sleep).
+//
+// Light sleep stops the UART clock, so NMEA arriving while asleep would be
+// lost. The GNSS UART's RX pin and the radio's DIO1 are light-sleep wake
+// sources, but the byte that wakes the chip is lost too; so the manager
+// keeps the chip awake through every NMEA burst instead. It learns when the
+// receiver's epochs start from GPSHandler; from then on an esp_timer takes
+// a no-light-sleep lock POWER_GNSS_LEAD_MS before each burst is due and
+// releases it once the UART has gone quiet for POWER_GNSS_POLL_MS. The
+// timer, not the loop, does both, so loop passes seconds apart (a send
+// and its RX windows) do not hold the chip awake. A USB console host also
+// keeps the chip awake (the USB peripheral does not survive light sleep).
+//
+// Builds without tickless idle (the stock Arduino core) reject light sleep;
+// the manager then scales the clock only. Without CONFIG_PM_ENABLE at all,
+// bursts switch the clock with setCpuFrequencyMhz(). The energy ledger
+// charges each burst at the clock it ran at, and idle time with light
+// sleep allowed at ENERGY_LIGHT_SLEEP_MA (an estimate: the ledger cannot
+// see how much of it the chip actually slept).
+
+#ifndef POWER_MAX_MHZ
+#define POWER_MAX_MHZ           240
+#endif
+#ifndef POWER_MIN_MHZ
+#define POWER_MIN_MHZ           80      // Lowest clock that keeps APB, and so the UART baud rates, at 80 MHz
+#endif
+#ifndef POWER_LIGHT_SLEEP
+#define POWER_LIGHT_SLEEP       1       // Automatic light sleep when the build supports it
+#endif
+#define POWER_GNSS_LEAD_MS      30      // Awake this long before an NMEA burst is due
+#define POWER_GNSS_POLL_MS      20      // Quiet UART this long: the burst is over
+
+enum PowerMode {
+    POWER_MODE_FIXED = 0,       // No esp_pm, no clock switching
+    POWER_MODE_MANUAL,          // No esp_pm: bursts call setCpuFrequencyMhz()
+    POWER_MODE_DFS,             // esp_pm frequency scaling
+    POWER_MODE_LIGHT_SLEEP      // ... and automatic light sleep
+};
+
+enum PowerBurstKind {
+    POWER_BURST_DISPLAY = 0,
+    POWER_BURST_CODEC,
+    POWER_BURST_SCAN,
+    POWER_BURST_KIND_COUNT
+};
+
+struct PowerStats {
+    PowerMode mode;
+    uint32_t bursts[POWER_BURST_KIND_COUNT];
+    uint32_t gnssGuards;        // Epoch guards taken by the timer
+    uint32_t gnssLateGuards;    // ... and by the loop, the bursts not timed yet
+    bool consoleHeld;           // USB host attached
+};
+
+// Configures esp_pm and the wake sources; call early in setup() (again
+// after a wake is fine)
+PowerMode powerInitialize();
+
+// Epoch guard and console lock; every loop pass, before the loop blocks
+void powerUpdate(const GPSHandler& gps);
+
+// Turns automatic light sleep on or off at run time; false if unsupported
+bool powerSetLightSleep(bool enable);
+
+// Clock boost for a burst of CPU work; nests
+void powerBurstBegin(PowerBurstKind kind);
+void powerBurstEnd();
+
+// Time so far with nothing holding the chip awake: light sleep was up to
+// the idle task (the energy ledger prices idle time in it as light sleep)
+uint64_t powerSleepAllowedUs();
+
+const PowerStats& powerStats();
+const char* powerModeName(PowerMode mode);
+void powerPrintStatus();
+
+class PowerBurst {
+public:
+    explicit PowerBurst(PowerBurstKind kind) { powerBurstBegin(kind); }
+    ~PowerBurst() { powerBurstEnd(); }
+};
+
+#define POWER_CONCAT_INNER(a, b) a##b
+#define POWER_CONCAT(a, b) POWER_CONCAT_INNER(a, b)
+#define POWER_BURST(kind) PowerBurst POWER_CONCAT(powerBurst_, __LINE__)(kind)
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,261 @@
+#include "remote_config.h"
+#include "console_print.h"
+#include "lora_handler.h"
+#include "sleep_cycle.h"
+#include "sample_archive.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <string.h>
+
+#define CONFIG_NVS_NAMESPACE    "config"
+#define CONFIG_NVS_KEY          "blob"
+#define CONFIG_BLOB_HEADER      2
+#define CONFIG_BLOB_FIELDS      13      // Layout version 1
+#define CONFIG_BLOB_MAX         (CONFIG_BLOB_HEADER + 64 + 4)
+
+static_assert(CONFIG_DR_ADR == LORA_DATA_RATE_ADR, "config and radio agree on the ADR policy value");
+static_assert(CONFIG_UPLINK_INTERVAL_MS >= CONFIG_MIN_UPLINK_INTERVAL_S * 1000UL,
+              "the default uplink interval is one a command could set");
+
+static RemoteConfig config;
+static Preferences nvs;
+
+static RemoteConfig defaults() {
+    RemoteConfig settings;
+    settings.revision = 0;
+    settings.uplinkIntervalMs = CONFIG_UPLINK_INTERVAL_MS;
+    settings.dataRatePolicy = CONFIG_DR_ADR;
+    settings.discoveryEnabled = true;
+    settings.discoveryChangeDeciDb = (uint8_t)(LORA_DISCOVERY_CHANGE_DB * 10);
+    settings.discoveryIntervalS = LORA_DISCOVERY_INTERVAL_MS / 1000;
+    settings.sampleCycleS = SLEEP_CYCLE_INTERVAL_S;
+    settings.logLevel = LOG_LEVEL_DEBUG;
+    return settings;
+}
+
+// Field by field, so the blob does not depend on struct padding
+static size_t encodeFields(const RemoteConfig& settings, uint8_t* buffer) {
+    size_t offset = 0;
+    buffer[offset++] = settings.revision;
+    for (int i = 0; i < 4; i++) buffer[offset++] = (uint8_t)(settings.uplinkIntervalMs >> (8 * i));
+    buffer[offset++] = settings.dataRatePolicy;
+    buffer[offset++] = settings.discoveryEnabled ? 1 : 0;
+    buffer[offset++] = settings.discoveryChangeDeciDb;
+    buffer[offset++] = (uint8_t)settings.discoveryIntervalS;
+    buffer[offset++] = (uint8_t)(settings.discoveryIntervalS >> 8);
+    buffer[offset++] = (uint8_t)settings.sampleCycleS;
+    buffer[offset++] = (uint8_t)(settings.sampleCycleS >> 8);
+    buffer[offset++] = settings.logLevel;
+    return offset;
+}
+
+// Reads little-endian fields while the blob has them; past its end they keep their defaults
+struct FieldReader {
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+
+    template <typename T> void read(T& field) {
+        if (offset + sizeof(T) > length) {
+            offset = length;
+            return;
+        }
+        uint32_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) value |= (uint32_t)data[offset++] << (8 * i);
+        field = (T)value;
+    }
+};
+
+static void decodeFields(const uint8_t* data, size_t length, RemoteConfig& settings) {
+    FieldReader reader = {data, length, 0};
+    uint8_t discoveryEnabled = settings.discoveryEnabled ? 1 : 0;
+    reader.read(settings.revision);
+    reader.read(settings.uplinkIntervalMs);
+    reader.read(settings.dataRatePolicy);
+    reader.read(discoveryEnabled);
+    reader.read(settings.discoveryChangeDeciDb);
+    reader.read(settings.discoveryIntervalS);
+    reader.read(settings.sampleCycleS);
+    reader.read(settings.logLevel);
+    settings.discoveryEnabled = discoveryEnabled != 0;
+    if (settings.logLevel >= LOG_LEVEL_COUNT) settings.logLevel = LOG_LEVEL_DEBUG;
+    // Blobs saved with the old 120 ms default carry it along
+    if (settings.uplinkIntervalMs < CONFIG_MIN_UPLINK_INTERVAL_S * 1000UL) settings.uplinkIntervalMs = CONFIG_UPLINK_INTERVAL_MS;
+}
+
+static void save() {
+    uint8_t blob[CONFIG_BLOB_MAX];
+    size_t length = encodeFields(config, blob + CONFIG_BLOB_HEADER);
+    blob[0] = CONFIG_BLOB_VERSION;
+    blob[1] = (uint8_t)length;
+    length += CONFIG_BLOB_HEADER;
+    uint32_t crc = archiveCrc32(blob, length);
+    memcpy(blob + length, &crc, sizeof(crc));
+    nvs.begin(CONFIG_NVS_NAMESPACE, false);
+    nvs.putBytes(CONFIG_NVS_KEY, blob, length + sizeof(crc));
+    nvs.end();
+    consolePrintf("[Config][NVS] Revision %u saved\n", config.revision);
+}
+
+void remoteConfigBegin() {
+    config = defaults();
+    uint8_t blob[CONFIG_BLOB_MAX];
+    nvs.begin(CONFIG_NVS_NAMESPACE, true);
+    size_t length = nvs.isKey(CONFIG_NVS_KEY) ? nvs.getBytes(CONFIG_NVS_KEY, blob, sizeof(blob)) : 0;
+    nvs.end();
+    if (length == 0) {
+        Serial.println(F("[Config] No saved settings, build defaults"));
+        return;
+    }
+
+    uint32_t crc;
+    size_t fields = blob[1];
+    if (length < CONFIG_BLOB_HEADER + sizeof(crc) || length != CONFIG_BLOB_HEADER + fields + sizeof(crc)) {
+        Serial.println(F("[Config] [WARN] Saved settings are damaged, build defaults"));
+        return;
+    }
+    memcpy(&crc, blob + length - sizeof(crc), sizeof(crc));
+    if (crc != archiveCrc32(blob, length - sizeof(crc))) {
+        Serial.println(F("[Config] [WARN] Saved settings are damaged, build defaults"));
+        return;
+    }
+    if (blob[0] != CONFIG_BLOB_VERSION) {
+        consolePrintf("[Config] [WARN] Saved settings have layout version %u, not %u: build defaults\n", blob[0],
+                      CONFIG_BLOB_VERSION);
+        return;
+    }
+    decodeFields(blob + CONFIG_BLOB_HEADER, fields, config);
+    consolePrintf("[Config] Revision %u loaded%s\n", config.revision,
+                  fields < CONFIG_BLOB_FIELDS ? " (older layout, newer settings at defaults)" : "");
+}
+
+const RemoteConfig& remoteConfig() {
+    return config;
+}
+
+static uint16_t getU16(const uint8_t* data) {
+    return (uint16_t)(data[0] << 8 | data[1]);
+}
+
+// Argument bytes per opcode, -1 for an unknown one
+static int argumentSize(uint8_t opcode) {
+    switch (opcode) {
+        case CONFIG_OP_UPLINK_INTERVAL: return 2;
+        case CONFIG_OP_DATA_RATE: return 1;
+        case CONFIG_OP_DISCOVERY: return 4;
+        case CONFIG_OP_SAMPLE_CYCLE: return 2;
+        case CONFIG_OP_LOG_LEVEL: return 1;
+        case CONFIG_OP_DEFAULTS: return 0;
+        default: return -1;
+    }
+}
+
+// One command into `settings`; false if an argument is out of range
+static bool applyCommand(uint8_t opcode, const uint8_t* arguments, RemoteConfig& settings) {
+    switch (opcode) {
+        case CONFIG_OP_UPLINK_INTERVAL: {
+            uint16_t seconds = getU16(arguments);
+            if (seconds != 0 && seconds < CONFIG_MIN_UPLINK_INTERVAL_S) return false;
+            settings.uplinkIntervalMs = seconds ? seconds * 1000UL : CONFIG_UPLINK_INTERVAL_MS;
+            return true;
+        }
+        case CONFIG_OP_DATA_RATE:
+            if (arguments[0] != CONFIG_DR_ADR && arguments[0] > 4) return false;
+            settings.dataRatePolicy = arguments[0];
+            return true;
+        case CONFIG_OP_DISCOVERY:
+            if (arguments[0] > 1 || arguments[1] == 0 || getU16(arguments + 2) == 0) return false;
+            settings.discoveryEnabled = arguments[0] != 0;
+            settings.discoveryChangeDeciDb = arguments[1];
+            settings.discoveryIntervalS = getU16(arguments + 2);
+            return true;
+        case CONFIG_OP_SAMPLE_CYCLE: {
+            uint16_t seconds = getU16(arguments);
+            if (seconds != 0 && seconds < SLEEP_CYCLE_MIN_INTERVAL_S) return false;
+            settings.sampleCycleS = seconds;
+            return true;
+        }
+        case CONFIG_OP_LOG_LEVEL:
+            if (arguments[0] >= LOG_LEVEL_COUNT) return false;
+            settings.logLevel = arguments[0];
+            return true;
+        case CONFIG_OP_DEFAULTS: {
+            uint8_t revision = settings.revision;
+            settings = defaults();
+            settings.revision = revision;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+ConfigAck remoteConfigHandleCommand(const uint8_t* data, size_t length) {
+    ConfigAck ack;
+    if (length < 2 || data[0] != CONFIG_PROTOCOL_VERSION) {
+        ack.sequence = length >= 2 ? data[1] : 0;
+        ack.rejected = CONFIG_ACK_MALFORMED;
+        ack.revision = config.revision;
+        consolePrintf("[Config] [WARN] Command of %u bytes, protocol version %d: ignored\n", (unsigned)length,
+                      length ? data[0] : -1);
+        return ack;
+    }
+
+    ack.sequence = data[1];
+    RemoteConfig settings = config;
+    size_t offset = 2;
+    while (offset < length) {
+        uint8_t opcode = data[offset++];
+        int size = argumentSize(opcode);
+        if (size < 0 || offset + size > length) {
+            ack.rejected |= CONFIG_ACK_MALFORMED;
+            consolePrintf("[Config] [WARN] Opcode 0x%02X at byte %u cannot be read, rest of the command dropped\n",
+                          opcode, (unsigned)(offset - 1));
+            break;
+        }
+        uint8_t bit = (uint8_t)CONFIG_ACK_BIT(opcode);
+        if (applyCommand(opcode, data + offset, settings)) {
+            ack.applied |= bit;
+        } else {
+            ack.rejected |= bit;
+            consolePrintf("[Config] [WARN] Opcode 0x%02X: argument out of range\n", opcode);
+        }
+        offset += size;
+    }
+
+    // Only a change costs a revision and a flash write
+    uint8_t before[CONFIG_BLOB_FIELDS], after[CONFIG_BLOB_FIELDS];
+    encodeFields(config, before);
+    encodeFields(settings, after);
+    if (memcmp(before, after, sizeof(before)) != 0) {
+        settings.revision = config.revision + 1;
+        config = settings;
+        save();
+    }
+    ack.revision = config.revision;
+    consolePrintf("[Config] Command %u: applied 0x%02X, rejected 0x%02X, revision %u\n", ack.sequence, ack.applied,
+                  ack.rejected, ack.revision);
+    return ack;
+}
+
+bool logLevelEnabled(LogLevel level) {
+    return config.logLevel >= level;
+}
+
+const char* logLevelName(uint8_t level) {
+    static const char* NAMES[LOG_LEVEL_COUNT] = {"error", "warn", "info", "debug"};
+    return level < LOG_LEVEL_COUNT ? NAMES[level] : "?";
+}
+
+void remoteConfigPrint() {
+    consolePrintf("[Config] Revision %u: uplink every %lu ms, ", config.revision,
+                  (unsigned long)config.uplinkIntervalMs);
+    if (config.dataRatePolicy == CONFIG_DR_ADR) {
+        Serial.print(F("ADR"));
+    } else {
+        consolePrintf("DR%u fixed", config.dataRatePolicy);
+    }
+    consolePrintf(", discovery %s (%.1f dB, %u s), sample cycle %u s, log level %s\n",
+                  config.discoveryEnabled ? "on" : "off", config.discoveryChangeDeciDb / 10.0f,
+                  config.discoveryIntervalS, config.sampleCycleS, logLevelName(config.logLevel));
+}
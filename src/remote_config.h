@@ -0,0 +1,87 @@
+#ifndef REMOTE_CONFIG_H
+#define REMOTE_CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "payload_codec.h"
+
+// Settings tuned per site without reflashing: uplink interval, data-rate
+// policy, gateway discovery, the GNSS sample cycle and the console log
+// level. They come as a binary command downlink on CONFIG_PORT, out of the
+// receive windows of any uplink (LoRaHandler::takeDownlink()), or as the
+// same bytes in hex at the console (`config`). The settings are kept in
+// NVS as one versioned blob and applied again at every boot; main.cpp
+// pushes them into the handlers. The result goes back as a ConfigAck
+// (payload_codec.h) on the next status uplink.
+//
+// Downlink (port 10), big-endian:
+//   protocol version (1) = CONFIG_PROTOCOL_VERSION | sequence (1) | command...
+// Each command is an opcode and its fixed arguments:
+//   0x01 uplink interval s (2)                   0 = the build's default
+//   0x02 data-rate policy (1)                    CONFIG_DR_ADR, or US915 DR0-DR4 fixed with ADR off
+//   0x03 discovery on (1) | RSSI change 0.1 dB (1) | min interval s (2)
+//   0x04 GNSS sample cycle s (2)                 0 = stay awake, else >= SLEEP_CYCLE_MIN_INTERVAL_S
+//   0x05 log level (1)                           LogLevel
+//   0x06 defaults                                every setting back to the build's
+// A command with an argument out of range is rejected and the others still
+// apply. An unknown opcode or a short argument ends the frame, since what
+// follows cannot be framed; the ack marks it CONFIG_ACK_MALFORMED.
+//
+// NVS blob, namespace "config", key "blob":
+//   layout version (1) | length N (1) | N bytes of settings, little-endian | CRC-32 (4)
+// Settings are only ever appended: a blob of the same layout version but
+// shorter (older firmware) fills what it has, the rest keep their defaults.
+
+#define CONFIG_PORT                 10
+#define CONFIG_PROTOCOL_VERSION     1
+#define CONFIG_BLOB_VERSION         1
+#define CONFIG_DR_ADR               0xFF
+
+#define CONFIG_OP_UPLINK_INTERVAL   0x01
+#define CONFIG_OP_DATA_RATE         0x02
+#define CONFIG_OP_DISCOVERY         0x03
+#define CONFIG_OP_SAMPLE_CYCLE      0x04
+#define CONFIG_OP_LOG_LEVEL         0x05
+#define CONFIG_OP_DEFAULTS          0x06
+#define CONFIG_ACK_BIT(opcode)      (1 << ((opcode) - 1))   // In ConfigAck applied/rejected
+
+#ifndef CONFIG_UPLINK_INTERVAL_MS
+#define CONFIG_UPLINK_INTERVAL_MS   120000  // 2 minutes
+#endif
+#define CONFIG_MIN_UPLINK_INTERVAL_S 10
+
+enum LogLevel {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,             // Periodic status reports
+    LOG_LEVEL_DEBUG,            // Per-uplink radio detail and per-sentence GNSS output
+    LOG_LEVEL_COUNT
+};
+
+struct RemoteConfig {
+    uint8_t revision;               // Counts the changes; wraps
+    uint32_t uplinkIntervalMs;
+    uint8_t dataRatePolicy;         // CONFIG_DR_ADR or DR0-DR4
+    bool discoveryEnabled;
+    uint8_t discoveryChangeDeciDb;  // RSSI change that counts as a new gateway
+    uint16_t discoveryIntervalS;
+    uint16_t sampleCycleS;          // Deep-sleep sample cycle (sleep_cycle.h), 0 = off
+    uint8_t logLevel;
+};
+
+// Loads the blob (defaults if there is none or it does not check out); call
+// once at boot, before anything reads the settings
+void remoteConfigBegin();
+const RemoteConfig& remoteConfig();
+
+// Applies a config downlink (or console hex) and saves the settings when
+// any changed; returns the ack to send back
+ConfigAck remoteConfigHandleCommand(const uint8_t* data, size_t length);
+
+// Console output at this level and below is printed
+bool logLevelEnabled(LogLevel level);
+const char* logLevelName(uint8_t level);
+
+void remoteConfigPrint();
+
+#endif // REMOTE_CONFIG_H
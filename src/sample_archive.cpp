@@ -0,0 +1,292 @@
+#include "sample_archive.h"
+#include <string.h>
+
+static inline void putLE32(uint8_t* buffer, uint32_t value) {
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+    buffer[2] = (value >> 16) & 0xFF;
+    buffer[3] = (value >> 24) & 0xFF;
+}
+
+static inline void putLE64(uint8_t* buffer, uint64_t value) {
+    putLE32(buffer, (uint32_t)value);
+    putLE32(buffer + 4, (uint32_t)(value >> 32));
+}
+
+static inline uint32_t getLE32(const uint8_t* buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) |
+           ((uint32_t)buffer[3] << 24);
+}
+
+static inline uint64_t getLE64(const uint8_t* buffer) {
+    return (uint64_t)getLE32(buffer) | ((uint64_t)getLE32(buffer + 4) << 32);
+}
+
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline unsigned bitWidth(uint64_t value) {
+    unsigned width = 0;
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+static void putVarint(uint8_t* out, size_t& pos, uint64_t value) {
+    while (value >= 0x80) {
+        out[pos++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[pos++] = (uint8_t)value;
+}
+
+static bool getVarint(const uint8_t* in, size_t end, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos >= end) return false;
+        uint8_t byte = in[pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// ---- Encoding -------------------------------------------------------------
+
+class BitWriter {
+private:
+    uint8_t* out;
+    size_t& pos;
+    uint64_t pending;
+    unsigned pendingBits;
+
+public:
+    BitWriter(uint8_t* buffer, size_t& position) : out(buffer), pos(position), pending(0), pendingBits(0) {}
+
+    void put(uint64_t value, unsigned width) {
+        // At most 32 bits per step so `pending` never overflows
+        while (width > 0) {
+            unsigned step = width > 32 ? 32 : width;
+            pending |= (value & ((1ULL << step) - 1)) << pendingBits;
+            pendingBits += step;
+            value >>= step;
+            width -= step;
+            while (pendingBits >= 8) {
+                out[pos++] = (uint8_t)pending;
+                pending >>= 8;
+                pendingBits -= 8;
+            }
+        }
+    }
+
+    void finish() {
+        if (pendingBits) out[pos++] = (uint8_t)pending;
+        pending = 0;
+        pendingBits = 0;
+    }
+};
+
+template <typename T>
+static inline int64_t columnValue(const CoverageSample& row, T CoverageSample::*field) {
+    return (int64_t)(row.*field);
+}
+
+template <typename T>
+static inline uint64_t storedValue(const CoverageSample* rows, uint32_t i, T CoverageSample::*field, bool delta) {
+    return delta ? (uint64_t)columnValue(rows[i], field) - (uint64_t)columnValue(rows[i - 1], field)
+                 : (uint64_t)columnValue(rows[i], field);
+}
+
+template <typename T>
+static void encodeColumn(const CoverageSample* rows, uint32_t count, T CoverageSample::*field, bool delta,
+                         uint8_t* out, size_t& pos) {
+    uint32_t first = delta ? 1 : 0;
+    int64_t reference = 0, maximum = 0;
+    for (uint32_t i = first; i < count; i++) {
+        int64_t value = (int64_t)storedValue(rows, i, field, delta);
+        if (i == first || value < reference) reference = value;
+        if (i == first || value > maximum) maximum = value;
+    }
+    unsigned width = count > first ? bitWidth((uint64_t)maximum - (uint64_t)reference) : 0;
+
+    out[pos++] = (uint8_t)width;
+    putVarint(out, pos, zigzag(reference));
+    if (delta) putVarint(out, pos, zigzag(columnValue(rows[0], field)));
+    if (width == 0) return;
+
+    BitWriter writer(out, pos);
+    for (uint32_t i = first; i < count; i++) {
+        writer.put(storedValue(rows, i, field, delta) - (uint64_t)reference, width);
+    }
+    writer.finish();
+}
+
+void writeArchiveFileHeader(uint8_t* header) {
+    memset(header, 0, ARCHIVE_FILE_HEADER_SIZE);
+    memcpy(header, ARCHIVE_FILE_MAGIC, 4);
+    header[4] = ARCHIVE_FILE_VERSION & 0xFF;
+    header[5] = ARCHIVE_FILE_VERSION >> 8;
+}
+
+bool checkArchiveFileHeader(const uint8_t* header, size_t length) {
+    return length >= ARCHIVE_FILE_HEADER_SIZE && memcmp(header, ARCHIVE_FILE_MAGIC, 4) == 0 &&
+           (header[4] | (header[5] << 8)) == ARCHIVE_FILE_VERSION;
+}
+
+size_t encodeArchiveBlock(const CoverageSample* rows, uint32_t count, uint8_t* out, size_t capacity) {
+    if (count == 0 || capacity < ARCHIVE_MAX_BLOCK_SIZE(count)) return 0;
+
+    // Zone map
+    int64_t minTime = rows[0].timeMs, maxTime = rows[0].timeMs;
+    int32_t minLat = INT32_MAX, maxLat = INT32_MIN, minLon = INT32_MAX, maxLon = INT32_MIN;
+    for (uint32_t i = 0; i < count; i++) {
+        const CoverageSample& row = rows[i];
+        if (row.timeMs < minTime) minTime = row.timeMs;
+        if (row.timeMs > maxTime) maxTime = row.timeMs;
+        if (!(row.flags & SAMPLE_FLAG_POSITION)) continue;
+        if (row.latitudeE7 < minLat) minLat = row.latitudeE7;
+        if (row.latitudeE7 > maxLat) maxLat = row.latitudeE7;
+        if (row.longitudeE7 < minLon) minLon = row.longitudeE7;
+        if (row.longitudeE7 > maxLon) maxLon = row.longitudeE7;
+    }
+
+    uint8_t* payload = out + ARCHIVE_BLOCK_HEADER_SIZE;
+    size_t pos = 0;
+    encodeColumn(rows, count, &CoverageSample::timeMs, true, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::deviceEui, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::gatewayId, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::latitudeE7, true, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::longitudeE7, true, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::frameCounter, true, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::accuracyM, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::rssi, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::snrDeci, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::dataRate, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::gatewayCount, false, payload, pos);
+    encodeColumn(rows, count, &CoverageSample::flags, false, payload, pos);
+    memset(payload + pos, 0, ARCHIVE_PAYLOAD_SLACK);
+    pos += ARCHIVE_PAYLOAD_SLACK;
+
+    putLE32(out, ARCHIVE_BLOCK_SYNC);
+    putLE32(out + 4, (uint32_t)pos);
+    putLE32(out + 8, count);
+    putLE32(out + 12, archiveCrc32(payload, pos));
+    putLE64(out + 16, (uint64_t)minTime);
+    putLE64(out + 24, (uint64_t)maxTime);
+    putLE32(out + 32, (uint32_t)minLat);
+    putLE32(out + 36, (uint32_t)maxLat);
+    putLE32(out + 40, (uint32_t)minLon);
+    putLE32(out + 44, (uint32_t)maxLon);
+    return ARCHIVE_BLOCK_HEADER_SIZE + pos;
+}
+
+// ---- Decoding -------------------------------------------------------------
+
+bool parseArchiveBlockHeader(const uint8_t* data, size_t available, ArchiveBlockInfo& info) {
+    if (available < ARCHIVE_BLOCK_HEADER_SIZE || getLE32(data) != ARCHIVE_BLOCK_SYNC) return false;
+    info.payloadBytes = getLE32(data + 4);
+    info.rows = getLE32(data + 8);
+    info.crc = getLE32(data + 12);
+    info.minTimeMs = (int64_t)getLE64(data + 16);
+    info.maxTimeMs = (int64_t)getLE64(data + 24);
+    info.minLatitudeE7 = (int32_t)getLE32(data + 32);
+    info.maxLatitudeE7 = (int32_t)getLE32(data + 36);
+    info.minLongitudeE7 = (int32_t)getLE32(data + 40);
+    info.maxLongitudeE7 = (int32_t)getLE32(data + 44);
+    return info.rows > 0 && info.payloadBytes >= ARCHIVE_PAYLOAD_SLACK &&
+           info.payloadBytes <= available - ARCHIVE_BLOCK_HEADER_SIZE;
+}
+
+template <typename T>
+static bool decodeColumn(const uint8_t* payload, size_t end, size_t& pos, uint32_t count, bool delta, T* out) {
+    if (pos >= end) return false;
+    unsigned width = payload[pos++];
+    uint64_t reference, first = 0;
+    if (width > 64 || !getVarint(payload, end, pos, reference)) return false;
+    if (delta && !getVarint(payload, end, pos, first)) return false;
+
+    uint32_t packedCount = delta ? count - 1 : count;
+    size_t packedBytes = ((uint64_t)packedCount * width + 7) / 8;
+    if (packedBytes > end - pos) return false;
+    const uint8_t* packed = payload + pos;
+    pos += packedBytes;
+
+    // `end` excludes the zero slack, so 8-byte loads past the packed data stay in bounds
+    uint64_t base = (uint64_t)unzigzag(reference);
+    uint64_t mask = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+    uint64_t running = (uint64_t)unzigzag(first);
+    if (delta) out[0] = (T)running;
+    uint64_t bit = 0;
+    for (uint32_t i = 0; i < packedCount; i++, bit += width) {
+        uint64_t value;
+        if (width <= 56) {
+            value = (getLE64(packed + (bit >> 3)) >> (bit & 7)) & mask;
+        } else {
+            uint64_t low = getLE64(packed + (bit >> 3)) >> (bit & 7);
+            uint64_t highBit = bit + 32;
+            uint64_t high = getLE64(packed + (highBit >> 3)) >> (highBit & 7);
+            value = ((low & 0xFFFFFFFFULL) | (high << 32)) & mask;
+        }
+        value += base;
+        if (delta) {
+            running += value;
+            out[i + 1] = (T)running;
+        } else {
+            out[i] = (T)value;
+        }
+    }
+    return true;
+}
+
+bool decodeArchiveBlock(const ArchiveBlockInfo& info, const uint8_t* payload, const ArchiveColumns& columns) {
+    if (archiveCrc32(payload, info.payloadBytes) != info.crc) return false;
+    size_t end = info.payloadBytes - ARCHIVE_PAYLOAD_SLACK;
+    size_t pos = 0;
+    uint32_t rows = info.rows;
+    return decodeColumn(payload, end, pos, rows, true, columns.timeMs) &&
+           decodeColumn(payload, end, pos, rows, false, columns.deviceEui) &&
+           decodeColumn(payload, end, pos, rows, false, columns.gatewayId) &&
+           decodeColumn(payload, end, pos, rows, true, columns.latitudeE7) &&
+           decodeColumn(payload, end, pos, rows, true, columns.longitudeE7) &&
+           decodeColumn(payload, end, pos, rows, true, columns.frameCounter) &&
+           decodeColumn(payload, end, pos, rows, false, columns.accuracyM) &&
+           decodeColumn(payload, end, pos, rows, false, columns.rssi) &&
+           decodeColumn(payload, end, pos, rows, false, columns.snrDeci) &&
+           decodeColumn(payload, end, pos, rows, false, columns.dataRate) &&
+           decodeColumn(payload, end, pos, rows, false, columns.gatewayCount) &&
+           decodeColumn(payload, end, pos, rows, false, columns.flags);
+}
+
+int64_t archiveUnixTimeMs(int year, unsigned month, unsigned day, unsigned hour, unsigned minute,
+                          unsigned second, unsigned millisecond) {
+    // Days from civil (proleptic Gregorian), valid for any year
+    int64_t y = year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yearOfEra = (unsigned)(y - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + (int64_t)dayOfEra - 719468;
+    return ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 + millisecond;
+}
+
+// CRC-32 (IEEE, reflected) with a 16-entry table to keep flash use small
+uint32_t archiveCrc32(const uint8_t* data, size_t length, uint32_t crc) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
@@ -0,0 +1,145 @@
+#ifndef SAMPLE_ARCHIVE_H
+#define SAMPLE_ARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Append-only columnar coverage sample archive, written by the firmware to
+// flash and by the host tools to disk, read back through mmap.
+//
+//   file:   "LGSA" | version u16 | reserved u16 | reserved u64
+//   block:  header (ARCHIVE_BLOCK_HEADER_SIZE) | payload
+//   header: sync u32 | payload bytes u32 | rows u32 | payload CRC-32 u32 |
+//           min time i64 | max time i64 | min/max latitude E7 i32 | min/max longitude E7 i32
+//   payload: per column in CoverageSample field order
+//           bit width u8 | zigzag varint reference [| zigzag varint first value] | bit-packed values
+//           followed by ARCHIVE_PAYLOAD_SLACK zero bytes
+//
+// The header's min/max fields form a zone map so time-window and bounding
+// box queries skip blocks without decoding them. Columns whose values move
+// smoothly (time, position, frame counter) store deltas between rows;
+// the rest store value minus block minimum. Both are then bit-packed at
+// the narrowest width covering the block. All integers are little-endian.
+// A block whose CRC does not match (torn write on power loss) ends the file.
+#define ARCHIVE_FILE_MAGIC          "LGSA"
+#define ARCHIVE_FILE_VERSION        1
+#define ARCHIVE_FILE_HEADER_SIZE    16
+#define ARCHIVE_BLOCK_SYNC          0x4B4C4241u     // "ABLK"
+#define ARCHIVE_BLOCK_HEADER_SIZE   48
+#define ARCHIVE_COLUMN_COUNT        12
+#define ARCHIVE_PAYLOAD_SLACK       8               // Lets decoders use 8-byte loads at the end
+#define ARCHIVE_ROW_BITS            360             // Widest possible packed row
+#define ARCHIVE_MAX_BLOCK_SIZE(rows) \
+    (ARCHIVE_BLOCK_HEADER_SIZE + ARCHIVE_COLUMN_COUNT * 22 + ((size_t)(rows) * ARCHIVE_ROW_BITS + 7) / 8 + \
+     ARCHIVE_COLUMN_COUNT + ARCHIVE_PAYLOAD_SLACK)
+
+#define SAMPLE_FLAG_POSITION        0x01    // Sniffer position known
+#define SAMPLE_FLAG_ESTIMATED       0x02    // Position dead-reckoned between fixes
+#define SAMPLE_FLAG_DEVICE          0x04    // Logged on the device (RSSI/SNR are the device's view)
+#define SAMPLE_FLAG_SURVEY          0x08    // Data-rate survey uplink, confirmed, at the row's data rate
+#define SAMPLE_FLAG_ACKED           0x10    // ... or confirmed, and the network acknowledged it
+#define SAMPLE_FLAG_CONFIRMED       0x20    // Status uplink the confirm policy sent confirmed
+
+#define SAMPLE_DATA_RATE_UNKNOWN    0xFF
+
+// One sample is one (uplink, receiving gateway) pair: where the sniffer
+// was, which gateway heard it and how well. Samples logged on the device
+// carry gateway 0 since the device cannot tell which gateways heard it.
+struct CoverageSample {
+    int64_t timeMs;             // Unix time of reception
+    uint64_t deviceEui;
+    uint64_t gatewayId;
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+    uint32_t frameCounter;
+    uint16_t accuracyM;
+    int16_t rssi;               // dBm
+    int16_t snrDeci;            // dB * 10
+    uint8_t dataRate;
+    uint8_t gatewayCount;       // Gateways that received the same uplink
+    uint8_t flags;
+};
+
+// Zone map and location of one block
+struct ArchiveBlockInfo {
+    uint32_t payloadBytes;
+    uint32_t rows;
+    uint32_t crc;
+    int64_t minTimeMs;
+    int64_t maxTimeMs;
+    int32_t minLatitudeE7;      // min > max when no row has a position
+    int32_t maxLatitudeE7;
+    int32_t minLongitudeE7;
+    int32_t maxLongitudeE7;
+
+    bool hasPosition() const { return minLatitudeE7 <= maxLatitudeE7; }
+};
+
+// Time window plus optional bounding box (inclusive bounds)
+struct ArchiveQuery {
+    int64_t fromMs;
+    int64_t toMs;
+    bool useBox;
+    int32_t minLatitudeE7;
+    int32_t maxLatitudeE7;
+    int32_t minLongitudeE7;
+    int32_t maxLongitudeE7;
+
+    ArchiveQuery() : fromMs(INT64_MIN), toMs(INT64_MAX), useBox(false), minLatitudeE7(0),
+                     maxLatitudeE7(0), minLongitudeE7(0), maxLongitudeE7(0) {}
+
+    bool mayMatch(const ArchiveBlockInfo& block) const {
+        if (block.maxTimeMs < fromMs || block.minTimeMs > toMs) return false;
+        if (!useBox) return true;
+        return block.hasPosition() &&
+               block.maxLatitudeE7 >= minLatitudeE7 && block.minLatitudeE7 <= maxLatitudeE7 &&
+               block.maxLongitudeE7 >= minLongitudeE7 && block.minLongitudeE7 <= maxLongitudeE7;
+    }
+
+    bool matches(int64_t timeMs, int32_t latitudeE7, int32_t longitudeE7, uint8_t flags) const {
+        if (timeMs < fromMs || timeMs > toMs) return false;
+        if (!useBox) return true;
+        return (flags & SAMPLE_FLAG_POSITION) &&
+               latitudeE7 >= minLatitudeE7 && latitudeE7 <= maxLatitudeE7 &&
+               longitudeE7 >= minLongitudeE7 && longitudeE7 <= maxLongitudeE7;
+    }
+};
+
+// Caller-owned column arrays, each with room for the block's rows
+struct ArchiveColumns {
+    int64_t* timeMs;
+    uint64_t* deviceEui;
+    uint64_t* gatewayId;
+    int32_t* latitudeE7;
+    int32_t* longitudeE7;
+    uint32_t* frameCounter;
+    uint16_t* accuracyM;
+    int16_t* rssi;
+    int16_t* snrDeci;
+    uint8_t* dataRate;
+    uint8_t* gatewayCount;
+    uint8_t* flags;
+};
+
+void writeArchiveFileHeader(uint8_t* header);
+bool checkArchiveFileHeader(const uint8_t* header, size_t length);
+
+// Encodes `count` rows as one block (header + payload). Returns the block
+// size, or 0 if `capacity` is below ARCHIVE_MAX_BLOCK_SIZE(count) and the
+// block did not fit.
+size_t encodeArchiveBlock(const CoverageSample* rows, uint32_t count, uint8_t* out, size_t capacity);
+
+// Parses a block header; false if the sync word is missing or the block
+// would extend past `available` bytes
+bool parseArchiveBlockHeader(const uint8_t* data, size_t available, ArchiveBlockInfo& info);
+
+// Unpacks a block payload into `columns`; false on CRC mismatch or corrupt columns
+bool decodeArchiveBlock(const ArchiveBlockInfo& info, const uint8_t* payload, const ArchiveColumns& columns);
+
+// UTC calendar time to Unix milliseconds, for writers holding GNSS or ISO 8601 timestamps
+int64_t archiveUnixTimeMs(int year, unsigned month, unsigned day, unsigned hour, unsigned minute,
+                          unsigned second, unsigned millisecond);
+
+uint32_t archiveCrc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+#endif // SAMPLE_ARCHIVE_H
@@ -0,0 +1,169 @@
+#include "sample_logger.h"
+#include "console_print.h"
+#include <LittleFS.h>
+#include <unistd.h>
+
+SampleLogger::SampleLogger() :
+    pendingCount(0),
+    firstPendingTime(0),
+    initialized(false),
+    full(false),
+    fileSize(0),
+    blockCount(0),
+    rowCount(0),
+    droppedRows(0) {
+}
+
+bool SampleLogger::initialize() {
+    Serial.println(F("[Archive] Mounting LittleFS..."));
+    if (!LittleFS.begin(true)) {
+        Serial.println(F("[Archive] [ERROR] LittleFS mount failed"));
+        return false;
+    }
+
+    if (!recoverFile()) {
+        // Missing or foreign file: start a fresh archive
+        File file = LittleFS.open(SAMPLE_LOG_PATH, "w");
+        if (!file) {
+            Serial.println(F("[Archive] [ERROR] Cannot create sample log"));
+            return false;
+        }
+        uint8_t header[ARCHIVE_FILE_HEADER_SIZE];
+        writeArchiveFileHeader(header);
+        file.write(header, sizeof(header));
+        file.close();
+        fileSize = ARCHIVE_FILE_HEADER_SIZE;
+        blockCount = 0;
+        rowCount = 0;
+        Serial.println(F("[Archive] Created new sample log"));
+    }
+
+    full = fileSize >= SAMPLE_LOG_MAX_BYTES;
+    initialized = true;
+    consolePrintf("[Archive] [SUCCESS] Sample log ready: %lu rows in %lu blocks, %lu bytes\n",
+                  (unsigned long)rowCount, (unsigned long)blockCount, (unsigned long)fileSize);
+    return true;
+}
+
+// Walks the block headers of an existing log; a torn block left by a
+// power cut is cut off so new blocks stay reachable for readers
+bool SampleLogger::recoverFile() {
+    File file = LittleFS.open(SAMPLE_LOG_PATH, "r");
+    if (!file) return false;
+
+    uint32_t size = file.size();
+    uint8_t header[ARCHIVE_BLOCK_HEADER_SIZE];
+    if (file.read(header, ARCHIVE_FILE_HEADER_SIZE) != ARCHIVE_FILE_HEADER_SIZE ||
+        !checkArchiveFileHeader(header, ARCHIVE_FILE_HEADER_SIZE)) {
+        file.close();
+        Serial.println(F("[Archive] [WARN] Existing sample log has an unknown header, replacing it"));
+        return false;
+    }
+
+    uint32_t offset = ARCHIVE_FILE_HEADER_SIZE;
+    blockCount = 0;
+    rowCount = 0;
+    ArchiveBlockInfo info;
+    while (offset + ARCHIVE_BLOCK_HEADER_SIZE <= size) {
+        file.seek(offset);
+        if (file.read(header, ARCHIVE_BLOCK_HEADER_SIZE) != ARCHIVE_BLOCK_HEADER_SIZE ||
+            !parseArchiveBlockHeader(header, size - offset, info)) {
+            break;
+        }
+        offset += ARCHIVE_BLOCK_HEADER_SIZE + info.payloadBytes;
+        blockCount++;
+        rowCount += info.rows;
+    }
+    file.close();
+
+    if (offset != size) {
+        consolePrintf("[Archive] [WARN] Dropping %lu bytes of torn block at offset %lu\n", (unsigned long)(size - offset),
+                      (unsigned long)offset);
+        if (truncate(SAMPLE_LOG_VFS_PATH, offset) != 0) {
+            Serial.println(F("[Archive] [ERROR] Truncate failed, replacing sample log"));
+            return false;
+        }
+    }
+    fileSize = offset;
+    return true;
+}
+
+bool SampleLogger::append(const CoverageSample& sample) {
+    if (!initialized) return false;
+    if (full) {
+        droppedRows++;
+        return false;
+    }
+
+    if (pendingCount == 0) firstPendingTime = millis();
+    pending[pendingCount++] = sample;
+    if (pendingCount == SAMPLE_LOG_BLOCK_ROWS) return writeBlock();
+    return true;
+}
+
+bool SampleLogger::flush() {
+    if (!initialized || pendingCount == 0) return true;
+    return writeBlock();
+}
+
+bool SampleLogger::writeBlock() {
+    size_t size = encodeArchiveBlock(pending, pendingCount, encoded, sizeof(encoded));
+    if (fileSize + size > SAMPLE_LOG_MAX_BYTES) {
+        consolePrintf("[Archive] [WARN] Sample log full (%lu bytes), dropping %u rows\n", (unsigned long)fileSize, pendingCount);
+        droppedRows += pendingCount;
+        pendingCount = 0;
+        full = true;
+        return false;
+    }
+
+    File file = LittleFS.open(SAMPLE_LOG_PATH, "a");
+    if (!file) {
+        Serial.println(F("[Archive] [ERROR] Cannot open sample log for append"));
+        return false;
+    }
+    size_t written = file.write(encoded, size);
+    file.close();
+    if (written != size) {
+        consolePrintf("[Archive] [ERROR] Short write: %u of %u bytes\n", (unsigned)written, (unsigned)size);
+        return false;
+    }
+
+    consolePrintf("[Archive] Wrote block of %u rows (%u bytes, %.1f bytes/row)\n",
+                  pendingCount, (unsigned)size, (float)size / pendingCount);
+    fileSize += size;
+    blockCount++;
+    rowCount += pendingCount;
+    pendingCount = 0;
+    return true;
+}
+
+void SampleLogger::clear() {
+    if (!initialized) return;
+    LittleFS.remove(SAMPLE_LOG_PATH);
+    pendingCount = 0;
+    droppedRows = 0;
+    initialized = false;
+    initialize();
+}
+
+void SampleLogger::handlePeriodicTasks() {
+    // Bound what a power cut can lose without writing tiny blocks every uplink
+    if (pendingCount > 0 && millis() - firstPendingTime > SAMPLE_LOG_FLUSH_INTERVAL) {
+        writeBlock();
+    }
+}
+
+void SampleLogger::printStatus() {
+    if (!initialized) {
+        Serial.println(F("[Archive] Status: Not initialized"));
+        return;
+    }
+    consolePrintf("[Archive] File: %s, %lu / %lu bytes%s\n", SAMPLE_LOG_PATH, (unsigned long)fileSize,
+                  (unsigned long)SAMPLE_LOG_MAX_BYTES, full ? " (FULL)" : "");
+    consolePrintf("[Archive] Rows: %lu stored in %lu blocks, %u pending, %lu dropped\n",
+                  (unsigned long)rowCount, (unsigned long)blockCount, pendingCount, (unsigned long)droppedRows);
+    if (rowCount > 0) {
+        consolePrintf("[Archive] Average: %.1f bytes/row\n",
+                      (float)(fileSize - ARCHIVE_FILE_HEADER_SIZE) / rowCount);
+    }
+}
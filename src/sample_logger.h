@@ -0,0 +1,50 @@
+#ifndef SAMPLE_LOGGER_H
+#define SAMPLE_LOGGER_H
+
+#include <Arduino.h>
+#include "sample_archive.h"
+
+// On-flash coverage log in the shared archive format (sample_archive.h);
+// the same file opens unchanged in the host tools.
+#define SAMPLE_LOG_PATH             "/samples.lgss"
+#define SAMPLE_LOG_VFS_PATH         "/littlefs" SAMPLE_LOG_PATH
+#define SAMPLE_LOG_BLOCK_ROWS       64          // Rows buffered in RAM per block
+#define SAMPLE_LOG_FLUSH_INTERVAL   900000      // Write a partial block after 15 minutes
+#define SAMPLE_LOG_MAX_BYTES        (1024UL * 1024UL)
+
+class SampleLogger {
+private:
+    CoverageSample pending[SAMPLE_LOG_BLOCK_ROWS];
+    uint8_t encoded[ARCHIVE_MAX_BLOCK_SIZE(SAMPLE_LOG_BLOCK_ROWS)];
+    uint16_t pendingCount;
+    unsigned long firstPendingTime;
+    bool initialized;
+    bool full;
+
+    // Statistics
+    uint32_t fileSize;
+    uint32_t blockCount;
+    uint32_t rowCount;
+    uint32_t droppedRows;
+
+    bool recoverFile();
+    bool writeBlock();
+
+public:
+    SampleLogger();
+
+    bool initialize();
+    bool append(const CoverageSample& sample);
+    bool flush();
+    void clear();
+    void handlePeriodicTasks();
+
+    bool isInitialized() const { return initialized; }
+    uint32_t getFileSize() const { return fileSize; }
+    uint32_t getRowCount() const { return rowCount + pendingCount; }
+    uint16_t getPendingCount() const { return pendingCount; }
+
+    void printStatus();
+};
+
+#endif // SAMPLE_LOGGER_H
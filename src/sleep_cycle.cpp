@@ -0,0 +1,189 @@
+#include "sleep_cycle.h"
+#include "console_print.h"
+#include "energy_ledger.h"
+#include "sample_archive.h"
+#include "Config.h"
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+
+#define SLEEP_RETAINED_MAGIC    0x534C4350  // "SLCP"
+#define SLEEP_RETAINED_VERSION  1           // Bump when SleepRetained changes
+
+struct SleepRetained {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t intervalS;
+    uint64_t nextSlotRtcUs;     // Fixed cadence: slots are intervalS apart from the `sleep` command
+    uint64_t sleepStartRtcUs;
+    SleepFix fix;
+    SleepStats stats;
+    uint32_t crc;               // Over everything before it, sealed when going to sleep
+};
+
+RTC_DATA_ATTR static SleepRetained retained;
+static SleepWake wake = SLEEP_WAKE_POWER_ON;
+
+static const char* WAKE_NAMES[] = {"power-on", "timer", "button"};
+
+// RTC clock: counts from power-on and keeps running through deep sleep
+static uint64_t rtcNowUs() {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_usec;
+}
+
+static uint32_t retainedCrc() {
+    return archiveCrc32((const uint8_t*)&retained, offsetof(SleepRetained, crc));
+}
+
+static bool retainedValid() {
+    return retained.magic == SLEEP_RETAINED_MAGIC && retained.version == SLEEP_RETAINED_VERSION &&
+           retained.crc == retainedCrc();
+}
+
+static void resetRetained() {
+    memset(&retained, 0, sizeof(retained));
+    retained.magic = SLEEP_RETAINED_MAGIC;
+    retained.version = SLEEP_RETAINED_VERSION;
+    sleepCycleSetInterval(SLEEP_CYCLE_INTERVAL_S);
+}
+
+float SleepStats::meanCurrentMa() const {
+    uint64_t totalMs = awakeMs + asleepMs;
+    return totalMs ? (awakeMah + asleepMah) / (totalMs / 3600000.0f) : 0.0f;
+}
+
+SleepWake sleepCycleBegin() {
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_TIMER:
+            wake = SLEEP_WAKE_TIMER;
+            break;
+        case ESP_SLEEP_WAKEUP_EXT0:
+        case ESP_SLEEP_WAKEUP_EXT1:
+        case ESP_SLEEP_WAKEUP_GPIO:
+            wake = SLEEP_WAKE_BUTTON;
+            break;
+        default:
+            wake = SLEEP_WAKE_POWER_ON;
+            break;
+    }
+
+    if (wake != SLEEP_WAKE_POWER_ON && !retainedValid()) {
+        Serial.println(F("[Sleep] [WARN] Retained state failed its check, starting over"));
+        wake = SLEEP_WAKE_POWER_ON;
+    }
+    if (wake == SLEEP_WAKE_POWER_ON) {
+        resetRetained();
+        return wake;
+    }
+
+    uint64_t now = rtcNowUs();
+    uint64_t asleepUs = now > retained.sleepStartRtcUs ? now - retained.sleepStartRtcUs : 0;
+    SleepStats& stats = retained.stats;
+    stats.asleepMs += asleepUs / 1000;
+    stats.asleepMah += (float)(asleepUs * (double)ENERGY_DEEP_SLEEP_MA / 3600e6);
+    if (wake == SLEEP_WAKE_TIMER) {
+        stats.timerWakes++;
+    } else {
+        stats.buttonWakes++;
+    }
+    consolePrintf("[Sleep] %s wake after %.1f s asleep (sleep %lu)\n", sleepWakeName(wake), asleepUs / 1e6,
+                  (unsigned long)stats.sleeps);
+    return wake;
+}
+
+SleepWake sleepCycleWake() {
+    return wake;
+}
+
+const char* sleepWakeName(SleepWake wakeCause) {
+    return wakeCause <= SLEEP_WAKE_BUTTON ? WAKE_NAMES[wakeCause] : "?";
+}
+
+void sleepCycleSetInterval(uint32_t seconds) {
+    if (seconds > 0 && seconds < SLEEP_CYCLE_MIN_INTERVAL_S) seconds = SLEEP_CYCLE_MIN_INTERVAL_S;
+    retained.intervalS = seconds;
+    retained.nextSlotRtcUs = seconds ? rtcNowUs() + seconds * 1000000ULL : 0;
+}
+
+uint32_t sleepCycleInterval() {
+    return retained.intervalS;
+}
+
+bool sleepCycleEnabled() {
+    return retained.intervalS > 0;
+}
+
+void sleepCycleRecordLink(bool restored) {
+    if (restored) {
+        retained.stats.sessionsRestored++;
+    } else {
+        retained.stats.rejoins++;
+    }
+}
+
+void sleepCycleRecordUplink(uint32_t fixWaitMs, bool retainedFix) {
+    SleepStats& stats = retained.stats;
+    uint32_t latencyMs = millis();
+    stats.uplinks++;
+    if (retainedFix) stats.retainedFixUplinks++;
+    stats.lastWakeToUplinkMs = latencyMs;
+    if (stats.uplinks == 1 || latencyMs < stats.minWakeToUplinkMs) stats.minWakeToUplinkMs = latencyMs;
+    if (latencyMs > stats.maxWakeToUplinkMs) stats.maxWakeToUplinkMs = latencyMs;
+    stats.totalWakeToUplinkMs += latencyMs;
+    stats.totalFixWaitMs += fixWaitMs;
+}
+
+void sleepCycleRetainFix(const SleepFix& fix) {
+    retained.fix = fix;
+    retained.fix.valid = true;
+    retained.fix.rtcUs = rtcNowUs();
+}
+
+bool sleepCycleLastFix(SleepFix& fix) {
+    if (!retained.fix.valid) return false;
+    fix = retained.fix;
+    float ageS = (rtcNowUs() - fix.rtcUs) / 1e6f;
+    float accuracy = fix.accuracyM + fix.speedMps * ageS;
+    fix.accuracyM = accuracy >= 65535.0f ? 0xFFFF : (uint16_t)accuracy;
+    return true;
+}
+
+const SleepStats& sleepCycleStats() {
+    return retained.stats;
+}
+
+void sleepCycleSleep(float awakeMah) {
+    if (retained.intervalS == 0) {
+        Serial.println(F("[Sleep] [ERROR] Deep sleep without a sample cycle, staying awake"));
+        return;
+    }
+    uint64_t now = rtcNowUs();
+    SleepStats& stats = retained.stats;
+    stats.awakeMs += millis();
+    stats.awakeMah += awakeMah;
+
+    // Next slot far enough ahead; a timer wake has just served the one it woke for
+    uint64_t intervalUs = retained.intervalS * 1000000ULL;
+    uint32_t advanced = 0;
+    while (retained.nextSlotRtcUs < now + SLEEP_MIN_SLEEP_MS * 1000ULL) {
+        retained.nextSlotRtcUs += intervalUs;
+        advanced++;
+    }
+    uint32_t served = wake == SLEEP_WAKE_TIMER ? 1 : 0;
+    if (advanced > served) stats.skippedSlots += advanced - served;
+
+    uint64_t sleepUs = retained.nextSlotRtcUs - now;
+    stats.sleeps++;
+    retained.sleepStartRtcUs = now;
+    retained.crc = retainedCrc();
+
+    consolePrintf("[Sleep] Sleeping %.1f s until the next sample (awake %lu ms, %.3f mAh)\n", sleepUs / 1e6,
+                  (unsigned long)millis(), awakeMah);
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup(sleepUs);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)USER_BUTTON_PIN, 0);
+    esp_deep_sleep_start();
+}
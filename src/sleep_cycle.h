@@ -0,0 +1,101 @@
+#ifndef SLEEP_CYCLE_H
+#define SLEEP_CYCLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Deep-sleep sample cycle. With an interval set, the tracker sleeps between
+// samples: the RTC timer wakes it, it takes a fix, sends one status uplink
+// and goes back to sleep until the next slot of a fixed cadence. The user
+// button wakes it into an ordinary awake window with the display.
+//
+// What has to outlive a sleep is kept in RTC memory behind a magic, layout
+// version and CRC-32: the schedule, the last fix (sent, marked estimated,
+// when the receiver has no fix within SLEEP_FIX_TIMEOUT_MS) and the cycle
+// statistics. The LoRaWAN session and nonces are kept by LoRaHandler. Any
+// boot other than a deep-sleep wake starts from defaults, as the RTC
+// memory itself does.
+//
+// Wake-to-uplink latency is millis() when the uplink completes, i.e. from
+// the end of the ROM bootloader. Average current is the energy ledger's
+// charge for the awake parts plus ENERGY_DEEP_SLEEP_MA over the time
+// asleep, measured on the RTC clock.
+
+#ifndef SLEEP_CYCLE_INTERVAL_S
+#define SLEEP_CYCLE_INTERVAL_S      0       // Sample interval from power-on; 0 = stay awake (see `sleep` command)
+#endif
+#define SLEEP_CYCLE_MIN_INTERVAL_S  30
+#define SLEEP_AWAKE_WINDOW_MS       60000   // After power-on, a button wake or console input, before sleeping
+#define SLEEP_FIX_TIMEOUT_MS        30000   // Timer wake: longest wait for the receiver's fix
+#define SLEEP_MIN_SLEEP_MS          5000    // A slot closer than this is skipped
+
+enum SleepWake {
+    SLEEP_WAKE_POWER_ON = 0,    // Or any reset that is not a deep-sleep wake
+    SLEEP_WAKE_TIMER,
+    SLEEP_WAKE_BUTTON
+};
+
+struct SleepFix {
+    bool valid;
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+    float altitudeM;
+    float speedMps;             // Grows the accuracy radius while the fix ages
+    uint16_t accuracyM;
+    uint8_t satellites;
+    uint64_t rtcUs;             // RTC clock when it was taken
+};
+
+struct SleepStats {
+    uint32_t sleeps;
+    uint32_t timerWakes;
+    uint32_t buttonWakes;
+    uint32_t skippedSlots;          // Cycle overran its interval
+    uint32_t sessionsRestored;      // Timer wakes that reused the retained LoRaWAN session
+    uint32_t rejoins;               // ... and those that had to join
+    uint32_t uplinks;               // Sent from timer wakes
+    uint32_t retainedFixUplinks;    // ... with the retained fix, the receiver had none yet
+    uint32_t lastWakeToUplinkMs;
+    uint32_t minWakeToUplinkMs;
+    uint32_t maxWakeToUplinkMs;
+    uint64_t totalWakeToUplinkMs;
+    uint64_t totalFixWaitMs;
+    uint64_t awakeMs;               // Completed awake periods
+    uint64_t asleepMs;
+    float awakeMah;
+    float asleepMah;
+
+    uint32_t meanWakeToUplinkMs() const { return uplinks ? (uint32_t)(totalWakeToUplinkMs / uplinks) : 0; }
+    uint32_t meanFixWaitMs() const { return uplinks ? (uint32_t)(totalFixWaitMs / uplinks) : 0; }
+    float meanCurrentMa() const;    // Over the completed awake and sleep periods
+};
+
+// Reads the wake cause and validates the retained state (defaults if it
+// does not check out); call first thing in setup()
+SleepWake sleepCycleBegin();
+SleepWake sleepCycleWake();
+const char* sleepWakeName(SleepWake wake);
+
+// Sample interval in seconds, 0 = cycle off; restarts the schedule
+void sleepCycleSetInterval(uint32_t seconds);
+uint32_t sleepCycleInterval();
+bool sleepCycleEnabled();
+
+// Timer wake bookkeeping: how the LoRaWAN link came back, and the uplink
+// (wake-to-uplink latency is taken here)
+void sleepCycleRecordLink(bool restored);
+void sleepCycleRecordUplink(uint32_t fixWaitMs, bool retainedFix);
+
+void sleepCycleRetainFix(const SleepFix& fix);
+// Retained fix with its accuracy grown by speed x age; false if there is none
+bool sleepCycleLastFix(SleepFix& fix);
+
+const SleepStats& sleepCycleStats();
+
+// Closes the awake period with its charge (energy ledger), arms the timer
+// for the next slot and the button, and deep-sleeps. Does not return,
+// unless the cycle is off: then there is no slot to wake for, and it logs
+// an error and returns without sleeping.
+void sleepCycleSleep(float awakeMah);
+
+#endif // SLEEP_CYCLE_H
@@ -0,0 +1,373 @@
+#include "telemetry.h"
+
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+#include <Arduino.h>
+#include "perf_stats.h"
+#endif
+
+static inline void putU8(uint8_t* buffer, size_t& offset, uint8_t value) {
+    buffer[offset++] = value;
+}
+
+static inline void putU16(uint8_t* buffer, size_t& offset, uint16_t value) {
+    buffer[offset++] = value & 0xFF;
+    buffer[offset++] = (value >> 8) & 0xFF;
+}
+
+static inline void putU32(uint8_t* buffer, size_t& offset, uint32_t value) {
+    putU16(buffer, offset, value & 0xFFFF);
+    putU16(buffer, offset, value >> 16);
+}
+
+static inline void putU64(uint8_t* buffer, size_t& offset, uint64_t value) {
+    putU32(buffer, offset, (uint32_t)value);
+    putU32(buffer, offset, (uint32_t)(value >> 32));
+}
+
+static inline uint8_t getU8(const uint8_t* buffer, size_t& offset) {
+    return buffer[offset++];
+}
+
+static inline uint16_t getU16(const uint8_t* buffer, size_t& offset) {
+    uint16_t value = buffer[offset] | ((uint16_t)buffer[offset + 1] << 8);
+    offset += 2;
+    return value;
+}
+
+static inline uint32_t getU32(const uint8_t* buffer, size_t& offset) {
+    uint32_t low = getU16(buffer, offset);
+    return low | ((uint32_t)getU16(buffer, offset) << 16);
+}
+
+static inline uint64_t getU64(const uint8_t* buffer, size_t& offset) {
+    uint64_t low = getU32(buffer, offset);
+    return low | ((uint64_t)getU32(buffer, offset) << 32);
+}
+
+// Body sizes after the 7-byte header
+#define GPS_FIX_BODY_SIZE   32
+#define UPLINK_BODY_SIZE    17
+#define BATTERY_BODY_SIZE   3
+#define SYSTEM_BODY_SIZE    (12 + 2 + TELEMETRY_SUBSYSTEMS)
+#define PERF_BODY_SIZE      31      // Before the pairs
+#define PERF_PAIR_SIZE      6
+
+// CRC-16/CCITT-FALSE, one nibble at a time
+static const uint16_t CRC_NIBBLE_TABLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc << 4) ^ CRC_NIBBLE_TABLE[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ CRC_NIBBLE_TABLE[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+size_t cobsEncode(const uint8_t* input, size_t length, uint8_t* output) {
+    size_t codeIndex = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (input[i] != 0) {
+            output[out++] = input[i];
+            code++;
+        }
+        if (input[i] == 0 || code == 0xFF) {
+            output[codeIndex] = code;
+            codeIndex = out++;
+            code = 1;
+        }
+    }
+    output[codeIndex] = code;
+    return out;
+}
+
+size_t cobsDecode(const uint8_t* input, size_t length, uint8_t* output) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < length) {
+        uint8_t code = input[in++];
+        if (code == 0 || in + code - 1 > length) return 0;
+        for (uint8_t i = 1; i < code; i++) {
+            if (input[in] == 0) return 0;
+            output[out++] = input[in++];
+        }
+        if (code != 0xFF && in < length) output[out++] = 0;
+    }
+    return out;
+}
+
+static void putHeader(uint8_t* record, size_t& offset, const TelemetryHeader& header, uint8_t type) {
+    putU8(record, offset, type);
+    putU16(record, offset, header.sequence);
+    putU32(record, offset, header.uptimeMs);
+}
+
+size_t telemetryEncodeGpsFix(uint8_t* record, const TelemetryHeader& header, const TelemetryGpsFix& fix) {
+    size_t offset = 0;
+    putHeader(record, offset, header, TELEMETRY_GPS_FIX);
+    putU64(record, offset, (uint64_t)fix.unixTimeMs);
+    putU32(record, offset, (uint32_t)fix.latitudeE7);
+    putU32(record, offset, (uint32_t)fix.longitudeE7);
+    putU32(record, offset, (uint32_t)fix.altitudeCm);
+    putU16(record, offset, fix.speedCmps);
+    putU16(record, offset, fix.courseCentiDeg);
+    putU16(record, offset, fix.hdopCenti);
+    putU16(record, offset, fix.accuracyM);
+    putU8(record, offset, fix.satellites);
+    putU8(record, offset, fix.flags);
+    putU16(record, offset, 0);  // Reserved
+    return offset;
+}
+
+size_t telemetryEncodeUplink(uint8_t* record, const TelemetryHeader& header, const TelemetryUplink& uplink) {
+    size_t offset = 0;
+    putHeader(record, offset, header, TELEMETRY_UPLINK);
+    putU32(record, offset, uplink.frameCounter);
+    putU32(record, offset, uplink.durationUs);
+    putU16(record, offset, (uint16_t)uplink.state);
+    putU16(record, offset, (uint16_t)uplink.rssi);
+    putU16(record, offset, (uint16_t)uplink.snrDeci);
+    putU8(record, offset, uplink.port);
+    putU8(record, offset, uplink.length);
+    putU8(record, offset, uplink.flags);
+    return offset;
+}
+
+size_t telemetryEncodeBattery(uint8_t* record, const TelemetryHeader& header, const TelemetryBattery& battery) {
+    size_t offset = 0;
+    putHeader(record, offset, header, TELEMETRY_BATTERY);
+    putU16(record, offset, battery.millivolts);
+    putU8(record, offset, battery.percent);
+    return offset;
+}
+
+size_t telemetryEncodeSystem(uint8_t* record, const TelemetryHeader& header, const TelemetrySystem& system) {
+    size_t offset = 0;
+    putHeader(record, offset, header, TELEMETRY_SYSTEM);
+    putU32(record, offset, system.freeHeap);
+    putU32(record, offset, system.minFreeHeap);
+    putU32(record, offset, system.droppedFrames);
+    putU8(record, offset, system.coreLoad[0]);
+    putU8(record, offset, system.coreLoad[1]);
+    for (int i = 0; i < TELEMETRY_SUBSYSTEMS; i++) putU8(record, offset, system.subsystemLoad[i]);
+    return offset;
+}
+
+size_t telemetryEncodePerf(uint8_t* record, const TelemetryHeader& header, const TelemetryPerf& perf) {
+    size_t offset = 0;
+    uint8_t pairs = perf.pairs > TELEMETRY_PERF_MAX_PAIRS ? TELEMETRY_PERF_MAX_PAIRS : perf.pairs;
+    putHeader(record, offset, header, TELEMETRY_PERF);
+    putU8(record, offset, perf.probe);
+    putU8(record, offset, perf.flags);
+    putU32(record, offset, perf.count);
+    putU64(record, offset, perf.minNs);
+    putU64(record, offset, perf.maxNs);
+    putU64(record, offset, perf.sumNs);
+    putU8(record, offset, pairs);
+    for (uint8_t i = 0; i < pairs; i++) {
+        putU16(record, offset, perf.buckets[i]);
+        putU32(record, offset, perf.counts[i]);
+    }
+    return offset;
+}
+
+size_t telemetryFrame(const uint8_t* record, size_t length, uint8_t* frame) {
+    uint8_t checked[TELEMETRY_MAX_RECORD + 2];
+    if (length > TELEMETRY_MAX_RECORD) return 0;
+    memcpy(checked, record, length);
+    size_t offset = length;
+    putU16(checked, offset, telemetryCrc16(record, length));
+
+    frame[0] = 0;
+    size_t encoded = cobsEncode(checked, offset, frame + 1);
+    frame[encoded + 1] = 0;
+    return encoded + 2;
+}
+
+bool telemetryDecodeHeader(const uint8_t* record, size_t length, TelemetryHeader& header) {
+    if (length < TELEMETRY_HEADER_SIZE) return false;
+    size_t offset = 0;
+    header.type = getU8(record, offset);
+    header.sequence = getU16(record, offset);
+    header.uptimeMs = getU32(record, offset);
+    return true;
+}
+
+// Checks type and minimum length and returns the body offset; longer
+// records from a newer firmware decode with the extra bytes ignored
+static bool bodyOf(const uint8_t* record, size_t length, uint8_t type, size_t bodySize, size_t& offset) {
+    if (length < TELEMETRY_HEADER_SIZE + bodySize || record[0] != type) return false;
+    offset = TELEMETRY_HEADER_SIZE;
+    return true;
+}
+
+bool telemetryDecodeGpsFix(const uint8_t* record, size_t length, TelemetryGpsFix& fix) {
+    size_t offset;
+    if (!bodyOf(record, length, TELEMETRY_GPS_FIX, GPS_FIX_BODY_SIZE, offset)) return false;
+    fix.unixTimeMs = (int64_t)getU64(record, offset);
+    fix.latitudeE7 = (int32_t)getU32(record, offset);
+    fix.longitudeE7 = (int32_t)getU32(record, offset);
+    fix.altitudeCm = (int32_t)getU32(record, offset);
+    fix.speedCmps = getU16(record, offset);
+    fix.courseCentiDeg = getU16(record, offset);
+    fix.hdopCenti = getU16(record, offset);
+    fix.accuracyM = getU16(record, offset);
+    fix.satellites = getU8(record, offset);
+    fix.flags = getU8(record, offset);
+    return true;
+}
+
+bool telemetryDecodeUplink(const uint8_t* record, size_t length, TelemetryUplink& uplink) {
+    size_t offset;
+    if (!bodyOf(record, length, TELEMETRY_UPLINK, UPLINK_BODY_SIZE, offset)) return false;
+    uplink.frameCounter = getU32(record, offset);
+    uplink.durationUs = getU32(record, offset);
+    uplink.state = (int16_t)getU16(record, offset);
+    uplink.rssi = (int16_t)getU16(record, offset);
+    uplink.snrDeci = (int16_t)getU16(record, offset);
+    uplink.port = getU8(record, offset);
+    uplink.length = getU8(record, offset);
+    uplink.flags = getU8(record, offset);
+    return true;
+}
+
+bool telemetryDecodeBattery(const uint8_t* record, size_t length, TelemetryBattery& battery) {
+    size_t offset;
+    if (!bodyOf(record, length, TELEMETRY_BATTERY, BATTERY_BODY_SIZE, offset)) return false;
+    battery.millivolts = getU16(record, offset);
+    battery.percent = getU8(record, offset);
+    return true;
+}
+
+bool telemetryDecodeSystem(const uint8_t* record, size_t length, TelemetrySystem& system) {
+    size_t offset;
+    if (!bodyOf(record, length, TELEMETRY_SYSTEM, SYSTEM_BODY_SIZE, offset)) return false;
+    system.freeHeap = getU32(record, offset);
+    system.minFreeHeap = getU32(record, offset);
+    system.droppedFrames = getU32(record, offset);
+    system.coreLoad[0] = getU8(record, offset);
+    system.coreLoad[1] = getU8(record, offset);
+    for (int i = 0; i < TELEMETRY_SUBSYSTEMS; i++) system.subsystemLoad[i] = getU8(record, offset);
+    return true;
+}
+
+bool telemetryDecodePerf(const uint8_t* record, size_t length, TelemetryPerf& perf) {
+    size_t offset;
+    if (!bodyOf(record, length, TELEMETRY_PERF, PERF_BODY_SIZE, offset)) return false;
+    perf.probe = getU8(record, offset);
+    perf.flags = getU8(record, offset);
+    perf.count = getU32(record, offset);
+    perf.minNs = getU64(record, offset);
+    perf.maxNs = getU64(record, offset);
+    perf.sumNs = getU64(record, offset);
+    perf.pairs = getU8(record, offset);
+    if (perf.pairs > TELEMETRY_PERF_MAX_PAIRS || length < offset + (size_t)perf.pairs * PERF_PAIR_SIZE) return false;
+    for (uint8_t i = 0; i < perf.pairs; i++) {
+        perf.buckets[i] = getU16(record, offset);
+        perf.counts[i] = getU32(record, offset);
+    }
+    return true;
+}
+
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+
+static bool enabled = TELEMETRY_DEFAULT_ENABLED;
+static uint16_t sequence = 0;
+static uint32_t sentFrames = 0;
+static uint32_t droppedFrames = 0;
+static uint8_t recordBuffer[TELEMETRY_MAX_RECORD];
+static uint8_t frameBuffer[TELEMETRY_MAX_FRAME];
+
+void telemetrySetEnabled(bool enable) {
+    enabled = enable;
+}
+
+bool telemetryEnabled() {
+    return enabled;
+}
+
+uint32_t telemetrySentFrames() {
+    return sentFrames;
+}
+
+uint32_t telemetryDroppedFrames() {
+    return droppedFrames;
+}
+
+static TelemetryHeader nextHeader() {
+    TelemetryHeader header;
+    header.sequence = sequence++;
+    header.uptimeMs = millis();
+    return header;
+}
+
+// Never waits for the host: a frame that does not fit the CDC buffer is
+// dropped whole, so the console and the loop keep their timing
+static bool sendRecord(size_t length) {
+    size_t frameLength = telemetryFrame(recordBuffer, length, frameBuffer);
+    if (frameLength == 0 || (size_t)Serial.availableForWrite() < frameLength) {
+        droppedFrames++;
+        return false;
+    }
+    Serial.write(frameBuffer, frameLength);
+    sentFrames++;
+    return true;
+}
+
+bool telemetrySendGpsFix(const TelemetryGpsFix& fix) {
+    if (!enabled) return false;
+    return sendRecord(telemetryEncodeGpsFix(recordBuffer, nextHeader(), fix));
+}
+
+bool telemetrySendUplink(const TelemetryUplink& uplink) {
+    if (!enabled) return false;
+    return sendRecord(telemetryEncodeUplink(recordBuffer, nextHeader(), uplink));
+}
+
+bool telemetrySendBattery(const TelemetryBattery& battery) {
+    if (!enabled) return false;
+    return sendRecord(telemetryEncodeBattery(recordBuffer, nextHeader(), battery));
+}
+
+bool telemetrySendSystem(TelemetrySystem& system) {
+    if (!enabled) return false;
+    system.droppedFrames = droppedFrames;
+    return sendRecord(telemetryEncodeSystem(recordBuffer, nextHeader(), system));
+}
+
+void telemetrySendPerf() {
+    if (!enabled) return;
+    static TelemetryPerf perf;
+    for (int probe = 0; probe < PERF_PROBE_COUNT; probe++) {
+        const PerfHistogram& histogram = perfHistogram((PerfProbe)probe);
+        if (histogram.getCount() == 0) continue;
+
+        perf.probe = probe;
+        perf.count = histogram.getCount();
+        perf.minNs = histogram.getMinNs();
+        perf.maxNs = histogram.getMaxNs();
+        perf.sumNs = histogram.getSumNs();
+        perf.pairs = 0;
+        for (int bucket = 0; bucket < PERF_BUCKET_COUNT; bucket++) {
+            uint32_t count = histogram.getBucketCount(bucket);
+            if (count == 0) continue;
+            if (perf.pairs == TELEMETRY_PERF_MAX_PAIRS) {
+                perf.flags = 0;
+                sendRecord(telemetryEncodePerf(recordBuffer, nextHeader(), perf));
+                perf.pairs = 0;
+            }
+            perf.buckets[perf.pairs] = bucket;
+            perf.counts[perf.pairs] = count;
+            perf.pairs++;
+        }
+        perf.flags = TELEMETRY_PERF_LAST_PART;
+        sendRecord(telemetryEncodePerf(recordBuffer, nextHeader(), perf));
+    }
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Binary telemetry multiplexed with the text console on the same serial
+// port. Each record is [type][sequence u16][uptime ms u32][body], little
+// endian, followed by a CRC-16/CCITT-FALSE and COBS-encoded between two
+// 0x00 delimiters. Console text never contains 0x00, so a reader passes
+// everything outside a frame through as text; a chunk between delimiters
+// that fails COBS or CRC is text too, which also resynchronises a reader
+// that started mid-frame. The sequence number exposes dropped frames.
+//
+// The codec is portable; the ARDUINO section (also built by the native
+// simulation) sends to Serial without blocking (frames that do not fit the
+// USB CDC buffer are dropped and counted). tools/telemetry_decode.cpp is
+// the host side.
+
+#define TELEMETRY_HEADER_SIZE       7
+#define TELEMETRY_MAX_RECORD        400     // Header and body, before CRC and COBS
+#define TELEMETRY_MAX_FRAME         (TELEMETRY_MAX_RECORD + 2 + (TELEMETRY_MAX_RECORD + 2) / 254 + 1 + 2)
+#define TELEMETRY_PERF_MAX_PAIRS    56      // (bucket, count) pairs per perf record
+#define TELEMETRY_SUBSYSTEMS        6       // Matches CPU_SUBSYSTEM_COUNT
+
+enum TelemetryType {
+    TELEMETRY_GPS_FIX = 1,
+    TELEMETRY_UPLINK = 2,
+    TELEMETRY_PERF = 3,
+    TELEMETRY_BATTERY = 4,
+    TELEMETRY_SYSTEM = 5
+};
+
+#define TELEMETRY_GPS_VALID         0x01
+#define TELEMETRY_GPS_ESTIMATED     0x02    // Dead-reckoned, no live fix
+
+#define TELEMETRY_UPLINK_SUCCESS    0x01
+#define TELEMETRY_UPLINK_CONFIRMED  0x02
+
+#define TELEMETRY_PERF_LAST_PART    0x01    // Histograms wider than one record span several
+
+struct TelemetryHeader {
+    uint8_t type;
+    uint16_t sequence;
+    uint32_t uptimeMs;
+};
+
+struct TelemetryGpsFix {
+    int64_t unixTimeMs;         // 0 until the receiver has a date
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+    int32_t altitudeCm;
+    uint16_t speedCmps;
+    uint16_t courseCentiDeg;
+    uint16_t hdopCenti;
+    uint16_t accuracyM;
+    uint8_t satellites;
+    uint8_t flags;
+};
+
+struct TelemetryUplink {
+    uint32_t frameCounter;
+    uint32_t durationUs;
+    int16_t state;              // RadioLib status code
+    int16_t rssi;
+    int16_t snrDeci;
+    uint8_t port;
+    uint8_t length;
+    uint8_t flags;
+};
+
+struct TelemetryBattery {
+    uint16_t millivolts;
+    uint8_t percent;
+};
+
+struct TelemetrySystem {
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint32_t droppedFrames;     // Telemetry frames lost to a full serial buffer
+    uint8_t coreLoad[2];        // Percent
+    uint8_t subsystemLoad[TELEMETRY_SUBSYSTEMS];
+};
+
+struct TelemetryPerf {
+    uint8_t probe;
+    uint8_t flags;
+    uint32_t count;             // Whole histogram, repeated in every part
+    uint64_t minNs;
+    uint64_t maxNs;
+    uint64_t sumNs;
+    uint8_t pairs;
+    uint16_t buckets[TELEMETRY_PERF_MAX_PAIRS];
+    uint32_t counts[TELEMETRY_PERF_MAX_PAIRS];
+};
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length);
+
+// COBS without the delimiter; output needs length + length / 254 + 1 bytes
+size_t cobsEncode(const uint8_t* input, size_t length, uint8_t* output);
+// Returns the decoded length, 0 on malformed input; output may alias input
+size_t cobsDecode(const uint8_t* input, size_t length, uint8_t* output);
+
+// Record encoders write header and body and return the record length
+size_t telemetryEncodeGpsFix(uint8_t* record, const TelemetryHeader& header, const TelemetryGpsFix& fix);
+size_t telemetryEncodeUplink(uint8_t* record, const TelemetryHeader& header, const TelemetryUplink& uplink);
+size_t telemetryEncodeBattery(uint8_t* record, const TelemetryHeader& header, const TelemetryBattery& battery);
+size_t telemetryEncodeSystem(uint8_t* record, const TelemetryHeader& header, const TelemetrySystem& system);
+size_t telemetryEncodePerf(uint8_t* record, const TelemetryHeader& header, const TelemetryPerf& perf);
+
+// Appends the CRC and wraps the record in COBS and delimiters; returns the frame length
+size_t telemetryFrame(const uint8_t* record, size_t length, uint8_t* frame);
+
+// Record decoders check type and length
+bool telemetryDecodeHeader(const uint8_t* record, size_t length, TelemetryHeader& header);
+bool telemetryDecodeGpsFix(const uint8_t* record, size_t length, TelemetryGpsFix& fix);
+bool telemetryDecodeUplink(const uint8_t* record, size_t length, TelemetryUplink& uplink);
+bool telemetryDecodeBattery(const uint8_t* record, size_t length, TelemetryBattery& battery);
+bool telemetryDecodeSystem(const uint8_t* record, size_t length, TelemetrySystem& system);
+bool telemetryDecodePerf(const uint8_t* record, size_t length, TelemetryPerf& perf);
+
+// Splits a serial byte stream into console text and verified records.
+// Sink needs onText(const char*, size_t) and onRecord(const uint8_t*, size_t).
+class TelemetryStreamDecoder {
+private:
+    uint8_t chunk[TELEMETRY_MAX_FRAME];     // Bytes since the last delimiter
+    uint8_t record[TELEMETRY_MAX_FRAME];
+    size_t used;
+    bool inFrame;
+    bool overlong;                          // Chunk too long to be a frame, passed through as text
+    uint32_t frames;
+    uint32_t rejected;
+
+    template <class Sink>
+    void closeChunk(Sink& sink) {
+        if (overlong) {
+            overlong = false;
+            return;
+        }
+        size_t length = cobsDecode(chunk, used, record);
+        if (length > TELEMETRY_HEADER_SIZE + 2 &&
+            telemetryCrc16(record, length - 2) == (uint16_t)(record[length - 2] | (record[length - 1] << 8))) {
+            frames++;
+            sink.onRecord(record, length - 2);
+            inFrame = false;
+        } else if (used > 0) {
+            // Text between two frames; its closing delimiter may open the next one
+            rejected++;
+            sink.onText((const char*)chunk, used);
+        }
+        used = 0;
+    }
+
+public:
+    TelemetryStreamDecoder() : used(0), inFrame(false), overlong(false), frames(0), rejected(0) {}
+
+    template <class Sink>
+    void feed(const uint8_t* data, size_t length, Sink& sink) {
+        const uint8_t* end = data + length;
+        while (data < end) {
+            const uint8_t* zero = (const uint8_t*)memchr(data, 0, end - data);
+            const uint8_t* stop = zero ? zero : end;
+            size_t run = stop - data;
+            if (!inFrame || overlong) {
+                if (run) sink.onText((const char*)data, run);
+            } else if (used + run > sizeof(chunk)) {
+                sink.onText((const char*)chunk, used);
+                sink.onText((const char*)data, run);
+                used = 0;
+                overlong = true;
+            } else {
+                memcpy(chunk + used, data, run);
+                used += run;
+            }
+            if (!zero) break;
+            if (inFrame) {
+                closeChunk(sink);
+            } else {
+                inFrame = true;
+            }
+            data = zero + 1;
+        }
+    }
+
+    uint32_t getFrames() const { return frames; }
+    uint32_t getRejected() const { return rejected; }       // Chunks that were not frames
+};
+
+#if defined(ARDUINO) || defined(NATIVE_SIM)
+
+// Off by default so a plain terminal stays readable; `telemetry on` or the build flag turns it on
+#ifndef TELEMETRY_DEFAULT_ENABLED
+#define TELEMETRY_DEFAULT_ENABLED   false
+#endif
+
+void telemetrySetEnabled(bool enabled);
+bool telemetryEnabled();
+
+// Stamp header and send; false if disabled or the frame was dropped
+bool telemetrySendGpsFix(const TelemetryGpsFix& fix);
+bool telemetrySendUplink(const TelemetryUplink& uplink);
+bool telemetrySendBattery(const TelemetryBattery& battery);
+bool telemetrySendSystem(TelemetrySystem& system);
+void telemetrySendPerf();      // Every probe histogram
+
+uint32_t telemetrySentFrames();
+uint32_t telemetryDroppedFrames();
+
+#endif
+
+#endif // TELEMETRY_H
@@ -0,0 +1,235 @@
+/**
+ * LoRa Gateway Sniffer - Sample Archive Query
+ *
+ * Time-window and bounding-box queries over a coverage sample archive
+ * (src/sample_archive.h). Block zone maps are checked before anything is
+ * decoded, so narrow queries only touch the blocks that can match.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o archive_query archive_query.cpp ../src/sample_archive.cpp
+ *
+ * Usage:
+ *   archive_query [--from T] [--to T] [--bbox MINLAT,MINLON,MAXLAT,MAXLON] [--csv] samples.lgss
+ *       T is Unix ms or UTC "YYYY-MM-DDTHH:MM:SS". Matching rows go to stdout with --csv,
+ *       otherwise only the counts are printed.
+ *   archive_query --bench ROWS [--queries N] [-o path]
+ *       Writes a synthetic multi-day drive log, then compares zone-map pruned
+ *       queries against full scans (results must agree) and reports latency.
+ */
+
+#include "sample_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+struct QueryResult {
+    uint64_t rows;
+    uint64_t blocksDecoded;
+    int64_t rssiSum;
+};
+
+static int64_t parseTime(const char* text) {
+    int year;
+    unsigned month, day, hour = 0, minute = 0, second = 0;
+    if (strchr(text, '-') && sscanf(text, "%d-%u-%uT%u:%u:%u", &year, &month, &day, &hour, &minute, &second) >= 3) {
+        return archiveUnixTimeMs(year, month, day, hour, minute, second, 0);
+    }
+    return strtoll(text, nullptr, 10);
+}
+
+static QueryResult runQuery(const SampleFileReader& reader, const std::vector<size_t>& blocks,
+                            const ArchiveQuery& query, SampleBlockBuffer& buffer, FILE* csv) {
+    QueryResult result = {0, 0, 0};
+    SampleBlockView view;
+    for (size_t index : blocks) {
+        if (!reader.decodeBlock(index, buffer, view)) continue;
+        result.blocksDecoded++;
+        for (uint32_t i = 0; i < view.rows; i++) {
+            if (!query.matches(view.timeMs[i], view.latitudeE7[i], view.longitudeE7[i], view.flags[i])) continue;
+            result.rows++;
+            result.rssiSum += view.rssi[i];
+            if (csv) {
+                fprintf(csv, "%lld,%016llx,%016llx,%.7f,%.7f,%u,%u,%d,%.1f,%u,%u,%u\n", (long long)view.timeMs[i],
+                        (unsigned long long)view.deviceEui[i], (unsigned long long)view.gatewayId[i],
+                        view.latitudeE7[i] / 1e7, view.longitudeE7[i] / 1e7, view.frameCounter[i],
+                        view.accuracyM[i], view.rssi[i], view.snrDeci[i] / 10.0, view.dataRate[i],
+                        view.gatewayCount[i], view.flags[i]);
+            }
+        }
+    }
+    return result;
+}
+
+// Drives around a ~40 km square for several days: 1 s GPS period while
+// moving, one to four gateways per uplink, nights parked
+static void writeSyntheticArchive(const char* path, uint64_t rows) {
+    SampleFileWriter writer;
+    if (!writer.open(path)) {
+        fprintf(stderr, "[Archive] [ERROR] Cannot create %s\n", path);
+        exit(1);
+    }
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    int64_t time = archiveUnixTimeMs(2025, 7, 1, 8, 0, 0, 0);
+    double latitude = 37.70, longitude = -122.45, heading = 0;
+    uint32_t frameCounter = 0;
+    CoverageSample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.deviceEui = 0x451cd5860fae0001ULL;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t written = 0; written < rows;) {
+        time += 1000 + (int64_t)(uniform(rng) * 200);
+        if ((time / 3600000) % 24 >= 20) time += 12 * 3600000LL;  // Parked overnight
+        heading += (uniform(rng) - 0.5) * 0.3;
+        latitude = std::min(38.05, std::max(37.70, latitude + 0.00012 * cos(heading)));
+        longitude = std::min(-122.00, std::max(-122.45, longitude + 0.00015 * sin(heading)));
+
+        sample.timeMs = time;
+        sample.latitudeE7 = (int32_t)lround(latitude * 1e7);
+        sample.longitudeE7 = (int32_t)lround(longitude * 1e7);
+        sample.frameCounter = frameCounter++;
+        sample.accuracyM = (uint16_t)(3 + uniform(rng) * 5);
+        sample.dataRate = (uint8_t)(frameCounter % 4);
+        sample.flags = SAMPLE_FLAG_POSITION | (uniform(rng) < 0.05 ? SAMPLE_FLAG_ESTIMATED : 0);
+        sample.gatewayCount = (uint8_t)(1 + uniform(rng) * 4);
+        for (uint8_t g = 0; g < sample.gatewayCount && written < rows; g++, written++) {
+            sample.gatewayId = 0x34913d8d63430000ULL + (uint64_t)(uniform(rng) * 500);
+            sample.rssi = (int16_t)(-60 - uniform(rng) * 60);
+            sample.snrDeci = (int16_t)(uniform(rng) * 250 - 150);
+            writer.append(sample);
+        }
+    }
+    writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[Archive] Wrote %llu rows in %.2f s (%.1f M rows/s): %llu bytes, %.2f bytes/row "
+           "(%.1fx smaller than %zu-byte rows)\n",
+           (unsigned long long)rows, seconds, rows / seconds / 1e6, (unsigned long long)writer.getBytesWritten(),
+           (double)writer.getBytesWritten() / rows, (double)rows * sizeof(CoverageSample) / writer.getBytesWritten(),
+           sizeof(CoverageSample));
+}
+
+static int runBenchmark(uint64_t rows, int queries, const char* path) {
+    writeSyntheticArchive(path, rows);
+    SampleFileReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "[Archive] [ERROR] Cannot read %s\n", path);
+        return 1;
+    }
+    const ArchiveBlockInfo& first = reader.block(0);
+    const ArchiveBlockInfo& last = reader.block(reader.blockCount() - 1);
+    SampleBlockBuffer buffer;
+
+    // Full decode rate
+    auto start = std::chrono::steady_clock::now();
+    QueryResult all = runQuery(reader, reader.allBlocks(), ArchiveQuery(), buffer, nullptr);
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[Archive] Full scan: %llu rows in %zu blocks, %.3f s (%.1f M rows/s)\n", (unsigned long long)all.rows,
+           reader.blockCount(), scanSeconds, all.rows / scanSeconds / 1e6);
+
+    // Random 6 h windows with a ~3 km box somewhere in the driving area
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> prunedMs, fullMs;
+    uint64_t decoded = 0, matched = 0;
+    for (int q = 0; q < queries; q++) {
+        ArchiveQuery query;
+        query.fromMs = first.minTimeMs + (int64_t)(uniform(rng) * (last.maxTimeMs - first.minTimeMs));
+        query.toMs = query.fromMs + 6 * 3600000LL;
+        query.useBox = true;
+        double latitude = 37.70 + uniform(rng) * 0.33, longitude = -122.45 + uniform(rng) * 0.42;
+        query.minLatitudeE7 = (int32_t)(latitude * 1e7);
+        query.maxLatitudeE7 = (int32_t)((latitude + 0.03) * 1e7);
+        query.minLongitudeE7 = (int32_t)(longitude * 1e7);
+        query.maxLongitudeE7 = (int32_t)((longitude + 0.035) * 1e7);
+
+        start = std::chrono::steady_clock::now();
+        QueryResult pruned = runQuery(reader, reader.blocksMatching(query), query, buffer, nullptr);
+        prunedMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (q < 20) {
+            start = std::chrono::steady_clock::now();
+            QueryResult full = runQuery(reader, reader.allBlocks(), query, buffer, nullptr);
+            fullMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            if (full.rows != pruned.rows || full.rssiSum != pruned.rssiSum) {
+                fprintf(stderr, "[Archive] [ERROR] Query %d: pruned %llu rows, full scan %llu rows\n", q,
+                        (unsigned long long)pruned.rows, (unsigned long long)full.rows);
+                return 1;
+            }
+        }
+        decoded += pruned.blocksDecoded;
+        matched += pruned.rows;
+    }
+    std::sort(prunedMs.begin(), prunedMs.end());
+    std::sort(fullMs.begin(), fullMs.end());
+    printf("[Archive] %d queries (6 h x 3 km): %.1f rows matched, %.2f of %zu blocks decoded on average\n", queries,
+           (double)matched / queries, (double)decoded / queries, reader.blockCount());
+    printf("[Archive] Pruned latency p50 %.3f ms, p99 %.3f ms; full scan p50 %.1f ms (results identical)\n",
+           prunedMs[prunedMs.size() / 2], prunedMs[prunedMs.size() * 99 / 100], fullMs[fullMs.size() / 2]);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    ArchiveQuery query;
+    bool csv = false;
+    const char* inputPath = nullptr;
+    const char* benchPath = "archive_bench.lgss";
+    uint64_t benchRows = 0;
+    int queries = 200;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            query.fromMs = parseTime(argv[++i]);
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            query.toMs = parseTime(argv[++i]);
+        } else if (strcmp(argv[i], "--bbox") == 0 && i + 1 < argc) {
+            double minLat, minLon, maxLat, maxLon;
+            if (sscanf(argv[++i], "%lf,%lf,%lf,%lf", &minLat, &minLon, &maxLat, &maxLon) != 4) {
+                fprintf(stderr, "[Archive] [ERROR] --bbox expects MINLAT,MINLON,MAXLAT,MAXLON\n");
+                return 1;
+            }
+            query.useBox = true;
+            query.minLatitudeE7 = (int32_t)lround(minLat * 1e7);
+            query.minLongitudeE7 = (int32_t)lround(minLon * 1e7);
+            query.maxLatitudeE7 = (int32_t)lround(maxLat * 1e7);
+            query.maxLongitudeE7 = (int32_t)lround(maxLon * 1e7);
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchRows = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            queries = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            benchPath = argv[++i];
+        } else {
+            inputPath = argv[i];
+        }
+    }
+    if (benchRows) return runBenchmark(benchRows, queries, benchPath);
+    if (!inputPath) {
+        fprintf(stderr, "Usage: %s [--from T] [--to T] [--bbox MINLAT,MINLON,MAXLAT,MAXLON] [--csv] samples.lgss\n"
+                        "       %s --bench ROWS [--queries N] [-o path]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    SampleFileReader reader;
+    if (!reader.open(inputPath)) {
+        fprintf(stderr, "[Archive] [ERROR] Cannot read sample archive %s\n", inputPath);
+        return 1;
+    }
+    if (csv) printf("time_ms,device_eui,gateway_id,latitude,longitude,fcnt,accuracy_m,rssi,snr,dr,gateways,flags\n");
+    SampleBlockBuffer buffer;
+    std::vector<size_t> blocks = reader.blocksMatching(query);
+    auto start = std::chrono::steady_clock::now();
+    QueryResult result = runQuery(reader, blocks, query, buffer, csv ? stdout : nullptr);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "[Archive] %llu of %llu rows matched; %llu of %zu blocks decoded in %.3f ms\n",
+            (unsigned long long)result.rows, (unsigned long long)reader.getRowCount(),
+            (unsigned long long)result.blocksDecoded, reader.blockCount(), seconds * 1e3);
+    return 0;
+}
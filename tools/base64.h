@@ -0,0 +1,129 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+// Standard (RFC 4648) base64 decoding for ChirpStack `data` fields.
+//
+// Built with SSSE3 (-mssse3 or -march=native) the decoder translates and
+// packs 16 characters per step with byte shuffles (Mula/Lemire method) and
+// finishes the tail, or any block with invalid characters, in scalar code.
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#define BASE64_INVALID 0xFF
+
+struct Base64Table {
+    uint8_t values[256];
+
+    Base64Table() {
+        for (int i = 0; i < 256; i++) values[i] = BASE64_INVALID;
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; i++) values[(uint8_t)alphabet[i]] = (uint8_t)i;
+    }
+};
+
+static inline size_t base64DecodedSize(size_t length) {
+    return (length / 4) * 3 + 3;
+}
+
+// Length after stripping '=' padding, or -1 if no valid encoding has it
+static inline long base64UnpaddedLength(const char* text, size_t length) {
+    while (length > 0 && text[length - 1] == '=') length--;
+    return length % 4 == 1 ? -1 : (long)length;
+}
+
+static inline size_t base64ExactDecodedSize(size_t unpaddedLength) {
+    return (unpaddedLength / 4) * 3 + ((unpaddedLength % 4) ? (unpaddedLength % 4) - 1 : 0);
+}
+
+// Scalar kernel for unpadded input starting at text[i] / out[o]
+static inline long base64DecodeTail(const char* text, size_t length, size_t i, uint8_t* out, size_t o) {
+    static const Base64Table table;
+    for (; i + 4 <= length; i += 4) {
+        uint32_t a = table.values[(uint8_t)text[i]];
+        uint32_t b = table.values[(uint8_t)text[i + 1]];
+        uint32_t c = table.values[(uint8_t)text[i + 2]];
+        uint32_t d = table.values[(uint8_t)text[i + 3]];
+        if ((a | b | c | d) & 0x80) return -1;
+        uint32_t triple = (a << 18) | (b << 12) | (c << 6) | d;
+        out[o++] = (triple >> 16) & 0xFF;
+        out[o++] = (triple >> 8) & 0xFF;
+        out[o++] = triple & 0xFF;
+    }
+
+    size_t rest = length - i;
+    if (rest >= 2) {
+        uint32_t a = table.values[(uint8_t)text[i]];
+        uint32_t b = table.values[(uint8_t)text[i + 1]];
+        uint32_t c = rest == 3 ? table.values[(uint8_t)text[i + 2]] : 0;
+        if ((a | b | c) & 0x80) return -1;
+        uint32_t triple = (a << 18) | (b << 12) | (c << 6);
+        out[o++] = (triple >> 16) & 0xFF;
+        if (rest == 3) out[o++] = (triple >> 8) & 0xFF;
+    }
+    return (long)o;
+}
+
+#if defined(__SSSE3__)
+// Decodes whole 16-character blocks while at least 16 output bytes fit
+// (each store writes 16, of which 12 are data). Stops early at the first
+// block holding a character outside the alphabet; returns characters consumed.
+static inline size_t base64DecodeBlocks(const char* text, size_t length, uint8_t* out, size_t capacity,
+                                        size_t& written) {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t i = 0;
+    written = 0;
+    for (; i + 16 <= length && written + 16 <= capacity; i += 16, written += 12) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), mask2F);
+        __m128i loNibbles = _mm_and_si128(chars, mask2F);
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        // Any byte with both class bits set is outside the alphabet
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF) break;
+
+        __m128i eq2F = _mm_cmpeq_epi8(chars, mask2F);
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+        __m128i values = _mm_add_epi8(chars, roll);
+
+        // 4 x 6 bits -> 3 bytes per lane, then gather the 12 data bytes
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i*)(out + written), _mm_shuffle_epi8(packed, pack));
+    }
+    return i;
+}
+#endif
+
+// Portable reference decoder; same contract as base64Decode()
+static inline long base64DecodeScalar(const char* text, size_t length, uint8_t* out, size_t capacity) {
+    long unpadded = base64UnpaddedLength(text, length);
+    if (unpadded < 0 || base64ExactDecodedSize((size_t)unpadded) > capacity) return -1;
+    return base64DecodeTail(text, (size_t)unpadded, 0, out, 0);
+}
+
+// Returns the number of bytes written, or -1 on malformed input or if
+// `capacity` is too small. Trailing '=' padding is optional.
+static inline long base64Decode(const char* text, size_t length, uint8_t* out, size_t capacity) {
+    long unpadded = base64UnpaddedLength(text, length);
+    if (unpadded < 0 || base64ExactDecodedSize((size_t)unpadded) > capacity) return -1;
+#if defined(__SSSE3__)
+    size_t written;
+    size_t consumed = base64DecodeBlocks(text, (size_t)unpadded, out, capacity, written);
+    return base64DecodeTail(text, (size_t)unpadded, consumed, out, written);
+#else
+    return base64DecodeTail(text, (size_t)unpadded, 0, out, 0);
+#endif
+}
+
+#endif // BASE64_H
@@ -0,0 +1,233 @@
+/**
+ * LoRa Gateway Sniffer - Micro-benchmark Regression Check
+ *
+ * Reads the JSON line the firmware's `bench` console command prints
+ * (src/micro_bench.*), on the device or in the native simulation, and
+ * compares it with a committed baseline. Time per op may grow by the
+ * tolerance; allocations and bytes per op are deterministic and may not grow
+ * at all. Exits 1 on any regression or missing case.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o bench_check bench_check.cpp
+ *
+ * Usage:
+ *   bench_check RESULTS [BASELINE] [--tolerance PCT] [--write-baseline PATH]
+ *       RESULTS is a console capture or a file holding the JSON line ('-' =
+ *       stdin); the last {"benchmarks": line is used. BASELINE defaults to
+ *       bench_baseline.json; --tolerance defaults to 25 (% slower allowed).
+ *       --write-baseline stores the results as the new baseline instead.
+ *
+ * Host run (native simulation, see README.md):
+ *   .pio/build/native/program --hours 0.1 --command 300:"bench 100" --console bench.log
+ *   tools/bench_check bench.log tools/bench_baseline.json
+ * The host runs 100x the device iteration counts to get above scheduler
+ * noise. Times only compare between runs on the same platform; across platforms
+ * (device results against the host baseline) only allocations are checked.
+ */
+
+#include "json_sax.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define BENCH_LINE_PREFIX   "{\"benchmarks\":"
+
+struct BenchCase {
+    std::string name;
+    double iterations;
+    double nsPerOp;
+    double allocsPerOp;         // NAN when the build does not count allocations
+    double bytesPerOp;
+};
+
+struct BenchRun {
+    std::vector<BenchCase> cases;
+    std::string platform;
+    double cpuMhz;
+};
+
+// Collects the cases of one {"benchmarks":[...], ...} object
+class BenchHandler {
+private:
+    BenchRun& run;
+    std::string currentKey;
+    int depth;
+
+    double* field() {
+        if (depth == 3 && !run.cases.empty()) {
+            BenchCase& current = run.cases.back();
+            if (currentKey == "iterations") return &current.iterations;
+            if (currentKey == "ns_per_op") return &current.nsPerOp;
+            if (currentKey == "allocs_per_op") return &current.allocsPerOp;
+            if (currentKey == "bytes_per_op") return &current.bytesPerOp;
+        }
+        if (depth == 1 && currentKey == "cpu_mhz") return &run.cpuMhz;
+        return nullptr;
+    }
+
+public:
+    explicit BenchHandler(BenchRun& target) : run(target), depth(0) {}
+
+    void startObject() {
+        depth++;
+        if (depth == 3) run.cases.push_back(BenchCase{std::string(), 0, 0, NAN, NAN});
+    }
+    void endObject() { depth--; }
+    void startArray() { depth++; }
+    void endArray() { depth--; }
+    void key(const char* text, size_t length) { currentKey.assign(text, length); }
+    void string(const char* text, size_t length, bool) {
+        if (depth == 3 && currentKey == "name" && !run.cases.empty()) run.cases.back().name.assign(text, length);
+        if (depth == 1 && currentKey == "platform") run.platform.assign(text, length);
+    }
+    void number(const char* text, size_t length) {
+        double* target = field();
+        if (target) *target = strtod(std::string(text, length).c_str(), nullptr);
+    }
+    void literal(char) {}
+};
+
+static bool readFile(const char* path, std::string& content) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!file) return false;
+    char buffer[65536];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) content.append(buffer, got);
+    if (file != stdin) fclose(file);
+    return true;
+}
+
+// Last benchmark line in a console capture (or the whole baseline file)
+static bool loadRun(const char* path, BenchRun& run, std::string* line) {
+    std::string content;
+    if (!readFile(path, content)) {
+        fprintf(stderr, "[Bench] [ERROR] Cannot read %s\n", path);
+        return false;
+    }
+    size_t start = content.rfind(BENCH_LINE_PREFIX);
+    if (start == std::string::npos) {
+        fprintf(stderr, "[Bench] [ERROR] No benchmark results in %s\n", path);
+        return false;
+    }
+    size_t end = content.find('\n', start);
+    if (end == std::string::npos) end = content.size();
+    std::string json = content.substr(start, end - start);
+    while (!json.empty() && (json.back() == '\r' || json.back() == ' ')) json.pop_back();
+
+    run.cpuMhz = 0;
+    BenchHandler handler(run);
+    JsonResult result = parseJson(json.data(), json.data() + json.size(), handler);
+    if (result.status != JSON_OK) {
+        fprintf(stderr, "[Bench] [ERROR] Malformed results in %s at offset %zu\n", path, result.offset);
+        return false;
+    }
+    if (line) *line = json;
+    return true;
+}
+
+static const BenchCase* findCase(const BenchRun& run, const std::string& name) {
+    for (const BenchCase& bench : run.cases) {
+        if (bench.name == name) return &bench;
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    const char* resultsPath = nullptr;
+    const char* baselinePath = "bench_baseline.json";
+    const char* writePath = nullptr;
+    double tolerance = 25.0;
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+            writePath = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Usage: %s RESULTS [BASELINE] [--tolerance PCT] [--write-baseline PATH]\n", argv[0]);
+            return 2;
+        } else if (positional == 0) {
+            resultsPath = argv[i];
+            positional++;
+        } else {
+            baselinePath = argv[i];
+            positional++;
+        }
+    }
+    if (!resultsPath) {
+        fprintf(stderr, "Usage: %s RESULTS [BASELINE] [--tolerance PCT] [--write-baseline PATH]\n", argv[0]);
+        return 2;
+    }
+
+    BenchRun current;
+    std::string line;
+    if (!loadRun(resultsPath, current, &line)) return 2;
+
+    if (writePath) {
+        FILE* file = fopen(writePath, "wb");
+        if (!file || fprintf(file, "%s\n", line.c_str()) < 0 || fclose(file) != 0) {
+            fprintf(stderr, "[Bench] [ERROR] Cannot write %s\n", writePath);
+            return 2;
+        }
+        fprintf(stderr, "[Bench] Baseline %s: %zu cases (%s)\n", writePath, current.cases.size(),
+                current.platform.c_str());
+        return 0;
+    }
+
+    BenchRun baseline;
+    if (!loadRun(baselinePath, baseline, nullptr)) return 2;
+    bool compareTime = current.platform == baseline.platform;
+    if (!compareTime) {
+        fprintf(stderr, "[Bench] [WARN] Results from %s, baseline from %s: checking allocations only\n",
+                current.platform.c_str(), baseline.platform.c_str());
+    }
+
+    printf("%-24s %12s %12s %8s %10s %10s  %s\n", "case", "ns/op", "baseline", "change", "allocs/op", "bytes/op",
+           "verdict");
+    int regressions = 0;
+    for (const BenchCase& base : baseline.cases) {
+        const BenchCase* now = findCase(current, base.name);
+        if (!now) {
+            printf("%-24s %12s %12.1f %8s %10s %10s  MISSING\n", base.name.c_str(), "-", base.nsPerOp, "-", "-", "-");
+            regressions++;
+            continue;
+        }
+        double change = base.nsPerOp > 0 ? (now->nsPerOp / base.nsPerOp - 1.0) * 100.0 : 0.0;
+        const char* verdict = "ok";
+        if (compareTime && change > tolerance) verdict = "SLOWER";
+        // Allocation counts are exact; a fraction of an allocation per op still means a new one in the loop
+        if (!isnan(now->allocsPerOp) && !isnan(base.allocsPerOp) &&
+            (now->allocsPerOp > base.allocsPerOp + 1e-9 || now->bytesPerOp > base.bytesPerOp + 1e-9)) {
+            verdict = "ALLOCATES";
+        }
+        if (strcmp(verdict, "ok") != 0) regressions++;
+
+        char allocs[16] = "-";
+        char bytes[16] = "-";
+        if (!isnan(now->allocsPerOp)) {
+            snprintf(allocs, sizeof(allocs), "%.3f", now->allocsPerOp);
+            snprintf(bytes, sizeof(bytes), "%.1f", now->bytesPerOp);
+        }
+        printf("%-24s %12.1f %12.1f %+7.1f%% %10s %10s  %s\n", base.name.c_str(), now->nsPerOp, base.nsPerOp, change,
+               allocs, bytes, verdict);
+    }
+    for (const BenchCase& now : current.cases) {
+        if (!findCase(baseline, now.name)) {
+            printf("%-24s %12.1f %12s %8s %10s %10s  new (not in baseline)\n", now.name.c_str(), now.nsPerOp, "-", "-",
+                   "-", "-");
+        }
+    }
+
+    if (regressions) {
+        fprintf(stderr, "[Bench] %d regression(s) against %s (time tolerance %.0f%%)\n", regressions, baselinePath,
+                tolerance);
+        return 1;
+    }
+    fprintf(stderr, "[Bench] No regressions against %s (time tolerance %.0f%%)\n", baselinePath, tolerance);
+    return 0;
+}
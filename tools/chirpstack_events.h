@@ -0,0 +1,329 @@
+#ifndef CHIRPSTACK_EVENTS_H
+#define CHIRPSTACK_EVENTS_H
+
+// SAX handler turning ChirpStack uplink events into coverage samples, one
+// per receiving gateway. Works on a JSON array export, JSONL, or a single
+// event object (MQTT/UDP message); the nesting level of events is detected
+// from the first container. Port 3 (status), port 5 (survey) and port 6
+// (config ack, with or without the status layout after it) `data` are
+// decoded with the firmware's payload codec. `Sink` needs
+// `void append(const CoverageSample&)`.
+
+#include "payload_codec.h"
+#include "sample_archive.h"
+#include "json_sax.h"
+#include "base64.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <string>
+
+#define INGEST_MAX_GATEWAYS     32
+#define INGEST_MAX_DATA_BYTES   256
+
+enum FieldKey {
+    KEY_OTHER = 0,
+    KEY_TIME,
+    KEY_DEVICE_INFO,
+    KEY_DEV_EUI,
+    KEY_FCNT,
+    KEY_FPORT,
+    KEY_DR,
+    KEY_DATA,
+    KEY_CODE,
+    KEY_RX_INFO,
+    KEY_GATEWAY_ID,
+    KEY_RSSI,
+    KEY_SNR
+};
+
+static FieldKey classifyKey(const char* text, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(text, "dr", 2) == 0) return KEY_DR;
+            break;
+        case 3:
+            if (memcmp(text, "snr", 3) == 0) return KEY_SNR;
+            break;
+        case 4:
+            if (memcmp(text, "time", 4) == 0) return KEY_TIME;
+            if (memcmp(text, "fCnt", 4) == 0) return KEY_FCNT;
+            if (memcmp(text, "data", 4) == 0) return KEY_DATA;
+            if (memcmp(text, "code", 4) == 0) return KEY_CODE;
+            if (memcmp(text, "rssi", 4) == 0) return KEY_RSSI;
+            break;
+        case 5:
+            if (memcmp(text, "fPort", 5) == 0) return KEY_FPORT;
+            break;
+        case 6:
+            if (memcmp(text, "devEui", 6) == 0) return KEY_DEV_EUI;
+            if (memcmp(text, "rxInfo", 6) == 0) return KEY_RX_INFO;
+            break;
+        case 9:
+            if (memcmp(text, "gatewayId", 9) == 0) return KEY_GATEWAY_ID;
+            break;
+        case 10:
+            if (memcmp(text, "deviceInfo", 10) == 0) return KEY_DEVICE_INFO;
+            break;
+    }
+    return KEY_OTHER;
+}
+
+static uint64_t parseHex64(const char* text, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length && i < 16; i++) {
+        char c = text[i];
+        uint64_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else break;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = (unsigned)(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+static int parseDigits(const char* text, int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++) value = value * 10 + (text[i] - '0');
+    return value;
+}
+
+// "2025-07-15T02:20:18.076+00:00" (any fraction length, Z or +hh:mm) -> Unix ms
+static int64_t parseIsoTime(const char* text, size_t length) {
+    if (length < 19) return 0;
+    int64_t days = daysFromCivil(parseDigits(text, 4), parseDigits(text + 5, 2), parseDigits(text + 8, 2));
+    int64_t ms = ((days * 24 + parseDigits(text + 11, 2)) * 60 + parseDigits(text + 14, 2)) * 60000 +
+                 parseDigits(text + 17, 2) * 1000;
+    size_t i = 19;
+    if (i < length && text[i] == '.') {
+        int scale = 100;
+        for (i++; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+            ms += (text[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    if (i + 6 <= length && (text[i] == '+' || text[i] == '-')) {
+        int offsetMinutes = parseDigits(text + i + 1, 2) * 60 + parseDigits(text + i + 4, 2);
+        ms -= (text[i] == '+' ? 1 : -1) * (int64_t)offsetMinutes * 60000;
+    }
+    return ms;
+}
+
+struct GatewayReception {
+    uint64_t gatewayId;
+    int16_t rssi;
+    int16_t snrDeci;
+};
+
+struct IngestStats {
+    uint64_t events;
+    uint64_t uplinks;
+    uint64_t decoded;
+    uint64_t decodeFailures;
+    uint64_t samples;
+    uint64_t withPosition;
+    std::map<std::string, uint64_t> errorCodes;
+
+    IngestStats() : events(0), uplinks(0), decoded(0), decodeFailures(0), samples(0), withPosition(0) {}
+};
+
+template <typename Sink>
+class ChirpStackEventHandler {
+private:
+    Sink& sink;
+    IngestStats& stats;
+
+    // Nesting: keyOf[d] is the key that opened the container at depth d
+    FieldKey keyOf[JSON_MAX_DEPTH + 1];
+    int depth;
+    int eventLevel;         // Depth inside an event object; -1 until the layout is known
+    FieldKey pendingKey;
+
+    // Current event
+    int64_t timeMs;
+    uint64_t deviceEui;
+    uint32_t frameCounter;
+    int fPort;
+    int dataRate;
+    bool hasData;
+    uint8_t data[INGEST_MAX_DATA_BYTES];
+    long dataLength;
+    GatewayReception gateways[INGEST_MAX_GATEWAYS];
+    int gatewayCount;
+    GatewayReception currentGateway;
+
+    bool inEvent() const { return eventLevel > 0 && depth >= eventLevel; }
+    bool inGateway() const { return depth == eventLevel + 2 && keyOf[eventLevel + 1] == KEY_RX_INFO; }
+
+    void beginEvent() {
+        timeMs = 0;
+        deviceEui = 0;
+        frameCounter = 0;
+        fPort = -1;
+        dataRate = -1;
+        hasData = false;
+        dataLength = 0;
+        gatewayCount = 0;
+    }
+
+    void finishEvent() {
+        stats.events++;
+        if (!hasData) return;
+        stats.uplinks++;
+
+        CoverageSample sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.timeMs = timeMs;
+        sample.deviceEui = deviceEui;
+        sample.frameCounter = frameCounter;
+        sample.dataRate = dataRate < 0 ? 0xFF : (uint8_t)dataRate;
+        sample.gatewayCount = (uint8_t)gatewayCount;
+
+        if (fPort == CONFIG_ACK_PORT && dataLength == CONFIG_ACK_SIZE) {
+            stats.decoded++;    // Ack alone: no status to place the sample
+        } else if (fPort == STATUS_PORT || fPort == CONFIG_ACK_PORT) {
+            size_t skip = fPort == CONFIG_ACK_PORT ? CONFIG_ACK_SIZE : 0;
+            StatusPayload status;
+            if (dataLength >= (long)skip && decodeStatusPayload(data + skip, (size_t)dataLength - skip, status)) {
+                stats.decoded++;
+                if (status.hasGPS && isfinite(status.latitude) && isfinite(status.longitude)) {
+                    sample.flags |= SAMPLE_FLAG_POSITION;
+                    sample.latitudeE7 = (int32_t)lround(status.latitude * 1e7);
+                    sample.longitudeE7 = (int32_t)lround(status.longitude * 1e7);
+                    if (status.hasPositionQuality) {
+                        sample.accuracyM = status.accuracyM;
+                        if (status.positionFlags & STATUS_FLAG_ESTIMATED) sample.flags |= SAMPLE_FLAG_ESTIMATED;
+                    }
+                }
+            } else {
+                stats.decodeFailures++;
+            }
+        } else if (fPort == SURVEY_PORT) {
+            // Data-rate survey uplink: position only, the data rate comes from txInfo as for any uplink
+            SurveyPayload survey;
+            if (dataLength >= 0 && decodeSurveyPayload(data, (size_t)dataLength, survey)) {
+                stats.decoded++;
+                sample.flags |= SAMPLE_FLAG_POSITION | SAMPLE_FLAG_SURVEY;
+                sample.latitudeE7 = survey.latitudeE7;
+                sample.longitudeE7 = survey.longitudeE7;
+            } else {
+                stats.decodeFailures++;
+            }
+        }
+
+        if (sample.flags & SAMPLE_FLAG_POSITION) stats.withPosition++;
+        for (int i = 0; i < gatewayCount; i++) {
+            sample.gatewayId = gateways[i].gatewayId;
+            sample.rssi = gateways[i].rssi;
+            sample.snrDeci = gateways[i].snrDeci;
+            sink.append(sample);
+            stats.samples++;
+        }
+    }
+
+    void value(const char* text, size_t length, bool isString) {
+        if (!inEvent()) return;
+        if (depth == eventLevel) {
+            switch (pendingKey) {
+                case KEY_TIME:
+                    if (isString) timeMs = parseIsoTime(text, length);
+                    break;
+                case KEY_FCNT:
+                    frameCounter = (uint32_t)jsonToInt(text, length);
+                    break;
+                case KEY_FPORT:
+                    fPort = (int)jsonToInt(text, length);
+                    break;
+                case KEY_DR:
+                    dataRate = (int)jsonToInt(text, length);
+                    break;
+                case KEY_DATA:
+                    if (isString) {
+                        hasData = true;
+                        dataLength = base64Decode(text, length, data, sizeof(data));
+                    }
+                    break;
+                case KEY_CODE:
+                    if (isString) stats.errorCodes[std::string(text, length)]++;
+                    break;
+                default:
+                    break;
+            }
+        } else if (depth == eventLevel + 1 && keyOf[depth] == KEY_DEVICE_INFO) {
+            if (pendingKey == KEY_DEV_EUI && isString) deviceEui = parseHex64(text, length);
+        } else if (inGateway()) {
+            switch (pendingKey) {
+                case KEY_GATEWAY_ID:
+                    if (isString) currentGateway.gatewayId = parseHex64(text, length);
+                    break;
+                case KEY_RSSI:
+                    currentGateway.rssi = (int16_t)jsonToInt(text, length);
+                    break;
+                case KEY_SNR:
+                    currentGateway.snrDeci = (int16_t)jsonToFixed(text, length, 1);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void open(bool isObject) {
+        if (eventLevel < 0) eventLevel = isObject ? 1 : 2;
+        depth++;
+        keyOf[depth] = pendingKey;
+        pendingKey = KEY_OTHER;
+        if (!isObject) return;
+        if (depth == eventLevel) beginEvent();
+        else if (inGateway()) currentGateway = GatewayReception{0, 0, 0};
+    }
+
+    void close(bool isObject) {
+        if (isObject) {
+            if (depth == eventLevel) {
+                finishEvent();
+            } else if (inGateway() && gatewayCount < INGEST_MAX_GATEWAYS) {
+                gateways[gatewayCount++] = currentGateway;
+            }
+        }
+        depth--;
+        pendingKey = KEY_OTHER;
+    }
+
+public:
+    ChirpStackEventHandler(Sink& sampleSink, IngestStats& ingestStats)
+        : sink(sampleSink), stats(ingestStats), depth(0), eventLevel(-1), pendingKey(KEY_OTHER) {
+        keyOf[0] = KEY_OTHER;
+        beginEvent();
+    }
+
+    // Drops a half-parsed event (after a JSON error in one message) but keeps the detected layout
+    void reset() {
+        depth = 0;
+        pendingKey = KEY_OTHER;
+        beginEvent();
+    }
+
+    void startObject() { open(true); }
+    void endObject() { close(true); }
+    void startArray() { open(false); }
+    void endArray() { close(false); }
+    void key(const char* text, size_t length) { pendingKey = inEvent() ? classifyKey(text, length) : KEY_OTHER; }
+    void string(const char* text, size_t length, bool) { value(text, length, true); pendingKey = KEY_OTHER; }
+    void number(const char* text, size_t length) { value(text, length, false); pendingKey = KEY_OTHER; }
+    void literal(char) { pendingKey = KEY_OTHER; }
+};
+
+#endif // CHIRPSTACK_EVENTS_H
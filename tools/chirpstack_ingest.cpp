@@ -0,0 +1,265 @@
+/**
+ * LoRa Gateway Sniffer - ChirpStack Event Ingester
+ *
+ * Streams ChirpStack uplink exports (like logs/log.json) into the columnar
+ * coverage sample file (sample_file.h). Files are memory-mapped and parsed
+ * in a single SAX pass, so exports larger than RAM work; JSONL can also be
+ * piped in on stdin. Port 3 `data` is decoded with the firmware's own
+ * payload codec (src/payload_codec.*), and every rxInfo[] entry becomes
+ * one sample.
+ *
+ * Build:
+ *   g++ -O2 -mssse3 -std=c++17 -I../src -o chirpstack_ingest chirpstack_ingest.cpp ../src/payload_codec.cpp \
+ *       ../src/sample_archive.cpp
+ *
+ * Usage:
+ *   chirpstack_ingest [-o samples.lgss] <export.json | ->
+ *   chirpstack_ingest --generate EVENTS export.json      (synthetic benchmark input)
+ *
+ * Throughput (MB/s, events/s) is always reported on stderr.
+ */
+
+#include "chirpstack_events.h"
+#include "sample_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#define INGEST_STDIN_CHUNK      (1 << 20)
+
+typedef ChirpStackEventHandler<SampleFileWriter> EventHandler;
+
+static bool ingestMapped(const char* path, EventHandler& handler, uint64_t& bytes) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[Ingest] [ERROR] Cannot open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    bytes = (uint64_t)info.st_size;
+    if (bytes == 0) {
+        close(fd);
+        return true;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "[Ingest] [ERROR] mmap failed for %s\n", path);
+        return false;
+    }
+    madvise(mapped, bytes, MADV_SEQUENTIAL);
+
+    const char* text = (const char*)mapped;
+    JsonResult result = parseJson(text, text + bytes, handler);
+    munmap(mapped, bytes);
+    if (result.status != JSON_OK) {
+        fprintf(stderr, "[Ingest] [ERROR] JSON error %d at byte %zu\n", result.status, result.offset);
+        return false;
+    }
+    return true;
+}
+
+// JSONL on stdin: parse whole lines, carry the partial tail to the next read
+static bool ingestStream(FILE* input, EventHandler& handler, uint64_t& bytes) {
+    std::vector<char> buffer(INGEST_STDIN_CHUNK * 2);
+    size_t carried = 0;
+    bytes = 0;
+    while (true) {
+        if (buffer.size() - carried < INGEST_STDIN_CHUNK) buffer.resize(buffer.size() * 2);
+        size_t got = fread(buffer.data() + carried, 1, buffer.size() - carried, input);
+        bytes += got;
+        size_t available = carried + got;
+        if (got == 0) {
+            if (available == 0) return true;
+            JsonResult result = parseJson(buffer.data(), buffer.data() + available, handler);
+            if (result.status != JSON_OK) {
+                fprintf(stderr, "[Ingest] [ERROR] JSON error %d near byte %llu\n", result.status,
+                        (unsigned long long)(bytes - available + result.offset));
+                return false;
+            }
+            return true;
+        }
+
+        const char* lastNewline = (const char*)memrchr(buffer.data(), '\n', available);
+        if (!lastNewline) {
+            carried = available;
+            continue;
+        }
+        size_t complete = lastNewline - buffer.data() + 1;
+        JsonResult result = parseJson(buffer.data(), buffer.data() + complete, handler);
+        if (result.status != JSON_OK) {
+            fprintf(stderr, "[Ingest] [ERROR] JSON error %d near byte %llu\n", result.status,
+                    (unsigned long long)(bytes - available + result.offset));
+            return false;
+        }
+        carried = available - complete;
+        memmove(buffer.data(), buffer.data() + complete, carried);
+    }
+}
+
+static void base64Encode(const uint8_t* data, size_t length, std::string& out) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.clear();
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < length) triple |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) triple |= data[i + 2];
+        out += alphabet[(triple >> 18) & 0x3F];
+        out += alphabet[(triple >> 12) & 0x3F];
+        out += i + 1 < length ? alphabet[(triple >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? alphabet[triple & 0x3F] : '=';
+    }
+}
+
+// Synthetic export shaped like logs/log.json: status uplinks from a fleet of
+// sniffers driving around, 1-4 receiving gateways each, plus codec errors
+static int generateExport(uint64_t events, const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "[Ingest] [ERROR] Cannot create %s\n", path);
+        return 1;
+    }
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::string encoded;
+    int64_t baseSeconds = 1752545000;
+
+    fputs("[\n", out);
+    for (uint64_t i = 0; i < events; i++) {
+        int64_t seconds = baseSeconds + (int64_t)(i * 2);
+        int64_t day = seconds / 86400, rem = seconds % 86400;
+        int64_t z = day + 719468, era = z / 146097, doe = z - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100), mp = (5 * doy + 2) / 153;
+        int dayOfMonth = (int)(doy - (153 * mp + 2) / 5 + 1), month = (int)(mp < 10 ? mp + 3 : mp - 9);
+        int year = (int)(yoe + era * 400 + (month <= 2));
+        char timestamp[40];
+        snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03d+00:00", year, month,
+                 dayOfMonth, (int)(rem / 3600), (int)(rem / 60 % 60), (int)(rem % 60), (int)(i % 1000));
+        unsigned device = (unsigned)(i % 64);
+
+        if (i % 97 == 0) {
+            fprintf(out, "%s    {\n        \"time\": \"%s\",\n        \"deviceInfo\": {\n"
+                         "            \"deviceName\": \"Gateway Sniffer\",\n"
+                         "            \"devEui\": \"451cd5860fae%04x\"\n        },\n"
+                         "        \"level\": \"ERROR\",\n        \"code\": \"UPLINK_CODEC\",\n"
+                         "        \"description\": \"JS error: Error: console is not defined\\n    at <eval> (eval_script:98:1)\\n\",\n"
+                         "        \"context\": {\n            \"deduplication_id\": \"e5c758fe-a7e6-4a15-8a57-e94e4d6d0572\"\n        }\n    }",
+                    i ? ",\n" : "", timestamp, device);
+            continue;
+        }
+
+        StatusPayload status;
+        status.uptimeSeconds = (uint32_t)(i * 2);
+        status.freeHeapKB = 356;
+        status.rssiByte = StatusPayload::encodeRssi(-45 - (float)(uniform(rng) * 60));
+        status.snrByte = StatusPayload::encodeSnr((float)(uniform(rng) * 20 - 10));
+        status.batteryMv = 3700 + (uint16_t)(uniform(rng) * 400);
+        status.batteryPercent = 60;
+        status.hasGPS = uniform(rng) < 0.9;
+        status.latitude = (float)(37.70 + uniform(rng) * 0.2);
+        status.longitude = (float)(-122.50 + uniform(rng) * 0.2);
+        status.altitude = 20.0f;
+        status.satellites = 9;
+        status.hasPositionQuality = true;
+        status.positionFlags = uniform(rng) < 0.1 ? STATUS_FLAG_ESTIMATED : 0;
+        status.accuracyM = 5;
+        uint8_t payload[STATUS_MAX_SIZE];
+        size_t size = encodeStatusPayload(status, payload, sizeof(payload));
+        base64Encode(payload, size, encoded);
+
+        fprintf(out, "%s    {\n        \"deduplicationId\": \"b6156787-578a-4588-a2ae-%012llx\",\n"
+                     "        \"time\": \"%s\",\n        \"deviceInfo\": {\n"
+                     "            \"tenantName\": \"structuresense\",\n"
+                     "            \"deviceProfileName\": \"Gateway Sniffer\",\n"
+                     "            \"deviceName\": \"Gateway Sniffer\",\n"
+                     "            \"devEui\": \"451cd5860fae%04x\",\n"
+                     "            \"deviceClassEnabled\": \"CLASS_A\",\n            \"tags\": {}\n        },\n"
+                     "        \"devAddr\": \"78000003\",\n        \"adr\": true,\n        \"dr\": %d,\n"
+                     "        \"fCnt\": %llu,\n        \"fPort\": 3,\n        \"confirmed\": false,\n"
+                     "        \"data\": \"%s\",\n        \"object\": {\n            \"has_gps\": %s\n        },\n"
+                     "        \"rxInfo\": [",
+                i ? ",\n" : "", (unsigned long long)i, timestamp, device, (int)(i % 4),
+                (unsigned long long)(i / 64), encoded.c_str(), status.hasGPS ? "true" : "false");
+        int gateways = 1 + (int)(uniform(rng) * 4);
+        for (int g = 0; g < gateways; g++) {
+            fprintf(out, "%s\n            {\n                \"gatewayId\": \"34913d8d6343%04x\",\n"
+                         "                \"uplinkId\": %d,\n"
+                         "                \"rssi\": %d,\n                \"snr\": %.1f,\n"
+                         "                \"metadata\": {\n                    \"regi\": \"US915\",\n"
+                         "                    \"network\": \"helium_iot\"\n                },\n"
+                         "                \"crcStatus\": \"CRC_OK\"\n            }",
+                    g ? "," : "", (unsigned)(uniform(rng) * 500), (int)(uniform(rng) * 65535),
+                    -60 - (int)(uniform(rng) * 60), uniform(rng) * 25 - 15);
+        }
+        fputs("\n        ],\n        \"txInfo\": {\n            \"frequency\": 905300000,\n"
+              "            \"modulation\": {\n                \"lora\": {\n"
+              "                    \"bandwidth\": 125000,\n                    \"spreadingFactor\": 10,\n"
+              "                    \"codeRate\": \"CR_4_5\"\n                }\n            }\n        },\n"
+              "        \"regionConfigId\": \"us915_1\"\n    }", out);
+    }
+    fputs("\n]\n", out);
+    fclose(out);
+    fprintf(stderr, "[Ingest] Generated %llu events in %s\n", (unsigned long long)events, path);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* outputPath = "samples.lgss";
+    const char* inputPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--generate") == 0 && i + 2 < argc) {
+            return generateExport(strtoull(argv[i + 1], nullptr, 10), argv[i + 2]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            inputPath = argv[i];
+        }
+    }
+    if (!inputPath) {
+        fprintf(stderr, "Usage: %s [-o samples.lgss] <export.json | ->\n"
+                        "       %s --generate EVENTS export.json\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    SampleFileWriter writer;
+    if (!writer.open(outputPath)) {
+        fprintf(stderr, "[Ingest] [ERROR] Cannot create %s\n", outputPath);
+        return 1;
+    }
+
+    IngestStats stats;
+    EventHandler handler(writer, stats);
+    uint64_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = strcmp(inputPath, "-") == 0 ? ingestStream(stdin, handler, bytes)
+                                          : ingestMapped(inputPath, handler, bytes);
+    writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(stderr, "[Ingest] %llu events (%llu uplinks, %llu decoded, %llu decode failures)\n",
+            (unsigned long long)stats.events, (unsigned long long)stats.uplinks,
+            (unsigned long long)stats.decoded, (unsigned long long)stats.decodeFailures);
+    fprintf(stderr, "[Ingest] %llu samples written to %s (%llu uplinks with position)\n",
+            (unsigned long long)stats.samples, outputPath, (unsigned long long)stats.withPosition);
+    for (const auto& code : stats.errorCodes) {
+        fprintf(stderr, "[Ingest] Error events %s: %llu\n", code.first.c_str(), (unsigned long long)code.second);
+    }
+    if (seconds > 0) {
+        fprintf(stderr, "[Ingest] %.1f MB in %.3f s: %.1f MB/s, %.0f events/s\n", bytes / 1e6, seconds,
+                bytes / 1e6 / seconds, stats.events / seconds);
+    }
+    return ok ? 0 : 1;
+}
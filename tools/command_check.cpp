@@ -0,0 +1,239 @@
+/**
+ * LoRa Gateway Sniffer - Console Command Check
+ *
+ * Drives the firmware's serial command processor (src/command_processor.*)
+ * from a simulated serial port: byte-by-byte typing, half lines, bursts,
+ * CRLF, overlong lines, ';' batches, typed argument errors and random
+ * noise. Verifies that a poll never reads more than is buffered or more
+ * than its byte budget, that commands run exactly when their line ends,
+ * and reports the worst poll time.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o command_check command_check.cpp ../src/command_processor.cpp
+ *
+ * Usage:
+ *   command_check [--fuzz BYTES]
+ */
+
+#include "command_processor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+
+// Serial stand-in that only ever hands out bytes it already holds
+class SimulatedSerial {
+private:
+    std::string pending;
+    size_t position;
+
+public:
+    uint64_t reads;
+    uint64_t emptyReads;        // read() with nothing buffered would block or fail on hardware
+
+    SimulatedSerial() : position(0), reads(0), emptyReads(0) {}
+
+    void type(const char* text) { pending.append(text); }
+    void type(char c) { pending.push_back(c); }
+    int available() const { return (int)(pending.size() - position); }
+
+    int read() {
+        reads++;
+        if (position == pending.size()) {
+            emptyReads++;
+            return -1;
+        }
+        return (uint8_t)pending[position++];
+    }
+};
+
+static std::string calls;       // Handler trace: "name(args);"
+static std::string messages;    // Processor diagnostics
+
+static void trace(const char* name, const CommandArgs& args) {
+    calls += name;
+    calls += "(";
+    for (uint8_t i = 0; i < args.count; i++) {
+        char value[32];
+        switch (args.values[i].type) {
+            case 'u': snprintf(value, sizeof(value), "%u", (unsigned)args.values[i].u); break;
+            case 'i': snprintf(value, sizeof(value), "%d", (int)args.values[i].i); break;
+            case 'f': snprintf(value, sizeof(value), "%g", args.values[i].f); break;
+            case 'b': snprintf(value, sizeof(value), "%s", args.values[i].b ? "on" : "off"); break;
+            default: snprintf(value, sizeof(value), "%s", args.values[i].word); break;
+        }
+        if (i) calls += ",";
+        calls += value;
+    }
+    calls += ");";
+}
+
+static void handlePerf(const CommandArgs& args) { trace("perf", args); }
+static void handleInterval(const CommandArgs& args) { trace("interval", args); }
+static void handleTelemetry(const CommandArgs& args) { trace("telemetry", args); }
+static void handleOffset(const CommandArgs& args) { trace("offset", args); }
+static void handleName(const CommandArgs& args) { trace("name", args); }
+
+static void collectMessage(const char* message) {
+    messages += message;
+    messages += "\n";
+}
+
+static const CommandSpec TABLE[] = {
+    {"perf", "pf", "", "Latency table", handlePerf},
+    {"interval", "iv", "uf?", "Uplink interval in seconds, optional jitter", handleInterval},
+    {"telemetry", "tm", "b?", "Binary telemetry", handleTelemetry},
+    {"offset", nullptr, "i", "Signed offset", handleOffset},
+    {"name", "nm", "w", "Device label", handleName}
+};
+
+static int failures = 0;
+
+static void expect(bool condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "[Command] [FAIL] %s\n", what);
+        failures++;
+    }
+}
+
+// Polls until the simulated port is drained, timing every call
+struct PollStats {
+    uint64_t polls;
+    uint64_t worstBytes;
+    double worstNs;
+};
+
+static void drain(CommandProcessor& processor, SimulatedSerial& serial, PollStats& stats) {
+    while (serial.available() > 0) {
+        uint64_t before = serial.reads;
+        auto start = std::chrono::steady_clock::now();
+        processor.poll(serial);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        stats.polls++;
+        if (serial.reads - before > stats.worstBytes) stats.worstBytes = serial.reads - before;
+        if (ns > stats.worstNs) stats.worstNs = ns;
+    }
+    // An idle poll must return without reading
+    uint64_t before = serial.reads;
+    processor.poll(serial);
+    expect(serial.reads == before, "idle poll read from an empty port");
+}
+
+static void runLine(CommandProcessor& processor, SimulatedSerial& serial, PollStats& stats, const char* line,
+                    const char* expectedCalls, bool expectMessage) {
+    calls.clear();
+    messages.clear();
+    serial.type(line);
+    drain(processor, serial, stats);
+    if (calls != expectedCalls || messages.empty() == expectMessage) {
+        fprintf(stderr, "[Command] [FAIL] '%s': calls '%s' (expected '%s'), message '%s'\n", line, calls.c_str(),
+                expectedCalls, messages.c_str());
+        failures++;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t fuzzBytes = 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc) fuzzBytes = strtoull(argv[++i], nullptr, 10);
+    }
+
+    CommandProcessor processor;
+    expect(processor.begin(TABLE, sizeof(TABLE) / sizeof(TABLE[0]), collectMessage), "table rejected");
+    SimulatedSerial serial;
+    PollStats stats = {0, 0, 0.0};
+
+    // Typed one byte per loop pass: nothing runs until the newline
+    calls.clear();
+    const char* typed = "interval 30 0.5\n";
+    for (const char* c = typed; *c; c++) {
+        expect(calls.empty(), "command ran before its line ended");
+        serial.type(*c);
+        drain(processor, serial, stats);
+    }
+    expect(calls == "interval(30,0.5);", "byte-by-byte command did not run once");
+
+    // A half line sits in the assembler across many passes
+    calls.clear();
+    serial.type("pe");
+    for (int pass = 0; pass < 1000; pass++) drain(processor, serial, stats);
+    expect(calls.empty(), "half line ran");
+    serial.type("rf\r\n");
+    drain(processor, serial, stats);
+    expect(calls == "perf();", "CRLF line did not run exactly once");
+
+    // A burst is consumed COMMAND_BYTES_PER_POLL bytes at a time
+    std::string burst;
+    while (burst.size() < 10 * COMMAND_BYTES_PER_POLL) burst += "pf\n";
+    serial.type(burst.c_str());
+    uint64_t before = serial.reads;
+    processor.poll(serial);
+    expect(serial.reads - before == COMMAND_BYTES_PER_POLL, "poll exceeded its byte budget");
+    drain(processor, serial, stats);
+
+    runLine(processor, serial, stats, "PF ; tm on;iv 10 ;  name  north-42 \n", "perf();telemetry(on);interval(10);name(north-42);", false);
+    runLine(processor, serial, stats, "tm\n", "telemetry();", false);
+    runLine(processor, serial, stats, "offset -15\n", "offset(-15);", false);
+    runLine(processor, serial, stats, "iv 0x3c\n", "interval(60);", false);
+    runLine(processor, serial, stats, "bogus\n", "", true);
+    runLine(processor, serial, stats, "iv -5\n", "", true);
+    runLine(processor, serial, stats, "iv ten\n", "", true);
+    runLine(processor, serial, stats, "iv\n", "", true);
+    runLine(processor, serial, stats, "tm maybe\n", "", true);
+    runLine(processor, serial, stats, "pf extra\n", "", true);
+    runLine(processor, serial, stats, "iv 1 2 3\n", "", true);
+    runLine(processor, serial, stats, "bogus; pf\n", "perf();", true);
+    runLine(processor, serial, stats, ";;  ;\n", "", false);
+
+    std::string overlong(COMMAND_LINE_MAX + 40, 'x');
+    overlong += "\npf\n";
+    runLine(processor, serial, stats, overlong.c_str(), "perf();", true);
+
+    // Duplicate names must be refused outright
+    static const CommandSpec DUPLICATE[] = {
+        {"perf", "pf", "", "", handlePerf},
+        {"perf_reset", "pf", "", "", handlePerf}
+    };
+    CommandProcessor duplicate;
+    expect(!duplicate.begin(DUPLICATE, 2, collectMessage), "duplicate alias accepted");
+
+    // A name whose alias probes through the name's own slot is not a duplicate
+    // ("enable_discovery" and "reset_devnonce" share a slot, "ed" hashes to the next)
+    static const CommandSpec COLLIDING[] = {
+        {"reset_devnonce", "rd", "", "", handlePerf},
+        {"enable_discovery", "ed", "", "", handlePerf}
+    };
+    CommandProcessor colliding;
+    expect(colliding.begin(COLLIDING, 2, collectMessage), "alias colliding with its own name refused");
+
+    // Noise: random printable bytes, separators and line ends
+    std::mt19937_64 rng(5);
+    static const char ALPHABET[] = "pfivtmnaeoffs0123456789 -.;\t\r\nxyzPF";
+    calls.clear();
+    uint32_t executedBefore = processor.getExecuted();
+    for (uint64_t i = 0; i < fuzzBytes; i++) {
+        serial.type(ALPHABET[rng() % (sizeof(ALPHABET) - 1)]);
+        if (rng() % 16 == 0) {
+            drain(processor, serial, stats);
+            calls.clear();
+            messages.clear();
+        }
+    }
+    serial.type('\n');
+    drain(processor, serial, stats);
+
+    expect(serial.emptyReads == 0, "read() called with nothing buffered");
+    expect(stats.worstBytes <= COMMAND_BYTES_PER_POLL, "poll exceeded its byte budget");
+    fprintf(stderr, "[Command] %llu polls, at most %llu bytes and %.1f us per poll; noise ran %u commands, rejected %u\n",
+            (unsigned long long)stats.polls, (unsigned long long)stats.worstBytes, stats.worstNs / 1e3,
+            processor.getExecuted() - executedBefore, processor.getRejected());
+    if (failures) {
+        fprintf(stderr, "[Command] %d check(s) failed\n", failures);
+        return 1;
+    }
+    fprintf(stderr, "[Command] All checks passed\n");
+    return 0;
+}
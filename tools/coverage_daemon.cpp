@@ -0,0 +1,969 @@
+/**
+ * LoRa Gateway Sniffer - Coverage Ingestion Daemon
+ *
+ * Long-running host service that takes ChirpStack uplink events as they
+ * happen and keeps a live coverage map for a whole fleet of sniffers:
+ *
+ *   MQTT   minimal MQTT 3.1.1 endpoint (broker stand-in): accepts CONNECT and
+ *          PUBLISH QoS 0-2 on application/+/device/+/event/up, the topic
+ *          ChirpStack's MQTT integration publishes to
+ *   UDP    one JSON event per datagram
+ *   replay a JSONL or JSON array export, optionally paced to N events/s
+ *
+ * A single epoll thread owns every socket, timer and signal and hands raw
+ * messages to a worker pool in batches. Workers parse with the shared SAX
+ * event handler (chirpstack_events.h), decode port 3 with the firmware
+ * codec and add the samples to a sharded in-memory store of per-gateway
+ * Web Mercator cells plus per-device state. The store is snapshotted to
+ * disk periodically (write + rename) and reloaded on start.
+ *
+ * Every few seconds the daemon prints events/s and receive-to-stored
+ * latency percentiles; a summary follows on SIGINT/SIGTERM or --duration.
+ * uplink_loadgen.cpp drives it with synthetic fleets.
+ *
+ * Build:
+ *   g++ -O2 -mssse3 -std=c++17 -pthread -I../src -o coverage_daemon coverage_daemon.cpp ../src/payload_codec.cpp
+ *
+ * Usage:
+ *   coverage_daemon [--mqtt PORT] [--udp PORT] [--replay FILE [--replay-rate N]]
+ *                   [--workers N] [--shards N] [--zoom Z] [--snapshot PATH]
+ *                   [--snapshot-interval S] [--stats-interval S] [--duration S]
+ */
+
+#include "chirpstack_events.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define DAEMON_MAX_EVENTS           256
+#define DAEMON_UDP_BATCH            64
+#define DAEMON_UDP_MAX_DATAGRAM     16384
+#define DAEMON_READ_CHUNK           65536
+#define DAEMON_MQTT_MAX_PACKET      (1 << 20)
+#define DAEMON_QUEUE_LIMIT          200000      // Messages per worker before new ones are dropped
+#define DAEMON_REPLAY_TICK_MS       1
+#define DAEMON_REPLAY_UNPACED_BATCH 512
+
+#define SNAPSHOT_MAGIC              "LGCS"
+#define SNAPSHOT_VERSION            1
+
+static inline uint64_t monotonicNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+// ---- Latency histogram --------------------------------------------------
+
+// Log-linear buckets: 16 sub-buckets per power of two (~6 % resolution),
+// written by one worker, read concurrently by the stats reporter
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 4;
+    static const int BUCKETS = 64 << SUB_BITS;
+    std::atomic<uint64_t> counts[BUCKETS];
+
+public:
+    LatencyHistogram() {
+        for (int i = 0; i < BUCKETS; i++) counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t value) {
+        if (value < (1u << SUB_BITS)) return (int)value;
+        int exponent = 63 - __builtin_clzll(value);
+        return ((exponent - SUB_BITS + 1) << SUB_BITS) | (int)((value >> (exponent - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+    }
+
+    static uint64_t bucketValue(int bucket) {
+        if (bucket < (1 << SUB_BITS)) return (uint64_t)bucket;
+        int exponent = (bucket >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t low = (1ULL << exponent) | ((uint64_t)(bucket & ((1 << SUB_BITS) - 1)) << (exponent - SUB_BITS));
+        return low + (1ULL << (exponent - SUB_BITS)) / 2;
+    }
+
+    void record(uint64_t value) { counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed); }
+
+    void addTo(std::vector<uint64_t>& totals) const {
+        totals.resize(BUCKETS);
+        for (int i = 0; i < BUCKETS; i++) totals[i] += counts[i].load(std::memory_order_relaxed);
+    }
+
+    static uint64_t percentile(const std::vector<uint64_t>& totals, double fraction) {
+        uint64_t total = 0;
+        for (uint64_t count : totals) total += count;
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(fraction * total), seen = 0;
+        for (size_t i = 0; i < totals.size(); i++) {
+            seen += totals[i];
+            if (seen >= rank) return bucketValue((int)i);
+        }
+        return bucketValue((int)totals.size() - 1);
+    }
+};
+
+// ---- Coverage store -----------------------------------------------------
+
+struct CellKey {
+    uint64_t gatewayId;
+    uint64_t cell;      // x << 32 | y at the store zoom
+
+    bool operator==(const CellKey& other) const { return gatewayId == other.gatewayId && cell == other.cell; }
+};
+
+struct CellKeyHash {
+    size_t operator()(const CellKey& key) const { return (size_t)mix64(key.gatewayId ^ (key.cell * 0x9E3779B97F4A7C15ULL)); }
+};
+
+struct CellStats {
+    uint32_t count;
+    int16_t rssiMin;
+    int16_t rssiMax;
+    int64_t rssiSum;
+    int64_t snrDeciSum;
+    int64_t firstTimeMs;
+    int64_t lastTimeMs;
+};
+
+struct DeviceState {
+    uint64_t samples;
+    uint64_t positioned;
+    int64_t lastTimeMs;
+    uint32_t lastFrameCounter;
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+};
+
+class CoverageStore {
+private:
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<CellKey, CellStats, CellKeyHash> cells;
+        std::unordered_map<uint64_t, DeviceState> devices;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    unsigned zoom;
+
+    Shard& shardFor(uint64_t hash) { return *shards[hash % shards.size()]; }
+
+    uint64_t cellOf(int32_t latitudeE7, int32_t longitudeE7) const {
+        double latitude = std::max(-85.05112878, std::min(85.05112878, latitudeE7 / 1e7));
+        double n = (double)(1u << zoom);
+        double x = (longitudeE7 / 1e7 + 180.0) / 360.0 * n;
+        double sinLat = sin(latitude * M_PI / 180.0);
+        double y = (0.5 - log((1 + sinLat) / (1 - sinLat)) / (4 * M_PI)) * n;
+        uint64_t cx = (uint64_t)std::min(n - 1, std::max(0.0, x));
+        uint64_t cy = (uint64_t)std::min(n - 1, std::max(0.0, y));
+        return (cx << 32) | cy;
+    }
+
+public:
+    CoverageStore(unsigned shardCount, unsigned cellZoom) : zoom(cellZoom) {
+        for (unsigned i = 0; i < shardCount; i++) shards.emplace_back(new Shard());
+    }
+
+    unsigned getZoom() const { return zoom; }
+
+    // Two short critical sections, never nested
+    void add(const CoverageSample& sample) {
+        bool positioned = sample.flags & SAMPLE_FLAG_POSITION;
+        {
+            Shard& shard = shardFor(mix64(sample.deviceEui));
+            std::lock_guard<std::mutex> guard(shard.lock);
+            DeviceState& device = shard.devices[sample.deviceEui];
+            device.samples++;
+            if (sample.timeMs >= device.lastTimeMs) {
+                device.lastTimeMs = sample.timeMs;
+                device.lastFrameCounter = sample.frameCounter;
+                if (positioned) {
+                    device.latitudeE7 = sample.latitudeE7;
+                    device.longitudeE7 = sample.longitudeE7;
+                }
+            }
+            if (positioned) device.positioned++;
+        }
+        if (!positioned) return;
+
+        CellKey key = {sample.gatewayId, cellOf(sample.latitudeE7, sample.longitudeE7)};
+        Shard& shard = shardFor(CellKeyHash()(key) >> 8);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto inserted = shard.cells.emplace(key, CellStats());
+        CellStats& cell = inserted.first->second;
+        if (inserted.second) {
+            cell = CellStats{0, sample.rssi, sample.rssi, 0, 0, sample.timeMs, sample.timeMs};
+        }
+        cell.count++;
+        cell.rssiMin = std::min(cell.rssiMin, sample.rssi);
+        cell.rssiMax = std::max(cell.rssiMax, sample.rssi);
+        cell.rssiSum += sample.rssi;
+        cell.snrDeciSum += sample.snrDeci;
+        cell.firstTimeMs = std::min(cell.firstTimeMs, sample.timeMs);
+        cell.lastTimeMs = std::max(cell.lastTimeMs, sample.timeMs);
+    }
+
+    void counts(size_t& cells, size_t& devices) {
+        cells = devices = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard->lock);
+            cells += shard->cells.size();
+            devices += shard->devices.size();
+        }
+    }
+
+    // Copies one shard at a time under its lock, then writes outside any lock
+    bool writeSnapshot(const char* path, size_t& cellsWritten, size_t& devicesWritten) {
+        std::vector<std::pair<CellKey, CellStats>> cells;
+        std::vector<std::pair<uint64_t, DeviceState>> devices;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard->lock);
+            cells.insert(cells.end(), shard->cells.begin(), shard->cells.end());
+            devices.insert(devices.end(), shard->devices.begin(), shard->devices.end());
+        }
+
+        std::string temporary = std::string(path) + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (!file) return false;
+        uint8_t header[16] = {0};
+        memcpy(header, SNAPSHOT_MAGIC, 4);
+        header[4] = SNAPSHOT_VERSION;
+        header[5] = (uint8_t)zoom;
+        uint64_t cellCount = cells.size(), deviceCount = devices.size();
+        bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+                  fwrite(&cellCount, sizeof(cellCount), 1, file) == 1 &&
+                  fwrite(&deviceCount, sizeof(deviceCount), 1, file) == 1;
+        for (size_t i = 0; ok && i < cells.size(); i++) {
+            ok = fwrite(&cells[i].first, sizeof(CellKey), 1, file) == 1 &&
+                 fwrite(&cells[i].second, sizeof(CellStats), 1, file) == 1;
+        }
+        for (size_t i = 0; ok && i < devices.size(); i++) {
+            ok = fwrite(&devices[i].first, sizeof(uint64_t), 1, file) == 1 &&
+                 fwrite(&devices[i].second, sizeof(DeviceState), 1, file) == 1;
+        }
+        ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+        fclose(file);
+        if (!ok || rename(temporary.c_str(), path) != 0) {
+            remove(temporary.c_str());
+            return false;
+        }
+        cellsWritten = cells.size();
+        devicesWritten = devices.size();
+        return true;
+    }
+
+    bool loadSnapshot(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (!file) return false;
+        uint8_t header[16];
+        uint64_t cellCount = 0, deviceCount = 0;
+        bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                  memcmp(header, SNAPSHOT_MAGIC, 4) == 0 && header[4] == SNAPSHOT_VERSION && header[5] == zoom &&
+                  fread(&cellCount, sizeof(cellCount), 1, file) == 1 &&
+                  fread(&deviceCount, sizeof(deviceCount), 1, file) == 1;
+        for (uint64_t i = 0; ok && i < cellCount; i++) {
+            CellKey key;
+            CellStats stats;
+            ok = fread(&key, sizeof(key), 1, file) == 1 && fread(&stats, sizeof(stats), 1, file) == 1;
+            if (ok) shardFor(CellKeyHash()(key) >> 8).cells[key] = stats;
+        }
+        for (uint64_t i = 0; ok && i < deviceCount; i++) {
+            uint64_t eui;
+            DeviceState state;
+            ok = fread(&eui, sizeof(eui), 1, file) == 1 && fread(&state, sizeof(state), 1, file) == 1;
+            if (ok) shardFor(mix64(eui)).devices[eui] = state;
+        }
+        fclose(file);
+        if (!ok) {
+            fprintf(stderr, "[Daemon] [WARN] Snapshot %s unreadable or for another zoom, starting empty\n", path);
+            for (auto& shard : shards) {
+                shard->cells.clear();
+                shard->devices.clear();
+            }
+            return false;
+        }
+        fprintf(stderr, "[Daemon] Restored %llu cells and %llu devices from %s\n", (unsigned long long)cellCount,
+                (unsigned long long)deviceCount, path);
+        return true;
+    }
+};
+
+// ---- Worker pool --------------------------------------------------------
+
+struct Message {
+    std::string body;
+    uint64_t receivedNs;
+};
+
+struct WorkerSink {
+    CoverageStore& store;
+    void append(const CoverageSample& sample) { store.add(sample); }
+};
+
+class Worker {
+private:
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<Message> queue;
+    bool stopping;
+    std::thread thread;
+
+    CoverageStore& store;
+    WorkerSink sink;
+    IngestStats stats;
+    ChirpStackEventHandler<WorkerSink> handler;
+
+    void run() {
+        std::vector<Message> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [&]() { return stopping || !queue.empty(); });
+                if (queue.empty() && stopping) return;
+                batch.swap(queue);
+                queued.store(0, std::memory_order_relaxed);
+            }
+            for (Message& message : batch) {
+                const char* text = message.body.data();
+                JsonResult result = parseJson(text, text + message.body.size(), handler);
+                if (result.status != JSON_OK) {
+                    handler.reset();
+                    parseErrors.fetch_add(1, std::memory_order_relaxed);
+                }
+                latency.record(monotonicNs() - message.receivedNs);
+                processed.fetch_add(1, std::memory_order_relaxed);
+            }
+            batch.clear();
+        }
+    }
+
+public:
+    std::atomic<uint64_t> processed;
+    std::atomic<uint64_t> parseErrors;
+    std::atomic<size_t> queued;
+    LatencyHistogram latency;
+
+    explicit Worker(CoverageStore& coverageStore)
+        : stopping(false), store(coverageStore), sink{coverageStore}, handler(sink, stats), processed(0),
+          parseErrors(0), queued(0) {
+        thread = std::thread([this]() { run(); });
+    }
+
+    // Returns how many messages were dropped because the queue is full
+    size_t push(std::vector<Message>& messages) {
+        if (messages.empty()) return 0;
+        size_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (Message& message : messages) {
+                if (queue.size() >= DAEMON_QUEUE_LIMIT) {
+                    dropped++;
+                    continue;
+                }
+                queue.push_back(std::move(message));
+            }
+            queued.store(queue.size(), std::memory_order_relaxed);
+        }
+        messages.clear();
+        ready.notify_one();
+        return dropped;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_one();
+        thread.join();
+    }
+
+    const IngestStats& getStats() const { return stats; }
+};
+
+// ---- Event loop ---------------------------------------------------------
+
+enum SourceKind {
+    SOURCE_MQTT = 0,
+    SOURCE_UDP,
+    SOURCE_REPLAY,
+    SOURCE_COUNT
+};
+
+struct MqttConnection {
+    int fd;
+    std::vector<uint8_t> buffer;
+    bool connected;
+};
+
+struct DaemonConfig {
+    int mqttPort;
+    int udpPort;
+    const char* replayPath;
+    double replayRate;
+    unsigned workers;
+    unsigned shards;
+    unsigned zoom;
+    const char* snapshotPath;
+    unsigned snapshotInterval;
+    unsigned statsInterval;
+    unsigned duration;
+};
+
+class Daemon {
+private:
+    DaemonConfig config;
+    CoverageStore store;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::vector<Message>> outgoing;     // Per-worker batch for this loop iteration
+    unsigned nextWorker;
+
+    int epollFd, signalFd, statsTimerFd, snapshotTimerFd, replayTimerFd, durationTimerFd;
+    int mqttListenFd, udpFd;
+    std::unordered_map<int, MqttConnection> mqttConnections;
+    bool running;
+
+    // Replay input
+    const char* replayData;
+    size_t replaySize;
+    size_t replayOffset;
+    double replayCredit;
+
+    // Snapshot runs off the loop thread; one at a time
+    std::thread snapshotThread;
+    std::atomic<bool> snapshotBusy;
+
+    // Counters (loop thread only)
+    uint64_t received[SOURCE_COUNT];
+    uint64_t dropped;
+    uint64_t ignoredTopics;
+    uint64_t lastProcessed;
+    uint64_t lastStatsNs;
+    uint64_t firstReceiveNs;
+    uint64_t lastReceiveNs;
+    std::vector<uint64_t> lastHistogram;
+
+    void dispatch(std::string&& body, SourceKind source, uint64_t receivedNs) {
+        if (!firstReceiveNs) firstReceiveNs = receivedNs;
+        lastReceiveNs = receivedNs;
+        received[source]++;
+        outgoing[nextWorker].push_back(Message{std::move(body), receivedNs});
+        nextWorker = (nextWorker + 1) % workers.size();
+    }
+
+    void flushOutgoing() {
+        for (size_t i = 0; i < workers.size(); i++) dropped += workers[i]->push(outgoing[i]);
+    }
+
+    bool addToEpoll(int fd, uint32_t events) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.fd = fd;
+        return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+
+    static int makeTimer(unsigned intervalMs) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct itimerspec spec;
+        spec.it_interval.tv_sec = intervalMs / 1000;
+        spec.it_interval.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+        spec.it_value = spec.it_interval;
+        timerfd_settime(fd, 0, &spec, nullptr);
+        return fd;
+    }
+
+    static uint64_t drainTimer(int fd) {
+        uint64_t expirations = 0;
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return 0;
+        return expirations;
+    }
+
+    int listenSocket(int type, int port) {
+        int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (type == SOCK_DGRAM) {
+            int size = 8 << 20;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        }
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons((uint16_t)port);
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+            (type == SOCK_STREAM && listen(fd, 128) != 0)) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // ---- UDP ----
+
+    void readUdp() {
+        static char buffers[DAEMON_UDP_BATCH][DAEMON_UDP_MAX_DATAGRAM];
+        struct mmsghdr messages[DAEMON_UDP_BATCH];
+        struct iovec vectors[DAEMON_UDP_BATCH];
+        while (true) {
+            for (int i = 0; i < DAEMON_UDP_BATCH; i++) {
+                vectors[i].iov_base = buffers[i];
+                vectors[i].iov_len = DAEMON_UDP_MAX_DATAGRAM;
+                memset(&messages[i].msg_hdr, 0, sizeof(messages[i].msg_hdr));
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int count = recvmmsg(udpFd, messages, DAEMON_UDP_BATCH, MSG_DONTWAIT, nullptr);
+            if (count <= 0) return;
+            uint64_t now = monotonicNs();
+            for (int i = 0; i < count; i++) {
+                if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    dropped++;
+                    continue;
+                }
+                dispatch(std::string(buffers[i], messages[i].msg_len), SOURCE_UDP, now);
+            }
+        }
+    }
+
+    // ---- MQTT (publish side of a broker only) ----
+
+    static void sendAll(int fd, const uint8_t* data, size_t length) {
+        // Control replies are a few bytes; a full socket buffer means a stalled client
+        if (send(fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)length) shutdown(fd, SHUT_RDWR);
+    }
+
+    void acceptMqtt() {
+        while (true) {
+            int fd = accept4(mqttListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            mqttConnections[fd] = MqttConnection{fd, std::vector<uint8_t>(), false};
+            addToEpoll(fd, EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    void closeMqtt(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        mqttConnections.erase(fd);
+    }
+
+    static bool isUplinkTopic(const uint8_t* topic, size_t length) {
+        static const char suffix[] = "/event/up";
+        size_t suffixLength = sizeof(suffix) - 1;
+        return length >= suffixLength && memcmp(topic + length - suffixLength, suffix, suffixLength) == 0;
+    }
+
+    // Returns false if the connection must be closed
+    bool handleMqttPacket(MqttConnection& connection, uint8_t type, uint8_t flags, const uint8_t* body,
+                          size_t length, uint64_t now) {
+        switch (type) {
+            case 1: {   // CONNECT -> CONNACK accepted
+                static const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                sendAll(connection.fd, connack, sizeof(connack));
+                connection.connected = true;
+                return true;
+            }
+            case 3: {   // PUBLISH
+                if (!connection.connected || length < 2) return false;
+                size_t topicLength = ((size_t)body[0] << 8) | body[1];
+                uint8_t qos = (flags >> 1) & 0x03;
+                size_t offset = 2 + topicLength + (qos ? 2 : 0);
+                if (offset > length || qos == 3) return false;
+                if (qos) {
+                    uint8_t reply[] = {(uint8_t)(qos == 1 ? 0x40 : 0x50), 0x02, body[2 + topicLength],
+                                       body[3 + topicLength]};
+                    sendAll(connection.fd, reply, sizeof(reply));
+                }
+                if (!isUplinkTopic(body + 2, topicLength)) {
+                    ignoredTopics++;
+                    return true;
+                }
+                dispatch(std::string((const char*)body + offset, length - offset), SOURCE_MQTT, now);
+                return true;
+            }
+            case 6: {   // PUBREL -> PUBCOMP
+                if (length < 2) return false;
+                uint8_t reply[] = {0x70, 0x02, body[0], body[1]};
+                sendAll(connection.fd, reply, sizeof(reply));
+                return true;
+            }
+            case 8: {   // SUBSCRIBE: nothing is ever delivered, so refuse every filter
+                if (length < 2) return false;
+                std::vector<uint8_t> reply = {0x90, 0x00, body[0], body[1]};
+                for (size_t offset = 2; offset + 2 <= length;) {
+                    offset += 2 + (((size_t)body[offset] << 8) | body[offset + 1]) + 1;
+                    reply.push_back(0x80);
+                }
+                reply[1] = (uint8_t)(reply.size() - 2);
+                sendAll(connection.fd, reply.data(), reply.size());
+                return true;
+            }
+            case 12: {  // PINGREQ -> PINGRESP
+                static const uint8_t pong[] = {0xD0, 0x00};
+                sendAll(connection.fd, pong, sizeof(pong));
+                return true;
+            }
+            case 14:    // DISCONNECT
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    void readMqtt(int fd) {
+        auto found = mqttConnections.find(fd);
+        if (found == mqttConnections.end()) return;
+        MqttConnection& connection = found->second;
+        uint8_t chunk[DAEMON_READ_CHUNK];
+        bool open = true;
+        while (true) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (got > 0) {
+                connection.buffer.insert(connection.buffer.end(), chunk, chunk + got);
+                continue;
+            }
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) open = false;
+            break;
+        }
+
+        // Frame complete packets: type/flags byte, remaining length varint, body
+        uint64_t now = monotonicNs();
+        std::vector<uint8_t>& buffer = connection.buffer;
+        size_t offset = 0;
+        while (open && offset + 2 <= buffer.size()) {
+            size_t remaining = 0, header = 1;
+            int shift = 0;
+            bool complete = false;
+            while (offset + header < buffer.size() && header <= 4) {
+                uint8_t byte = buffer[offset + header++];
+                remaining |= (size_t)(byte & 0x7F) << shift;
+                shift += 7;
+                if (!(byte & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete) {
+                if (header > 4) open = false;
+                break;
+            }
+            if (remaining > DAEMON_MQTT_MAX_PACKET) {
+                open = false;
+                break;
+            }
+            if (offset + header + remaining > buffer.size()) break;
+            uint8_t first = buffer[offset];
+            open = handleMqttPacket(connection, first >> 4, first & 0x0F, buffer.data() + offset + header, remaining, now);
+            offset += header + remaining;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + offset);
+        if (!open) closeMqtt(fd);
+    }
+
+    // ---- Replay ----
+
+    // Next top-level JSON object in a JSONL file or inside a JSON array
+    bool nextReplayEvent(std::string& event) {
+        while (replayOffset < replaySize) {
+            char c = replayData[replayOffset];
+            if (c != '{') {
+                replayOffset++;
+                continue;
+            }
+            size_t start = replayOffset;
+            int depth = 0;
+            bool inString = false;
+            for (; replayOffset < replaySize; replayOffset++) {
+                c = replayData[replayOffset];
+                if (inString) {
+                    if (c == '\\') replayOffset++;
+                    else if (c == '"') inString = false;
+                } else if (c == '"') {
+                    inString = true;
+                } else if (c == '{') {
+                    depth++;
+                } else if (c == '}' && --depth == 0) {
+                    replayOffset++;
+                    event.assign(replayData + start, replayOffset - start);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool replayActive() const { return replayData && replayOffset < replaySize; }
+
+    void replayBatch(size_t limit) {
+        std::string event;
+        uint64_t now = monotonicNs();
+        for (size_t i = 0; i < limit && nextReplayEvent(event); i++) {
+            dispatch(std::move(event), SOURCE_REPLAY, now);
+            event = std::string();
+        }
+        if (!replayActive()) fprintf(stderr, "[Daemon] Replay of %s finished\n", config.replayPath);
+    }
+
+    bool openReplay() {
+        int fd = open(config.replayPath, O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        replaySize = (size_t)info.st_size;
+        void* mapped = replaySize ? mmap(nullptr, replaySize, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+        madvise(mapped, replaySize, MADV_SEQUENTIAL);
+        replayData = (const char*)mapped;
+        replayOffset = 0;
+        if (config.replayRate > 0) {
+            replayTimerFd = makeTimer(DAEMON_REPLAY_TICK_MS);
+            addToEpoll(replayTimerFd, EPOLLIN);
+        }
+        return true;
+    }
+
+    // ---- Snapshot and stats ----
+
+    void startSnapshot() {
+        if (snapshotBusy.exchange(true)) return;
+        if (snapshotThread.joinable()) snapshotThread.join();
+        snapshotThread = std::thread([this]() {
+            auto start = std::chrono::steady_clock::now();
+            size_t cells = 0, devices = 0;
+            bool ok = store.writeSnapshot(config.snapshotPath, cells, devices);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (ok) {
+                fprintf(stderr, "[Daemon] Snapshot: %zu cells, %zu devices -> %s in %.1f ms\n", cells, devices,
+                        config.snapshotPath, ms);
+            } else {
+                fprintf(stderr, "[Daemon] [ERROR] Snapshot to %s failed: %s\n", config.snapshotPath, strerror(errno));
+            }
+            snapshotBusy = false;
+        });
+    }
+
+    uint64_t totalProcessed() const {
+        uint64_t total = 0;
+        for (const auto& worker : workers) total += worker->processed.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void printStats() {
+        uint64_t now = monotonicNs();
+        uint64_t processed = totalProcessed();
+        std::vector<uint64_t> histogram;
+        for (const auto& worker : workers) worker->latency.addTo(histogram);
+        std::vector<uint64_t> interval(histogram);
+        for (size_t i = 0; i < lastHistogram.size(); i++) interval[i] -= lastHistogram[i];
+
+        size_t queued = 0;
+        for (const auto& worker : workers) queued += worker->queued.load(std::memory_order_relaxed);
+        size_t cells, devices;
+        store.counts(cells, devices);
+        double seconds = (now - lastStatsNs) / 1e9;
+        fprintf(stderr, "[Daemon] %.0f events/s (mqtt %llu, udp %llu, replay %llu total), latency p50 %.3f ms "
+                        "p99 %.3f ms, queued %zu, dropped %llu, cells %zu, devices %zu\n",
+                (processed - lastProcessed) / seconds, (unsigned long long)received[SOURCE_MQTT],
+                (unsigned long long)received[SOURCE_UDP], (unsigned long long)received[SOURCE_REPLAY],
+                LatencyHistogram::percentile(interval, 0.50) / 1e6, LatencyHistogram::percentile(interval, 0.99) / 1e6,
+                queued, (unsigned long long)dropped, cells, devices);
+        lastProcessed = processed;
+        lastStatsNs = now;
+        lastHistogram.swap(histogram);
+    }
+
+    void printSummary() {
+        // Rate over the span that actually had traffic, not idle time around it
+        double seconds = std::max(1e-3, (lastReceiveNs - firstReceiveNs) / 1e9);
+        uint64_t processed = totalProcessed(), parseErrors = 0, samples = 0, decoded = 0;
+        std::vector<uint64_t> histogram;
+        for (const auto& worker : workers) {
+            worker->latency.addTo(histogram);
+            parseErrors += worker->parseErrors.load();
+            samples += worker->getStats().samples;
+            decoded += worker->getStats().decoded;
+        }
+        fprintf(stderr, "[Daemon] Summary: %llu events over %.1f s of traffic (%.0f events/s sustained), %llu decoded, "
+                        "%llu samples, %llu parse errors, %llu dropped, %llu ignored topics\n",
+                (unsigned long long)processed, seconds, processed / seconds, (unsigned long long)decoded,
+                (unsigned long long)samples, (unsigned long long)parseErrors, (unsigned long long)dropped,
+                (unsigned long long)ignoredTopics);
+        fprintf(stderr, "[Daemon] Ingest latency: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, p99.9 %.3f ms\n",
+                LatencyHistogram::percentile(histogram, 0.50) / 1e6, LatencyHistogram::percentile(histogram, 0.90) / 1e6,
+                LatencyHistogram::percentile(histogram, 0.99) / 1e6, LatencyHistogram::percentile(histogram, 0.999) / 1e6);
+    }
+
+public:
+    explicit Daemon(const DaemonConfig& daemonConfig)
+        : config(daemonConfig), store(daemonConfig.shards, daemonConfig.zoom), nextWorker(0), epollFd(-1),
+          signalFd(-1), statsTimerFd(-1), snapshotTimerFd(-1), replayTimerFd(-1), durationTimerFd(-1),
+          mqttListenFd(-1), udpFd(-1), running(false), replayData(nullptr), replaySize(0), replayOffset(0),
+          replayCredit(0), snapshotBusy(false), dropped(0), ignoredTopics(0), lastProcessed(0),
+          lastStatsNs(0), firstReceiveNs(0), lastReceiveNs(0) {
+        memset(received, 0, sizeof(received));
+    }
+
+    bool start() {
+        store.loadSnapshot(config.snapshotPath);
+        for (unsigned i = 0; i < config.workers; i++) workers.emplace_back(new Worker(store));
+        outgoing.resize(workers.size());
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        addToEpoll(signalFd, EPOLLIN);
+
+        statsTimerFd = makeTimer(config.statsInterval * 1000);
+        addToEpoll(statsTimerFd, EPOLLIN);
+        snapshotTimerFd = makeTimer(config.snapshotInterval * 1000);
+        addToEpoll(snapshotTimerFd, EPOLLIN);
+        if (config.duration) {
+            durationTimerFd = makeTimer(config.duration * 1000);
+            addToEpoll(durationTimerFd, EPOLLIN);
+        }
+
+        if (config.mqttPort) {
+            mqttListenFd = listenSocket(SOCK_STREAM, config.mqttPort);
+            if (mqttListenFd < 0 || !addToEpoll(mqttListenFd, EPOLLIN)) {
+                fprintf(stderr, "[Daemon] [ERROR] Cannot listen for MQTT on port %d\n", config.mqttPort);
+                return false;
+            }
+            fprintf(stderr, "[Daemon] MQTT endpoint on port %d (topic */event/up)\n", config.mqttPort);
+        }
+        if (config.udpPort) {
+            udpFd = listenSocket(SOCK_DGRAM, config.udpPort);
+            if (udpFd < 0 || !addToEpoll(udpFd, EPOLLIN)) {
+                fprintf(stderr, "[Daemon] [ERROR] Cannot bind UDP port %d\n", config.udpPort);
+                return false;
+            }
+            fprintf(stderr, "[Daemon] UDP endpoint on port %d\n", config.udpPort);
+        }
+        if (config.replayPath && !openReplay()) {
+            fprintf(stderr, "[Daemon] [ERROR] Cannot open replay file %s\n", config.replayPath);
+            return false;
+        }
+        fprintf(stderr, "[Daemon] %u workers, %u store shards, cells at zoom %u\n", config.workers, config.shards,
+                config.zoom);
+        return true;
+    }
+
+    void run() {
+        running = true;
+        lastStatsNs = monotonicNs();
+        struct epoll_event events[DAEMON_MAX_EVENTS];
+        while (running) {
+            // Unpaced replay shares the loop with the sockets instead of blocking it
+            bool unpacedReplay = replayActive() && config.replayRate <= 0;
+            int count = epoll_wait(epollFd, events, DAEMON_MAX_EVENTS, unpacedReplay ? 0 : -1);
+            if (count < 0 && errno != EINTR) break;
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == udpFd) {
+                    readUdp();
+                } else if (fd == mqttListenFd) {
+                    acceptMqtt();
+                } else if (fd == statsTimerFd) {
+                    drainTimer(fd);
+                    printStats();
+                } else if (fd == snapshotTimerFd) {
+                    drainTimer(fd);
+                    startSnapshot();
+                } else if (fd == replayTimerFd) {
+                    replayCredit += drainTimer(fd) * config.replayRate * DAEMON_REPLAY_TICK_MS / 1000.0;
+                    size_t due = (size_t)replayCredit;
+                    replayCredit -= due;
+                    if (replayActive()) replayBatch(due);
+                } else if (fd == signalFd || fd == durationTimerFd) {
+                    running = false;
+                } else {
+                    readMqtt(fd);
+                }
+            }
+            if (unpacedReplay) replayBatch(DAEMON_REPLAY_UNPACED_BATCH);
+            flushOutgoing();
+        }
+
+        fprintf(stderr, "[Daemon] Shutting down, draining workers...\n");
+        for (auto& worker : workers) worker->stop();
+        while (snapshotBusy) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (snapshotThread.joinable()) snapshotThread.join();
+        startSnapshot();
+        snapshotThread.join();
+        printSummary();
+    }
+};
+
+int main(int argc, char** argv) {
+    DaemonConfig config = {0, 0, nullptr, 0, std::max(1u, std::thread::hardware_concurrency()), 64, 17,
+                           "coverage.snap", 30, 5, 0};
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--mqtt") == 0 && hasValue) config.mqttPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--udp") == 0 && hasValue) config.udpPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && hasValue) config.replayPath = argv[++i];
+        else if (strcmp(argv[i], "--replay-rate") == 0 && hasValue) config.replayRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0 && hasValue) config.workers = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--shards") == 0 && hasValue) config.shards = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--zoom") == 0 && hasValue) config.zoom = std::min(24, std::max(1, atoi(argv[++i])));
+        else if (strcmp(argv[i], "--snapshot") == 0 && hasValue) config.snapshotPath = argv[++i];
+        else if (strcmp(argv[i], "--snapshot-interval") == 0 && hasValue) config.snapshotInterval = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--stats-interval") == 0 && hasValue) config.statsInterval = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--duration") == 0 && hasValue) config.duration = std::max(0, atoi(argv[++i]));
+        else {
+            fprintf(stderr, "Usage: %s [--mqtt PORT] [--udp PORT] [--replay FILE [--replay-rate N]] [--workers N]\n"
+                            "          [--shards N] [--zoom Z] [--snapshot PATH] [--snapshot-interval S]\n"
+                            "          [--stats-interval S] [--duration S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!config.mqttPort && !config.udpPort && !config.replayPath) {
+        fprintf(stderr, "[Daemon] [ERROR] Nothing to ingest: give --mqtt, --udp and/or --replay\n");
+        return 1;
+    }
+
+    Daemon daemon(config);
+    if (!daemon.start()) return 1;
+    daemon.run();
+    return 0;
+}
@@ -0,0 +1,543 @@
+/**
+ * LoRa Gateway Sniffer - Coverage Raster / Tile Builder
+ *
+ * Bins coverage samples (from chirpstack_ingest) into Web Mercator raster
+ * grids at several zoom levels, one layer per gateway plus a combined
+ * layer. Sample blocks are handed out to worker threads, each of which
+ * fills its own cell table; the tables are merged in parallel by hash
+ * shard at the end, so no locks are taken on the hot path.
+ *
+ * Output:
+ *   <out>/<layer>/<z>/<x>/<y>.png   RGBA heat map of mean RSSI (or sparse .bin with --format bin)
+ *   <out>/cells.geojson              Cell summaries at --geojson-zoom
+ * where <layer> is "all" or the 16 hex digit gateway id.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -pthread -I../src -o coverage_tiles coverage_tiles.cpp ../src/sample_archive.cpp -lz
+ *
+ * Usage:
+ *   coverage_tiles [options] samples.lgss
+ *     -o DIR             output directory (default tiles)
+ *     --zoom MIN-MAX     zoom levels (default 10-16)
+ *     --cells N          cells per tile edge, power of two (default 256)
+ *     --threads N        worker threads (default: all cores)
+ *     --format png|bin   tile format (default png)
+ *     --geojson-zoom Z   zoom for GeoJSON cell summaries (default MIN)
+ *     --bench            time binning for 1..N threads, write nothing
+ */
+
+#include "sample_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TILES_MAX_ZOOM      22
+#define TILES_ALL_GATEWAYS  0       // Layer id of the combined raster
+
+struct CellKey {
+    uint64_t gateway;
+    uint64_t cell;      // zoom (6 bits) | x (29 bits) | y (29 bits), in cells at that zoom
+
+    bool operator==(const CellKey& other) const { return gateway == other.gateway && cell == other.cell; }
+};
+
+struct CellStats {
+    uint32_t count;
+    int16_t rssiMax;
+    int16_t rssiMin;
+    int64_t rssiSum;
+    int64_t snrSumDeci;
+    uint8_t gatewaysMax;
+
+    void add(int16_t rssi, int16_t snrDeci, uint8_t gateways) {
+        if (count == 0 || rssi > rssiMax) rssiMax = rssi;
+        if (count == 0 || rssi < rssiMin) rssiMin = rssi;
+        if (gateways > gatewaysMax) gatewaysMax = gateways;
+        rssiSum += rssi;
+        snrSumDeci += snrDeci;
+        count++;
+    }
+
+    void merge(const CellStats& other) {
+        if (other.count == 0) return;
+        if (count == 0 || other.rssiMax > rssiMax) rssiMax = other.rssiMax;
+        if (count == 0 || other.rssiMin < rssiMin) rssiMin = other.rssiMin;
+        if (other.gatewaysMax > gatewaysMax) gatewaysMax = other.gatewaysMax;
+        rssiSum += other.rssiSum;
+        snrSumDeci += other.snrSumDeci;
+        count += other.count;
+    }
+
+    double rssiMean() const { return count ? (double)rssiSum / count : 0.0; }
+    double snrMean() const { return count ? snrSumDeci / 10.0 / count : 0.0; }
+};
+
+static inline uint64_t packCell(uint32_t zoom, uint32_t x, uint32_t y) {
+    return ((uint64_t)zoom << 58) | ((uint64_t)x << 29) | y;
+}
+
+static inline uint32_t cellZoom(uint64_t cell) { return (uint32_t)(cell >> 58); }
+static inline uint32_t cellX(uint64_t cell) { return (uint32_t)((cell >> 29) & 0x1FFFFFFF); }
+static inline uint32_t cellY(uint64_t cell) { return (uint32_t)(cell & 0x1FFFFFFF); }
+
+static inline uint64_t hashKey(const CellKey& key) {
+    uint64_t h = key.gateway * 0x9E3779B97F4A7C15ULL ^ key.cell;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Open-addressing cell accumulator; one per thread, never shared while filling
+class CellTable {
+private:
+    std::vector<CellKey> keys;
+    std::vector<CellStats> values;
+    std::vector<uint8_t> used;
+    size_t mask;
+    size_t count;
+
+    void grow() {
+        CellTable bigger(keys.size() * 2);
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (used[i]) bigger.slot(keys[i]).merge(values[i]);
+        }
+        *this = std::move(bigger);
+    }
+
+public:
+    explicit CellTable(size_t capacity = 1 << 16) : mask(0), count(0) {
+        size_t size = 16;
+        while (size < capacity) size <<= 1;
+        keys.resize(size);
+        values.resize(size);
+        used.assign(size, 0);
+        mask = size - 1;
+    }
+
+    CellStats& slot(const CellKey& key) {
+        if ((count + 1) * 10 > keys.size() * 7) grow();
+        size_t i = hashKey(key) & mask;
+        while (used[i]) {
+            if (keys[i] == key) return values[i];
+            i = (i + 1) & mask;
+        }
+        used[i] = 1;
+        keys[i] = key;
+        values[i] = CellStats();
+        count++;
+        return values[i];
+    }
+
+    size_t size() const { return count; }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (used[i]) visit(keys[i], values[i]);
+        }
+    }
+};
+
+struct BinningConfig {
+    uint32_t minZoom;
+    uint32_t maxZoom;
+    uint32_t cellsPerTile;
+    uint32_t cellShift;     // log2(cellsPerTile)
+};
+
+// Normalised Web Mercator position in [0, 1)
+static inline bool mercator(int32_t latitudeE7, int32_t longitudeE7, double& x, double& y) {
+    double latitude = latitudeE7 / 1e7;
+    double longitude = longitudeE7 / 1e7;
+    if (latitude > 85.05112878 || latitude < -85.05112878) return false;
+    double sinLat = sin(latitude * M_PI / 180.0);
+    x = (longitude + 180.0) / 360.0;
+    y = 0.5 - log((1 + sinLat) / (1 - sinLat)) / (4 * M_PI);
+    return x >= 0 && x < 1 && y >= 0 && y < 1;
+}
+
+static void binBlock(const SampleBlockView& block, const BinningConfig& config, CellTable& table) {
+    double worldCells = ldexp(1.0, config.maxZoom + config.cellShift);
+    for (uint32_t i = 0; i < block.rows; i++) {
+        if (!(block.flags[i] & SAMPLE_FLAG_POSITION)) continue;
+        double x, y;
+        if (!mercator(block.latitudeE7[i], block.longitudeE7[i], x, y)) continue;
+        uint32_t px = (uint32_t)(x * worldCells);
+        uint32_t py = (uint32_t)(y * worldCells);
+        for (uint32_t zoom = config.minZoom; zoom <= config.maxZoom; zoom++) {
+            uint32_t shift = config.maxZoom - zoom;
+            uint64_t cell = packCell(zoom, px >> shift, py >> shift);
+            table.slot(CellKey{block.gatewayId[i], cell}).add(block.rssi[i], block.snrDeci[i], block.gatewayCount[i]);
+            table.slot(CellKey{TILES_ALL_GATEWAYS, cell}).add(block.rssi[i], block.snrDeci[i], block.gatewayCount[i]);
+        }
+    }
+}
+
+// Fill per-thread tables from blocks claimed off a shared counter, then
+// merge by hash shard so each merge thread owns a disjoint key range
+static std::vector<CellTable> buildRasters(const SampleFileReader& reader, const std::vector<size_t>& blocks,
+                                           const BinningConfig& config, unsigned threads, uint64_t& samples) {
+    std::vector<CellTable> local(threads);
+    std::vector<uint64_t> rows(threads, 0);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            SampleBlockBuffer buffer;
+            SampleBlockView view;
+            size_t index;
+            while ((index = next.fetch_add(1)) < blocks.size()) {
+                if (!reader.decodeBlock(blocks[index], buffer, view)) continue;
+                binBlock(view, config, local[t]);
+                rows[t] += view.rows;
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+
+    samples = 0;
+    for (uint64_t count : rows) samples += count;
+    if (threads == 1) return local;
+
+    std::vector<CellTable> shards(threads);
+    for (unsigned s = 0; s < threads; s++) {
+        workers.emplace_back([&, s]() {
+            for (const CellTable& table : local) {
+                table.forEach([&](const CellKey& key, const CellStats& stats) {
+                    if ((hashKey(key) >> 32) % threads == s) shards[s].slot(key).merge(stats);
+                });
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return shards;
+}
+
+static bool makeDirectories(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            std::string prefix = path.substr(0, i);
+            if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+    }
+    return true;
+}
+
+// Minimal PNG encoder: RGBA8, one zlib-compressed IDAT chunk
+static void putBE32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void pngChunk(FILE* file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    putBE32(chunk, (uint32_t)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    uint32_t crc = (uint32_t)crc32(0, chunk.data() + 4, (uInt)(chunk.size() - 4));
+    putBE32(chunk, crc);
+    fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+static bool writePng(const std::string& path, uint32_t size, const std::vector<uint8_t>& rgba) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+
+    std::vector<uint8_t> header;
+    putBE32(header, size);
+    putBE32(header, size);
+    header.push_back(8);    // Bit depth
+    header.push_back(6);    // RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    pngChunk(file, "IHDR", header);
+
+    std::vector<uint8_t> raw;
+    raw.reserve((size * 4 + 1) * size);
+    for (uint32_t y = 0; y < size; y++) {
+        raw.push_back(0);   // Filter: none
+        raw.insert(raw.end(), rgba.begin() + (size_t)y * size * 4, rgba.begin() + (size_t)(y + 1) * size * 4);
+    }
+
+    uLongf compressedSize = compressBound(raw.size());
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK) {
+        fclose(file);
+        return false;
+    }
+    compressed.resize(compressedSize);
+    pngChunk(file, "IDAT", compressed);
+    pngChunk(file, "IEND", std::vector<uint8_t>());
+    fclose(file);
+    return true;
+}
+
+// Mean RSSI -130 dBm (red) .. -60 dBm (green)
+static void rssiColor(double rssi, uint8_t* rgba) {
+    double t = (rssi + 130.0) / 70.0;
+    t = std::max(0.0, std::min(1.0, t));
+    rgba[0] = (uint8_t)(255 * std::min(1.0, 2 * (1 - t)));
+    rgba[1] = (uint8_t)(255 * std::min(1.0, 2 * t));
+    rgba[2] = 0;
+    rgba[3] = 200;
+}
+
+struct CellEntry {
+    CellKey key;
+    CellStats stats;
+};
+
+static std::string layerName(uint64_t gateway) {
+    if (gateway == TILES_ALL_GATEWAYS) return "all";
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)gateway);
+    return name;
+}
+
+// Sparse binary tile: cells u16 | entries u32 | entries * {x u16, y u16, count u32,
+// rssi mean*10 i16, rssi max i16, snr mean*10 i16, gateways u8, reserved u8}
+static bool writeBinaryTile(const std::string& path, uint32_t cells, const std::vector<CellEntry>& entries,
+                            size_t begin, size_t end) {
+    struct __attribute__((packed)) TileHeader {
+        uint16_t cells;
+        uint32_t entries;
+    };
+    struct TileCell {
+        uint16_t x;
+        uint16_t y;
+        uint32_t count;
+        int16_t rssiMeanDeci;
+        int16_t rssiMax;
+        int16_t snrMeanDeci;
+        uint8_t gateways;
+        uint8_t reserved;
+    };
+    TileHeader header = {(uint16_t)cells, (uint32_t)(end - begin)};
+    std::vector<TileCell> records;
+    records.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        const CellEntry& entry = entries[i];
+        TileCell cell;
+        cell.x = (uint16_t)(cellX(entry.key.cell) & (cells - 1));
+        cell.y = (uint16_t)(cellY(entry.key.cell) & (cells - 1));
+        cell.count = entry.stats.count;
+        cell.rssiMeanDeci = (int16_t)lround(entry.stats.rssiMean() * 10);
+        cell.rssiMax = entry.stats.rssiMax;
+        cell.snrMeanDeci = (int16_t)lround(entry.stats.snrMean() * 10);
+        cell.gateways = entry.stats.gatewaysMax;
+        cell.reserved = 0;
+        records.push_back(cell);
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(records.data(), sizeof(TileCell), records.size(), file);
+    fclose(file);
+    return true;
+}
+
+static bool writeTile(const std::vector<CellEntry>& entries, size_t begin, size_t end,
+                      const BinningConfig& config, const std::string& outputDir, bool png) {
+    const CellKey& first = entries[begin].key;
+    uint32_t cells = config.cellsPerTile;
+    char relative[96];
+    snprintf(relative, sizeof(relative), "/%s/%u/%u", layerName(first.gateway).c_str(), cellZoom(first.cell),
+             cellX(first.cell) >> config.cellShift);
+    std::string directory = outputDir + relative;
+    makeDirectories(directory);
+    std::string path = directory + "/" + std::to_string(cellY(first.cell) >> config.cellShift) + (png ? ".png" : ".bin");
+
+    if (!png) return writeBinaryTile(path, cells, entries, begin, end);
+
+    std::vector<uint8_t> rgba((size_t)cells * cells * 4, 0);
+    for (size_t i = begin; i < end; i++) {
+        uint32_t x = cellX(entries[i].key.cell) & (cells - 1);
+        uint32_t y = cellY(entries[i].key.cell) & (cells - 1);
+        rssiColor(entries[i].stats.rssiMean(), &rgba[((size_t)y * cells + x) * 4]);
+    }
+    return writePng(path, cells, rgba);
+}
+
+// Entries are sorted by tile; encode and write tiles on all worker threads
+static size_t writeTiles(const std::vector<CellEntry>& entries, const BinningConfig& config,
+                         const std::string& outputDir, bool png, unsigned threads) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+    while (begin < entries.size()) {
+        const CellKey& first = entries[begin].key;
+        size_t end = begin;
+        while (end < entries.size() && entries[end].key.gateway == first.gateway &&
+               cellZoom(entries[end].key.cell) == cellZoom(first.cell) &&
+               (cellX(entries[end].key.cell) >> config.cellShift) == (cellX(first.cell) >> config.cellShift) &&
+               (cellY(entries[end].key.cell) >> config.cellShift) == (cellY(first.cell) >> config.cellShift)) {
+            end++;
+        }
+        ranges.push_back(std::make_pair(begin, end));
+        begin = end;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> written(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            size_t index;
+            while ((index = next.fetch_add(1)) < ranges.size()) {
+                if (writeTile(entries, ranges[index].first, ranges[index].second, config, outputDir, png)) written++;
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return written;
+}
+
+static void cellCorner(uint32_t zoom, uint32_t cellShift, uint32_t x, uint32_t y, double& latitude, double& longitude) {
+    double worldCells = ldexp(1.0, zoom + cellShift);
+    longitude = x / worldCells * 360.0 - 180.0;
+    double n = M_PI - 2.0 * M_PI * y / worldCells;
+    latitude = 180.0 / M_PI * atan(sinh(n));
+}
+
+static size_t writeGeoJson(const std::vector<CellEntry>& entries, const BinningConfig& config, uint32_t zoom,
+                           const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return 0;
+    fputs("{\"type\":\"FeatureCollection\",\"features\":[", file);
+    size_t features = 0;
+    for (const CellEntry& entry : entries) {
+        if (cellZoom(entry.key.cell) != zoom) continue;
+        uint32_t x = cellX(entry.key.cell), y = cellY(entry.key.cell);
+        double north, west, south, east;
+        cellCorner(zoom, config.cellShift, x, y, north, west);
+        cellCorner(zoom, config.cellShift, x + 1, y + 1, south, east);
+        fprintf(file,
+                "%s\n{\"type\":\"Feature\",\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[[%.7f,%.7f],"
+                "[%.7f,%.7f],[%.7f,%.7f],[%.7f,%.7f],[%.7f,%.7f]]]},\"properties\":{\"gateway\":\"%s\","
+                "\"zoom\":%u,\"samples\":%u,\"rssi_mean\":%.1f,\"rssi_max\":%d,\"rssi_min\":%d,"
+                "\"snr_mean\":%.1f,\"gateways_max\":%u}}",
+                features ? "," : "", west, north, east, north, east, south, west, south, west, north,
+                layerName(entry.key.gateway).c_str(), zoom, entry.stats.count, entry.stats.rssiMean(),
+                entry.stats.rssiMax, entry.stats.rssiMin, entry.stats.snrMean(), entry.stats.gatewaysMax);
+        features++;
+    }
+    fputs("\n]}\n", file);
+    fclose(file);
+    return features;
+}
+
+int main(int argc, char** argv) {
+    const char* inputPath = nullptr;
+    std::string outputDir = "tiles";
+    BinningConfig config = {10, 16, 256, 8};
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool png = true;
+    bool bench = false;
+    int geojsonZoom = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (strcmp(argv[i], "--zoom") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u-%u", &config.minZoom, &config.maxZoom) != 2) config.maxZoom = config.minZoom;
+        } else if (strcmp(argv[i], "--cells") == 0 && i + 1 < argc) {
+            config.cellsPerTile = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            png = strcmp(argv[++i], "bin") != 0;
+        } else if (strcmp(argv[i], "--geojson-zoom") == 0 && i + 1 < argc) {
+            geojsonZoom = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else {
+            inputPath = argv[i];
+        }
+    }
+
+    config.cellShift = 0;
+    while ((1u << config.cellShift) < config.cellsPerTile) config.cellShift++;
+    if (!inputPath || (1u << config.cellShift) != config.cellsPerTile || config.minZoom > config.maxZoom ||
+        config.maxZoom + config.cellShift > 29 || config.maxZoom > TILES_MAX_ZOOM) {
+        fprintf(stderr, "Usage: %s [-o DIR] [--zoom MIN-MAX] [--cells POW2] [--threads N] "
+                        "[--format png|bin] [--geojson-zoom Z] [--bench] samples.lgss\n", argv[0]);
+        return 1;
+    }
+    if (geojsonZoom < 0) geojsonZoom = (int)config.minZoom;
+
+    SampleFileReader reader;
+    if (!reader.open(inputPath)) {
+        fprintf(stderr, "[Tiles] [ERROR] Cannot read sample file %s\n", inputPath);
+        return 1;
+    }
+    std::vector<size_t> blocks = reader.allBlocks();
+
+    if (bench) {
+        std::vector<unsigned> counts;
+        for (unsigned count = 1; count < threads; count *= 2) counts.push_back(count);
+        counts.push_back(threads);
+        for (unsigned count : counts) {
+            uint64_t samples = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<CellTable> tables = buildRasters(reader, blocks, config, count, samples);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            size_t cellCount = 0;
+            for (const CellTable& table : tables) cellCount += table.size();
+            printf("[Tiles] threads=%2u samples=%llu cells=%zu time=%.3f s rate=%.2f M samples/s\n", count,
+                   (unsigned long long)samples, cellCount, seconds, samples / seconds / 1e6);
+        }
+        return 0;
+    }
+
+    uint64_t samples = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CellTable> tables = buildRasters(reader, blocks, config, threads, samples);
+    double binSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<CellEntry> entries;
+    for (const CellTable& table : tables) {
+        table.forEach([&](const CellKey& key, const CellStats& stats) { entries.push_back({key, stats}); });
+    }
+    // Group by layer, zoom, tile; cells stay row-major inside each tile
+    std::sort(entries.begin(), entries.end(), [&](const CellEntry& a, const CellEntry& b) {
+        if (a.key.gateway != b.key.gateway) return a.key.gateway < b.key.gateway;
+        uint32_t za = cellZoom(a.key.cell), zb = cellZoom(b.key.cell);
+        if (za != zb) return za < zb;
+        uint32_t txa = cellX(a.key.cell) >> config.cellShift, txb = cellX(b.key.cell) >> config.cellShift;
+        if (txa != txb) return txa < txb;
+        uint32_t tya = cellY(a.key.cell) >> config.cellShift, tyb = cellY(b.key.cell) >> config.cellShift;
+        if (tya != tyb) return tya < tyb;
+        return a.key.cell < b.key.cell;
+    });
+
+    if (!makeDirectories(outputDir)) {
+        fprintf(stderr, "[Tiles] [ERROR] Cannot create %s\n", outputDir.c_str());
+        return 1;
+    }
+    size_t tiles = writeTiles(entries, config, outputDir, png, threads);
+    size_t features = writeGeoJson(entries, config, (uint32_t)geojsonZoom, outputDir + "/cells.geojson");
+
+    printf("[Tiles] %llu samples binned into %zu cells in %.3f s with %u threads (%.2f M samples/s)\n",
+           (unsigned long long)samples, entries.size(), binSeconds, threads, samples / binSeconds / 1e6);
+    printf("[Tiles] Wrote %zu %s tiles and %zu GeoJSON cells (zoom %d) to %s\n", tiles, png ? "PNG" : "binary",
+           features, geojsonZoom, outputDir.c_str());
+    return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * LoRa Gateway Sniffer - Dead Reckoning Benchmark
+ *
+ * Runs the firmware's DeadReckoning estimator on the host against a GPS
+ * trace, cuts outages out of the trace and compares the propagated
+ * position with the held-out ground truth. Also measures cycles per
+ * addFix()/estimate() call.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o dead_reckoning_bench dead_reckoning_bench.cpp ../src/dead_reckoning.cpp
+ *
+ * Usage:
+ *   dead_reckoning_bench [trace.csv] [--gap SECONDS] [--period SECONDS]
+ *
+ * Trace format (one fix per line, header optional):
+ *   t_ms,latitude,longitude,speed_kmh,course_deg,hdop
+ * Without a trace a synthetic 1 Hz drive (with turns and GPS noise) is used.
+ */
+
+#include "dead_reckoning.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+struct TracePoint {
+    uint32_t timeMs;
+    double latitude;
+    double longitude;
+    double speedKmh;
+    double courseDeg;
+    double hdop;
+};
+
+static const double EARTH_RADIUS_M = 6371000.0;
+static const double DEG_TO_RAD = M_PI / 180.0;
+
+static double distanceMeters(double lat1, double lon1, double lat2, double lon2) {
+    double dLat = (lat2 - lat1) * DEG_TO_RAD;
+    double dLon = (lon2 - lon1) * DEG_TO_RAD;
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+               cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
+    return 2 * EARTH_RADIUS_M * atan2(sqrt(a), sqrt(1 - a));
+}
+
+static bool loadTrace(const char* path, std::vector<TracePoint>& trace) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "[DR] [ERROR] Cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        TracePoint point;
+        unsigned long timeMs;
+        if (sscanf(line, "%lu,%lf,%lf,%lf,%lf,%lf", &timeMs, &point.latitude, &point.longitude,
+                   &point.speedKmh, &point.courseDeg, &point.hdop) == 6) {
+            point.timeMs = (uint32_t)timeMs;
+            trace.push_back(point);
+        }
+    }
+    fclose(file);
+    return !trace.empty();
+}
+
+// One hour at 1 Hz: straight segments, gentle turns and speed changes,
+// with receiver noise scaled by HDOP on both position and velocity
+static void syntheticTrace(std::vector<TracePoint>& trace) {
+    std::mt19937 rng(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    double latitude = 37.7749, longitude = -122.4194;
+    double speedMs = 12.0, courseDeg = 45.0, turnRate = 0.0;
+    for (uint32_t t = 0; t < 3600; t++) {
+        if (uniform(rng) < 0.03) turnRate = (uniform(rng) - 0.5) * 12.0;
+        if (uniform(rng) < 0.10) turnRate = 0.0;
+        if (uniform(rng) < 0.05) speedMs = std::max(0.0, std::min(30.0, speedMs + (uniform(rng) - 0.5) * 8.0));
+        courseDeg = fmod(courseDeg + turnRate + 360.0, 360.0);
+
+        double north = speedMs * cos(courseDeg * DEG_TO_RAD);
+        double east = speedMs * sin(courseDeg * DEG_TO_RAD);
+        latitude += north / 111319.49;
+        longitude += east / (111319.49 * cos(latitude * DEG_TO_RAD));
+
+        double hdop = 0.8 + uniform(rng) * 1.2;
+        TracePoint point;
+        point.timeMs = t * 1000;
+        point.latitude = latitude + noise(rng) * hdop * 2.0 / 111319.49;
+        point.longitude = longitude + noise(rng) * hdop * 2.0 / (111319.49 * cos(latitude * DEG_TO_RAD));
+        point.speedKmh = std::max(0.0, (speedMs + noise(rng) * 0.2) * 3.6);
+        point.courseDeg = fmod(courseDeg + noise(rng) * 2.0 + 360.0, 360.0);
+        point.hdop = hdop;
+        trace.push_back(point);
+    }
+}
+
+static void feed(DeadReckoning& estimator, const TracePoint& point) {
+    estimator.addFix(point.timeMs,
+                     (int32_t)lround(point.latitude * 1e7),
+                     (int32_t)lround(point.longitude * 1e7),
+                     (uint32_t)(point.speedKmh * 1000.0 / 3.6),
+                     (uint32_t)(point.courseDeg * 100.0),
+                     (uint32_t)(point.hdop * 100.0));
+}
+
+struct ErrorBucket {
+    const char* label;
+    uint32_t maxAgeMs;
+    std::vector<double> errors;
+    uint32_t contained;
+};
+
+static double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(p * (values.size() - 1));
+    return values[index];
+}
+
+static void runAccuracy(const std::vector<TracePoint>& trace, uint32_t gapMs, uint32_t periodMs) {
+    ErrorBucket buckets[] = {
+        {"0-5 s", 5000, {}, 0},
+        {"5-15 s", 15000, {}, 0},
+        {"15-30 s", 30000, {}, 0},
+        {"30-60 s", 60000, {}, 0},
+    };
+    const size_t bucketCount = sizeof(buckets) / sizeof(buckets[0]);
+
+    DeadReckoning estimator;
+    uint32_t start = trace.front().timeMs;
+    uint32_t dropped = 0, unavailable = 0;
+
+    for (const TracePoint& point : trace) {
+        uint32_t phase = (point.timeMs - start) % periodMs;
+        bool inGap = phase >= periodMs - gapMs;
+        if (!inGap) {
+            feed(estimator, point);
+            continue;
+        }
+
+        // Held-out sample: estimate against the receiver's own reading
+        dropped++;
+        PositionEstimate estimate;
+        if (!estimator.estimate(point.timeMs, estimate)) {
+            unavailable++;
+            continue;
+        }
+        double error = distanceMeters(estimate.latitudeE7 / 1e7, estimate.longitudeE7 / 1e7,
+                                      point.latitude, point.longitude);
+        for (size_t i = 0; i < bucketCount; i++) {
+            if (estimate.ageMs <= buckets[i].maxAgeMs) {
+                buckets[i].errors.push_back(error);
+                if (error <= estimate.accuracyMm / 1000.0) buckets[i].contained++;
+                break;
+            }
+        }
+    }
+
+    printf("[DR] Outage %u s every %u s, %u samples held out, %u beyond horizon\n",
+           gapMs / 1000, periodMs / 1000, dropped, unavailable);
+    printf("[DR] %-8s %8s %10s %10s %10s %10s\n", "age", "samples", "mean_m", "p50_m", "p95_m", "in_radius");
+    for (size_t i = 0; i < bucketCount; i++) {
+        std::vector<double>& errors = buckets[i].errors;
+        if (errors.empty()) continue;
+        double sum = 0;
+        for (double e : errors) sum += e;
+        size_t count = errors.size();
+        double mean = sum / count;
+        double p50 = percentile(errors, 0.50);
+        double p95 = percentile(errors, 0.95);
+        printf("[DR] %-8s %8zu %10.1f %10.1f %10.1f %9.1f%%\n", buckets[i].label, count, mean, p50, p95,
+               100.0 * buckets[i].contained / count);
+    }
+}
+
+static void runTiming(const std::vector<TracePoint>& trace) {
+    const int iterations = 2000000;
+    DeadReckoning estimator;
+    PositionEstimate estimate;
+    volatile int32_t sink = 0;
+
+    auto wallStart = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+    uint64_t cycleStart = __rdtsc();
+#endif
+    for (int i = 0; i < iterations; i++) {
+        feed(estimator, trace[i % trace.size()]);
+    }
+#ifdef HAVE_TSC
+    uint64_t addCycles = __rdtsc() - cycleStart;
+#endif
+    auto wallMid = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+    cycleStart = __rdtsc();
+#endif
+    uint32_t base = estimator.getLastFixTime();
+    for (int i = 0; i < iterations; i++) {
+        estimator.estimate(base + (i % DR_MAX_EXTRAPOLATION_MS), estimate);
+        sink = sink + estimate.latitudeE7;
+    }
+#ifdef HAVE_TSC
+    uint64_t estimateCycles = __rdtsc() - cycleStart;
+#endif
+    auto wallEnd = std::chrono::steady_clock::now();
+    (void)sink;
+
+    double addNs = std::chrono::duration<double, std::nano>(wallMid - wallStart).count() / iterations;
+    double estimateNs = std::chrono::duration<double, std::nano>(wallEnd - wallMid).count() / iterations;
+    printf("[DR] addFix:   %.1f ns/update", addNs);
+#ifdef HAVE_TSC
+    printf(", %.1f cycles/update", (double)addCycles / iterations);
+#endif
+    printf("\n[DR] estimate: %.1f ns/update", estimateNs);
+#ifdef HAVE_TSC
+    printf(", %.1f cycles/update", (double)estimateCycles / iterations);
+#endif
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    uint32_t gapSeconds = 30;
+    uint32_t periodSeconds = 120;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--gap") == 0 && i + 1 < argc) {
+            gapSeconds = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            periodSeconds = (uint32_t)atoi(argv[++i]);
+        } else {
+            tracePath = argv[i];
+        }
+    }
+    if (gapSeconds == 0 || gapSeconds >= periodSeconds) {
+        fprintf(stderr, "[DR] [ERROR] --gap must be between 1 and --period - 1\n");
+        return 1;
+    }
+
+    std::vector<TracePoint> trace;
+    if (tracePath) {
+        if (!loadTrace(tracePath, trace)) return 1;
+        printf("[DR] Loaded %zu fixes from %s\n", trace.size(), tracePath);
+    } else {
+        syntheticTrace(trace);
+        printf("[DR] Using synthetic trace: %zu fixes\n", trace.size());
+    }
+
+    runAccuracy(trace, gapSeconds * 1000, periodSeconds * 1000);
+    runTiming(trace);
+    return 0;
+}
@@ -0,0 +1,764 @@
+/**
+ * LoRa Gateway Sniffer - Gateway Location Estimator
+ *
+ * Estimates where each gateway is from the sniffer positions at which it
+ * heard uplinks and the RSSI it reported. Per gateway a log-distance path
+ * loss model
+ *
+ *     rssi = P0 - 10 * n * log10(d / 100 m)
+ *
+ * is fitted jointly with the gateway position (x, y, P0, n). A RANSAC pass
+ * over candidate positions taken from strong cells seeds a Huber-weighted
+ * Levenberg-Marquardt solve, and the position covariance gives a 95 %
+ * uncertainty ellipse.
+ *
+ * Samples are folded into per-gateway grid cells (centroid, mean RSSI,
+ * count) that coarsen automatically once a gateway exceeds --max-cells, so
+ * memory stays bounded for any number of samples. Adding samples only
+ * marks their gateway dirty; the next solve refits dirty gateways from
+ * their previous solution instead of starting over. Gateways are sharded
+ * across threads by id for both ingest and solve.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -pthread -I../src -o gateway_locate gateway_locate.cpp ../src/sample_archive.cpp
+ *
+ * Usage:
+ *   gateway_locate [--threads N] [--cell M] [--max-cells N] [--geojson out.geojson] samples.lgss [more.lgss ...]
+ *       Files are ingested in order with an incremental solve after each; CSV goes to stdout.
+ *   gateway_locate --bench GATEWAYS SAMPLES [--threads N]
+ *       Synthetic fleet with known gateway positions; reports ingest/solve rates and error.
+ */
+
+#include "sample_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define LOCATE_METERS_PER_DEGREE    111319.49
+#define LOCATE_REFERENCE_DISTANCE_M 100.0
+#define LOCATE_MIN_CELLS            6
+#define LOCATE_MAX_CELL_WEIGHT      32.0f   // Cap per-cell weight so parking spots don't dominate
+#define LOCATE_INLIER_DB            10.0
+#define LOCATE_RANSAC_CANDIDATES    24
+#define LOCATE_RANSAC_SUBSAMPLE     256
+#define LOCATE_MIN_EXPONENT         1.5
+#define LOCATE_MAX_EXPONENT         6.0
+#define LOCATE_CHI2_95_2DOF         5.991
+
+struct Cell {
+    uint32_t key;       // (cx & 0xFFFF) << 16 | (cy & 0xFFFF); 0xFFFFFFFF = empty
+    uint32_t count;
+    float x;            // Centroid of the samples in the cell (m, local frame)
+    float y;
+    float rssi;         // Mean RSSI
+};
+
+static const uint32_t CELL_EMPTY = 0xFFFFFFFF;
+
+struct GatewaySolution {
+    double x, y;            // Local frame, metres
+    double p0;              // RSSI at 100 m
+    double exponent;        // Path loss exponent n
+    double sigmaDb;         // Robust residual scale
+    double ellipseMajorM;   // 95 % semi-axes
+    double ellipseMinorM;
+    double ellipseAngleDeg; // Major axis, degrees clockwise from north
+    uint32_t cellsUsed;
+    uint32_t inliers;
+    bool valid;
+};
+
+class GatewayModel {
+private:
+    std::vector<Cell> cells;
+    uint32_t cellCount;
+    float cellSize;
+    uint32_t maxCells;
+
+    static uint32_t makeKey(int32_t cx, int32_t cy) {
+        return ((uint32_t)(cx & 0xFFFF) << 16) | (uint32_t)(cy & 0xFFFF);
+    }
+
+    Cell& slot(uint32_t key) {
+        uint32_t mask = (uint32_t)cells.size() - 1;
+        uint32_t i = (key * 2654435761u) & mask;
+        while (cells[i].key != CELL_EMPTY && cells[i].key != key) i = (i + 1) & mask;
+        return cells[i];
+    }
+
+    void insert(float x, float y, float rssi, uint32_t count) {
+        uint32_t key = makeKey((int32_t)floorf(x / cellSize), (int32_t)floorf(y / cellSize));
+        Cell& cell = slot(key);
+        if (cell.key == CELL_EMPTY) {
+            cell.key = key;
+            cell.count = count;
+            cell.x = x;
+            cell.y = y;
+            cell.rssi = rssi;
+            cellCount++;
+            return;
+        }
+        // Running weighted means keep float precision far from the origin
+        uint32_t total = cell.count + count;
+        float share = (float)count / total;
+        cell.x += (x - cell.x) * share;
+        cell.y += (y - cell.y) * share;
+        cell.rssi += (rssi - cell.rssi) * share;
+        cell.count = total;
+    }
+
+    // Double the cell size and merge neighbours until there is room again
+    void coarsen() {
+        std::vector<Cell> old;
+        old.swap(cells);
+        do {
+            cellSize *= 2;
+            cells.assign(old.size(), Cell{CELL_EMPTY, 0, 0, 0, 0});
+            cellCount = 0;
+            for (const Cell& cell : old) {
+                if (cell.key != CELL_EMPTY) insert(cell.x, cell.y, cell.rssi, cell.count);
+            }
+        } while (cellCount * 2 > maxCells);
+    }
+
+public:
+    uint64_t gatewayId;
+    double originLatitude;
+    double originLongitude;
+    double metersPerDegreeLon;
+    uint64_t samples;
+    bool dirty;
+    GatewaySolution solution;
+
+    GatewayModel(uint64_t id, double latitude, double longitude, float initialCellSize, uint32_t cellLimit)
+        : cellCount(0), cellSize(initialCellSize), maxCells(cellLimit), gatewayId(id),
+          originLatitude(latitude), originLongitude(longitude),
+          metersPerDegreeLon(LOCATE_METERS_PER_DEGREE * cos(latitude * M_PI / 180.0)),
+          samples(0), dirty(false) {
+        cells.assign(64, Cell{CELL_EMPTY, 0, 0, 0, 0});
+        memset(&solution, 0, sizeof(solution));
+    }
+
+    void add(double latitude, double longitude, float rssi) {
+        float x = (float)((longitude - originLongitude) * metersPerDegreeLon);
+        float y = (float)((latitude - originLatitude) * LOCATE_METERS_PER_DEGREE);
+        if ((cellCount + 1) * 10 > cells.size() * 7) {
+            if (cellCount + 1 > maxCells) {
+                coarsen();
+            } else {
+                std::vector<Cell> old;
+                old.swap(cells);
+                cells.assign(old.size() * 2, Cell{CELL_EMPTY, 0, 0, 0, 0});
+                cellCount = 0;
+                for (const Cell& cell : old) {
+                    if (cell.key != CELL_EMPTY) insert(cell.x, cell.y, cell.rssi, cell.count);
+                }
+            }
+        }
+        insert(x, y, rssi, 1);
+        samples++;
+        dirty = true;
+    }
+
+    void compactCells(std::vector<Cell>& out) const {
+        out.clear();
+        for (const Cell& cell : cells) {
+            if (cell.key != CELL_EMPTY) out.push_back(cell);
+        }
+    }
+
+    void toLatLon(double x, double y, double& latitude, double& longitude) const {
+        latitude = originLatitude + y / LOCATE_METERS_PER_DEGREE;
+        longitude = originLongitude + x / metersPerDegreeLon;
+    }
+
+    void toLocal(double latitude, double longitude, double& x, double& y) const {
+        x = (longitude - originLongitude) * metersPerDegreeLon;
+        y = (latitude - originLatitude) * LOCATE_METERS_PER_DEGREE;
+    }
+};
+
+// ---- Solver -------------------------------------------------------------
+
+static inline double logDistance(double dx, double dy) {
+    double d = sqrt(dx * dx + dy * dy);
+    if (d < 1.0) d = 1.0;
+    return -10.0 * log10(d / LOCATE_REFERENCE_DISTANCE_M);
+}
+
+static inline float cellWeight(const Cell& cell) {
+    return std::min((float)cell.count, LOCATE_MAX_CELL_WEIGHT);
+}
+
+// Weighted linear fit of rssi = P0 + n * L for a fixed position
+static void fitPowerLaw(const std::vector<Cell>& cells, size_t stride, double x, double y,
+                        double& p0, double& exponent) {
+    double sw = 0, sl = 0, sr = 0, sll = 0, slr = 0;
+    for (size_t i = 0; i < cells.size(); i += stride) {
+        double w = cellWeight(cells[i]);
+        double l = logDistance(cells[i].x - x, cells[i].y - y);
+        sw += w;
+        sl += w * l;
+        sr += w * cells[i].rssi;
+        sll += w * l * l;
+        slr += w * l * cells[i].rssi;
+    }
+    double det = sw * sll - sl * sl;
+    exponent = fabs(det) > 1e-9 ? (sw * slr - sl * sr) / det : 2.7;
+    exponent = std::max(LOCATE_MIN_EXPONENT, std::min(LOCATE_MAX_EXPONENT, exponent));
+    p0 = (sr - exponent * sl) / sw;
+}
+
+// Solve A x = b for a 4x4 system (Gaussian elimination with partial pivoting)
+static bool solve4(double a[4][4], double b[4], double x[4]) {
+    double m[4][5];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) m[i][j] = a[i][j];
+        m[i][4] = b[i];
+    }
+    for (int col = 0; col < 4; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < 4; row++) {
+            if (fabs(m[row][col]) > fabs(m[pivot][col])) pivot = row;
+        }
+        if (fabs(m[pivot][col]) < 1e-12) return false;
+        if (pivot != col) {
+            for (int j = 0; j < 5; j++) std::swap(m[col][j], m[pivot][j]);
+        }
+        for (int row = 0; row < 4; row++) {
+            if (row == col) continue;
+            double factor = m[row][col] / m[col][col];
+            for (int j = col; j < 5; j++) m[row][j] -= factor * m[col][j];
+        }
+    }
+    for (int i = 0; i < 4; i++) x[i] = m[i][4] / m[i][i];
+    return true;
+}
+
+static bool invert4(double a[4][4], double inverse[4][4]) {
+    for (int col = 0; col < 4; col++) {
+        double copy[4][4], unit[4] = {0, 0, 0, 0}, column[4];
+        memcpy(copy, a, sizeof(copy));
+        unit[col] = 1;
+        if (!solve4(copy, unit, column)) return false;
+        for (int row = 0; row < 4; row++) inverse[row][col] = column[row];
+    }
+    return true;
+}
+
+static double medianAbs(std::vector<double>& values) {
+    if (values.empty()) return 0;
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    return values[middle];
+}
+
+struct SolverScratch {
+    std::vector<Cell> cells;
+    std::vector<double> residuals;
+    std::mt19937 rng;
+
+    SolverScratch() : rng(1234) {}
+};
+
+// Huber-IRLS cost and normal equations at parameters p
+static double buildNormal(const std::vector<Cell>& cells, const double p[4], double huberK,
+                          double jtj[4][4], double jtr[4], uint32_t* inliers) {
+    memset(jtj, 0, sizeof(double) * 16);
+    memset(jtr, 0, sizeof(double) * 4);
+    double cost = 0;
+    uint32_t inlierCount = 0;
+    for (const Cell& cell : cells) {
+        double dx = p[0] - cell.x, dy = p[1] - cell.y;
+        double d2 = std::max(dx * dx + dy * dy, 1.0);
+        double l = -10.0 * log10(sqrt(d2) / LOCATE_REFERENCE_DISTANCE_M);
+        double r = cell.rssi - (p[2] + p[3] * l);
+        double absR = fabs(r);
+        double huber = absR <= huberK ? 1.0 : huberK / absR;
+        double w = cellWeight(cell) * huber;
+        cost += cellWeight(cell) * (absR <= huberK ? 0.5 * r * r : huberK * (absR - 0.5 * huberK));
+        if (absR <= LOCATE_INLIER_DB) inlierCount++;
+
+        // Jacobian of the model (residual Jacobian is its negative)
+        double scale = -10.0 * p[3] / (M_LN10 * d2);
+        double j[4] = {scale * dx, scale * dy, 1.0, l};
+        for (int a = 0; a < 4; a++) {
+            jtr[a] += w * j[a] * r;
+            for (int b = a; b < 4; b++) jtj[a][b] += w * j[a] * j[b];
+        }
+    }
+    for (int a = 0; a < 4; a++) {
+        for (int b = 0; b < a; b++) jtj[a][b] = jtj[b][a];
+    }
+    if (inliers) *inliers = inlierCount;
+    return cost;
+}
+
+static double robustScale(const std::vector<Cell>& cells, const double p[4], std::vector<double>& residuals) {
+    residuals.clear();
+    for (const Cell& cell : cells) {
+        double l = logDistance(cell.x - p[0], cell.y - p[1]);
+        residuals.push_back(fabs(cell.rssi - (p[2] + p[3] * l)));
+    }
+    return std::max(1.0, 1.4826 * medianAbs(residuals));
+}
+
+// RANSAC seed: candidate positions from strong cells, scored by inlier weight
+static void ransacSeed(SolverScratch& scratch, double p[4]) {
+    std::vector<Cell>& cells = scratch.cells;
+    std::vector<uint32_t> order(cells.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    size_t strong = std::max<size_t>(1, cells.size() / 4);
+    std::partial_sort(order.begin(), order.begin() + strong, order.end(),
+                      [&](uint32_t a, uint32_t b) { return cells[a].rssi > cells[b].rssi; });
+
+    std::vector<std::pair<double, double>> candidates;
+    for (size_t i = 0; i < std::min<size_t>(8, strong); i++) {
+        candidates.push_back(std::make_pair((double)cells[order[i]].x, (double)cells[order[i]].y));
+    }
+    double wx = 0, wy = 0, ws = 0;
+    for (size_t i = 0; i < strong; i++) {
+        double w = pow(10.0, cells[order[i]].rssi / 20.0);
+        wx += w * cells[order[i]].x;
+        wy += w * cells[order[i]].y;
+        ws += w;
+    }
+    candidates.push_back(std::make_pair(wx / ws, wy / ws));
+    std::uniform_int_distribution<size_t> pick(0, strong - 1);
+    while (candidates.size() < LOCATE_RANSAC_CANDIDATES) {
+        // Midpoints of random strong pairs reach positions between drive paths
+        const Cell& a = cells[order[pick(scratch.rng)]];
+        const Cell& b = cells[order[pick(scratch.rng)]];
+        candidates.push_back(std::make_pair((a.x + b.x) * 0.5, (a.y + b.y) * 0.5));
+    }
+
+    size_t stride = std::max<size_t>(1, cells.size() / LOCATE_RANSAC_SUBSAMPLE);
+    double bestScore = -1;
+    for (const auto& candidate : candidates) {
+        double p0, exponent;
+        fitPowerLaw(cells, stride, candidate.first, candidate.second, p0, exponent);
+        double score = 0;
+        for (size_t i = 0; i < cells.size(); i += stride) {
+            double l = logDistance(cells[i].x - candidate.first, cells[i].y - candidate.second);
+            if (fabs(cells[i].rssi - (p0 + exponent * l)) <= LOCATE_INLIER_DB) score += cellWeight(cells[i]);
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            p[0] = candidate.first;
+            p[1] = candidate.second;
+            p[2] = p0;
+            p[3] = exponent;
+        }
+    }
+}
+
+static void solveGateway(GatewayModel& model, SolverScratch& scratch) {
+    model.compactCells(scratch.cells);
+    model.dirty = false;
+    GatewaySolution& solution = model.solution;
+    if (scratch.cells.size() < LOCATE_MIN_CELLS) {
+        solution.valid = false;
+        return;
+    }
+
+    double p[4];
+    bool warm = solution.valid;
+    if (warm) {
+        p[0] = solution.x;
+        p[1] = solution.y;
+        p[2] = solution.p0;
+        p[3] = solution.exponent;
+    } else {
+        ransacSeed(scratch, p);
+    }
+
+    // Levenberg-Marquardt with Huber weights re-derived from a MAD scale
+    double lambda = 1e-3;
+    int maxIterations = warm ? 8 : 40;
+    double sigma = robustScale(scratch.cells, p, scratch.residuals);
+    double jtj[4][4], jtr[4];
+    double cost = buildNormal(scratch.cells, p, 1.345 * sigma, jtj, jtr, nullptr);
+    for (int iteration = 0; iteration < maxIterations; iteration++) {
+        double damped[4][4], step[4];
+        memcpy(damped, jtj, sizeof(damped));
+        for (int i = 0; i < 4; i++) damped[i][i] *= 1.0 + lambda;
+        if (!solve4(damped, jtr, step)) break;
+
+        double trial[4] = {p[0] + step[0], p[1] + step[1], p[2] + step[2], p[3] + step[3]};
+        trial[3] = std::max(LOCATE_MIN_EXPONENT, std::min(LOCATE_MAX_EXPONENT, trial[3]));
+        double trialJtj[4][4], trialJtr[4];
+        double trialCost = buildNormal(scratch.cells, trial, 1.345 * sigma, trialJtj, trialJtr, nullptr);
+        if (trialCost < cost) {
+            memcpy(p, trial, sizeof(trial));
+            memcpy(jtj, trialJtj, sizeof(jtj));
+            memcpy(jtr, trialJtr, sizeof(jtr));
+            cost = trialCost;
+            lambda = std::max(lambda / 3.0, 1e-7);
+            if (step[0] * step[0] + step[1] * step[1] < 0.01) break;
+            sigma = robustScale(scratch.cells, p, scratch.residuals);
+            cost = buildNormal(scratch.cells, p, 1.345 * sigma, jtj, jtr, nullptr);
+        } else {
+            lambda *= 4.0;
+            if (lambda > 1e7) break;
+        }
+    }
+
+    // Covariance of the position from the final normal matrix
+    uint32_t inliers = 0;
+    buildNormal(scratch.cells, p, 1.345 * sigma, jtj, jtr, &inliers);
+    double weightSum = 0, weightedSq = 0;
+    for (const Cell& cell : scratch.cells) {
+        double r = cell.rssi - (p[2] + p[3] * logDistance(cell.x - p[0], cell.y - p[1]));
+        weightSum += cellWeight(cell);
+        weightedSq += cellWeight(cell) * std::min(r * r, 9.0 * sigma * sigma);
+    }
+    double variance = weightedSq / std::max(1.0, weightSum - 4.0);
+    double inverse[4][4];
+    solution.valid = invert4(jtj, inverse);
+    if (!solution.valid) return;
+
+    double a = inverse[0][0] * variance, b = inverse[0][1] * variance, c = inverse[1][1] * variance;
+    double mean = (a + c) / 2, spread = sqrt(((a - c) / 2) * ((a - c) / 2) + b * b);
+    solution.x = p[0];
+    solution.y = p[1];
+    solution.p0 = p[2];
+    solution.exponent = p[3];
+    solution.sigmaDb = sigma;
+    solution.ellipseMajorM = sqrt(LOCATE_CHI2_95_2DOF * std::max(0.0, mean + spread));
+    solution.ellipseMinorM = sqrt(LOCATE_CHI2_95_2DOF * std::max(0.0, mean - spread));
+    // Angle of the major axis in the x=east / y=north frame, converted to a bearing
+    double angle = 0.5 * atan2(2 * b, a - c) * 180.0 / M_PI;
+    solution.ellipseAngleDeg = fmod(90.0 - angle + 360.0, 180.0);
+    solution.cellsUsed = (uint32_t)scratch.cells.size();
+    solution.inliers = inliers;
+}
+
+// ---- Sharded store ----------------------------------------------------
+
+class GatewayLocator {
+private:
+    struct Shard {
+        std::unordered_map<uint64_t, uint32_t> index;
+        std::vector<GatewayModel> gateways;
+    };
+
+    std::vector<Shard> shards;
+    float cellSize;
+    uint32_t maxCells;
+
+public:
+    GatewayLocator(unsigned shardCount, float initialCellSize, uint32_t cellLimit)
+        : shards(shardCount), cellSize(initialCellSize), maxCells(cellLimit) {}
+
+    unsigned shardCount() const { return (unsigned)shards.size(); }
+
+    static unsigned shardOf(uint64_t gatewayId, unsigned count) {
+        return (unsigned)((gatewayId * 0x9E3779B97F4A7C15ULL) >> 40) % count;
+    }
+
+    // Only the thread owning `shard` may call this
+    void add(unsigned shard, uint64_t gatewayId, double latitude, double longitude, float rssi) {
+        Shard& owner = shards[shard];
+        auto found = owner.index.find(gatewayId);
+        uint32_t index;
+        if (found == owner.index.end()) {
+            index = (uint32_t)owner.gateways.size();
+            owner.index.emplace(gatewayId, index);
+            owner.gateways.emplace_back(gatewayId, latitude, longitude, cellSize, maxCells);
+        } else {
+            index = found->second;
+        }
+        owner.gateways[index].add(latitude, longitude, rssi);
+    }
+
+    // Each thread scans every block but keeps only its own shard's rows
+    void ingest(const SampleFileReader& reader, const std::vector<size_t>& blocks) {
+        std::vector<std::thread> workers;
+        unsigned count = shardCount();
+        for (unsigned s = 0; s < count; s++) {
+            workers.emplace_back([&, s]() {
+                SampleBlockBuffer buffer;
+                SampleBlockView view;
+                for (size_t index : blocks) {
+                    if (!reader.decodeBlock(index, buffer, view)) continue;
+                    for (uint32_t i = 0; i < view.rows; i++) {
+                        if (!(view.flags[i] & SAMPLE_FLAG_POSITION)) continue;
+                        if (shardOf(view.gatewayId[i], count) != s) continue;
+                        add(s, view.gatewayId[i], view.latitudeE7[i] / 1e7, view.longitudeE7[i] / 1e7, view.rssi[i]);
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    // Refits dirty gateways on all shards in parallel; returns how many were solved
+    size_t solveDirty() {
+        std::atomic<size_t> solved(0);
+        std::vector<std::thread> workers;
+        for (unsigned s = 0; s < shardCount(); s++) {
+            workers.emplace_back([&, s]() {
+                SolverScratch scratch;
+                for (GatewayModel& model : shards[s].gateways) {
+                    if (!model.dirty) continue;
+                    solveGateway(model, scratch);
+                    solved++;
+                }
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+        return solved;
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Shard& shard : shards) {
+            for (const GatewayModel& model : shard.gateways) visit(model);
+        }
+    }
+
+    template <typename Visitor>
+    void forEachMutable(Visitor visit) {
+        for (Shard& shard : shards) {
+            for (GatewayModel& model : shard.gateways) visit(model);
+        }
+    }
+};
+
+// ---- Output -------------------------------------------------------------
+
+static void printCsv(const GatewayLocator& locator) {
+    printf("gateway_id,latitude,longitude,p0_dbm_at_100m,exponent,sigma_db,ellipse_major_m,ellipse_minor_m,"
+           "ellipse_bearing_deg,samples,cells,inliers\n");
+    locator.forEach([](const GatewayModel& model) {
+        const GatewaySolution& s = model.solution;
+        if (!s.valid) return;
+        double latitude, longitude;
+        model.toLatLon(s.x, s.y, latitude, longitude);
+        printf("%016llx,%.7f,%.7f,%.1f,%.2f,%.1f,%.0f,%.0f,%.0f,%llu,%u,%u\n", (unsigned long long)model.gatewayId,
+               latitude, longitude, s.p0, s.exponent, s.sigmaDb, s.ellipseMajorM, s.ellipseMinorM,
+               s.ellipseAngleDeg, (unsigned long long)model.samples, s.cellsUsed, s.inliers);
+    });
+}
+
+static void writeGeoJson(const GatewayLocator& locator, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "[Locate] [ERROR] Cannot create %s\n", path);
+        return;
+    }
+    fputs("{\"type\":\"FeatureCollection\",\"features\":[", file);
+    bool first = true;
+    locator.forEach([&](const GatewayModel& model) {
+        const GatewaySolution& s = model.solution;
+        if (!s.valid) return;
+        // Ellipse outline as a 36-point polygon
+        fprintf(file, "%s\n{\"type\":\"Feature\",\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[", first ? "" : ",");
+        double bearing = s.ellipseAngleDeg * M_PI / 180.0;
+        for (int k = 0; k <= 36; k++) {
+            double t = 2 * M_PI * (k % 36) / 36;
+            double u = s.ellipseMajorM * cos(t), v = s.ellipseMinorM * sin(t);
+            double east = u * sin(bearing) + v * cos(bearing);
+            double north = u * cos(bearing) - v * sin(bearing);
+            double latitude, longitude;
+            model.toLatLon(s.x + east, s.y + north, latitude, longitude);
+            fprintf(file, "%s[%.7f,%.7f]", k ? "," : "", longitude, latitude);
+        }
+        double latitude, longitude;
+        model.toLatLon(s.x, s.y, latitude, longitude);
+        fprintf(file, "]]},\"properties\":{\"gateway\":\"%016llx\",\"latitude\":%.7f,\"longitude\":%.7f,"
+                      "\"p0\":%.1f,\"exponent\":%.2f,\"major_m\":%.0f,\"minor_m\":%.0f,\"samples\":%llu}}",
+                (unsigned long long)model.gatewayId, latitude, longitude, s.p0, s.exponent, s.ellipseMajorM,
+                s.ellipseMinorM, (unsigned long long)model.samples);
+        first = false;
+    });
+    fputs("\n]}\n", file);
+    fclose(file);
+}
+
+// ---- Benchmark ----------------------------------------------------------
+
+struct TrueGateway {
+    double latitude, longitude, p0, exponent;
+};
+
+// Synthetic sniffer drives: each sample lands within 12 km of its gateway
+// with 6 dB shadowing and 5 % gross outliers (bad fixes, multipath)
+static void generateSamples(GatewayLocator& locator, const std::vector<TrueGateway>& truth,
+                            uint64_t samples, uint64_t seed) {
+    unsigned shards = locator.shardCount();
+    std::vector<std::vector<uint32_t>> owned(shards);
+    for (uint32_t g = 0; g < truth.size(); g++) owned[GatewayLocator::shardOf(g + 1, shards)].push_back(g);
+
+    std::vector<std::thread> workers;
+    for (unsigned s = 0; s < shards; s++) {
+        workers.emplace_back([&, s]() {
+            if (owned[s].empty()) return;
+            std::mt19937_64 rng(seed * 7919 + s);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            std::normal_distribution<double> shadowing(0.0, 6.0);
+            uint64_t share = samples * owned[s].size() / truth.size();
+            for (uint64_t i = 0; i < share; i++) {
+                uint32_t g = owned[s][(size_t)(uniform(rng) * owned[s].size())];
+                const TrueGateway& gw = truth[g];
+                double distance = 30.0 + 12000.0 * sqrt(uniform(rng));
+                double bearing = uniform(rng) * 2 * M_PI;
+                double latitude = gw.latitude + distance * cos(bearing) / LOCATE_METERS_PER_DEGREE;
+                double longitude = gw.longitude + distance * sin(bearing) /
+                                   (LOCATE_METERS_PER_DEGREE * cos(gw.latitude * M_PI / 180.0));
+                double rssi = gw.p0 - 10 * gw.exponent * log10(distance / LOCATE_REFERENCE_DISTANCE_M) + shadowing(rng);
+                if (uniform(rng) < 0.05) rssi += (uniform(rng) - 0.5) * 50;
+                if (rssi < -137) continue;  // Below SX1262 sensitivity, never heard
+                locator.add(s, g + 1, latitude, longitude, (float)rssi);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+}
+
+static void reportError(GatewayLocator& locator, const std::vector<TrueGateway>& truth) {
+    std::vector<double> errors;
+    size_t inside = 0;
+    locator.forEach([&](const GatewayModel& model) {
+        if (!model.solution.valid) return;
+        const TrueGateway& gw = truth[model.gatewayId - 1];
+        double x, y;
+        model.toLocal(gw.latitude, gw.longitude, x, y);
+        double dx = x - model.solution.x, dy = y - model.solution.y;
+        double error = sqrt(dx * dx + dy * dy);
+        errors.push_back(error);
+        // Inside the ellipse? Rotate into its axes (bearing is clockwise from north)
+        double bearing = model.solution.ellipseAngleDeg * M_PI / 180.0;
+        double u = -dx * sin(bearing) - dy * cos(bearing);
+        double v = -dx * cos(bearing) + dy * sin(bearing);
+        double major = std::max(model.solution.ellipseMajorM, 1e-3), minor = std::max(model.solution.ellipseMinorM, 1e-3);
+        if ((u * u) / (major * major) + (v * v) / (minor * minor) <= 1.0) inside++;
+    });
+    if (errors.empty()) return;
+    std::sort(errors.begin(), errors.end());
+    printf("[Locate] Solved %zu gateways: error p50 %.0f m, p90 %.0f m, p95 %.0f m; %.1f%% inside 95%% ellipse\n",
+           errors.size(), errors[errors.size() / 2], errors[errors.size() * 9 / 10], errors[errors.size() * 95 / 100],
+           100.0 * inside / errors.size());
+}
+
+static int runBenchmark(uint32_t gatewayCount, uint64_t samples, unsigned threads) {
+    std::mt19937_64 rng(99);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<TrueGateway> truth(gatewayCount);
+    for (TrueGateway& gw : truth) {
+        gw.latitude = 36.0 + uniform(rng) * 2.0;
+        gw.longitude = -123.0 + uniform(rng) * 2.5;
+        gw.p0 = -70.0 + uniform(rng) * 15.0;
+        gw.exponent = 2.4 + uniform(rng) * 1.0;
+    }
+
+    GatewayLocator locator(threads, 50.0f, 2048);
+    auto start = std::chrono::steady_clock::now();
+    generateSamples(locator, truth, samples, 1);
+    double ingestSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t stored = 0;
+    locator.forEach([&](const GatewayModel& model) { stored += model.samples; });
+    printf("[Locate] Ingested %llu samples for %u gateways in %.2f s (%.1f M samples/s incl. generation)\n",
+           (unsigned long long)stored, gatewayCount, ingestSeconds, stored / ingestSeconds / 1e6);
+
+    start = std::chrono::steady_clock::now();
+    size_t solved = locator.solveDirty();
+    double solveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[Locate] Full solve: %zu gateways in %.2f s (%.0f gateways/s, %u threads)\n", solved, solveSeconds,
+           solved / solveSeconds, threads);
+    reportError(locator, truth);
+
+    // A new drive session touching 5 % of the gateways
+    uint32_t touched = std::max<uint32_t>(1, gatewayCount / 20);
+    GatewayLocator* target = &locator;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned s = 0; s < threads; s++) {
+        workers.emplace_back([&, s]() {
+            std::mt19937_64 local(500 + s);
+            std::uniform_real_distribution<double> u(0.0, 1.0);
+            std::normal_distribution<double> shadowing(0.0, 6.0);
+            for (uint32_t g = 0; g < touched; g++) {
+                if (GatewayLocator::shardOf(g + 1, threads) != s) continue;
+                const TrueGateway& gw = truth[g];
+                for (int i = 0; i < 200; i++) {
+                    double distance = 30.0 + 12000.0 * sqrt(u(local));
+                    double bearing = u(local) * 2 * M_PI;
+                    double rssi = gw.p0 - 10 * gw.exponent * log10(distance / LOCATE_REFERENCE_DISTANCE_M) + shadowing(local);
+                    if (rssi < -137) continue;
+                    target->add(s, g + 1, gw.latitude + distance * cos(bearing) / LOCATE_METERS_PER_DEGREE,
+                                gw.longitude + distance * sin(bearing) /
+                                (LOCATE_METERS_PER_DEGREE * cos(gw.latitude * M_PI / 180.0)), (float)rssi);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    solved = locator.solveDirty();
+    double incrementalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[Locate] Incremental update: %zu dirty gateways refitted in %.3f s (full solve %.2f s)\n", solved,
+           incrementalSeconds, solveSeconds);
+    reportError(locator, truth);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    float cellSize = 50.0f;
+    uint32_t maxCells = 2048;
+    const char* geojsonPath = nullptr;
+    std::vector<const char*> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--cell") == 0 && i + 1 < argc) {
+            cellSize = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-cells") == 0 && i + 1 < argc) {
+            maxCells = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--geojson") == 0 && i + 1 < argc) {
+            geojsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 2 < argc) {
+            uint32_t gateways = (uint32_t)atoi(argv[i + 1]);
+            uint64_t samples = strtoull(argv[i + 2], nullptr, 10);
+            for (int j = i + 3; j + 1 < argc; j++) {
+                if (strcmp(argv[j], "--threads") == 0) threads = std::max(1, atoi(argv[j + 1]));
+            }
+            return runBenchmark(gateways, samples, threads);
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty() || cellSize <= 0 || maxCells < 64) {
+        fprintf(stderr, "Usage: %s [--threads N] [--cell M] [--max-cells N] [--geojson out] samples.lgss [...]\n"
+                        "       %s --bench GATEWAYS SAMPLES [--threads N]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    GatewayLocator locator(threads, cellSize, maxCells);
+    for (const char* path : inputs) {
+        SampleFileReader reader;
+        if (!reader.open(path)) {
+            fprintf(stderr, "[Locate] [ERROR] Cannot read sample file %s\n", path);
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        locator.ingest(reader, reader.allBlocks());
+        size_t solved = locator.solveDirty();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "[Locate] %s: %zu gateways refitted in %.3f s\n", path, solved, seconds);
+    }
+
+    printCsv(locator);
+    if (geojsonPath) writeGeoJson(locator, geojsonPath);
+    return 0;
+}
@@ -0,0 +1,187 @@
+#ifndef JSON_SAX_H
+#define JSON_SAX_H
+
+// Minimal streaming (SAX) JSON tokenizer for ChirpStack exports.
+//
+// parseJson() walks a buffer once and reports tokens to a handler without
+// building any document tree. Several top-level values may follow each
+// other (JSONL or concatenated objects). String contents are passed as raw
+// slices of the input; `escaped` is set when the slice contains backslash
+// escapes, which none of the fields we extract ever do.
+//
+// Handler interface (static dispatch, no virtual calls):
+//   void startObject();  void endObject();
+//   void startArray();   void endArray();
+//   void key(const char* text, size_t length);
+//   void string(const char* text, size_t length, bool escaped);
+//   void number(const char* text, size_t length);
+//   void literal(char first);   // 't', 'f' or 'n'
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 64
+
+enum JsonStatus {
+    JSON_OK = 0,
+    JSON_ERROR_SYNTAX,
+    JSON_ERROR_DEPTH,
+    JSON_ERROR_TRUNCATED
+};
+
+struct JsonResult {
+    JsonStatus status;
+    size_t offset;      // Position of the error, or bytes consumed
+};
+
+static inline bool jsonIsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Returns the closing quote, or nullptr if the string runs past `end`
+static inline const char* jsonScanString(const char* p, const char* end, bool& escaped) {
+    escaped = false;
+    while (p < end) {
+        const char* quote = (const char*)memchr(p, '"', end - p);
+        if (!quote) return nullptr;
+        // Count preceding backslashes to tell \" from "
+        const char* back = quote;
+        while (back > p && back[-1] == '\\') back--;
+        if (((quote - back) & 1) == 0) {
+            if (!escaped && memchr(p, '\\', quote - p)) escaped = true;
+            return quote;
+        }
+        escaped = true;
+        p = quote + 1;
+    }
+    return nullptr;
+}
+
+template <class Handler>
+JsonResult parseJson(const char* begin, const char* end, Handler& handler) {
+    // Per-depth container type: true = object (keys expected)
+    bool isObject[JSON_MAX_DEPTH];
+    int depth = 0;
+    bool expectKey = false;
+    const char* p = begin;
+
+    while (p < end) {
+        char c = *p;
+        if (jsonIsSpace(c) || c == ',' || c == ':') {
+            p++;
+            continue;
+        }
+
+        if (c == '"') {
+            bool escaped;
+            const char* close = jsonScanString(p + 1, end, escaped);
+            if (!close) return {JSON_ERROR_TRUNCATED, (size_t)(p - begin)};
+            if (expectKey) {
+                handler.key(p + 1, close - p - 1);
+                expectKey = false;
+            } else {
+                handler.string(p + 1, close - p - 1, escaped);
+                if (depth > 0 && isObject[depth - 1]) expectKey = true;
+            }
+            p = close + 1;
+            continue;
+        }
+
+        if (expectKey && c != '}') return {JSON_ERROR_SYNTAX, (size_t)(p - begin)};
+
+        switch (c) {
+            case '{':
+            case '[':
+                if (depth == JSON_MAX_DEPTH) return {JSON_ERROR_DEPTH, (size_t)(p - begin)};
+                isObject[depth++] = (c == '{');
+                if (c == '{') {
+                    handler.startObject();
+                    expectKey = true;
+                } else {
+                    handler.startArray();
+                }
+                p++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0 || isObject[depth - 1] != (c == '}')) {
+                    return {JSON_ERROR_SYNTAX, (size_t)(p - begin)};
+                }
+                depth--;
+                if (c == '}') handler.endObject(); else handler.endArray();
+                expectKey = depth > 0 && isObject[depth - 1];
+                p++;
+                break;
+            case 't':
+            case 'f':
+            case 'n': {
+                handler.literal(c);
+                const char* q = p;
+                while (q < end && *q >= 'a' && *q <= 'z') q++;
+                p = q;
+                expectKey = depth > 0 && isObject[depth - 1];
+                break;
+            }
+            default: {
+                if (!((c >= '0' && c <= '9') || c == '-')) return {JSON_ERROR_SYNTAX, (size_t)(p - begin)};
+                const char* q = p + 1;
+                while (q < end && ((*q >= '0' && *q <= '9') || *q == '.' || *q == 'e' ||
+                                   *q == 'E' || *q == '+' || *q == '-')) {
+                    q++;
+                }
+                handler.number(p, q - p);
+                p = q;
+                expectKey = depth > 0 && isObject[depth - 1];
+                break;
+            }
+        }
+    }
+
+    if (depth != 0) return {JSON_ERROR_TRUNCATED, (size_t)(p - begin)};
+    return {JSON_OK, (size_t)(p - begin)};
+}
+
+// Fast integer / decimal parsing for number tokens
+static inline int64_t jsonToInt(const char* text, size_t length) {
+    int64_t value = 0;
+    bool negative = false;
+    size_t i = 0;
+    if (i < length && text[i] == '-') {
+        negative = true;
+        i++;
+    }
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+// Fixed-point value scaled by 10^decimals (e.g. "10.8" with 1 -> 108)
+static inline int64_t jsonToFixed(const char* text, size_t length, int decimals) {
+    int64_t value = 0;
+    bool negative = false;
+    int fraction = -1;
+    size_t i = 0;
+    if (i < length && text[i] == '-') {
+        negative = true;
+        i++;
+    }
+    for (; i < length; i++) {
+        char c = text[i];
+        if (c == '.') {
+            fraction = 0;
+        } else if (c >= '0' && c <= '9') {
+            if (fraction >= decimals) continue;
+            value = value * 10 + (c - '0');
+            if (fraction >= 0) fraction++;
+        } else {
+            break;
+        }
+    }
+    if (fraction < 0) fraction = 0;
+    for (; fraction < decimals; fraction++) value *= 10;
+    return negative ? -value : value;
+}
+
+#endif // JSON_SAX_H
@@ -0,0 +1,379 @@
+/**
+ * LoRa Gateway Sniffer - Batch Status Payload Decoder
+ *
+ * Decodes status uplinks (port 3) from base64 in bulk with the native
+ * decoder in status_batch.h, as a replacement for re-running
+ * payload_decoder.js over history. Also checks conformance against the
+ * JS decoder (through node) and benchmarks frames/s.
+ *
+ * Build (SSSE3 base64 kernel; drop -mssse3 for the portable scalar path):
+ *   g++ -O2 -mssse3 -std=c++17 -pthread -I../src -o payload_batch payload_batch.cpp ../src/payload_codec.cpp
+ *
+ * Usage:
+ *   payload_batch [frames.txt | -]
+ *       One base64 `data` string per line -> CSV on stdout
+ *   payload_batch --conformance N [--js ../payload_decoder.js]
+ *       N encoded + N random frames through the JS decoder, the firmware
+ *       codec and the batch decoder; exits non-zero on any disagreement
+ *   payload_batch --bench FRAMES [--threads N]
+ */
+
+#include "status_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void base64Encode(const uint8_t* data, size_t length, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < length) triple |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) triple |= data[i + 2];
+        out += BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        out += BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        out += i + 1 < length ? BASE64_ALPHABET[(triple >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? BASE64_ALPHABET[triple & 0x3F] : '=';
+    }
+}
+
+// Random status payloads in every length variant the firmware has sent
+static std::vector<std::vector<uint8_t>> makeFrames(size_t encoded, size_t random, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t i = 0; i < encoded; i++) {
+        StatusPayload status;
+        status.uptimeSeconds = i % 16 == 0 ? (uint32_t)rng() : (uint32_t)(uniform(rng) * 86400 * 30);
+        status.freeHeapKB = (uint16_t)rng();
+        status.rssiByte = StatusPayload::encodeRssi(-140 + (float)(uniform(rng) * 140));
+        status.snrByte = StatusPayload::encodeSnr(-20 + (float)(uniform(rng) * 32));
+        status.batteryMv = (uint16_t)(3000 + uniform(rng) * 1300);
+        status.batteryPercent = (uint8_t)(uniform(rng) * 101);
+        status.hasGPS = uniform(rng) < 0.8;
+        status.latitude = (float)(uniform(rng) * 180 - 90);
+        status.longitude = (float)(uniform(rng) * 360 - 180);
+        status.altitude = (float)(uniform(rng) * 3000 - 100);
+        status.satellites = (uint8_t)(uniform(rng) * 24);
+        status.hasPositionQuality = uniform(rng) < 0.7;
+        status.positionFlags = uniform(rng) < 0.2 ? STATUS_FLAG_ESTIMATED : 0;
+        status.accuracyM = (uint16_t)rng();
+        if (uniform(rng) < 0.3) {
+            status.perfCount = (uint8_t)(rng() % (STATUS_PERF_MAX_PROBES + 1));
+            for (int p = 0; p < STATUS_PERF_MAX_PROBES; p++) {
+                status.perfP50[p] = (uint8_t)rng();
+                status.perfP99[p] = (uint8_t)rng();
+            }
+            status.hasEnergy = uniform(rng) < 0.5;
+            status.meanCurrentCentiMa = (uint16_t)rng();
+            status.chargePerUplinkUah = (uint16_t)rng();
+            status.chargeUsedMah = (uint16_t)rng();
+        }
+        uint8_t payload[STATUS_MAX_SIZE];
+        size_t size = encodeStatusPayload(status, payload, sizeof(payload));
+        frames.emplace_back(payload, payload + size);
+    }
+    for (size_t i = 0; i < random; i++) {
+        std::vector<uint8_t> bytes((size_t)(uniform(rng) * (STATUS_MAX_SIZE + 4)));
+        for (uint8_t& byte : bytes) byte = (uint8_t)rng();
+        frames.push_back(bytes);
+    }
+    return frames;
+}
+
+static void buildBatch(const std::vector<std::string>& encoded, std::vector<Base64Frame>& frames) {
+    frames.resize(encoded.size());
+    for (size_t i = 0; i < encoded.size(); i++) {
+        frames[i].text = encoded[i].data();
+        frames[i].length = (uint32_t)encoded[i].size();
+    }
+}
+
+// ---- Conformance --------------------------------------------------------
+
+static const char* NODE_RUNNER =
+    "const fs=require('fs');eval(fs.readFileSync(process.argv[1],'utf8'));"
+    "const out=[];"
+    "for(const line of fs.readFileSync(process.argv[2],'utf8').split('\\n')){"
+    "if(!line)continue;"
+    "const r=decodeUplink({bytes:[...Buffer.from(line.slice(1),'hex')],fPort:3});"
+    "if(r.errors.length){out.push('E');continue;}"
+    "const d=r.data;"
+    "out.push([d.uptime_seconds,d.free_memory_kb,d.rssi_dbm,d.snr_db,d.battery_voltage,d.battery_percentage,"
+    "d.has_gps?1:0,d.latitude,d.longitude,d.altitude,d.satellites,"
+    "d.position_estimated===undefined?undefined:(d.position_estimated?1:0),d.position_accuracy_m,"
+    "d.uptime_hours,d.energy_ma_mean,d.energy_mah_per_uplink,d.energy_mah_used].map(String).join(' '));}"
+    "process.stdout.write(out.join('\\n')+'\\n');";
+
+#define JS_FIELD_COUNT 17
+
+static const char* JS_FIELD_NAMES[JS_FIELD_COUNT] = {
+    "uptime_seconds", "free_memory_kb", "rssi_dbm", "snr_db", "battery_voltage", "battery_percentage", "has_gps",
+    "latitude", "longitude", "altitude", "satellites", "position_estimated", "position_accuracy_m", "uptime_hours",
+    "energy_ma_mean", "energy_mah_per_uplink", "energy_mah_used"};
+
+static bool sameValue(double expected, bool present, const char* token) {
+    if (strcmp(token, "undefined") == 0) return !present;
+    if (!present) return false;
+    double actual = strtod(token, nullptr);
+    if (std::isnan(expected)) return std::isnan(actual);
+    return actual == expected;
+}
+
+static bool checkBase64Kernel(uint64_t seed, size_t cases) {
+    std::mt19937_64 rng(seed);
+    size_t failures = 0;
+    for (size_t c = 0; c < cases; c++) {
+        std::string text((size_t)(rng() % 100), 'A');
+        for (char& ch : text) {
+            uint64_t r = rng() % 200;
+            ch = r < 196 ? BASE64_ALPHABET[r % 64] : (char)(rng() % 256);
+        }
+        if (rng() % 4 == 0) text += rng() % 2 ? "=" : "==";
+        uint8_t fast[128], scalar[128];
+        long fastLength = base64Decode(text.data(), text.size(), fast, sizeof(fast));
+        long scalarLength = base64DecodeScalar(text.data(), text.size(), scalar, sizeof(scalar));
+        if (fastLength != scalarLength || (fastLength > 0 && memcmp(fast, scalar, (size_t)fastLength) != 0)) {
+            if (failures++ < 5) fprintf(stderr, "[Batch] [ERROR] base64 kernel mismatch on \"%s\"\n", text.c_str());
+        }
+    }
+    printf("[Batch] base64 kernel vs scalar: %zu cases, %zu mismatches\n", cases, failures);
+    return failures == 0;
+}
+
+static int runConformance(size_t count, const char* jsPath) {
+    bool ok = checkBase64Kernel(5, count * 10);
+
+    std::vector<std::vector<uint8_t>> payloads = makeFrames(count, count, 3);
+    std::vector<std::string> encoded(payloads.size());
+    for (size_t i = 0; i < payloads.size(); i++) base64Encode(payloads[i].data(), payloads[i].size(), encoded[i]);
+    std::vector<Base64Frame> frames;
+    buildBatch(encoded, frames);
+    StatusBatch batch;
+    batch.resize(frames.size());
+    decodeStatusBatch(frames.data(), 0, frames.size(), batch);
+
+    // Batch decoder against the firmware codec
+    size_t codecMismatches = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+        StatusPayload status;
+        bool decoded = decodeStatusPayload(payloads[i].data(), payloads[i].size(), status);
+        bool same = decoded == (batch.result[i] == STATUS_BATCH_OK);
+        if (same && decoded) {
+            same = status.uptimeSeconds == batch.uptimeSeconds[i] && status.freeHeapKB == batch.freeHeapKB[i] &&
+                   status.rssiDbm() == batch.rssiDbm[i] && status.snrDb() == batch.snrDb[i] &&
+                   status.batteryMv == batch.batteryMv[i] && status.batteryPercent == batch.batteryPercent[i] &&
+                   status.hasGPS == (bool)batch.hasGPS[i] && status.satellites == batch.satellites[i] &&
+                   memcmp(&status.latitude, &batch.latitude[i], 4) == 0 &&
+                   memcmp(&status.longitude, &batch.longitude[i], 4) == 0 &&
+                   memcmp(&status.altitude, &batch.altitude[i], 4) == 0 &&
+                   status.hasPositionQuality == (bool)batch.hasPositionQuality[i] &&
+                   status.positionFlags == batch.positionFlags[i] && status.accuracyM == batch.accuracyM[i];
+        }
+        if (!same) codecMismatches++;
+    }
+    printf("[Batch] batch decoder vs firmware codec: %zu frames, %zu mismatches\n", payloads.size(), codecMismatches);
+    ok = ok && codecMismatches == 0;
+
+    // Batch decoder against payload_decoder.js
+    char vectorPath[] = "/tmp/payload_batch_XXXXXX";
+    int fd = mkstemp(vectorPath);
+    FILE* vectors = fd >= 0 ? fdopen(fd, "w") : nullptr;
+    if (!vectors) {
+        fprintf(stderr, "[Batch] [ERROR] Cannot create vector file\n");
+        return 1;
+    }
+    for (const std::vector<uint8_t>& payload : payloads) {
+        fputc('h', vectors);
+        for (uint8_t byte : payload) fprintf(vectors, "%02x", byte);
+        fputc('\n', vectors);
+    }
+    fclose(vectors);
+
+    std::string command = "node -e \"" + std::string(NODE_RUNNER) + "\" '" + jsPath + "' '" + vectorPath + "'";
+    FILE* node = popen(command.c_str(), "r");
+    if (!node) {
+        fprintf(stderr, "[Batch] [ERROR] Cannot run node\n");
+        return 1;
+    }
+    char line[1024];
+    size_t row = 0, jsMismatches = 0;
+    size_t fieldMismatches[JS_FIELD_COUNT] = {0};
+    while (fgets(line, sizeof(line), node) && row < payloads.size()) {
+        line[strcspn(line, "\n")] = 0;
+        size_t i = row++;
+        bool decoded = batch.result[i] == STATUS_BATCH_OK;
+        if (strcmp(line, "E") == 0 || !decoded) {
+            if ((strcmp(line, "E") == 0) != !decoded) jsMismatches++;
+            continue;
+        }
+
+        bool gps = batch.hasGPS[i], quality = batch.hasPositionQuality[i];
+        // The batch decoder stops before the energy block; the firmware codec reads it
+        StatusPayload full;
+        decodeStatusPayload(payloads[i].data(), payloads[i].size(), full);
+        double expected[JS_FIELD_COUNT] = {
+            (double)batch.uptimeSeconds[i], (double)batch.freeHeapKB[i], (double)batch.rssiDbm[i],
+            (double)batch.snrDb[i], batch.batteryMv[i] / 1000.0, (double)batch.batteryPercent[i], (double)gps,
+            (double)batch.latitude[i], (double)batch.longitude[i], (double)batch.altitude[i],
+            (double)batch.satellites[i], (double)(batch.positionFlags[i] & STATUS_FLAG_ESTIMATED ? 1 : 0),
+            (double)batch.accuracyM[i], floor(batch.uptimeSeconds[i] / 3600.0 * 100 + 0.5) / 100,
+            full.meanCurrentCentiMa / 100.0, full.chargePerUplinkUah / 1000.0, (double)full.chargeUsedMah};
+        bool energy = full.hasEnergy;
+        bool present[JS_FIELD_COUNT] = {true, true, true, true, true, true, true, gps, gps, gps, gps,
+                                        quality, quality, true, energy, energy, energy};
+
+        char* save = nullptr;
+        char* token = strtok_r(line, " ", &save);
+        bool rowOk = true;
+        for (int f = 0; f < JS_FIELD_COUNT; f++, token = strtok_r(nullptr, " ", &save)) {
+            if (!token || !sameValue(expected[f], present[f], token)) {
+                if (fieldMismatches[f]++ == 0) {
+                    fprintf(stderr, "[Batch] [ERROR] %s differs on frame %zu: native %.17g, JS %s\n",
+                            JS_FIELD_NAMES[f], i, expected[f], token ? token : "(missing)");
+                }
+                rowOk = false;
+            }
+        }
+        if (!rowOk) jsMismatches++;
+    }
+    pclose(node);
+    remove(vectorPath);
+    if (row != payloads.size()) {
+        fprintf(stderr, "[Batch] [ERROR] node returned %zu of %zu results (is node installed?)\n", row,
+                payloads.size());
+        return 1;
+    }
+    printf("[Batch] batch decoder vs %s: %zu frames, %zu mismatches\n", jsPath, payloads.size(), jsMismatches);
+    ok = ok && jsMismatches == 0;
+    printf("[Batch] Conformance %s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---- Benchmark ----------------------------------------------------------
+
+static int runBenchmark(size_t count, unsigned threads) {
+    std::vector<std::vector<uint8_t>> payloads = makeFrames(count, 0, 9);
+    std::vector<std::string> encoded(payloads.size());
+    size_t textBytes = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+        base64Encode(payloads[i].data(), payloads[i].size(), encoded[i]);
+        textBytes += encoded[i].size();
+    }
+    std::vector<Base64Frame> frames;
+    buildBatch(encoded, frames);
+    StatusBatch batch;
+    batch.resize(frames.size());
+
+    // Reference: scalar base64 plus the firmware codec, one struct per frame
+    auto start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (const Base64Frame& frame : frames) {
+        uint8_t bytes[64];
+        long length = base64DecodeScalar(frame.text, frame.length, bytes, sizeof(bytes));
+        StatusPayload status;
+        if (length > 0 && decodeStatusPayload(bytes, (size_t)length, status)) checksum += status.uptimeSeconds;
+    }
+    double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int pass = 0; pass < 2; pass++) {
+        unsigned workers = pass == 0 ? 1 : threads;
+        if (pass == 1 && threads == 1) break;
+        start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        size_t chunk = (frames.size() + workers - 1) / workers;
+        for (unsigned t = 0; t < workers; t++) {
+            size_t first = std::min(frames.size(), t * chunk);
+            size_t length = std::min(chunk, frames.size() - first);
+            pool.emplace_back([&, first, length]() { decodeStatusBatch(frames.data(), first, length, batch); });
+        }
+        for (std::thread& worker : pool) worker.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("[Batch] Batch SoA (%s base64), %u thread%s: %.1f M frames/s, %.0f MB/s of base64\n",
+#if defined(__SSSE3__)
+               "SSSE3",
+#else
+               "scalar",
+#endif
+               workers, workers == 1 ? "" : "s", frames.size() / seconds / 1e6, textBytes / seconds / 1e6);
+    }
+    printf("[Batch] Reference (scalar base64 + decodeStatusPayload): %.1f M frames/s (checksum %llu)\n",
+           frames.size() / referenceSeconds / 1e6, (unsigned long long)checksum);
+    return 0;
+}
+
+// ---- CSV conversion -----------------------------------------------------
+
+static int decodeFile(const char* path) {
+    FILE* in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "[Batch] [ERROR] Cannot open %s\n", path);
+        return 1;
+    }
+    std::vector<std::string> lines;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), in)) {
+        size_t length = strcspn(buffer, "\r\n");
+        lines.emplace_back(buffer, length);
+    }
+    if (in != stdin) fclose(in);
+
+    std::vector<Base64Frame> frames;
+    buildBatch(lines, frames);
+    StatusBatch batch;
+    batch.resize(frames.size());
+    size_t ok = decodeStatusBatch(frames.data(), 0, frames.size(), batch);
+
+    printf("result,uptime_s,free_heap_kb,rssi_dbm,snr_db,battery_mv,battery_pct,has_gps,latitude,longitude,"
+           "altitude,satellites,position_estimated,accuracy_m\n");
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (batch.result[i] != STATUS_BATCH_OK) {
+            printf("%s\n", batch.result[i] == STATUS_BATCH_BAD_BASE64 ? "bad_base64" : "too_short");
+            continue;
+        }
+        printf("ok,%u,%u,%d,%.2f,%u,%u,%u,%.7f,%.7f,%.1f,%u,%u,%u\n", batch.uptimeSeconds[i], batch.freeHeapKB[i],
+               batch.rssiDbm[i], batch.snrDb[i], batch.batteryMv[i], batch.batteryPercent[i], batch.hasGPS[i],
+               batch.latitude[i], batch.longitude[i], batch.altitude[i], batch.satellites[i],
+               batch.positionFlags[i] & STATUS_FLAG_ESTIMATED ? 1 : 0, batch.accuracyM[i]);
+    }
+    fprintf(stderr, "[Batch] Decoded %zu of %zu frames\n", ok, batch.size());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const char* jsPath = "../payload_decoder.js";
+    size_t conformance = 0, bench = 0;
+    const char* inputPath = "-";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--conformance") == 0 && i + 1 < argc) {
+            conformance = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--js") == 0 && i + 1 < argc) {
+            jsPath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (argv[i][0] == '-' && argv[i][1] != 0) {
+            fprintf(stderr, "Usage: %s [frames.txt | -]\n"
+                            "       %s --conformance N [--js ../payload_decoder.js]\n"
+                            "       %s --bench FRAMES [--threads N]\n", argv[0], argv[0], argv[0]);
+            return 1;
+        } else {
+            inputPath = argv[i];
+        }
+    }
+    if (conformance) return runConformance(conformance, jsPath);
+    if (bench) return runBenchmark(bench, threads);
+    return decodeFile(inputPath);
+}
@@ -0,0 +1,254 @@
+#ifndef SAMPLE_FILE_H
+#define SAMPLE_FILE_H
+
+// Host-side reader and writer for the coverage sample archive
+// (src/sample_archive.h), the same format the firmware logs to flash.
+//
+// The writer buffers SAMPLE_BLOCK_ROWS samples per block. The reader maps
+// the file, indexes the block headers (zone maps) without touching the
+// payloads, and decodes blocks on demand into a caller-owned buffer, so
+// each thread keeps one SampleBlockBuffer and queries skip whole blocks.
+// Tools using this header link ../src/sample_archive.cpp.
+
+#include "sample_archive.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAMPLE_BLOCK_ROWS       8192
+
+// Decoded view of one block
+struct SampleBlockView {
+    uint32_t rows;
+    const int64_t* timeMs;
+    const uint64_t* deviceEui;
+    const uint64_t* gatewayId;
+    const int32_t* latitudeE7;
+    const int32_t* longitudeE7;
+    const uint32_t* frameCounter;
+    const uint16_t* accuracyM;
+    const int16_t* rssi;
+    const int16_t* snrDeci;
+    const uint8_t* dataRate;
+    const uint8_t* gatewayCount;
+    const uint8_t* flags;
+
+    CoverageSample row(uint32_t i) const {
+        CoverageSample s;
+        s.timeMs = timeMs[i];
+        s.deviceEui = deviceEui[i];
+        s.gatewayId = gatewayId[i];
+        s.latitudeE7 = latitudeE7[i];
+        s.longitudeE7 = longitudeE7[i];
+        s.frameCounter = frameCounter[i];
+        s.accuracyM = accuracyM[i];
+        s.rssi = rssi[i];
+        s.snrDeci = snrDeci[i];
+        s.dataRate = dataRate[i];
+        s.gatewayCount = gatewayCount[i];
+        s.flags = flags[i];
+        return s;
+    }
+};
+
+// Per-thread decode target
+struct SampleBlockBuffer {
+    std::vector<int64_t> timeMs;
+    std::vector<uint64_t> deviceEui;
+    std::vector<uint64_t> gatewayId;
+    std::vector<int32_t> latitudeE7;
+    std::vector<int32_t> longitudeE7;
+    std::vector<uint32_t> frameCounter;
+    std::vector<uint16_t> accuracyM;
+    std::vector<int16_t> rssi;
+    std::vector<int16_t> snrDeci;
+    std::vector<uint8_t> dataRate;
+    std::vector<uint8_t> gatewayCount;
+    std::vector<uint8_t> flags;
+
+    void resize(uint32_t rows) {
+        if (timeMs.size() >= rows) return;
+        timeMs.resize(rows);
+        deviceEui.resize(rows);
+        gatewayId.resize(rows);
+        latitudeE7.resize(rows);
+        longitudeE7.resize(rows);
+        frameCounter.resize(rows);
+        accuracyM.resize(rows);
+        rssi.resize(rows);
+        snrDeci.resize(rows);
+        dataRate.resize(rows);
+        gatewayCount.resize(rows);
+        flags.resize(rows);
+    }
+
+    ArchiveColumns columns() {
+        ArchiveColumns c = {timeMs.data(), deviceEui.data(), gatewayId.data(), latitudeE7.data(),
+                            longitudeE7.data(), frameCounter.data(), accuracyM.data(), rssi.data(),
+                            snrDeci.data(), dataRate.data(), gatewayCount.data(), flags.data()};
+        return c;
+    }
+
+    SampleBlockView view(uint32_t rows) const {
+        SampleBlockView v = {rows, timeMs.data(), deviceEui.data(), gatewayId.data(), latitudeE7.data(),
+                             longitudeE7.data(), frameCounter.data(), accuracyM.data(), rssi.data(),
+                             snrDeci.data(), dataRate.data(), gatewayCount.data(), flags.data()};
+        return v;
+    }
+};
+
+class SampleFileWriter {
+private:
+    FILE* file;
+    std::vector<CoverageSample> pending;
+    std::vector<uint8_t> encoded;
+    uint64_t written;
+    uint64_t bytesWritten;
+
+public:
+    SampleFileWriter() : file(nullptr), written(0), bytesWritten(0) {}
+    ~SampleFileWriter() { close(); }
+
+    bool open(const char* path) {
+        file = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+        if (!file) return false;
+        uint8_t header[ARCHIVE_FILE_HEADER_SIZE];
+        writeArchiveFileHeader(header);
+        fwrite(header, 1, sizeof(header), file);
+        bytesWritten = sizeof(header);
+        pending.reserve(SAMPLE_BLOCK_ROWS);
+        encoded.resize(ARCHIVE_MAX_BLOCK_SIZE(SAMPLE_BLOCK_ROWS));
+        return true;
+    }
+
+    void append(const CoverageSample& sample) {
+        pending.push_back(sample);
+        if (pending.size() == SAMPLE_BLOCK_ROWS) flush();
+    }
+
+    void flush() {
+        if (!file || pending.empty()) return;
+        size_t size = encodeArchiveBlock(pending.data(), (uint32_t)pending.size(), encoded.data(), encoded.size());
+        fwrite(encoded.data(), 1, size, file);
+        bytesWritten += size;
+        written += pending.size();
+        pending.clear();
+    }
+
+    void close() {
+        if (!file) return;
+        flush();
+        if (file != stdout) fclose(file); else fflush(file);
+        file = nullptr;
+    }
+
+    uint64_t getWrittenCount() const { return written + pending.size(); }
+    uint64_t getBytesWritten() const { return bytesWritten; }
+};
+
+class SampleFileReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t cursor;
+    std::vector<ArchiveBlockInfo> blocks;
+    std::vector<size_t> payloadOffsets;
+    uint64_t totalRows;
+
+public:
+    SampleFileReader() : data(nullptr), size(0), cursor(0), totalRows(0) {}
+    ~SampleFileReader() { close(); }
+
+    bool open(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < ARCHIVE_FILE_HEADER_SIZE) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = (const uint8_t*)mapped;
+        if (!checkArchiveFileHeader(data, size)) {
+            close();
+            return false;
+        }
+
+        // Index the block headers; payloads stay untouched until decoded
+        size_t at = ARCHIVE_FILE_HEADER_SIZE;
+        ArchiveBlockInfo block;
+        while (parseArchiveBlockHeader(data + at, size - at, block)) {
+            blocks.push_back(block);
+            payloadOffsets.push_back(at + ARCHIVE_BLOCK_HEADER_SIZE);
+            totalRows += block.rows;
+            at += ARCHIVE_BLOCK_HEADER_SIZE + block.payloadBytes;
+        }
+        if (at != size) {
+            fprintf(stderr, "[Archive] [WARN] Ignoring %zu trailing bytes (torn or foreign block)\n", size - at);
+        }
+        return true;
+    }
+
+    void close() {
+        if (data) munmap((void*)data, size);
+        data = nullptr;
+        size = 0;
+        blocks.clear();
+        payloadOffsets.clear();
+        totalRows = 0;
+    }
+
+    size_t blockCount() const { return blocks.size(); }
+    const ArchiveBlockInfo& block(size_t index) const { return blocks[index]; }
+    uint64_t getRowCount() const { return totalRows; }
+    size_t getFileSize() const { return size; }
+
+    // Decodes block `index` into `buffer`; false on CRC mismatch
+    bool decodeBlock(size_t index, SampleBlockBuffer& buffer, SampleBlockView& view) const {
+        const ArchiveBlockInfo& info = blocks[index];
+        buffer.resize(info.rows);
+        if (!decodeArchiveBlock(info, data + payloadOffsets[index], buffer.columns())) {
+            fprintf(stderr, "[Archive] [ERROR] Block %zu failed its CRC or is corrupt\n", index);
+            return false;
+        }
+        view = buffer.view(info.rows);
+        return true;
+    }
+
+    // Blocks whose zone map overlaps the query
+    std::vector<size_t> blocksMatching(const ArchiveQuery& query) const {
+        std::vector<size_t> matching;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            if (query.mayMatch(blocks[i])) matching.push_back(i);
+        }
+        return matching;
+    }
+
+    std::vector<size_t> allBlocks() const {
+        std::vector<size_t> all(blocks.size());
+        for (size_t i = 0; i < all.size(); i++) all[i] = i;
+        return all;
+    }
+
+    // Sequential scan
+    void rewind() { cursor = 0; }
+
+    bool nextBlock(SampleBlockBuffer& buffer, SampleBlockView& view) {
+        while (cursor < blocks.size()) {
+            if (decodeBlock(cursor++, buffer, view)) return true;
+        }
+        return false;
+    }
+};
+
+#endif // SAMPLE_FILE_H
@@ -0,0 +1,132 @@
+#ifndef STATUS_BATCH_H
+#define STATUS_BATCH_H
+
+// Batch decoder for status uplinks (port 3) straight from ChirpStack's
+// base64 `data` strings into struct-of-arrays columns. Field layout and
+// length rules are those of src/payload_codec.h (and payload_decoder.js):
+// the GPS block needs 24 bytes, position quality 27; shorter than 11 bytes
+// is an error, and STATUS_FLAG_NO_POSITION marks a zero-filled GPS block.
+// Only the first STATUS_BATCH_PREFIX_CHARS characters are decoded since
+// nothing past byte 27 is read (the latency block is not batched), so
+// trailing characters of longer frames are not validated. Frames are independent: callers can
+// split a batch across threads, each decoding its own row range.
+
+#include "base64.h"
+#include "payload_codec.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define STATUS_BATCH_PREFIX_CHARS   48      // 36 bytes, covers STATUS_POSITION_END
+
+#define STATUS_BATCH_OK             0
+#define STATUS_BATCH_BAD_BASE64     1
+#define STATUS_BATCH_TOO_SHORT      2
+
+// Column-per-field decode output; row i is frame i of the batch
+struct StatusBatch {
+    std::vector<uint8_t> result;            // STATUS_BATCH_*
+    std::vector<uint32_t> uptimeSeconds;
+    std::vector<uint16_t> freeHeapKB;
+    std::vector<int16_t> rssiDbm;
+    std::vector<float> snrDb;
+    std::vector<uint16_t> batteryMv;
+    std::vector<uint8_t> batteryPercent;
+    std::vector<uint8_t> hasGPS;
+    std::vector<float> latitude;
+    std::vector<float> longitude;
+    std::vector<float> altitude;
+    std::vector<uint8_t> satellites;
+    std::vector<uint8_t> hasPositionQuality;
+    std::vector<uint8_t> positionFlags;
+    std::vector<uint16_t> accuracyM;
+
+    void resize(size_t count) {
+        result.resize(count);
+        uptimeSeconds.resize(count);
+        freeHeapKB.resize(count);
+        rssiDbm.resize(count);
+        snrDb.resize(count);
+        batteryMv.resize(count);
+        batteryPercent.resize(count);
+        hasGPS.resize(count);
+        latitude.resize(count);
+        longitude.resize(count);
+        altitude.resize(count);
+        satellites.resize(count);
+        hasPositionQuality.resize(count);
+        positionFlags.resize(count);
+        accuracyM.resize(count);
+    }
+
+    size_t size() const { return result.size(); }
+};
+
+// Frames as (pointer, length) views into caller memory, e.g. a mapped export
+struct Base64Frame {
+    const char* text;
+    uint32_t length;
+};
+
+static inline uint16_t statusLoadU16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t statusLoadU32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return __builtin_bswap32(value);
+}
+
+static inline float statusLoadFloat(const uint8_t* p) {
+    uint32_t bits = statusLoadU32(p);
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+}
+
+// Decodes frames[first, first + count) into rows [first, first + count) of
+// `out`, which must already be sized for them. Returns frames decoded OK.
+static inline size_t decodeStatusBatch(const Base64Frame* frames, size_t first, size_t count, StatusBatch& out) {
+    // 16 bytes of slack past the prefix for the vector store
+    uint8_t bytes[STATUS_BATCH_PREFIX_CHARS / 4 * 3 + 16];
+    size_t ok = 0;
+    for (size_t i = first; i < first + count; i++) {
+        uint32_t used = frames[i].length > STATUS_BATCH_PREFIX_CHARS ? STATUS_BATCH_PREFIX_CHARS : frames[i].length;
+        long length = base64Decode(frames[i].text, used, bytes, sizeof(bytes));
+        if (length < 0) {
+            out.result[i] = STATUS_BATCH_BAD_BASE64;
+            continue;
+        }
+        if (length < STATUS_BASE_SIZE) {
+            out.result[i] = STATUS_BATCH_TOO_SHORT;
+            continue;
+        }
+
+        out.result[i] = STATUS_BATCH_OK;
+        out.uptimeSeconds[i] = statusLoadU32(bytes);
+        out.freeHeapKB[i] = statusLoadU16(bytes + 4);
+        out.rssiDbm[i] = (int16_t)(bytes[6] - 200);
+        out.snrDb[i] = ((int)bytes[7] - 128) / 4.0f;
+        out.batteryMv[i] = statusLoadU16(bytes + 8);
+        out.batteryPercent[i] = bytes[10];
+
+        bool quality = length >= STATUS_POSITION_END;
+        bool gps = length >= STATUS_BASE_SIZE + STATUS_GPS_SIZE && !(quality && (bytes[24] & STATUS_FLAG_NO_POSITION));
+        quality = quality && gps;
+        out.hasGPS[i] = gps;
+        out.latitude[i] = gps ? statusLoadFloat(bytes + 11) : 0.0f;
+        out.longitude[i] = gps ? statusLoadFloat(bytes + 15) : 0.0f;
+        out.altitude[i] = gps ? statusLoadFloat(bytes + 19) : 0.0f;
+        out.satellites[i] = gps ? bytes[23] : 0;
+        out.hasPositionQuality[i] = quality;
+        out.positionFlags[i] = length >= STATUS_POSITION_END ? bytes[24] : 0;
+        out.accuracyM[i] = quality ? statusLoadU16(bytes + 25) : 0;
+        ok++;
+    }
+    return ok;
+}
+
+#endif // STATUS_BATCH_H
@@ -0,0 +1,509 @@
+/**
+ * LoRa Gateway Sniffer - Telemetry Decoder
+ *
+ * Splits the firmware's serial stream into console text and binary
+ * telemetry records (src/telemetry.h: COBS frames with CRC-16, enabled
+ * with the `telemetry` serial command), filters them by type and writes
+ * one CSV per record type and/or a columnar sample archive with one row
+ * per successful uplink at the last reported position.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o telemetry_decode telemetry_decode.cpp \
+ *       ../src/telemetry.cpp ../src/perf_stats.cpp ../src/sample_archive.cpp
+ *
+ * Usage:
+ *   telemetry_decode [--types gps,uplink,perf,battery,system] [--csv PREFIX]
+ *                    [--archive samples.lgss] [--device-eui HEX] [--text PATH] INPUT
+ *       INPUT is a capture file, '-' for stdin, or the serial device itself
+ *       (/dev/ttyACM0), which is switched to raw mode. Console text goes to
+ *       stderr unless --text names a file ('-' = stdout). --csv writes
+ *       PREFIX_<type>.csv for every selected type that occurs.
+ *   telemetry_decode --bench RECORDS [--corrupt PERMILLE]
+ *       Decodes a synthetic capture of interleaved text and records, checks
+ *       that every record and every text byte comes back, and reports MB/s.
+ *       --corrupt flips bytes to exercise resynchronisation.
+ */
+
+#include "telemetry.h"
+#include "perf_stats.h"
+#include "sample_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#define READ_BUFFER_SIZE    (64 * 1024)
+
+static const char* TYPE_NAMES[] = {"", "gps", "uplink", "perf", "battery", "system"};
+#define TYPE_COUNT  6
+
+static const char* CSV_HEADERS[TYPE_COUNT] = {
+    "",
+    "uptime_ms,seq,unix_time_ms,latitude,longitude,altitude_m,speed_mps,course_deg,hdop,accuracy_m,satellites,valid,estimated\n",
+    "uptime_ms,seq,fcnt,port,length,confirmed,success,state,duration_ms,rssi,snr\n",
+    "uptime_ms,seq,probe,count,min_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_ms\n",
+    "uptime_ms,seq,millivolts,percent\n",
+    "uptime_ms,seq,free_heap,min_free_heap,dropped_frames,core0_load,core1_load,main,gps,lora,display,logging,serial\n"
+};
+
+struct DecodeOptions {
+    bool selected[TYPE_COUNT];
+    const char* csvPrefix;
+    const char* archivePath;
+    uint64_t deviceEui;
+    FILE* text;
+
+    DecodeOptions() : csvPrefix(nullptr), archivePath(nullptr), deviceEui(0), text(stderr) {
+        for (int i = 0; i < TYPE_COUNT; i++) selected[i] = i > 0;
+    }
+};
+
+// Stream sink: routes text and records to the requested outputs
+class RecordWriter {
+private:
+    const DecodeOptions& options;
+    FILE* csv[TYPE_COUNT];
+    SampleFileWriter archive;
+    bool archiveOpen;
+
+    bool haveSequence;
+    uint16_t lastSequence;
+    bool haveFix;
+    TelemetryHeader fixHeader;
+    TelemetryGpsFix lastFix;
+
+    // Perf histograms can span records; pairs collect until the last part
+    TelemetryPerf part;
+    std::vector<uint16_t> perfBuckets;
+    std::vector<uint32_t> perfCounts;
+
+    FILE* csvFor(uint8_t type) {
+        if (!options.csvPrefix) return nullptr;
+        if (!csv[type]) {
+            std::string path = std::string(options.csvPrefix) + "_" + TYPE_NAMES[type] + ".csv";
+            csv[type] = fopen(path.c_str(), "w");
+            if (!csv[type]) {
+                fprintf(stderr, "[Telemetry] [ERROR] Cannot write %s\n", path.c_str());
+                return nullptr;
+            }
+            fputs(CSV_HEADERS[type], csv[type]);
+        }
+        return csv[type];
+    }
+
+    void writeGpsFix(const TelemetryHeader& header, const uint8_t* record, size_t length) {
+        TelemetryGpsFix fix;
+        if (!telemetryDecodeGpsFix(record, length, fix)) {
+            malformed++;
+            return;
+        }
+        haveFix = (fix.flags & (TELEMETRY_GPS_VALID | TELEMETRY_GPS_ESTIMATED)) != 0;
+        fixHeader = header;
+        lastFix = fix;
+        FILE* out = csvFor(TELEMETRY_GPS_FIX);
+        if (!out) return;
+        fprintf(out, "%u,%u,%lld,%.7f,%.7f,%.2f,%.2f,%.2f,%.2f,%u,%u,%u,%u\n", header.uptimeMs, header.sequence,
+                (long long)fix.unixTimeMs, fix.latitudeE7 / 1e7, fix.longitudeE7 / 1e7, fix.altitudeCm / 100.0,
+                fix.speedCmps / 100.0, fix.courseCentiDeg / 100.0, fix.hdopCenti / 100.0, fix.accuracyM,
+                fix.satellites, fix.flags & TELEMETRY_GPS_VALID ? 1 : 0, fix.flags & TELEMETRY_GPS_ESTIMATED ? 1 : 0);
+    }
+
+    void writeUplink(const TelemetryHeader& header, const uint8_t* record, size_t length) {
+        TelemetryUplink uplink;
+        if (!telemetryDecodeUplink(record, length, uplink)) {
+            malformed++;
+            return;
+        }
+        bool success = uplink.flags & TELEMETRY_UPLINK_SUCCESS;
+        FILE* out = csvFor(TELEMETRY_UPLINK);
+        if (out) {
+            fprintf(out, "%u,%u,%u,%u,%u,%u,%u,%d,%.3f,%d,%.1f\n", header.uptimeMs, header.sequence,
+                    uplink.frameCounter, uplink.port, uplink.length, uplink.flags & TELEMETRY_UPLINK_CONFIRMED ? 1 : 0,
+                    success ? 1 : 0, uplink.state, uplink.durationUs / 1000.0, uplink.rssi, uplink.snrDeci / 10.0);
+        }
+        if (archiveOpen && success && haveFix && lastFix.unixTimeMs != 0) {
+            CoverageSample sample;
+            sample.timeMs = lastFix.unixTimeMs + (int64_t)(header.uptimeMs - fixHeader.uptimeMs);
+            sample.deviceEui = options.deviceEui;
+            sample.gatewayId = 0;
+            sample.latitudeE7 = lastFix.latitudeE7;
+            sample.longitudeE7 = lastFix.longitudeE7;
+            sample.frameCounter = uplink.frameCounter;
+            sample.accuracyM = lastFix.accuracyM;
+            sample.rssi = uplink.rssi;
+            sample.snrDeci = uplink.snrDeci;
+            sample.dataRate = SAMPLE_DATA_RATE_UNKNOWN;
+            sample.gatewayCount = 0;
+            sample.flags = SAMPLE_FLAG_POSITION | (options.deviceEui ? SAMPLE_FLAG_DEVICE : 0) |
+                           (lastFix.flags & TELEMETRY_GPS_VALID ? 0 : SAMPLE_FLAG_ESTIMATED);
+            archive.append(sample);
+            archivedRows++;
+        }
+    }
+
+    void writePerf(const TelemetryHeader& header, const uint8_t* record, size_t length) {
+        if (!telemetryDecodePerf(record, length, part)) {
+            malformed++;
+            return;
+        }
+        perfBuckets.insert(perfBuckets.end(), part.buckets, part.buckets + part.pairs);
+        perfCounts.insert(perfCounts.end(), part.counts, part.counts + part.pairs);
+        if (!(part.flags & TELEMETRY_PERF_LAST_PART)) return;
+
+        PerfHistogram histogram;
+        histogram.restore(perfBuckets.data(), perfCounts.data(), perfBuckets.size(), part.minNs, part.maxNs, part.sumNs);
+        perfBuckets.clear();
+        perfCounts.clear();
+        FILE* out = csvFor(TELEMETRY_PERF);
+        if (!out) return;
+        const char* name = part.probe < PERF_PROBE_COUNT ? perfProbeName((PerfProbe)part.probe) : "unknown";
+        fprintf(out, "%u,%u,%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", header.uptimeMs, header.sequence, name,
+                histogram.getCount(), histogram.getMinNs() / 1e6, histogram.percentileNs(0.50f) / 1e6,
+                histogram.percentileNs(0.90f) / 1e6, histogram.percentileNs(0.99f) / 1e6,
+                histogram.getMaxNs() / 1e6, histogram.getMeanNs() / 1e6);
+    }
+
+    void writeBattery(const TelemetryHeader& header, const uint8_t* record, size_t length) {
+        TelemetryBattery battery;
+        if (!telemetryDecodeBattery(record, length, battery)) {
+            malformed++;
+            return;
+        }
+        FILE* out = csvFor(TELEMETRY_BATTERY);
+        if (out) fprintf(out, "%u,%u,%u,%u\n", header.uptimeMs, header.sequence, battery.millivolts, battery.percent);
+    }
+
+    void writeSystem(const TelemetryHeader& header, const uint8_t* record, size_t length) {
+        TelemetrySystem system;
+        if (!telemetryDecodeSystem(record, length, system)) {
+            malformed++;
+            return;
+        }
+        FILE* out = csvFor(TELEMETRY_SYSTEM);
+        if (!out) return;
+        fprintf(out, "%u,%u,%u,%u,%u,%u,%u", header.uptimeMs, header.sequence, system.freeHeap,
+                system.minFreeHeap, system.droppedFrames, system.coreLoad[0], system.coreLoad[1]);
+        for (int i = 0; i < TELEMETRY_SUBSYSTEMS; i++) fprintf(out, ",%u", system.subsystemLoad[i]);
+        fputc('\n', out);
+    }
+
+public:
+    uint64_t records[TYPE_COUNT];
+    uint64_t unknown;
+    uint64_t malformed;
+    uint64_t sequenceGaps;      // Frames the device dropped or the link lost
+    uint64_t textBytes;
+    uint64_t archivedRows;
+    std::string* textCapture;   // Benchmark only
+
+    explicit RecordWriter(const DecodeOptions& decodeOptions) :
+        options(decodeOptions),
+        csv(),
+        archiveOpen(false),
+        haveSequence(false),
+        lastSequence(0),
+        haveFix(false),
+        fixHeader(),
+        lastFix(),
+        part(),
+        records(),
+        unknown(0),
+        malformed(0),
+        sequenceGaps(0),
+        textBytes(0),
+        archivedRows(0),
+        textCapture(nullptr) {
+    }
+
+    ~RecordWriter() {
+        for (int i = 0; i < TYPE_COUNT; i++) {
+            if (csv[i]) fclose(csv[i]);
+        }
+    }
+
+    bool openArchive(const char* path) {
+        archiveOpen = archive.open(path);
+        return archiveOpen;
+    }
+
+    void onText(const char* text, size_t length) {
+        textBytes += length;
+        if (textCapture) textCapture->append(text, length);
+        if (options.text) fwrite(text, 1, length, options.text);
+    }
+
+    void onRecord(const uint8_t* record, size_t length) {
+        TelemetryHeader header;
+        if (!telemetryDecodeHeader(record, length, header)) {
+            malformed++;
+            return;
+        }
+        if (haveSequence) sequenceGaps += (uint16_t)(header.sequence - lastSequence - 1);
+        haveSequence = true;
+        lastSequence = header.sequence;
+
+        if (header.type == 0 || header.type >= TYPE_COUNT) {
+            unknown++;
+            return;
+        }
+        records[header.type]++;
+        // GPS fixes are always decoded: archive rows need the last position
+        if (!options.selected[header.type] && !(header.type == TELEMETRY_GPS_FIX && archiveOpen)) return;
+
+        switch (header.type) {
+            case TELEMETRY_GPS_FIX:
+                writeGpsFix(header, record, length);
+                break;
+            case TELEMETRY_UPLINK:
+                writeUplink(header, record, length);
+                break;
+            case TELEMETRY_PERF:
+                writePerf(header, record, length);
+                break;
+            case TELEMETRY_BATTERY:
+                writeBattery(header, record, length);
+                break;
+            case TELEMETRY_SYSTEM:
+                writeSystem(header, record, length);
+                break;
+        }
+    }
+
+    void printSummary(uint32_t rejected) const {
+        fprintf(stderr, "[Telemetry] Records:");
+        for (int i = 1; i < TYPE_COUNT; i++) fprintf(stderr, " %s %llu", TYPE_NAMES[i], (unsigned long long)records[i]);
+        fprintf(stderr, "\n[Telemetry] %llu text bytes, %u non-frame chunks, %llu sequence gaps, %llu unknown, %llu malformed",
+                (unsigned long long)textBytes, rejected, (unsigned long long)sequenceGaps,
+                (unsigned long long)unknown, (unsigned long long)malformed);
+        if (archiveOpen) fprintf(stderr, ", %llu archive rows", (unsigned long long)archivedRows);
+        fputc('\n', stderr);
+    }
+};
+
+// USB CDC ignores the baud rate, but a real UART behind a bridge does not
+static void makeRaw(int fd) {
+    struct termios tty;
+    if (!isatty(fd) || tcgetattr(fd, &tty) != 0) return;
+    cfmakeraw(&tty);
+    cfsetspeed(&tty, B115200);
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tty);
+}
+
+static int decodeInput(const char* path, const DecodeOptions& options) {
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "[Telemetry] [ERROR] Cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    makeRaw(fd);
+
+    RecordWriter writer(options);
+    if (options.archivePath && !writer.openArchive(options.archivePath)) {
+        fprintf(stderr, "[Telemetry] [ERROR] Cannot write sample archive %s\n", options.archivePath);
+        return 1;
+    }
+    static TelemetryStreamDecoder decoder;
+    std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        ssize_t got = read(fd, buffer.data(), buffer.size());
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        total += got;
+        decoder.feed(buffer.data(), got, writer);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (fd != STDIN_FILENO) close(fd);
+
+    writer.printSummary(decoder.getRejected());
+    fprintf(stderr, "[Telemetry] %llu bytes in %.3f s (%.1f MB/s)\n", (unsigned long long)total, seconds,
+            seconds > 0 ? total / seconds / 1e6 : 0.0);
+    return 0;
+}
+
+// Capture of text lines and records in the firmware's proportions
+static size_t buildCapture(uint64_t records, std::vector<uint8_t>& capture, std::string& text, uint64_t* expected) {
+    std::mt19937_64 rng(7);
+    uint8_t record[TELEMETRY_MAX_RECORD];
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    uint32_t uptime = 0;
+    char line[160];
+    for (uint64_t i = 0; i < records; i++) {
+        TelemetryHeader header;
+        header.sequence = (uint16_t)i;
+        header.uptimeMs = uptime += 250;
+        size_t length = 0;
+        int type = 1 + (int)(rng() % 10 < 6 ? 0 : 1 + rng() % 4);
+        if (type == TELEMETRY_GPS_FIX) {
+            TelemetryGpsFix fix = {};
+            fix.unixTimeMs = 1760000000000LL + uptime;
+            fix.latitudeE7 = 454000000 + (int32_t)(rng() % 100000);
+            fix.longitudeE7 = -1226000000 - (int32_t)(rng() % 100000);
+            fix.satellites = 9;
+            fix.accuracyM = 4;
+            fix.flags = TELEMETRY_GPS_VALID;
+            length = telemetryEncodeGpsFix(record, header, fix);
+        } else if (type == TELEMETRY_UPLINK) {
+            TelemetryUplink uplink = {};
+            uplink.frameCounter = (uint32_t)i;
+            uplink.durationUs = 1500000 + rng() % 500000;
+            uplink.rssi = -(int16_t)(60 + rng() % 60);
+            uplink.snrDeci = (int16_t)(rng() % 200) - 100;
+            uplink.port = 3;
+            uplink.length = 27;
+            uplink.flags = TELEMETRY_UPLINK_SUCCESS;
+            length = telemetryEncodeUplink(record, header, uplink);
+        } else if (type == TELEMETRY_PERF) {
+            TelemetryPerf perf = {};
+            perf.probe = rng() % PERF_PROBE_COUNT;
+            perf.flags = TELEMETRY_PERF_LAST_PART;
+            perf.pairs = 1 + rng() % TELEMETRY_PERF_MAX_PAIRS;
+            for (int p = 0; p < perf.pairs; p++) {
+                perf.buckets[p] = (uint16_t)(80 + p);
+                perf.counts[p] = (uint32_t)(rng() % 1000);
+                perf.count += perf.counts[p];
+            }
+            perf.minNs = 1000;
+            perf.maxNs = 5000000;
+            perf.sumNs = (uint64_t)perf.count * 20000;
+            length = telemetryEncodePerf(record, header, perf);
+        } else if (type == TELEMETRY_BATTERY) {
+            TelemetryBattery battery = {3900, 80};
+            length = telemetryEncodeBattery(record, header, battery);
+        } else {
+            TelemetrySystem system = {};
+            system.freeHeap = 200000;
+            length = telemetryEncodeSystem(record, header, system);
+        }
+        expected[type]++;
+        size_t frameLength = telemetryFrame(record, length, frame);
+        capture.insert(capture.end(), frame, frame + frameLength);
+
+        if (rng() % 3 == 0) {
+            int n = snprintf(line, sizeof(line), "[LoRa] [DEBUG] (sendData) After uplink: isActivated=1, fCntUp=%llu\n",
+                             (unsigned long long)i);
+            capture.insert(capture.end(), line, line + n);
+            text.append(line, n);
+        }
+    }
+    return capture.size();
+}
+
+static int runBenchmark(uint64_t records, int corruptPermille) {
+    std::vector<uint8_t> capture;
+    std::string expectedText;
+    uint64_t expected[TYPE_COUNT] = {0};
+    buildCapture(records, capture, expectedText, expected);
+    uint64_t corrupted = 0;
+    if (corruptPermille > 0) {
+        std::mt19937_64 rng(11);
+        for (size_t i = 0; i < capture.size(); i++) {
+            if ((int)(rng() % 1000) < corruptPermille) {
+                capture[i] ^= (uint8_t)(1 + rng() % 255);
+                corrupted++;
+            }
+        }
+    }
+
+    DecodeOptions options;
+    options.text = nullptr;
+    RecordWriter writer(options);
+    std::string text;
+    writer.textCapture = &text;
+    text.reserve(expectedText.size() + 1024);
+
+    static TelemetryStreamDecoder decoder;
+    auto start = std::chrono::steady_clock::now();
+    // Feed in USB-sized reads so frames straddle buffer boundaries
+    for (size_t offset = 0; offset < capture.size(); offset += 512) {
+        size_t chunk = std::min<size_t>(512, capture.size() - offset);
+        decoder.feed(capture.data() + offset, chunk, writer);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    writer.printSummary(decoder.getRejected());
+    uint64_t decoded = 0;
+    bool countsMatch = true;
+    for (int i = 1; i < TYPE_COUNT; i++) {
+        decoded += writer.records[i];
+        if (writer.records[i] != expected[i]) countsMatch = false;
+    }
+    fprintf(stderr, "[Telemetry] %zu bytes, %llu records in %.3f s: %.1f MB/s, %.2f M records/s\n", capture.size(),
+            (unsigned long long)decoded, seconds, capture.size() / seconds / 1e6, decoded / seconds / 1e6);
+
+    if (corruptPermille > 0) {
+        fprintf(stderr, "[Telemetry] %llu bytes corrupted: %llu of %llu records recovered, %llu malformed\n",
+                (unsigned long long)corrupted, (unsigned long long)decoded, (unsigned long long)records,
+                (unsigned long long)writer.malformed);
+        return 0;
+    }
+    if (!countsMatch || text != expectedText || writer.sequenceGaps != 0) {
+        fprintf(stderr, "[Telemetry] [ERROR] Round trip mismatch (records %s, text %s, gaps %llu)\n",
+                countsMatch ? "ok" : "differ", text == expectedText ? "ok" : "differs",
+                (unsigned long long)writer.sequenceGaps);
+        return 1;
+    }
+    fprintf(stderr, "[Telemetry] Round trip OK: every record and text byte recovered\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    DecodeOptions options;
+    const char* inputPath = nullptr;
+    uint64_t benchRecords = 0;
+    int corruptPermille = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--types") == 0 && i + 1 < argc) {
+            for (int t = 0; t < TYPE_COUNT; t++) options.selected[t] = false;
+            char* list = argv[++i];
+            for (char* name = strtok(list, ","); name; name = strtok(nullptr, ",")) {
+                int t = 1;
+                while (t < TYPE_COUNT && strcmp(name, TYPE_NAMES[t]) != 0) t++;
+                if (t == TYPE_COUNT) {
+                    fprintf(stderr, "[Telemetry] [ERROR] Unknown record type '%s'\n", name);
+                    return 1;
+                }
+                options.selected[t] = true;
+            }
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            options.csvPrefix = argv[++i];
+        } else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            options.archivePath = argv[++i];
+        } else if (strcmp(argv[i], "--device-eui") == 0 && i + 1 < argc) {
+            options.deviceEui = strtoull(argv[++i], nullptr, 16);
+        } else if (strcmp(argv[i], "--text") == 0 && i + 1 < argc) {
+            const char* path = argv[++i];
+            options.text = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+            if (!options.text) {
+                fprintf(stderr, "[Telemetry] [ERROR] Cannot write %s\n", path);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchRecords = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--corrupt") == 0 && i + 1 < argc) {
+            corruptPermille = atoi(argv[++i]);
+        } else {
+            inputPath = argv[i];
+        }
+    }
+    if (benchRecords) return runBenchmark(benchRecords, corruptPermille);
+    if (!inputPath) {
+        fprintf(stderr, "Usage: %s [--types gps,uplink,perf,battery,system] [--csv PREFIX]\n"
+                        "          [--archive samples.lgss] [--device-eui HEX] [--text PATH] INPUT\n"
+                        "       %s --bench RECORDS [--corrupt PERMILLE]\n", argv[0], argv[0]);
+        return 1;
+    }
+    return decodeInput(inputPath, options);
+}
@@ -0,0 +1,304 @@
+/**
+ * LoRa Gateway Sniffer - Uplink Load Generator
+ *
+ * Plays a synthetic fleet of sniffers against coverage_daemon: each device
+ * random-walks around a start point and sends port 3 status uplinks encoded
+ * with the firmware codec, wrapped in single-line ChirpStack up events with
+ * 1-4 receiving gateways. Events go out as UDP datagrams or as MQTT QoS 0
+ * PUBLISHes on application/<id>/device/<devEui>/event/up.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -I../src -o uplink_loadgen uplink_loadgen.cpp ../src/payload_codec.cpp
+ *
+ * Usage:
+ *   uplink_loadgen (--udp HOST:PORT | --mqtt HOST:PORT) [--rate N] [--seconds S]
+ *                  [--devices D] [--gateways G] [--seed N]
+ *
+ *   --rate 0 sends as fast as the socket takes them.
+ */
+
+#include "payload_codec.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LOADGEN_BATCH           64      // Datagrams per sendmmsg / events per MQTT write
+#define LOADGEN_TICK_US         1000
+
+static const char* BASE64_ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void base64Encode(const uint8_t* data, size_t length, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < length) triple |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) triple |= data[i + 2];
+        out += BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        out += BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        out += i + 1 < length ? BASE64_ALPHABET[(triple >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? BASE64_ALPHABET[triple & 0x3F] : '=';
+    }
+}
+
+struct SimDevice {
+    uint64_t eui;
+    double latitude;
+    double longitude;
+    double heading;
+    uint32_t frameCounter;
+    uint32_t uptimeSeconds;
+};
+
+class Fleet {
+private:
+    std::vector<SimDevice> devices;
+    std::vector<uint64_t> gateways;
+    std::mt19937_64 random;
+    size_t next;
+    std::string encoded;
+
+public:
+    Fleet(size_t deviceCount, size_t gatewayCount, uint64_t seed) : random(seed), next(0) {
+        std::uniform_real_distribution<double> spread(-0.05, 0.05);
+        for (size_t i = 0; i < deviceCount; i++) {
+            devices.push_back(SimDevice{0x70B3D57ED0000000ULL + i, 41.5 + spread(random), -81.7 + spread(random),
+                                        std::uniform_real_distribution<double>(0, 2 * M_PI)(random), 0, 0});
+        }
+        for (size_t i = 0; i < gatewayCount; i++) gateways.push_back(0x0016C001F0000000ULL + i);
+    }
+
+    // Next event in round-robin device order as one line of JSON
+    const SimDevice& nextEvent(std::string& json) {
+        SimDevice& device = devices[next];
+        next = (next + 1) % devices.size();
+        std::normal_distribution<double> turn(0, 0.3);
+        device.heading += turn(random);
+        device.latitude += cos(device.heading) * 0.0003;
+        device.longitude += sin(device.heading) * 0.0004;
+        device.uptimeSeconds += 60;
+
+        StatusPayload status;
+        status.uptimeSeconds = device.uptimeSeconds;
+        status.freeHeapKB = 180;
+        status.rssiByte = StatusPayload::encodeRssi(-90);
+        status.snrByte = StatusPayload::encodeSnr(7.5f);
+        status.batteryMv = 3900;
+        status.batteryPercent = 80;
+        status.hasGPS = true;
+        status.latitude = (float)device.latitude;
+        status.longitude = (float)device.longitude;
+        status.altitude = 210;
+        status.satellites = 9;
+        status.hasPositionQuality = true;
+        status.accuracyM = 5;
+        uint8_t payload[STATUS_MAX_SIZE];
+        base64Encode(payload, encodeStatusPayload(status, payload, sizeof(payload)), encoded);
+
+        time_t now = time(nullptr);
+        struct tm utc;
+        gmtime_r(&now, &utc);
+        char timestamp[40];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S.000+00:00", &utc);
+
+        char head[512];
+        snprintf(head, sizeof(head),
+                 "{\"time\":\"%s\",\"deviceInfo\":{\"deviceName\":\"Gateway Sniffer\",\"devEui\":\"%016llx\"},"
+                 "\"dr\":%u,\"fCnt\":%u,\"fPort\":3,\"confirmed\":false,\"data\":\"%s\",\"rxInfo\":[",
+                 timestamp, (unsigned long long)device.eui, (unsigned)(random() % 4), device.frameCounter++,
+                 encoded.c_str());
+        json = head;
+        size_t heard = 1 + random() % std::min<size_t>(4, gateways.size());
+        size_t first = random() % gateways.size();
+        for (size_t i = 0; i < heard; i++) {
+            char gateway[160];
+            snprintf(gateway, sizeof(gateway), "%s{\"gatewayId\":\"%016llx\",\"rssi\":%d,\"snr\":%.1f}",
+                     i ? "," : "", (unsigned long long)gateways[(first + i) % gateways.size()],
+                     -60 - (int)(random() % 60), (int)(random() % 200) / 10.0 - 8.0);
+            json += gateway;
+        }
+        json += "]}";
+        return device;
+    }
+};
+
+static bool resolve(const char* hostPort, struct sockaddr_in& address) {
+    std::string text(hostPort);
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos) return false;
+    struct addrinfo hints, *result = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(text.substr(0, colon).c_str(), text.substr(colon + 1).c_str(), &hints, &result) != 0) return false;
+    memcpy(&address, result->ai_addr, sizeof(address));
+    freeaddrinfo(result);
+    return true;
+}
+
+static void appendRemainingLength(std::string& packet, size_t length) {
+    do {
+        uint8_t byte = length & 0x7F;
+        length >>= 7;
+        if (length) byte |= 0x80;
+        packet += (char)byte;
+    } while (length);
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+static int connectMqtt(const struct sockaddr_in& address) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const struct sockaddr*)&address, sizeof(address)) != 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    static const char clientId[] = "uplink-loadgen";
+    std::string body("\x00\x04MQTT\x04\x02\x00\x3C", 10);     // MQTT 3.1.1, clean session, 60 s keepalive
+    body += (char)0;
+    body += (char)(sizeof(clientId) - 1);
+    body += clientId;
+    std::string packet(1, (char)0x10);
+    appendRemainingLength(packet, body.size());
+    packet += body;
+    uint8_t connack[4];
+    if (!sendAll(fd, packet) || recv(fd, connack, sizeof(connack), MSG_WAITALL) != 4 || connack[0] != 0x20 ||
+        connack[3] != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    const char* udpTarget = nullptr;
+    const char* mqttTarget = nullptr;
+    double rate = 10000;
+    double seconds = 10;
+    size_t deviceCount = 1000, gatewayCount = 50;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--udp") == 0 && hasValue) udpTarget = argv[++i];
+        else if (strcmp(argv[i], "--mqtt") == 0 && hasValue) mqttTarget = argv[++i];
+        else if (strcmp(argv[i], "--rate") == 0 && hasValue) rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue) seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--devices") == 0 && hasValue) deviceCount = (size_t)std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--gateways") == 0 && hasValue) gatewayCount = (size_t)std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "Usage: %s (--udp HOST:PORT | --mqtt HOST:PORT) [--rate N] [--seconds S]\n"
+                            "          [--devices D] [--gateways G] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+    struct sockaddr_in address;
+    if ((!udpTarget) == (!mqttTarget) || !resolve(udpTarget ? udpTarget : mqttTarget, address)) {
+        fprintf(stderr, "[Loadgen] [ERROR] Give exactly one reachable --udp or --mqtt HOST:PORT\n");
+        return 1;
+    }
+
+    int fd = udpTarget ? socket(AF_INET, SOCK_DGRAM, 0) : connectMqtt(address);
+    if (fd < 0 || (udpTarget && connect(fd, (const struct sockaddr*)&address, sizeof(address)) != 0)) {
+        fprintf(stderr, "[Loadgen] [ERROR] Cannot connect to %s\n", udpTarget ? udpTarget : mqttTarget);
+        return 1;
+    }
+
+    Fleet fleet(deviceCount, gatewayCount, seed);
+    std::vector<std::string> events(LOADGEN_BATCH);
+    std::string mqttBatch;
+    uint64_t sent = 0, failed = 0;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    double credit = 0;
+    auto lastTick = start;
+
+    fprintf(stderr, "[Loadgen] %zu devices, %zu gateways, %s over %s for %.0f s at %s events/s\n", deviceCount,
+            gatewayCount, udpTarget ? udpTarget : mqttTarget, udpTarget ? "UDP" : "MQTT", seconds,
+            rate > 0 ? std::to_string((long long)rate).c_str() : "max");
+    while (std::chrono::steady_clock::now() < deadline) {
+        // Token bucket refilled every tick; unpaced runs always send a full batch
+        auto now = std::chrono::steady_clock::now();
+        size_t due = LOADGEN_BATCH;
+        if (rate > 0) {
+            credit = std::min(credit + std::chrono::duration<double>(now - lastTick).count() * rate, rate);
+            lastTick = now;
+            if (credit < 1) {
+                std::this_thread::sleep_for(std::chrono::microseconds(LOADGEN_TICK_US));
+                continue;
+            }
+            due = std::min<size_t>(LOADGEN_BATCH, (size_t)credit);
+            credit -= due;
+        }
+
+        for (size_t i = 0; i < due; i++) {
+            const SimDevice& device = fleet.nextEvent(events[i]);
+            bytes += events[i].size();
+            if (mqttTarget) {
+                char topic[96];
+                int topicLength = snprintf(topic, sizeof(topic),
+                                           "application/e846ed91-61de-4605-a1b1-9738d526680d/device/%016llx/event/up",
+                                           (unsigned long long)device.eui);
+                mqttBatch += (char)0x30;
+                appendRemainingLength(mqttBatch, 2 + topicLength + events[i].size());
+                mqttBatch += (char)(topicLength >> 8);
+                mqttBatch += (char)(topicLength & 0xFF);
+                mqttBatch.append(topic, topicLength);
+                mqttBatch += events[i];
+            }
+        }
+
+        if (mqttTarget) {
+            if (!sendAll(fd, mqttBatch)) {
+                fprintf(stderr, "[Loadgen] [ERROR] MQTT connection lost: %s\n", strerror(errno));
+                break;
+            }
+            sent += due;
+            mqttBatch.clear();
+        } else {
+            struct mmsghdr messages[LOADGEN_BATCH];
+            struct iovec vectors[LOADGEN_BATCH];
+            memset(messages, 0, sizeof(messages));
+            for (size_t i = 0; i < due; i++) {
+                vectors[i].iov_base = (void*)events[i].data();
+                vectors[i].iov_len = events[i].size();
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int count = sendmmsg(fd, messages, (unsigned)due, 0);
+            if (count < 0) count = 0;
+            sent += (uint64_t)count;
+            failed += due - (size_t)count;
+        }
+    }
+    if (mqttTarget) sendAll(fd, std::string("\xE0\x00", 2));     // DISCONNECT
+    close(fd);
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "[Loadgen] Sent %llu events (%.0f events/s, avg %.0f bytes) in %.1f s, %llu send failures\n",
+            (unsigned long long)sent, sent / elapsed, sent ? (double)bytes / sent : 0.0, elapsed,
+            (unsigned long long)failed);
+    return 0;
+}